@@ -13,8 +13,17 @@
 /*!
 ** LLVM optimisation pass that converts wide loads and stores into byte
 ** accesses with appropriate merging / splitting.
+**
+** With -native-width-access, integer accesses of 2, 4 or 8 bytes are left
+** at their native width if their address is a constant, naturally
+** aligned offset from an alloca, global or function argument.  The HLS
+** back-end then emits them as packed ap_uint<N> operations.  Accesses at
+** variable offsets are still split into bytes.
 **/
 
+#include "common_cmd_opts.hpp"
+
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Function.h"
@@ -63,6 +72,31 @@ struct Byteify : public FunctionPass {
     }
   }
 
+  /**
+   * Check whether an access of the given size and alignment should keep
+   * its native width.  This requires that the address is a constant
+   * offset from an object whose base address is fixed, so that the
+   * access does not depend on any variable index.
+   */
+  static bool keep_native_width(Value *addr, Type *ty, unsigned align,
+                                uint64_t bytes, const DataLayout &DL) {
+    if (!nanotube::opt_native_width_access)
+      return false;
+    if (!ty->isIntegerTy())
+      return false;
+    if (bytes != 2 && bytes != 4 && bytes != 8)
+      return false;
+    if (align < bytes)
+      return false;
+
+    int64_t offset = 0;
+    Value *base = GetPointerBaseWithConstantOffset(addr, offset, DL);
+    if (!isa<AllocaInst>(base) && !isa<GlobalVariable>(base) &&
+        !isa<Argument>(base))
+      return false;
+    return (offset % int64_t(bytes)) == 0;
+  }
+
   /**
    * Convert a memory access (load to variable X) of a simple type of
    * length N bytes into a byte access sequence.
@@ -110,6 +144,10 @@ struct Byteify : public FunctionPass {
     if (bytes == 1)
       return false;
 
+    // Aligned access at a constant offset -> keep native width
+    if (keep_native_width(addr_op, tgt_ty, ld->getAlignment(), bytes, DL))
+      return false;
+
     // Step 1: pointer to intN -> pointer to i8
     // NOTE: Previously this used an array which is "mathematically"
     // nicer, but creates ugly code in the C back-end
@@ -229,6 +267,10 @@ struct Byteify : public FunctionPass {
     if (bytes == 1)
       return false;
 
+    // Aligned access at a constant offset -> keep native width
+    if (keep_native_width(addr_op, tgt_ty, st->getAlignment(), bytes, DL))
+      return false;
+
     // Step 1: pointer to intN -> pointer to i8
     // NOTE: Previously this used an array which is "mathematically"
     // nicer, but creates ugly code in the C back-end
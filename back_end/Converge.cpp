@@ -42,6 +42,18 @@
 **
 ** XXX: How does the constructor work?
 **
+** If the kernel has a profile (see the nt-profile-use pass), the
+** constructor converges the most frequently executed access of the
+** frontier first, so that the accesses of the hot path are placed in
+** the earliest pipeline stages.
+**
+** _Loops_
+**
+** The accesses of the kernel must not be inside a loop.  Bounded loops
+** are either unrolled or outlined into a separate function by the
+** outline-loops pass, which only accepts loops without map / packet
+** accesses.  Such a loop is just a call for the purposes of this pass.
+**
 **/
 
 //#define VISUALISE_CONVERGE_STEPS
@@ -55,6 +67,7 @@
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/CFG.h"
 #include "llvm/Analysis/CFGPrinter.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/MemoryLocation.h"
 #include "llvm/Analysis/MemorySSA.h"
 #include "llvm/Analysis/PostDominators.h"
@@ -84,6 +97,7 @@
 #include "Intrinsics.h"
 #include "Map_Packet_CFG.hpp"
 #include "graphs.hpp"
+#include "profile.hpp"
 #include "set_ops.hpp"
 #include "unify_function_returns.hpp"
 
@@ -193,11 +207,13 @@ struct Converge : public FunctionPass {
          const bb_to_unsigned_t& max_accesses_remaining);
   void pick_merge_set(access_set_t* result, const access_set_t& candidates,
                       const LLGraph<BasicBlock>& reduced_cfg,
-                      bb_to_unsigned_t* max_accesses_remaining);
+                      bb_to_unsigned_t* max_accesses_remaining,
+                      const block_profile& profile);
   bool can_converge(const CallInst* lhs, const CallInst* rhs);
   void construct_plan(std::vector<access_set_t>* converge_plan,
                       const LLGraph<BasicBlock>& reduced_cfg,
-                      bb_to_unsigned_t* max_accesses_remaining);
+                      bb_to_unsigned_t* max_accesses_remaining,
+                      const block_profile& profile);
   void execute_converge_plan(const std::vector<access_set_t>& converge_plan,
                              const LLGraph<BasicBlock>& reduced_cfg,
                              std::vector<converged_access_block*>* merge_blocks,
@@ -945,7 +961,8 @@ bool Converge::can_converge(const CallInst* lhs, const CallInst* rhs) {
 void Converge::pick_merge_set(Converge::access_set_t* result,
                               const Converge::access_set_t& candidates,
                               const LLGraph<BasicBlock>& reduced_cfg,
-                              bb_to_unsigned_t* max_accesses_remaining) {
+                              bb_to_unsigned_t* max_accesses_remaining,
+                              const block_profile& profile) {
   /* Trivial case: merge only a single entry :) */
   if( candidates.size() == 1 ) {
     result->insert(*candidates.begin());
@@ -954,20 +971,27 @@ void Converge::pick_merge_set(Converge::access_set_t* result,
 
   LLVM_DEBUG(dbgs() << "Picking merge candidates from " << candidates
                     << '\n');
-  /* Find the access / bb with the longest chain */
+  /* Find the access / bb with the longest chain.  If there is a profile,
+   * pick the most frequently executed access instead and use the chain
+   * length to break ties.  That converges the accesses of the hot path
+   * first, so they end up in the earliest pipeline stages. */
   CallInst* critical_access = nullptr;
   unsigned  criticality     = 0;
+  uint64_t  hotness         = 0;
   for( auto* acc : candidates ) {
     BasicBlock* bb = acc->getParent();
     unsigned n     = (*max_accesses_remaining)[bb];
-    if( n > criticality ) {
+    uint64_t count = profile.count(bb);
+    if( (count > hotness) || ((count == hotness) && (n > criticality)) ) {
       criticality     = n;
+      hotness         = count;
       critical_access = acc;
     }
   }
   assert(critical_access != nullptr);
   LLVM_DEBUG(dbgs() << "Most critical access: " << *critical_access
-                    << " length: " << criticality << '\n');
+                    << " length: " << criticality << " count: "
+                    << hotness << '\n');
   result->insert(critical_access);
 
   /* Add all potential merge candidates */
@@ -986,7 +1010,8 @@ void Converge::pick_merge_set(Converge::access_set_t* result,
 
 void Converge::construct_plan(std::vector<access_set_t>* converge_plan,
                               const LLGraph<BasicBlock>& reduced_cfg,
-                              bb_to_unsigned_t* max_accesses_remaining) {
+                              bb_to_unsigned_t* max_accesses_remaining,
+                              const block_profile& profile) {
   typedef std::unordered_map<BasicBlock*, BasicBlock::iterator>
             bb_to_access_t;
 
@@ -1029,7 +1054,8 @@ void Converge::construct_plan(std::vector<access_set_t>* converge_plan,
 
       /* Pick the accesses that will be converged */
       access_set_t picked;
-      pick_merge_set(&picked, access_cand, reduced_cfg, max_accesses_remaining);
+      pick_merge_set(&picked, access_cand, reduced_cfg, max_accesses_remaining,
+                     profile);
       converge_plan->push_back(picked);
 
       LLVM_DEBUG(
@@ -1746,6 +1772,21 @@ bool Converge::converge(Function& f) {
   if( !found_some )
     return false;
 
+  /* Accesses inside loops cannot be put into a sequence; bounded loops
+   * must have been unrolled or outlined (-outline-loops) by now */
+  LoopInfo li(dt);
+  for( auto* bb_accs : {&bb_mas, &bb_pktas} ) {
+    for( auto& bb_acc : *bb_accs ) {
+      if( bb_acc.second.empty() || li.getLoopFor(bb_acc.first) == nullptr )
+        continue;
+      errs() << "ERROR: Map / packet access " << *bb_acc.second.front()
+             << " in function " << f.getName() << " is inside a loop.\n"
+             << "Please unroll the loop or use -header-parse and"
+             << " -outline-loops to turn it into an iterative stage.\n";
+      exit(1);
+    }
+  }
+
   // Step 2: simplify CFG to only BBs with map & packet accesses
   LLGraph<BasicBlock> reduced_cfg;
   construct_reduced_cfg(f, bb_mas, bb_pktas, &reduced_cfg);
@@ -1760,7 +1801,9 @@ bool Converge::converge(Function& f) {
 
   /* Construct the converge plan (sequence of merge sets) */
   std::vector<access_set_t> converge_plan;
-  construct_plan(&converge_plan, reduced_cfg, &max_accesses_remaining);
+  block_profile profile(f, dt);
+  construct_plan(&converge_plan, reduced_cfg, &max_accesses_remaining,
+                 profile);
 
   if( converge_stats )
     dbgs() << "Converge plan entries: " << converge_plan.size() << '\n';
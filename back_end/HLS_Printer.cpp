@@ -13,6 +13,8 @@
 
 #include "HLS_Printer.h"
 
+#include "common_cmd_opts.hpp"
+
 #include "hls_validate.hpp"
 #include "Intrinsics.h"
 #include "llvm_common.h"
@@ -23,15 +25,20 @@
 
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/GetElementPtrTypeIterator.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cctype>
+#include <condition_variable>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <list>
+#include <mutex>
 #include <utility>
 #include <sstream>
 
@@ -136,6 +143,52 @@ using namespace nanotube;
 // The body of the function is generated by one-to-one conversion of
 // the LLVM-IR into C++.  Each instruction is identified and the
 // corresponding C++ code is generated.
+//
+// Dataflow top level
+// ------------------
+//
+// When -hls-dataflow-top is specified, the top_writer also writes a
+// top-level function called nanotube_top into top.cc.  This function
+// uses "#pragma HLS dataflow" to connect the stages directly.  Each
+// channel which is both read and written by stages becomes a static
+// hls::stream with the depth of the Nanotube channel.  Each channel
+// which is only read or only written by the stages is exported and
+// becomes an AXI-Stream port of the top-level function.  This allows
+// the whole kernel to be synthesised as a single IP block.
+//
+// A C simulation testbench is written to top_tb.cc.  It reads the
+// words for each exported input channel N from channelN.in and
+// writes the words from each exported output channel N to
+// channelN.out.  Each line of these files holds one channel element
+// as hex bytes, using the layout of the Nanotube channel.  The
+// testbench invokes nanotube_top until all the input has been
+// consumed and no more output is produced.
+//
+// Parallel stage emission
+// -----------------------
+//
+// The stages are written concurrently using a thread pool, see
+// -hls-threads.  The thread functions are validated serially first.
+// Each stage_writer only reads the IR and writes its own file, using a
+// private copy of the DataLayout since its struct layout cache is not
+// thread-safe.  Warnings are buffered per stage and printed in thread
+// order when the stage and all the stages before it have completed.
+// A fatal error in a stage is reported after the diagnostics of the
+// stages before it, so the output matches a serial run.  Accesses to
+// static variables are recorded per stage and checked for conflicts
+// in thread order after all the stages have been written.
+
+///////////////////////////////////////////////////////////////////////////
+
+static llvm::cl::opt<bool> opt_dataflow_top("hls-dataflow-top",
+    llvm::cl::desc("Write a dataflow top-level function and testbench"
+                   " which connect the stages directly"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<unsigned> opt_hls_threads("hls-threads",
+    llvm::cl::desc("The number of threads used to write the stages,"
+                   " or zero for one per CPU"),
+    llvm::cl::init(0));
 
 ///////////////////////////////////////////////////////////////////////////
 
@@ -209,6 +262,26 @@ private:
 class top_writer
 {
 public:
+  // An access to a static variable by a stage.
+  struct var_access {
+    const Value *var;
+    bool is_write;
+  };
+
+  // The results of writing a stage which are merged in thread order.
+  struct stage_result {
+    stage_result(): done(false) {}
+
+    // The buffered diagnostics.
+    std::string diags;
+
+    // The accesses to static variables in program order.
+    std::vector<var_access> var_accesses;
+
+    // Whether the stage has been written.
+    bool done;
+  };
+
   top_writer(hls_printer &printer, Module &m, setup_func &s);
   hls_printer &get_printer() { return m_printer; }
 
@@ -218,13 +291,28 @@ public:
   void check_channel_data_widths();
 
   void write_stages();
+  void write_stage(thread_id_t thread_id);
+  void report_stage(thread_id_t thread_id);
+  static void fatal_error_handler(void *user_data,
+                                  const std::string &reason,
+                                  bool gen_crash_diag);
   void write_header();
   void write_json();
   void write_vitis_opts();
   void write_poll_thread();
+  void write_dataflow_top();
+  void write_dataflow_testbench();
 
   void output_prototype(raw_os_ostream &out,
                         thread_id_t thread_id);
+  void output_top_prototype(raw_os_ostream &out);
+  void output_stream_conversion(raw_os_ostream &out, StringRef indent,
+                                const channel_info &channel,
+                                StringRef elem, StringRef flat,
+                                bool to_flat);
+
+  std::string get_stream_type(const channel_info &channel);
+  bool is_exported(const channel_info &channel);
 
   void output_c_string(raw_os_ostream &out, StringRef str);
 
@@ -244,6 +332,18 @@ private:
   // A mapping from GlobalVariable to information about the threads
   // which accesses it.  Used to report errors.
   DenseMap<const Value *, static_var_info> m_static_var_infos;
+
+  // The results of the stages being written, indexed by thread ID.
+  std::vector<stage_result> m_stage_results;
+
+  // The lowest thread ID whose diagnostics have not been reported.
+  thread_id_t m_next_report;
+
+  // Protects m_stage_results[].done and m_next_report.
+  std::mutex m_report_mutex;
+
+  // Signalled when m_next_report advances.
+  std::condition_variable m_report_cond;
 };
 
 ///////////////////////////////////////////////////////////////////////////
@@ -276,7 +376,8 @@ public:
   stage_writer(top_writer &top,
                context_info &context,
                thread_id_t thread_id,
-               std::ostream &out);
+               std::ostream &out,
+               top_writer::stage_result &result);
 
   void write();
   void write_preamble();
@@ -334,14 +435,21 @@ private:
   // The stream to write.
   raw_os_ostream m_out;
 
+  // The stream for warnings, which are reported by the top_writer.
+  llvm::raw_string_ostream m_diag;
+
+  // The accesses to static variables, checked by the top_writer.
+  std::vector<top_writer::var_access> &m_var_accesses;
+
   // The arguments to nanotube_thread_create.
   const thread_create_args &m_args;
 
   // The context passed to nanotube_thread_create.
   context_info &m_context;
 
-  // The data layout of the module.
-  const DataLayout &m_data_layout;
+  // A copy of the data layout of the module.  The copy is private
+  // to this stage so that its caches can be used without locking.
+  const DataLayout m_data_layout;
 
   // The entry basic block.
   const BasicBlock *m_entry_bb;
@@ -417,7 +525,7 @@ bool hls_printer::runOnModule(Module &m)
   }
 
   // Process the setup function.
-  auto top = top_writer(*this, m, setup);
+  top_writer top(*this, m, setup);
 
   // Check the widths of the different fields is sufficient and consistent
   top.check_channel_data_widths();
@@ -430,6 +538,10 @@ bool hls_printer::runOnModule(Module &m)
   top.write_json();
   top.write_vitis_opts();
   top.write_poll_thread();
+  if (opt_dataflow_top) {
+    top.write_dataflow_top();
+    top.write_dataflow_testbench();
+  }
 
   // Nothing was modified.
   return false;
@@ -564,19 +676,114 @@ void top_writer::check_channel_data_widths()
 }
 
 
+// The stage being written by the current thread.
+static thread_local thread_id_t s_current_stage;
+
 void top_writer::write_stages()
 {
   thread_id_t num_threads = m_setup_func.threads().size();
+
+  // Validate the thread functions first.  The validator writes errors
+  // directly, so it is not run concurrently.
+  for (thread_id_t id = 0; id < num_threads; id++) {
+    auto &thread = m_setup_func.get_thread_info(id);
+    validate_hls_thread_function(*thread.args().func);
+  }
+
+  unsigned num_workers = opt_hls_threads;
+  if (num_workers == 0)
+    num_workers = llvm::hardware_concurrency();
+#ifndef NDEBUG
+  // The debug output is not buffered per stage.
+  if (llvm::DebugFlag)
+    num_workers = 1;
+#endif
+
+  m_stage_results.clear();
+  m_stage_results.resize(num_threads);
+  m_next_report = 0;
+
+  llvm::install_fatal_error_handler(fatal_error_handler, this);
+  if (num_workers <= 1 || num_threads <= 1) {
+    for (thread_id_t id = 0; id < num_threads; id++)
+      write_stage(id);
+  } else {
+    // The pool starts the stages in thread order, which the fatal
+    // error handler relies on.
+    llvm::ThreadPool pool(std::min<unsigned>(num_workers, num_threads));
+    for (thread_id_t id = 0; id < num_threads; id++)
+      pool.async([this, id]() { write_stage(id); });
+    pool.wait();
+  }
+  llvm::remove_fatal_error_handler();
+
+  // Check the accesses to static variables in thread order so that
+  // conflicts are reported independently of the schedule.
   for (thread_id_t id = 0; id < num_threads; id++) {
+    for (auto &access: m_stage_results[id].var_accesses)
+      set_thread_of_var(*access.var, id, access.is_write);
+  }
+  m_stage_results.clear();
+}
+
+void top_writer::write_stage(thread_id_t thread_id)
+{
+  s_current_stage = thread_id;
+
+  {
     std::string filename = formatv("{0}/stage_{1}.cc",
-                                   m_printer.get_output_dir(), id);
+                                   m_printer.get_output_dir(), thread_id);
     std::ofstream out_fstream(filename);
 
-    auto context_index = m_setup_func.get_thread_info(id).context_index();
-    context_info &context = m_setup_func.get_context_info(context_index);
-    stage_writer writer(*this, context, id, out_fstream);
+    auto &thread = m_setup_func.get_thread_info(thread_id);
+    context_info &context =
+      m_setup_func.get_context_info(thread.context_index());
+    stage_writer writer(*this, context, thread_id, out_fstream,
+                        m_stage_results[thread_id]);
     writer.write();
   }
+
+  report_stage(thread_id);
+}
+
+void top_writer::report_stage(thread_id_t thread_id)
+{
+  std::lock_guard<std::mutex> lock(m_report_mutex);
+  m_stage_results[thread_id].done = true;
+
+  // Report the diagnostics of each stage once all the stages before
+  // it have been reported.
+  bool advanced = false;
+  while (m_next_report < m_stage_results.size() &&
+         m_stage_results[m_next_report].done) {
+    errs() << m_stage_results[m_next_report].diags;
+    m_next_report++;
+    advanced = true;
+  }
+  if (advanced)
+    m_report_cond.notify_all();
+}
+
+void top_writer::fatal_error_handler(void *user_data,
+                                     const std::string &reason,
+                                     bool gen_crash_diag)
+{
+  auto *top = static_cast<top_writer *>(user_data);
+  thread_id_t thread_id = s_current_stage;
+
+  // Wait for the stages before this one so that the error is reported
+  // in the same place as a serial run.  If one of them fails then it
+  // exits the process first.
+  std::unique_lock<std::mutex> lock(top->m_report_mutex);
+  top->m_report_cond.wait(lock, [&]() {
+    return top->m_next_report == thread_id;
+  });
+
+  errs() << top->m_stage_results[thread_id].diags;
+  errs() << "LLVM ERROR: " << reason << "\n";
+  errs().flush();
+
+  // The caller exits the process when this returns.
 }
 
 void top_writer::write_vitis_opts()
@@ -726,6 +933,11 @@ void top_writer::write_header()
     out << ";\n\n";
   }
 
+  if (opt_dataflow_top) {
+    output_top_prototype(out);
+    out << ";\n\n";
+  }
+
   out << ( "#endif // STAGES_HH\n" );
 }
 
@@ -1019,6 +1231,246 @@ void top_writer::write_poll_thread()
   );
 }
 
+void top_writer::write_dataflow_top()
+{
+  std::string filename = formatv("{0}/top.cc",
+                                 m_printer.get_output_dir());
+  std::ofstream out_fstream(filename);
+  raw_os_ostream out(out_fstream);
+
+  out << ( "#include \"stages.hh\"\n"
+           "\n" );
+
+  output_top_prototype(out);
+  out << ( "\n"
+           "{\n"
+           "#pragma HLS interface ap_ctrl_none port=return\n" );
+
+  // Write the interface pragmas for the exported channels.
+  channel_index_t num_channels = m_setup_func.channels().size();
+  for (channel_index_t channel_index=0; channel_index<num_channels;
+       channel_index++) {
+    const channel_info &channel = m_setup_func.channels()[channel_index];
+    if (!is_exported(channel))
+      continue;
+
+    out << formatv("#pragma HLS interface axis port=channel{0}\n",
+                   channel_index);
+    if (channel.get_sideband_size() == 0 &&
+        channel.get_sideband_signals_size() == 0) {
+      out << "#if defined(NANOTUBE_USING_VIVADO_HLS)\n";
+      out << formatv("#pragma HLS data_pack variable=channel{0}\n",
+                     channel_index);
+      out << "#else // defined(NANOTUBE_USING_VIVADO_HLS)\n";
+      out << formatv("#pragma HLS aggregate variable=channel{0}\n",
+                     channel_index);
+      out << "#endif // defined(NANOTUBE_USING_VIVADO_HLS)\n";
+    }
+  }
+  out << "#pragma HLS dataflow\n";
+
+  // Declare the internal streams.  They are static so that words
+  // are retained between invocations in C simulation.
+  bool any_internal = false;
+  for (channel_index_t channel_index=0; channel_index<num_channels;
+       channel_index++) {
+    const channel_info &channel = m_setup_func.channels()[channel_index];
+    if (!channel.has_reader() || !channel.has_writer())
+      continue;
+
+    if (!any_internal)
+      out << "\n";
+    any_internal = true;
+
+    out << formatv("  static hls::stream<{0} > channel{1}(",
+                   get_stream_type(channel), channel_index);
+    output_c_string(out, channel.get_name());
+    out << ");\n";
+    out << formatv("#pragma HLS stream variable=channel{0} depth={1}\n",
+                   channel_index, channel.get_num_elem());
+  }
+
+  // Invoke each of the stages.
+  out << "\n";
+  thread_id_t num_threads = m_setup_func.threads().size();
+  for (thread_id_t thread_id=0; thread_id<num_threads; thread_id++) {
+    thread_info &thread = m_setup_func.get_thread_info(thread_id);
+    context_info &context = m_setup_func.get_context_info(thread.context_index());
+    port_index_t num_ports = context.ports().size();
+
+    out << formatv("  stage_{0}(", thread_id);
+    for (port_index_t port_index=0; port_index < num_ports; port_index++) {
+      auto &port = context.get_port(port_index);
+      out << formatv("{0}channel{1}", (port_index == 0 ? "" : ", "),
+                     port.channel_index());
+    }
+    out << ");\n";
+  }
+
+  out << "}\n";
+}
+
+void top_writer::write_dataflow_testbench()
+{
+  std::string filename = formatv("{0}/top_tb.cc",
+                                 m_printer.get_output_dir());
+  std::ofstream out_fstream(filename);
+  raw_os_ostream out(out_fstream);
+
+  // Write the file header and the helper functions.
+  out << (
+    "#include \"stages.hh\"\n"
+    "\n"
+    "#include <cstring>\n"
+    "#include <fstream>\n"
+    "#include <iomanip>\n"
+    "#include <iostream>\n"
+    "#include <sstream>\n"
+    "#include <string>\n"
+    "\n"
+    "// The number of invocations without any progress before the\n"
+    "// testbench stops.\n"
+    "static const int idle_limit = 1000;\n"
+    "\n"
+    "static bool read_elem(std::istream &in, uint8_t *data, size_t size)\n"
+    "{\n"
+    "  std::string line;\n"
+    "  do {\n"
+    "    if (!std::getline(in, line))\n"
+    "      return false;\n"
+    "  } while (line.find_first_not_of(\" \\t\\r\") == std::string::npos);\n"
+    "\n"
+    "  std::istringstream line_in(line);\n"
+    "  for (size_t i=0; i<size; i++) {\n"
+    "    unsigned val;\n"
+    "    if (!(line_in >> std::hex >> val) || val > 0xff) {\n"
+    "      std::cerr << \"Invalid channel element: \" << line << \"\\n\";\n"
+    "      exit(1);\n"
+    "    }\n"
+    "    data[i] = val;\n"
+    "  }\n"
+    "  return true;\n"
+    "}\n"
+    "\n"
+    "static void write_elem(std::ostream &out, const uint8_t *data,"
+    " size_t size)\n"
+    "{\n"
+    "  out << std::hex << std::setfill('0');\n"
+    "  for (size_t i=0; i<size; i++)\n"
+    "    out << (i == 0 ? \"\" : \" \") << std::setw(2) << unsigned(data[i]);\n"
+    "  out << std::dec << std::setfill(' ') << \"\\n\";\n"
+    "}\n"
+    "\n"
+    "int main(int argc, char *argv[])\n"
+    "{\n"
+  );
+
+  // Declare the streams and files.
+  channel_index_t num_channels = m_setup_func.channels().size();
+  for (channel_index_t channel_index=0; channel_index<num_channels;
+       channel_index++) {
+    const channel_info &channel = m_setup_func.channels()[channel_index];
+    if (!is_exported(channel))
+      continue;
+
+    bool is_input = channel.has_reader();
+    out << formatv("  // Channel {0}: ", channel_index);
+    output_c_string(out, channel.get_name());
+    out << "\n";
+    out << formatv("  hls::stream<{0} > channel{1}(\"channel{1}\");\n",
+                   get_stream_type(channel), channel_index);
+    if (is_input) {
+      out << formatv("  std::ifstream channel{0}_file(\"channel{0}.in\");\n"
+                     "  bool channel{0}_done = false;\n",
+                     channel_index);
+    } else {
+      out << formatv("  std::ofstream channel{0}_file(\"channel{0}.out\");\n",
+                     channel_index);
+    }
+  }
+
+  // Start the loop.
+  out << (
+    "\n"
+    "  int idle = 0;\n"
+    "  while (idle < idle_limit) {\n"
+    "    bool active = false;\n"
+  );
+
+  // Feed the input channels.
+  for (channel_index_t channel_index=0; channel_index<num_channels;
+       channel_index++) {
+    const channel_info &channel = m_setup_func.channels()[channel_index];
+    if (!is_exported(channel) || !channel.has_reader())
+      continue;
+
+    std::string elem = formatv("channel{0}_elem", channel_index);
+    std::string flat = formatv("channel{0}_flat", channel_index);
+    out << "\n"
+        << formatv("    if (!channel{0}_done && channel{0}.empty()) {{\n"
+                   "      bytes<{1}> {2};\n"
+                   "      if (read_elem(channel{0}_file, {2}.data, {1})) {{\n"
+                   "        {3} {4};\n",
+                   channel_index, channel.get_elem_size(), flat,
+                   get_stream_type(channel), elem);
+    output_stream_conversion(out, "        ", channel, elem, flat, false);
+    out << formatv("        channel{0}.write({1});\n"
+                   "        active = true;\n"
+                   "      } else {{\n"
+                   "        channel{0}_done = true;\n"
+                   "      }\n"
+                   "    }\n",
+                   channel_index, elem);
+  }
+
+  // Invoke the top-level function.
+  out << "\n"
+      << "    nanotube_top(";
+  bool any_channels = false;
+  for (channel_index_t channel_index=0; channel_index<num_channels;
+       channel_index++) {
+    const channel_info &channel = m_setup_func.channels()[channel_index];
+    if (!is_exported(channel))
+      continue;
+    out << formatv("{0}channel{1}", (any_channels ? ", " : ""),
+                   channel_index);
+    any_channels = true;
+  }
+  out << ");\n";
+
+  // Drain the output channels.
+  for (channel_index_t channel_index=0; channel_index<num_channels;
+       channel_index++) {
+    const channel_info &channel = m_setup_func.channels()[channel_index];
+    if (!is_exported(channel) || !channel.has_writer())
+      continue;
+
+    std::string elem = formatv("channel{0}_elem", channel_index);
+    std::string flat = formatv("channel{0}_flat", channel_index);
+    out << "\n"
+        << formatv("    while (!channel{0}.empty()) {{\n"
+                   "      {1} {2} = channel{0}.read();\n"
+                   "      bytes<{3}> {4};\n",
+                   channel_index, get_stream_type(channel), elem,
+                   channel.get_elem_size(), flat);
+    output_stream_conversion(out, "      ", channel, elem, flat, true);
+    out << formatv("      write_elem(channel{0}_file, {1}.data, {2});\n"
+                   "      active = true;\n"
+                   "    }\n",
+                   channel_index, flat, channel.get_elem_size());
+  }
+
+  // Write the end of the loop.
+  out << (
+    "\n"
+    "    idle = (active ? 0 : idle + 1);\n"
+    "  }\n"
+    "\n"
+    "  return 0;\n"
+    "}\n"
+  );
+}
+
 void top_writer::output_prototype(raw_os_ostream &out,
                                   thread_id_t thread_id)
 {
@@ -1052,6 +1504,107 @@ void top_writer::output_prototype(raw_os_ostream &out,
   out << formatv(num_ports == 0 ? "void)" : ")");
 }
 
+void top_writer::output_top_prototype(raw_os_ostream &out)
+{
+  out << "void nanotube_top(";
+
+  bool any_channels = false;
+  channel_index_t num_channels = m_setup_func.channels().size();
+  for (channel_index_t channel_index=0; channel_index<num_channels;
+       channel_index++) {
+    const channel_info &channel = m_setup_func.channels()[channel_index];
+    if (!is_exported(channel))
+      continue;
+    out << formatv("{0}\n  hls::stream<{1} > &channel{2}",
+                   (any_channels ? "," : ""),
+                   get_stream_type(channel), channel_index);
+    any_channels = true;
+  }
+  out << (any_channels ? ")" : "void)");
+}
+
+// Write code to convert between a stream element and the flat
+// layout used by the Nanotube channel.  See write_channel_call for a
+// description of the layout.
+void top_writer::output_stream_conversion(raw_os_ostream &out,
+                                          StringRef indent,
+                                          const channel_info &channel,
+                                          StringRef elem, StringRef flat,
+                                          bool to_flat)
+{
+  auto elem_size = channel.get_elem_size();
+  auto sideband_size = channel.get_sideband_size();
+  auto sideband_signals_size = channel.get_sideband_signals_size();
+  auto user_offset = elem_size - sideband_size - sideband_signals_size;
+  auto keep_offset = elem_size - sideband_signals_size;
+  auto strb_offset = elem_size - (sideband_signals_size - 1)/2 - 1;
+  auto last_offset = elem_size - 1;
+  auto signal_size = ( sideband_signals_size == 0 ? 0 :
+                       (sideband_signals_size - 1)/2 );
+
+  if (sideband_size == 0 && sideband_signals_size == 0) {
+    if (to_flat)
+      out << formatv("{0}{1} = {2};\n", indent, flat, elem);
+    else
+      out << formatv("{0}{1} = {2};\n", indent, elem, flat);
+    return;
+  }
+
+  // Each field is described by the element member, the offset in the
+  // flat layout and the size.
+  struct field {
+    const char *member;
+    uint32_t offset;
+    uint32_t size;
+  };
+  field fields[] = {
+    { "data", 0, user_offset },
+    { "user", user_offset, sideband_size },
+    { "keep", keep_offset, signal_size },
+    { "strb", strb_offset, signal_size },
+  };
+  for (auto &f: fields) {
+    if (f.size == 0)
+      continue;
+    if (to_flat)
+      out << formatv("{0}nanotube_memcpy(&({1}.data[{2}]), &{3}.{4}, {5});\n",
+                     indent, flat, f.offset, elem, f.member, f.size);
+    else
+      out << formatv("{0}nanotube_memcpy(&{1}.{2}, &({3}.data[{4}]), {5});\n",
+                     indent, elem, f.member, flat, f.offset, f.size);
+  }
+
+  if (sideband_signals_size != 0) {
+    if (to_flat)
+      out << formatv("{0}{1}.data[{2}] = {3}.last;\n",
+                     indent, flat, last_offset, elem);
+    else
+      out << formatv("{0}{1}.last = {2}.data[{3}] & 1;\n",
+                     indent, elem, flat, last_offset);
+  }
+}
+
+std::string top_writer::get_stream_type(const channel_info &channel)
+{
+  auto elem_size = channel.get_elem_size();
+  auto sideband_size = channel.get_sideband_size();
+  auto sideband_signals_size = channel.get_sideband_signals_size();
+
+  if (sideband_size != 0 || sideband_signals_size != 0) {
+    return formatv("ap_axiu<{0},{1},0,0>",
+                   (elem_size - sideband_size - sideband_signals_size) << 3,
+                   sideband_size << 3);
+  }
+  return formatv("bytes<{0}>", elem_size);
+}
+
+// A channel is exported from the dataflow top level if it is
+// connected to a stage at only one end.
+bool top_writer::is_exported(const channel_info &channel)
+{
+  return channel.has_reader() != channel.has_writer();
+}
+
 void top_writer::output_c_string(raw_os_ostream &out, StringRef str)
 {
   out << '"';
@@ -1148,17 +1701,22 @@ void global_var_writer::write(value_id_t id, GlobalVariable *var)
 stage_writer::stage_writer(top_writer &top,
                            context_info &context,
                            thread_id_t thread_id,
-                           std::ostream &out):
+                           std::ostream &out,
+                           top_writer::stage_result &result):
   m_top(top),
   m_setup_func(top.get_setup_func()),
   m_thread_id(thread_id),
   m_out(out),
+  m_diag(result.diags),
+  m_var_accesses(result.var_accesses),
   m_args(m_setup_func.get_thread_info(thread_id).args()),
   m_context(context),
   m_data_layout(m_args.func->getParent()->getDataLayout()),
   m_entry_bb(nullptr)
 {
-  validate_hls_thread_function(*(m_args.func));
+  // Write the diagnostics straight into the string so that they can
+  // be reported if a fatal error occurs.
+  m_diag.SetUnbuffered();
   m_entry_bb = &(m_args.func->getEntryBlock());
 }
 
@@ -1646,6 +2204,10 @@ void stage_writer::write_call(const CallBase &insn)
     write_trace_buffer_call(insn);
     break;
 
+  case Intrinsics::debug_packet_dropped:
+    // The drop counts are only collected by the software model.
+    break;
+
   case Intrinsics::llvm_bswap:
     write_bswap(insn);
     break;
@@ -2012,6 +2574,23 @@ void stage_writer::write_load(const LoadInst &insn)
   bool is_big_endian = m_data_layout.isBigEndian();
   const Value *ptr = insn.getPointerOperand();
   check_mem_access(&insn, ptr, num_bytes, false);
+
+  // Read a native width access as a single concatenation of the
+  // bytes, most significant first.
+  if (nanotube::opt_native_width_access && num_bytes > 1) {
+    m_out << "(";
+    for (unsigned i=0; i<num_bytes; i++) {
+      unsigned index = (is_big_endian ? i : num_bytes-1-i);
+      if (i != 0)
+        m_out << ",\n    ";
+      m_out << "ap_uint<8>(";
+      write_operand(insn, *ptr, HLS_TYPE_POINTER);
+      m_out << "[" << index << "])";
+    }
+    m_out << ");\n";
+    return;
+  }
+
   for (unsigned i=0; i<num_bytes; i++) {
     unsigned shift = i*8;
     if (is_big_endian)
@@ -2125,6 +2704,26 @@ void stage_writer::write_store(const StoreInst &insn)
 
   const Value *ptr = insn.getPointerOperand();
   check_mem_access(&insn, ptr, num_bytes, true);
+
+  // Write a native width access by slicing a packed copy of the data.
+  if (nanotube::opt_native_width_access && num_bytes > 1) {
+    unsigned num_bits = int_ty->getBitWidth();
+    m_out << "  {\n"
+          << "    ap_uint<" << num_bits << "> packed = ";
+    write_operand(insn, *data);
+    m_out << ";\n";
+    for (unsigned i=0; i<num_bytes; i++) {
+      unsigned lo = (is_big_endian ? num_bytes-1-i : i)*8;
+      unsigned hi = std::min(lo+7, num_bits-1);
+      m_out << "    ";
+      write_operand(insn, *ptr, HLS_TYPE_POINTER);
+      m_out << "[" << i << "] = packed.range(" << hi << ", " << lo
+            << ");\n";
+    }
+    m_out << "  }\n";
+    return;
+  }
+
   for (unsigned i=0; i<num_bytes; i++) {
     unsigned shift = i*8;
     if (is_big_endian)
@@ -2281,7 +2880,7 @@ void stage_writer::check_mem_access(const Instruction *insn, const Value *base,
 {
   auto size_const = dyn_cast<ConstantInt>(size);
   if (size_const == nullptr) {
-    errs() << "Unknown size in " << *insn << "\n";
+    m_diag << "Unknown size in " << *insn << "\n";
     return;
   }
   check_mem_access(insn, base, size_const->getValue(), is_write);
@@ -2303,15 +2902,15 @@ void stage_writer::check_mem_access(const Instruction *insn,
 
   auto glb_var = dyn_cast<GlobalVariable>(base);
   if (glb_var != nullptr) {
-    // Assign the variable to this thread so it cannot be used by
-    // multiple threads.
-    m_top.set_thread_of_var(*base, m_thread_id, is_write);
+    // Record the access so that the top_writer can check the
+    // variable is not used by multiple threads.
+    m_var_accesses.push_back({base, is_write});
 
     auto var_type = glb_var->getValueType();
     auto var_size = m_data_layout.getTypeStoreSize(var_type);
     auto max_size = var_size - offset;
     if (offset.ugt(var_size) || access_size.ugt(max_size)) {
-      errs() << formatv("WARNING: Out of bounds access in {0}\n",
+      m_diag << formatv("WARNING: Out of bounds access in {0}\n",
                         *insn);
     }
     return;
@@ -2322,7 +2921,7 @@ void stage_writer::check_mem_access(const Instruction *insn,
     auto var_size = get_alloca_size(m_data_layout, *alloca);
     auto max_size = var_size - offset;
     if (offset.uge(var_size) || access_size.ugt(max_size)) {
-      errs() << formatv("WARNING: Out of bounds access in {0}\n",
+      m_diag << formatv("WARNING: Out of bounds access in {0}\n",
                         *insn);
     }
     return;
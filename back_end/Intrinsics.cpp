@@ -330,6 +330,20 @@ packet_bounded_length_args::packet_bounded_length_args(Instruction* inst) {
   max_length = call->getArgOperand(1);
 }
 
+packet_csum_args::packet_csum_args(Instruction* inst) {
+  auto* call = cast<CallInst>(inst);
+  auto  nt_call = nt_api_call(call);
+
+  /* Make sure it is all solid :) */
+  check_intrinsic_call(*call, 4);
+  assert(nt_call.get_intrinsic() == Intrinsics::packet_csum);
+
+  packet = call->getArgOperand(0);
+  offset = call->getArgOperand(1);
+  length = call->getArgOperand(2);
+  seed   = call->getArgOperand(3);
+}
+
 packet_resize_args::packet_resize_args(Instruction* inst) {
   auto* call = cast<CallInst>(inst);
 
@@ -781,6 +795,33 @@ Constant* create_nt_map_process_capsule(Module& m)
                                 get_nt_map_process_capsule_ty(m));
 }
 
+FunctionType* get_nt_map_process_capsule_batch_ty(Module& m)
+{
+  LLVMContext& c = m.getContext();
+  /* void nanotube_map_process_capsule_batch(nanotube_context_t *ctxt,
+   *                                         nanotube_map_id_t map_id,
+   *                                         uint8_t *capsule,
+   *                                         size_t key_len,
+   *                                         size_t value_len,
+   *                                         size_t max_entries);
+   */
+  Type *args[] = {
+    get_nt_context_type(m)->getPointerTo(),
+    get_nt_map_id_type(m),
+    Type::getInt8PtrTy(c),
+    Type::getInt64Ty(c),
+    Type::getInt64Ty(c),
+    Type::getInt64Ty(c),
+  };
+  return FunctionType::get(Type::getVoidTy(c), args, false);
+}
+
+Constant* create_nt_map_process_capsule_batch(Module& m)
+{
+  return get_or_insert_function(m, "nanotube_map_process_capsule_batch",
+                                get_nt_map_process_capsule_batch_ty(m));
+}
+
 Constant* create_nt_map_read(Module& m) {
   LLVMContext& c = m.getContext();
   /**
@@ -881,6 +922,20 @@ Constant* create_nt_packet_bounded_length(Module& m) {
                                 get_nt_packet_type(m)->getPointerTo(),
                                 Type::getInt64Ty(c));
 }
+Constant* create_nt_packet_csum(Module& m) {
+  LLVMContext& c = m.getContext();
+  /**
+  ** uint16_t nanotube_packet_csum(nanotube_packet_t* packet,
+  **                               size_t offset, size_t length,
+  **                               uint32_t seed);
+  **/
+  return get_or_insert_function(m, "nanotube_packet_csum",
+                                Type::getInt16Ty(c),
+                                get_nt_packet_type(m)->getPointerTo(),
+                                Type::getInt64Ty(c),
+                                Type::getInt64Ty(c),
+                                Type::getInt32Ty(c));
+}
 Constant* create_nt_packet_resize(Module& m) {
   LLVMContext& c = m.getContext();
   /**
@@ -1271,6 +1326,14 @@ Constant* create_nt_get_time_ns(Module& m) {
   return m.getOrInsertFunction("nanotube_get_time_ns",
                                Type::getInt64Ty(c));
 }
+Constant* create_nt_debug_packet_dropped(Module& m) {
+  LLVMContext& c = m.getContext();
+  /**
+  ** void nanotube_debug_packet_dropped(void);
+  **/
+  return m.getOrInsertFunction("nanotube_debug_packet_dropped",
+                               Type::getVoidTy(c));
+}
 Constant* create_packet_handle_xdp_result(Module& m) {
   LLVMContext& c = m.getContext();
   /**
@@ -1281,6 +1344,34 @@ Constant* create_packet_handle_xdp_result(Module& m) {
                                get_nt_packet_type(m)->getPointerTo(),
                                Type::getInt32Ty(c));
 }
+Constant* create_packet_redirect_adapter(Module& m) {
+  LLVMContext& c = m.getContext();
+  /**
+  ** int32 packet_redirect_adapter(nanotube_packet_t* packet,
+  **                               uint32 ifindex, uint64 flags);
+  **/
+  return m.getOrInsertFunction("packet_redirect_adapter",
+                               Type::getInt32Ty(c),
+                               get_nt_packet_type(m)->getPointerTo(),
+                               Type::getInt32Ty(c),
+                               Type::getInt64Ty(c));
+}
+Constant* create_packet_redirect_map_adapter(Module& m) {
+  LLVMContext& c = m.getContext();
+  /**
+  ** int32 packet_redirect_map_adapter(nanotube_context_t* ctx,
+  **                                   nanotube_packet_t* packet,
+  **                                   nanotube_map_id_t map_id,
+  **                                   uint32 key, uint64 flags);
+  **/
+  return m.getOrInsertFunction("packet_redirect_map_adapter",
+                               Type::getInt32Ty(c),
+                               get_nt_context_type(m)->getPointerTo(),
+                               get_nt_packet_type(m)->getPointerTo(),
+                               get_nt_map_id_type(m),
+                               Type::getInt32Ty(c),
+                               Type::getInt64Ty(c));
+}
 };
 
 
@@ -1361,7 +1452,7 @@ FunctionType* get_tap_packet_read_ty(Module& m) {
 
 Constant* create_tap_packet_read(Module& m, nanotube_bus_id_t bus_type) {
   auto fname = std::string("nanotube_tap_packet_read") +
-                 get_bus_suffix(bus_type);
+                 get_bus_tap_suffix(bus_type);
   return get_or_insert_function(m, fname, get_tap_packet_read_ty(m));
 }
 
@@ -1428,7 +1519,7 @@ FunctionType* get_tap_packet_write_ty(Module& m) {
 
 Constant* create_tap_packet_write(Module& m, nanotube_bus_id_t bus_type) {
   auto fname = std::string("nanotube_tap_packet_write") +
-                 get_bus_suffix(bus_type);
+                 get_bus_tap_suffix(bus_type);
   return get_or_insert_function(m, fname, get_tap_packet_write_ty(m));
 }
 
@@ -1498,10 +1589,83 @@ FunctionType* get_tap_packet_length_ty(Module& m) {
 
 Constant* create_tap_packet_length(Module& m, nanotube_bus_id_t bus_type) {
   auto fname = std::string("nanotube_tap_packet_length") +
-                 get_bus_suffix(bus_type);
+                 get_bus_tap_suffix(bus_type);
   return get_or_insert_function(m, fname, get_tap_packet_length_ty(m));
 }
 
+StructType* get_nt_tap_packet_csum_req_ty(Module& m) {
+  static const std::string name = "struct.nanotube_tap_packet_csum_req";
+  auto* ty = m.getTypeByName(name);
+  if (ty != nullptr)
+    return ty;
+
+  LLVMContext& c = m.getContext();
+  std::array<Type*,4> elements = {
+    IntegerType::getInt8Ty(c),    /* valid */
+    IntegerType::getInt16Ty(c),   /* csum_offset */
+    IntegerType::getInt16Ty(c),   /* csum_length */
+    IntegerType::getInt32Ty(c),   /* seed */
+  };
+  return StructType::create(c, elements, name);
+}
+
+StructType* get_nt_tap_packet_csum_resp_ty(Module& m) {
+  static const std::string name = "struct.nanotube_tap_packet_csum_resp";
+  auto* ty = m.getTypeByName(name);
+  if (ty != nullptr)
+    return ty;
+
+  LLVMContext& c = m.getContext();
+  std::array<Type*,3> elements = {
+    IntegerType::getInt8Ty(c),    /* valid */
+    IntegerType::getInt16Ty(c),   /* result_length */
+    IntegerType::getInt16Ty(c),   /* result_sum */
+  };
+  return StructType::create(c, elements, name);
+}
+
+StructType* get_nt_tap_packet_csum_state_ty(Module& m) {
+  static const std::string name = "struct.nanotube_tap_packet_csum_state";
+  auto* ty = m.getTypeByName(name);
+  if (ty != nullptr)
+    return ty;
+
+  LLVMContext& c = m.getContext();
+  std::array<Type*, 5>  elements = {
+    IntegerType::getInt16Ty(c),   /* packet_length */
+    IntegerType::getInt16Ty(c),   /* packet_offset */
+    IntegerType::getInt32Ty(c),   /* partial_sum */
+    IntegerType::getInt8Ty(c),    /* done */
+    IntegerType::getInt8Ty(c),    /* data_eop_seen */
+  };
+  return StructType::create(c, elements, name);
+}
+
+FunctionType* get_tap_packet_csum_ty(Module& m) {
+  LLVMContext& c = m.getContext();
+  /**
+  ** void nanotube_tap_packet_csum(
+  **   struct nanotube_tap_packet_csum_resp  *resp_out,
+  **   struct nanotube_tap_packet_csum_state *state_inout,
+  **   const uint8_t *packet_word_in,
+  **   const struct nanotube_tap_packet_csum_req *req_in);
+  **/
+  auto* res_ty   = Type::getVoidTy(c);
+  Type* arg_ty[] = {
+    get_nt_tap_packet_csum_resp_ty(m)->getPointerTo(),
+    get_nt_tap_packet_csum_state_ty(m)->getPointerTo(),
+    Type::getInt8PtrTy(c),
+    get_nt_tap_packet_csum_req_ty(m)->getPointerTo()
+  };
+  return FunctionType::get(res_ty, arg_ty, false);
+}
+
+Constant* create_tap_packet_csum(Module& m, nanotube_bus_id_t bus_type) {
+  auto fname = std::string("nanotube_tap_packet_csum") +
+                 get_bus_tap_suffix(bus_type);
+  return get_or_insert_function(m, fname, get_tap_packet_csum_ty(m));
+}
+
 /* Resize Tap */
 StructType* get_nt_tap_packet_resize_cword_ty(Module& m) {
   LLVMContext& c = m.getContext();
@@ -1589,7 +1753,7 @@ FunctionType* get_tap_packet_resize_ingress_ty(Module& m) {
 }
 Constant* create_tap_packet_resize_ingress(Module& m, nanotube_bus_id_t bus_type) {
   auto fname = std::string("nanotube_tap_packet_resize_ingress") +
-                 get_bus_suffix(bus_type);
+                 get_bus_tap_suffix(bus_type);
   return get_or_insert_function(m, fname, get_tap_packet_resize_ingress_ty(m));
 }
 
@@ -1638,7 +1802,7 @@ FunctionType* get_tap_packet_resize_egress_ty(Module& m) {
 }
 Constant* create_tap_packet_resize_egress(Module& m, nanotube_bus_id_t bus_type) {
   auto fname = std::string("nanotube_tap_packet_resize_egress") +
-                 get_bus_suffix(bus_type);
+                 get_bus_tap_suffix(bus_type);
   return get_or_insert_function(m, fname,
            get_tap_packet_resize_egress_ty(m));
 }
@@ -1706,7 +1870,7 @@ FunctionType* get_tap_packet_is_eop_ty(Module& m) {
 }
 Constant* create_tap_packet_is_eop(Module& m, nanotube_bus_id_t bus_type) {
   auto fname = std::string("nanotube_tap_packet_is_eop") +
-                 get_bus_suffix(bus_type);
+                 get_bus_tap_suffix(bus_type);
   return get_or_insert_function(m, fname, get_tap_packet_is_eop_ty(m));
 }
 };
@@ -1994,13 +2158,20 @@ StructType* get_nt_packet_type(Module& m) {
 }
 
 Type* get_simple_bus_word_ty(Module& m) {
-  static const std::string name = "struct.simple_bus::word";
+  /* Words wider than 64 bytes have a two byte control field, see
+   * simple_bus::bus_traits. */
+  unsigned data_bytes = get_bus_data_bytes();
+  unsigned control_bytes = (data_bytes > 64 ? 2 : 1);
+  std::string name = "struct.simple_bus::word";
+  if (data_bytes != 64)
+    name += "_w" + std::to_string(data_bytes);
   auto* ty = m.getTypeByName(name);
   if (ty != nullptr)
     return ty;
 
   auto& c = m.getContext();
-  auto *ar_ty = ArrayType::get(Type::getInt8Ty(c), 65);
+  auto *ar_ty = ArrayType::get(Type::getInt8Ty(c),
+                               data_bytes + control_bytes);
   return StructType::create(name, ar_ty);
 }
 
@@ -2027,7 +2198,12 @@ Type* get_nt_tap_map_ty(Module& m) {
 }
 
 /* Constants */
-uint64_t get_simple_bus_word_control_offs() { return   64; }
+/* The offset of the control byte which holds the EOP flag.  This is
+ * the high byte of the control field on buses wider than 64 bytes. */
+uint64_t get_simple_bus_word_control_offs() {
+  unsigned data_bytes = get_bus_data_bytes();
+  return data_bytes + (data_bytes > 64 ? 1 : 0);
+}
 uint8_t  get_simple_bus_word_control_eop()  { return 0x80; }
 }; //namespace nanotube
 
@@ -2043,6 +2219,7 @@ bool nt_api_call::is_packet() {
          intrin == Intrinsics::packet_write_masked ||
          intrin == Intrinsics::packet_edit ||
          intrin == Intrinsics::packet_bounded_length ||
+         intrin == Intrinsics::packet_csum ||
          intrin == Intrinsics::packet_data ||
          intrin == Intrinsics::packet_end ||
          intrin == Intrinsics::packet_resize;
@@ -2155,6 +2332,15 @@ Value* nt_api_call::get_dummy_arg(unsigned a) {
     case Intrinsics::packet_bounded_length:
       v = UndefValue::get(ty);
       break;
+    case Intrinsics::packet_csum:
+      switch( a ) {
+        case 0: /*fall-through */
+        case 1: /*fall-through */
+        case 3: v = UndefValue::get(ty); break;
+
+        case 2: v = ConstantInt::get(ty, 0); break;
+      };
+      break;
     case Intrinsics::map_op:
       switch( a ) {
         /* type = NANOTUBE_MAP_NOP */
@@ -2247,6 +2433,7 @@ std::vector<MemoryLocation> nt_api_call::get_input_mem() {
     case Intrinsics::packet_read:
     case Intrinsics::packet_edit:
     case Intrinsics::packet_bounded_length:
+    case Intrinsics::packet_csum:
     case Intrinsics::packet_get_port:
     case Intrinsics::packet_set_port:
     case Intrinsics::packet_data:
@@ -2318,6 +2505,7 @@ std::vector<MemoryLocation> nt_api_call::get_output_mem() {
     case Intrinsics::packet_write_masked:
     case Intrinsics::packet_edit:
     case Intrinsics::packet_bounded_length:
+    case Intrinsics::packet_csum:
     case Intrinsics::packet_get_port:
     case Intrinsics::packet_set_port:
     case Intrinsics::packet_data:
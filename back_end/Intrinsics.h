@@ -243,6 +243,16 @@ namespace nanotube
   static const unsigned PACKET_BOUNDED_LENGTH_ARG = 1;
   static const unsigned PACKET_BOUNDED_LENGTH_BIT_WIDTH = 64;
 
+  /* Unpack arguments of nanotube_packet_csum */
+  struct packet_csum_args {
+    packet_csum_args(Instruction* inst);
+    Value* packet;
+    Value* offset;
+    Value* length;
+    Value* seed;
+  };
+  static const unsigned PACKET_CSUM_OFFSET_ARG = 1;
+
   /* Unpack arguments of nanotube_packet_drop */
   struct packet_drop_args {
     packet_drop_args(Instruction* inst);
@@ -357,12 +367,14 @@ namespace nanotube
   Constant* create_nt_packet_end(Module& m);
   Constant* create_nt_packet_meta(Module& m);
   Constant* create_nt_packet_bounded_length(Module& m);
+  Constant* create_nt_packet_csum(Module& m);
   Constant* create_nt_packet_drop(Module& m);
   Constant* create_nt_packet_resize(Module& m);
   Constant* create_nt_packet_resize_ingress(Module& m);
   Constant* create_nt_packet_resize_egress(Module& m);
   Constant* create_nt_packet_drop(Module& m);
   Constant* create_nt_get_time_ns(Module& m);
+  Constant* create_nt_debug_packet_dropped(Module& m);
   FunctionType* get_nt_packet_resize_ingress_ty(Module& m);
   FunctionType* get_nt_packet_resize_egress_ty(Module& m);
   FunctionType* get_nt_packet_drop_ty(Module& m);
@@ -376,6 +388,8 @@ namespace nanotube
   Constant* create_packet_adjust_head_adapter(Module& m);
   Constant* create_packet_adjust_meta_adapter(Module& m);
   Constant* create_packet_handle_xdp_result(Module& m);
+  Constant* create_packet_redirect_adapter(Module& m);
+  Constant* create_packet_redirect_map_adapter(Module& m);
   Constant* create_nt_merge_data_mask(Module& m);
   Constant* create_bus_packet_set_port(Module& m, nanotube_bus_id_t bus_type);
   FunctionType* get_capsule_classify_ty(Module& m);
@@ -398,6 +412,12 @@ namespace nanotube
   FunctionType* get_tap_packet_length_ty(Module& m);
   Constant* create_tap_packet_length(Module& m, nanotube_bus_id_t bus_type);
 
+  StructType* get_nt_tap_packet_csum_req_ty(Module& m);
+  StructType* get_nt_tap_packet_csum_resp_ty(Module& m);
+  StructType* get_nt_tap_packet_csum_state_ty(Module& m);
+  FunctionType* get_tap_packet_csum_ty(Module& m);
+  Constant* create_tap_packet_csum(Module& m, nanotube_bus_id_t bus_type);
+
   StructType* get_nt_tap_packet_resize_cword_ty(Module& m);
   StructType* get_nt_tap_packet_resize_req_ty(Module& m);
 
@@ -462,6 +482,21 @@ namespace nanotube
   static const unsigned KERNEL_NUM_ARGS = 2;
   Constant* create_nt_add_plain_packet_kernel(Module& m);
 
+  /* Bounded loops; the function attribute records the maximum trip
+   * count of a loop outlined by the outline-loops pass, or the sum over
+   * the loops of a thread function converted by the loop-feedback pass. */
+  static const char* const LOOP_MAX_TRIPS_ATTR = "nanotube_loop_max_trips";
+  static inline
+  unsigned get_loop_max_trips(const Function& f) {
+    unsigned trips = 0;
+    if( !f.hasFnAttribute(LOOP_MAX_TRIPS_ATTR) )
+      return 0;
+    auto attr = f.getFnAttribute(LOOP_MAX_TRIPS_ATTR);
+    if( attr.getValueAsString().getAsInteger(10, trips) )
+      return 0;
+    return trips;
+  }
+
   /* Maps */
   FunctionType* get_nt_map_op_send_ty(Module& m);
   Constant* create_nt_map_op_send(Module& m);
@@ -469,6 +504,8 @@ namespace nanotube
   Constant* create_nt_map_op_receive(Module& m);
   FunctionType* get_nt_map_process_capsule_ty(Module& m);
   Constant* create_nt_map_process_capsule(Module& m);
+  FunctionType* get_nt_map_process_capsule_batch_ty(Module& m);
+  Constant* create_nt_map_process_capsule_batch(Module& m);
 
   FunctionType* get_nt_tap_map_recv_resp_ty(Module& m);
   Constant* create_nt_tap_map_recv_resp(Module& m);
@@ -13,304 +13,270 @@
 
 #define DEBUG_TYPE "liveness"
 
-namespace std {
-  template<> struct hash<llvm::MemoryLocation> {
-    std::size_t operator()(const llvm::MemoryLocation& mloc) const noexcept {
-      std::size_t h1 = std::hash<const llvm::Value*>{}(mloc.Ptr);
-      std::size_t h2 = mloc.Size.toRaw();
-      return h1 ^ h2;
-    }
-  };
+#include "llvm/ADT/PostOrderIterator.h"
+
+#define DEBUG_TYPE "liveness"
+
+void liveness_info_t::append_live(const BitVector& val_bits,
+                                  const BitVector& mem_bits,
+                                  std::vector<Value*>* values,
+                                  std::vector<MemoryLocation>* stack) {
+  for( auto idx : mem_bits.set_bits() )
+    stack->push_back(mlocs[idx]);
+  for( auto idx : val_bits.set_bits() )
+    values->push_back(this->values[idx]);
 }
 
 void liveness_info_t::get_live_in(Instruction *inst,
                                   std::vector<Value*>* values,
                                   std::vector<MemoryLocation>* stack) {
-  auto mem_it = live_mem_in_inst.find(inst);
-  auto val_it = live_in_inst.find(inst);
-
-  if( mem_it != live_mem_in_inst.end() ) {
-    stack->insert(stack->end(), mem_it->second.begin(),
-                  mem_it->second.end());
-  }
-
-  if( val_it != live_in_inst.end() ) {
-    values->insert(values->end(), val_it->second.begin(),
-                   val_it->second.end());
-  }
+  if( !compute_block_insts(inst->getParent()) )
+    return;
+  auto pos = cached_pos.lookup(inst);
+  append_live(cached_val_in[pos], cached_mem_in[pos], values, stack);
 }
 
 void liveness_info_t::get_live_out(Instruction* inst,
                                    std::vector<Value*>* values,
                                    std::vector<MemoryLocation>* stack) {
-  auto mem_it = live_mem_out_inst.find(inst);
-  auto val_it = live_out_inst.find(inst);
-
-  if( mem_it != live_mem_out_inst.end() ) {
-    stack->insert(stack->end(), mem_it->second.begin(),
-                  mem_it->second.end());
-  }
-
-  if( val_it != live_out_inst.end() ) {
-    values->insert(values->end(), val_it->second.begin(),
-                   val_it->second.end());
-  }
+  if( !compute_block_insts(inst->getParent()) )
+    return;
+  auto pos = cached_pos.lookup(inst);
+  append_live(cached_val_out[pos], cached_mem_out[pos], values, stack);
 }
 
-void
-liveness_info_t::find_producers_in_def(Instruction* inst, MemoryAccess* acc,
-                                       MemoryLocation mloc,
-                                       std::vector<memory_use_t>* memory_uses)
-{
-  aa_helper aah(aa);
-  auto* walker = mssa->getWalker();
-  while( true ) {
-    LLVM_DEBUG(dbgs() << "    Memory access " << *acc << '\n');
-
-    /* Nothing before us... remaining mlocs must be from elsewhere */
-    if( mssa->isLiveOnEntryDef(acc) ) {
-      LLVM_DEBUG(dbgs() << "    LiveOnEntry\n");
-      memory_uses->emplace_back(nullptr, inst, mloc);
-      return;
-    }
-
-    /* Special case: this is a MemoryPHI -> simply continue tracing
-     * through the children */
-    if( isa<MemoryPhi>(acc) ) {
-      LLVM_DEBUG(
-        dbgs() << "    Memory Phi following\n";
-        for( auto it = acc->defs_begin(); it != acc->defs_end(); ++it)
-          dbgs() << "      " << **it << '\n';
-      );
-
-      for( auto it = acc->defs_begin(); it != acc->defs_end(); ++it)
-        find_producers_in_def(inst, *it, mloc, memory_uses);
-      return;
-    }
-
-    /* Bail if there is more madness :) */
-    if( !isa<MemoryDef>(acc) ) {
-      errs() << "ERROR: Liveness Analysis - Unusual MemoryAccess:" << *acc
-             << "\nAborting!\n";
-      assert(false);
-    }
-
-    auto* memdef  = cast<MemoryDef>(acc);
-    auto* meminst = memdef->getMemoryInst();
-    LLVM_DEBUG(dbgs() << "    Inst: " << *meminst << '\n');
-    if( isa<CallInst>(meminst) && ignore_function(cast<CallInst>(meminst)) ) {
-      acc = walker->getClobberingMemoryAccess(memdef);
-      continue;
-    }
+/**
+ * Derive the liveness at each instruction of a basic block from the
+ * summary of the block.  The results are cached until the next call
+ * with a different block.  Returns false if the block is not part of
+ * the analysed function.
+ */
+bool liveness_info_t::compute_block_insts(const BasicBlock* bb) {
+  if( bb == cached_bb )
+    return true;
 
-    /* Check overlap with the defining store */
-    auto mri = aah.get_mri(meminst, mloc);
-    if( isModSet(mri) ) {
-      /* Special case: Check the base of the mloc for being (derived from)
-       * a PHI node */
-      auto* ptr_base =
-        const_cast<Value*>(mloc.Ptr->stripPointerCasts());
-      if( isa<PHINode>(ptr_base) || isa<SelectInst>(ptr_base) ) {
-        std::vector<Value*> incoming_values;
-        if( isa<PHINode>(ptr_base) ) {
-          LLVM_DEBUG(dbgs() << "    PHI Base: " << *ptr_base << '\n');
-          auto* phi = cast<PHINode>(ptr_base);
-          for( auto& u : phi->incoming_values() )
-            incoming_values.emplace_back(u.get());
-        } else {
-          LLVM_DEBUG(dbgs() << "    Select Base: " << *ptr_base << '\n');
-          auto* sel = cast<SelectInst>(ptr_base);
-          incoming_values.emplace_back(sel->getTrueValue());
-          incoming_values.emplace_back(sel->getFalseValue());
-        }
+  auto it = blocks.find(bb);
+  if( it == blocks.end() )
+    return false;
+  auto& bi = it->second;
+
+  cached_bb = bb;
+  cached_pos.clear();
+  auto n = bb->size();
+  cached_val_in.assign(n, BitVector());
+  cached_val_out.assign(n, BitVector());
+  cached_mem_in.assign(n, BitVector());
+  cached_mem_out.assign(n, BitVector());
+
+  /* Forward: memory locations written before / after each instruction */
+  BitVector written = bi.mem_written_in;
+  unsigned pos = 0;
+  for( auto& inst : *bb ) {
+    cached_pos[&inst] = pos;
+    cached_mem_in[pos] = written;
+    auto acc_it = mem_accesses.find(&inst);
+    if( acc_it != mem_accesses.end() )
+      written |= acc_it->second.writes;
+    cached_mem_out[pos] = written;
+    pos++;
+  }
 
-        /* We now know that the consumer reads from a "split" memory
-         * location.  Let's check the defined constituents and see if they
-         * are ALL overwritten, which suggests the store also writes to the
-         * "split" location.*/
-        bool all_bases_stored = true;
-        for( auto* v : incoming_values ) {
-          if( isa<UndefValue>(v) )
-            continue;
-          auto part_mri = aah.get_mri(meminst, mloc.getWithNewPtr(v));
-          all_bases_stored &= isModSet(part_mri);
-          LLVM_DEBUG(dbgs() << "    Checking " << *v
-                            << " Res: " << part_mri << '\n');
-        }
-        if( !all_bases_stored ) {
-          /* Create separate memory uses for the
-           *   producerS -> phi
-           * and
-           *   phi -> original consumer */
-
-          LLVM_DEBUG(dbgs() << "    Not all covered => splitting "
-                            << "MemoryLocation!\n");
-          memory_uses->emplace_back(ptr_base, inst, mloc);
-          for( auto* v : incoming_values ) {
-            if( isa<UndefValue>(v) )
-              continue;
-            find_producers_in_def(cast<Instruction>(ptr_base), acc,
-                mloc.getWithNewPtr(v), memory_uses);
-          }
-          return;
-        }
+  /* Backward: values used and memory locations read later */
+  BitVector live = bi.live_out;
+  BitVector read = bi.mem_read_out;
+  for( auto inst_it = bb->rbegin(); inst_it != bb->rend(); ++inst_it ) {
+    auto& inst = *inst_it;
+    pos--;
+    cached_val_out[pos] = live;
+    cached_mem_out[pos] &= read;
+
+    auto idx_it = value_idx.find(&inst);
+    if( idx_it != value_idx.end() )
+      live.reset(idx_it->second);
+    if( !isa<PHINode>(&inst) ) {
+      for( auto& op : inst.operands() ) {
+        auto op_it = value_idx.find(op.get());
+        if( op_it != value_idx.end() )
+          live.set(op_it->second);
       }
-
-      /* Normal case: simply add the use */
-      memory_uses->emplace_back(meminst, inst, mloc);
-
-      /* XXX: Only return when we are sure that there are no possible other
-       * stores to the memory location (for example due to MayAlias / Mod)
-       * or PartialAlias */
-      return;
     }
+    auto acc_it = mem_accesses.find(&inst);
+    if( acc_it != mem_accesses.end() )
+      read |= acc_it->second.reads;
 
-    /* Continue looking if our memory location did not alias */
-    acc = walker->getClobberingMemoryAccess(memdef);
+    cached_val_in[pos] = live;
+    cached_mem_in[pos] &= read;
   }
+  return true;
 }
 
-void liveness_info_t::memory_liveness_analysis_backward(Function& f) {
-  /* Liveness analysis for all memory locations */
-  errs() << f.getName() << '\n';
-
-  std::vector<memory_use_t> memory_uses;
+/**
+ * Number the values which are used by instructions of the function:
+ * arguments, global variables and instructions.  Uses by constant
+ * expressions are not considered.
+ */
+void liveness_info_t::number_values(Function& f) {
+  auto add = [&](Value* v) {
+    if( value_idx.insert(std::make_pair(v, values.size())).second )
+      values.push_back(v);
+  };
 
+  for( auto& arg : f.args() ) {
+    if( !arg.use_empty() )
+      add(&arg);
+  }
   for( auto& inst : instructions(f) ) {
-    std::vector<MemoryLocation> in_mlocs;
-    std::vector<MemoryDef*>     in_mdef;
-    std::vector<MemoryLocation> out_mlocs;
-    std::vector<MemoryDef*>     out_mdef;
-
-    /* Process potential memory producers */
-    //XXX: Do we actually need to do anything?
-    if( inst.mayWriteToMemory() ) {
+    for( auto& op : inst.operands() ) {
+      if( isa<GlobalVariable>(op.get()) )
+        add(op.get());
     }
+  }
+  for( auto& inst : instructions(f) ) {
+    if( !inst.use_empty() )
+      add(&inst);
+  }
+}
 
-    /* Trace back memory locations from consumers */
-    if( inst.mayReadFromMemory() ) {
-      LLVM_DEBUG(dbgs() << inst << '\n');
-      bool succ = get_memory_inputs(&inst, &in_mlocs, &in_mdef);
-      if( !succ ) {
-        errs() << "ERROR: Liveness Analysis - Could not properly analyse "
-               << "memory for\n" << inst << '\n';
-        assert(false);
-        //continue;
+/**
+ * Compute the live values at the boundaries of the basic blocks.  This is
+ * the usual backward dataflow problem:
+ *
+ *   live_out(B) = phi_use(B) + union over successors S of live_in(S)
+ *   live_in(B)  = use(B) + (live_out(B) - def(B))
+ *
+ * where the values used by PHI nodes are live at the end of the
+ * respective predecessor rather than at the start of the PHI's block.
+ */
+void liveness_info_t::compute_value_summaries(Function& f) {
+  auto n = values.size();
+  for( auto& bb : f ) {
+    auto& bi = blocks[&bb];
+    bi.use.resize(n);
+    bi.def.resize(n);
+    bi.phi_use.resize(n);
+    bi.live_out.resize(n);
+
+    for( auto& inst : bb ) {
+      if( !isa<PHINode>(&inst) ) {
+        for( auto& op : inst.operands() ) {
+          auto it = value_idx.find(op.get());
+          if( it != value_idx.end() && !bi.def.test(it->second) )
+            bi.use.set(it->second);
+        }
       }
+      auto it = value_idx.find(&inst);
+      if( it != value_idx.end() )
+        bi.def.set(it->second);
+    }
 
-      // dbgs() << "    Memory Locations:\n";
-      // for( auto& mloc : in_mlocs )
-      //   dbgs() << "      " << mloc << '\n';
-
-      /* Walk the MemorySSA and collect writers */
-      auto* walker = mssa->getWalker();
-      MemoryAccess* memacc = mssa->getMemoryAccess(&inst);
-      memacc = walker->getClobberingMemoryAccess(memacc);
+    for( auto* succ : successors(&bb) ) {
+      for( auto& phi : succ->phis() ) {
+        auto* v  = phi.getIncomingValueForBlock(&bb);
+        auto it = value_idx.find(v);
+        if( it != value_idx.end() )
+          bi.phi_use.set(it->second);
+      }
+    }
+    bi.live_in = bi.use;
+  }
 
-      for( auto mloc : in_mlocs )
-        find_producers_in_def(&inst, memacc, mloc, &memory_uses);
-    } /* if inst.mayReadFromMemory() */
+  /* Visit the blocks in post order, so that the successors come first
+   * and the iteration converges quickly. */
+  std::vector<BasicBlock*> order(po_begin(&f), po_end(&f));
+  SmallPtrSet<BasicBlock*, 32> reachable(order.begin(), order.end());
+  for( auto& bb : f ) {
+    if( reachable.count(&bb) == 0 )
+      order.push_back(&bb);
   }
 
-  std::sort(memory_uses.begin(), memory_uses.end(), memory_use_t::cmp);
-  LLVM_DEBUG(
-    for( auto& mu : memory_uses ) {
-      dbgs() << "Memory Use\n  Prod: ";
-      if( mu.producer != nullptr )
-        dbgs() << *mu.producer;
-      else
-        dbgs() << "LiveOnEntry";
-      dbgs() << "\n  Cons: " << *mu.consumer
-             << "\n  Loc: " << mu.loc << '\n';
+  bool changed = true;
+  BitVector tmp;
+  while( changed ) {
+    changed = false;
+    for( auto* bb : order ) {
+      auto& bi = blocks[bb];
+      tmp = bi.phi_use;
+      for( auto* succ : successors(bb) )
+        tmp |= blocks[succ].live_in;
+      if( tmp == bi.live_out )
+        continue;
+      bi.live_out = tmp;
+      tmp.reset(bi.def);
+      tmp |= bi.use;
+      bi.live_in = tmp;
+      changed = true;
     }
-  );
+  }
 }
 
-template <typename M, typename V>
-using map_to_vec_t = std::unordered_map<M, std::vector<V>>;
-template <typename M, typename S>
-using map_to_set_t = std::unordered_map<M, std::unordered_set<S>>;
-
 /**
- * Compute live memory locations for a function in a forward pass.
- *
- * The algorithm consists of multiple steps:
- * (1) collect found allocations (memory locations) and record them per
- *     basic block.  collect instructions (loads / stores / calls) that
- *     access these allocations => this flows forwards and builds the lists
- *     of available (visible) memory locatins per basic block and then
- *     intersects these locations with the instructions in the block
- * (2) flow the information of readers backwards through the program on the
- *     basic blocks to capture liveness that way; and record when a read is
- *     the last one to access the location (this can be multiple loads per
- *     location in case control flow diverges)
- * (3) trace backwards on the instruction level and mark all instruction
- *     between the last read and the first write as having the memory
- *     location live.
- *
- * TOOD:
- *   - instead of always querying all (detected) memory locations with all
- *     loads / stores / calls, we could flow forward the allocations
- *     through the program (and through pointer transformations and phis)
- *     and mark each load / store with the allocations it could potentially
- *     access => that is basically again what the mem2req pass does
+ * Number the memory locations of the allocas and record which of them
+ * each instruction may read or write.  Each instruction is only checked
+ * against the allocas which are available on some path to it.
  */
-void liveness_info_t::memory_liveness_analysis_forward(Function& f) {
+void liveness_info_t::collect_memory_accesses(Function& f) {
   aa_helper aah(aa);
   const auto& dl = f.getParent()->getDataLayout();
 
-  /* Known memory locations coming out of / going into a basic block */
-  map_to_set_t<BasicBlock*, MemoryLocation> out_locs;
-
-  /* Capture all potential(!) readers / writers per mem loc */
-  map_to_vec_t<MemoryLocation, Instruction*> writers, readers;
-
-  /* Track the outgoing and incoming written mem locs per bb */
-  map_to_set_t<BasicBlock*, MemoryLocation> out_written;
-
-  /* Record first / last accesses that limit the lifetime.  Note that this
-   * can be multiple, e.g., in parallel basic blocks. */
-  map_to_vec_t<MemoryLocation, Instruction*> first_writes, last_reads;
-
-  /* Collect readers per BB for backwards traversal */
-  map_to_vec_t<BasicBlock*, Instruction*> reads;
-
-  /* Collect mem locs per read for backwards traversal */
-  map_to_vec_t<Instruction*, MemoryLocation> read_locs;
-
-  typedef dep_aware_converter<BasicBlock> dac_t;
-  dac_t dac;
-  for( auto& bb : f )
-    dac.insert(&bb, pred_size(&bb));
+  DenseMap<const Value*, unsigned> alloca_idx;
+  for( auto& inst : instructions(f) ) {
+    auto* alloca = dyn_cast<AllocaInst>(&inst);
+    if( alloca == nullptr )
+      continue;
+    auto size   = alloca->getAllocationSizeInBits(dl);
+    auto tysize = LocationSize::unknown();
+    if( size.hasValue() ) {
+      tysize = LocationSize::precise(size.getValue() / 8);
+    } else {
+      errs() << "Unknown size for alloca: " << *alloca << '\n';
+    }
+    alloca_idx[alloca] = mlocs.size();
+    mlocs.emplace_back(alloca, tysize);
+  }
 
-  /* Walk through all basic blocks in CFG compatible order, and collect
-   * information about allocas and how they are accessed */
-  dac.execute([&](dac_t* dac, BasicBlock* bb) {
-    LLVM_DEBUG(dbgs() << bb->getName() << '\n');
+  /* Flow the available allocas forward through the CFG */
+  auto n = mlocs.size();
+  DenseMap<const BasicBlock*, BitVector> avail_out;
+  ReversePostOrderTraversal<Function*> rpot(&f);
+  bool changed = true;
+  while( changed ) {
+    changed = false;
+    for( auto* bb : rpot ) {
+      BitVector avail(n);
+      for( auto* pred : predecessors(bb) ) {
+        auto it = avail_out.find(pred);
+        if( it != avail_out.end() )
+          avail |= it->second;
+      }
+      for( auto& inst : *bb ) {
+        auto it = alloca_idx.find(&inst);
+        if( it != alloca_idx.end() )
+          avail.set(it->second);
+      }
+      auto& out = avail_out[bb];
+      if( out.size() == n && out == avail )
+        continue;
+      out = std::move(avail);
+      changed = true;
+    }
+  }
 
-    for( auto* pred : predecessors(bb) ) {
-      /* Compute in-memloc as the union over the previous out-memloc */
-      auto& pred_out = out_locs[pred];
-      out_locs[bb].insert(pred_out.begin(), pred_out.end());
+  for( auto& bb : f ) {
+    auto& bi = blocks[&bb];
+    bi.mem_reads.resize(n);
+    bi.mem_writes.resize(n);
 
-      /* Union of previous outs is our in */
-      auto& pred_wr = out_written[pred];
-      out_written[bb].insert(pred_wr.begin(), pred_wr.end());
+    BitVector avail(n);
+    for( auto* pred : predecessors(&bb) ) {
+      auto it = avail_out.find(pred);
+      if( it != avail_out.end() )
+        avail |= it->second;
     }
 
-    for( auto& inst : *bb ) {
-      /* Record interesting memory locations; from allocas only (for now) */
-      auto* alloca = dyn_cast<AllocaInst>(&inst);
-      if( alloca != nullptr ) {
-        auto size   = alloca->getAllocationSizeInBits(dl);
-        auto tysize = LocationSize::unknown();
-        if( size.hasValue() ) {
-          tysize = LocationSize::precise(size.getValue() / 8);
-        } else {
-          errs() << "Unknown size for alloca: " << *alloca << '\n';
-        }
-        out_locs[bb].emplace(alloca, tysize);
-      }
+    for( auto& inst : bb ) {
+      auto a_it = alloca_idx.find(&inst);
+      if( a_it != alloca_idx.end() )
+        avail.set(a_it->second);
 
       if( !inst.mayReadFromMemory() && !inst.mayWriteToMemory() )
         continue;
@@ -319,204 +285,112 @@ void liveness_info_t::memory_liveness_analysis_forward(Function& f) {
       if( isa<CallInst>(&inst) && ignore_function(cast<CallInst>(&inst)) )
         continue;
 
-      /* Intersect the current instruction with all known memory locations */
-      bool inst_reads = false;
-      bool print_ins  = true;
-      for( auto& mloc : out_locs[bb] ) {
-        auto res    = aah.get_mri(&inst, mloc);
+      /* Intersect the instruction with all available memory locations */
+      mem_access_t acc;
+      acc.reads.resize(n);
+      acc.writes.resize(n);
+      bool any = false;
+      for( auto idx : avail.set_bits() ) {
+        auto res = aah.get_mri(&inst, mlocs[idx]);
         if( isNoModRef(res) )
           continue;
-        bool rd = inst.mayReadFromMemory() && isRefSet(res);
-        bool wr = inst.mayWriteToMemory()  && isModSet(res);
-
-        if( rd ) {
-          readers[mloc].emplace_back(&inst);
-          read_locs[&inst].emplace_back(mloc);
-          inst_reads = true;
+        if( inst.mayReadFromMemory() && isRefSet(res) ) {
+          acc.reads.set(idx);
+          any = true;
         }
-        if( wr ) {
-          writers[mloc].emplace_back(&inst);
-          bool new_one = out_written[bb].insert(mloc).second;
-          if( new_one )
-            first_writes[mloc].emplace_back(&inst);
-        }
-
-        /* Debug output */
-        if( print_ins ) {
-          LLVM_DEBUG(dbgs() << inst << "\n");
-          print_ins = false;
+        if( inst.mayWriteToMemory() && isModSet(res) ) {
+          acc.writes.set(idx);
+          any = true;
         }
         LLVM_DEBUG(
-          dbgs() << "    " << (rd ? "R" : "") << (wr ? "W" : "");
-          dbgs() << mloc << '\n';
+          dbgs() << inst << "\n    "
+                 << (acc.reads.test(idx) ? "R" : "")
+                 << (acc.writes.test(idx) ? "W" : "")
+                 << mlocs[idx] << '\n';
         );
-      } /* for( auto* alloca : out_allocas[bb] ) */
-
-      /* Collect instructions per BB that read (at least) one of our
-       * known locations */
-      if( inst_reads )
-        reads[bb].emplace_back(&inst);
-    } /* for( auto& inst : *bb ) */
-
-    for( auto* succ : successors(bb) )
-      dac->mark_dep_ready(succ);
-  });
-
-
-  /* Record per-BB which memory locations are known to be live, aka, read
-   * in a successor */
-  map_to_set_t<BasicBlock*, MemoryLocation> known_live;
-
-  /* Go backwards through the CFG and track the last reads per alloca */
-  for( auto& bb : f )
-    dac.insert(&bb, succ_size(&bb));
-
-  dac.execute([&](dac_t* dac, BasicBlock* bb) {
-    /* Our known-live values are the union of the successors */
-    for( auto* succ : successors(bb) ) {
-      auto& succ_known = known_live[succ];
-      known_live[bb].insert(succ_known.begin(), succ_known.end());
-    }
-
-    /* Add any reads / read memory locations to the known-live list, and
-     * find the last read (by going reverse and remembering the first) for
-     * each location */
-    for( auto it = reads[bb].rbegin(); it != reads[bb].rend(); ++it ) {
-      auto* read = *it;
-      for( auto& mloc : read_locs[read] ) {
-        bool new_one = known_live[bb].insert(mloc).second;
-        if( new_one )
-          last_reads[mloc].emplace_back(read);
       }
-    }
-
-    for( auto* pred : predecessors(bb) )
-      dac->mark_dep_ready(pred);
-  });
-
-  /* Record live memory per instruction */
-  /* XXX: Instead of tracing back through the program once for every single
-   * mloc, we should be backtracking through the program once, and have a
-   * map instruction -> vector of mloc that captures the last reads, and
-   * the same for instruction -> vector of mloc to capture the first write.
-   * Then go through all instructions once, and keep a set of active mlocs
-   * and only do delta updates, here.  That might be a little tricky with
-   * branches and joins, but should be doable.
-   * IIRC, I wrote that to begin with but then got royally confused.  It
-   * also feels like the bactracking on the BBs would be enough to capture
-   * this?!?
-   *
-   * Alternatively / in addition, it would make sense to track this only on
-   * a per-BB level for those blocks where the liveness does not change
-   * (i.e. those that are not first_write->getParent() or
-   * last_read->getParent().
-   */
-  for( auto& mloc_vec : last_reads ) {
-    auto& mloc   = mloc_vec.first;
-    auto& ends   = mloc_vec.second;
-    std::unordered_set<Instruction*> starts(first_writes[mloc].begin(),
-                                            first_writes[mloc].end());
-
-    std::vector<Instruction*>       todo(ends.begin(), ends.end());
-    std::unordered_set<BasicBlock*> done_bb;
-
-    while( todo.size() != 0 ) {
-      auto* inst = todo.back();
-      auto* bb   = inst->getParent();
-      todo.pop_back();
-
-      /* We have found a livetime start -> done */
-      if( starts.count(inst) != 0)
+      if( !any )
         continue;
-
-      /* Keep tracing */
-      mark(live_mem_in_inst, inst, mloc);
-      if( inst != &bb->front() ) {
-        /* Mark previous inst live out, and add to worklist */
-        auto* pred_inst = inst->getPrevNode();
-        mark(live_mem_out_inst, pred_inst, mloc);
-        todo.push_back(pred_inst);
-      } else {
-        /* Close this BB and trace through the predecessors */
-        mark(live_mem_in_bb, bb, mloc);
-        done_bb.insert(bb);
-        for( auto* pred : predecessors(bb) ) {
-          /* Skip blocks we have already processed */
-          if( done_bb.count(pred) != 0 )
-            continue;
-          /* Skip blocks that don't have the location live */
-          if( out_written[pred].count(mloc) == 0 )
-            continue;
-          mark(live_mem_out_bb, pred, mloc);
-          auto* pred_inst = &pred->back();
-          mark(live_mem_out_inst, pred_inst, mloc);
-          todo.push_back(pred_inst);
-        }
-      }
+      bi.mem_reads  |= acc.reads;
+      bi.mem_writes |= acc.writes;
+      mem_accesses[&inst] = std::move(acc);
     }
   }
+}
 
-  /* Print out our findings */
-  LLVM_DEBUG(
-    for( auto& mloc_vec : first_writes ) {
-      auto& mloc = mloc_vec.first;
-      dbgs() << "MLoc: " << mloc << "\n  First write(s):\n";
-      for( auto* wr : mloc_vec.second )
-        dbgs() << "  " << *wr << '\n';
-      dbgs() << "  Last read(s):\n";
-      for( auto* rd : last_reads[mloc] )
-        dbgs() << "  " << *rd << '\n';
-    }
-  );
+/**
+ * Compute the live memory locations at the boundaries of the basic
+ * blocks.  A memory location is live at a point if it may have been
+ * written on a path to the point (forward problem) and may be read on a
+ * path from the point (backward problem).  Neither problem has a kill
+ * set, because the accesses are may-accesses.
+ */
+void liveness_info_t::compute_memory_summaries(Function& f) {
+  auto n = mlocs.size();
+  for( auto& bb : f ) {
+    auto& bi = blocks[&bb];
+    bi.mem_written_in.resize(n);
+    bi.mem_written_out = bi.mem_writes;
+    bi.mem_read_in     = bi.mem_reads;
+    bi.mem_read_out.resize(n);
+  }
 
-  /* Print out liveness per instruction in CFG-friendly order */
-  LLVM_DEBUG(
-    for( auto& bb : f )
-      dac.insert(&bb, pred_size(&bb));
-    dac.execute([&](dac_t* dac, BasicBlock* bb) {
-      dbgs() << '\n' << bb->getName() << ":\n";
-      for ( auto& inst : *bb ) {
-        dbgs() << inst << '\n';
-        if( live_mem_in_inst[&inst].size() > 0 )
-          dbgs() << "    Live In:\n";
-        for( auto& mloc : live_mem_in_inst[&inst] )
-          dbgs() << "    " << mloc << '\n';
-        if( live_mem_out_inst[&inst].size() > 0 )
-          dbgs() << "    Live Out:\n";
-        for( auto& mloc : live_mem_out_inst[&inst] )
-          dbgs() << "    " << mloc << '\n';
-      }
+  ReversePostOrderTraversal<Function*> rpot(&f);
+  bool changed = true;
+  while( changed ) {
+    changed = false;
+    for( auto* bb : rpot ) {
+      auto& bi = blocks[bb];
+      BitVector in(n);
+      for( auto* pred : predecessors(bb) )
+        in |= blocks[pred].mem_written_out;
+      if( in == bi.mem_written_in )
+        continue;
+      bi.mem_written_in  = in;
+      bi.mem_written_out = in;
+      bi.mem_written_out |= bi.mem_writes;
+      changed = true;
+    }
+  }
 
+  changed = true;
+  while( changed ) {
+    changed = false;
+    for( auto* bb : post_order(&f) ) {
+      auto& bi = blocks[bb];
+      BitVector out(n);
       for( auto* succ : successors(bb) )
-        dac->mark_dep_ready(succ);
-    });
-  );
+        out |= blocks[succ].mem_read_in;
+      if( out == bi.mem_read_out )
+        continue;
+      bi.mem_read_out = out;
+      bi.mem_read_in  = out;
+      bi.mem_read_in |= bi.mem_reads;
+      changed = true;
+    }
+  }
 }
 
 void liveness_info_t::reset_state() {
-  live_mem_in_inst.clear();
-  live_mem_out_inst.clear();
-  live_mem_in_bb.clear();
-  live_mem_out_bb.clear();
-  live_in_inst.clear();
-  live_out_inst.clear();
-  live_in_bb.clear();
-  live_out_bb.clear();
+  values.clear();
+  value_idx.clear();
+  mlocs.clear();
+  mem_accesses.clear();
+  blocks.clear();
+  cached_bb = nullptr;
+  cached_pos.clear();
 }
 
 void liveness_info_t::recompute(Function& f) {
   reset_state();
 
   /* Liveness analysis for all values */
-  for( auto& arg : f.args() )
-    liveness_analysis(&arg);
-  for( auto& g : f.getParent()->globals() )
-    liveness_analysis(&g);
-  for( auto& inst : instructions(f) )
-    liveness_analysis(&inst);
-
-  memory_liveness_analysis_forward(f);
-  //memory_liveness_analysis_backward(f);
+  number_values(f);
+  compute_value_summaries(f);
+
+  /* Liveness analysis for the stack allocations */
+  collect_memory_accesses(f);
+  compute_memory_summaries(f);
   LLVM_DEBUG(print_liveness_results(dbgs(), f));
 }
 
@@ -650,73 +524,33 @@ bool liveness_info_t::get_memory_inputs(Value* val,
 }
 
 void liveness_info_t::print_liveness_results(raw_ostream& os, Function& f) {
-  typedef dep_aware_converter<BasicBlock> dac_t;
-  dac_t dac;
-  for( auto& bb : f )
-    dac.insert(&bb, pred_size(&bb));
-
   os << "Function: " << f.getName() << " Liveness\n";
-  dac.execute([&](dac_t* dac, BasicBlock* bb) {
-    dbgs() << '\n' << bb->getName() << ":\n";
-    for ( auto& inst : *bb ) {
+  for( auto& bb : f ) {
+    os << '\n' << bb.getName() << ":\n";
+    compute_block_insts(&bb);
+    for( auto& inst : bb ) {
+      auto pos = cached_pos.lookup(&inst);
       os << inst << '\n';
       os << "    Live In: ";
-      for( auto* v : live_in_inst[&inst] ) {
-        v->printAsOperand(os, false);
+      for( auto idx : cached_val_in[pos].set_bits() ) {
+        values[idx]->printAsOperand(os, false);
         os << " ";
       }
+      for( auto idx : cached_mem_in[pos].set_bits() )
+        os << mlocs[idx] << " ";
       os << '\n';
       os << "    Live Out: ";
-      for( auto* v : live_out_inst[&inst] ) {
-        v->printAsOperand(os, false);
+      for( auto idx : cached_val_out[pos].set_bits() ) {
+        values[idx]->printAsOperand(os, false);
         os << " ";
       }
+      for( auto idx : cached_mem_out[pos].set_bits() )
+        os << mlocs[idx] << " ";
       os << '\n';
     }
-
-    for( auto* succ : successors(bb) )
-      dac->mark_dep_ready(succ);
-  });
-}
-
-void liveness_info_t::liveness_analysis(Value* v) {
-  done.clear();
-  for( auto& u : v->uses() ) {
-    auto* inst = dyn_cast<Instruction>(u.getUser());
-    if( inst == nullptr )
-      continue;
-    if( isa<PHINode>(inst) ) {
-      auto* phi = cast<PHINode>(inst);
-      live_out_at_block(phi->getIncomingBlock(u), v);
-    } else {
-      live_in_at_statement(inst, v);
-    }
   }
 }
-void liveness_info_t::live_out_at_block(BasicBlock* bb, Value* v) {
-  mark(live_out_bb, bb, v);
-  if( done.count(bb) > 0 )
-    return;
-  done.insert(bb);
-  live_out_at_statement(&bb->back(), v);
-}
-void liveness_info_t::live_in_at_statement(Instruction* inst, Value* v) {
-  mark(live_in_inst, inst, v);
-  auto* bb = inst->getParent();
-  if( inst == &bb->front() ) {
-    mark(live_in_bb, bb, v);
-    for( auto* pred : predecessors(bb) )
-      live_out_at_block(pred, v);
-  } else {
-    live_out_at_statement(inst->getPrevNode(), v);
-  }
-}
-void liveness_info_t::live_out_at_statement(Instruction* inst, Value* v) {
-  mark(live_out_inst, inst, v);
-  Value* def = inst; // XXX: This will need changes for memory locations!
-  if( v != def )
-    live_in_at_statement(inst, v);
-}
+
 char liveness_analysis::ID = 0;
 static RegisterPass<liveness_analysis>
   X("liveness", "Analyse liveness of values and stack allocations.",
@@ -14,6 +14,8 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/CFG.h"
 #include "llvm/Analysis/CFGPrinter.h"
@@ -38,6 +40,17 @@ using namespace nanotube;
 namespace nanotube {
 class liveness_analysis;
 
+/*!
+** Liveness of the values and stack allocations of a function.
+**
+** The values and the memory locations of the allocas of the function
+** are numbered when the analysis is computed, so that sets of them are
+** dense bit vectors.  The dataflow is solved on the basic blocks only;
+** the liveness at an instruction is derived from the summary of its
+** block when it is queried.  The instruction level results of the most
+** recently queried block are kept, so that queries which walk through a
+** block in order are cheap.
+**/
 class liveness_info_t {
 public:
   void get_live_in(Instruction* inst,
@@ -55,39 +68,56 @@ private:
   AliasAnalysis*     aa;
   TargetLibraryInfo* tli;
 
-  typedef std::unordered_map<Instruction*, std::vector<MemoryLocation>>
-    inst_to_memloc_vec_t;
-  typedef std::unordered_map<BasicBlock*, std::vector<MemoryLocation>>
-    bb_to_memloc_vec_t;
-  typedef std::unordered_map<Instruction*, std::vector<Value*>>
-    inst_to_val_vec_t;
-  typedef std::unordered_map<BasicBlock*, std::vector<Value*>>
-    bb_to_val_vec_t;
+  /* The numbered values and memory locations */
+  std::vector<Value*>              values;
+  DenseMap<const Value*, unsigned> value_idx;
+  std::vector<MemoryLocation>      mlocs;
 
-  inst_to_memloc_vec_t live_mem_in_inst, live_mem_out_inst;
-  bb_to_memloc_vec_t   live_mem_in_bb,   live_mem_out_bb;
-  inst_to_val_vec_t    live_in_inst,     live_out_inst;
-  bb_to_val_vec_t      live_in_bb,       live_out_bb;
+  /* The numbered memory locations read / written by an instruction */
+  struct mem_access_t {
+    BitVector reads;
+    BitVector writes;
+  };
+  DenseMap<const Instruction*, mem_access_t> mem_accesses;
+
+  /* Dataflow summary of a basic block.  Values are live from their
+   * definition to their last use.  Memory locations are live between
+   * points which can be reached from a write and which can reach a read
+   * of the location. */
+  struct block_info_t {
+    /* Values used before being defined in the block (not counting PHI
+     * nodes), values defined in the block and values used by PHI nodes
+     * of the successors on the edges leaving the block. */
+    BitVector use, def, phi_use;
+    BitVector live_in, live_out;
+
+    /* Memory locations accessed by the block */
+    BitVector mem_reads, mem_writes;
+    /* Memory locations written on some path to the block boundary */
+    BitVector mem_written_in, mem_written_out;
+    /* Memory locations read on some path from the block boundary */
+    BitVector mem_read_in, mem_read_out;
+  };
+  DenseMap<const BasicBlock*, block_info_t> blocks;
 
-  void reset_state();
+  /* Instruction level liveness of the most recently queried block */
+  const BasicBlock*                      cached_bb = nullptr;
+  DenseMap<const Instruction*, unsigned> cached_pos;
+  std::vector<BitVector> cached_val_in, cached_val_out;
+  std::vector<BitVector> cached_mem_in, cached_mem_out;
 
-  template<class M, class K, class V>
-  void mark(M& store, K& key, V& val) {
-    if( find(store[key], val) == store[key].end() )
-      store[key].emplace_back(val);
-  }
+  void reset_state();
+  void number_values(Function& f);
+  void compute_value_summaries(Function& f);
+  void collect_memory_accesses(Function& f);
+  void compute_memory_summaries(Function& f);
+  bool compute_block_insts(const BasicBlock* bb);
+  void append_live(const BitVector& val_bits, const BitVector& mem_bits,
+                   std::vector<Value*>* values,
+                   std::vector<MemoryLocation>* stack);
 
   void print_liveness_results(raw_ostream& os, Function& f);
 
-  /* Tracing the liveness of LLVM Values */
-  std::unordered_set<BasicBlock*> done;
-  void liveness_analysis(Function& f);
-  void liveness_analysis(Value* v);
-
-  void live_out_at_block(BasicBlock* bb, Value* v);
-  void live_out_at_statement(Instruction* inst, Value* v);
-  void live_in_at_statement(Instruction* inst, Value* v);
-
   /* Tracing memory values and their liveness */
   bool get_memory_inputs(Value* val,
                          std::vector<MemoryLocation>* input_mlocs,
@@ -95,41 +125,6 @@ private:
 
 
   bool ignore_function(CallBase* call);
-
-  /* Consumer -> producer backwards tracing */
-  void collect_memory_producers(MemoryAccess* acc, MemoryLocation mloc,
-                                std::vector<Value*>* prods);
-  void collect_memory_producers(MemoryDef* acc, MemoryLocation mloc,
-                                std::vector<Value*>* prods);
-  void collect_memory_producers(MemoryPhi* acc, MemoryLocation mloc,
-                                std::vector<Value*>* prods);
-  void memory_liveness_analysis_backward(Function& f);
-
-
-  /* Alloca -> potential writes / reads forward tracing */
-  void memory_liveness_analysis_forward(Function& f);
-
-  /* Capture memory uses */
-  struct memory_use_t {
-    Value*         producer;
-    Value*         consumer;
-    MemoryLocation loc;
-
-    memory_use_t(Value* p, Value* c, MemoryLocation l) : producer(p),
-                                                         consumer(c),
-                                                         loc(l) {}
-
-    static bool cmp(const memory_use_t& a, const memory_use_t& b) {
-      if( a.producer != b.producer )
-        return a.producer < b.producer;
-      if( a.loc.Ptr != b.loc.Ptr )
-        return a.loc.Ptr < b.loc.Ptr;
-      return a.consumer < b.consumer;
-    }
-  };
-
-  void find_producers_in_def(Instruction* inst, MemoryAccess* acc,
-         MemoryLocation mloc, std::vector<memory_use_t>* memory_uses);
 };
 
 struct liveness_analysis : public FunctionPass {
@@ -34,7 +34,8 @@
  *     accesses use a base packet and explicit offset in the reoquest
  *
  * Limitations:
- *   * no loop support
+ *   * loops may only carry packet pointers (see phase 2), not pointers
+ *     into map values
  *   * no support for "mixed mode" accesses where one load / store can
  *     access either map or packet depending on some condition
  *   * no support for select statements; as long as the pointer base is the
@@ -70,6 +71,22 @@
  *    inttoptr instructions away from the converted nanotube_packet_data
  *    origins, all the way into the nanotube_packet_read/writes.
  *
+ *    Loop-carried packet pointers are PHIs with an input on a back edge.
+ *    That input is not counted as a dependency of the PHI; instead, the
+ *    converted offset PHI receives the offset once the back edge value
+ *    has been converted further down the loop body.
+ *
+ *    Phase 3 turns updates of map values into single read-modify-write
+ *    map operations.  Atomic add / umin / umax on map values are
+ *    converted directly in phase 1, while a map read followed by an add /
+ *    min / max / saturating add of the loaded value and a map write of
+ *    the result to the same location (*v += x) is recognised afterwards.
+ *    That saves a tap round trip and avoids the hazard between the read
+ *    and the write.  Map taps apply these operations to the whole map
+ *    value and do not insert missing keys, so only accesses through a
+ *    map lookup pointer which cover the whole value are converted.
+ *    Other atomics are split into a map read and a map write.
+ *
  */
 
 #include "Mem2req.h"
@@ -80,10 +97,13 @@
 
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/GetElementPtrTypeIterator.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/PatternMatch.h"
 #include "llvm/IR/Value.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/Debug.h"
@@ -556,9 +576,11 @@ void flow_conversion::flow(Instruction* inst) {
           meta_new->dummy_read_ret = meta->dummy_read_ret;
         }
 
-        /* Key size has to be the same */
+        /* Key size and context have to be the same */
         assert(meta->key_sz == meta2->key_sz);
+        assert(meta->ctx == meta2->ctx);
         meta_new->key_sz = meta->key_sz;
+        meta_new->ctx    = meta->ctx;
       }
       LLVM_DEBUG(dbgs() << "  New meta: " << *meta_new << '\n'
                         << "Replacing with: " << *select_new <<'\n');
@@ -590,8 +612,16 @@ void flow_conversion::flow(Instruction* inst) {
 
       PHINode* phi_map = nullptr;
       PHINode* phi_key = nullptr;
-      /* Get the type (map vs packet) from the first parameter */
-      bool is_map    = val_to_meta[phi->getOperand(0)]->is_map;
+      /* Get the type (map vs packet) from the first converted parameter;
+       * inputs on loop back edges have not been converted, yet */
+      bool is_map = false;
+      for( auto& v : phi->incoming_values() ) {
+        auto it = val_to_meta.find(v);
+        if( it != val_to_meta.end() ) {
+          is_map = it->second->is_map;
+          break;
+        }
+      }
 
       if( is_map) {
         phi_map = ir.CreatePHI(get_nt_map_id_type(*phi->getModule()),
@@ -607,11 +637,26 @@ void flow_conversion::flow(Instruction* inst) {
       Value* base    = nullptr;
       Value* key     = nullptr;
 
+      bool first = true;
       for( unsigned i = 0; i < phi->getNumIncomingValues(); ++i ) {
-        auto *v  = cast<IntToPtrInst>(phi->getIncomingValue(i));
         auto *bb = phi->getIncomingBlock(i);
-        auto it  = val_to_meta.find(v);
-        assert(it != val_to_meta.end());
+        auto *v  = dyn_cast<IntToPtrInst>(phi->getIncomingValue(i));
+        auto it  = (v != nullptr) ? val_to_meta.find(v) : val_to_meta.end();
+        if( it == val_to_meta.end() ) {
+          /* Loop-carried pointer; patched up in replace_and_cleanup once
+           * the input has been converted */
+          if( is_map ) {
+            errs() << "ERROR: Phi node" << *phi << " carries a map pointer"
+                   << " around a loop.  This is not supported.\n";
+            exit(1);
+          }
+          LLVM_DEBUG(dbgs() << "  Input " << i << " is loop-carried: "
+                            << *phi->getIncomingValue(i) << '\n');
+          phi_offset->addIncoming(UndefValue::get(ir.getInt64Ty()), bb);
+          pending_back_edges.insert({phi->getIncomingValue(i),
+                                     {phi_offset, i}});
+          continue;
+        }
 
         /* We currently do not support mixed PHI nodes, i.e., where one
          * pointer comes from a packet, and another from a map */
@@ -633,21 +678,26 @@ void flow_conversion::flow(Instruction* inst) {
         phi_offset->addIncoming(v->getOperand(0), bb);
         input_i2ps.insert(v);
 
-        if( i == 0 )
+        if( first )
           base = it->second->base;
 
         if( it->second->base != base )
           base_same = false;
 
-        if( !is_map )
+        if( !is_map ) {
+          first = false;
           continue;
+        }
 
         /* More processing for map entries */
-        if( i == 0 ) {
+        if( first ) {
           key                  = it->second->key;
           meta->key_sz         = it->second->key_sz;
           meta->dummy_read_ret = it->second->dummy_read_ret;
+          meta->ctx            = it->second->ctx;
         }
+        first = false;
+        assert(it->second->ctx == meta->ctx);
 
         phi_map->addIncoming(it->second->base, bb);
         phi_key->addIncoming(it->second->key, bb);
@@ -702,6 +752,9 @@ void flow_conversion::flow(Instruction* inst) {
     case Instruction::Load:
       convert_mem(inst);
       break;
+    case Instruction::AtomicRMW:
+      convert_atomic(inst);
+      break;
     default:
       errs() << "Cannot convert unknown instruction " << *inst << '\n';
       assert(false);
@@ -749,6 +802,7 @@ void flow_conversion::convert_nanotube_root(CallInst* call) {
     auto* map_id = call->getOperand(1);
     auto* key    = call->getOperand(2);
     auto* key_sz = call->getOperand(3);
+    auto* val_sz = dyn_cast<ConstantInt>(call->getOperand(4));
 
     IRBuilder<> ir(call);
     IRBuilder<> ir_entry(call->getFunction()->getEntryBlock().getFirstNonPHI());
@@ -775,9 +829,16 @@ void flow_conversion::convert_nanotube_root(CallInst* call) {
 
     meta->is_map         = true;
     meta->base           = map_id;
+    meta->ctx            = ctx;
     meta->key            = key_copy;
     meta->key_sz         = key_sz;
     meta->dummy_read_ret = bytes_read;
+    meta->value_sz       = (val_sz != nullptr) ? val_sz->getZExtValue() : 0;
+
+    /* Accesses through the returned pointer only happen when the lookup
+     * found the key */
+    if( meta->value_sz != 0 )
+      lookups[key_copy] = meta->value_sz;
   }
 
   auto* i2p = new IntToPtrInst(replacement, call->getType(),
@@ -845,7 +906,7 @@ void flow_conversion::convert_mem(Instruction* inst) {
   /* Arguments: make sure to add key and key size for map access */
   std::vector<Value*> args;
   if( meta->is_map )
-    args.push_back(inst->getFunction()->arg_begin());
+    args.push_back(meta->ctx);
   args.push_back(meta->base);
   if( meta->is_map ) {
     args.push_back(meta->key);
@@ -881,6 +942,126 @@ void flow_conversion::convert_mem(Instruction* inst) {
     }
   }
 }
+/**
+ * Create a read-modify-write map operation before the IRBuilder's
+ * insertion point.  ctx is the context of the map access, data_in points
+ * to the operand, data_out may be null.
+ */
+static CallInst*
+create_map_rmw(IRBuilder<>* ir, Function* f, Value* ctx, Value* map,
+               Value* key, Value* key_sz, enum map_access_t op,
+               Value* data_in, Value* data_out, Value* offset,
+               unsigned size) {
+  auto* m = f->getParent();
+  IRBuilder<> ir_entry(f->getEntryBlock().getFirstNonPHI());
+  unsigned mask_sz = (size + 7) / 8;
+  auto* mask = ir_entry.CreateAlloca(ir->getInt8Ty(),
+                                     ir->getInt32(mask_sz), "rmw_mask");
+  ir->CreateMemSet(mask, ir->getInt8(0xff), mask_sz, 0);
+
+  auto* null_ptr = ConstantPointerNull::get(ir->getInt8PtrTy());
+  Value* args[] = { ctx, map, ir->getInt32(op), key, key_sz,
+                    ir->CreateBitCast(data_in, ir->getInt8PtrTy()),
+                    (data_out != nullptr) ?
+                      ir->CreateBitCast(data_out, ir->getInt8PtrTy()) :
+                      null_ptr,
+                    mask, offset, ir->getInt64(size) };
+  return ir->CreateCall(create_nt_map_op(*m), args);
+}
+
+void flow_conversion::convert_atomic(Instruction* inst) {
+  auto* rmw     = cast<AtomicRMWInst>(inst);
+  auto* ptr     = rmw->getPointerOperand();
+  auto* val     = rmw->getValOperand();
+  auto* i2p     = cast<IntToPtrInst>(ptr);
+  auto  it      = val_to_meta.find(i2p);
+  assert(it != val_to_meta.end());
+  auto* meta    = it->second;
+  auto* offset  = i2p->getOperand(0);
+
+  LLVM_DEBUG(dbgs() << "Converting atomic " << *inst << " with ptr: "
+                    << *ptr << '\n');
+
+  if( !meta->is_map ) {
+    errs() << "ERROR: Atomic access " << *inst << " to packet data is not "
+           << "supported.\nAborting!\n";
+    abort();
+  }
+
+  enum map_access_t op;
+  switch( rmw->getOperation() ) {
+    case AtomicRMWInst::Add:  op = NANOTUBE_MAP_ADD; break;
+    case AtomicRMWInst::UMin: op = NANOTUBE_MAP_MIN; break;
+    case AtomicRMWInst::UMax: op = NANOTUBE_MAP_MAX; break;
+    default:
+      errs() << "ERROR: Unsupported atomic operation " << *inst
+             << " on a map value.\nAborting!\n";
+      abort();
+  }
+
+  auto* ty      = val->getType();
+  unsigned size = m.getDataLayout().getTypeStoreSize(ty);
+  auto* f       = inst->getFunction();
+  IRBuilder<> ir(inst);
+  IRBuilder<> ir_entry(f->getEntryBlock().getFirstNonPHI());
+
+  /* Map taps apply the operation to the whole map value, starting at
+   * byte 0.  Other atomics become a map read and a map write of the
+   * updated value, which are converted like any other load / store. */
+  auto* const_offset = dyn_cast<ConstantInt>(offset);
+  if( (const_offset == nullptr) || !const_offset->isZero() ||
+      (size != meta->value_sz) ) {
+    LLVM_DEBUG(dbgs() << "Atomic does not cover the whole map value, "
+                      << "splitting it into a read and a write.\n");
+    auto* old = ir.CreateLoad(ptr, inst->getName() + "_old");
+    Value* res = nullptr;
+    switch( op ) {
+      case NANOTUBE_MAP_ADD:
+        res = ir.CreateAdd(old, val);
+        break;
+      case NANOTUBE_MAP_MIN:
+        res = ir.CreateSelect(ir.CreateICmpULT(old, val), old, val);
+        break;
+      case NANOTUBE_MAP_MAX:
+        res = ir.CreateSelect(ir.CreateICmpUGT(old, val), old, val);
+        break;
+      default:
+        assert(false);
+    }
+    auto* st = ir.CreateStore(res, ptr);
+    inst->replaceAllUsesWith(old);
+    inst->eraseFromParent();
+    convert_mem(old);
+    convert_mem(st);
+    return;
+  }
+
+  /* Pass the operand through memory, and read the old value back if the
+   * program uses it */
+  auto* data_in  = ir_entry.CreateAlloca(ty, nullptr,
+                                         inst->getName() + "_operand");
+  ir.CreateStore(val, data_in);
+  AllocaInst* data_out = nullptr;
+  if( !inst->use_empty() )
+    data_out = ir_entry.CreateAlloca(ty, nullptr, inst->getName() + "_old");
+
+  auto* call = create_map_rmw(&ir, f, meta->ctx, meta->base,
+                              meta->key, meta->key_sz, op, data_in,
+                              data_out, offset, size);
+  LLVM_DEBUG(dbgs() << *call << '\n');
+
+  if( data_out != nullptr ) {
+    auto* ld = ir.CreateLoad(data_out);
+    replace_and_cleanup(inst, ld, i2p);
+  } else {
+    inst->eraseFromParent();
+    if( i2p->use_empty() ) {
+      i2p->eraseFromParent();
+      val_to_meta.erase(it);
+    }
+  }
+}
+
 void flow_conversion::convert_special_case_call(CallInst* call) {
   switch( get_intrinsic(call) ) {
     case Intrinsics::llvm_memcpy:
@@ -956,7 +1137,7 @@ void flow_conversion::convert_call(CallInst* call) {
           LLVM_DEBUG(dbgs() << "map");
           /* Map read into the new variable */
           auto* map_rd  = create_nt_map_read(*call->getModule());
-          Value* args[] = { call->getFunction()->arg_begin(), meta->base,
+          Value* args[] = { meta->ctx, meta->base,
                             meta->key, meta->key_sz, alloca, offset, ai.size };
           rd_op         = ir.CreateCall(map_rd, args, arg->getName() + "_rd");
         } else {
@@ -994,7 +1175,7 @@ void flow_conversion::convert_call(CallInst* call) {
           /* Map write with new variable */
           LLVM_DEBUG(dbgs() << "map");
           auto* map_wr  = create_nt_map_write(*call->getModule());
-          Value* args[] = { call->getFunction()->arg_begin(), meta->base,
+          Value* args[] = { meta->ctx, meta->base,
                             meta->key, meta->key_sz, alloca, offset, ai.size };
           wr_op         = ir.CreateCall(map_wr, args, arg->getName() + "_wr");
         } else {
@@ -1108,7 +1289,7 @@ void flow_conversion::convert_memcpy(Instruction* inst) {
     /* Convert source to a map read */
     auto* offset  = cast<IntToPtrInst>(src)->getOperand(0);
     auto* map_rd  = create_nt_map_read(*inst->getModule());
-    Value* args[] = { inst->getFunction()->arg_begin(), src_meta->base,
+    Value* args[] = { src_meta->ctx, src_meta->base,
                       src_meta->key, src_meta->key_sz, mem, offset, size };
     auto* call    = ir.CreateCall(map_rd, args);
     LLVM_DEBUG(dbgs() << "Map read: " << *call << '\n');
@@ -1126,7 +1307,7 @@ void flow_conversion::convert_memcpy(Instruction* inst) {
     /* Convert destination to a map write */
     auto* offset  = cast<IntToPtrInst>(dst)->getOperand(0);
     auto* map_wr  = create_nt_map_write(*inst->getModule());
-    Value* args[] = { inst->getFunction()->arg_begin(), dst_meta->base,
+    Value* args[] = { dst_meta->ctx, dst_meta->base,
                       dst_meta->key, dst_meta->key_sz, mem, offset, size };
     auto* call    = ir.CreateCall(map_wr, args);
     LLVM_DEBUG(dbgs() << "Map write: " << *call << '\n');
@@ -1155,6 +1336,25 @@ void flow_conversion::replace_and_cleanup(Instruction* inst, Value* repl,
            << " (" << *inst->getType() << ")\nAborting!\n";
     abort();
   }
+
+  /* Hand the converted offset to PHIs waiting for it on a back edge */
+  auto range = pending_back_edges.equal_range(inst);
+  for( auto it = range.first; it != range.second; ++it ) {
+    auto* repl_i2p = dyn_cast<IntToPtrInst>(repl);
+    if( repl_i2p == nullptr ) {
+      errs() << "ERROR: Loop-carried pointer " << *inst
+             << " was not converted to an offset, but to " << *repl
+             << "\nAborting!\n";
+      abort();
+    }
+    LLVM_DEBUG(dbgs() << "  Back edge input " << it->second.second
+                      << " of " << *it->second.first << " is "
+                      << *repl_i2p->getOperand(0) << '\n');
+    it->second.first->setIncomingValue(it->second.second,
+                                       repl_i2p->getOperand(0));
+  }
+  pending_back_edges.erase(range.first, range.second);
+
   inst->replaceAllUsesWith(repl);
   inst->eraseFromParent();
   if( i2p != nullptr && i2p->use_empty() ) {
@@ -1214,6 +1414,7 @@ bool propagates_map_packet_ptr(Instruction* inst) {
     case Instruction::ICmp:
     case Instruction::Load:
     case Instruction::Store:
+    case Instruction::AtomicRMW:
       return false;
 
     /* We can either subtract a non-pointer and get a pointer, meaning map
@@ -1231,9 +1432,12 @@ bool propagates_map_packet_ptr(Instruction* inst) {
   return false;
 }
 
-/* Compute the number of map / packet inputs per instruction */
+/* Compute the number of map / packet inputs per instruction.  Inputs of
+ * PHIs on loop back edges are not counted, because they can only be
+ * converted after the PHI itself. */
 static
 void compute_map_packet_inputs(const std::vector<Instruction*>& roots,
+    const DominatorTree& dt,
     std::unordered_map<Instruction*, unsigned>* input_deps)
 {
   std::unordered_set<Instruction*> todo;
@@ -1252,15 +1456,22 @@ void compute_map_packet_inputs(const std::vector<Instruction*>& roots,
 
     /* Go through users of the map / packet pointer */
     LLVM_DEBUG(dbgs() << "Current: " << *inst <<'\n');
-    for( auto* user : inst->users() ) {
-      auto* ui = dyn_cast<Instruction>(user);
+    for( auto& use : inst->uses() ) {
+      auto* ui = dyn_cast<Instruction>(use.getUser());
       if( ui == nullptr ) {
-        LLVM_DEBUG(dbgs() << "Unexpected non-instruction user " << *ui << '\n');
+        LLVM_DEBUG(dbgs() << "Unexpected non-instruction user "
+                          << *use.getUser() << '\n');
         assert(ui);
       }
       LLVM_DEBUG(dbgs() << "  User: :" << *ui << '\n');
       /* Count the number of incident pointer flows to this instruction */
-      (*input_deps)[ui]++;
+      auto* phi = dyn_cast<PHINode>(ui);
+      if( phi != nullptr &&
+          dt.dominates(phi->getParent(), phi->getIncomingBlock(use)) ) {
+        LLVM_DEBUG(dbgs() << "    on a loop back edge\n");
+      } else {
+        (*input_deps)[ui]++;
+      }
 
       /* Continue if we have not already propagated this instruction */
       if( done.count(ui) == 0 )
@@ -1290,12 +1501,13 @@ raw_ostream& operator<<(raw_ostream& os, const nt_meta& meta) {
   return os;
 }
 
-bool mem_to_req::convert_to_req(Function& f) {
+bool mem_to_req::convert_to_req(Function& f, lookup_size_map* lookups) {
   flow_conversion fc(f);
 
   std::vector<Instruction*> roots;
   collect_roots(f, &roots);
-  compute_map_packet_inputs(roots, &fc.input_deps);
+  DominatorTree dt(f);
+  compute_map_packet_inputs(roots, dt, &fc.input_deps);
 
   /* Find those roots that are ready to convert */
   LLVM_DEBUG( dbgs() << "\nStarting flow conversion with ready roots:\n" );
@@ -1310,12 +1522,169 @@ bool mem_to_req::convert_to_req(Function& f) {
     [&](dep_aware_converter<Value>* dac, Value* v) {
       fc.flow(v);
     });
+  *lookups = std::move(fc.lookups);
+  return true;
+}
+/**
+ * Check that the only users of buffer (directly or through bitcasts) are
+ * a and b.
+ */
+static bool
+only_used_by(Value* buffer, Instruction* a, Instruction* b) {
+  for( auto* u : buffer->users() ) {
+    if( (u == a) || (u == b) )
+      continue;
+    if( !isa<BitCastInst>(u) || !only_used_by(u, a, b) )
+      return false;
+  }
   return true;
 }
+
+/**
+ * Match a map write that stores the result of a read-modify-write of the
+ * value returned by a map read of the same location:
+ *
+ *   map_read(ctx, map, key, key_sz, rd_buf, offset, size)
+ *   %v = load rd_buf
+ *   %r = add %v, %x     (or min / max / uadd.sat)
+ *   store %r, wr_buf
+ *   map_write(ctx, map, key, key_sz, wr_buf, offset, size)
+ *
+ * and convert it into a single map operation with operand %x.  The map
+ * read, the load and the write have to be in the same basic block with
+ * nothing writing memory in between, so that the key and the map value
+ * do not change.
+ *
+ * A map write inserts a missing key, but a read-modify-write does not, so
+ * only accesses through the pointer returned by a map lookup are
+ * converted; those only happen when the key is present.  The map taps
+ * also apply the operation from the start of the map value, so the
+ * access has to cover the whole value.
+ */
+static bool
+convert_one_map_rmw(CallInst* wr, const lookup_size_map& lookups) {
+  using namespace llvm::PatternMatch;
+
+  auto* wr_buf = dyn_cast<AllocaInst>(wr->getArgOperand(4)
+                                        ->stripPointerCasts());
+  auto* offset = dyn_cast<ConstantInt>(wr->getArgOperand(5));
+  auto* size   = dyn_cast<ConstantInt>(wr->getArgOperand(6));
+  auto* st     = dyn_cast_or_null<StoreInst>(wr->getPrevNode());
+  if( (wr_buf == nullptr) || (size == nullptr) || (st == nullptr) ||
+      (st->getPointerOperand()->stripPointerCasts() != wr_buf) ||
+      !only_used_by(wr_buf, st, wr) )
+    return false;
+
+  /* Present key, whole map value */
+  auto lookup = lookups.find(wr->getArgOperand(2));
+  if( (lookup == lookups.end()) || (offset == nullptr) ||
+      !offset->isZero() || (size->getZExtValue() != lookup->second) )
+    return false;
+
+  /* Identify the operation and the loaded map value */
+  auto* r = st->getValueOperand();
+  if( !r->hasOneUse() )
+    return false;
+  Value *a, *b;
+  enum map_access_t op;
+  if( match(r, m_Add(m_Value(a), m_Value(b))) )
+    op = NANOTUBE_MAP_ADD;
+  else if( match(r, m_Intrinsic<Intrinsic::uadd_sat>(m_Value(a),
+                                                     m_Value(b))) )
+    op = NANOTUBE_MAP_ADD_SAT;
+  else if( match(r, m_UMin(m_Value(a), m_Value(b))) )
+    op = NANOTUBE_MAP_MIN;
+  else if( match(r, m_UMax(m_Value(a), m_Value(b))) )
+    op = NANOTUBE_MAP_MAX;
+  else
+    return false;
+
+  auto* v = dyn_cast<LoadInst>(a);
+  Value* x = b;
+  if( (v == nullptr) || !isa<AllocaInst>(v->getPointerOperand()) ) {
+    v = dyn_cast<LoadInst>(b);
+    x = a;
+  }
+  if( (v == nullptr) || (v->getParent() != wr->getParent()) )
+    return false;
+  /* min / max select between the loaded value and the operand, so the
+   * loaded value may also feed the comparison */
+  for( auto* u : v->users() ) {
+    if( (u != r) && (!u->hasOneUse() || (*u->user_begin() != r)) )
+      return false;
+  }
+
+  /* Find the matching map read that fills the loaded buffer */
+  auto* rd_buf = dyn_cast<AllocaInst>(v->getPointerOperand());
+  CallInst* rd = nullptr;
+  for( auto* i = v->getPrevNode(); i != nullptr; i = i->getPrevNode() ) {
+    if( get_intrinsic(i) == Intrinsics::map_read ) {
+      rd = cast<CallInst>(i);
+      break;
+    }
+  }
+  if( (rd == nullptr) || !rd->use_empty() ||
+      (rd->getArgOperand(4)->stripPointerCasts() != rd_buf) ||
+      !only_used_by(rd_buf, rd, v) )
+    return false;
+
+  /* Same map entry and location */
+  for( unsigned arg : {0, 1, 2, 3, 5, 6} ) {
+    if( rd->getArgOperand(arg) != wr->getArgOperand(arg) )
+      return false;
+  }
+
+  /* Nothing may change the map or the key in between */
+  for( auto* i = rd->getNextNode(); i != wr; i = i->getNextNode() ) {
+    if( (i != st) && i->mayWriteToMemory() )
+      return false;
+  }
+
+  LLVM_DEBUG(dbgs() << "Converting read-modify-write\n" << *rd << '\n'
+                    << *v << '\n' << *r << '\n' << *st << '\n' << *wr
+                    << "\ninto a single map operation.\n");
+
+  /* Write the operand rather than the result and replace the write */
+  st->setOperand(0, x);
+  IRBuilder<> ir(wr);
+  auto* call = create_map_rmw(&ir, wr->getFunction(), wr->getArgOperand(0),
+                              wr->getArgOperand(1), wr->getArgOperand(2),
+                              wr->getArgOperand(3), op, wr->getArgOperand(4),
+                              nullptr, wr->getArgOperand(5),
+                              size->getZExtValue());
+  LLVM_DEBUG(dbgs() << "New map operation: " << *call << '\n');
+
+  wr->eraseFromParent();
+  cast<Instruction>(r)->eraseFromParent();
+  for( auto* u : make_early_inc_range(v->users()) )
+    cast<Instruction>(u)->eraseFromParent();
+  v->eraseFromParent();
+  rd->eraseFromParent();
+  return true;
+}
+
+bool mem_to_req::convert_map_rmw(Function& f,
+                                 const lookup_size_map& lookups) {
+  std::vector<CallInst*> writes;
+  for( auto& bb : f ) {
+    for( auto& inst : bb ) {
+      if( get_intrinsic(&inst) == Intrinsics::map_write )
+        writes.push_back(cast<CallInst>(&inst));
+    }
+  }
+
+  bool changes = false;
+  for( auto* wr : writes )
+    changes |= convert_one_map_rmw(wr, lookups);
+  return changes;
+}
+
 bool mem_to_req::runOnFunction(Function& f) {
   bool changes = false;
 
-  changes |= convert_to_req(f);
+  lookup_size_map lookups;
+  changes |= convert_to_req(f, &lookups);
+  changes |= convert_map_rmw(f, lookups);
   return changes;
 }
 
@@ -30,12 +30,16 @@ namespace {
   using llvm::IntToPtrInst;
   using llvm::LLVMContext;
   using llvm::Module;
+  using llvm::PHINode;
   using llvm::Twine;
   using llvm::Type;
   using llvm::Value;
 
   using nanotube::dep_aware_converter;
 
+  /* Size of the map value behind each key copied for a map lookup */
+  typedef std::unordered_map<Value*, uint64_t> lookup_size_map;
+
   struct mem_to_req : public llvm::FunctionPass {
 
     mem_to_req() : FunctionPass(ID) {}
@@ -43,14 +47,18 @@ namespace {
 
     static char ID;
 
-    static bool convert_to_req(Function& f);
+    static bool convert_to_req(Function& f, lookup_size_map* lookups);
+    static bool convert_map_rmw(Function& f,
+                                const lookup_size_map& lookups);
   }; // struct mem_to_req
 
   struct nt_meta {
     Value* base;      /* base package / map */
+    Value* ctx;       /* context of a map lookup; nullptr for packets */
     Value* key;       /* key for a map lookup; nullptr for packets */
     Value* key_sz;    /* size of the key as a value */
     Value* dummy_read_ret;  /* return value of the dummy map read */
+    uint64_t value_sz;      /* size of the map value; 0 if not known */
 
     bool   is_map;    /* true -> map; false -> packet */
     bool   is_start;
@@ -61,10 +69,16 @@ namespace {
   struct flow_conversion {
     meta_vec      meta_nodes;
     val_meta_map  val_to_meta;
+    lookup_size_map lookups;
     std::vector<Instruction*> deletion_candidates;
     std::unordered_map<Instruction*, unsigned> input_deps;
     dep_aware_converter<Value> dac;
 
+    /* Loop-carried inputs of converted PHIs which have not been
+     * converted yet: original value -> (offset PHI, incoming index) */
+    std::unordered_multimap<Value*, std::pair<PHINode*, unsigned>>
+      pending_back_edges;
+
     Module&       m;
     LLVMContext&  c;
     flow_conversion(Function& f);
@@ -77,6 +91,7 @@ namespace {
     void convert_special_case_call(CallInst* call);
 
     void convert_mem(Instruction* inst);
+    void convert_atomic(Instruction* inst);
     void convert_memcpy(Instruction* inst);
     void replace_and_cleanup(Instruction* inst, Value* repl,
                              IntToPtrInst* i2p);
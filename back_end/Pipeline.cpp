@@ -130,6 +130,90 @@
  *   - testing/kernel_tests/pipeline_maps*.cc
  *
  *
+ * LANES
+ *
+ * A single pipeline processes one packet word per cycle.  With
+ * -pipeline-lanes=N the setup function instantiates N copies of the
+ * stage chain, each with its own channels, contexts and static state:
+ *
+ *                  +-> lane 0: stage_0 -> ... -> stage_K --+
+ * packets_in -> dispatch                                  merge -> packets_out
+ *                  +-> lane 1: stage_0 -> ... -> stage_K --+
+ *
+ * The dispatch stage hashes the bytes at the offsets given by
+ * -pipeline-lane-hash-offsets (by default the IPv4 5-tuple, or the part
+ * of it which fits in a narrow bus word) in the first word of each
+ * packet and sends the whole packet to the selected lane.
+ * The merge stage forwards complete packets from the lanes in round-robin
+ * order.  All packets of a flow go through the same lane, so per-flow
+ * order is preserved, but packets of different flows may be reordered.
+ * Dropped packets do not leave a lane, so the merge stage does not wait
+ * for them.
+ *
+ * The lanes share the map taps.  Each lane adds its own clients to the
+ * map with nanotube_tap_map_add_client, so all accesses to a map are
+ * serialised by the map itself.
+ *
+ *
+ * OUTPUT PORTS
+ *
+ * By default all packets leave through the single exported packets_out
+ * channel.  With -pipeline-output-ports=N a final demux stage reads the
+ * destination port set by nanotube_packet_set_port from the bus header of
+ * each packet and forwards the packet to packets_out_port<port % N>:
+ *
+ *                                        +-> packets_out_port0
+ * ... -> stage_K -> packets_out -> demux +-> ...
+ *                                        +-> packets_out_port<N-1>
+ *
+ * Each of those channels is exported, so traffic for different ports
+ * does not share the bandwidth of a single output channel.
+ *
+ * EARLY DROP
+ *
+ * The drop decision of the kernel is applied by the last stage, so by
+ * default all the words of a dropped packet travel through the whole
+ * pipeline.  With -pipeline-early-drop, the stages which already know the
+ * drop value discard the words of dropped packets and only forward the
+ * EOP word, so that the later stages still see the end of the packet.
+ * The drop value is part of the live application state, so it acts as a
+ * drop token for the later stages.  Stages which inspect the packet need
+ * all of its words, so early drop starts at the last of those stages if
+ * it follows the computation of the drop value.  Each early-drop stage
+ * calls nanotube_debug_packet_dropped for every packet it discards, so
+ * the test harness can report the drops per stage.
+ *
+ * MAP PREFETCH
+ *
+ * A map request is sent by the stage just before the one that receives
+ * the response, even if the key was complete much earlier.  With
+ * -pipeline-map-prefetch, each map request moves to the earliest stage in
+ * which its arguments are available and the memory it reads is not
+ * written any more.  The response still arrives in the original stage,
+ * so the map latency overlaps with the stages in between.  A request does
+ * not move past another map request, which keeps one request per stage
+ * and the requests in program order, nor past the response of an earlier
+ * access to the same map.
+ *
+ * After the converge pass, the type of a map operation is often a choice
+ * between a read and a no-op.  If that choice is only made after the
+ * stage the request moves to, the request is sent as a read
+ * speculatively.  The receiving stage cancels the response if the
+ * original type was not a read: it does not copy out the data and
+ * reports a miss.  Note that an early read sees the map state from
+ * earlier in the pipeline, so writes of the packets in between are not
+ * visible.
+ *
+ * BOUNDED LOOPS
+ *
+ * The packet kernel must be loop-free.  Bounded loops which do not
+ * access packets or maps can be moved into a separate function by the
+ * outline-loops pass; the call is copied into a stage like any other
+ * application code.  The loop-feedback pass then runs after this pass
+ * and turns the stage into an iterative stage which executes one loop
+ * iteration per invocation and recirculates the loop state through a
+ * feedback channel of its own context.
+ *
  * NOTES / LIMITATIONS / TODO ITEMS
  *
  * - allow multiple packet operations in the same pipeline stage (e.g.,
@@ -142,7 +226,11 @@
 #include "nanotube_map_taps.h"
 #include "nanotube_packet_taps.h"
 #include "nanotube_packet_taps_bus.h"
+#include "softhub_bus.hpp"
+#include "utils.h"
 
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Analysis/AliasSetTracker.h"
 #include "llvm/Analysis/OrderedInstructions.h"
 #include "llvm/Analysis/ValueTracking.h"
@@ -175,6 +263,27 @@ void Pipeline::getAnalysisUsage(AnalysisUsage &info) const {
 static llvm::cl::opt<bool> pipeline_stats("pipeline-stats",
     llvm::cl::desc("Print statistics for the pipeline pass"),
     llvm::cl::Hidden, llvm::cl::init(false));
+static llvm::cl::opt<unsigned> pipeline_lanes("pipeline-lanes",
+    llvm::cl::desc("Number of parallel copies (lanes) of the pipeline"),
+    llvm::cl::init(1));
+static llvm::cl::opt<unsigned> pipeline_output_ports(
+    "pipeline-output-ports",
+    llvm::cl::desc("Number of exported packet output channels, one per"
+                   " destination port"),
+    llvm::cl::init(1));
+static llvm::cl::list<unsigned> pipeline_lane_hash_offsets(
+    "pipeline-lane-hash-offsets",
+    llvm::cl::desc("Packet byte offsets of the flow key which selects the"
+                   " lane of a packet"),
+    llvm::cl::CommaSeparated);
+static llvm::cl::opt<bool> pipeline_early_drop("pipeline-early-drop",
+    llvm::cl::desc("Discard the words of dropped packets in the first stage"
+                   " which knows that the packet will be dropped"),
+    llvm::cl::init(false));
+static llvm::cl::opt<bool> pipeline_map_prefetch("pipeline-map-prefetch",
+    llvm::cl::desc("Send each map request in the earliest stage in which"
+                   " its key is available"),
+    llvm::cl::init(false));
 
 static
 StructType* get_live_state_type(LLVMContext& c,
@@ -199,6 +308,7 @@ bool is_split_point(Instruction* inst) {
          (i == Intrinsics::packet_resize_ingress) ||
          (i == Intrinsics::packet_resize_egress) ||
          (i == Intrinsics::packet_bounded_length) ||
+         (i == Intrinsics::packet_csum) ||
          (i == Intrinsics::map_op_receive) ||
          (i == Intrinsics::packet_drop) ||
          isa<ReturnInst>(inst);
@@ -414,6 +524,8 @@ stage_function_t::stage_function_t() : func(nullptr),
                                        map_op_rcv(nullptr),
                                        map_rcv_buf_size(nullptr),
                                        drop_val(nullptr),
+                                       early_drop(false),
+                                       early_drop_live_in(false),
                                        nt_id(Intrinsics::none) {
 }
 
@@ -1620,6 +1732,7 @@ create_get_static(have_map_resp,    Type::getInt1Ty(c));
 create_get_static(map_resp_data,    get_map_resp_data_ty());
 create_get_static(map_result,       Type::getInt32Ty(c));
 create_get_static(word_is_eop,      Type::getInt1Ty(c));
+create_get_static(packet_dropped,   Type::getInt1Ty(c));
 
 create_get_static(packet_read_tap_state,
                   get_nt_tap_packet_read_state_ty(*m));
@@ -1627,6 +1740,8 @@ create_get_static(packet_write_tap_state,
                   get_nt_tap_packet_write_state_ty(*m));
 create_get_static(packet_length_tap_state,
                   get_nt_tap_packet_length_state_ty(*m));
+create_get_static(packet_csum_tap_state,
+                  get_nt_tap_packet_csum_state_ty(*m));
 create_get_static(packet_resize_ingress_tap_state,
                   get_nt_tap_packet_resize_ingress_state_ty(*m));
 create_get_static(packet_resize_egress_tap_state,
@@ -2200,6 +2315,7 @@ void stage_function_t::scan_nanotube_accesses(setup_func* setup) {
         case Intrinsics::packet_write_masked:
         case Intrinsics::packet_resize_ingress:
         case Intrinsics::packet_bounded_length:
+        case Intrinsics::packet_csum:
         case Intrinsics::packet_resize_egress:
           set_nt_call(call, intr);
           break;
@@ -2565,6 +2681,102 @@ void stage_function_t::convert_packet_length(Value* packet_word, BasicBlock* byp
   nt_call->eraseFromParent();
 }
 
+void stage_function_t::convert_packet_csum(Value* packet_word, BasicBlock* bypass_bb) {
+  auto* m = func->getParent();
+
+  assert(nt_call != nullptr);
+  assert(nt_id   == Intrinsics::packet_csum);
+  packet_csum_args pca(nt_call);
+
+  /**
+   * This follows the same pattern as the packet length tap:
+   *
+   * (pre-call app logic)
+   * res = nanotube_packet_csum(packet, offset, length, seed);
+   * (post-call app logic)
+   *
+   * becomes
+   *
+   * (pre-call app logic)
+   * (prepare csum req structure)
+   * nanotube_tap_packet_csum(&resp, &state, packet_word, req)
+   * valid = load resp.valid
+   * br valid, app_code, bypass_bb
+   * app_code:
+   *   res = load resp.result_sum;
+   *   (post-call app logic)
+   *   ...
+   * bypass_bb:
+   *   ...
+   *   ret
+   */
+
+  /* Split the basic block just after the packet_csum to split off the
+   * post-call app logic */
+  auto* pre_call_bb  = nt_call->getParent();
+  auto* post_call_bb = split_app_bb(pre_call_bb, nt_call,
+                         pre_call_bb->getName() + ".post");
+  pre_call_bb->setName(post_call_bb->getName() + ".pre");
+  pre_call_bb->getTerminator()->eraseFromParent();
+
+  IRBuilder<> ir(pre_call_bb);
+
+  /* put together the required state */
+  auto* resp_ty          = get_nt_tap_packet_csum_resp_ty(*m);
+  auto* resp             = ir.CreateAlloca(resp_ty , 0, "resp");
+  auto* tap_state        = get_static_packet_csum_tap_state();
+  auto* req_ty           = get_nt_tap_packet_csum_req_ty(*m);
+  auto* req              = ir.CreateAlloca(req_ty, 0, "req");
+
+  /* fill the request structure with arguments from the original call */
+  auto* req_valid  = ir.CreateStructGEP(req_ty, req, 0, "req.valid.p");
+  auto* req_offset = ir.CreateStructGEP(req_ty, req, 1, "req.csum_offset.p");
+  auto* req_length = ir.CreateStructGEP(req_ty, req, 2, "req.csum_length.p");
+  auto* req_seed   = ir.CreateStructGEP(req_ty, req, 3, "req.seed.p");
+  ir.CreateStore(ir.getInt8(1), req_valid);
+  ir.CreateStore(ir.CreateZExtOrTrunc(pca.offset,
+                                      req_ty->getElementType(1)),
+                 req_offset);
+  ir.CreateStore(ir.CreateZExtOrTrunc(pca.length,
+                                      req_ty->getElementType(2)),
+                 req_length);
+  ir.CreateStore(ir.CreateZExtOrTrunc(pca.seed,
+                                      req_ty->getElementType(3)),
+                 req_seed);
+
+  /* Actually call the tap */
+  auto* tap     = create_tap_packet_csum(*m, get_bus_type());
+  auto* tap_ty  = get_tap_packet_csum_ty(*m);
+  Value* args[] = { resp, tap_state, packet_word, req };
+  ir.CreateCall(tap_ty, tap, args);
+
+  /* Parse the response */
+  auto* resp_valid = ir.CreateStructGEP(resp_ty, resp, 0, "resp.valid.p");
+  auto* valid_i8   = ir.CreateLoad(ir.getInt8Ty(), resp_valid, "resp.valid.i8");
+  auto* valid      = ir.CreateTrunc(valid_i8, ir.getInt1Ty(), "resp.valid");
+  ir.CreateCondBr(valid, post_call_bb, bypass_bb);
+
+  LLVM_DEBUG(dbgs() << "Pre-call BB: " << *pre_call_bb << '\n');
+
+  /* Patch up the post-call logic */
+  ir.SetInsertPoint(nt_call);
+  auto lov_it = live_out_val.end();
+  if( value_used(nt_call, &lov_it) ) {
+    auto* resp_sum_p = ir.CreateStructGEP(resp_ty, resp, 2, "resp.result_sum.p");
+    Value* res_sum   = ir.CreateLoad(resp_ty->getElementType(2), resp_sum_p,
+                                     "resp.result_sum");
+    if( res_sum->getType() != nt_call->getType() )
+      res_sum = ir.CreateZExtOrTrunc(res_sum, nt_call->getType());
+    nt_call->replaceAllUsesWith(res_sum);
+
+    /* And also adjust this in the live-out state */
+    if( lov_it != live_out_val.end() )
+      *lov_it = res_sum;
+  }
+  LLVM_DEBUG(dbgs() << "Call BB: " << *nt_call->getParent() << '\n');
+  nt_call->eraseFromParent();
+}
+
 void stage_function_t::convert_packet_resize_ingress(Value* packet_word) {
   auto* m = func->getParent();
 
@@ -3175,7 +3387,9 @@ Pipeline::create_stage_epilogue(stage_function_t* stage, Value* packet_word,
     LLVM_DEBUG(dbgs() << "No live out state, not creating marshal basic block\n");
   }
 
-  if( !stage->is_packet_drop() ) {
+  if( stage->early_drop ) {
+    create_early_drop(stage, packet_word, exit_bb, out_app_entry);
+  } else if( !stage->is_packet_drop() ) {
     /* Normal stages will always write the packet word */
     stage->write_packet_word(packet_word, exit_bb->getTerminator());
   } else {
@@ -3226,6 +3440,93 @@ Pipeline::create_stage_epilogue(stage_function_t* stage, Value* packet_word,
   }
 }
 
+/**
+ * Generate the packet word write of an early-drop stage, see
+ * -pipeline-early-drop.  Once the stage knows that the packet will be
+ * dropped, it discards the packet words instead of writing them.  The
+ * EOP word is still written, so that the later stages see the end of the
+ * packet and reset their per-packet state.  The drop value itself
+ * travels to the later stages with the live application state, so it
+ * acts as the drop token.
+ *
+ * If the drop value is computed in this stage, the application logic
+ * records the decision in a static:
+ *
+ * app_early_drop:
+ *   %drop = icmp ne %drop_val, 0
+ *   store %drop, @packet_dropped
+ *   br <old app epilogue entry>
+ *
+ * exit_bb:
+ *   %dropped = load @packet_dropped    ; or icmp ne %drop_val, 0 if
+ *                                      ; the drop value is live-in
+ *   %discard = and %dropped, !%word_is_eop
+ *   store %discard, @packet_dropped
+ *   br %discard, exit_bb_post, pw_write_bb
+ *
+ * pw_write_bb:
+ *   <write packet word>
+ *   br %dropped, drop_count_bb, exit_bb_post
+ *
+ * drop_count_bb:
+ *   call nanotube_debug_packet_dropped()
+ *   br exit_bb_post
+ *
+ * exit_bb_post:
+ *   exit_term
+ */
+void
+Pipeline::create_early_drop(stage_function_t* stage, Value* packet_word,
+                            BasicBlock* exit_bb,
+                            BasicBlock** out_app_entry) {
+  auto* m = stage->func->getParent();
+  auto& c = m->getContext();
+  auto* drop_val = stage->drop_val;
+  assert(drop_val != nullptr);
+  auto* zero = Constant::getNullValue(drop_val->getType());
+
+  if( !stage->early_drop_live_in ) {
+    auto* drop_bb = BasicBlock::Create(c, stage->stage_name +
+                                       "_app_early_drop", stage->func,
+                                       *out_app_entry);
+    IRBuilder<> ir(drop_bb);
+    auto* drop = ir.CreateICmpNE(drop_val, zero, "drop");
+    ir.CreateStore(drop, stage->get_static_packet_dropped());
+    ir.CreateBr(*out_app_entry);
+    *out_app_entry = drop_bb;
+  }
+
+  auto* exit_bb_post = exit_bb->splitBasicBlock(exit_bb->getTerminator(),
+                         exit_bb->getName() + "_post");
+  auto* pw_write_bb  = BasicBlock::Create(c, "cond_packet_word_write",
+                                          stage->func, exit_bb_post);
+  auto* count_bb     = BasicBlock::Create(c, "drop_count", stage->func,
+                                          exit_bb_post);
+  exit_bb->getTerminator()->eraseFromParent();
+
+  IRBuilder<> ir(exit_bb);
+  Value* dropped;
+  if( stage->early_drop_live_in ) {
+    dropped = ir.CreateICmpNE(drop_val, zero, "dropped");
+  } else {
+    dropped = ir.CreateLoad(ir.getInt1Ty(),
+                            stage->get_static_packet_dropped(), "dropped");
+  }
+  auto* not_eop = ir.CreateNot(stage->word_is_eop, "not_eop");
+  auto* discard = ir.CreateAnd(dropped, not_eop, "discard");
+  if( !stage->early_drop_live_in )
+    ir.CreateStore(discard, stage->get_static_packet_dropped());
+  ir.CreateCondBr(discard, exit_bb_post, pw_write_bb);
+
+  ir.SetInsertPoint(pw_write_bb);
+  auto* br = ir.CreateCondBr(dropped, count_bb, exit_bb_post);
+  stage->write_packet_word(packet_word, br);
+
+  ir.SetInsertPoint(count_bb);
+  ir.CreateCall(create_nt_debug_packet_dropped(*m));
+  ir.CreateBr(exit_bb_post);
+}
+
 void
 Pipeline::convert_to_taps(stage_function_t* stage) {
   /**
@@ -3273,6 +3574,10 @@ Pipeline::convert_to_taps(stage_function_t* stage) {
     LLVM_DEBUG(dbgs() << "Packet length: " << *stage->nt_call << '\n');
     stage->convert_packet_length(packet_word_in, app_bypass);
     converted = true;
+  } else if( stage->is_packet_csum() ) {
+    LLVM_DEBUG(dbgs() << "Packet checksum: " << *stage->nt_call << '\n');
+    stage->convert_packet_csum(packet_word_in, app_bypass);
+    converted = true;
   } else if( stage->is_resize_ingress() ) {
     LLVM_DEBUG(dbgs() << "Packet resize (ingress): " << *stage->nt_call << '\n');
     stage->convert_packet_resize_ingress(packet_word_in);
@@ -3482,6 +3787,379 @@ tap_map_add_client(Value* map, Value* key_sz, Value* data_in_sz,
   return call;
 }
 
+/********** Multi-lane pipelines **********/
+
+/* The default flow key is the IPv4 5-tuple of an untagged Ethernet frame
+ * without IP options: protocol, source and destination address and the
+ * source and destination ports. */
+static const unsigned default_lane_hash_offsets[] = {
+  23, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37,
+};
+
+static unsigned get_pipeline_lanes() {
+  unsigned lanes = pipeline_lanes.getValue();
+  if( lanes == 0 )
+    report_fatal_errorv("The number of pipeline lanes must be at least 1.");
+  return lanes;
+}
+
+/**
+ * Create a copy of a stage function for a lane.  The copy gets its own
+ * static state and uses its own client IDs for the maps it accesses.
+ * The mapping of values from the original to the copy is added to vmap.
+ */
+static Function*
+clone_stage_for_lane(stage_function_t* stage, unsigned lane,
+                     ValueToValueMapTy& vmap) {
+  auto* m = stage->func->getParent();
+
+  /* Duplicate the static state of the stage */
+  for( auto& name_gv : stage->static_vars ) {
+    auto* gv  = name_gv.second;
+    auto* ngv = new GlobalVariable(*m, gv->getValueType(),
+                                   gv->isConstant(), gv->getLinkage(),
+                                   gv->getInitializer(),
+                                   gv->getName() + "_lane" + Twine(lane));
+    vmap[gv] = ngv;
+  }
+
+  auto* f = CloneFunction(stage->func, vmap);
+  f->setName(stage->func->getName() + "_lane" + Twine(lane));
+
+  /* Each lane adds its own clients to the shared maps.  The clients of
+   * lane N follow those of lanes 0 .. N-1. */
+  auto* send_f = create_nt_tap_map_send_req(*m)->stripPointerCasts();
+  auto* recv_f = create_nt_tap_map_recv_resp(*m)->stripPointerCasts();
+  for( auto& id_val : stage->map_id_to_val ) {
+    auto id = id_val.first;
+    unsigned clients = stage_function_t::map_to_rcvs[id].size();
+    for( auto* user : id_val.second->users() ) {
+      auto* call = dyn_cast<CallInst>(user);
+      if( call == nullptr )
+        continue;
+      auto* callee = call->getCalledFunction();
+      if( callee != send_f && callee != recv_f )
+        continue;
+      auto* ncall = cast<CallInst>(vmap[call]);
+      auto* cid   = cast<ConstantInt>(ncall->getArgOperand(2));
+      ncall->setArgOperand(2,
+        ConstantInt::get(cid->getType(),
+                         cid->getZExtValue() + lane * clients));
+    }
+  }
+  LLVM_DEBUG(dbgs() << "Created lane " << lane << " copy " << f->getName()
+                    << " of stage " << stage->stage_name << '\n');
+  return f;
+}
+
+static GlobalVariable*
+create_lane_static(Module& m, Type* ty, const Twine& name) {
+  return new GlobalVariable(m, ty, false, GlobalValue::PrivateLinkage,
+                            Constant::getNullValue(ty), name);
+}
+
+static Value*
+lane_channel_try_read(Value* ctx, unsigned channel_id, Value* data,
+                      size_t size, IRBuilder<>& ir, Module& m) {
+  Value* args[4];
+  args[0] = ctx;
+  args[1] = ir.getInt32(channel_id);
+  args[2] = ir.CreateBitCast(data, ir.getInt8PtrTy());
+  args[3] = ir.getInt64(size);
+  auto* f  = create_nt_channel_try_read(m);
+  auto* ty = cast<FunctionType>(cast<PointerType>(f->getType())->getElementType());
+  auto* res = ir.CreateCall(ty, f, args, "read_channel");
+  return ir.CreateICmpEQ(res, ConstantInt::get(res->getType(), 0),
+                         "try_fail");
+}
+
+static void
+lane_channel_write(Value* ctx, unsigned channel_id, Value* data,
+                   size_t size, IRBuilder<>& ir, Module& m) {
+  Value* args[4];
+  args[0] = ctx;
+  args[1] = ir.getInt32(channel_id);
+  args[2] = ir.CreateBitCast(data, ir.getInt8PtrTy());
+  args[3] = ir.getInt64(size);
+  auto* f  = create_nt_channel_write(m);
+  auto* ty = cast<FunctionType>(cast<PointerType>(f->getType())->getElementType());
+  ir.CreateCall(ty, f, args);
+}
+
+static BasicBlock*
+lane_thread_wait_exit(Function* f) {
+  auto* m = f->getParent();
+  auto* bb = BasicBlock::Create(m->getContext(), "thread_wait_exit", f);
+  IRBuilder<> ir(bb);
+  auto* thread_wait_f = create_nt_thread_wait(*m);
+  auto* ty = cast<FunctionType>(cast<PointerType>(thread_wait_f->getType())->getElementType());
+  ir.CreateCall(ty, thread_wait_f);
+  ir.CreateRetVoid();
+  return bb;
+}
+
+static Value*
+lane_word_is_eop(Value* word, Value* eop_state, IRBuilder<>& ir,
+                 Module& m) {
+  auto* eop_ty = get_tap_packet_is_eop_ty(m);
+  auto* eop_f  = create_tap_packet_is_eop(m, get_bus_type());
+  Value* args[] = { ir.CreateBitCast(word, ir.getInt8PtrTy()), eop_state };
+  return ir.CreateCall(eop_ty, eop_f, args, "eop");
+}
+
+/**
+ * Create a stage which reads packet words from channel 0 and writes each
+ * packet to channel 1 + out, where out is computed by the select
+ * callback from the first word of the packet.  The callback emits code
+ * which returns a value less than outputs.
+ *
+ * read_packet_word:
+ *   %fail = !nanotube_channel_try_read(ctx, 0, @word, size)
+ *   br %fail, thread_wait_exit, check_sop
+ * check_sop:
+ *   br @in_packet, write_packet_word, select_output
+ * select_output:
+ *   @out = select(@word)
+ * write_packet_word:
+ *   switch @out -> nanotube_channel_write(ctx, 1 + @out, @word, size)
+ *   @in_packet = !eop(@word)
+ */
+static Function*
+create_word_dispatch(Module& m, const Twine& func_name, StringRef suffix,
+                     unsigned outputs,
+                     function_ref<Value*(IRBuilder<>&, Value*)> select) {
+  auto& c = m.getContext();
+  auto* f = Function::Create(get_nt_thread_func_ty(m),
+                             Function::ExternalLinkage, func_name, &m);
+  Value* ctx = f->arg_begin();
+
+  auto  size    = get_bus_word_size();
+  auto* word_ty = ArrayType::get(Type::getInt8Ty(c), size);
+  auto* word      = create_lane_static(m, word_ty,
+                                       "packet_word_" + suffix);
+  auto* in_packet = create_lane_static(m, Type::getInt1Ty(c),
+                                       "in_packet_" + suffix);
+  auto* cur_out   = create_lane_static(m, Type::getInt32Ty(c),
+                                       "output_" + suffix);
+  auto* eop_state = create_lane_static(m, get_nt_tap_packet_eop_state_ty(m),
+                                       "packet_eop_tap_state_" + suffix);
+
+  auto* read_bb   = BasicBlock::Create(c, "read_packet_word", f);
+  auto* wait_bb   = lane_thread_wait_exit(f);
+  auto* sop_bb    = BasicBlock::Create(c, "check_sop", f);
+  auto* select_bb = BasicBlock::Create(c, "select_output", f);
+  auto* write_bb  = BasicBlock::Create(c, "write_packet_word", f);
+  auto* eop_bb    = BasicBlock::Create(c, "check_eop", f);
+
+  IRBuilder<> ir(read_bb);
+  auto* fail = lane_channel_try_read(ctx, 0, word, size, ir, m);
+  ir.CreateCondBr(fail, wait_bb, sop_bb);
+
+  ir.SetInsertPoint(sop_bb);
+  auto* in_pkt = ir.CreateLoad(in_packet, "in_packet");
+  ir.CreateCondBr(in_pkt, write_bb, select_bb);
+
+  ir.SetInsertPoint(select_bb);
+  ir.CreateStore(select(ir, word), cur_out);
+  ir.CreateBr(write_bb);
+
+  ir.SetInsertPoint(write_bb);
+  auto* out = ir.CreateLoad(cur_out, "output");
+  std::vector<BasicBlock*> out_bbs;
+  for( unsigned o = 0; o < outputs; o++ )
+    out_bbs.push_back(BasicBlock::Create(c, "write_output" + Twine(o), f,
+                                         eop_bb));
+  auto* sw = ir.CreateSwitch(out, out_bbs[0], outputs);
+  for( unsigned o = 0; o < outputs; o++ ) {
+    sw->addCase(ir.getInt32(o), out_bbs[o]);
+    ir.SetInsertPoint(out_bbs[o]);
+    lane_channel_write(ctx, 1 + o, word, size, ir, m);
+    ir.CreateBr(eop_bb);
+  }
+
+  ir.SetInsertPoint(eop_bb);
+  auto* eop = lane_word_is_eop(word, eop_state, ir, m);
+  ir.CreateStore(ir.CreateNot(eop, "in_packet"), in_packet);
+  ir.CreateRetVoid();
+
+  LLVM_DEBUG(dbgs() << "Created " << suffix << " stage:\n" << *f << '\n');
+  return f;
+}
+
+/**
+ * Create the dispatch stage of a multi-lane pipeline.  The lane of a
+ * packet is selected by a FNV-1a hash of the flow key in the first word.
+ */
+static Function*
+create_lane_dispatch(Module& m, const Twine& base_name, unsigned lanes) {
+  auto& c = m.getContext();
+  auto* word_ty = ArrayType::get(Type::getInt8Ty(c), get_bus_word_size());
+
+  /* Check the flow key offsets.  Each offset selects one byte, which
+   * has to end within the data of the first bus word.  The default key
+   * is cut down to the bytes in the first word on narrow buses. */
+  auto md_size = get_bus_md_size();
+  auto data_bytes = get_bus_data_bytes();
+  std::vector<unsigned> offsets(pipeline_lane_hash_offsets.begin(),
+                                pipeline_lane_hash_offsets.end());
+  if( offsets.empty() ) {
+    for( auto off : default_lane_hash_offsets ) {
+      if( md_size + off + 1 > data_bytes )
+        break;
+      offsets.push_back(off);
+    }
+  }
+  for( auto off : offsets ) {
+    if( md_size + off + 1 > data_bytes )
+      report_fatal_errorv("Lane hash offset {0} is not in the first bus"
+                          " word of a packet.", off);
+  }
+
+  auto select_lane = [&](IRBuilder<>& ir, Value* word) -> Value* {
+    Value* hash = ir.getInt32(2166136261u);
+    for( auto off : offsets ) {
+      auto* ptr  = ir.CreateConstInBoundsGEP2_32(word_ty, word, 0,
+                                                 md_size + off);
+      auto* byte = ir.CreateZExt(ir.CreateLoad(ptr), ir.getInt32Ty());
+      hash = ir.CreateMul(ir.CreateXor(hash, byte), ir.getInt32(16777619u));
+    }
+    return ir.CreateURem(hash, ir.getInt32(lanes), "lane");
+  };
+  return create_word_dispatch(m, base_name + "_lane_dispatch",
+                              "lane_dispatch", lanes, select_lane);
+}
+
+/********** Per-port output channels **********/
+
+static unsigned get_pipeline_output_ports() {
+  unsigned ports = pipeline_output_ports.getValue();
+  if( ports == 0 )
+    report_fatal_errorv("The number of pipeline output ports must be at"
+                        " least 1.");
+  return ports;
+}
+
+/**
+ * Create the port demultiplexing stage.  It reads the destination port
+ * from the bus header in the first word of each packet and sends the
+ * packet to output port % ports.
+ */
+static Function*
+create_port_demux(Module& m, const Twine& base_name, unsigned ports) {
+  auto& c = m.getContext();
+  auto* word_ty = ArrayType::get(Type::getInt8Ty(c), get_bus_word_size());
+
+  auto select_port = [&](IRBuilder<>& ir, Value* word) -> Value* {
+    auto load_byte = [&](unsigned idx) {
+      auto* ptr = ir.CreateConstInBoundsGEP2_32(word_ty, word, 0, idx);
+      return ir.CreateZExt(ir.CreateLoad(ptr), ir.getInt32Ty());
+    };
+
+    Value* port;
+    if( get_bus_type() == NANOTUBE_BUS_ID_SHB ) {
+      /* The port is the route field of the capsule header. */
+      Value* hdr = load_byte(0);
+      hdr = ir.CreateOr(hdr, ir.CreateShl(load_byte(1), 8));
+      hdr = ir.CreateOr(hdr, ir.CreateShl(load_byte(2), 16));
+      port = ir.CreateLShr(hdr, softhub_bus::CH_ROUTE_OFFSET);
+      port = ir.CreateAnd(port, ir.getInt32(0xffff));
+    } else {
+      /* The other buses carry the port in the first header byte. */
+      port = load_byte(0);
+    }
+    return ir.CreateURem(port, ir.getInt32(ports), "port");
+  };
+  return create_word_dispatch(m, base_name + "_port_demux", "port_demux",
+                              ports, select_port);
+}
+
+/**
+ * Create the merge stage of a multi-lane pipeline.  It reads packet
+ * words from channels 0 .. lanes-1 and writes them to channel lanes.
+ * Once the first word of a packet has been read from a lane, the rest of
+ * the packet is read from the same lane.  Between packets the lanes are
+ * polled in round-robin order, waiting only after a complete round
+ * without any words.
+ */
+static Function*
+create_lane_merge(Module& m, const Twine& base_name, unsigned lanes) {
+  auto& c = m.getContext();
+  auto* f = Function::Create(get_nt_thread_func_ty(m),
+                             Function::ExternalLinkage,
+                             base_name + "_lane_merge", &m);
+  Value* ctx = f->arg_begin();
+
+  auto  size    = get_bus_word_size();
+  auto* word_ty = ArrayType::get(Type::getInt8Ty(c), size);
+  auto* word      = create_lane_static(m, word_ty,
+                                       "packet_word_lane_merge");
+  auto* in_packet = create_lane_static(m, Type::getInt1Ty(c),
+                                       "in_packet_lane_merge");
+  auto* cur_lane  = create_lane_static(m, Type::getInt32Ty(c),
+                                       "lane_lane_merge");
+  auto* idle      = create_lane_static(m, Type::getInt32Ty(c),
+                                       "idle_lane_merge");
+  auto* eop_state = create_lane_static(m, get_nt_tap_packet_eop_state_ty(m),
+                                       "packet_eop_tap_state_lane_merge");
+
+  auto* read_bb = BasicBlock::Create(c, "read_packet_word", f);
+  auto* wait_bb = lane_thread_wait_exit(f);
+  auto* miss_bb = BasicBlock::Create(c, "no_packet_word", f);
+  auto* next_bb = BasicBlock::Create(c, "next_lane", f);
+  auto* got_bb  = BasicBlock::Create(c, "write_packet_word", f);
+  auto* exit_bb = BasicBlock::Create(c, "stage_exit", f);
+
+  IRBuilder<> ir(read_bb);
+  auto* lane = ir.CreateLoad(cur_lane, "lane");
+  auto* lane_inc  = ir.CreateAdd(lane, ir.getInt32(1));
+  auto* lane_wrap = ir.CreateICmpEQ(lane_inc, ir.getInt32(lanes));
+  auto* next_lane = ir.CreateSelect(lane_wrap, ir.getInt32(0), lane_inc,
+                                    "next_lane");
+  std::vector<BasicBlock*> lane_bbs;
+  for( unsigned l = 0; l < lanes; l++ )
+    lane_bbs.push_back(BasicBlock::Create(c, "read_lane" + Twine(l), f,
+                                          miss_bb));
+  auto* sw = ir.CreateSwitch(lane, lane_bbs[0], lanes);
+  for( unsigned l = 0; l < lanes; l++ ) {
+    sw->addCase(ir.getInt32(l), lane_bbs[l]);
+    ir.SetInsertPoint(lane_bbs[l]);
+    auto* fail = lane_channel_try_read(ctx, l, word, size, ir, m);
+    ir.CreateCondBr(fail, miss_bb, got_bb);
+  }
+
+  /* Nothing to read.  Wait for the rest of a packet on the current lane,
+   * otherwise move on to the next lane. */
+  ir.SetInsertPoint(miss_bb);
+  auto* in_pkt = ir.CreateLoad(in_packet, "in_packet");
+  ir.CreateCondBr(in_pkt, wait_bb, next_bb);
+
+  ir.SetInsertPoint(next_bb);
+  ir.CreateStore(next_lane, cur_lane);
+  auto* idle_inc   = ir.CreateAdd(ir.CreateLoad(idle, "idle"),
+                                  ir.getInt32(1));
+  auto* idle_round = ir.CreateICmpUGE(idle_inc, ir.getInt32(lanes),
+                                      "idle_round");
+  ir.CreateStore(ir.CreateSelect(idle_round, ir.getInt32(0), idle_inc),
+                 idle);
+  ir.CreateCondBr(idle_round, wait_bb, exit_bb);
+
+  /* Forward the word and move on to the next lane at the end of the
+   * packet. */
+  ir.SetInsertPoint(got_bb);
+  ir.CreateStore(ir.getInt32(0), idle);
+  auto* eop = lane_word_is_eop(word, eop_state, ir, m);
+  ir.CreateStore(ir.CreateNot(eop, "in_packet"), in_packet);
+  ir.CreateStore(ir.CreateSelect(eop, next_lane, lane), cur_lane);
+  lane_channel_write(ctx, lanes, word, size, ir, m);
+  ir.CreateBr(exit_bb);
+
+  ir.SetInsertPoint(exit_bb);
+  ir.CreateRetVoid();
+
+  LLVM_DEBUG(dbgs() << "Created lane merge stage:\n" << *f << '\n');
+  return f;
+}
+
 /**
  * Update the nanotube_setup function and create threads for every pipeline
  * stage and fifos to connect them.
@@ -3499,40 +4177,98 @@ void Pipeline::extend_nanotube_setup(const Pipeline::stages_t& stages,
   auto* add_plain_kernel = ki.creator();
   IRBuilder<> ir(add_plain_kernel);
 
+  /**
+   * Copies of the stage functions for each lane.  Lane 0 uses the
+   * original stage functions, the other lanes use clones with their own
+   * static state.  lane_vmaps[l] maps the values of lane 0 to those of
+   * lane l.
+   */
+  unsigned lanes = get_pipeline_lanes();
+  std::vector<std::vector<Function*>> lane_funcs(lanes);
+  std::vector<std::unique_ptr<ValueToValueMapTy>> lane_vmaps(lanes);
+  for( unsigned l = 0; l < lanes; l++ ) {
+    lane_vmaps[l].reset(new ValueToValueMapTy());
+    for( auto* stage : stages ) {
+      if( l == 0 )
+        lane_funcs[l].push_back(stage->func);
+      else
+        lane_funcs[l].push_back(clone_stage_for_lane(stage, l,
+                                                     *lane_vmaps[l]));
+    }
+  }
+  auto lane_value = [&](unsigned l, Value* v) -> Value* {
+    return (l == 0) ? v : (Value*)(*lane_vmaps[l])[v];
+  };
+  auto lane_prefix = [&](unsigned l) -> std::string {
+    return (lanes == 1) ? "" : "lane" + std::to_string(l) + "_";
+  };
+
   /**
    * Channel for packet words:
    * packets_in -> stage_0 -> packets_0_to_1 -> ...
    *                                  ...  -> stage N -> packets_out
+   *
+   * With multiple lanes, each lane gets its own chain and the dispatch
+   * and merge stages connect them to packets_in and packets_out:
+   * packets_in -> dispatch -> laneL_packets_in -> stage_0 -> ...
+   *                   ... -> stage N -> laneL_packets_out -> merge
+   *                                                 merge -> packets_out
    */
   auto  bus_word_size = get_bus_word_size();
   auto  sideband_size = get_bus_sb_size();
   auto  sideband_signals = get_bus_sb_signals_size();
   static const size_t packet_fifo_depth = 140; // 9000 / 64
 
-  std::vector<Value*> packet_chs(stages.size() + 1);
-  for( unsigned n = 0; n <= stages.size(); n++ ) {
-    std::string ch_name;
-    Value* ch;
-    if( n == 0 ) {
-      /* The test framework uses the name of the packet input channel as
-       * the test name, so copy that off the old registration */
-      auto* kernel_name = add_plain_kernel->getArgOperand(0);
-      ch = channel_create(kernel_name, bus_word_size, packet_fifo_depth,
-                          ir, *m, "packet_in");
-    } else {
-      if( n == stages.size() )
-        ch_name = "packets_out";
-      else
-        ch_name = "packets_" + std::to_string(n - 1) + "_to_" +
-                   std::to_string(n);
-      ch = channel_create(ch_name, bus_word_size, packet_fifo_depth,
-                          ir, *m);
-    }
+  auto set_packet_ch_attrs = [&](Value* ch) {
     if (sideband_size != 0)
       channel_set_attr(ch, NANOTUBE_CHANNEL_ATTR_SIDEBAND_BYTES, sideband_size, ir, *m);
     if (sideband_signals != 0)
       channel_set_attr(ch, NANOTUBE_CHANNEL_ATTR_SIDEBAND_SIGNALS, sideband_signals, ir, *m);
-    packet_chs[n] = ch;
+  };
+
+  /* The test framework uses the name of the packet input channel as the
+   * test name, so copy that off the old registration */
+  auto* kernel_name = add_plain_kernel->getArgOperand(0);
+  Value* packets_in  = nullptr;
+  Value* packets_out = nullptr;
+  if( lanes > 1 ) {
+    packets_in = channel_create(kernel_name, bus_word_size,
+                                packet_fifo_depth, ir, *m, "packet_in");
+    set_packet_ch_attrs(packets_in);
+  }
+
+  std::vector<std::vector<Value*>> packet_chs(lanes);
+  for( unsigned l = 0; l < lanes; l++ ) {
+    packet_chs[l].resize(stages.size() + 1);
+    for( unsigned n = 0; n <= stages.size(); n++ ) {
+      std::string ch_name;
+      Value* ch;
+      if( n == 0 && lanes == 1 ) {
+        ch = channel_create(kernel_name, bus_word_size, packet_fifo_depth,
+                            ir, *m, "packet_in");
+      } else {
+        if( n == 0 )
+          ch_name = "packets_in";
+        else if( n == stages.size() )
+          ch_name = "packets_out";
+        else
+          ch_name = "packets_" + std::to_string(n - 1) + "_to_" +
+                     std::to_string(n);
+        ch = channel_create(lane_prefix(l) + ch_name, bus_word_size,
+                            packet_fifo_depth, ir, *m);
+      }
+      set_packet_ch_attrs(ch);
+      packet_chs[l][n] = ch;
+    }
+  }
+
+  if( lanes == 1 ) {
+    packets_in  = packet_chs[0][0];
+    packets_out = packet_chs[0][stages.size()];
+  } else {
+    packets_out = channel_create("packets_out", bus_word_size,
+                                 packet_fifo_depth, ir, *m);
+    set_packet_ch_attrs(packets_out);
   }
 
   nanotube_channel_type_t channel_type;
@@ -3542,11 +4278,27 @@ void Pipeline::extend_nanotube_setup(const Pipeline::stages_t& stages,
     default:                   channel_type = NANOTUBE_CHANNEL_TYPE_SIMPLE_PACKET;
   }
 
+  /* With several output ports, packets_out feeds the port demux stage
+   * and each port gets its own exported channel. */
+  unsigned ports = get_pipeline_output_ports();
+  std::vector<Value*> port_chs;
+  for( unsigned p = 0; ports > 1 && p < ports; p++ ) {
+    auto* ch = channel_create("packets_out_port" + std::to_string(p),
+                              bus_word_size, packet_fifo_depth, ir, *m);
+    set_packet_ch_attrs(ch);
+    port_chs.push_back(ch);
+  }
+
   /* Export the overall packet in / out channels */
-  channel_export(packet_chs[0], channel_type,
+  channel_export(packets_in, channel_type,
                  NANOTUBE_CHANNEL_WRITE, ir, *m);
-  channel_export(packet_chs[stages.size()], channel_type,
-                 NANOTUBE_CHANNEL_READ, ir, *m);
+  if( ports == 1 ) {
+    channel_export(packets_out, channel_type,
+                   NANOTUBE_CHANNEL_READ, ir, *m);
+  } else {
+    for( auto* ch : port_chs )
+      channel_export(ch, channel_type, NANOTUBE_CHANNEL_READ, ir, *m);
+  }
 
   /**
    * Channels for application state (where needed and of the right type):
@@ -3554,22 +4306,26 @@ void Pipeline::extend_nanotube_setup(const Pipeline::stages_t& stages,
    * stage_K -> state_K_to_K+1 -> stage_K+1
    * ...
    */
-  std::vector<Value*> app_state_chs(stages.size() - 1);
-  for( unsigned n = 0; n < stages.size() - 1; n++ ) {
-    auto* stout = stages[n];
-    if( !stout->has_live_out() )
-      continue;
-    auto* stin = stages[n + 1];
-    assert(stin->has_live_in());
-
-    std::string ch_name;
-    ch_name = "state_" + std::to_string(n) + "_to_" +
-               std::to_string(n + 1);
-    assert(stout->get_live_out_ty() == stin->get_live_in_ty());
-    size_t live_size = dl.getTypeStoreSize(stout->get_live_out_ty());
-    static const size_t live_fifo_depth = 10;
-    auto* ch = channel_create(ch_name, live_size, live_fifo_depth, ir, *m);
-    app_state_chs[n] = ch;
+  std::vector<std::vector<Value*>> app_state_chs(lanes);
+  for( unsigned l = 0; l < lanes; l++ ) {
+    app_state_chs[l].resize(stages.size() - 1);
+    for( unsigned n = 0; n < stages.size() - 1; n++ ) {
+      auto* stout = stages[n];
+      if( !stout->has_live_out() )
+        continue;
+      auto* stin = stages[n + 1];
+      assert(stin->has_live_in());
+
+      std::string ch_name;
+      ch_name = "state_" + std::to_string(n) + "_to_" +
+                 std::to_string(n + 1);
+      assert(stout->get_live_out_ty() == stin->get_live_in_ty());
+      size_t live_size = dl.getTypeStoreSize(stout->get_live_out_ty());
+      static const size_t live_fifo_depth = 10;
+      auto* ch = channel_create(lane_prefix(l) + ch_name, live_size,
+                                live_fifo_depth, ir, *m);
+      app_state_chs[l][n] = ch;
+    }
   }
 
   /**
@@ -3578,21 +4334,25 @@ void Pipeline::extend_nanotube_setup(const Pipeline::stages_t& stages,
    * stage_K -> cword_K_to_K+1 -> stage_K+1
    * ...
    */
-  std::vector<Value*> cword_chs(stages.size() - 1);
-  for( unsigned n = 0; n < stages.size() - 1; n++ ) {
-    auto* stout = stages[n];
-    if( !stout->is_resize_ingress() )
-      continue;
-    auto* stin = stages[n + 1];
-    assert(stin->is_resize_egress());
-
-    std::string ch_name;
-    ch_name = "cword" + std::to_string(n) + "_to_" +
-               std::to_string(n + 1);
-    size_t live_size = dl.getTypeStoreSize(get_nt_tap_packet_resize_cword_ty(*m));
-    static const size_t cword_fifo_depth = 140;
-    auto* ch = channel_create(ch_name, live_size, cword_fifo_depth, ir, *m);
-    cword_chs[n] = ch;
+  std::vector<std::vector<Value*>> cword_chs(lanes);
+  for( unsigned l = 0; l < lanes; l++ ) {
+    cword_chs[l].resize(stages.size() - 1);
+    for( unsigned n = 0; n < stages.size() - 1; n++ ) {
+      auto* stout = stages[n];
+      if( !stout->is_resize_ingress() )
+        continue;
+      auto* stin = stages[n + 1];
+      assert(stin->is_resize_egress());
+
+      std::string ch_name;
+      ch_name = "cword" + std::to_string(n) + "_to_" +
+                 std::to_string(n + 1);
+      size_t live_size = dl.getTypeStoreSize(get_nt_tap_packet_resize_cword_ty(*m));
+      static const size_t cword_fifo_depth = 140;
+      auto* ch = channel_create(lane_prefix(l) + ch_name, live_size,
+                                cword_fifo_depth, ir, *m);
+      cword_chs[l][n] = ch;
+    }
   }
 
   /* Create contexts, and connect them to the right channels.  Also
@@ -3605,54 +4365,58 @@ void Pipeline::extend_nanotube_setup(const Pipeline::stages_t& stages,
   static const int CWORD_OUT   = stage_function_t::CWORD_OUT;
   static const int MAP_REQ     = stage_function_t::MAP_REQ;
   static const int MAP_RESP    = stage_function_t::MAP_RESP;
-  std::vector<Value*> contexts;
-  for( unsigned i = 0; i < stages.size(); i++ ) {
-    auto* ctx = context_create(i, ir, *m);
-    contexts.push_back(ctx);
-
-    /* Packet daisy chain */
-    auto* pin = packet_chs[i];
-    auto* pout = packet_chs[i + 1];
-    context_add_channel(ctx, PACKETS_IN,  pin,  NANOTUBE_CHANNEL_READ, ir, *m);
-    context_add_channel(ctx, PACKETS_OUT, pout, NANOTUBE_CHANNEL_WRITE, ir, *m);
-
-    /* Live State: has_live_out (producer) => has_live_in (consumer) */
-    if( stages[i]->has_live_out() ) {
-      assert(i < app_state_chs.size());
-      context_add_channel(ctx, STATE_OUT, app_state_chs[i],
-                          NANOTUBE_CHANNEL_WRITE, ir, *m);
-    }
-    if( stages[i]->has_live_in() ) {
-      assert(i > 0);
-      context_add_channel(ctx, STATE_IN, app_state_chs[i - 1],
-                          NANOTUBE_CHANNEL_READ, ir, *m);
-    }
+  std::vector<std::vector<Value*>> contexts(lanes);
+  for( unsigned l = 0; l < lanes; l++ ) {
+    for( unsigned i = 0; i < stages.size(); i++ ) {
+      auto* ctx = context_create(l * stages.size() + i, ir, *m);
+      contexts[l].push_back(ctx);
+
+      /* Packet daisy chain */
+      auto* pin = packet_chs[l][i];
+      auto* pout = packet_chs[l][i + 1];
+      context_add_channel(ctx, PACKETS_IN,  pin,  NANOTUBE_CHANNEL_READ, ir, *m);
+      context_add_channel(ctx, PACKETS_OUT, pout, NANOTUBE_CHANNEL_WRITE, ir, *m);
+
+      /* Live State: has_live_out (producer) => has_live_in (consumer) */
+      if( stages[i]->has_live_out() ) {
+        assert(i < app_state_chs[l].size());
+        context_add_channel(ctx, STATE_OUT, app_state_chs[l][i],
+                            NANOTUBE_CHANNEL_WRITE, ir, *m);
+      }
+      if( stages[i]->has_live_in() ) {
+        assert(i > 0);
+        context_add_channel(ctx, STATE_IN, app_state_chs[l][i - 1],
+                            NANOTUBE_CHANNEL_READ, ir, *m);
+      }
 
-    /* Resize Cword: resize_ingress (producer) => resize_egress (consumer) */
-    if( stages[i]->is_resize_ingress() ) {
-      assert(i < app_state_chs.size());
-      context_add_channel(ctx, CWORD_OUT, cword_chs[i],
-                          NANOTUBE_CHANNEL_WRITE, ir, *m);
-    }
-    if( stages[i]->is_resize_egress() ) {
-      assert(i > 0);
-      context_add_channel(ctx, CWORD_IN, cword_chs[i - 1],
-                          NANOTUBE_CHANNEL_READ, ir, *m);
-    }
+      /* Resize Cword: resize_ingress (producer) => resize_egress (consumer) */
+      if( stages[i]->is_resize_ingress() ) {
+        assert(i < app_state_chs[l].size());
+        context_add_channel(ctx, CWORD_OUT, cword_chs[l][i],
+                            NANOTUBE_CHANNEL_WRITE, ir, *m);
+      }
+      if( stages[i]->is_resize_egress() ) {
+        assert(i > 0);
+        context_add_channel(ctx, CWORD_IN, cword_chs[l][i - 1],
+                            NANOTUBE_CHANNEL_READ, ir, *m);
+      }
 
-    /* Initialise per-stage static state */
-    if( stages[i]->is_resize_ingress() ) {
-      auto* init_ty = get_tap_packet_resize_ingress_state_init_ty(*m);
-      auto* init_f  = create_tap_packet_resize_ingress_state_init(*m);
-      Value* args[] = {
-        stages[i]->get_static_packet_resize_ingress_tap_state() };
-      ir.CreateCall(init_ty, init_f, args);
-    } else if( stages[i]->is_resize_egress() ) {
-      auto* init_ty = get_tap_packet_resize_egress_state_init_ty(*m);
-      auto* init_f  = create_tap_packet_resize_egress_state_init(*m);
-      Value* args[] = {
-        stages[i]->get_static_packet_resize_egress_tap_state() };
-      ir.CreateCall(init_ty, init_f, args);
+      /* Initialise per-stage static state */
+      if( stages[i]->is_resize_ingress() ) {
+        auto* init_ty = get_tap_packet_resize_ingress_state_init_ty(*m);
+        auto* init_f  = create_tap_packet_resize_ingress_state_init(*m);
+        Value* args[] = {
+          lane_value(l,
+            stages[i]->get_static_packet_resize_ingress_tap_state()) };
+        ir.CreateCall(init_ty, init_f, args);
+      } else if( stages[i]->is_resize_egress() ) {
+        auto* init_ty = get_tap_packet_resize_egress_state_init_ty(*m);
+        auto* init_f  = create_tap_packet_resize_egress_state_init(*m);
+        Value* args[] = {
+          lane_value(l,
+            stages[i]->get_static_packet_resize_egress_tap_state()) };
+        ir.CreateCall(init_ty, init_f, args);
+      }
     }
   }
 
@@ -3676,6 +4440,7 @@ void Pipeline::extend_nanotube_setup(const Pipeline::stages_t& stages,
       /* Create map with nanotube_tap_map_create */
       const unsigned map_size = 10; //XXX: Fixme
 
+      /* Each lane has its own set of clients */
       auto  num_clients   = stage_function_t::map_to_rcvs[id].size();
       if( num_clients == 0 ) {
         errs() << "WARNING: Defined but unused map found!\n"
@@ -3690,7 +4455,7 @@ void Pipeline::extend_nanotube_setup(const Pipeline::stages_t& stages,
       auto* key_sz = ir.CreateZExtOrTrunc(mca.key_sz, map_width_ty);
       auto* value_sz = ir.CreateZExtOrTrunc(mca.value_sz, map_width_ty);
       auto* map = tap_map_create(mca.type, key_sz, value_sz, map_size,
-                                 num_clients, id, ir, *m);
+                                 num_clients * lanes, id, ir, *m);
 
       /* Remember this map for threads to find */
       auto* gep = ir.CreateConstInBoundsGEP2_32(maparr_ty, maparr, 0, idx,
@@ -3701,18 +4466,20 @@ void Pipeline::extend_nanotube_setup(const Pipeline::stages_t& stages,
       auto& reqs = stage_function_t::map_to_reqs[id];
       auto& rcvs = stage_function_t::map_to_rcvs[id];
 
-      for( unsigned cid = 0; cid < num_clients; cid++ ) {
-        auto *req_stage = reqs[cid];
-        auto *rcv_stage = rcvs[cid];
-        Value *req_buf_sz = req_stage->map_req_buf_size;
-        Value *rcv_buf_sz = rcv_stage->map_rcv_buf_size;
-        req_buf_sz = ir.CreateZExtOrTrunc(req_buf_sz, map_width_ty);
-        rcv_buf_sz = ir.CreateZExtOrTrunc(rcv_buf_sz, map_width_ty);
-        tap_map_add_client(map, key_sz, req_buf_sz,
-                           true, rcv_buf_sz,
-                           contexts[req_stage->idx], MAP_REQ,
-                           contexts[rcv_stage->idx], MAP_RESP,
-                           cid, id, ir, *m);
+      for( unsigned l = 0; l < lanes; l++ ) {
+        for( unsigned cid = 0; cid < num_clients; cid++ ) {
+          auto *req_stage = reqs[cid];
+          auto *rcv_stage = rcvs[cid];
+          Value *req_buf_sz = req_stage->map_req_buf_size;
+          Value *rcv_buf_sz = rcv_stage->map_rcv_buf_size;
+          req_buf_sz = ir.CreateZExtOrTrunc(req_buf_sz, map_width_ty);
+          rcv_buf_sz = ir.CreateZExtOrTrunc(rcv_buf_sz, map_width_ty);
+          tap_map_add_client(map, key_sz, req_buf_sz,
+                             true, rcv_buf_sz,
+                             contexts[l][req_stage->idx], MAP_REQ,
+                             contexts[l][rcv_stage->idx], MAP_RESP,
+                             l * num_clients + cid, id, ir, *m);
+        }
       }
 
       /* Build the map */
@@ -3721,11 +4488,54 @@ void Pipeline::extend_nanotube_setup(const Pipeline::stages_t& stages,
   }
 
   /* Bind contexts to thread functions */
-  for( unsigned i = 0; i < stages.size(); i++ ) {
-    /* Thread per stage */
-    auto* ctx = contexts[i];
-    thread_create(ctx, stages[i]->stage_name, stages[i]->func, maparr, maparr_size,
+  for( unsigned l = 0; l < lanes; l++ ) {
+    for( unsigned i = 0; i < stages.size(); i++ ) {
+      /* Thread per stage */
+      auto* ctx = contexts[l][i];
+      std::string name = stages[i]->stage_name;
+      if( l > 0 )
+        name += "_lane" + std::to_string(l);
+      thread_create(ctx, name, lane_funcs[l][i], maparr, maparr_size,
+                    ir, *m);
+    }
+  }
+
+  /* Connect the lanes to the overall packet in / out channels */
+  if( lanes > 1 ) {
+    auto  base_name = kia.kernel->getName();
+    auto* dispatch_f = create_lane_dispatch(*m, base_name, lanes);
+    auto* merge_f    = create_lane_merge(*m, base_name, lanes);
+
+    auto* dispatch_ctx = context_create(lanes * stages.size(), ir, *m);
+    context_add_channel(dispatch_ctx, 0, packets_in,
+                        NANOTUBE_CHANNEL_READ, ir, *m);
+    for( unsigned l = 0; l < lanes; l++ )
+      context_add_channel(dispatch_ctx, 1 + l, packet_chs[l][0],
+                          NANOTUBE_CHANNEL_WRITE, ir, *m);
+
+    auto* merge_ctx = context_create(lanes * stages.size() + 1, ir, *m);
+    for( unsigned l = 0; l < lanes; l++ )
+      context_add_channel(merge_ctx, l, packet_chs[l][stages.size()],
+                          NANOTUBE_CHANNEL_READ, ir, *m);
+    context_add_channel(merge_ctx, lanes, packets_out,
+                        NANOTUBE_CHANNEL_WRITE, ir, *m);
+
+    thread_create(dispatch_ctx, "lane_dispatch", dispatch_f, nullptr, 0,
                   ir, *m);
+    thread_create(merge_ctx, "lane_merge", merge_f, nullptr, 0, ir, *m);
+  }
+
+  /* Demultiplex the packets to the per-port output channels */
+  if( ports > 1 ) {
+    auto* demux_f = create_port_demux(*m, kia.kernel->getName(), ports);
+    unsigned ctx_id = lanes * stages.size() + (lanes > 1 ? 2 : 0);
+    auto* demux_ctx = context_create(ctx_id, ir, *m);
+    context_add_channel(demux_ctx, 0, packets_out,
+                        NANOTUBE_CHANNEL_READ, ir, *m);
+    for( unsigned p = 0; p < ports; p++ )
+      context_add_channel(demux_ctx, 1 + p, port_chs[p],
+                          NANOTUBE_CHANNEL_WRITE, ir, *m);
+    thread_create(demux_ctx, "port_demux", demux_f, nullptr, 0, ir, *m);
   }
 
   /* Remove old calls to the high-level nanotube_map_create */
@@ -3971,6 +4781,7 @@ bool check_api_call_usage(Function& f) {
 
     switch( get_intrinsic(&inst) ) {
       case Intrinsics::packet_bounded_length:
+      case Intrinsics::packet_csum:
       case Intrinsics::packet_read:
       case Intrinsics::packet_write:
         /* These all have perfect translations */
@@ -4007,6 +4818,390 @@ bool check_api_call_usage(Function& f) {
   return false;
 }
 
+/********** Map prefetch **********/
+
+/**
+ * Checks whether the type of a map operation is always either a read or a
+ * no-op.  The converge pass creates such types from the dummy accesses on
+ * the paths which do not access the map.  Operations of that type can be
+ * issued as a read speculatively.
+ */
+static bool
+is_read_or_nop(Value* type) {
+  SmallVector<Value*, 8> todo = {type};
+  SmallPtrSet<Value*, 8> seen;
+  while( !todo.empty() ) {
+    auto* v = todo.pop_back_val();
+    if( !seen.insert(v).second || isa<UndefValue>(v) )
+      continue;
+
+    auto* c = dyn_cast<ConstantInt>(v);
+    if( c != nullptr ) {
+      auto t = c->getZExtValue();
+      if( (t != NANOTUBE_MAP_READ) && (t != NANOTUBE_MAP_NOP) )
+        return false;
+      continue;
+    }
+    auto* phi = dyn_cast<PHINode>(v);
+    if( phi != nullptr ) {
+      for( auto& in : phi->incoming_values() )
+        todo.push_back(in);
+      continue;
+    }
+    auto* sel = dyn_cast<SelectInst>(v);
+    if( sel != nullptr ) {
+      todo.push_back(sel->getTrueValue());
+      todo.push_back(sel->getFalseValue());
+      continue;
+    }
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Look through a PHI node which merges a single value with undef.  For a
+ * speculative read, the null / zero arguments of the dummy accesses are
+ * ignored, too, because the result of those accesses is cancelled.
+ */
+static Value*
+resolve_map_arg(Value* v, bool speculate) {
+  auto* phi = dyn_cast<PHINode>(v);
+  if( phi == nullptr )
+    return v;
+
+  Value* res = nullptr;
+  for( auto& in : phi->incoming_values() ) {
+    auto* c = dyn_cast<Constant>(in);
+    if( isa<UndefValue>(in) || (speculate && (c != nullptr) &&
+                                c->isNullValue()) )
+      continue;
+    if( (res != nullptr) && (res != in) )
+      return v;
+    res = in;
+  }
+  return (res != nullptr) ? res : v;
+}
+
+/**
+ * Collect the instructions on the paths from start (inclusive) to end
+ * (exclusive).
+ */
+static void
+get_insts_between(Instruction* start, Instruction* end,
+                  std::vector<Instruction*>* insts) {
+  auto* from = start->getParent();
+  auto* to   = end->getParent();
+
+  /* Blocks reachable from the start which reach the end */
+  SmallPtrSet<BasicBlock*, 16> fwd;
+  SmallVector<BasicBlock*, 16> todo = {from};
+  while( !todo.empty() ) {
+    auto* bb = todo.pop_back_val();
+    if( !fwd.insert(bb).second || (bb == to) )
+      continue;
+    for( auto* succ : successors(bb) )
+      todo.push_back(succ);
+  }
+  SmallPtrSet<BasicBlock*, 16> bwd;
+  todo.push_back(to);
+  while( !todo.empty() ) {
+    auto* bb = todo.pop_back_val();
+    if( !bwd.insert(bb).second || (bb == from) )
+      continue;
+    for( auto* pred : predecessors(bb) )
+      todo.push_back(pred);
+  }
+
+  for( auto* bb : fwd ) {
+    if( bwd.count(bb) == 0 )
+      continue;
+    auto it = (bb == from) ? start->getIterator() : bb->begin();
+    for( ; it != bb->end(); ++it ) {
+      if( &*it == end )
+        break;
+      insts->push_back(&*it);
+    }
+  }
+}
+
+/**
+ * Checks whether a map request can be issued in the pipeline stage ending
+ * at split point.  The request must not pass another map request (each
+ * stage sends at most one and the requests must stay in order), nor the
+ * response of an earlier access to the same map on any path to the
+ * request.  The memory read by the request must not be written on the
+ * way.
+ */
+static bool
+can_prefetch_at(CallInst* send, Instruction* split,
+                ArrayRef<MemoryLocation> mlocs, AliasAnalysis* aa) {
+  map_op_send_args moa(send);
+
+  /* A request which has been moved sits just before its split point, so
+   * the stage ending at split may already send one */
+  auto* prev = split->getPrevNode();
+  if( (prev != nullptr) &&
+      (get_intrinsic(prev) == Intrinsics::map_op_send) )
+    return false;
+
+  std::vector<Instruction*> insts;
+  get_insts_between(split, send, &insts);
+  for( auto* inst : insts ) {
+    auto intrinsic = get_intrinsic(inst);
+    if( intrinsic == Intrinsics::map_op_send )
+      return false;
+    if( intrinsic == Intrinsics::map_op_receive ) {
+      map_op_receive_args mra(inst);
+      if( mra.map == moa.map )
+        return false;
+    }
+    if( !inst->mayWriteToMemory() )
+      continue;
+    for( auto& mloc : mlocs ) {
+      if( isModSet(aa->getModRefInfo(inst, mloc)) ) {
+        LLVM_DEBUG(dbgs() << "  " << *inst << " writes "
+                          << *mloc.Ptr << '\n');
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Returns the memory location of a map request argument with the given
+ * length.
+ */
+static MemoryLocation
+get_map_arg_loc(Value* ptr, Value* len) {
+  auto* len_c = dyn_cast<ConstantInt>(len);
+  if( len_c != nullptr )
+    return MemoryLocation(ptr, len_c->getZExtValue());
+  return MemoryLocation(ptr);
+}
+
+/**
+ * Replace the undef values which make up the type of a map operation, see
+ * is_read_or_nop, with a no-op.  Undef may be refined to any value, so
+ * this is correct for all users of the type.  Returns the resulting type.
+ */
+static Value*
+resolve_undef_map_type(Value* type) {
+  auto* nop = ConstantInt::get(type->getType(), NANOTUBE_MAP_NOP);
+  if( isa<UndefValue>(type) )
+    return nop;
+
+  SmallVector<Instruction*, 8> todo;
+  SmallPtrSet<Instruction*, 8> seen;
+  auto* inst = dyn_cast<Instruction>(type);
+  if( inst != nullptr )
+    todo.push_back(inst);
+  while( !todo.empty() ) {
+    inst = todo.pop_back_val();
+    if( !seen.insert(inst).second )
+      continue;
+    /* The condition of a select is not part of the type */
+    unsigned first;
+    if( isa<PHINode>(inst) )
+      first = 0;
+    else if( isa<SelectInst>(inst) )
+      first = 1;
+    else
+      continue;
+    for( unsigned i = first; i < inst->getNumOperands(); i++ ) {
+      auto* op = inst->getOperand(i);
+      if( isa<UndefValue>(op) )
+        inst->setOperand(i, nop);
+      else if( isa<Instruction>(op) )
+        todo.push_back(cast<Instruction>(op));
+    }
+  }
+  return type;
+}
+
+/**
+ * Cancel the response of a speculative read: when the original type of
+ * the map operation was not a read, the response is not copied to the
+ * application buffer and the map operation reports a miss.
+ */
+static void
+cancel_map_response(CallInst* receive, Value* type) {
+  auto& c = receive->getContext();
+  map_op_receive_args mra(receive);
+  IRBuilder<> ir(receive->getNextNode());
+
+  /* An undef type would make the cancel decision undefined */
+  type = resolve_undef_map_type(type);
+  auto* read   = ConstantInt::get(type->getType(), NANOTUBE_MAP_READ);
+  auto* cancel = ir.CreateICmpNE(type, read, "map_cancel");
+
+  /* Receive into a scratch buffer and copy out if not cancelled */
+  auto* len = cast<ConstantInt>(mra.data_length);
+  if( !isa<ConstantPointerNull>(mra.data_out) && !len->isZero() ) {
+    auto& entry = receive->getFunction()->getEntryBlock();
+    IRBuilder<> entry_ir(&*entry.getFirstInsertionPt());
+    auto* buf_ty  = ArrayType::get(Type::getInt8Ty(c), len->getZExtValue());
+    auto* scratch = entry_ir.CreateAlloca(buf_ty, nullptr, "map_spec_buf");
+    IRBuilder<> pre_ir(receive);
+    auto* scratch_p = pre_ir.CreateBitCast(scratch,
+                                           mra.data_out->getType());
+    receive->setArgOperand(2, scratch_p);
+    auto* zero   = ConstantInt::get(len->getType(), 0);
+    auto* cp_len = ir.CreateSelect(cancel, zero, len);
+    ir.CreateMemCpy(mra.data_out, 0, scratch_p, 0, cp_len);
+  }
+
+  /* The users compare the result against zero, see
+   * check_api_call_usage */
+  std::vector<ICmpInst*> users;
+  for( auto* u : receive->users() )
+    users.push_back(cast<ICmpInst>(u));
+  for( auto* icmp : users ) {
+    Instruction* res;
+    if( icmp->getPredicate() == CmpInst::ICMP_EQ ) {
+      res = BinaryOperator::CreateOr(icmp, cancel, "", icmp->getNextNode());
+    } else {
+      auto* keep = BinaryOperator::CreateNot(cancel, "",
+                                             icmp->getNextNode());
+      res = BinaryOperator::CreateAnd(icmp, keep, "", keep->getNextNode());
+    }
+    /* Careful: the new instruction uses icmp itself */
+    icmp->replaceAllUsesWith(res);
+    res->setOperand(0, icmp);
+  }
+}
+
+/**
+ * Checks whether value v is available at instruction inst.
+ */
+static bool
+dominates_inst(DominatorTree* dt, Value* v, Instruction* inst) {
+  auto* def = dyn_cast<Instruction>(v);
+  return (def == nullptr) || dt->dominates(def, inst);
+}
+
+/**
+ * Move a map request to the earliest pipeline stage in which its
+ * arguments are available.  Returns the number of stages the request has
+ * been moved by.
+ */
+static unsigned
+prefetch_map_send(CallInst* send, DominatorTree* dt, AliasAnalysis* aa) {
+  auto* receive = dyn_cast_or_null<CallInst>(send->getNextNode());
+  if( (receive == nullptr) ||
+      (get_intrinsic(receive) != Intrinsics::map_op_receive) )
+    return 0;
+
+  map_op_send_args moa(send);
+  auto* type = moa.type;
+  auto* type_c = dyn_cast<ConstantInt>(type);
+  if( (type_c != nullptr) &&
+      (type_c->getZExtValue() == NANOTUBE_MAP_NOP) )
+    return 0;
+  bool can_speculate = (type_c == nullptr) && is_read_or_nop(type);
+
+  /* The arguments which have to be available */
+  const unsigned args[] = {3, 4, 5, 6, 7, 8};
+  SmallVector<Value*, 6> vals;
+  for( auto idx : args )
+    vals.push_back(resolve_map_arg(send->getArgOperand(idx),
+                                   can_speculate));
+  auto* key = vals[0];
+  auto* key_length = vals[1];
+  auto* data_in = vals[2];
+  auto* mask = vals[3];
+  auto* data_length = vals[5];
+
+  SmallVector<MemoryLocation, 3> mlocs;
+  mlocs.push_back(get_map_arg_loc(key, key_length));
+  if( !isa<ConstantPointerNull>(data_in) )
+    mlocs.push_back(get_map_arg_loc(data_in, data_length));
+  if( !isa<ConstantPointerNull>(mask) )
+    mlocs.push_back(get_map_arg_loc(mask, data_length));
+
+  /* Walk up the dominator tree and visit the split points */
+  Instruction* best = nullptr;
+  unsigned stages = 0;
+  bool speculate = false;
+  bool stop = false;
+  auto* bb = send->getParent();
+  auto  it = send->getIterator();
+  while( !stop ) {
+    while( it != bb->begin() ) {
+      --it;
+      auto* split = &*it;
+      if( !is_split_point(split) )
+        continue;
+
+      bool avail = true;
+      for( auto* v : vals )
+        avail &= dominates_inst(dt, v, split);
+      bool type_avail = dominates_inst(dt, type, split);
+      if( !avail || (!type_avail && !can_speculate) ||
+          !can_prefetch_at(send, split, mlocs, aa) ) {
+        stop = true;
+        break;
+      }
+
+      best = split;
+      speculate = !type_avail;
+      stages++;
+    }
+    auto* node = dt->getNode(bb)->getIDom();
+    if( node == nullptr )
+      break;
+    bb = node->getBlock();
+    it = bb->end();
+  }
+  if( best == nullptr )
+    return 0;
+
+  LLVM_DEBUG(dbgs() << "Moving " << *send << " before " << *best
+                    << " by " << stages << " stages"
+                    << (speculate ? " speculatively\n" : "\n"));
+  for( unsigned i = 0; i < vals.size(); i++ )
+    send->setArgOperand(args[i], vals[i]);
+  if( speculate ) {
+    send->setArgOperand(2, ConstantInt::get(type->getType(),
+                                            NANOTUBE_MAP_READ));
+    cancel_map_response(receive, type);
+  }
+  send->moveBefore(best);
+  return stages;
+}
+
+/**
+ * Move the map requests of the packet kernel to the earliest stage where
+ * their arguments are available, see -pipeline-map-prefetch.
+ *
+ * NOTE: Moving instructions will invalidate liveness analysis data!
+ * Returns true when changes were made.
+ */
+static bool
+prefetch_map_sends(Function& f, DominatorTree* dt, AliasAnalysis* aa) {
+  /* Visit the requests in program order, so that an earlier request
+   * moves out of the way of a later one first */
+  std::vector<CallInst*> sends;
+  ReversePostOrderTraversal<Function*> rpot(&f);
+  for( auto* bb : rpot ) {
+    for( auto& inst : *bb ) {
+      if( get_intrinsic(&inst) == Intrinsics::map_op_send )
+        sends.push_back(cast<CallInst>(&inst));
+    }
+  }
+
+  bool changes = false;
+  for( auto* send : sends ) {
+    unsigned stages = prefetch_map_send(send, dt, aa);
+    if( pipeline_stats && (stages > 0) )
+      errs() << "Map prefetch: " << *send << " moved by " << stages
+             << " stage(s)\n";
+    changes |= (stages > 0);
+  }
+  return changes;
+}
+
 /**
  * Remove llvm.stacksave / llvm.stackrestore calls from the function as
  * they are not needed here and generally confuse the pass.
@@ -4044,6 +5239,56 @@ bool remove_stacksave_restore(Function& f) {
   return changes;
 }
 
+/**
+ * Select the stages which discard the words of dropped packets, see
+ * -pipeline-early-drop.  The drop value of the kernel is known from the
+ * stage which computes it onwards.  A stage must not discard words which
+ * a later stage still inspects, so the early-drop stages also have to
+ * start at the last stage which reads the packet or uses the result of a
+ * packet write.  The resize stages pass control words to one another
+ * and never discard words.
+ */
+static void
+select_early_drop_stages(const Pipeline::stages_t& stages) {
+  auto* last = stages.back();
+  if( !last->is_packet_drop() || isa<Constant>(last->drop_val) )
+    return;
+  auto* drop_val = last->drop_val;
+
+  unsigned first = stages.size() - 1;
+  for( unsigned i = 0; i + 1 < stages.size(); i++ ) {
+    auto& lov = stages[i]->live_out_val;
+    if( std::find(lov.begin(), lov.end(), drop_val) != lov.end() ) {
+      first = i;
+      break;
+    }
+  }
+
+  for( unsigned i = first; i + 1 < stages.size(); i++ ) {
+    auto* stage = stages[i];
+    if( stage->is_resize_ingress() || stage->is_resize_egress() )
+      first = i + 1;
+    else if( stage->is_packet_read() || stage->is_packet_length() ||
+             stage->is_packet_csum() ||
+             (stage->is_packet_write() && !stage->nt_call->use_empty()) )
+      first = i;
+  }
+
+  for( unsigned i = first; i + 1 < stages.size(); i++ ) {
+    auto* stage = stages[i];
+    auto& liv = stage->live_in_val;
+    stage->early_drop = true;
+    stage->early_drop_live_in =
+      std::find(liv.begin(), liv.end(), drop_val) != liv.end();
+    stage->drop_val = drop_val;
+    LLVM_DEBUG(dbgs() << "Stage " << stage->stage_name
+                      << " discards the words of dropped packets"
+                      << (stage->early_drop_live_in ? "" :
+                          " and decides the drop")
+                      << '\n');
+  }
+}
+
 Pipeline::stages_t Pipeline::pipeline(Function& f) {
   std::vector<stage_function_t*> stages;
   /* Scan the function for stages */
@@ -4055,6 +5300,9 @@ Pipeline::stages_t Pipeline::pipeline(Function& f) {
     stage->scan_nanotube_accesses(setup);
   }
 
+  if( pipeline_early_drop )
+    select_early_drop_stages(stages);
+
   /* Create the actual code for each stage */
   for( auto* stage : stages ) {
     ValueToValueMapTy vmap;
@@ -4436,6 +5684,13 @@ bool Pipeline::runOnModule(Module& m) {
     /* Split Nanotube API calls that are multi-phase / multi-stage */
     changes |= convert_api_calls(f);
     changes |= check_api_call_usage(f);
+    /* Issue map requests as early as possible.  The AA result from
+     * get_all_analysis_results has been freed by the analyses requested
+     * after it, so get a fresh one. */
+    if( pipeline_map_prefetch ) {
+      aa = &getAnalysis<AAResultsWrapperPass>(f).getAAResults();
+      changes |= prefetch_map_sends(f, dt, aa);
+    }
     /* Remove all llvm.stacksave / llvm.stackrestore calls */
     changes |= remove_stacksave_restore(f);
     /* Convert phi-of-pointer instructions so they can deal with changed
@@ -84,6 +84,9 @@ struct Pipeline : public llvm::ModulePass {
                              std::vector<llvm::MemoryLocation>& live_out_mem,
                              llvm::BasicBlock** out_app_entry,
                              llvm::BasicBlock** out_bypass_entry);
+  void create_early_drop(stage_function_t* stage, llvm::Value* packet_word,
+                         llvm::BasicBlock* exit_bb,
+                         llvm::BasicBlock** out_app_entry);
 };
 
 class stage_function_t {
@@ -170,12 +173,14 @@ class stage_function_t {
     llvm::GlobalVariable* get_static_have_packet_word();
     llvm::GlobalVariable* get_static_packet_word();
     llvm::GlobalVariable* get_static_word_is_eop();
+    llvm::GlobalVariable* get_static_packet_dropped();
 
     /* Tap state */
     llvm::GlobalVariable* get_static_packet_read_tap_state();
     llvm::GlobalVariable* get_static_packet_read_data(unsigned size);
     llvm::GlobalVariable* get_static_packet_write_tap_state();
     llvm::GlobalVariable* get_static_packet_length_tap_state();
+    llvm::GlobalVariable* get_static_packet_csum_tap_state();
     llvm::GlobalVariable* get_static_packet_resize_ingress_tap_state();
     llvm::GlobalVariable* get_static_packet_eop_tap_state();
 
@@ -196,6 +201,7 @@ class stage_function_t {
     void convert_packet_read(llvm::Value* packet_word, llvm::BasicBlock* bypass_bb);
     llvm::Value* convert_packet_write(Value* packet_word);
     void convert_packet_length(llvm::Value* packet_word, llvm::BasicBlock* bypass_bb);
+    void convert_packet_csum(llvm::Value* packet_word, llvm::BasicBlock* bypass_bb);
     llvm::Value* convert_packet_drop(llvm::Value* packet_word);
     void convert_packet_resize_ingress(llvm::Value* packet_word);
     llvm::Value* convert_packet_resize_egress(Value* packet_word, llvm::BasicBlock* bypass_bb);
@@ -293,6 +299,13 @@ class stage_function_t {
     llvm::ConstantInt* map_rcv_buf_size;
     llvm::Value*       drop_val;
 
+    /* Early drop: the stage discards the words of packets which will be
+     * dropped, see -pipeline-early-drop.  drop_val is the drop value of
+     * the kernel in that case; it is live-in if an earlier stage
+     * computed it. */
+    bool early_drop;
+    bool early_drop_live_in;
+
     void set_nt_id(Intrinsics::ID id) { nt_id = id; }
     void set_nt_call(Instruction* call, Intrinsics::ID id);
 
@@ -303,6 +316,7 @@ class stage_function_t {
     bool is_resize_ingress() { return nt_id == Intrinsics::packet_resize_ingress;}
     bool is_resize_egress()  { return nt_id == Intrinsics::packet_resize_egress;}
     bool is_packet_length()  { return nt_id == Intrinsics::packet_bounded_length;}
+    bool is_packet_csum()    { return nt_id == Intrinsics::packet_csum;}
     bool is_map_request()    { return map_op_req != nullptr; }
     bool is_map_receive()    {
       /* For now, map_receives have to be their own stage! */
@@ -312,7 +326,8 @@ class stage_function_t {
       return map_field;
     }
     bool is_packet_drop()    { return nt_id == Intrinsics::packet_drop; }
-    bool needs_app_send_guard() {return !is_packet_read() && !is_packet_length(); }
+    bool needs_app_send_guard() {return !is_packet_read() && !is_packet_length() &&
+                                        !is_packet_csum(); }
     bool needs_static_checked_packet_word() {return is_resize_egress(); }
     bool unset_app_state_eop() {return has_live_in() && !is_resize_egress(); }
     bool unset_map_resp_eop() {return is_map_receive(); }
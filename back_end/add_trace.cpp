@@ -16,6 +16,12 @@
 #include "llvm_pass.h"
 
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Regex.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <memory>
 
 #define DEBUG_TYPE "add_trace"
 
@@ -25,6 +31,12 @@
 // This pass adds a nanotube_trace call for each integer value
 // computed by the program.  Each trace call is assigned a unique ID.
 //
+// The -add-trace-function option restricts the instrumentation to the
+// functions with a matching name.  The -add-trace-map option writes a
+// file which maps each ID to the instruction being traced.  The
+// scripts/trace_decode tool uses it to annotate binary traces written
+// by the runtime, see nanotube_debug_trace_open.
+//
 // Input conditions
 // ----------------
 //
@@ -49,10 +61,25 @@
 // PHI nodes are handled as a group, so the trace calls are added
 // after the last PHI node.  Terminator instructions which produce a
 // value are ignored as these instructions are not expected.
+//
+// Each line of the map file contains the ID, the function name, the
+// basic block name and the instruction, separated by tabs.
 
 using namespace nanotube;
 using namespace llvm;
 
+static cl::opt<std::string>
+opt_trace_function("add-trace-function",
+                   cl::desc("Only trace the functions whose name matches"
+                            " this regular expression."),
+                   cl::init(""));
+
+static cl::opt<std::string>
+opt_trace_map("add-trace-map",
+              cl::desc("Write the mapping from trace IDs to instructions"
+                       " to this file."),
+              cl::init(""));
+
 namespace
 {
   class add_trace: public llvm::FunctionPass
@@ -60,10 +87,17 @@ namespace
   public:
     static char ID;
     add_trace();
+    bool doInitialization(Module& m) override;
+    bool doFinalization(Module& m) override;
     bool runOnFunction(Function& f) override;
   private:
+    /* Record a trace ID in the map file. */
+    void write_map(uint64_t id, Instruction *insn);
+
     /* The next ID to assign to a trace call. */
     uint64_t m_next_id;
+    /* The map file, if requested. */
+    std::unique_ptr<raw_fd_ostream> m_map_out;
   };
 } // anonymous namespace
 
@@ -75,8 +109,50 @@ add_trace::add_trace():
 {
 }
 
+bool add_trace::doInitialization(Module& m)
+{
+  if (opt_trace_map.empty())
+    return false;
+
+  std::error_code ec;
+  m_map_out.reset(new raw_fd_ostream(opt_trace_map, ec, sys::fs::F_None));
+  if (ec) {
+    errs() << "ERROR: Cannot open trace map '" << opt_trace_map << "': "
+           << ec.message() << "\n";
+    exit(1);
+  }
+  return false;
+}
+
+bool add_trace::doFinalization(Module& m)
+{
+  m_map_out.reset();
+  return false;
+}
+
+void add_trace::write_map(uint64_t id, Instruction *insn)
+{
+  if (!m_map_out)
+    return;
+
+  std::string insn_str;
+  raw_string_ostream insn_os(insn_str);
+  insn->print(insn_os);
+  StringRef insn_text = StringRef(insn_os.str()).trim();
+
+  *m_map_out << id << '\t' << insn->getFunction()->getName()
+             << '\t' << insn->getParent()->getName()
+             << '\t' << insn_text << '\n';
+}
+
 bool add_trace::runOnFunction(Function& func)
 {
+  if (!opt_trace_function.empty()) {
+    Regex re(opt_trace_function);
+    if (!re.match(func.getName()))
+      return false;
+  }
+
   /* Create the trace intrinsic function. */
   Module *module = func.getParent();
   LLVMContext &context = module->getContext();
@@ -104,6 +180,7 @@ bool add_trace::runOnFunction(Function& func)
         Value *value_arg = builder.CreateIntCast(&insn, uint64_type, false);
         Value *trace_args[] = { id_val, value_arg };
         builder.CreateCall(trace_func, trace_args);
+        write_map(m_next_id, &insn);
         any_changes = true;
         m_next_id += 1;
       }
@@ -128,6 +205,7 @@ bool add_trace::runOnFunction(Function& func)
         Value *value_arg = builder.CreateIntCast(insn, uint64_type, false);
         Value *trace_args[] = { id_val, value_arg };
         builder.CreateCall(trace_func, trace_args);
+        write_map(m_next_id, insn);
         any_changes = true;
         m_next_id += 1;
       }
@@ -114,6 +114,7 @@ int main(int argc, char *argv[])
   // Initialize passes.  See llvm/tools/opt/opt.cpp
   llvm::PassRegistry &registry = *llvm::PassRegistry::getPassRegistry();
   llvm::initializeCore(registry);
+  llvm::initializeIPO(registry);
   llvm::initializeAnalysis(registry);
   llvm::initializeTransformUtils(registry);
 
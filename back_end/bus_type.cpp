@@ -29,6 +29,12 @@ static llvm::cl::opt<std::string>
 opt_bus("bus", llvm::cl::desc("Which bus format to use"),
         llvm::cl::init("sb"));
 
+static llvm::cl::opt<unsigned>
+opt_bus_data_bytes("bus-data-bytes",
+                   llvm::cl::desc("The number of data bytes in a bus word"
+                                  " (32, 64 or 128)"),
+                   llvm::cl::init(simple_bus::data_bytes));
+
 std::unordered_map<std::string, enum nanotube_bus_id_t> bus_types = {
   // Recommended names.
   { "sb", NANOTUBE_BUS_ID_SB },
@@ -70,13 +76,55 @@ const char* nanotube::get_bus_suffix(enum nanotube_bus_id_t type) {
 
 ///////////////////////////////////////////////////////////////////////////
 
+/* Return log2 of the selected number of data bytes per word. */
+static unsigned get_bus_log_data_bytes()
+{
+  switch (opt_bus_data_bytes.getValue()) {
+  case 32:  return 5;
+  case 64:  return 6;
+  case 128: return 7;
+  default:
+    report_fatal_errorv("Unsupported bus width of {0} bytes.  Supported"
+                        " widths are 32, 64 and 128 bytes.",
+                        opt_bus_data_bytes.getValue());
+  }
+}
+
+unsigned nanotube::get_bus_data_bytes()
+{
+  unsigned log_data_bytes = get_bus_log_data_bytes();
+  if (log_data_bytes != simple_bus::log_data_bytes &&
+      get_bus_type() == NANOTUBE_BUS_ID_X3RX) {
+    report_fatal_errorv("The x3rx bus only supports {0} byte words.",
+                        x3rx_bus::data_bytes);
+  }
+  return 1U << log_data_bytes;
+}
+
+std::string nanotube::get_bus_tap_suffix(enum nanotube_bus_id_t type)
+{
+  std::string suffix = get_bus_suffix(type);
+  unsigned data_bytes = get_bus_data_bytes();
+  if (data_bytes != simple_bus::data_bytes)
+    suffix += "_w" + std::to_string(data_bytes);
+  return suffix;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+/* Look up a property of the simple bus or softhub bus for the selected
+ * bus width. */
+#define BUS_WIDTH_PROPERTY(bus, prop)                                   \
+  ( get_bus_data_bytes() == 32 ? bus::bus_traits<5>::prop :             \
+    get_bus_data_bytes() == 128 ? bus::bus_traits<7>::prop :            \
+    bus::bus_traits<6>::prop )
+
 nanotube_tap_offset_t nanotube::get_bus_word_size() {
-  /* For now assume that each bus has only a single bus word size.  Of course,
-   * this can be made more complex in the future and the user might want to
-   * select simple-bus-32 vs simple-bus-64 etc. */
+  /* The word size of the simple bus and softhub bus depends on the
+   * selected bus width. */
   nanotube_tap_offset_t word_sizes[] = {
-    sizeof(simple_bus::word),
-    sizeof(softhub_bus::word),
+    BUS_WIDTH_PROPERTY(simple_bus, total_bytes),
+    BUS_WIDTH_PROPERTY(softhub_bus, total_bytes),
     0,
     sizeof(x3rx_bus::word),
   };
@@ -138,8 +186,8 @@ nanotube_packet_size_t nanotube::get_bus_sb_size()
 nanotube_packet_size_t nanotube::get_bus_sb_signals_size()
 {
   nanotube_packet_size_t sideband_signals_sizes[] = {
-    simple_bus::sideband_signals_bytes,
-    softhub_bus::sideband_signals_bytes,
+    BUS_WIDTH_PROPERTY(simple_bus, sideband_signals_bytes),
+    BUS_WIDTH_PROPERTY(softhub_bus, sideband_signals_bytes),
     0,
     x3rx_bus::sideband_signals_bytes,
   };
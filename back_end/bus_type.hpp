@@ -19,6 +19,8 @@
 
 #include "bus_id.h"
 
+#include <string>
+
 ///////////////////////////////////////////////////////////////////////////
 
 namespace nanotube
@@ -45,6 +47,15 @@ namespace nanotube
   // Returns a consistent suffix for specialised bus functions
   const char* get_bus_suffix(enum nanotube_bus_id_t type);
 
+  // Return the number of data bytes in a bus word of the currently
+  // selected bus.
+  unsigned get_bus_data_bytes();
+
+  // Returns the suffix for packet taps specialised for the currently
+  // selected bus width.  This is the bus suffix followed by "_w<N>"
+  // if the width is not the default.
+  std::string get_bus_tap_suffix(enum nanotube_bus_id_t type);
+
   // Return the width of a bus word of the currently selected bus
   nanotube_tap_offset_t get_bus_word_size();
 } // namespace nanotube
@@ -20,35 +20,65 @@
  * the real cost, depending on the specifics of the chosen back-end.
  * Therefore, they should really provide only a first-order approximation.
  *
- * Currently, the following metrics are extracted:
- * XXX
+ * Currently, the following metrics are extracted for each thread and
+ * packet kernel:
+ * - the total cost (sum of all instruction weights) of the application code
+ * - the data-flow critical path, assuming conditionals are flattened
+ * - the CFG-based critical path and longest path through the basic blocks
+ * - the number of boolean operations, comparisons and multiplexers and
+ *   the total width of the multiplexers; these map directly onto LUTs
+ *   and show the effect of the condition simplification in flatten-cfg
+ *
+ * In addition, the pass can produce a static performance estimate for
+ * each pipeline stage (see the -perf-report option).  For each thread it
+ * reports:
+ * - the combinational depth (data-flow critical path) and the latency in
+ *   cycles when -perf-ops-per-cycle operations fit into one clock cycle
+ * - the expected initiation interval (II), derived from the longest
+ *   recurrence through static state (a load of a global variable feeding
+ *   a store to the same variable)
+ * - the FIFO bandwidth in bytes per packet word written by the stage
+ * - the width of the live state passed to the next stage
+ * - the number of map requests per packet and, for map taps, the
+ *   utilisation of the tap
+ * - the resulting packets/second bound at the -perf-clock-mhz clock
+ * The report also names the stage which limits the throughput.
  *
  * _Theory of Operation_
  *
  * - go through all packet kernel pipeline functions
  * - trace instructions and control flow
- * - XXX
+ * - compute dependencies between instructions (data, memory and phi
+ *   selection) and derive critical paths from them
+ * - for the performance report, combine the critical paths with the
+ *   channels and contexts created by the setup function
  *
  * _Prerequisites_
  *
  * The code presented to the pass has to be processed by all the compilation
  * steps including the Pipeline pass.  (It may be interesting to compute
  * similar metrics at earlier points in the compiler pipeline, too, but after
- * the Pipeline pass is the starting point, for now.)
- * XXX: What about after inlining the taps?
+ * the Pipeline pass is the starting point, for now.)  The performance
+ * report is intended to be computed on the same code as the HLS printer,
+ * i.e., after the taps have been linked and inlined.
  *
  * _Expected Output_
  *
- * This pass does not change the code that is passed to it.  It will provide
- * the statistics output as XXX.
+ * This pass does not change the code that is passed to it, unless
+ * -create-trace is specified.  It will provide the statistics output as
+ * CSV lines on the debug output stream and the performance report as a
+ * JSON file.
  */
 #include "code_metrics.hpp"
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <unordered_map>
 
 #include "llvm/Analysis/IteratedDominanceFrontier.h"
+#include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/Analysis/PostDominators.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Module.h"
@@ -56,6 +86,7 @@
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 
+#include "bus_type.hpp"
 #include "common_cmd_opts.hpp"
 #include "Dep_Aware_Converter.h"
 #include "Intrinsics.h"
@@ -68,6 +99,27 @@ using namespace nanotube;
 cl::opt<bool> create_trace("create-trace", cl::desc("Creates kernel "\
                 "copies that only contain a straight-line trace of "\
                 "execution"));
+static cl::opt<std::string> perf_report("perf-report",
+  cl::desc("Write a static per-stage performance estimate to the "
+           "specified JSON file"),
+  cl::value_desc("filename"), cl::init(""));
+static cl::opt<unsigned> perf_clock_mhz("perf-clock-mhz",
+  cl::desc("Clock frequency assumed by the performance estimate"),
+  cl::init(250));
+static cl::opt<unsigned> perf_packet_size("perf-packet-size",
+  cl::desc("Packet size in bytes assumed by the performance estimate"),
+  cl::init(64));
+static cl::opt<unsigned> perf_ops_per_cycle("perf-ops-per-cycle",
+  cl::desc("Number of dependent operations which fit into one clock "
+           "cycle in the performance estimate"),
+  cl::init(4));
+
+code_metrics::code_metrics() :
+  ModulePass(ID), perf_report_file(perf_report) {
+}
+code_metrics::code_metrics(const std::string& perf_report) :
+  ModulePass(ID), perf_report_file(perf_report) {
+}
 
 
 void code_metrics::getAnalysisUsage(AnalysisUsage &info) const {
@@ -1431,8 +1483,53 @@ find_app_code(Function* f, Instruction*& app_entry, Instruction*& app_exit) {
                     << "\n  app end: " << nullsafe(app_exit) << '\n');
 }
 
-static void compute_stage_stats(Function* f, DominatorTree* dt,
-                                PostDominatorTree* pdt, AliasAnalysis* aa) {
+struct stage_stats_t {
+  unsigned total;          /* Sum of the weights of the app code */
+  unsigned data_flow_len;  /* Data-flow critical path of the app code */
+  unsigned cfg_len;        /* CFG-based critical path */
+  unsigned cfg_long_len;   /* CFG-based longest path */
+  lut_stats_t luts;        /* LUT-relevant operation counts */
+};
+
+/**
+ * Count the operations of function f which are implemented in LUTs:
+ * boolean operations (mostly predicates), integer comparisons and
+ * multiplexers (selects, mostly from flattened PHI nodes).  Arithmetic is
+ * not counted, because it typically maps to carry chains and DSPs.
+ */
+lut_stats_t
+nanotube::compute_lut_stats(Function& f) {
+  auto& dl = f.getParent()->getDataLayout();
+  lut_stats_t stats = {0, 0, 0, 0};
+  for( auto& inst : instructions(f) ) {
+    if( isa<SelectInst>(inst) ) {
+      stats.selects++;
+      stats.select_bits += dl.getTypeSizeInBits(inst.getType());
+      continue;
+    }
+    if( isa<ICmpInst>(inst) ) {
+      stats.compares++;
+      continue;
+    }
+    auto* bo = dyn_cast<BinaryOperator>(&inst);
+    if( (bo == nullptr) || !bo->getType()->isIntOrIntVectorTy(1) )
+      continue;
+    switch( bo->getOpcode() ) {
+      case Instruction::And:
+      case Instruction::Or:
+      case Instruction::Xor:
+        stats.bool_ops++;
+        break;
+      default:
+        break;
+    }
+  }
+  return stats;
+}
+
+static stage_stats_t
+compute_stage_stats(Function* f, DominatorTree* dt, PostDominatorTree* pdt,
+                    AliasAnalysis* aa) {
   LLVM_DEBUG(dbgs() << "Computing stats for " << f->getName() << '\n');
 
   Instruction *app_entry, *app_exit;
@@ -1449,6 +1546,7 @@ static void compute_stage_stats(Function* f, DominatorTree* dt,
     dbgs() << "Length: " << data_flow_len << '\n');
   auto cfg_len       = get_cfg_critical_path(f, app_entry, app_exit);
   auto cfg_long_len  = get_cfg_longest_path(f, app_entry, app_exit);
+  auto luts          = compute_lut_stats(*f);
 
   LLVM_DEBUG(
     dbgs() << "Function " << f->getName() << " Cost: " << total
@@ -1458,8 +1556,268 @@ static void compute_stage_stats(Function* f, DominatorTree* dt,
            << " ILP: " << formatv("{0:f}", (float)total/cfg_len)
            << '\n');
   dbgs() << f->getName() << ", " << total << ", " << data_flow_len << ", "
-         << cfg_len << ", " << cfg_long_len << '\n';
+         << cfg_len << ", " << cfg_long_len << ", " << luts.bool_ops << ", "
+         << luts.compares << ", " << luts.selects << ", "
+         << luts.select_bits << '\n';
+
+  return stage_stats_t{total, data_flow_len, cfg_len, cfg_long_len, luts};
+}
+
+/***** Static per-stage performance estimate *****/
+
+/**
+ * Compute the longest chain of data dependencies from a load of a global
+ * variable to a store of the same variable in the provided function.
+ * Such a chain is a recurrence: the next invocation of the stage cannot
+ * read the variable before the current invocation has written it, so the
+ * length of the chain bounds the initiation interval of the stage.
+ *
+ * Back edges are ignored, the stage functions are expected to be acyclic.
+ */
+static unsigned
+get_recurrence_depth(Function* f) {
+  auto& dl = f->getParent()->getDataLayout();
+
+  /* Find the globals that are both loaded and stored */
+  std::unordered_set<Value*> loaded, recurrent;
+  for( auto& inst : instructions(f) ) {
+    auto* ld = dyn_cast<LoadInst>(&inst);
+    if( ld != nullptr ) {
+      auto* obj = GetUnderlyingObject(ld->getPointerOperand(), dl);
+      if( isa<GlobalVariable>(obj) )
+        loaded.insert(obj);
+    }
+  }
+  for( auto& inst : instructions(f) ) {
+    auto* st = dyn_cast<StoreInst>(&inst);
+    if( st == nullptr )
+      continue;
+    auto* obj = GetUnderlyingObject(st->getPointerOperand(), dl);
+    if( loaded.count(obj) > 0 )
+      recurrent.insert(obj);
+  }
+
+  unsigned max_depth = 0;
+  ReversePostOrderTraversal<Function*> rpot(f);
+  for( auto* gv : recurrent ) {
+    /* Distance of each instruction from a load of gv */
+    std::unordered_map<Instruction*, unsigned> dist;
+    for( auto* bb : rpot ) {
+      for( auto& inst : *bb ) {
+        auto* ld = dyn_cast<LoadInst>(&inst);
+        if( (ld != nullptr) &&
+            (GetUnderlyingObject(ld->getPointerOperand(), dl) == gv) ) {
+          dist[&inst] = get_weight(&inst);
+          continue;
+        }
+
+        bool     reached = false;
+        unsigned d       = 0;
+        for( auto& op : inst.operands() ) {
+          auto* op_inst = dyn_cast<Instruction>(op.get());
+          if( op_inst == nullptr )
+            continue;
+          auto it = dist.find(op_inst);
+          if( it == dist.end() )
+            continue;
+          reached = true;
+          d = std::max(d, it->second);
+        }
+        if( !reached )
+          continue;
+        d += get_weight(&inst);
+        dist[&inst] = d;
+
+        auto* st = dyn_cast<StoreInst>(&inst);
+        if( (st != nullptr) &&
+            (GetUnderlyingObject(st->getPointerOperand(), dl) == gv) ) {
+          LLVM_DEBUG(dbgs() << "Recurrence through " << gv->getName()
+                            << " in " << f->getName() << ": " << d
+                            << '\n');
+          max_depth = std::max(max_depth, d);
+        }
+      }
+    }
+  }
+  return max_depth;
+}
+
+static unsigned
+div_ceil(unsigned a, unsigned b) {
+  return (a + b - 1) / b;
+}
+
+/**
+ * Write a string as a quoted JSON string.
+ */
+static void
+write_json_string(raw_ostream& os, StringRef str) {
+  os << '"';
+  for( unsigned char c : str ) {
+    if( (c == '"') || (c == '\\') )
+      os << '\\' << c;
+    else if( c < 0x20 )
+      os << formatv("\\u{0:x-4}", (unsigned)c);
+    else
+      os << c;
+  }
+  os << '"';
+}
+
+/**
+ * Estimate the throughput of each thread and write the result as JSON.
+ *
+ * The estimate uses a simple model: a stage processes one packet word per
+ * invocation and can start a new invocation every II cycles; a map tap
+ * serves one request per cycle.  Channels with the width of a bus word
+ * carry one element per packet word, all other channels carry one
+ * element per packet.  A stage with an iterative loop (see the
+ * loop-feedback pass) needs one extra invocation per loop iteration
+ * after the first, so its bound is given for the maximum trip count.
+ */
+static void
+write_perf_report(setup_func& setup, const std::vector<stage_stats_t>& stats,
+                  const std::vector<unsigned>& rec_depths,
+                  const std::string& filename) {
+  auto word_size = get_bus_word_size();
+  unsigned data_bytes = word_size - get_bus_sb_size() -
+                        get_bus_sb_signals_size();
+  unsigned words_per_packet = std::max(1u, div_ceil(perf_packet_size,
+                                                    data_bytes));
+  unsigned ops_per_cycle = std::max(1u, (unsigned)perf_ops_per_cycle);
+  double   clock_hz = perf_clock_mhz * 1e6;
+
+  /* Count the map request channels of each thread and of each map tap */
+  unsigned num_threads = setup.threads().size();
+  std::vector<unsigned> map_channels(num_threads, 0);
+  std::vector<unsigned> map_clients(num_threads, 0);
+  std::vector<bool>     is_map_tap(num_threads, false);
+  for( thread_id_t id = 0; id < num_threads; id++ )
+    is_map_tap[id] = (setup.threads()[id].args().name == "map_tap");
+
+  for( auto& channel : setup.channels() ) {
+    if( !channel.has_writer() || !channel.has_reader() )
+      continue;
+    auto& rd_ctx = setup.get_context_info(channel.get_reader_context());
+    auto& wr_ctx = setup.get_context_info(channel.get_writer_context());
+    auto rd_id = rd_ctx.get_thread_id();
+    auto wr_id = wr_ctx.get_thread_id();
+    if( (rd_id == thread_id_none) || (wr_id == thread_id_none) )
+      continue;
+    if( is_map_tap[rd_id] && !is_map_tap[wr_id] ) {
+      map_channels[wr_id]++;
+      map_clients[rd_id]++;
+    }
+  }
+
+  /* Compute the per-thread estimates and find the limiting thread */
+  struct perf_t {
+    unsigned latency;
+    unsigned ii;
+    double   fifo_bytes_per_word;
+    unsigned live_state_bytes;
+    unsigned loop_max_trips;
+    double   pps;
+  };
+  std::vector<perf_t> perf(num_threads);
+  thread_id_t limit_id = thread_id_none;
+  for( thread_id_t id = 0; id < num_threads; id++ ) {
+    auto& p = perf[id];
+    auto& context = setup.get_context_info(
+                      setup.threads()[id].context_index());
+    p.latency = div_ceil(stats[id].data_flow_len, ops_per_cycle);
+    p.ii      = std::max(1u, div_ceil(rec_depths[id], ops_per_cycle));
+    p.loop_max_trips = get_loop_max_trips(*setup.threads()[id].args().func);
+
+    p.fifo_bytes_per_word = 0;
+    p.live_state_bytes    = 0;
+    for( auto& port : context.ports() ) {
+      if( port.is_read() )
+        continue;
+      auto& channel = setup.channels()[port.channel_index()];
+      unsigned size = channel.get_elem_size();
+      if( size == word_size )
+        p.fifo_bytes_per_word += size;
+      else
+        p.fifo_bytes_per_word += (double)size / words_per_packet;
+      if( StringRef(channel.get_name()).startswith("state_") )
+        p.live_state_bytes += size;
+    }
+
+    if( is_map_tap[id] )
+      p.pps = clock_hz / std::max(1u, map_clients[id]);
+    else
+      p.pps = clock_hz / (p.ii * (words_per_packet +
+                                  std::max(1u, p.loop_max_trips) - 1));
+
+    if( (limit_id == thread_id_none) || (p.pps < perf[limit_id].pps) )
+      limit_id = id;
+  }
+  double pps = (limit_id != thread_id_none) ? perf[limit_id].pps : 0.0;
+
+  std::error_code ec;
+  raw_fd_ostream out(filename, ec, sys::fs::F_None);
+  if( ec ) {
+    errs() << "ERROR: Could not open performance report " << filename
+           << ": " << ec.message() << '\n';
+    return;
+  }
 
+  out << "{\n"
+         "  \"clock_mhz\": " << perf_clock_mhz << ",\n"
+         "  \"packet_size\": " << perf_packet_size << ",\n"
+         "  \"bus_data_bytes\": " << data_bytes << ",\n"
+         "  \"words_per_packet\": " << words_per_packet << ",\n"
+         "  \"ops_per_cycle\": " << ops_per_cycle << ",\n"
+         "  \"stages\": [\n";
+  for( thread_id_t id = 0; id < num_threads; id++ ) {
+    auto& thread = setup.threads()[id];
+    auto& p = perf[id];
+    if( id != 0 )
+      out << ",\n";
+    out << "    {\n"
+           "      \"thread_id\": " << id << ",\n"
+           "      \"name\": ";
+    write_json_string(out, thread.args().name);
+    out << ",\n"
+           "      \"function\": ";
+    write_json_string(out, thread.args().func->getName());
+    out << ",\n"
+           "      \"kind\": \"" << (is_map_tap[id] ? "map_tap" : "stage")
+                                    << "\",\n"
+           "      \"comb_depth\": " << stats[id].data_flow_len << ",\n"
+           "      \"bool_ops\": " << stats[id].luts.bool_ops << ",\n"
+           "      \"compares\": " << stats[id].luts.compares << ",\n"
+           "      \"selects\": " << stats[id].luts.selects << ",\n"
+           "      \"select_bits\": " << stats[id].luts.select_bits << ",\n"
+           "      \"latency_cycles\": " << p.latency << ",\n"
+           "      \"recurrence_depth\": " << rec_depths[id] << ",\n"
+           "      \"ii\": " << p.ii << ",\n"
+           "      \"fifo_bytes_per_word\": "
+             << formatv("{0:f2}", p.fifo_bytes_per_word) << ",\n"
+           "      \"live_state_bytes\": " << p.live_state_bytes << ",\n"
+           "      \"loop_max_trips\": " << p.loop_max_trips << ",\n"
+           "      \"map_channels\": " << map_channels[id] << ",\n"
+           "      \"map_tap_utilization\": "
+             << formatv("{0:f3}", is_map_tap[id]
+                                    ? map_clients[id] * pps / clock_hz
+                                    : 0.0) << ",\n"
+           "      \"pps_bound\": " << formatv("{0:f0}", p.pps) << "\n"
+           "    }";
+  }
+  if( num_threads != 0 )
+    out << "\n";
+  out << "  ],\n"
+         "  \"limiting_thread_id\": ";
+  if( limit_id != thread_id_none )
+    out << limit_id;
+  else
+    out << "null";
+  out << ",\n"
+         "  \"pps_bound\": " << formatv("{0:f0}", pps) << ",\n"
+         "  \"gbps_bound\": "
+           << formatv("{0:f3}", pps * perf_packet_size * 8 / 1e9) << "\n"
+         "}\n";
 }
 
 /**
@@ -1598,16 +1956,24 @@ synthesise_trace(Function* f) {
 
 bool code_metrics::runOnModule(Module& m) {
   setup_func setup(m, nullptr, false);
-  dbgs() << "Function Name, Total Cost, DF CP, CFG CP, CFG LL\n";
+  dbgs() << "Function Name, Total Cost, DF CP, CFG CP, CFG LL, Bool Ops, "
+            "Compares, Selects, Select Bits\n";
+  std::vector<stage_stats_t> thread_stats;
+  std::vector<unsigned> rec_depths;
   for( auto& thread : setup.threads() ) {
     get_all_analysis_results(thread.args().func);
-    compute_stage_stats(thread.args().func, dt, pdt, aa);
+    thread_stats.emplace_back(compute_stage_stats(thread.args().func,
+                                                  dt, pdt, aa));
+    rec_depths.emplace_back(get_recurrence_depth(thread.args().func));
   }
   for( auto& kernel : setup.kernels() ) {
     get_all_analysis_results(kernel.args().kernel);
     compute_stage_stats(kernel.args().kernel, dt, pdt, aa);
   }
 
+  if( !perf_report_file.empty() )
+    write_perf_report(setup, thread_stats, rec_depths, perf_report_file);
+
   if( !create_trace)
     return false;
 
@@ -1625,4 +1991,8 @@ static RegisterPass<code_metrics>
     true
   );
 
+ModulePass* nanotube::create_code_metrics(const std::string& perf_report) {
+  return new code_metrics(perf_report);
+}
+
 /* vim: set ts=8 et sw=2 sts=2 tw=75: */
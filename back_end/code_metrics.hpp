@@ -20,11 +20,29 @@
 
 #include "Nanotube_Alias.hpp"
 
+#include <string>
+
+namespace nanotube {
+/* Create the code-metrics pass, writing the performance report to the
+ * provided file unless it is empty. */
+llvm::ModulePass* create_code_metrics(const std::string& perf_report);
+
+/* Counts of the operations which end up as LUTs in the HLS output. */
+struct lut_stats_t {
+  unsigned bool_ops;     /* Boolean AND / OR / XOR operations */
+  unsigned compares;     /* Integer comparisons */
+  unsigned selects;      /* Multiplexers */
+  unsigned select_bits;  /* Sum of the widths of the multiplexers */
+};
+lut_stats_t compute_lut_stats(llvm::Function& f);
+} // namespace nanotube
+
 namespace {
 struct code_metrics : public llvm::ModulePass {
-  code_metrics() : ModulePass(ID) {
-  }
+  code_metrics();
+  code_metrics(const std::string& perf_report);
   static char ID;
+  std::string perf_report_file;
   llvm::PostDominatorTree* pdt;
   llvm::DominatorTree* dt;
   llvm::AliasAnalysis* aa;
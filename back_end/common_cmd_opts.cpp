@@ -15,5 +15,9 @@ namespace nanotube {
 llvm::cl::opt<bool>
 opt_print_analysis_info("print-analysis-info",
                       llvm::cl::desc("Print analysis pass info."));
+llvm::cl::opt<bool>
+opt_native_width_access("native-width-access",
+                        llvm::cl::desc("Keep aligned constant offset memory"
+                                       " accesses at their native width."));
 };
 /* vim: set ts=8 et sw=2 sts=2 tw=75: */
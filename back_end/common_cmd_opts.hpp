@@ -14,5 +14,6 @@
 
 namespace nanotube {
   extern llvm::cl::opt<bool> opt_print_analysis_info;
+  extern llvm::cl::opt<bool> opt_native_width_access;
 };
 /* vim: set ts=8 et sw=2 sts=2 tw=75: */
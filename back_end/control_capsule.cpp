@@ -84,6 +84,17 @@
 //   
 //   process_net_packet:                               ; preds = %entry
 //     <original code>
+//
+// Batched capsules
+// ----------------
+//
+// With -control-capsule-batch=N, each map is processed with
+// nanotube_map_process_capsule_batch instead, which also accepts
+// capsules holding up to N entries.  The number of entries is limited
+// to what fits in a capsule of NANOTUBE_CAPSULE_MAX_SIZE bytes.  The
+// capsule buffer is sized for the largest batch, so N trades the size
+// of the capsule kernel against the number of capsules needed to
+// access many map entries.
 
 #define DEBUG_TYPE "control-capsule"
 
@@ -91,6 +102,7 @@
 #include "llvm_common.h"
 #include "llvm_pass.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 #include "nanotube_capsule.h"
 #include "setup_func.hpp"
@@ -100,6 +112,13 @@ using namespace nanotube;
 using llvm::IRBuilder;
 using llvm::Twine;
 
+static llvm::cl::opt<unsigned>
+opt_batch_entries("control-capsule-batch",
+                  llvm::cl::desc("The maximum number of map entries in a"
+                                 " batched control capsule, or 0 to"
+                                 " disable batches."),
+                  llvm::cl::init(0));
+
 ///////////////////////////////////////////////////////////////////////////
 
 namespace {
@@ -112,6 +131,9 @@ namespace {
     cc_code_builder(const cc_code_builder &) = delete;
     cc_code_builder &operator =(const cc_code_builder &) = delete;
 
+    void get_map_sizes(const map_info *map, uint64_t *key_size,
+                       uint64_t *value_size);
+    uint64_t get_batch_entries(const map_info *map);
     size_t get_buffer_length(const map_info *map);
     size_t get_buffer_length();
 
@@ -210,7 +232,9 @@ cc_code_builder::cc_code_builder(const kernel_info *kernel,
   m_packet_arg = (m_func->arg_begin() + KERNEL_PACKET_ARG);
 }
 
-size_t cc_code_builder::get_buffer_length(const map_info *map)
+void cc_code_builder::get_map_sizes(const map_info *map,
+                                    uint64_t *key_size,
+                                    uint64_t *value_size)
 {
   auto *key_size_val = dyn_cast_or_null<ConstantInt>(map->args().key_sz);
   auto *value_size_val = dyn_cast_or_null<ConstantInt>(map->args().value_sz);
@@ -223,10 +247,35 @@ size_t cc_code_builder::get_buffer_length(const map_info *map)
                         *(map->args().value_sz));
   }
 
-  uint64_t key_size = key_size_val->getLimitedValue();
-  uint64_t value_size = value_size_val->getLimitedValue();
+  *key_size = key_size_val->getLimitedValue();
+  *value_size = value_size_val->getLimitedValue();
+}
+
+uint64_t cc_code_builder::get_batch_entries(const map_info *map)
+{
+  uint64_t key_size, value_size;
+  get_map_sizes(map, &key_size, &value_size);
+
+  uint64_t max_entries =
+    NANOTUBE_CAPSULE_MAP_BATCH_MAX_ENTRIES(key_size, value_size);
+  return std::min(uint64_t(opt_batch_entries), max_entries);
+}
 
-  return NANOTUBE_CAPSULE_MAP_CAPSULE_SIZE(key_size, value_size);
+size_t cc_code_builder::get_buffer_length(const map_info *map)
+{
+  uint64_t key_size, value_size;
+  get_map_sizes(map, &key_size, &value_size);
+
+  size_t result = NANOTUBE_CAPSULE_MAP_CAPSULE_SIZE(key_size, value_size);
+  uint64_t entries = get_batch_entries(map);
+  if (entries != 0) {
+    size_t size = NANOTUBE_CAPSULE_MAP_BATCH_CAPSULE_SIZE(key_size,
+                                                          value_size,
+                                                          entries);
+    if (result < size)
+      result = size;
+  }
+  return result;
 }
 
 size_t cc_code_builder::get_buffer_length()
@@ -369,15 +418,29 @@ void cc_code_builder::create_map_bb(uint64_t index, const map_info *info)
   auto map_id = info->args().id;
   IntegerType* id_ty = get_nt_map_id_type(*m_module);
   auto *map_id_value = ConstantInt::get(id_ty, uint64_t(map_id));
-  auto *proc_func = create_nt_map_process_capsule(*m_module);
-  Value *args[] = {
-    m_context_arg,
-    map_id_value,
-    m_capsule_buffer,
-    info->args().key_sz,
-    info->args().value_sz,
-  };
-  m_builder.CreateCall(proc_func, args);
+  uint64_t batch_entries = get_batch_entries(info);
+  if (batch_entries != 0) {
+    auto *proc_func = create_nt_map_process_capsule_batch(*m_module);
+    Value *args[] = {
+      m_context_arg,
+      map_id_value,
+      m_capsule_buffer,
+      info->args().key_sz,
+      info->args().value_sz,
+      m_builder.getInt64(batch_entries),
+    };
+    m_builder.CreateCall(proc_func, args);
+  } else {
+    auto *proc_func = create_nt_map_process_capsule(*m_module);
+    Value *args[] = {
+      m_context_arg,
+      map_id_value,
+      m_capsule_buffer,
+      info->args().key_sz,
+      info->args().value_sz,
+    };
+    m_builder.CreateCall(proc_func, args);
+  }
 
   m_builder.CreateBr(m_capsule_write_bb);
 
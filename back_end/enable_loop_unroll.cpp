@@ -17,6 +17,8 @@
 
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/LoopPass.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Support/CommandLine.h"
 
 #define DEBUG_TYPE "enable_loop_unroll"
 
@@ -42,6 +44,11 @@
 // The following metadata is removed:
 //   llvm.loop.unroll.disable
 //
+// With -enable-loop-unroll-max-trips=N, loops which may execute more
+// than N iterations are marked with llvm.loop.unroll.disable instead so
+// that the outline-loops and loop-feedback passes can implement them
+// without replicating the body.
+//
 // Theory of operation
 // -------------------
 //
@@ -56,11 +63,20 @@
 using namespace nanotube;
 using llvm::LLVMContext;
 using llvm::Loop;
+using llvm::ScalarEvolution;
+using llvm::ScalarEvolutionWrapperPass;
 using llvm::MDNode;
 using llvm::MDOperand;
 using llvm::MDString;
 using llvm::Metadata;
 
+static llvm::cl::opt<unsigned>
+opt_max_trips("enable-loop-unroll-max-trips",
+              llvm::cl::desc("Disable unrolling of loops which may"
+                             " execute more than this number of"
+                             " iterations.  Zero means no limit."),
+              llvm::cl::init(0));
+
 namespace
 {
   class enable_loop_unroll: public llvm::LoopPass
@@ -68,6 +84,7 @@ namespace
   public:
     static char ID;
     enable_loop_unroll();
+    void getAnalysisUsage(llvm::AnalysisUsage &info) const override;
     bool runOnLoop(Loop* L, llvm::LPPassManager& LPM) override;
   };
 } // anonymous namespace
@@ -79,6 +96,12 @@ enable_loop_unroll::enable_loop_unroll():
 {
 }
 
+void enable_loop_unroll::getAnalysisUsage(llvm::AnalysisUsage &info) const
+{
+  if (opt_max_trips != 0)
+    info.addRequired<ScalarEvolutionWrapperPass>();
+}
+
 bool enable_loop_unroll::runOnLoop(Loop *L, llvm::LPPassManager &LPM)
 {
   // The LLVM context.
@@ -93,6 +116,22 @@ bool enable_loop_unroll::runOnLoop(Loop *L, llvm::LPPassManager &LPM)
     dbgs() << formatv("Processing loop at {0}\n", L->getHeader()->front());
   );
 
+  // Decide whether to enable or disable unrolling.  Loops with a large
+  // or unknown trip count are left alone unless a limit was requested.
+  const char *enable_str = "llvm.loop.unroll.enable";
+  const char *disable_str = "llvm.loop.unroll.disable";
+  if (opt_max_trips != 0) {
+    ScalarEvolution &se =
+      getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+    unsigned trips = se.getSmallConstantMaxTripCount(L);
+    if (trips == 0 || trips > opt_max_trips) {
+      LLVM_DEBUG(
+        dbgs() << formatv("  Keeping rolled, max trips {0}.\n", trips);
+      );
+      std::swap(enable_str, disable_str);
+    }
+  }
+
   if (loop_md != nullptr) {
     LLVM_DEBUG(
       dbgs() << formatv("  Scanning metadata: {0}\n", *loop_md);
@@ -119,7 +158,7 @@ bool enable_loop_unroll::runOnLoop(Loop *L, llvm::LPPassManager &LPM)
           dbgs() << formatv("  Found string '{0}'\n", str);
         );
 
-        if (str.equals("llvm.loop.unroll.enable")) {
+        if (str.equals(enable_str)) {
           LLVM_DEBUG(
             dbgs() << formatv("    Is loop enable.\n");
           );
@@ -127,7 +166,7 @@ bool enable_loop_unroll::runOnLoop(Loop *L, llvm::LPPassManager &LPM)
           continue;
         }
 
-        if (str.equals("llvm.loop.unroll.disable")) {
+        if (str.equals(disable_str)) {
           LLVM_DEBUG(
             dbgs() << formatv("    Need update.\n");
           );
@@ -180,7 +219,7 @@ bool enable_loop_unroll::runOnLoop(Loop *L, llvm::LPPassManager &LPM)
         );
 
         // Strip any properties which are not required.
-        if (str.equals("llvm.loop.unroll.disable")) {
+        if (str.equals(disable_str)) {
           LLVM_DEBUG(
             dbgs() << formatv("    Ignoring.\n");
           );
@@ -200,7 +239,7 @@ bool enable_loop_unroll::runOnLoop(Loop *L, llvm::LPPassManager &LPM)
       dbgs() << formatv("  Adding unroll enable.\n");
     );
     Metadata *md[] = {
-        MDString::get(context, "llvm.loop.unroll.enable")
+        MDString::get(context, enable_str)
     };
     MDNode *enable = MDNode::get(context, md);
     props.push_back(enable);
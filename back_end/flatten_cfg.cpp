@@ -35,10 +35,38 @@
  *     statements) are removed; they order the basic blocks of the program;
  *     conditional branches / switch statements update the conditions for
  *     tracking which basic block of the program is executing
+ *
+ * _Speculation_
+ *
+ * Packet and map reads can be executed speculatively rather than being
+ * predicated, so that they do not have to wait for the predicate of their
+ * basic block (-flatten-spec-reads).  If the packet kernel has a profile
+ * (see the nt-profile-use pass), the reads of hot basic blocks are always
+ * executed speculatively and the reads of cold basic blocks are always
+ * predicated.  That keeps the predicate computation off the critical path
+ * of the hot path, and avoids issuing the reads of the cold path for every
+ * packet.
+ *
+ * _Condition simplification_
+ *
+ * The block predicates and the one-hot selects built from them contain a
+ * lot of redundancy on kernels with deep if / else chains: the predicate
+ * of a merge block often recomputes the predicate of an earlier block,
+ * and the cases of a switch are mutually exclusive.  After flattening,
+ * the pass represents the boolean values of the function as a BDD.
+ * Conditions which compute the same function share a single value,
+ * constant conditions are folded and nested selects whose condition is
+ * decided by the enclosing select are bypassed.  Selects with identical
+ * inputs collapse, too (-flatten-simplify-conds, on by default).
+ * -flatten-cond-stats reports the LUT-relevant operation counts (see the
+ * code-metrics pass) before and after.
  */
 #include "flatten_cfg.hpp"
 
+#include <limits>
+#include <map>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -50,14 +78,18 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/ValueHandle.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Transforms/Utils/Local.h"
 
 #include "../include/nanotube_api.h"
+#include "code_metrics.hpp"
 #include "common_cmd_opts.hpp"
 #include "Dep_Aware_Converter.h"
 #include "printing_helpers.h"
+#include "profile.hpp"
 #include "setup_func.hpp"
 #include "unify_function_returns.hpp"
 
@@ -70,6 +102,13 @@ cl::opt<bool> spec_reads("flatten-spec-reads", cl::desc("Allow the "\
                          "flatten-cfg pass to speculatively execute "\
                          "packet and map reads rather than predicating "\
                          "them."));
+static cl::opt<bool> simplify_conds("flatten-simplify-conds",
+  cl::desc("Simplify the predicates and multiplexers created by the "
+           "flatten-cfg pass"),
+  cl::init(true));
+static cl::opt<bool> cond_stats("flatten-cond-stats",
+  cl::desc("Report the LUT-relevant operation counts of each flattened "
+           "function before and after the condition simplification"));
 
 const bool inline_helpers = true;
 
@@ -518,17 +557,19 @@ generate_conditional_store(StoreInst* st, Instruction* ip, Value* pred) {
 }
 
 /**
- * Turns a packet operation into a predicated one and move it.
+ * Turns a packet operation into a predicated one and move it.  Reads are
+ * executed speculatively instead if speculate is set.
  */
 static void
-predicate_packet_access(nt_api_call* pkt_op, Instruction* ip, Value* pred) {
+predicate_packet_access(nt_api_call* pkt_op, Instruction* ip, Value* pred,
+                        bool speculate) {
   assert(pkt_op->is_packet());
   IRBuilder<> ir(ip);
   auto* call = pkt_op->get_call();
   int idx = -1;
   Value* new_arg = nullptr;
 
-  bool hoist_read = spec_reads && pkt_op->is_read();
+  bool hoist_read = speculate && pkt_op->is_read();
   if( pkt_op->is_access() ) {
     /* Execute reads speculatively if that is okay */
     if( hoist_read ) {
@@ -555,8 +596,9 @@ predicate_packet_access(nt_api_call* pkt_op, Instruction* ip, Value* pred) {
 
     auto* zero = Constant::getNullValue(adj->getType());
     new_arg = ir.CreateSelect(pred, adj, zero);
-  } else if( pkt_op->get_intrinsic() == Intrinsics::packet_bounded_length ) {
-    /* Can always hoist a length call */
+  } else if( pkt_op->get_intrinsic() == Intrinsics::packet_bounded_length ||
+             pkt_op->get_intrinsic() == Intrinsics::packet_csum ) {
+    /* Can always hoist a length or checksum call */
     call->moveBefore(ip);
     return;
   } else {
@@ -576,10 +618,12 @@ predicate_packet_access(nt_api_call* pkt_op, Instruction* ip, Value* pred) {
 }
 
 /**
- * Turns a map access into a predicated one and moves it.
+ * Turns a map access into a predicated one and moves it.  Reads are
+ * executed speculatively instead if speculate is set.
  */
 static void
-predicate_map_access(nt_api_call* map_acc, Instruction* ip, Value* pred) {
+predicate_map_access(nt_api_call* map_acc, Instruction* ip, Value* pred,
+                     bool speculate) {
   assert(map_acc->is_access() && map_acc->is_map());
   auto* call = map_acc->get_call();
 
@@ -594,7 +638,7 @@ predicate_map_access(nt_api_call* map_acc, Instruction* ip, Value* pred) {
 
   /* If it is a map read and allowed, execute it speculatively. */
   auto* op_const = dyn_cast<ConstantInt>(op);
-  if( spec_reads && (op_const != nullptr) &&
+  if( speculate && (op_const != nullptr) &&
       (op_const->getZExtValue() == NANOTUBE_MAP_READ) ) {
     call->moveBefore(ip);
     return;
@@ -678,7 +722,8 @@ remove_stacksave_and_restores(nt_api_call* nac) {
 }
 
 static void
-flatten_side_effect(Instruction* inst, Instruction* ip, Value* bb_pred) {
+flatten_side_effect(Instruction* inst, Instruction* ip, Value* bb_pred,
+                    bool speculate) {
 
   /* If the basic block will always be executed, no problem */
   auto* pred_const = dyn_cast<ConstantInt>(bb_pred);
@@ -705,10 +750,10 @@ flatten_side_effect(Instruction* inst, Instruction* ip, Value* bb_pred) {
     nt_api_call ntc(call);
     /* Turn an NT API access into a predicated version */
     if( ntc.is_packet() ) {
-      predicate_packet_access(&ntc, ip, bb_pred);
+      predicate_packet_access(&ntc, ip, bb_pred, speculate);
       return;
     } else if( ntc.is_map() ) {
-      predicate_map_access(&ntc, ip, bb_pred);
+      predicate_map_access(&ntc, ip, bb_pred, speculate);
       return;
     } else if( ntc.get_intrinsic() == Intrinsics::llvm_memcpy ) {
       predicate_memcpy(&ntc, ip, bb_pred);
@@ -739,7 +784,8 @@ flatten_side_effect(Instruction* inst, Instruction* ip, Value* bb_pred) {
 BasicBlock::iterator
 flatten_instruction(BasicBlock::iterator it, Value* pred, Instruction* ip,
                     block_to_blockval_t& edge_preds,
-                    block_val_vec_t& in_edge_preds, Value* bb_pred) {
+                    block_val_vec_t& in_edge_preds, Value* bb_pred,
+                    bool speculate) {
   auto* inst = &(*it);
   auto nxt = ++it;
 
@@ -772,7 +818,7 @@ flatten_instruction(BasicBlock::iterator it, Value* pred, Instruction* ip,
       break;
     case Instruction::Store:
     case Instruction::Call:
-      flatten_side_effect(inst, ip, bb_pred);
+      flatten_side_effect(inst, ip, bb_pred, speculate);
       break;
     default:
       if( !isSafeToSpeculativelyExecute(inst) ) {
@@ -791,7 +837,7 @@ flatten_instruction(BasicBlock::iterator it, Value* pred, Instruction* ip,
 static bool
 flatten_basic_bloc(BasicBlock* bb, Instruction* ip, block_to_val_t& bb_preds,
                    block_to_blockval_t& edge_preds, DominatorTree* dt,
-                   PostDominatorTree* pdt) {
+                   PostDominatorTree* pdt, const block_profile& profile) {
   //auto& c = ip->getContext();
   auto& in_edge_preds = edge_preds[bb];
 
@@ -819,10 +865,15 @@ flatten_basic_bloc(BasicBlock* bb, Instruction* ip, block_to_val_t& bb_preds,
   }
   bb_preds[bb]  = pred_bb;
 
+  /* Let the profile decide about speculating the reads, if there is one */
+  bool speculate = spec_reads;
+  if( profile.valid() )
+    speculate = profile.is_hot(bb) || (spec_reads && !profile.is_cold(bb));
+
   auto it = bb->begin();
   while( it != bb->end() ) {
     it = flatten_instruction(it, pred_bb, ip, edge_preds, in_edge_preds,
-                             pred_bb);
+                             pred_bb, speculate);
   }
   return false;
 }
@@ -839,6 +890,9 @@ flatten_function(Function& f, DominatorTree* dt, PostDominatorTree* pdt) {
   LLVM_DEBUG(dbgs() << "Flattening function " << f.getName() << '\n'
                     << "Insertion point " << *ip << '\n');
 
+  /* Compute the profile before the CFG is taken apart */
+  block_profile profile(f, *dt);
+
   /* Record for each BB a boolean whether that block was executed */
   block_to_val_t      bb_preds;
   /* Record edges in the CFG and whether they were executed.
@@ -851,7 +905,8 @@ flatten_function(Function& f, DominatorTree* dt, PostDominatorTree* pdt) {
   bb_preds[&bb_entry] = true_val;
   auto* entry_term = bb_entry.getTerminator();
   flatten_instruction(entry_term->getIterator(), true_val, entry_term,
-                      edge_preds, edge_preds[&bb_entry], true_val);
+                      edge_preds, edge_preds[&bb_entry], true_val,
+                      spec_reads);
 
   /* Go through all other basic blocks in CFG-compatible order and flatten them
    * into the entry block */
@@ -863,7 +918,8 @@ flatten_function(Function& f, DominatorTree* dt, PostDominatorTree* pdt) {
 
   SmallVector<BasicBlock*, 16> to_delete;
   dac.execute([&](dac_t* dac, BasicBlock* bb) {
-    changes |= flatten_basic_bloc(bb, ip, bb_preds, edge_preds, dt, pdt);
+    changes |= flatten_basic_bloc(bb, ip, bb_preds, edge_preds, dt, pdt,
+                                  profile);
     dac->ready_forward(bb);
     to_delete.emplace_back(bb);
   });
@@ -872,6 +928,425 @@ flatten_function(Function& f, DominatorTree* dt, PostDominatorTree* pdt) {
   return changes;
 }
 
+/***** Condition simplification *****/
+
+typedef unsigned bdd_node_t;
+static const bdd_node_t bdd_false = 0;
+static const bdd_node_t bdd_true  = 1;
+static const bdd_node_t bdd_none  = ~0u;
+
+/**
+ * A reduced ordered binary decision diagram (BDD) over the conditions of
+ * a flattened function.  Two conditions compute the same function if and
+ * only if they are represented by the same node, which makes it cheap to
+ * find equivalent predicates and to check implications between them.
+ *
+ * The number of nodes is limited; operations which would exceed the
+ * limit return bdd_none and the caller treats the result as unknown.
+ */
+class cond_bdd {
+public:
+  explicit cond_bdd(unsigned max_nodes);
+
+  bdd_node_t new_var();
+  bdd_node_t ite(bdd_node_t f, bdd_node_t g, bdd_node_t h);
+  bdd_node_t bdd_not(bdd_node_t f) { return ite(f, bdd_false, bdd_true); }
+  bdd_node_t bdd_and(bdd_node_t f, bdd_node_t g) {
+    return ite(f, g, bdd_false);
+  }
+  bdd_node_t bdd_or(bdd_node_t f, bdd_node_t g) {
+    return ite(f, bdd_true, g);
+  }
+  bdd_node_t bdd_xor(bdd_node_t f, bdd_node_t g) {
+    return ite(f, bdd_not(g), g);
+  }
+  /* Returns true if f implies g, false if it does not or if that is not
+   * known. */
+  bool implies(bdd_node_t f, bdd_node_t g) {
+    return bdd_and(f, bdd_not(g)) == bdd_false;
+  }
+
+private:
+  struct node_info {
+    unsigned   var;
+    bdd_node_t lo;
+    bdd_node_t hi;
+  };
+  typedef std::tuple<unsigned, bdd_node_t, bdd_node_t> node_key_t;
+
+  bdd_node_t make(unsigned var, bdd_node_t lo, bdd_node_t hi);
+  bdd_node_t cofactor(bdd_node_t f, unsigned var, bool val) const {
+    auto& n = m_nodes[f];
+    if( n.var != var )
+      return f;
+    return val ? n.hi : n.lo;
+  }
+
+  unsigned                            m_max_nodes;
+  unsigned                            m_num_vars;
+  std::vector<node_info>              m_nodes;
+  std::map<node_key_t, bdd_node_t>    m_unique;
+  std::map<node_key_t, bdd_node_t>    m_computed;
+};
+
+cond_bdd::cond_bdd(unsigned max_nodes) :
+  m_max_nodes(max_nodes), m_num_vars(0) {
+  /* The terminals order after all variables */
+  auto terminal = std::numeric_limits<unsigned>::max();
+  m_nodes.push_back(node_info{terminal, bdd_false, bdd_false});
+  m_nodes.push_back(node_info{terminal, bdd_true, bdd_true});
+}
+
+bdd_node_t cond_bdd::new_var() {
+  return make(m_num_vars++, bdd_false, bdd_true);
+}
+
+bdd_node_t cond_bdd::make(unsigned var, bdd_node_t lo, bdd_node_t hi) {
+  if( lo == hi )
+    return lo;
+
+  auto key = std::make_tuple(var, lo, hi);
+  auto it = m_unique.find(key);
+  if( it != m_unique.end() )
+    return it->second;
+
+  if( m_nodes.size() >= m_max_nodes )
+    return bdd_none;
+  bdd_node_t res = m_nodes.size();
+  m_nodes.push_back(node_info{var, lo, hi});
+  m_unique.emplace(key, res);
+  return res;
+}
+
+bdd_node_t cond_bdd::ite(bdd_node_t f, bdd_node_t g, bdd_node_t h) {
+  if( (f == bdd_none) || (g == bdd_none) || (h == bdd_none) )
+    return bdd_none;
+
+  /* Terminal cases */
+  if( f == bdd_true )
+    return g;
+  if( f == bdd_false )
+    return h;
+  if( g == h )
+    return g;
+  if( (g == bdd_true) && (h == bdd_false) )
+    return f;
+
+  auto key = std::make_tuple(f, g, h);
+  auto it = m_computed.find(key);
+  if( it != m_computed.end() )
+    return it->second;
+
+  /* Split on the top-most variable and combine the cofactors */
+  unsigned var = std::min(m_nodes[f].var,
+                          std::min(m_nodes[g].var, m_nodes[h].var));
+  auto hi = ite(cofactor(f, var, true), cofactor(g, var, true),
+                cofactor(h, var, true));
+  auto lo = ite(cofactor(f, var, false), cofactor(g, var, false),
+                cofactor(h, var, false));
+  bdd_node_t res = bdd_none;
+  if( (hi != bdd_none) && (lo != bdd_none) )
+    res = make(var, lo, hi);
+
+  /* Keep the cache bounded, too */
+  if( m_computed.size() >= 4 * m_max_nodes )
+    m_computed.clear();
+  m_computed.emplace(key, res);
+  return res;
+}
+
+/**
+ * Simplifies the conditions and multiplexers of a flattened function.
+ *
+ * Every boolean value of the function gets a BDD node.  Boolean
+ * operations and boolean selects are computed from their operands,
+ * equality comparisons against constants from the bits of the compared
+ * value, and everything else becomes a fresh variable.  Comparing the
+ * bits makes the cases of a switch statement mutually exclusive.  With
+ * that:
+ *   - a condition which is constant is replaced by the constant
+ *   - a condition which computes the same function as an earlier value
+ *     is replaced by that value, which shares the common path predicates
+ *   - a select on an arm of a select looks through the inner select if
+ *     the outer condition decides the inner condition
+ *   - a select with identical inputs or with a constant condition is
+ *     replaced by its input, and identical selects are merged
+ */
+class cond_simplifier {
+public:
+  explicit cond_simplifier(Function& f) :
+    m_func(f), m_bdd(max_bdd_nodes) {}
+  bool run();
+
+private:
+  static const unsigned max_bdd_nodes = 1 << 18;
+  static const unsigned max_cmp_bits  = 64;
+
+  bdd_node_t get_node(Value* v);
+  bdd_node_t get_bit(Value* v, unsigned bit);
+  bdd_node_t get_const_eq(Value* v, const APInt& c);
+  bdd_node_t compute_node(Instruction* inst);
+  Value*     select_under(Value* v, bdd_node_t cond);
+  bool       simplify_bool(Instruction* inst);
+  bool       simplify_select(SelectInst* sel);
+  void       replace(Instruction* inst, Value* v);
+
+  typedef std::tuple<bdd_node_t, Value*, Value*> select_key_t;
+
+  Function&                                      m_func;
+  cond_bdd                                       m_bdd;
+  DenseMap<Value*, bdd_node_t>                   m_val_nodes;
+  DenseMap<std::pair<Value*, unsigned>, bdd_node_t> m_bit_nodes;
+  std::map<bdd_node_t, Value*>                   m_node_vals;
+  std::map<select_key_t, SelectInst*>            m_selects;
+  SmallVector<WeakTrackingVH, 32>                m_dead;
+};
+
+/**
+ * Returns the node of a boolean value, creating a fresh variable for
+ * values which have not been seen, yet.
+ */
+bdd_node_t cond_simplifier::get_node(Value* v) {
+  auto* c = dyn_cast<ConstantInt>(v);
+  if( c != nullptr )
+    return c->isOne() ? bdd_true : bdd_false;
+
+  auto it = m_val_nodes.find(v);
+  if( it != m_val_nodes.end() )
+    return it->second;
+
+  auto node = m_bdd.new_var();
+  m_val_nodes[v] = node;
+  if( node != bdd_none )
+    m_node_vals.emplace(node, v);
+  return node;
+}
+
+/**
+ * Returns the node of a single bit of an integer value.  All bits of the
+ * value get their variables at the same time so that they are adjacent
+ * in the variable order.
+ */
+bdd_node_t cond_simplifier::get_bit(Value* v, unsigned bit) {
+  auto it = m_bit_nodes.find(std::make_pair(v, bit));
+  if( it != m_bit_nodes.end() )
+    return it->second;
+
+  unsigned width = v->getType()->getIntegerBitWidth();
+  for( unsigned i = 0; i < width; i++ )
+    m_bit_nodes[std::make_pair(v, i)] = m_bdd.new_var();
+  return m_bit_nodes[std::make_pair(v, bit)];
+}
+
+/**
+ * Returns the node of the condition v == c.
+ */
+bdd_node_t cond_simplifier::get_const_eq(Value* v, const APInt& c) {
+  unsigned width = c.getBitWidth();
+  if( width == 1 )
+    return c.isOneValue() ? get_node(v) : m_bdd.bdd_not(get_node(v));
+
+  bdd_node_t res = bdd_true;
+  for( unsigned i = 0; i < width; i++ ) {
+    auto bit = get_bit(v, i);
+    res = m_bdd.bdd_and(res, c[i] ? bit : m_bdd.bdd_not(bit));
+  }
+  return res;
+}
+
+bdd_node_t cond_simplifier::compute_node(Instruction* inst) {
+  auto* bo = dyn_cast<BinaryOperator>(inst);
+  if( bo != nullptr ) {
+    switch( bo->getOpcode() ) {
+      case Instruction::And:
+        return m_bdd.bdd_and(get_node(bo->getOperand(0)),
+                             get_node(bo->getOperand(1)));
+      case Instruction::Or:
+        return m_bdd.bdd_or(get_node(bo->getOperand(0)),
+                            get_node(bo->getOperand(1)));
+      case Instruction::Xor:
+        return m_bdd.bdd_xor(get_node(bo->getOperand(0)),
+                             get_node(bo->getOperand(1)));
+      default:
+        return get_node(inst);
+    }
+  }
+
+  auto* sel = dyn_cast<SelectInst>(inst);
+  if( sel != nullptr ) {
+    return m_bdd.ite(get_node(sel->getCondition()),
+                     get_node(sel->getTrueValue()),
+                     get_node(sel->getFalseValue()));
+  }
+
+  /* Equality comparisons against a constant; the switch statements turn
+   * into these */
+  auto* cmp = dyn_cast<ICmpInst>(inst);
+  if( (cmp != nullptr) && cmp->isEquality() ) {
+    auto* lhs = cmp->getOperand(0);
+    auto* rhs = dyn_cast<ConstantInt>(cmp->getOperand(1));
+    if( rhs == nullptr ) {
+      rhs = dyn_cast<ConstantInt>(lhs);
+      lhs = cmp->getOperand(1);
+    }
+    if( (rhs != nullptr) && !isa<Constant>(lhs) &&
+        (rhs->getBitWidth() <= max_cmp_bits) ) {
+      auto eq = get_const_eq(lhs, rhs->getValue());
+      if( cmp->getPredicate() == CmpInst::ICMP_EQ )
+        return eq;
+      return m_bdd.bdd_not(eq);
+    }
+  }
+
+  /* Anything else is opaque */
+  return get_node(inst);
+}
+
+/**
+ * Returns the value of v under the assumption that cond holds, looking
+ * through selects whose condition is decided by cond.
+ */
+Value* cond_simplifier::select_under(Value* v, bdd_node_t cond) {
+  while( true ) {
+    auto* sel = dyn_cast<SelectInst>(v);
+    if( (sel == nullptr) ||
+        !sel->getCondition()->getType()->isIntegerTy(1) )
+      return v;
+
+    auto sel_cond = get_node(sel->getCondition());
+    if( m_bdd.implies(cond, sel_cond) )
+      v = sel->getTrueValue();
+    else if( m_bdd.implies(cond, m_bdd.bdd_not(sel_cond)) )
+      v = sel->getFalseValue();
+    else
+      return v;
+  }
+}
+
+bool cond_simplifier::simplify_bool(Instruction* inst) {
+  auto node = compute_node(inst);
+  m_val_nodes[inst] = node;
+  if( node == bdd_none )
+    return false;
+
+  if( (node == bdd_true) || (node == bdd_false) ) {
+    replace(inst, ConstantInt::get(inst->getType(), node == bdd_true));
+    return true;
+  }
+
+  /* Reuse an earlier value which computes the same condition */
+  auto it = m_node_vals.find(node);
+  if( (it != m_node_vals.end()) && (it->second != inst) ) {
+    replace(inst, it->second);
+    return true;
+  }
+  m_node_vals.emplace(node, inst);
+  return false;
+}
+
+bool cond_simplifier::simplify_select(SelectInst* sel) {
+  if( !sel->getCondition()->getType()->isIntegerTy(1) )
+    return false;
+
+  auto cond = get_node(sel->getCondition());
+  auto* tv  = sel->getTrueValue();
+  auto* fv  = sel->getFalseValue();
+  if( cond != bdd_none ) {
+    tv = select_under(tv, cond);
+    fv = select_under(fv, m_bdd.bdd_not(cond));
+  }
+
+  Value* res = nullptr;
+  if( cond == bdd_true )
+    res = tv;
+  else if( cond == bdd_false )
+    res = fv;
+  else if( tv == fv )
+    res = tv;
+  if( res != nullptr ) {
+    replace(sel, res);
+    return true;
+  }
+
+  bool changes = false;
+  if( tv != sel->getTrueValue() ) {
+    sel->setTrueValue(tv);
+    changes = true;
+  }
+  if( fv != sel->getFalseValue() ) {
+    sel->setFalseValue(fv);
+    changes = true;
+  }
+  if( cond == bdd_none )
+    return changes;
+
+  /* Merge with an identical earlier select, which may have the inverted
+   * condition and swapped inputs */
+  auto it = m_selects.find(std::make_tuple(cond, tv, fv));
+  if( it == m_selects.end() )
+    it = m_selects.find(std::make_tuple(m_bdd.bdd_not(cond), fv, tv));
+  if( it != m_selects.end() ) {
+    replace(sel, it->second);
+    return true;
+  }
+  m_selects.emplace(std::make_tuple(cond, tv, fv), sel);
+  return changes;
+}
+
+void cond_simplifier::replace(Instruction* inst, Value* v) {
+  LLVM_DEBUG(dbgs() << "Replacing " << *inst << " with " << *v << '\n');
+  inst->replaceAllUsesWith(v);
+  m_dead.emplace_back(inst);
+}
+
+bool cond_simplifier::run() {
+  /* Values are reused in program order, which requires a single basic
+   * block */
+  if( m_func.size() != 1 )
+    return false;
+
+  bool changes = false;
+  for( auto& inst : m_func.getEntryBlock() ) {
+    if( inst.getType()->isIntegerTy(1) ) {
+      changes |= simplify_bool(&inst);
+      continue;
+    }
+    auto* sel = dyn_cast<SelectInst>(&inst);
+    if( sel != nullptr )
+      changes |= simplify_select(sel);
+  }
+
+  for( auto& vh : m_dead ) {
+    auto* inst = dyn_cast_or_null<Instruction>(vh);
+    if( inst != nullptr )
+      RecursivelyDeleteTriviallyDeadInstructions(inst);
+  }
+  return changes;
+}
+
+/**
+ * Simplify the conditions of the flattened function f and report the
+ * LUT-relevant counts before and after if requested.
+ */
+static bool
+simplify_conditions(Function& f) {
+  lut_stats_t before = {0, 0, 0, 0};
+  if( cond_stats )
+    before = compute_lut_stats(f);
+  cond_simplifier simplifier(f);
+  bool changes = simplifier.run();
+  if( cond_stats ) {
+    lut_stats_t after = compute_lut_stats(f);
+    dbgs() << "Conditions of " << f.getName() << ": bool ops "
+           << before.bool_ops << " -> " << after.bool_ops << ", compares "
+           << before.compares << " -> " << after.compares << ", selects "
+           << before.selects << " -> " << after.selects
+           << ", select bits " << before.select_bits << " -> "
+           << after.select_bits << '\n';
+  }
+  return changes;
+}
+
 void flatten_cfg::get_all_analysis_results(Function& f) {
   dt  = &getAnalysis<DominatorTreeWrapperPass>(f).getDomTree();
   pdt = &getAnalysis<PostDominatorTreeWrapperPass>(f).getPostDomTree();
@@ -890,12 +1365,16 @@ bool flatten_cfg::runOnModule(Module& m) {
     get_all_analysis_results(f);
     changes |= unify_function_returns(f, dt, pdt);
     changes |= flatten_function(f, dt, pdt);
+    if( simplify_conds )
+      changes |= simplify_conditions(f);
   }
   for( auto& kernel : setup.kernels() ) {
     auto& f = *kernel.args().kernel;
     get_all_analysis_results(f);
     changes |= unify_function_returns(f, dt, pdt);
     changes |= flatten_function(f, dt, pdt);
+    if( simplify_conds )
+      changes |= simplify_conditions(f);
   }
   return changes;
 }
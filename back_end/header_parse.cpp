@@ -0,0 +1,390 @@
+/**************************************************************************\
+*//*! \file header_parse.cpp
+** \brief  A pass to read the packet headers once at the kernel entry.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+// The header-parse pass
+// =====================
+//
+// Packet kernels typically read the Ethernet, IP and L4 headers with
+// many small packet reads.  The optreq pass merges reads which are a
+// known distance apart, but reads at offsets which depend on earlier
+// header fields (IP options, VLAN tags, ...) stay separate and each
+// one becomes a packet read tap in its own pipeline stage.
+//
+// This pass determines an upper bound on the bytes accessed by each
+// packet read.  It then replaces all the reads which lie within a
+// header window of at most -header-parse-max-bytes bytes with a single
+// read of the window at the start of the kernel.  The original reads
+// copy their data out of the header buffer instead.  The pipeline pass
+// then creates a single parser stage which reads the bus words of the
+// header once and the header buffer is carried to later stages as
+// application state.
+//
+// Input conditions
+// ----------------
+//
+// The packet kernel accesses the packet using nanotube_packet_read,
+// nanotube_packet_write_masked and the other high-level packet
+// functions.  The pass is intended to run after optreq.
+//
+// Output conditions
+// -----------------
+//
+// Packet reads which are covered by the header window and which are
+// not reachable from any packet modification have been replaced with
+// copies from the header buffer.
+//
+// Theory of operation
+// -------------------
+//
+// The upper bound of the offset and length of each read is computed by
+// following the expression through additions, shifts, multiplications,
+// masks, extensions, selects and PHI nodes.  Known bits are used where
+// the expression cannot be followed, so that masked header fields such
+// as the IPv4 IHL still give a bound.  The header window is the
+// largest end offset of the reads which are covered.  Where that fails,
+// for example for offsets which are induction variables of a bounded
+// loop, the unsigned range computed by scalar evolution is used.  This
+// lets the reads of header-walking loops be served from the header
+// buffer so that the loop can be outlined by the outline-loops pass.
+//
+// Reads which can execute after a packet write, resize or raw data
+// access are left alone since they may observe the modification.  The
+// pass does nothing unless at least two reads can be replaced.
+//
+// The header read zero-fills the buffer past the end of the packet,
+// just like the original reads would.  The length returned by each
+// original read is derived from the length returned by the header
+// read, so short packets behave the same as before.
+
+#define DEBUG_TYPE "header-parse"
+
+#include "Intrinsics.h"
+#include "llvm_common.h"
+#include "llvm_insns.h"
+#include "llvm_pass.h"
+#include "utils.h"
+
+#include "llvm/Analysis/CFG.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/KnownBits.h"
+
+using namespace llvm;
+using namespace nanotube;
+
+///////////////////////////////////////////////////////////////////////////
+
+static llvm::cl::opt<unsigned>
+opt_max_bytes("header-parse-max-bytes",
+              llvm::cl::desc("The maximum size of the header window read"
+                             " by the header-parse pass."),
+              llvm::cl::init(128));
+
+namespace {
+  class header_parse_pass: public llvm::FunctionPass {
+  public:
+    static char ID;
+
+    header_parse_pass();
+    StringRef getPassName() const override {
+      return "Read the packet headers once at the kernel entry";
+    }
+    void getAnalysisUsage(AnalysisUsage &info) const override;
+
+    bool runOnFunction(Function &f) override;
+  };
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+// Determine an upper bound of an unsigned integer value.  Returns
+// false if no bound below 2^64 could be found.
+static bool get_max_value(Value *v, const DataLayout &dl,
+                          uint64_t *result, unsigned depth = 0)
+{
+  auto *ty = dyn_cast<IntegerType>(v->getType());
+  if (ty == nullptr || ty->getBitWidth() > 64)
+    return false;
+
+  if (auto *c = dyn_cast<ConstantInt>(v)) {
+    *result = c->getZExtValue();
+    return true;
+  }
+
+  // Start with the bound given by the known zero bits.
+  KnownBits known = computeKnownBits(v, dl);
+  uint64_t max_val = (~known.Zero).getZExtValue();
+  bool found = (ty->getBitWidth() < 64 || known.Zero.isNegative());
+
+  const unsigned max_depth = 8;
+  if (depth >= max_depth) {
+    *result = max_val;
+    return found;
+  }
+
+  uint64_t a = 0, b = 0;
+  auto *inst = dyn_cast<Instruction>(v);
+  bool have_op = false;
+  uint64_t op_max = 0;
+
+  if (inst != nullptr) {
+    switch (inst->getOpcode()) {
+    case Instruction::Add:
+    case Instruction::Or:
+      if (get_max_value(inst->getOperand(0), dl, &a, depth+1) &&
+          get_max_value(inst->getOperand(1), dl, &b, depth+1) &&
+          a + b >= a) {
+        op_max = a + b;
+        have_op = true;
+      }
+      break;
+
+    case Instruction::Mul:
+      if (get_max_value(inst->getOperand(0), dl, &a, depth+1) &&
+          get_max_value(inst->getOperand(1), dl, &b, depth+1) &&
+          (a == 0 || b <= UINT64_MAX / a)) {
+        op_max = a * b;
+        have_op = true;
+      }
+      break;
+
+    case Instruction::Shl: {
+      auto *amount = dyn_cast<ConstantInt>(inst->getOperand(1));
+      if (amount != nullptr && amount->getZExtValue() < 64 &&
+          get_max_value(inst->getOperand(0), dl, &a, depth+1)) {
+        uint64_t shift = amount->getZExtValue();
+        if ((a << shift) >> shift == a) {
+          op_max = a << shift;
+          have_op = true;
+        }
+      }
+      break;
+    }
+
+    case Instruction::LShr:
+      if (get_max_value(inst->getOperand(0), dl, &a, depth+1)) {
+        op_max = a;
+        have_op = true;
+      }
+      break;
+
+    case Instruction::And:
+      if (get_max_value(inst->getOperand(0), dl, &a, depth+1)) {
+        op_max = a;
+        have_op = true;
+      }
+      if (get_max_value(inst->getOperand(1), dl, &b, depth+1)) {
+        op_max = (have_op ? std::min(a, b) : b);
+        have_op = true;
+      }
+      break;
+
+    case Instruction::ZExt:
+    case Instruction::Trunc:
+      have_op = get_max_value(inst->getOperand(0), dl, &op_max, depth+1);
+      break;
+
+    case Instruction::Select:
+      if (get_max_value(inst->getOperand(1), dl, &a, depth+1) &&
+          get_max_value(inst->getOperand(2), dl, &b, depth+1)) {
+        op_max = std::max(a, b);
+        have_op = true;
+      }
+      break;
+
+    case Instruction::PHI: {
+      auto *phi = cast<PHINode>(inst);
+      have_op = true;
+      for (Value *in: phi->incoming_values()) {
+        if (!get_max_value(in, dl, &a, depth+1)) {
+          have_op = false;
+          break;
+        }
+        op_max = std::max(op_max, a);
+      }
+      break;
+    }
+
+    default:
+      break;
+    }
+  }
+
+  if (have_op) {
+    max_val = (found ? std::min(max_val, op_max) : op_max);
+    found = true;
+  }
+
+  *result = max_val;
+  return found;
+}
+
+// Determine an upper bound of an unsigned integer value, falling back
+// to scalar evolution if the value cannot be followed.
+static bool get_max_value(Value *v, const DataLayout &dl,
+                          ScalarEvolution &se, uint64_t *result)
+{
+  if (get_max_value(v, dl, result))
+    return true;
+
+  if (!se.isSCEVable(v->getType()))
+    return false;
+  APInt max_val = se.getUnsignedRangeMax(se.getSCEV(v));
+  if (max_val.getActiveBits() > 64)
+    return false;
+  *result = max_val.getZExtValue();
+  return true;
+}
+
+// Determine whether an instruction may modify the packet or expose its
+// contents to direct memory accesses.
+static bool is_packet_modifier(Instruction *inst)
+{
+  switch (get_intrinsic(inst)) {
+  case Intrinsics::packet_write:
+  case Intrinsics::packet_write_masked:
+  case Intrinsics::packet_edit:
+  case Intrinsics::packet_data:
+  case Intrinsics::packet_end:
+  case Intrinsics::packet_resize:
+  case Intrinsics::packet_resize_ingress:
+  case Intrinsics::packet_resize_egress:
+    return true;
+  default:
+    return false;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+char header_parse_pass::ID;
+
+header_parse_pass::header_parse_pass():
+  FunctionPass(ID)
+{
+}
+
+void header_parse_pass::getAnalysisUsage(AnalysisUsage &info) const
+{
+  info.addRequired<DominatorTreeWrapperPass>();
+  info.addRequired<LoopInfoWrapperPass>();
+  info.addRequired<ScalarEvolutionWrapperPass>();
+}
+
+bool header_parse_pass::runOnFunction(Function &f)
+{
+  if (f.empty() || !is_nt_packet_kernel(f))
+    return false;
+
+  auto &dt = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+  auto &li = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+  auto &se = getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+  const DataLayout &dl = f.getParent()->getDataLayout();
+  Value *packet = f.arg_begin() + KERNEL_PACKET_ARG;
+
+  // Collect the packet reads and the modifications.
+  std::vector<Instruction *> reads;
+  std::vector<Instruction *> modifiers;
+  for (auto &inst: instructions(f)) {
+    if (get_intrinsic(&inst) == Intrinsics::packet_read)
+      reads.push_back(&inst);
+    else if (is_packet_modifier(&inst))
+      modifiers.push_back(&inst);
+  }
+
+  // Select the reads which can be served from the header buffer.
+  std::vector<Instruction *> selected;
+  uint64_t window = 0;
+  for (auto *inst: reads) {
+    packet_read_args pra(inst);
+    if (pra.packet != packet)
+      continue;
+
+    uint64_t max_offset, max_length;
+    if (!get_max_value(pra.offset, dl, se, &max_offset) ||
+        !get_max_value(pra.length, dl, se, &max_length) ||
+        max_offset > opt_max_bytes ||
+        max_length > opt_max_bytes - max_offset) {
+      LLVM_DEBUG(dbgs() << "Unbounded read " << *inst << '\n');
+      continue;
+    }
+
+    bool after_modifier = false;
+    for (auto *mod: modifiers) {
+      if (isPotentiallyReachable(mod, inst, &dt, &li)) {
+        after_modifier = true;
+        break;
+      }
+    }
+    if (after_modifier) {
+      LLVM_DEBUG(dbgs() << "Read after modification " << *inst << '\n');
+      continue;
+    }
+
+    LLVM_DEBUG(dbgs() << "Selected read " << *inst << " ending before "
+                      << (max_offset + max_length) << '\n');
+    selected.push_back(inst);
+    window = std::max(window, max_offset + max_length);
+  }
+
+  if (selected.size() < 2 || window == 0)
+    return false;
+
+  // Read the header window at the start of the kernel.
+  IRBuilder<> ir(&*f.getEntryBlock().getFirstInsertionPt());
+  auto *buffer = ir.CreateAlloca(ir.getInt8Ty(), ir.getInt32(window),
+                                 "header_buf");
+  auto *nt_packet_read = create_nt_packet_read(*f.getParent());
+  Value *args[] = { packet, buffer, ir.getInt64(0), ir.getInt64(window) };
+  auto *header_len = ir.CreateCall(nt_packet_read, args, "header_len");
+  LLVM_DEBUG(dbgs() << "Header read: " << *header_len << '\n');
+
+  // Replace each read with a copy out of the header buffer.
+  for (auto *inst: selected) {
+    packet_read_args pra(inst);
+    ir.SetInsertPoint(inst);
+
+    auto *offset = ir.CreateZExtOrTrunc(pra.offset, ir.getInt64Ty());
+    auto *length = ir.CreateZExtOrTrunc(pra.length, ir.getInt64Ty());
+    auto *buf_gep = ir.CreateInBoundsGEP(ir.getInt8Ty(), buffer, offset);
+    auto *memcpy = ir.CreateMemCpy(pra.data_out, 1, buf_gep, 1, length);
+    LLVM_DEBUG(dbgs() << "Replacing " << *inst << " with\n"
+                      << *buf_gep << '\n' << *memcpy << '\n');
+
+    if (!inst->use_empty()) {
+      // The result is the number of bytes of the header read which
+      // overlap this read.
+      auto *rel = ir.CreateSub(header_len, offset);
+      auto *neg = ir.CreateICmpSLT(rel, ir.getInt64(0));
+      rel = ir.CreateSelect(neg, ir.getInt64(0), rel);
+      auto *over = ir.CreateICmpSGT(rel, length);
+      rel = ir.CreateSelect(over, length, rel);
+      inst->replaceAllUsesWith(ir.CreateZExtOrTrunc(rel, inst->getType()));
+    }
+    inst->eraseFromParent();
+  }
+
+  return true;
+}
+
+static RegisterPass<header_parse_pass>
+register_pass("header-parse", "Read the packet headers once at the kernel"
+              " entry",
+              false,
+              false
+  );
+
+///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,646 @@
+/**************************************************************************\
+*//*! \file loop_feedback.cpp
+** \brief  A pass to turn outlined loops into iterative pipeline stages.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+// The loop-feedback pass
+// ======================
+//
+// The outline-loops pass moves bounded loops out of the packet kernel
+// so that the pipeline pass sees a call instead of a loop.  This pass
+// runs after the pipeline pass and implements each such call inside a
+// pipeline stage as an iterative stage.  The stage executes one loop
+// iteration per invocation.  At the end of an iteration which does not
+// leave the loop, the stage writes the loop state to a feedback
+// channel and returns.  On the next invocation, the stage reads the
+// state back from the feedback channel and resumes at the loop header
+// instead of accepting a new packet word.
+//
+//                +--------------------+
+//   in --------> |                    | --------> out
+//                |  stage with loop   |
+//          +---> |                    | ---+
+//          |     +--------------------+    |
+//          +------- <func>_loop<N> --------+
+//
+// A packet word which executes a loop with N iterations occupies the
+// stage for N invocations.  The maximum number of extra invocations is
+// recorded in the nanotube_loop_max_trips attribute of the thread
+// function and the static performance report uses it to estimate the
+// throughput as a function of the trip count.  The -loop-feedback-stats
+// option prints the same information.
+//
+// Input conditions
+// ----------------
+//
+// The pipeline pass has created the thread functions and the setup
+// function.  The only loops in the thread functions are inside calls to
+// functions created by the outline-loops pass.
+//
+// Output conditions
+// -----------------
+//
+// The thread functions and the outlined loop functions are loop-free.
+// Each converted loop has a feedback channel which is added to the
+// context of the thread as a read port and a write port.  The channel
+// IDs follow the highest channel ID the context already uses.
+//
+// Theory of operation
+// -------------------
+//
+// The call to the loop function is inlined.  The resume path enters
+// the loop header from a new entry block, so every value which is
+// defined before the loop and used by the loop or the code after it is
+// demoted to a stack slot, as are the PHI nodes of the loop header.
+// Address computations on the stack allocations are moved to the new
+// entry block instead.  Other pointers are replaced by their offset
+// from the stack allocation, global or argument they point into, and
+// recomputed where the loop uses them.  The stack allocations used by
+// the loop and the code after it form the loop state.
+//
+// The new entry block tries to read the loop state from the feedback
+// channel.  If that succeeds, the state is copied into the stack
+// allocations and control continues at the loop header.  Otherwise,
+// control continues at the original entry block.  The back edges of
+// the loop are redirected to a block which copies the loop state to
+// the feedback channel and returns.
+
+#define DEBUG_TYPE "loop-feedback"
+
+#include "Intrinsics.h"
+#include "llvm_common.h"
+#include "llvm_insns.h"
+#include "llvm_pass.h"
+#include "utils.h"
+
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+using namespace llvm;
+using namespace nanotube;
+
+///////////////////////////////////////////////////////////////////////////
+
+static cl::opt<bool>
+opt_stats("loop-feedback-stats",
+          cl::desc("Print the iteration bound and the resulting throughput"
+                   " of each iterative stage."));
+
+// The depth of each feedback channel.  One element is enough since at
+// most one iteration is in flight.
+static const unsigned feedback_channel_depth = 1;
+
+namespace {
+  class loop_feedback_pass: public llvm::ModulePass {
+  public:
+    static char ID;
+
+    loop_feedback_pass();
+    StringRef getPassName() const override {
+      return "Turn outlined loops into iterative pipeline stages";
+    }
+
+    bool runOnModule(Module &m) override;
+  };
+
+  // A loop which has been converted.
+  struct feedback_loop {
+    nanotube_channel_id_t read_id;
+    nanotube_channel_id_t write_id;
+    uint64_t state_size;
+    unsigned max_trips;
+  };
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+// Collect the blocks which are reachable from the given block.
+static void get_reachable(BasicBlock *start,
+                          SmallPtrSetImpl<BasicBlock *> &reachable)
+{
+  SmallVector<BasicBlock *, 16> todo { start };
+  reachable.insert(start);
+  while (!todo.empty()) {
+    BasicBlock *bb = todo.pop_back_val();
+    for (BasicBlock *succ: successors(bb)) {
+      if (reachable.insert(succ).second)
+        todo.push_back(succ);
+    }
+  }
+}
+
+// Move the address computations on allocas which are outside the
+// region into the entry block.  They can then be recomputed on the
+// resume path.
+static void hoist_alloca_addresses(Function &f, BasicBlock *entry,
+                                   SmallPtrSetImpl<BasicBlock *> &region)
+{
+  bool changes = true;
+  while (changes) {
+    changes = false;
+    for (BasicBlock &bb: f) {
+      if (&bb == entry || region.count(&bb) != 0)
+        continue;
+      for (auto it = bb.begin(); it != bb.end(); ) {
+        Instruction *inst = &*(it++);
+        if (!isa<GetElementPtrInst>(inst) && !isa<BitCastInst>(inst))
+          continue;
+
+        bool in_entry = true;
+        for (Value *op: inst->operands()) {
+          auto *op_inst = dyn_cast<Instruction>(op);
+          if (!isa<Constant>(op) &&
+              (op_inst == nullptr || op_inst->getParent() != entry))
+            in_entry = false;
+        }
+        if (!in_entry)
+          continue;
+
+        LLVM_DEBUG(dbgs() << "Hoisting " << *inst << '\n');
+        inst->moveBefore(entry->getTerminator());
+        changes = true;
+      }
+    }
+  }
+}
+
+// Determine whether the region uses an alloca, either directly or
+// through address computations in the entry block.
+static bool region_uses(Instruction *inst, BasicBlock *entry,
+                        SmallPtrSetImpl<BasicBlock *> &region)
+{
+  for (User *user: inst->users()) {
+    auto *user_inst = cast<Instruction>(user);
+    if (region.count(user_inst->getParent()) != 0)
+      return true;
+    if (user_inst->getParent() == entry &&
+        region_uses(user_inst, entry, region))
+      return true;
+  }
+  return false;
+}
+
+// Get the object which a pointer points into, if that object is
+// available on the resume path.  That is the case for arguments,
+// globals and static allocations in the entry block.
+static Value *get_pointer_base(Value *ptr, BasicBlock *entry,
+                               const DataLayout &dl)
+{
+  SmallVector<Value *, 4> objs;
+  GetUnderlyingObjects(ptr, objs, dl);
+  if (objs.size() != 1)
+    return nullptr;
+
+  Value *obj = objs[0];
+  if (isa<Argument>(obj) || isa<GlobalValue>(obj))
+    return obj;
+  auto *alloca = dyn_cast<AllocaInst>(obj);
+  if (alloca != nullptr && alloca->getParent() == entry)
+    return alloca;
+  return nullptr;
+}
+
+// Get the byte offset of a pointer from its base.  Code is inserted
+// before the given instruction if the offset is not constant.
+static Value *get_pointer_offset(Value *ptr, Value *base,
+                                 Instruction *insert_before,
+                                 const DataLayout &dl)
+{
+  IRBuilder<> ir(insert_before);
+  int64_t offset = 0;
+  if (GetPointerBaseWithConstantOffset(ptr, offset, dl) == base)
+    return ir.getInt64(offset);
+
+  auto *ptr_int = ir.CreatePtrToInt(ptr, ir.getInt64Ty());
+  auto *base_int = ir.CreatePtrToInt(base, ir.getInt64Ty());
+  return ir.CreateSub(ptr_int, base_int, ptr->getName() + ".offset");
+}
+
+// Compute a pointer from its base and byte offset.
+static Value *make_pointer(Value *base, Value *offset, Type *ty,
+                           Instruction *insert_before, const Twine &name)
+{
+  IRBuilder<> ir(insert_before);
+  auto *base_p = ir.CreateBitCast(base, ir.getInt8PtrTy());
+  auto *addr = ir.CreateInBoundsGEP(ir.getInt8Ty(), base_p, offset);
+  return ir.CreateBitCast(addr, ty, name);
+}
+
+// Replace a pointer PHI node of the loop header with a PHI node of the
+// offset from its base.
+static void rematerialise_pointer_phi(PHINode *phi, BasicBlock *entry,
+                                      const DataLayout &dl)
+{
+  Function &f = *phi->getFunction();
+  Value *base = get_pointer_base(phi, entry, dl);
+  if (base == nullptr)
+    report_fatal_errorv("Loop-carried pointer {0} in function {1} does"
+                        " not point into a stack allocation, a global or"
+                        " an argument.", *phi, f.getName());
+
+  auto *int64_ty = Type::getInt64Ty(phi->getContext());
+  auto *offset = PHINode::Create(int64_ty, phi->getNumIncomingValues(),
+                                 phi->getName() + ".offset", phi);
+  for (unsigned i=0; i<phi->getNumIncomingValues(); i++) {
+    BasicBlock *pred = phi->getIncomingBlock(i);
+    offset->addIncoming(
+      get_pointer_offset(phi->getIncomingValue(i), base,
+                         pred->getTerminator(), dl),
+      pred);
+  }
+
+  auto *ptr = make_pointer(base, offset, phi->getType(),
+                           phi->getParent()->getFirstNonPHI(),
+                           phi->getName());
+  LLVM_DEBUG(dbgs() << "Replacing " << *phi << " with offset " << *offset
+                    << '\n');
+  phi->replaceAllUsesWith(ptr);
+  phi->eraseFromParent();
+}
+
+// Replace the uses of a pointer which is live into the region with a
+// pointer computed from its base and offset.  Returns the offset, which
+// is live into the region instead of the pointer.
+static Value *rematerialise_pointer(Instruction *inst, BasicBlock *entry,
+                                    SmallPtrSetImpl<BasicBlock *> &region,
+                                    const DataLayout &dl)
+{
+  Function &f = *inst->getFunction();
+  Value *base = get_pointer_base(inst, entry, dl);
+  if (base == nullptr)
+    report_fatal_errorv("Pointer {0} which is live into the loop of"
+                        " function {1} does not point into a stack"
+                        " allocation, a global or an argument.",
+                        *inst, f.getName());
+
+  Instruction *after = ( isa<PHINode>(inst)
+                         ? inst->getParent()->getFirstNonPHI()
+                         : inst->getNextNode() );
+  Value *offset = get_pointer_offset(inst, base, after, dl);
+
+  for (Use &use: make_early_inc_range(inst->uses())) {
+    auto *user = cast<Instruction>(use.getUser());
+    if (region.count(user->getParent()) == 0)
+      continue;
+    Instruction *insert_before = user;
+    if (auto *phi = dyn_cast<PHINode>(user))
+      insert_before = phi->getIncomingBlock(use)->getTerminator();
+    use.set(make_pointer(base, offset, inst->getType(), insert_before,
+                         inst->getName()));
+  }
+  LLVM_DEBUG(dbgs() << "Rematerialising " << *inst << " from " << *base
+                    << " and " << *offset << '\n');
+  return offset;
+}
+
+// Convert the loop of the function into an iterative loop with a
+// feedback channel.
+static void make_iterative(Function &f, Loop *loop, feedback_loop &fl)
+{
+  Module &m = *f.getParent();
+  LLVMContext &c = m.getContext();
+  const DataLayout &dl = m.getDataLayout();
+  BasicBlock *header = loop->getHeader();
+  BasicBlock *old_entry = &f.getEntryBlock();
+
+  SmallVector<BasicBlock *, 4> latches;
+  loop->getLoopLatches(latches);
+
+  SmallPtrSet<BasicBlock *, 32> region;
+  get_reachable(header, region);
+  if (region.count(old_entry) != 0)
+    report_fatal_errorv("The entry block of function {0} is inside a"
+                        " loop.", f.getName());
+
+  // Create the new entry block and move the allocas into it.  The
+  // allocas are checked for a constant size, since isStaticAlloca() no
+  // longer holds once the old entry block is not the entry block.
+  auto *entry = BasicBlock::Create(c, "loop_dispatch", &f, old_entry);
+  BranchInst::Create(old_entry, entry);
+  for (auto it = old_entry->begin(); it != old_entry->end(); ) {
+    auto *alloca = dyn_cast<AllocaInst>(&*(it++));
+    if (alloca != nullptr && isa<ConstantInt>(alloca->getArraySize()))
+      alloca->moveBefore(entry->getTerminator());
+  }
+  hoist_alloca_addresses(f, entry, region);
+
+  // Demote the loop-carried values and the values which are live into
+  // the region to the stack.  Pointers cannot be part of the loop
+  // state, because stack addresses differ between invocations and HLS
+  // cannot pass pointers through a channel.  Only their offsets are
+  // carried and the pointers are recomputed in the region.
+  SmallVector<PHINode *, 8> phis;
+  for (PHINode &phi: header->phis())
+    phis.push_back(&phi);
+  for (PHINode *phi: phis) {
+    if (phi->getType()->isPointerTy())
+      rematerialise_pointer_phi(phi, entry, dl);
+  }
+  phis.clear();
+  for (PHINode &phi: header->phis())
+    phis.push_back(&phi);
+  for (PHINode *phi: phis)
+    DemotePHIToStack(phi, entry->getTerminator());
+
+  SetVector<AllocaInst *> state;
+  SmallVector<Instruction *, 16> live_in;
+  for (BasicBlock &bb: f) {
+    if (&bb == entry || region.count(&bb) != 0)
+      continue;
+    for (Instruction &inst: bb) {
+      if (region_uses(&inst, entry, region))
+        live_in.push_back(&inst);
+    }
+  }
+  SmallVector<Instruction *, 16> demote;
+  for (Instruction *inst: live_in) {
+    if (!inst->getType()->isPointerTy()) {
+      demote.push_back(inst);
+      continue;
+    }
+    Value *offset = rematerialise_pointer(inst, entry, region, dl);
+    if (auto *offset_inst = dyn_cast<Instruction>(offset))
+      demote.push_back(offset_inst);
+  }
+  for (Instruction *inst: demote) {
+    LLVM_DEBUG(dbgs() << "Demoting " << *inst << '\n');
+    DemoteRegToStack(*inst, false, entry->getTerminator());
+  }
+
+  // Collect the loop state.
+  for (Instruction &inst: *entry) {
+    auto *alloca = dyn_cast<AllocaInst>(&inst);
+    if (alloca != nullptr && region_uses(alloca, entry, region))
+      state.insert(alloca);
+  }
+
+  std::vector<uint64_t> offsets;
+  fl.state_size = 0;
+  for (AllocaInst *alloca: state) {
+    auto *count = cast<ConstantInt>(alloca->getArraySize());
+    uint64_t size = ( dl.getTypeAllocSize(alloca->getAllocatedType()) *
+                      count->getZExtValue() );
+    LLVM_DEBUG(dbgs() << "State at offset " << fl.state_size << ": "
+                      << *alloca << '\n');
+    offsets.push_back(fl.state_size);
+    fl.state_size += size;
+  }
+  if (fl.state_size == 0)
+    fl.state_size = 1;
+
+  // Read the state from the feedback channel on entry.
+  entry->getTerminator()->eraseFromParent();
+  IRBuilder<> ir(entry);
+  auto *buf_ty = ArrayType::get(ir.getInt8Ty(), fl.state_size);
+  auto *buf = ir.CreateAlloca(buf_ty, nullptr, "loop_state");
+  auto *buf_p = ir.CreateBitCast(buf, ir.getInt8PtrTy());
+  auto *resume = BasicBlock::Create(c, "loop_resume", &f, old_entry);
+
+  Value *ctx = f.arg_begin() + 0;
+  auto *try_read_f = create_nt_channel_try_read(m);
+  auto *try_read_ty = cast<FunctionType>(
+    cast<PointerType>(try_read_f->getType())->getElementType());
+  Value *read_args[] = {
+    ctx,
+    ConstantInt::get(get_nt_channel_id_ty(m), fl.read_id),
+    buf_p,
+    ir.getInt64(fl.state_size),
+  };
+  auto *read = ir.CreateCall(try_read_ty, try_read_f, read_args,
+                             "read_loop_state");
+  auto *have_state = ir.CreateICmpNE(
+    read, ConstantInt::get(read->getType(), 0), "have_loop_state");
+  ir.CreateCondBr(have_state, resume, old_entry);
+
+  // Restore the state and resume at the loop header.
+  ir.SetInsertPoint(resume);
+  for (unsigned i=0; i<state.size(); i++) {
+    auto *alloca = state[i];
+    auto *src = ir.CreateConstInBoundsGEP1_64(buf_p, offsets[i]);
+    auto *dst = ir.CreateBitCast(alloca, ir.getInt8PtrTy());
+    uint64_t size = ( (i+1 < state.size() ? offsets[i+1] : fl.state_size)
+                      - offsets[i] );
+    ir.CreateMemCpy(dst, 1, src, 1, size);
+  }
+  ir.CreateBr(header);
+
+  // Save the state at the end of each iteration.
+  auto *iterate = BasicBlock::Create(c, "loop_iterate", &f);
+  ir.SetInsertPoint(iterate);
+  for (unsigned i=0; i<state.size(); i++) {
+    auto *alloca = state[i];
+    auto *dst = ir.CreateConstInBoundsGEP1_64(buf_p, offsets[i]);
+    auto *src = ir.CreateBitCast(alloca, ir.getInt8PtrTy());
+    uint64_t size = ( (i+1 < state.size() ? offsets[i+1] : fl.state_size)
+                      - offsets[i] );
+    ir.CreateMemCpy(dst, 1, src, 1, size);
+  }
+  auto *write_f = create_nt_channel_write(m);
+  auto *write_ty = cast<FunctionType>(
+    cast<PointerType>(write_f->getType())->getElementType());
+  Value *write_args[] = {
+    ctx,
+    ConstantInt::get(get_nt_channel_id_ty(m), fl.write_id),
+    buf_p,
+    ir.getInt64(fl.state_size),
+  };
+  ir.CreateCall(write_ty, write_f, write_args);
+  ir.CreateRetVoid();
+
+  for (BasicBlock *latch: latches)
+    latch->getTerminator()->replaceUsesOfWith(header, iterate);
+}
+
+// Determine the highest channel ID used by a context.
+static nanotube_channel_id_t get_max_channel_id(Value *ctx)
+{
+  nanotube_channel_id_t max_id = 0;
+  for (User *user: ctx->users()) {
+    auto *call = dyn_cast<CallInst>(user);
+    if (call == nullptr ||
+        get_intrinsic(call) != Intrinsics::context_add_channel)
+      continue;
+    context_add_channel_args args(call);
+    auto *id = dyn_cast<ConstantInt>(args.channel_id);
+    if (id == nullptr)
+      report_fatal_errorv("Non-constant channel ID in {0}.", *call);
+    max_id = std::max(max_id, nanotube_channel_id_t(id->getZExtValue()));
+  }
+  return max_id;
+}
+
+// Add the feedback channels to each context which runs the thread
+// function.
+static void add_feedback_channels(Function &f,
+                                  const std::vector<CallInst *> &threads,
+                                  const std::vector<feedback_loop> &loops)
+{
+  Module &m = *f.getParent();
+  auto *create_f = create_nt_channel_create(m);
+  auto *create_ty = get_nt_channel_create_ty(m);
+  auto *add_f = create_nt_context_add_channel(m);
+  auto *add_ty = get_nt_context_add_channel_ty(m);
+
+  for (CallInst *thread: threads) {
+    thread_create_args args(thread);
+    IRBuilder<> ir(thread);
+    for (unsigned i=0; i<loops.size(); i++) {
+      auto &fl = loops[i];
+      std::string name = (f.getName() + "_loop" + Twine(i)).str();
+      Value *create_args[] = {
+        ir.CreateGlobalStringPtr(name),
+        ir.getInt64(fl.state_size),
+        ir.getInt64(feedback_channel_depth),
+      };
+      auto *channel = ir.CreateCall(create_ty, create_f, create_args, name);
+
+      Value *read_args[] = {
+        args.context,
+        ConstantInt::get(get_nt_channel_id_ty(m), fl.read_id),
+        channel,
+        ConstantInt::get(get_nt_channel_flags_ty(m), NANOTUBE_CHANNEL_READ),
+      };
+      ir.CreateCall(add_ty, add_f, read_args);
+
+      Value *write_args[] = {
+        args.context,
+        ConstantInt::get(get_nt_channel_id_ty(m), fl.write_id),
+        channel,
+        ConstantInt::get(get_nt_channel_flags_ty(m), NANOTUBE_CHANNEL_WRITE),
+      };
+      ir.CreateCall(add_ty, add_f, write_args);
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+char loop_feedback_pass::ID;
+
+loop_feedback_pass::loop_feedback_pass():
+  ModulePass(ID)
+{
+}
+
+bool loop_feedback_pass::runOnModule(Module &m)
+{
+  // Find the thread functions which call outlined loops.
+  std::map<Function *, std::vector<CallInst *>> loop_calls;
+  std::vector<Function *> loop_funcs;
+  for (Function &f: m) {
+    if (get_loop_max_trips(f) == 0)
+      continue;
+    loop_funcs.push_back(&f);
+    for (User *user: f.users()) {
+      auto *call = dyn_cast<CallInst>(user);
+      if (call == nullptr || call->getCalledFunction() != &f)
+        report_fatal_errorv("Unexpected use of loop function {0}.",
+                            f.getName());
+      loop_calls[call->getFunction()].push_back(call);
+    }
+  }
+  if (loop_calls.empty())
+    return false;
+
+  std::map<Function *, std::vector<CallInst *>> threads;
+  auto *thread_create_f = m.getFunction("nanotube_thread_create");
+  if (thread_create_f != nullptr) {
+    for (User *user: thread_create_f->users()) {
+      auto *call = dyn_cast<CallInst>(user);
+      if (call == nullptr)
+        continue;
+      thread_create_args args(call);
+      threads[args.func].push_back(call);
+    }
+  }
+
+  for (auto &func_calls: loop_calls) {
+    Function &f = *func_calls.first;
+    auto thread_it = threads.find(&f);
+    if (thread_it == threads.end())
+      report_fatal_errorv("Function {0} calls an outlined loop but is"
+                          " not a thread function.  Please run the"
+                          " pipeline pass first.", f.getName());
+
+    nanotube_channel_id_t next_id = 0;
+    for (CallInst *thread: thread_it->second) {
+      thread_create_args args(thread);
+      next_id = std::max(next_id, get_max_channel_id(args.context) + 1);
+    }
+
+    std::vector<feedback_loop> loops;
+    unsigned total_trips = 0;
+    for (CallInst *call: func_calls.second) {
+      feedback_loop fl;
+      fl.read_id = next_id++;
+      fl.write_id = next_id++;
+      fl.max_trips = get_loop_max_trips(*call->getCalledFunction());
+
+      InlineFunctionInfo ifi;
+      if (!InlineFunction(call, ifi))
+        report_fatal_errorv("Failed to inline the loop in function {0}.",
+                            f.getName());
+
+      DominatorTree dt(f);
+      LoopInfo li(dt);
+      if (li.empty())
+        report_fatal_errorv("Lost the loop in function {0}.", f.getName());
+      Loop *loop = *li.begin();
+      if (std::next(li.begin()) != li.end() ||
+          !loop->getSubLoops().empty())
+        report_fatal_errorv("Function {0} contains more than one loop.",
+                            f.getName());
+
+      make_iterative(f, loop, fl);
+      loops.push_back(fl);
+      total_trips += fl.max_trips;
+
+      if (opt_stats) {
+        errs() << "Loop " << (loops.size()-1) << " of " << f.getName()
+               << ": at most " << fl.max_trips << " iterations, "
+               << fl.state_size << " bytes of loop state.\n";
+      }
+    }
+
+    f.addFnAttr(LOOP_MAX_TRIPS_ATTR, utostr(total_trips));
+    add_feedback_channels(f, thread_it->second, loops);
+
+    if (opt_stats) {
+      errs() << "Stage " << f.getName() << ": up to " << total_trips
+             << " invocations per packet word, throughput 1/"
+             << total_trips << " word per invocation in the worst"
+             << " case.\n";
+    }
+  }
+
+  for (Function *f: loop_funcs) {
+    if (f->use_empty())
+      f->eraseFromParent();
+  }
+
+  return true;
+}
+
+static RegisterPass<loop_feedback_pass>
+register_pass("loop-feedback", "Turn outlined loops into iterative"
+              " pipeline stages",
+              false,
+              false
+  );
+
+///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,245 @@
+/**************************************************************************\
+*//*! \file loop_outline.cpp
+** \brief  A pass to move bounded loops out of packet kernels.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+// The outline-loops pass
+// ======================
+//
+// The converge and pipeline passes require the packet kernel to be
+// free of loops.  Loops with a static trip bound can be fully
+// unrolled, but that replicates the loop body for every iteration,
+// which is expensive for loops over IP options, TLVs or segment lists.
+//
+// This pass moves each such loop into a separate function, so that
+// the later passes only see a call.  The loop-feedback pass then turns
+// the call into an iterative pipeline stage which executes one
+// iteration per invocation and recirculates the loop state through a
+// feedback channel.
+//
+// Input conditions
+// ----------------
+//
+// The loops have not been unrolled.  See the
+// -enable-loop-unroll-max-trips option of the enable-loop-unroll pass.
+// The loops do not contain map or packet accesses.  Packet reads of a
+// header-walking loop can be moved out of the loop by the header-parse
+// pass.
+//
+// Output conditions
+// -----------------
+//
+// Each top-level loop of a packet kernel which has a static trip bound
+// and no nested loops has been replaced by a call to a new function.
+// The function is marked noinline and has the nanotube_loop_max_trips
+// attribute which holds the trip bound.
+//
+// Theory of operation
+// -------------------
+//
+// The pass uses the LLVM code extractor.  The trip bound is the
+// constant maximum trip count computed by scalar evolution.  The loop
+// state which lives in memory is passed to the new function as
+// pointers to the allocas of the kernel.  If the function only
+// accesses memory through its arguments, it is marked argmemonly so
+// that the liveness analysis of the pipeline pass can determine which
+// stack locations it uses.
+
+#define DEBUG_TYPE "outline-loops"
+
+#include "Intrinsics.h"
+#include "llvm_common.h"
+#include "llvm_insns.h"
+#include "llvm_pass.h"
+#include "utils.h"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Transforms/Utils.h"
+#include "llvm/Transforms/Utils/CodeExtractor.h"
+
+using namespace llvm;
+using namespace nanotube;
+
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+  class loop_outline_pass: public llvm::FunctionPass {
+  public:
+    static char ID;
+
+    loop_outline_pass();
+    StringRef getPassName() const override {
+      return "Move bounded loops out of packet kernels";
+    }
+    void getAnalysisUsage(AnalysisUsage &info) const override;
+
+    bool runOnFunction(Function &f) override;
+  };
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+// Determine whether a pointer refers to memory passed to the function.
+static bool is_arg_memory(Value *ptr, const DataLayout &dl)
+{
+  return isa<Argument>(GetUnderlyingObject(ptr, dl));
+}
+
+// Determine whether a function only accesses memory through its
+// pointer arguments.
+static bool only_accesses_arg_memory(Function &f)
+{
+  const DataLayout &dl = f.getParent()->getDataLayout();
+  for (auto &inst: instructions(f)) {
+    if (!inst.mayReadOrWriteMemory())
+      continue;
+
+    if (auto *ld = dyn_cast<LoadInst>(&inst)) {
+      if (!is_arg_memory(ld->getPointerOperand(), dl))
+        return false;
+      continue;
+    }
+    if (auto *st = dyn_cast<StoreInst>(&inst)) {
+      if (!is_arg_memory(st->getPointerOperand(), dl))
+        return false;
+      continue;
+    }
+    if (auto *mt = dyn_cast<MemTransferInst>(&inst)) {
+      if (!is_arg_memory(mt->getRawDest(), dl) ||
+          !is_arg_memory(mt->getRawSource(), dl))
+        return false;
+      continue;
+    }
+    if (auto *ms = dyn_cast<MemSetInst>(&inst)) {
+      if (!is_arg_memory(ms->getRawDest(), dl))
+        return false;
+      continue;
+    }
+
+    auto *ii = dyn_cast<IntrinsicInst>(&inst);
+    if (ii != nullptr &&
+        (ii->getIntrinsicID() == Intrinsic::lifetime_start ||
+         ii->getIntrinsicID() == Intrinsic::lifetime_end))
+      continue;
+
+    return false;
+  }
+  return true;
+}
+
+// Check that the loop does not contain Nanotube API calls.  Report an
+// error if it does.
+static void check_no_nanotube_calls(Loop *loop, Function &f)
+{
+  for (BasicBlock *bb: loop->blocks()) {
+    for (Instruction &inst: *bb) {
+      auto *call = dyn_cast<CallInst>(&inst);
+      if (call == nullptr)
+        continue;
+      auto intr = get_intrinsic(call);
+      if (intr >= Intrinsics::none && intr <= Intrinsics::llvm_unknown)
+        continue;
+
+      errs() << "ERROR: Bounded loop in function " << f.getName()
+             << " contains the Nanotube call\n" << *call
+             << "\nPacket reads can be moved out of the loop with"
+             << " -header-parse.  Map accesses in loops are not"
+             << " supported.\n";
+      exit(1);
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+char loop_outline_pass::ID;
+
+loop_outline_pass::loop_outline_pass():
+  FunctionPass(ID)
+{
+}
+
+void loop_outline_pass::getAnalysisUsage(AnalysisUsage &info) const
+{
+  info.addRequiredID(LoopSimplifyID);
+  info.addRequired<LoopInfoWrapperPass>();
+  info.addRequired<ScalarEvolutionWrapperPass>();
+}
+
+bool loop_outline_pass::runOnFunction(Function &f)
+{
+  if (f.empty() || !is_nt_packet_kernel(f))
+    return false;
+
+  auto &li = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+  auto &se = getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+
+  // Select the loops before changing the function.  Top-level loops
+  // are disjoint, so extracting one does not affect the others.
+  std::vector<std::pair<Loop *, unsigned>> selected;
+  for (Loop *loop: li) {
+    unsigned trips = se.getSmallConstantMaxTripCount(loop);
+    if (trips == 0 || !loop->getSubLoops().empty()) {
+      LLVM_DEBUG(dbgs() << "Skipping loop " << *loop << " with max trips "
+                        << trips << '\n');
+      continue;
+    }
+    check_no_nanotube_calls(loop, f);
+    selected.emplace_back(loop, trips);
+  }
+
+  unsigned index = 0;
+  for (auto &sel: selected) {
+    Loop *loop = sel.first;
+    unsigned trips = sel.second;
+
+    // The dominator tree is recomputed for each loop since the code
+    // extractor only updates it partially.
+    DominatorTree dt(f);
+    CodeExtractor ce(dt, *loop, false, nullptr, nullptr,
+                     ("loop" + Twine(index++)).str());
+    if (!ce.isEligible()) {
+      errs() << "ERROR: Cannot outline loop " << *loop << " in function "
+             << f.getName() << ".\n";
+      exit(1);
+    }
+
+    Function *loop_func = ce.extractCodeRegion();
+    if (loop_func == nullptr) {
+      errs() << "ERROR: Failed to outline loop " << *loop
+             << " in function " << f.getName() << ".\n";
+      exit(1);
+    }
+
+    loop_func->addFnAttr(Attribute::NoInline);
+    loop_func->addFnAttr(LOOP_MAX_TRIPS_ATTR, utostr(trips));
+    if (only_accesses_arg_memory(*loop_func))
+      loop_func->addFnAttr(Attribute::ArgMemOnly);
+
+    LLVM_DEBUG(dbgs() << "Outlined loop with at most " << trips
+                      << " iterations into " << loop_func->getName()
+                      << '\n');
+  }
+
+  return !selected.empty();
+}
+
+static RegisterPass<loop_outline_pass>
+register_pass("outline-loops", "Move bounded loops out of packet kernels",
+              false,
+              false
+  );
+
+///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,829 @@
+/*******************************************************/
+/*! \file nanotube_compile.cpp
+** \author Neil Turton <neilt@amd.com>
+**  \brief A single-process driver for the Nanotube compiler flow.
+**   \date 2023-03-02
+*//******************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+// The Nanotube compiler driver
+// ============================
+//
+// The scripts/nanotube_build script describes the compilation flow as
+// a sequence of steps.  Running each of those steps as a separate opt
+// invocation means that the bitcode is written and read back between
+// each step and the pass libraries are reloaded each time.  This
+// program runs the same steps inside a single process so that the
+// module stays in memory for the whole flow.  Each step still gets its
+// own legacy pass manager, like each opt invocation does, so that
+// immutable passes such as the alias analyses requested by one step do
+// not affect the passes of the following steps.
+//
+// Each step is a sequence of passes, a link against one of the
+// libnt bitcode libraries or the HLS output.  A step_boundary pass is
+// placed after the passes of each step.  It records the wall time
+// taken by the step, counts the instructions in the module and
+// optionally writes the intermediate bitcode.  The step definitions
+// below must be kept in sync with scripts/nanotube_build.
+//
+// The compile cache
+// -----------------
+//
+// When a cache directory is specified, the output of each step is
+// stored in the cache under a key which identifies the step inputs.
+// The key of the first step is derived from a hash of the input
+// bitcode.  The key of each step is a hash of the key of the previous
+// step, the step name, the passes of the step, the command line
+// options passed to the passes and the version of the pass libraries.
+// The version of a library is a hash of its contents.  Link steps
+// also include the contents of the linked library in the key.
+//
+// Before building the pass pipeline, the driver looks for the last
+// step whose output is in the cache.  The pipeline then starts from
+// that output instead of the input bitcode and only contains the
+// remaining steps.  Bitcode outputs are stored as <key>.bc and HLS
+// output directories are stored as <key>.hls.  Entries are written
+// to a temporary name and renamed so that concurrent builds sharing
+// a cache do not see partial entries.
+
+#include "HLS_Printer.h"
+#include "code_metrics.hpp"
+#include "llvm_common.h"
+#include "llvm_pass.h"
+#include "utils.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Analysis/ScopedNoAliasAA.h"
+#include "llvm/Analysis/TypeBasedAliasAnalysis.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/PluginLoader.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Utils.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace nanotube {
+  namespace cl = llvm::cl;
+};
+using namespace nanotube;
+
+///////////////////////////////////////////////////////////////////////////
+// Command line options.
+
+static cl::opt<std::string>
+opt_input_filename(cl::Positional, cl::desc("<input bitcode>"),
+                   cl::Required);
+
+static cl::opt<std::string>
+opt_output("o", cl::desc("<output bitcode or HLS directory>"),
+           cl::Required);
+
+static cl::opt<bool>
+opt_overwrite("overwrite", cl::desc("Overwrite the HLS output directory."));
+
+static cl::opt<std::string>
+opt_steps("steps", cl::desc("The steps to run, either a comma separated"
+                            " list or a range first:last."),
+          cl::init("mem2req:hls"));
+
+static cl::opt<std::string>
+opt_libnt_dir("libnt-dir", cl::desc("The directory containing the libnt"
+                                    " bitcode libraries."),
+              cl::init(""));
+
+static cl::opt<bool>
+opt_save_intermediates("save-intermediates",
+                       cl::desc("Write the bitcode after each step."));
+
+static cl::opt<std::string>
+opt_intermediate_prefix("intermediate-prefix",
+                        cl::desc("The filename prefix of the intermediate"
+                                 " bitcode files."),
+                        cl::init(""));
+
+static cl::opt<bool>
+opt_write_perf_report("write-perf-report",
+                      cl::desc("Write a static per-stage performance"
+                               " estimate to perf_report.json in the HLS"
+                               " output directory."));
+
+static cl::opt<bool>
+opt_list_steps("list-steps", cl::desc("List the steps and exit."));
+
+static cl::opt<std::string>
+opt_cache_dir("cache-dir", cl::desc("The directory used to cache step"
+                                    " outputs.  Defaults to the value of"
+                                    " NANOTUBE_CACHE_DIR."),
+              cl::init(""));
+
+///////////////////////////////////////////////////////////////////////////
+// The step definitions.
+
+enum step_kind {
+  STEP_OPT,
+  STEP_LINK,
+  STEP_HLS_OUT,
+};
+
+struct step_def {
+  const char *name;
+  step_kind kind;
+  // STEP_OPT: The passes to run, separated by spaces.  The name
+  //   "O2" selects the standard -O2 pipeline.
+  // STEP_LINK: The name of the libnt bitcode file to link.
+  // STEP_HLS_OUT: Unused.
+  const char *args;
+};
+
+static const step_def step_defs[] = {
+  { "ebpf2nt",    STEP_OPT,     "ebpf2nanotube" },
+  { "mem2req",    STEP_OPT,     "mem2req" },
+  { "lower",      STEP_LINK,    "nanotube_high_level.bc" },
+  { "inline",     STEP_OPT,     "always-inline constprop" },
+  { "platform",   STEP_OPT,     "platform always-inline constprop" },
+  { "ntattr",     STEP_OPT,     "nt-attributes O2" },
+  { "optreq",     STEP_OPT,     "optreq enable-loop-unroll always-inline"
+                                " constprop loop-unroll simplifycfg" },
+  { "converge",   STEP_OPT,     "compact-geps converge_mapa" },
+  { "pipeline",   STEP_OPT,     "compact-geps basicaa tbaa nanotube-aa"
+                                " pipeline" },
+  { "link_taps",  STEP_LINK,    "nanotube_low_level.bc" },
+  { "inline_opt", STEP_OPT,     "always-inline rewrite-setup replace-malloc"
+                                " thread-const constprop"
+                                " enable-loop-unroll loop-unroll"
+                                " move-alloca simplifycfg instcombine"
+                                " thread-const constprop simplifycfg" },
+  { "byteify",    STEP_OPT,     "byteify" },
+  { "destruct",   STEP_OPT,     "destruct" },
+  { "hdrparse",   STEP_OPT,     "header-parse" },
+  { "loopout",    STEP_OPT,     "outline-loops" },
+  { "loopfb",     STEP_OPT,     "loop-feedback" },
+  { "flatten",    STEP_OPT,     "flatten-cfg" },
+  { "pgogen",     STEP_OPT,     "nt-profile-gen" },
+  { "pgouse",     STEP_OPT,     "nt-profile-use" },
+  { "mapspec",    STEP_OPT,     "specialise-maps instcombine simplifycfg" },
+  { "hls",        STEP_HLS_OUT, "" },
+};
+
+// The standard back-end sequence, as the "hls" back-end in
+// scripts/nanotube_build.
+static const char *const default_sequence[] = {
+  "mem2req", "lower", "inline", "platform", "ntattr", "optreq",
+  "converge", "pipeline", "link_taps", "inline_opt", "hls",
+};
+
+static const step_def *find_step(StringRef name)
+{
+  for (auto &def: step_defs) {
+    if (name == def.name)
+      return &def;
+  }
+  return nullptr;
+}
+
+static int find_in_sequence(StringRef name)
+{
+  int num = sizeof(default_sequence)/sizeof(default_sequence[0]);
+  for (int i=0; i<num; i++) {
+    if (name == default_sequence[i])
+      return i;
+  }
+  return -1;
+}
+
+// Expand the -steps option into a list of step definitions.
+static bool parse_steps(const char *prog,
+                        std::vector<const step_def *> &steps)
+{
+  SmallVector<StringRef, 16> specs;
+  StringRef(opt_steps).split(specs, ',', -1, false);
+  for (StringRef spec: specs) {
+    auto range = spec.split(':');
+    if (range.second.empty() && !spec.endswith(":")) {
+      const step_def *def = find_step(spec);
+      if (def == nullptr) {
+        errs() << prog << ": Unknown step '" << spec << "'.\n";
+        return false;
+      }
+      steps.push_back(def);
+      continue;
+    }
+
+    int num = sizeof(default_sequence)/sizeof(default_sequence[0]);
+    int first = (range.first.empty() ? 0 : find_in_sequence(range.first));
+    int last = (range.second.empty() ? num-1 :
+                find_in_sequence(range.second));
+    if (first < 0 || last < 0) {
+      errs() << prog << ": Step range '" << spec << "' is not within"
+             << " the standard sequence.\n";
+      return false;
+    }
+    for (int i=first; i<=last; i++)
+      steps.push_back(find_step(default_sequence[i]));
+  }
+
+  // The HLS output step does not produce bitcode, so it must be last.
+  for (unsigned i=0; i+1<steps.size(); i++) {
+    if (steps[i]->kind == STEP_HLS_OUT) {
+      errs() << prog << ": The hls step must be the last step.\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Passes used to implement the steps.
+
+// Write a file by writing a temporary file and renaming it.
+static void write_file_atomic(const std::string &filename, StringRef data)
+{
+  std::string tmp_name = formatv("{0}.tmp{1}", filename,
+                                 llvm::sys::Process::getProcessId());
+  {
+    std::error_code ec;
+    llvm::raw_fd_ostream out(tmp_name, ec, llvm::sys::fs::F_None);
+    if (ec)
+      report_fatal_errorv("Failed to open '{0}': {1}",
+                          tmp_name, ec.message());
+    out << data;
+  }
+  std::error_code ec = llvm::sys::fs::rename(tmp_name, filename);
+  if (ec)
+    report_fatal_errorv("Failed to rename '{0}' to '{1}': {2}",
+                        tmp_name, filename, ec.message());
+}
+
+namespace {
+// The timing and instruction count information for a step.
+struct step_record {
+  const step_def *def;
+  bool cached;
+  double seconds;
+  uint64_t num_insns;
+};
+
+// A pass which is run at the end of each step.  It records how long
+// the step took, counts the instructions and writes the bitcode to
+// each of the requested files.
+class step_boundary: public llvm::ModulePass
+{
+public:
+  static char ID;
+  typedef std::chrono::steady_clock clock;
+
+  step_boundary(step_record &record, clock::time_point &last,
+                const std::vector<std::string> &bc_filenames):
+    ModulePass(ID), m_record(record), m_last(last),
+    m_bc_filenames(bc_filenames) {}
+  StringRef getPassName() const override {
+    return "Nanotube compile step boundary";
+  }
+  void getAnalysisUsage(AnalysisUsage &info) const override {
+    info.setPreservesAll();
+  }
+
+  bool runOnModule(Module &m) override {
+    auto now = clock::now();
+    m_record.seconds = std::chrono::duration<double>(now - m_last).count();
+
+    uint64_t num_insns = 0;
+    for (auto &func: m)
+      num_insns += func.getInstructionCount();
+    m_record.num_insns = num_insns;
+
+    if (!m_bc_filenames.empty()) {
+      SmallVector<char, 0> buffer;
+      llvm::raw_svector_ostream out(buffer);
+      llvm::WriteBitcodeToFile(m, out);
+      for (auto &filename: m_bc_filenames)
+        write_file_atomic(filename, out.str());
+    }
+
+    // Do not charge the bitcode output to the next step.
+    m_last = clock::now();
+    return false;
+  }
+
+private:
+  step_record &m_record;
+  clock::time_point &m_last;
+  std::vector<std::string> m_bc_filenames;
+};
+
+// A pass which links a bitcode library into the module.
+class link_library: public llvm::ModulePass
+{
+public:
+  static char ID;
+
+  link_library(const std::string &filename):
+    ModulePass(ID), m_filename(filename) {}
+  StringRef getPassName() const override {
+    return "Nanotube compile link library";
+  }
+
+  bool runOnModule(Module &m) override {
+    llvm::SMDiagnostic sm_diag;
+    auto lib = llvm::parseIRFile(m_filename, sm_diag, m.getContext());
+    if (!lib) {
+      sm_diag.print("nanotube_compile", errs());
+      report_fatal_errorv("Failed to read library '{0}'.", m_filename);
+    }
+    if (llvm::Linker::linkModules(m, std::move(lib)))
+      report_fatal_errorv("Failed to link library '{0}'.", m_filename);
+    return true;
+  }
+
+private:
+  std::string m_filename;
+};
+
+// The cache of step outputs.  See "The compile cache" above.
+class compile_cache
+{
+public:
+  typedef std::string key_t;
+
+  compile_cache(const std::string &dir): m_dir(dir) {}
+  bool enabled() const { return !m_dir.empty(); }
+
+  // Determine the key for a step given the key of the previous step.
+  key_t step_key(const key_t &prev_key, const step_def &def,
+                 StringRef extra) const;
+
+  // Determine the key of some input data.
+  static key_t data_key(StringRef data);
+
+  std::string bc_path(const key_t &key) const {
+    return m_dir + "/" + key + ".bc";
+  }
+  std::string hls_path(const key_t &key) const {
+    return m_dir + "/" + key + ".hls";
+  }
+
+  // Check whether the output of a step is in the cache.
+  bool lookup(const key_t &key, const step_def &def) const;
+
+  // Copy an HLS output directory into the cache.
+  void store_hls(const key_t &key, const std::string &src) const;
+
+  // Copy the cached HLS output to a directory.
+  void fetch_hls(const key_t &key, const std::string &dest) const;
+
+  // Set the string which identifies the compiler version and options.
+  void set_version(const std::string &version) { m_version = version; }
+
+private:
+  std::string m_dir;
+  std::string m_version;
+};
+} // namespace
+
+char step_boundary::ID = 0;
+char link_library::ID = 0;
+
+// Copy the regular files in one directory to another directory.  The
+// HLS output does not contain any subdirectories.
+static std::error_code copy_directory(const std::string &src,
+                                      const std::string &dest)
+{
+  std::error_code ec = llvm::sys::fs::create_directories(dest);
+  if (ec)
+    return ec;
+
+  llvm::sys::fs::directory_iterator it(src, ec), end;
+  for (; !ec && it != end; it.increment(ec)) {
+    auto status = it->status();
+    if (!status)
+      return status.getError();
+    if (status->type() != llvm::sys::fs::file_type::regular_file)
+      continue;
+    llvm::SmallString<256> dest_file(dest);
+    llvm::sys::path::append(dest_file,
+                            llvm::sys::path::filename(it->path()));
+    ec = llvm::sys::fs::copy_file(it->path(), dest_file);
+    if (ec)
+      return ec;
+  }
+  return ec;
+}
+
+compile_cache::key_t compile_cache::data_key(StringRef data)
+{
+  llvm::SHA1 hash;
+  hash.update(data);
+  return llvm::toHex(hash.final(), true);
+}
+
+compile_cache::key_t compile_cache::step_key(const key_t &prev_key,
+                                             const step_def &def,
+                                             StringRef extra) const
+{
+  llvm::SHA1 hash;
+  hash.update(prev_key);
+  hash.update(StringRef("\0", 1));
+  hash.update(def.name);
+  hash.update(StringRef("\0", 1));
+  hash.update(def.args);
+  hash.update(StringRef("\0", 1));
+  hash.update(m_version);
+  hash.update(StringRef("\0", 1));
+  hash.update(extra);
+  return llvm::toHex(hash.final(), true);
+}
+
+bool compile_cache::lookup(const key_t &key, const step_def &def) const
+{
+  if (def.kind == STEP_HLS_OUT)
+    return llvm::sys::fs::is_directory(hls_path(key));
+  return llvm::sys::fs::exists(bc_path(key));
+}
+
+void compile_cache::store_hls(const key_t &key,
+                              const std::string &src) const
+{
+  std::string dest = hls_path(key);
+  std::string tmp_dest = formatv("{0}.tmp{1}", dest,
+                                 llvm::sys::Process::getProcessId());
+  std::error_code ec = copy_directory(src, tmp_dest);
+  if (!ec)
+    ec = llvm::sys::fs::rename(tmp_dest, dest);
+  if (ec) {
+    // Another build may have stored the same entry.  Leave it alone
+    // and clean up the temporary copy.
+    llvm::sys::fs::remove_directories(tmp_dest);
+  }
+}
+
+void compile_cache::fetch_hls(const key_t &key,
+                              const std::string &dest) const
+{
+  ::mode_t mode = ( S_IRWXU | S_IRWXG | S_IRWXO );
+  int rc = ::mkdir(dest.c_str(), mode);
+  if (rc != 0 && (errno != EEXIST || !opt_overwrite)) {
+    int err = errno;
+    report_fatal_errorv("Failed to create directory '{0}': {1} (Error {2}).",
+                        dest, ::strerror(err), err);
+  }
+  std::error_code ec = copy_directory(hls_path(key), dest);
+  if (ec)
+    report_fatal_errorv("Failed to copy cached HLS output to '{0}': {1}",
+                        dest, ec.message());
+}
+
+// Hash the contents of a file into a hex string.  Returns an empty
+// string if the file cannot be read.
+static std::string hash_file(StringRef filename)
+{
+  auto buf = llvm::MemoryBuffer::getFile(filename);
+  if (!buf)
+    return "";
+  return compile_cache::data_key((*buf)->getBuffer());
+}
+
+// Determine the version of the pass libraries and the options passed
+// to the passes.  Options which only affect the driver are ignored.
+static std::string compiler_version(int argc, char *argv[])
+{
+  std::string result;
+
+  // Identify the back-end pass library by hashing its contents.
+  Dl_info info;
+  if (::dladdr((void*)&create_hls_printer, &info) != 0 &&
+      info.dli_fname != nullptr) {
+    result += hash_file(info.dli_fname);
+  }
+
+  // Include the contents of any plugins such as the front-end passes.
+  for (unsigned i=0; i<llvm::PluginLoader::getNumPlugins(); i++) {
+    result += ",";
+    result += hash_file(llvm::PluginLoader::getPlugin(i));
+  }
+
+  static const char *const driver_opts[] = {
+    "o", "overwrite", "steps", "libnt-dir", "save-intermediates",
+    "intermediate-prefix", "list-steps", "cache-dir",
+  };
+  for (int i=1; i<argc; i++) {
+    StringRef arg(argv[i]);
+    if (!arg.startswith("-"))
+      continue;
+    StringRef name = arg.ltrim('-').split('=').first;
+    bool is_driver_opt = false;
+    for (auto *opt: driver_opts)
+      is_driver_opt = is_driver_opt || (name == opt);
+    // Skip the value of a driver option given as a separate argument.
+    if (is_driver_opt) {
+      if (!arg.contains('=') && name != "overwrite" &&
+          name != "save-intermediates" && name != "list-steps")
+        i++;
+      continue;
+    }
+    result += " ";
+    result += arg;
+
+    // Include the contents of the files read by the passes, since
+    // they affect the output.
+    static const char *const file_opts[] = {
+      "nt-profile", "map-snapshot",
+    };
+    for (auto *opt: file_opts) {
+      if (name != opt)
+        continue;
+      StringRef filename = arg.split('=').second;
+      if (!arg.contains('=') && i+1 < argc)
+        filename = argv[++i];
+      result += ",";
+      result += hash_file(filename);
+    }
+  }
+  return result;
+}
+
+// Add the passes for an opt step.  Returns false if a pass was not
+// found.
+static bool add_opt_passes(const char *prog, llvm::legacy::PassManager &pm,
+                           const step_def &def)
+{
+  llvm::PassRegistry &registry = *llvm::PassRegistry::getPassRegistry();
+
+  SmallVector<StringRef, 16> names;
+  StringRef(def.args).split(names, ' ', -1, false);
+  for (StringRef name: names) {
+    if (name == "O2") {
+      // Mimic "opt -O2".  The passes which opt adds to its function
+      // pass manager are added directly.
+      pm.add(llvm::createTypeBasedAAWrapperPass());
+      pm.add(llvm::createScopedNoAliasAAWrapperPass());
+      pm.add(llvm::createCFGSimplificationPass());
+      pm.add(llvm::createSROAPass());
+      pm.add(llvm::createEarlyCSEPass());
+      pm.add(llvm::createLowerExpectIntrinsicPass());
+
+      llvm::PassManagerBuilder builder;
+      builder.OptLevel = 2;
+      builder.SizeLevel = 0;
+      builder.Inliner = llvm::createFunctionInliningPass(2, 0, false);
+      builder.populateModulePassManager(pm);
+      continue;
+    }
+
+    const llvm::PassInfo *pi = registry.getPassInfo(name);
+    if (pi == nullptr) {
+      errs() << prog << ": Unknown pass '" << name << "' in step '"
+             << def.name << "'.";
+      if (def.kind == STEP_OPT && StringRef(def.name) == "ebpf2nt")
+        errs() << "  Load the front-end passes with -load.";
+      errs() << "\n";
+      return false;
+    }
+    pm.add(pi->createPass());
+  }
+  return true;
+}
+
+static std::string default_libnt_dir(const char *argv0)
+{
+  void *addr = (void*)&default_libnt_dir;
+  std::string exe = llvm::sys::fs::getMainExecutable(argv0, addr);
+  llvm::SmallString<256> dir(llvm::sys::path::parent_path(exe));
+  llvm::sys::path::append(dir, "libnt");
+  return std::string(dir.str());
+}
+
+///////////////////////////////////////////////////////////////////////////
+// The main program.
+
+int main(int argc, char *argv[])
+{
+  llvm::InitLLVM init_llvm(argc, argv);
+
+  // Initialize passes.  See llvm/tools/opt/opt.cpp
+  llvm::PassRegistry &registry = *llvm::PassRegistry::getPassRegistry();
+  llvm::initializeCore(registry);
+  llvm::initializeScalarOpts(registry);
+  llvm::initializeIPO(registry);
+  llvm::initializeAnalysis(registry);
+  llvm::initializeTransformUtils(registry);
+  llvm::initializeInstCombine(registry);
+  llvm::initializeCodeGen(registry);
+
+  cl::ParseCommandLineOptions(argc, argv, "Nanotube compiler driver\n");
+
+  std::vector<const step_def *> steps;
+  if (!parse_steps(argv[0], steps))
+    return 1;
+
+  if (opt_list_steps) {
+    for (auto *def: steps)
+      llvm::outs() << def->name << "\n";
+    return 0;
+  }
+
+  std::string libnt_dir = opt_libnt_dir;
+  if (libnt_dir.empty())
+    libnt_dir = default_libnt_dir(argv[0]);
+
+  std::string prefix = opt_intermediate_prefix;
+  if (prefix.empty()) {
+    prefix = opt_input_filename;
+    StringRef ext = llvm::sys::path::extension(prefix);
+    if (ext == ".bc" || ext == ".ll")
+      prefix.resize(prefix.size() - ext.size());
+  }
+
+  std::string cache_dir = opt_cache_dir;
+  if (cache_dir.empty()) {
+    const char *env_dir = ::getenv("NANOTUBE_CACHE_DIR");
+    if (env_dir != nullptr)
+      cache_dir = env_dir;
+  }
+  compile_cache cache(cache_dir);
+
+  auto start_time = step_boundary::clock::now();
+  auto input_buf = llvm::MemoryBuffer::getFileOrSTDIN(opt_input_filename);
+  if (!input_buf) {
+    errs() << argv[0] << ": Failed to read '" << opt_input_filename
+           << "': " << input_buf.getError().message() << "\n";
+    return 1;
+  }
+
+  // Determine the cache keys and find the last cached step.
+  std::vector<compile_cache::key_t> keys(steps.size());
+  int first_step = 0;
+  if (cache.enabled()) {
+    std::error_code ec = llvm::sys::fs::create_directories(cache_dir);
+    if (ec) {
+      errs() << argv[0] << ": Failed to create cache directory '"
+             << cache_dir << "': " << ec.message() << "\n";
+      return 1;
+    }
+
+    cache.set_version(compiler_version(argc, argv));
+    compile_cache::key_t key =
+      compile_cache::data_key((*input_buf)->getBuffer());
+    for (unsigned i=0; i<steps.size(); i++) {
+      std::string extra;
+      if (steps[i]->kind == STEP_LINK) {
+        llvm::SmallString<256> lib(libnt_dir);
+        llvm::sys::path::append(lib, steps[i]->args);
+        extra = hash_file(lib);
+      }
+      key = cache.step_key(key, *(steps[i]), extra);
+      keys[i] = key;
+    }
+
+    for (int i=steps.size(); i>0; i--) {
+      if (cache.lookup(keys[i-1], *(steps[i-1]))) {
+        first_step = i;
+        break;
+      }
+    }
+  }
+
+  // Build a pass manager for each step which was not cached.
+  std::vector<std::unique_ptr<llvm::legacy::PassManager> > step_pms;
+  std::vector<step_record> records(steps.size());
+  step_boundary::clock::time_point last_time;
+  bool writes_hls = false;
+  for (unsigned i=0; i<steps.size(); i++) {
+    const step_def &def = *(steps[i]);
+    bool cached = (int(i) < first_step);
+    records[i] = step_record{&def, cached, 0.0, 0};
+    if (def.kind == STEP_HLS_OUT)
+      writes_hls = true;
+    if (cached)
+      continue;
+
+    step_pms.emplace_back(new llvm::legacy::PassManager);
+    llvm::legacy::PassManager &pm = *(step_pms.back());
+    switch (def.kind) {
+    case STEP_OPT:
+      if (!add_opt_passes(argv[0], pm, def))
+        return 1;
+      break;
+
+    case STEP_LINK: {
+      llvm::SmallString<256> lib(libnt_dir);
+      llvm::sys::path::append(lib, def.args);
+      pm.add(new link_library(std::string(lib.str())));
+      break;
+    }
+
+    case STEP_HLS_OUT:
+      pm.add(create_hls_printer(opt_output, opt_overwrite));
+      if (opt_write_perf_report) {
+        llvm::SmallString<256> report(opt_output);
+        llvm::sys::path::append(report, "perf_report.json");
+        pm.add(create_code_metrics(std::string(report.str())));
+      }
+      break;
+    }
+
+    std::vector<std::string> bc_filenames;
+    if (opt_save_intermediates && def.kind != STEP_HLS_OUT)
+      bc_filenames.push_back(prefix + "." + def.name + ".bc");
+    if (cache.enabled() && def.kind != STEP_HLS_OUT)
+      bc_filenames.push_back(cache.bc_path(keys[i]));
+    pm.add(new step_boundary(records[i], last_time, bc_filenames));
+  }
+
+  // Read the input, which is the output of the last cached step if
+  // there is one.
+  llvm::LLVMContext context;
+  llvm::SMDiagnostic sm_diag;
+  std::unique_ptr<Module> module;
+  int num_steps = steps.size();
+  if (first_step == 0) {
+    module = llvm::parseIR((*input_buf)->getMemBufferRef(), sm_diag,
+                           context);
+  } else if (first_step < num_steps ||
+             steps[first_step-1]->kind != STEP_HLS_OUT) {
+    module = llvm::parseIRFile(cache.bc_path(keys[first_step-1]),
+                               sm_diag, context);
+  }
+  if (!module && (first_step == 0 || first_step < num_steps ||
+                  steps[first_step-1]->kind != STEP_HLS_OUT)) {
+    sm_diag.print(argv[0], llvm::WithColor::error(errs(), argv[0]));
+    return 1;
+  }
+  auto read_time = step_boundary::clock::now();
+
+  last_time = read_time;
+  for (auto &pm: step_pms)
+    pm->run(*module);
+
+  // Write the output.
+  if (writes_hls) {
+    const auto &key = keys[num_steps-1];
+    if (first_step == num_steps)
+      cache.fetch_hls(key, opt_output);
+    else if (cache.enabled())
+      cache.store_hls(key, opt_output);
+  } else {
+    std::error_code ec;
+    llvm::raw_fd_ostream out(opt_output, ec, llvm::sys::fs::F_None);
+    if (ec) {
+      errs() << argv[0] << ": Failed to open '" << opt_output << "': "
+             << ec.message() << "\n";
+      return 1;
+    }
+    llvm::WriteBitcodeToFile(*module, out);
+  }
+  auto end_time = step_boundary::clock::now();
+
+  // Print the step report.
+  auto &os = llvm::outs();
+  os << formatv("{0,-12} {1,10} {2,12}\n", "Step", "Time (s)",
+                "Instructions");
+  os << formatv("{0,-12} {1,10:f3} {2,12}\n", "read",
+                std::chrono::duration<double>(read_time -
+                                              start_time).count(), "");
+  for (auto &rec: records) {
+    if (rec.cached) {
+      os << formatv("{0,-12} {1,10} {2,12}\n", rec.def->name,
+                    "cached", "");
+    } else {
+      os << formatv("{0,-12} {1,10:f3} {2,12}\n", rec.def->name,
+                    rec.seconds, rec.num_insns);
+    }
+  }
+  os << formatv("{0,-12} {1,10:f3}\n", "total",
+                std::chrono::duration<double>(end_time -
+                                              start_time).count());
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////
@@ -22,9 +22,9 @@
  *
  * _Theory of Operation_
  *
- * For each type of access (currently packet reads and packet writes), the
- * pass performs two steps: merge group collection and the actual merge
- * step.
+ * For each type of access (packet reads, packet writes, map reads and map
+ * writes), the pass performs two steps: merge group collection and the
+ * actual merge step.
  *
  * _Merge Group Collection_
  *
@@ -36,7 +36,12 @@
  *   - packet_read(%base, 2) and packet_read(%base + 3, 1) can be merged
  *   - packet_read(%base, 2) and packet_read(14, 1) cannot be merged (it is
  *     not clear where they are in relation to one another)
- * - they are to the same map entry (not implemented yet)
+ * - they are to the same map entry: map accesses are only merged if they
+ *   use the same map and the same key pointer, and the key is not
+ *   modified between the accesses and the merged access.  Map merging is
+ *   enabled with -optreq-map-merge.  The merged write only happens if one
+ *   of the original writes did, because a write with an empty mask would
+ *   still insert a missing key.
  * - they are of the same type (packet reads with packet reads, ...)
  * - EITHER: they are adjacent (no interleaving incompatible access)
  *   - packet_read(3, 4); packet_write(4, 2); packet_read(7, 1) cannot
@@ -75,6 +80,10 @@
  * - review size and gaps of the group (size of holes vs overall size), and
  *   split if necessary
  *
+ * Writes can instead be grouped with the frontier-based approach described
+ * below.  This is always done for map writes and can be selected for packet
+ * writes with -optreq-frontier.
+ *
  * Then, for each resulting merge group, try to find a place to insert the
  * merged access, observing the dominate / post-dominate conditions
  * outlined above.  That is not always possible and needs work in the
@@ -87,12 +96,29 @@
  * limiting the selection of original accesses for the moment.  That can
  * cause issues around finding an inserstion point, as above, and others.
  *
+ * _Frontier-Based Write Merging_
+ *
+ * Instead of tracing every group member to the insertion point, writes
+ * can be merged by growing a frontier: start at the first write of a group
+ * that has not been merged yet and go forwards in the program until an
+ * incompatible access is found.  Every write of the group found on the way
+ * is mopped up into the frontier, and every other instruction is checked
+ * against all writes in the frontier.  When an incompatible access is
+ * found, the merged write is placed just before it.
+ *
+ * The frontier follows the post-dominator tree: it walks to the end of the
+ * current basic block, checks all blocks between that block and its
+ * immediate post-dominator (in reverse post-order) and then continues in
+ * the post-dominator.  If an incompatible access sits between the two, the
+ * merged write is placed at the end of the current block and the writes
+ * found between the two are left for later frontiers.  Writes that were
+ * already merged by an earlier frontier block the walk, so that the merged
+ * writes of a group stay in the order of the original writes.
+ *
+ * This greedily mops up overlapping writes (see below) and finds insertion
+ * points in cases where tracing each write individually fails.
+ *
  * _Limitations and Further Development_
- * I think a better way instead of tracing every group member to the
- * insertion point is to do a frontier-based approach, especially for
- * writes: start at each write and go forwards in the program until another
- * write or incompatible access is found; if compatible, grow the merge
- * group and continue tracing; if incompatible, stop and merge just before.
  *
  * Care has to be taken that overlapping writes are either not merged at
  * all, merged to the same big write, or their merged writes are in the
@@ -151,10 +177,11 @@
  *     %C =  packet_read( offs = 16, len = 1)
  *     %A_D = packet_write( offs = 12, len = 4)  // combined %A + %D
  *
- * That functionality remains to be implemented, however.  One option would
- * be to separate the collection of the constraints and opportunities from
- * making the decision.  I am thinking a graph with edges of different
- * types might be a useful thing, here.
+ * The frontier-based approach implements greedy mopping up.  Only mopping
+ * when needed remains to be implemented.  One option would be to separate
+ * the collection of the constraints and opportunities from making the
+ * decision.  I am thinking a graph with edges of different types might be a
+ * useful thing, here.
  *
  * _Actual Merge Step_
  *
@@ -183,28 +210,59 @@
  *   with the aggregated data and mask
  * - care has to be taken that the merged write post-dominates all writes
  *   of the merge group (comes strictly after them!)
+ *
+ * Map accesses to the same key are merged in the same way: reads become a
+ * single wide map read with memcpy operations at the original sites, and
+ * writes update a data and mask buffer and are followed by a single wide
+ * masked map write.  The result of an original read is derived from the
+ * result of the wide read.  Map writes are only merged if their result is
+ * unused, because the merged write happens after the original writes.
+ * A map read and a map write are never reordered with one another, unless
+ * they access different maps.
+ *
+ * _Profile Guidance_
+ *
+ * If the packet kernel has a profile (see the nt-profile-use pass), the
+ * accesses in cold basic blocks are split off into separate merge groups
+ * before the groups are checked.  Merging a rarely executed access with
+ * the accesses of the hot path would place the merged access on the hot
+ * path and make it wider, so the cold accesses are only merged with one
+ * another.
  */
 
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/CFG.h"
 #include "llvm/Analysis/PostDominators.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/KnownBits.h"
 
 #include "Intrinsics.h"
 #include "Map_Packet_CFG.hpp"
+#include "profile.hpp"
 
 #define DEBUG_TYPE "optreq"
 using namespace llvm;
 using namespace nanotube;
 
+static cl::opt<bool> optreq_frontier("optreq-frontier",
+    cl::desc("Use frontier-based merging for packet writes"),
+    cl::init(false));
+static cl::opt<bool> optreq_map_merge("optreq-map-merge",
+    cl::desc("Merge map accesses to the same map entry"),
+    cl::init(false));
+
 /**
  * A scaled value is a thin wrapper around llvm::Value and captures
  * arithmetic done to the value: multiplication / division / shifts by
@@ -315,6 +373,56 @@ static raw_ostream& operator<<(raw_ostream& os, const merge_group& g) {
   return os;
 }
 
+/**
+ * The arguments of a map_op call.  Unlike map_op_args, this does not
+ * require the map ID to be a constant.
+ */
+struct map_access {
+  CallInst* call;
+  Value*    ctx;
+  Value*    map;
+  Value*    type;
+  Value*    key;
+  Value*    key_length;
+  Value*    data_in;
+  Value*    data_out;
+  Value*    mask;
+  Value*    offset;
+  Value*    data_length;
+
+  map_access(Instruction* inst) {
+    call        = cast<CallInst>(inst);
+    assert(get_intrinsic(call) == Intrinsics::map_op);
+    ctx         = call->getArgOperand(0);
+    map         = call->getArgOperand(1);
+    type        = call->getArgOperand(2);
+    key         = call->getArgOperand(3);
+    key_length  = call->getArgOperand(4);
+    data_in     = call->getArgOperand(5);
+    data_out    = call->getArgOperand(6);
+    mask        = call->getArgOperand(7);
+    offset      = call->getArgOperand(8);
+    data_length = call->getArgOperand(9);
+  }
+
+  bool has_type(map_access_t t) const {
+    auto* ci = dyn_cast<ConstantInt>(type);
+    return (ci != nullptr) && (ci->getZExtValue() == (uint64_t)t);
+  }
+  /* Constants are uniqued, so equal map IDs are the same value */
+  bool same_map(const map_access& other) const {
+    return map == other.map;
+  }
+  bool distinct_map(const map_access& other) const {
+    return isa<ConstantInt>(map) && isa<ConstantInt>(other.map) &&
+           (map != other.map);
+  }
+  bool same_key(const map_access& other) const {
+    return (key->stripPointerCasts() == other.key->stripPointerCasts()) &&
+           (key_length == other.key_length);
+  }
+};
+
 static bool is_reachable(BasicBlock* from, BasicBlock* to);
 
 struct optimise_requests : public FunctionPass {
@@ -323,6 +431,7 @@ struct optimise_requests : public FunctionPass {
   void get_all_analysis_results(Function& f) {
     dt  = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
     pdt = &getAnalysis<PostDominatorTreeWrapperPass>().getPostDomTree();
+    profile.reset(new block_profile(f, *dt));
   }
   void getAnalysisUsage(AnalysisUsage &info) const override {
     info.addRequired<DominatorTreeWrapperPass>();
@@ -331,17 +440,24 @@ struct optimise_requests : public FunctionPass {
 
   void collect_nt_calls(Function& f, ivec_t* prds, Intrinsics::ID id);
   void collect_nt_calls(BasicBlock& bb, ivec_t* prds, Intrinsics::ID id);
+  void collect_map_ops(Function& f, ivec_t* ops, map_access_t type);
   void group_nt_calls(const ivec_t& prds,
                       std::vector<merge_group>* prd_groups);
+  void group_map_ops(const ivec_t& ops, bool to_front,
+                     std::vector<merge_group>* op_groups);
+  void check_groups(std::vector<merge_group>* groups, bool to_front,
+                    bool frontier, std::vector<merge_group>* out);
 
   DominatorTree* dt;
   PostDominatorTree* pdt;
+  std::unique_ptr<block_profile> profile;
   /* LLVM-specific */
   static char ID;
   bool runOnFunction(Function& f) override;
 };
 
 static void merge_packet_group(merge_group* g);
+static void merge_map_group(merge_group* g, ivec_t* dead);
 
 bool optimise_requests::runOnFunction(Function& f) {
   if( !is_nt_packet_kernel(f) )
@@ -384,6 +500,37 @@ bool optimise_requests::runOnFunction(Function& f) {
     );
     for( auto& g : groups )
       merge_packet_group(&g);
+    changes |= !groups.empty();
+
+    /* Merge map accesses to the same map entry; reads first, again.  The
+     * original accesses are removed only after all groups have been
+     * merged, because they may be the insertion point of other groups. */
+    if( !optreq_map_merge )
+      return changes;
+
+    ivec_t dead;
+    prds.clear(); groups.clear();
+    collect_map_ops(f, &prds, NANOTUBE_MAP_READ);
+    group_map_ops(prds, true, &groups);
+    for( auto& g : groups )
+      merge_map_group(&g, &dead);
+    changes |= !groups.empty();
+    for( auto* inst : dead )
+      inst->eraseFromParent();
+
+    dead.clear(); prds.clear(); groups.clear();
+    collect_map_ops(f, &prds, NANOTUBE_MAP_WRITE);
+    group_map_ops(prds, false, &groups);
+    LLVM_DEBUG(
+      dbgs() << "Map write merge groups:\n";
+      for( auto& g : groups )
+        dbgs() << g;
+    );
+    for( auto& g : groups )
+      merge_map_group(&g, &dead);
+    changes |= !groups.empty();
+    for( auto* inst : dead )
+      inst->eraseFromParent();
 
     return changes;
   } else {
@@ -416,6 +563,31 @@ void optimise_requests::collect_nt_calls(BasicBlock& bb, ivec_t* prds,
   }
 }
 
+/**
+ * Collect the map_op calls of the provided type that can be merged: they
+ * need a constant offset and length, reads need an output buffer and
+ * writes a mask.  Map writes are only collected if their result is unused,
+ * because the merged write will happen after the original write.
+ */
+void optimise_requests::collect_map_ops(Function& f, ivec_t* ops,
+                                        map_access_t type) {
+  for( auto& inst : instructions(f) ) {
+    if( get_intrinsic(&inst) != Intrinsics::map_op )
+      continue;
+    map_access ma(&inst);
+    if( !ma.has_type(type) )
+      continue;
+    if( !isa<ConstantInt>(ma.offset) || !isa<ConstantInt>(ma.data_length) )
+      continue;
+    if( type == NANOTUBE_MAP_READ && isa<ConstantPointerNull>(ma.data_out) )
+      continue;
+    if( type == NANOTUBE_MAP_WRITE &&
+        (isa<ConstantPointerNull>(ma.mask) || !inst.use_empty()) )
+      continue;
+    ops->push_back(&inst);
+  }
+}
+
 static raw_ostream& operator<<(raw_ostream& os, const KnownBits& known) {
   unsigned bw = known.getBitWidth();
   for( unsigned i = bw; i > 0; i-- ) {
@@ -868,6 +1040,8 @@ static void split_on_offset(const merge_group& g, int64_t offs,
   merge_group g1, g2;
   g1.key = g.key;
   g2.key = g.key;
+  g1.insert_point = g.insert_point;
+  g2.insert_point = g.insert_point;
   for( auto& a : g.accesses ) {
     if( std::get<1>(a) < offs )
       g1.accesses.emplace_back(a);
@@ -1030,6 +1204,12 @@ can_bypass_packet_packet(inst_rng_t* inst_rng, scaled_value& base2,
       (id_tgt == Intrinsics::packet_bounded_length) )
     return BLOCK;
 
+  /* Checksums cover a whole region of the packet, so keep them in
+   * order with the other accesses. */
+  if( (id_ins == Intrinsics::packet_csum) ||
+      (id_tgt == Intrinsics::packet_csum) )
+    return BLOCK;
+
   /* Two reads always commute with one another */
   if( (id_ins == Intrinsics::packet_read) &&
       (id_tgt == Intrinsics::packet_read) )
@@ -1095,9 +1275,116 @@ can_bypass_packet_packet(inst_rng_t* inst_rng, scaled_value& base2,
   return BLOCK;
 }
 
+/**
+ * Check whether two map accesses commute.  Reads always commute with one
+ * another, and accesses to different maps are independent.  Otherwise, the
+ * accesses may touch the same map entry and only writes to the same key
+ * are understood: they commute if they write different bytes of the entry
+ * and can be merged if they overlap.  Anything else (different keys that
+ * may still be equal, inserts, updates, removes) blocks.
+ */
 static bypass_result_t
 can_bypass_map_map(inst_rng_t* inst_rng, scaled_value& base2, nt_api_call nt_tgt ) {
-  return BLOCK;
+  auto* inst = std::get<0>(*inst_rng);
+  if( (get_intrinsic(inst) != Intrinsics::map_op) ||
+      (nt_tgt.get_intrinsic() != Intrinsics::map_op) )
+    return BLOCK;
+
+  map_access ins(inst), tgt(nt_tgt.get_call());
+  if( ins.distinct_map(tgt) )
+    return BYPASS;
+
+  bool ins_rd = ins.has_type(NANOTUBE_MAP_READ);
+  bool tgt_rd = tgt.has_type(NANOTUBE_MAP_READ);
+  if( ins_rd && tgt_rd )
+    return BYPASS;
+
+  if( !ins.same_map(tgt) || !ins.same_key(tgt) ||
+      !ins.has_type(NANOTUBE_MAP_WRITE) ||
+      !tgt.has_type(NANOTUBE_MAP_WRITE) ) {
+    LLVM_DEBUG(dbgs() << "Mustn't bypass map access " << *tgt.call
+                      << " DONE.\n");
+    return BLOCK;
+  }
+
+  auto* offs = dyn_cast<ConstantInt>(tgt.offset);
+  auto* len  = dyn_cast<ConstantInt>(tgt.data_length);
+  if( (offs == nullptr) || (len == nullptr) )
+    return BLOCK;
+
+  bool overlap = range_overlap(offs->getSExtValue(),
+                               (uint16_t)len->getZExtValue(),
+                               std::get<1>(*inst_rng),
+                               std::get<2>(*inst_rng));
+  if( !overlap ) {
+    LLVM_DEBUG(dbgs() << "Allowing " << *inst << " past map write "
+                      << "that does not overlap: " << *tgt.call
+                      << " DONE.\n");
+    return BYPASS;
+  }
+  LLVM_DEBUG(dbgs() << "Cannot bypass but merge with " << *tgt.call
+                    << " DONE.\n");
+  return MERGE_SAME;
+}
+
+/**
+ * Check whether the target instruction may modify the memory pointed to
+ * by ptr.  This is conservative: pointers that cannot be traced to
+ * distinct identified objects may alias.
+ */
+static bool
+may_clobber(Instruction* target, Value* ptr) {
+  if( !target->mayWriteToMemory() )
+    return false;
+
+  auto& dl  = target->getModule()->getDataLayout();
+  auto* obj = GetUnderlyingObject(ptr, dl);
+
+  /* Collect the pointers that the target may write through */
+  SmallVector<Value*, 4> ptrs;
+  auto* st = dyn_cast<StoreInst>(target);
+  auto* call = dyn_cast<CallInst>(target);
+  if( st != nullptr ) {
+    ptrs.push_back(st->getPointerOperand());
+  } else if( call != nullptr ) {
+    switch( get_intrinsic(call) ) {
+      case Intrinsics::packet_read:
+        ptrs.push_back(packet_read_args(call).data_out);
+        break;
+      case Intrinsics::map_op:
+        ptrs.push_back(map_access(call).data_out);
+        break;
+      case Intrinsics::packet_write:
+      case Intrinsics::packet_write_masked:
+      case Intrinsics::packet_bounded_length:
+      case Intrinsics::packet_csum:
+      case Intrinsics::packet_resize:
+        break;
+      default:
+        if( isa<MemIntrinsic>(call) ) {
+          ptrs.push_back(cast<MemIntrinsic>(call)->getRawDest());
+          break;
+        }
+        /* Unknown calls may write any memory that is not local */
+        if( !isa<AllocaInst>(obj) )
+          return true;
+        for( auto& arg : call->arg_operands() )
+          if( arg->getType()->isPointerTy() )
+            ptrs.push_back(arg);
+    }
+  } else {
+    return true;
+  }
+
+  for( auto* p : ptrs ) {
+    if( isa<ConstantPointerNull>(p) )
+      continue;
+    auto* p_obj = GetUnderlyingObject(p, dl);
+    if( (p_obj == obj) ||
+        !isIdentifiedObject(p_obj) || !isIdentifiedObject(obj) )
+      return true;
+  }
+  return false;
 }
 
 static bypass_result_t
@@ -1108,6 +1395,15 @@ can_bypass(inst_rng_t* inst_rng, scaled_value& base2, Instruction* target)  {
   if( inst == target )
     return BYPASS;
 
+  /* Map accesses read their key when they are performed, so they must not
+   * move past anything that may change the key. */
+  if( (get_intrinsic(inst) == Intrinsics::map_op) &&
+      may_clobber(target, map_access(inst).key) ) {
+    LLVM_DEBUG(dbgs() << "Key of " << *inst << " may be modified by "
+                      << *target << " DONE.\n");
+    return BLOCK;
+  }
+
   /* Only call instructions can fiddle with the "behind the scenes" data.
    * Everything else cannot access packet / map data at this point! */
   if( !isa<CallInst>(target) )
@@ -1133,6 +1429,7 @@ can_bypass(inst_rng_t* inst_rng, scaled_value& base2, Instruction* target)  {
     case Intrinsics::packet_write:
     case Intrinsics::packet_write_masked:
     case Intrinsics::packet_bounded_length:
+    case Intrinsics::packet_csum:
     case Intrinsics::packet_resize:
     case Intrinsics::map_op:
       errs() << "ERROR: Unexpected operation " << *target << " in can_bypass"
@@ -1896,10 +2193,253 @@ void optimise_requests::group_nt_calls(const ivec_t& prds,
     groups.emplace_back(key_ise.first, key_ise.second);
   }
 
-  /* Check groups and adjust them if necessary */
-  while( !groups.empty() ) {
-    auto g = groups.back();
-    groups.pop_back();
+  bool to_front = (id == Intrinsics::packet_read);
+  check_groups(&groups, to_front, !to_front && optreq_frontier, prd_groups);
+}
+
+/**
+ * Group map accesses based on the map and key they access.  The key
+ * pointer is used as the key of the merge group.  Groups whose merged
+ * access would be placed where the map ID or key are not available are
+ * dropped.
+ */
+void optimise_requests::group_map_ops(const ivec_t& ops, bool to_front,
+                                      std::vector<merge_group>* op_groups) {
+  std::vector<merge_group> groups;
+  for( auto* op : ops ) {
+    map_access ma(op);
+    int64_t  offs = cast<ConstantInt>(ma.offset)->getSExtValue();
+    uint16_t len  = (uint16_t)cast<ConstantInt>(ma.data_length)
+                                ->getZExtValue();
+
+    merge_group* grp = nullptr;
+    for( auto& g : groups ) {
+      map_access other(std::get<0>(g.accesses.front()));
+      if( ma.same_map(other) && ma.same_key(other) ) {
+        grp = &g;
+        break;
+      }
+    }
+    if( grp == nullptr ) {
+      groups.emplace_back(scaled_value(ma.key), nullptr);
+      grp = &groups.back();
+    }
+    LLVM_DEBUG(dbgs() << "Grouping map access " << *op << " offset: "
+                      << offs << " length: " << len << '\n');
+    grp->accesses.emplace_back(op, offs, len);
+  }
+
+  std::vector<merge_group> checked;
+  check_groups(&groups, to_front, !to_front, &checked);
+
+  for( auto& g : checked ) {
+    map_access ma(std::get<0>(g.accesses.front()));
+    bool available = true;
+    for( auto* v : {ma.map, ma.type, ma.key, ma.key_length} ) {
+      auto* vi = dyn_cast<Instruction>(v);
+      if( (vi != nullptr) && !dt->dominates(vi, g.insert_point) )
+        available = false;
+    }
+    if( !available ) {
+      LLVM_DEBUG(dbgs() << "Arguments not available at insertion point, "
+                        << "not merging group " << g);
+      continue;
+    }
+    op_groups->emplace_back(g);
+  }
+}
+
+/**
+ * Check whether a single instruction can be passed by the writes of a
+ * growing frontier.  Writes of the group are mopped up into the frontier;
+ * writes of the group that were already merged by an earlier frontier and
+ * incompatible accesses stop the frontier (BLOCK).
+ */
+static bypass_result_t
+frontier_step(inst_rng_vec_t* frontier, scaled_value& key, Instruction* inst,
+              const std::unordered_map<Instruction*, inst_rng_t>& members,
+              const std::unordered_set<Instruction*>& merged) {
+  auto it = members.find(inst);
+  if( it != members.end() ) {
+    if( merged.count(inst) > 0 ) {
+      LLVM_DEBUG(dbgs() << "Frontier hit already merged write " << *inst
+                        << '\n');
+      return BLOCK;
+    }
+    LLVM_DEBUG(dbgs() << "Frontier mopping up " << *inst << '\n');
+    frontier->emplace_back(it->second);
+    return MERGE_SAME;
+  }
+
+  for( auto& inst_rng : *frontier ) {
+    if( can_bypass(&inst_rng, key, inst) != BYPASS ) {
+      LLVM_DEBUG(dbgs() << "Frontier blocked at " << *inst << '\n');
+      return BLOCK;
+    }
+  }
+  return BYPASS;
+}
+
+/**
+ * Split a group of writes into merge groups by growing a frontier forwards
+ * from the first write that has not been merged, yet.  See _Frontier-Based
+ * Write Merging_ above.  The resulting groups have their insertion point
+ * set.
+ */
+static void
+split_group_frontier(const merge_group& g, std::vector<merge_group>* out,
+                     PostDominatorTree* pdt) {
+  LLVM_DEBUG(dbgs() << "Frontier merging of group " << g);
+
+  std::unordered_map<Instruction*, inst_rng_t> members;
+  for( auto& inst_rng : g.accesses )
+    members.emplace(std::get<0>(inst_rng), inst_rng);
+  std::unordered_set<Instruction*> merged;
+
+  /* Number the basic blocks in reverse post-order, so that regions can be
+   * walked in program order */
+  auto* f = std::get<0>(g.accesses.front())->getFunction();
+  ReversePostOrderTraversal<Function*> rpot(f);
+  std::vector<BasicBlock*> order(rpot.begin(), rpot.end());
+  std::unordered_map<BasicBlock*, unsigned> bb_idx;
+  for( unsigned i = 0; i < order.size(); i++ )
+    bb_idx[order[i]] = i;
+
+  scaled_value key = g.key;
+  for( auto* seed_bb : order ) {
+    for( auto& seed : *seed_bb ) {
+      if( (members.count(&seed) == 0) || (merged.count(&seed) > 0) )
+        continue;
+
+      merge_group cur(key, nullptr);
+      cur.accesses.emplace_back(members.at(&seed));
+      auto* bb  = seed_bb;
+      auto* pos = seed.getNextNode();
+
+      while( true ) {
+        /* Grow the frontier to the end of the basic block */
+        for( ; pos != bb->getTerminator(); pos = pos->getNextNode() ) {
+          if( frontier_step(&cur.accesses, key, pos, members,
+                            merged) == BLOCK ) {
+            cur.insert_point = pos;
+            break;
+          }
+        }
+        if( cur.insert_point != nullptr )
+          break;
+
+        /* Continue in the immediate post-dominator, if there is one */
+        auto* node     = pdt->getNode(bb);
+        auto* ipdom    = (node != nullptr) ? node->getIDom() : nullptr;
+        auto* next_bb  = (ipdom != nullptr) ? ipdom->getBlock() : nullptr;
+        if( next_bb == nullptr ) {
+          cur.insert_point = bb->getTerminator();
+          break;
+        }
+
+        /* Collect the blocks between bb and next_bb */
+        std::unordered_set<BasicBlock*> region;
+        std::vector<BasicBlock*> todo(succ_begin(bb), succ_end(bb));
+        while( !todo.empty() ) {
+          auto* r = todo.back();
+          todo.pop_back();
+          if( (r == next_bb) || !region.insert(r).second )
+            continue;
+          todo.insert(todo.end(), succ_begin(r), succ_end(r));
+        }
+        std::vector<BasicBlock*> region_bbs(region.begin(), region.end());
+        std::sort(region_bbs.begin(), region_bbs.end(),
+                  [&](BasicBlock* a, BasicBlock* b) {
+                    return bb_idx[a] < bb_idx[b];
+                  });
+
+        /* Grow a copy of the frontier through the region, so that the
+         * region can be abandoned as a whole */
+        inst_rng_vec_t grown = cur.accesses;
+        bool blocked = false;
+        for( auto* r : region_bbs ) {
+          for( auto& inst : *r ) {
+            if( frontier_step(&grown, key, &inst, members,
+                              merged) == BLOCK ) {
+              blocked = true;
+              break;
+            }
+          }
+          if( blocked )
+            break;
+        }
+        if( blocked ) {
+          cur.insert_point = bb->getTerminator();
+          break;
+        }
+        cur.accesses.swap(grown);
+
+        bb  = next_bb;
+        pos = bb->getFirstNonPHI();
+      }
+
+      for( auto& inst_rng : cur.accesses )
+        merged.insert(std::get<0>(inst_rng));
+      LLVM_DEBUG(dbgs() << "Frontier group " << cur);
+      if( cur.accesses.size() > 1 )
+        out->emplace_back(cur);
+    }
+  }
+}
+
+/**
+ * Split the accesses of a merge group into those in cold basic blocks and
+ * the others.
+ */
+static void split_group_cold(const merge_group& g,
+                             const block_profile& profile,
+                             std::vector<merge_group>* out) {
+  inst_rng_vec_t warm, cold;
+  for( auto& inst_rng : g.accesses ) {
+    auto* bb = std::get<0>(inst_rng)->getParent();
+    if( profile.is_cold(bb) )
+      cold.push_back(inst_rng);
+    else
+      warm.push_back(inst_rng);
+  }
+
+  LLVM_DEBUG(
+    if( !warm.empty() && !cold.empty() )
+      dbgs() << "Splitting " << cold.size() << " cold accesses off group "
+             << g;
+  );
+  if( !warm.empty() )
+    out->emplace_back(g.key, g.insert_point, warm);
+  if( !cold.empty() )
+    out->emplace_back(g.key, g.insert_point, cold);
+}
+
+/**
+ * Check groups of accesses and adjust them if necessary: find the
+ * insertion point of the merged access and split groups that cannot be
+ * merged as a whole.  Groups that can be merged are added to out.
+ */
+void optimise_requests::check_groups(std::vector<merge_group>* groups,
+                                     bool to_front, bool frontier,
+                                     std::vector<merge_group>* out) {
+  /* Keep the cold accesses off the hot path */
+  if( profile->valid() ) {
+    std::vector<merge_group> split_groups;
+    for( auto& g : *groups )
+      split_group_cold(g, *profile, &split_groups);
+    groups->swap(split_groups);
+  }
+
+  if( frontier ) {
+    std::vector<merge_group> frontier_groups;
+    for( auto& g : *groups )
+      split_group_frontier(g, &frontier_groups, pdt);
+    groups->swap(frontier_groups);
+  }
+
+  while( !groups->empty() ) {
+    auto g = groups->back();
+    groups->pop_back();
 
     /* Ignore (drop) groups with only a single entry */
     if( g.accesses.size() <= 1 )
@@ -1907,16 +2447,18 @@ void optimise_requests::group_nt_calls(const ivec_t& prds,
 
     bool needs_split = false;
 
-    /* Compute and check the insertion point for the merged access */
-    bool to_front = (id == Intrinsics::packet_read);
-    g.insert_point = group_insertion_point(g, *dt, *pdt, to_front);
-    LLVM_DEBUG(dbgs() << "Mergeability check for group " << g << '\n');
-    needs_split = split_group_unsupported_intermediate(&g, &groups, dt,
-                                                       pdt, to_front);
-    if( needs_split ) {
-      LLVM_DEBUG(dbgs() << "Group must be split due to unsupported "
-                        << "intermediate.\n");
-      continue;
+    /* Compute and check the insertion point for the merged access; the
+     * frontier has done that already */
+    if( !frontier ) {
+      g.insert_point = group_insertion_point(g, *dt, *pdt, to_front);
+      LLVM_DEBUG(dbgs() << "Mergeability check for group " << g << '\n');
+      needs_split = split_group_unsupported_intermediate(&g, groups, dt,
+                                                         pdt, to_front);
+      if( needs_split ) {
+        LLVM_DEBUG(dbgs() << "Group must be split due to unsupported "
+                          << "intermediate.\n");
+        continue;
+      }
     }
 
     /* Never let the empty space be larger than total_factor / empty_factor
@@ -1927,7 +2469,7 @@ void optimise_requests::group_nt_calls(const ivec_t& prds,
     /* Split groups that have too much free space! */
     needs_split = split_group_with_holes(&g, empty_factor,
                                          total_factor,
-                                         max_empty_bytes, &groups);
+                                         max_empty_bytes, groups);
     if( needs_split ) {
       LLVM_DEBUG(dbgs() << "Group must be split due to holes.\n");
       continue;
@@ -1937,7 +2479,7 @@ void optimise_requests::group_nt_calls(const ivec_t& prds,
     LLVM_DEBUG(dbgs() << "Group can be merged!\n");
     assert(g.key.base != nullptr);
     assert(g.insert_point != nullptr);
-    prd_groups->emplace_back(g);
+    out->emplace_back(g);
   }
 }
 
@@ -2091,6 +2633,122 @@ static void merge_packet_group(merge_group* g) {
   }
 }
 
+/**
+ * Merge a group of map accesses to the same map entry.  Reads become a
+ * single wide read into a buffer with memcpy operations at the original
+ * read sites, and writes merge their data and mask into buffers followed
+ * by a single wide masked write, similar to packet accesses.  The original
+ * accesses are added to dead, rather than being removed here, because they
+ * may serve as insertion points of other groups.
+ */
+static void merge_map_group(merge_group* g, ivec_t* dead) {
+  LLVM_DEBUG(dbgs() << "Merging map group " << *g);
+
+  /* Get total size */
+  int64_t  start, end;
+  unsigned count;
+  std::vector<bool> accessed;
+  sort_group_start_offset(g);
+  get_accessed_mask(*g, &accessed, &start, &end, &count);
+  unsigned len = end - start;
+
+  /* Allocate big enough buffer */
+  auto* f = g->insert_point->getFunction();
+  auto* m = f->getParent();
+  IRBuilder<> ir(&*f->getEntryBlock().getFirstInsertionPt());
+  auto* buffer = ir.CreateAlloca(ir.getInt8Ty(), ir.getInt32(len),
+                                 "map_op_buf_off" + Twine(start));
+
+  map_access ma(std::get<0>(g->accesses[0]));
+  auto* nt_map_op = create_nt_map_op(*m);
+  auto* null_ptr  = ConstantPointerNull::get(ir.getInt8PtrTy());
+
+  if( ma.has_type(NANOTUBE_MAP_READ) ) {
+    /* Do the read */
+    ir.SetInsertPoint(g->insert_point);
+    Value* args[] = { ma.ctx, ma.map, ma.type, ma.key, ma.key_length,
+                      null_ptr, buffer, null_ptr,
+                      ir.getInt64(start), ir.getInt64(len) };
+    auto* new_read = ir.CreateCall(nt_map_op, args);
+    LLVM_DEBUG(dbgs() << "New buffer: " << *buffer
+                      << "\nNew map read: " << *new_read << '\n');
+
+    /* Replace every access with a memcpy out of the buffer and derive the
+     * returned length from that of the wide read */
+    for( auto& inst_rng : g->accesses ) {
+      auto* inst = std::get<0>(inst_rng);
+      auto  from = std::get<1>(inst_rng);
+      map_access ma(inst);
+      ir.SetInsertPoint(inst);
+
+      auto* buf_gep = ir.CreateConstInBoundsGEP1_32(ir.getInt8Ty(),
+                        buffer, from - start);
+      auto* memcpy = ir.CreateMemCpy(ma.data_out, 1, buf_gep, 1,
+                                     ma.data_length);
+      LLVM_DEBUG(dbgs() << "Replacing " << *inst << " with\n"
+                        << *buf_gep << '\n' << *memcpy << '\n');
+
+      if( !inst->use_empty() ) {
+        auto* rel = ir.CreateSub(new_read, ir.getInt64(from - start));
+        auto* neg = ir.CreateICmpSLT(rel, ir.getInt64(0));
+        rel = ir.CreateSelect(neg, ir.getInt64(0), rel);
+        auto* over = ir.CreateICmpSGT(rel, ma.data_length);
+        rel = ir.CreateSelect(over, ma.data_length, rel);
+        inst->replaceAllUsesWith(rel);
+      }
+      dead->push_back(inst);
+    }
+  } else if( ma.has_type(NANOTUBE_MAP_WRITE) ) {
+    unsigned mask_len = (len + 7) / 8;
+    auto* mask = ir.CreateAlloca(ir.getInt8Ty(), ir.getInt32(mask_len),
+                                 "map_op_mask_off" + Twine(start));
+    ir.CreateMemSet(mask, ir.getInt8(0), mask_len, 0);
+
+    /* A write with an empty mask still inserts a missing key, so the
+     * merged write must only happen if one of the original writes was
+     * executed.  Track that in a flag and turn the merged write into a
+     * NOP otherwise. */
+    auto* valid = ir.CreateAlloca(ir.getInt1Ty(), nullptr,
+                                  "map_op_valid_off" + Twine(start));
+    ir.CreateStore(ir.getFalse(), valid);
+
+    /* Create the final, merged write */
+    ir.SetInsertPoint(g->insert_point);
+    auto* any_write = ir.CreateLoad(valid);
+    auto* nop = ConstantInt::get(ma.type->getType(), NANOTUBE_MAP_NOP);
+    auto* type = ir.CreateSelect(any_write, ma.type, nop);
+    Value* args[] = { ma.ctx, ma.map, type, ma.key, ma.key_length,
+                      buffer, null_ptr, mask,
+                      ir.getInt64(start), ir.getInt64(len) };
+    auto* new_write = ir.CreateCall(nt_map_op, args);
+    LLVM_DEBUG(dbgs() << "New buffer: " << *buffer
+                      << "\nMask: " << *mask
+                      << "\nNew map write: " << *new_write << '\n');
+
+    /* Merge data and mask of the original writes into the buffers */
+    auto* merge_data_mask = create_nt_merge_data_mask(*m);
+    for( auto& inst_rng : g->accesses ) {
+      auto* inst = std::get<0>(inst_rng);
+      auto  from = std::get<1>(inst_rng);
+      map_access ma(inst);
+      ir.SetInsertPoint(inst);
+
+      Value* merge_args[] = { buffer, mask, ma.data_in, ma.mask,
+                              ir.getInt64(from - start),
+                              ma.data_length };
+      auto* mrg = ir.CreateCall(merge_data_mask, merge_args);
+      ir.CreateStore(ir.getTrue(), valid);
+      LLVM_DEBUG(dbgs() << "Replacing " << *inst << " with\n"
+                        << *mrg << '\n');
+      dead->push_back(inst);
+    }
+  } else {
+    errs() << "ERROR: Unexpected map access type in group " << *g
+           << "\nAborting!\n";
+    abort();
+  }
+}
+
 
 char optimise_requests::ID = 0;
 static RegisterPass<optimise_requests>
@@ -192,6 +192,10 @@ void platform::process_packet_kernel(CallBase *setup_call)
         adjust_return(&insn);
         break;
 
+      case Intrinsics::packet_csum:
+        adjust_offset_arg(&insn, PACKET_CSUM_OFFSET_ARG);
+        break;
+
       case Intrinsics::packet_set_port:
         adjust_set_port(&insn);
         break;
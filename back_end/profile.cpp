@@ -0,0 +1,403 @@
+/**************************************************************************\
+*//*! \file profile.cpp
+** \brief  Passes to collect and apply execution profiles.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+// The nt-profile-gen and nt-profile-use passes
+// ============================================
+//
+// Packet processing is usually dominated by a single fast path, such
+// as the lookup of an established flow.  The converge, optreq and
+// flatten-cfg passes can favour that path if they know which basic
+// blocks of the packet kernel are executed most often.  These passes
+// provide that information.
+//
+// The nt-profile-gen pass instruments the packet kernels so that the
+// software model counts how often each control flow edge is taken.
+// The test harness writes the counts to a file when given the
+// --profile-out option.  The nt-profile-use pass then reads the file
+// and attaches the counts to the packet kernels of the same program
+// as branch weights and function entry counts.  LLVM keeps this
+// metadata up to date as the later passes transform the code, so the
+// passes which use it only need to compute the block frequencies.
+//
+// Input conditions
+// ----------------
+//
+// nt-profile-use must be run on the same bitcode as nt-profile-gen,
+// since the counts are identified by the index of the basic block in
+// the function.
+//
+// Output conditions
+// -----------------
+//
+// nt-profile-gen: Each basic block of each packet kernel calls
+// nanotube_profile_block before its terminator.
+//
+// nt-profile-use: The terminators of the packet kernels which have
+// been executed and have multiple successors have branch_weights
+// metadata.  Each packet kernel which appears in the profile has an
+// entry count.
+//
+// Theory of operation
+// -------------------
+//
+// The call inserted by nt-profile-gen passes the name of the
+// function, the index of the basic block and the index of the
+// successor which is about to be taken.  The successor index of a
+// conditional branch is computed with a select and the successor
+// index of a switch is computed with a chain of compares and selects.
+// This is sufficient to reconstruct the block counts and the branch
+// weights.
+//
+// The profile file is a text file with one line per control flow edge
+// which was taken at least once:
+//
+//   <function> <block index> <successor index> <count>
+//
+// Lines starting with # are comments.
+
+#include "profile.hpp"
+
+#include "Intrinsics.h"
+#include "llvm_common.h"
+#include "llvm_insns.h"
+#include "llvm_pass.h"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/LineIterator.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#define DEBUG_TYPE "nt-profile"
+using namespace llvm;
+using namespace nanotube;
+
+///////////////////////////////////////////////////////////////////////////
+
+static cl::opt<std::string>
+opt_profile("nt-profile",
+            cl::desc("The profile file read by the nt-profile-use pass."),
+            cl::init(""));
+
+static cl::opt<unsigned>
+opt_hot_percent("nt-profile-hot-percent",
+                cl::desc("The percentage of kernel invocations which must"
+                         " execute a basic block for it to be hot."),
+                cl::init(50));
+
+static cl::opt<unsigned>
+opt_cold_percent("nt-profile-cold-percent",
+                 cl::desc("The percentage of kernel invocations below"
+                          " which a basic block is cold."),
+                 cl::init(1));
+
+///////////////////////////////////////////////////////////////////////////
+
+block_profile::block_profile(Function& f, const DominatorTree& dt):
+  m_entry_count(0)
+{
+  auto entry = f.getEntryCount();
+  if (!entry.hasValue() || entry.getCount() == 0)
+    return;
+
+  LoopInfo li(dt);
+  BranchProbabilityInfo bpi(f, li);
+  BlockFrequencyInfo bfi(f, bpi, li);
+
+  m_entry_count = entry.getCount();
+  for (auto &bb: f) {
+    auto count = bfi.getBlockProfileCount(&bb);
+    m_counts[&bb] = (count.hasValue() ? count.getValue() : 0);
+  }
+}
+
+uint64_t block_profile::count(const BasicBlock* bb) const
+{
+  auto it = m_counts.find(bb);
+  return (it == m_counts.end() ? 0 : it->second);
+}
+
+bool block_profile::is_hot(const BasicBlock* bb) const
+{
+  return ( valid() &&
+           count(bb) * 100 >= m_entry_count * opt_hot_percent );
+}
+
+bool block_profile::is_cold(const BasicBlock* bb) const
+{
+  return ( valid() &&
+           count(bb) * 100 < m_entry_count * opt_cold_percent );
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+  class profile_gen_pass: public llvm::ModulePass {
+  public:
+    static char ID;
+
+    profile_gen_pass();
+    StringRef getPassName() const override {
+      return "Instrument packet kernels to collect a profile";
+    }
+
+    bool runOnModule(Module &m) override;
+  };
+
+  class profile_use_pass: public llvm::ModulePass {
+  public:
+    static char ID;
+
+    profile_use_pass();
+    StringRef getPassName() const override {
+      return "Apply a profile to packet kernels";
+    }
+
+    bool runOnModule(Module &m) override;
+  };
+
+  // The edge counts of a function indexed by basic block and then by
+  // successor.
+  typedef std::vector<std::vector<uint64_t>> func_profile_t;
+  typedef std::map<std::string, func_profile_t> profile_t;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+// Determine the index of the successor which will be taken by a
+// terminator.
+static Value *get_successor_index(IRBuilder<> &ir, Instruction *term)
+{
+  if (auto *br = dyn_cast<BranchInst>(term)) {
+    if (br->isUnconditional())
+      return ir.getInt32(0);
+    return ir.CreateSelect(br->getCondition(), ir.getInt32(0),
+                           ir.getInt32(1), "profile_succ");
+  }
+
+  if (auto *sw = dyn_cast<SwitchInst>(term)) {
+    // Successor zero is the default destination.
+    Value *index = ir.getInt32(0);
+    for (auto &c: sw->cases()) {
+      Value *match = ir.CreateICmpEQ(sw->getCondition(),
+                                     c.getCaseValue());
+      index = ir.CreateSelect(match, ir.getInt32(c.getSuccessorIndex()),
+                              index, "profile_succ");
+    }
+    return index;
+  }
+
+  if (term->getNumSuccessors() > 1) {
+    errs() << "ERROR: Cannot profile the terminator " << *term
+           << " in function " << term->getFunction()->getName()
+           << ".\n";
+    exit(1);
+  }
+  return ir.getInt32(0);
+}
+
+char profile_gen_pass::ID;
+
+profile_gen_pass::profile_gen_pass():
+  ModulePass(ID)
+{
+}
+
+bool profile_gen_pass::runOnModule(Module &m)
+{
+  LLVMContext &context = m.getContext();
+  Type *void_type = Type::getVoidTy(context);
+  Type *int8_ptr_type = Type::getInt8PtrTy(context);
+  Type *int32_type = Type::getInt32Ty(context);
+  Type *arg_types[] = { int8_ptr_type, int32_type, int32_type };
+  FunctionType *func_type = FunctionType::get(void_type, arg_types, false);
+  Constant *profile_func =
+    m.getOrInsertFunction("nanotube_profile_block", func_type);
+
+  bool any_changes = false;
+  for (Function &f: m) {
+    if (f.empty() || !is_nt_packet_kernel(f))
+      continue;
+
+    IRBuilder<> ir(&*f.getEntryBlock().getFirstInsertionPt());
+    Value *name = ir.CreateGlobalStringPtr(f.getName(),
+                                           "nt_profile_name");
+
+    uint32_t index = 0;
+    for (BasicBlock &bb: f) {
+      Instruction *term = bb.getTerminator();
+      ir.SetInsertPoint(term);
+      Value *args[] = { name, ir.getInt32(index),
+                        get_successor_index(ir, term) };
+      ir.CreateCall(profile_func, args);
+      index++;
+    }
+
+    LLVM_DEBUG(dbgs() << "Instrumented " << index << " basic blocks of "
+                      << f.getName() << '\n');
+    any_changes = true;
+  }
+
+  return any_changes;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+// Read the profile file.  Report an error if it cannot be parsed.
+static void read_profile(const std::string &filename, profile_t *profile)
+{
+  auto buf = MemoryBuffer::getFile(filename);
+  if (!buf) {
+    errs() << "ERROR: Cannot read profile '" << filename << "': "
+           << buf.getError().message() << "\n";
+    exit(1);
+  }
+
+  for (line_iterator it(**buf, true, '#'); !it.is_at_eof(); ++it) {
+    SmallVector<StringRef, 4> fields;
+    it->split(fields, ' ', -1, false);
+
+    unsigned block, succ;
+    uint64_t count;
+    if (fields.size() != 4 ||
+        fields[1].getAsInteger(10, block) ||
+        fields[2].getAsInteger(10, succ) ||
+        fields[3].getAsInteger(10, count)) {
+      errs() << "ERROR: " << filename << ":" << it.line_number()
+             << ": Invalid profile entry '" << *it << "'.\n";
+      exit(1);
+    }
+
+    auto &func_prof = (*profile)[fields[0].str()];
+    if (func_prof.size() <= block)
+      func_prof.resize(block+1);
+    auto &block_prof = func_prof[block];
+    if (block_prof.size() <= succ)
+      block_prof.resize(succ+1, 0);
+    block_prof[succ] += count;
+  }
+}
+
+// Attach the profile to a function.  Report an error if the profile
+// does not match the function.
+static void apply_profile(Function &f, const func_profile_t &func_prof)
+{
+  if (func_prof.size() > f.size()) {
+    errs() << "ERROR: The profile of function " << f.getName()
+           << " has " << func_prof.size() << " basic blocks but the"
+           << " function has " << f.size() << ".\n"
+           << "Was the profile collected from different bitcode?\n";
+    exit(1);
+  }
+
+  MDBuilder mdb(f.getContext());
+  uint64_t entry_count = 0;
+  unsigned index = 0;
+  for (BasicBlock &bb: f) {
+    if (index >= func_prof.size())
+      break;
+    auto &counts = func_prof[index++];
+    Instruction *term = bb.getTerminator();
+    unsigned num_succs = term->getNumSuccessors();
+    if (counts.size() > std::max(num_succs, 1U)) {
+      errs() << "ERROR: The profile of basic block " << bb.getName()
+             << " in function " << f.getName() << " has "
+             << counts.size() << " successors.\n"
+             << "Was the profile collected from different bitcode?\n";
+      exit(1);
+    }
+
+    uint64_t total = 0;
+    uint64_t max_count = 0;
+    for (uint64_t count: counts) {
+      total += count;
+      max_count = std::max(max_count, count);
+    }
+    if (&bb == &f.getEntryBlock())
+      entry_count = total;
+    if (num_succs < 2 || total == 0)
+      continue;
+
+    // Branch weights are 32 bits wide, so scale the counts down if
+    // necessary.
+    uint64_t scale = max_count / UINT32_MAX + 1;
+    SmallVector<uint32_t, 4> weights(num_succs, 0);
+    for (unsigned i=0; i<counts.size(); i++)
+      weights[i] = uint32_t(counts[i] / scale);
+    term->setMetadata(LLVMContext::MD_prof,
+                      mdb.createBranchWeights(weights));
+  }
+
+  f.setEntryCount(entry_count);
+  LLVM_DEBUG(dbgs() << "Applied profile to " << f.getName()
+                    << " with entry count " << entry_count << '\n');
+}
+
+char profile_use_pass::ID;
+
+profile_use_pass::profile_use_pass():
+  ModulePass(ID)
+{
+}
+
+bool profile_use_pass::runOnModule(Module &m)
+{
+  if (opt_profile.empty()) {
+    errs() << "ERROR: The nt-profile-use pass requires the -nt-profile"
+           << " option.\n";
+    exit(1);
+  }
+
+  profile_t profile;
+  read_profile(opt_profile, &profile);
+
+  bool any_changes = false;
+  for (Function &f: m) {
+    if (f.empty() || !is_nt_packet_kernel(f))
+      continue;
+
+    auto it = profile.find(f.getName().str());
+    if (it == profile.end()) {
+      errs() << "WARNING: No profile for packet kernel " << f.getName()
+             << ".\n";
+      continue;
+    }
+    apply_profile(f, it->second);
+    any_changes = true;
+  }
+
+  return any_changes;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+static RegisterPass<profile_gen_pass>
+register_gen_pass("nt-profile-gen",
+                  "Instrument packet kernels to collect a profile",
+                  false,
+                  false
+  );
+
+static RegisterPass<profile_use_pass>
+register_use_pass("nt-profile-use", "Apply a profile to packet kernels",
+                  false,
+                  false
+  );
+
+///////////////////////////////////////////////////////////////////////////
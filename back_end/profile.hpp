@@ -0,0 +1,51 @@
+#ifndef __PROFILE_HPP__
+#define __PROFILE_HPP__
+/*******************************************************/
+/*! \file profile.hpp
+**  \brief Execution profiles of packet kernels.
+*//******************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace nanotube {
+  /*!
+  ** The execution counts of the basic blocks of a function.
+  **
+  ** The counts are derived from the branch weights and the entry
+  ** count which were attached by the nt-profile-use pass.  They are
+  ** estimates, because the passes which ran since then may have
+  ** changed the control flow.  The profile is not valid if the
+  ** function has no profile data or was never executed.
+  **/
+  class block_profile {
+  public:
+    block_profile(llvm::Function& f, const llvm::DominatorTree& dt);
+
+    bool valid() const { return m_entry_count != 0; }
+    uint64_t entry_count() const { return m_entry_count; }
+    uint64_t count(const llvm::BasicBlock* bb) const;
+
+    /* Whether the block is executed for a large fraction of the calls
+     * of the function, see -nt-profile-hot-percent. */
+    bool is_hot(const llvm::BasicBlock* bb) const;
+    /* Whether the block is executed for a small fraction of the calls
+     * of the function, see -nt-profile-cold-percent. */
+    bool is_cold(const llvm::BasicBlock* bb) const;
+
+  private:
+    uint64_t m_entry_count;
+    std::unordered_map<const llvm::BasicBlock*, uint64_t> m_counts;
+  };
+}; // namespace nanotube
+#endif //__PROFILE_HPP__
+/* vim: set ts=8 et sw=2 sts=2 tw=75: */
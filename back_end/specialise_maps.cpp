@@ -0,0 +1,762 @@
+/**************************************************************************\
+*//*! \file specialise_maps.cpp
+** \brief  Specialise packet kernels against static map contents.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+// The specialise-maps pass
+// ========================
+//
+// Many deployments load some maps once at setup time and never change
+// them while packets are being processed, for example a table which
+// maps virtual IPs to backends.  The pipeline still performs a map
+// access for each lookup in such a map, which costs a map tap, the
+// stages around it and the latency of the request.  This pass takes a
+// snapshot of the map contents and replaces the lookups with inline
+// logic which computes the result directly.
+//
+// The snapshot is given with the -map-snapshot option and uses the
+// format read by the --map-load option of the test harness.  Each map
+// in the snapshot is treated as static.
+//
+// Input conditions
+// ----------------
+//
+// The map accesses are calls to nanotube_map_op, as produced by the
+// mem2req pass.  The map IDs are constant.
+//
+// Output conditions
+// -----------------
+//
+// Each call to nanotube_map_op which reads a static map with constant
+// key length, offset and data length is replaced with the equivalent
+// inline logic.  A map which is no longer accessed is removed from the
+// setup function.  The input conditions are preserved.
+//
+// A map is not specialised if any access to it could modify it, since
+// the snapshot would then not describe its contents.  A warning is
+// issued in that case.
+//
+// Theory of operation
+// -------------------
+//
+// The result of a read is determined by whether the key was found and,
+// if so, by the value of the entry.  The length returned for a hit
+// only depends on the constant offset and data length, so it is the
+// same for all entries.  The key is loaded from memory as an integer
+// and the pass computes a hit flag and the data which are written to
+// the data_out buffer.
+//
+// Small tables are converted to match logic.  The entries are grouped
+// by the data they return and each group is matched with a chain of
+// comparisons.  The data is then selected by the group which matched.
+// Entries which return zero data only contribute to the hit flag, so a
+// table which only checks membership needs no data selection at all.
+// Lookups with a constant key are folded by the instcombine pass which
+// runs afterwards.
+//
+// Tables with more than -map-snapshot-max-compare entries are converted
+// into ROMs, which are constant global arrays.  Array maps are indexed
+// directly by the key.  Hash maps use a multiplicative perfect hash
+// which is found by trying pseudo-random multipliers for increasing
+// table sizes.  The ROM holds the key of each entry so that the hit
+// flag can be determined by comparing it with the lookup key.  Empty
+// slots hold the key of an entry which hashes to a different slot, so
+// they never match.  Reads of the same map share its ROMs.  Tables with
+// more than -map-snapshot-max-rom entries are left as map accesses.
+//
+// A read without a data buffer always returns zero, so it is replaced
+// with a constant.
+
+#include "Intrinsics.h"
+#include "llvm_common.h"
+#include "llvm_insns.h"
+#include "llvm_pass.h"
+
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#define DEBUG_TYPE "specialise-maps"
+using namespace llvm;
+using namespace nanotube;
+
+///////////////////////////////////////////////////////////////////////////
+
+static cl::opt<std::string>
+opt_snapshot("map-snapshot",
+             cl::desc("The map contents used by the specialise-maps pass."),
+             cl::init(""));
+
+static cl::opt<unsigned>
+opt_max_compare("map-snapshot-max-compare",
+                cl::desc("The maximum number of comparisons used for a"
+                         " static map lookup before using a ROM."),
+                cl::init(8));
+
+static cl::opt<unsigned>
+opt_max_rom("map-snapshot-max-rom",
+            cl::desc("The maximum number of entries of a static map ROM."),
+            cl::init(1024));
+
+// The maximum size of a key or data which is handled inline.
+static const unsigned max_inline_bytes = 64;
+
+// The maximum number of multipliers tried for each perfect hash table
+// size.
+static const unsigned max_hash_attempts = 1000;
+
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+  // The contents of a map in the snapshot.
+  struct static_map {
+    nanotube_map_id_t id;
+    enum map_type_t type;
+    unsigned key_sz;
+    unsigned value_sz;
+    // The entries, indexed by key.
+    std::map<std::vector<uint8_t>, std::vector<uint8_t>> entries;
+  };
+
+  typedef std::map<nanotube_map_id_t, static_map> snapshot_t;
+
+  // A group of keys which return the same data.
+  struct key_group {
+    APInt data;
+    std::vector<APInt> keys;
+  };
+
+  // A perfect hash function for a set of keys.
+  struct perfect_hash {
+    uint64_t multiplier;
+    unsigned log2_size;
+
+    uint64_t slot(uint64_t key) const {
+      return (key * multiplier) >> (64 - log2_size);
+    }
+  };
+
+  class specialise_maps_pass: public llvm::ModulePass {
+  public:
+    static char ID;
+
+    specialise_maps_pass();
+    StringRef getPassName() const override {
+      return "Specialise packet kernels against static map contents";
+    }
+
+    bool runOnModule(Module &m) override;
+
+  private:
+    bool specialise_read(CallInst *call, const static_map &map);
+    Value *create_compare(IRBuilder<> &ir, const static_map &map,
+                          Value *key, ArrayRef<key_group> groups,
+                          unsigned num_keys, Value **hit_out);
+    Value *create_rom(IRBuilder<> &ir, const static_map &map,
+                      Value *key, ArrayRef<key_group> groups,
+                      unsigned num_keys, uint64_t offset,
+                      Value **hit_out);
+
+    // The snapshot being applied.
+    snapshot_t m_snapshot;
+
+    // The perfect hash and the key ROM of each hash map.  They only
+    // depend on the keys, so they are shared by all the reads.
+    std::map<nanotube_map_id_t, std::pair<perfect_hash, GlobalVariable *>>
+      m_key_roms;
+
+    // The data ROM for each map, offset and data length.
+    std::map<std::tuple<nanotube_map_id_t, uint64_t, unsigned>,
+             GlobalVariable *> m_data_roms;
+
+    // The data layout of the module.
+    const DataLayout *m_data_layout;
+  };
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+// Read the snapshot file.  Report an error if it cannot be parsed.
+static void read_snapshot(const std::string &filename,
+                          snapshot_t *snapshot)
+{
+  auto buf = MemoryBuffer::getFile(filename);
+  if (!buf) {
+    errs() << "ERROR: Cannot read map snapshot '" << filename << "': "
+           << buf.getError().message() << "\n";
+    exit(1);
+  }
+
+  // Split the file into words, dropping comments.
+  std::vector<StringRef> words;
+  SmallVector<StringRef, 64> lines;
+  (*buf)->getBuffer().split(lines, '\n');
+  for (StringRef line: lines) {
+    line = line.split('#').first;
+    SmallVector<StringRef, 16> fields;
+    SplitString(line, fields);
+    words.insert(words.end(), fields.begin(), fields.end());
+  }
+
+  auto fail = [&](const Twine &msg) {
+    errs() << "ERROR: " << filename << ": " << msg << "\n";
+    exit(1);
+  };
+
+  auto read_bytes = [&](size_t &pos, unsigned count,
+                        std::vector<uint8_t> *out) {
+    for (unsigned i=0; i<count; i++) {
+      unsigned byte;
+      if (pos >= words.size() || words[pos].getAsInteger(16, byte) ||
+          byte > 255)
+        fail("Invalid byte in map entry.");
+      out->push_back(uint8_t(byte));
+      pos++;
+    }
+  };
+
+  size_t pos = 0;
+  while (pos < words.size()) {
+    static_map map;
+    unsigned id, type;
+    if (words[pos] != "nanotube_map:" || pos + 5 > words.size() ||
+        words[pos+1].getAsInteger(10, id) ||
+        words[pos+2].getAsInteger(10, type) ||
+        words[pos+3].getAsInteger(10, map.key_sz) ||
+        words[pos+4].getAsInteger(10, map.value_sz))
+      fail("Invalid map header.");
+    map.id = nanotube_map_id_t(id);
+    map.type = (enum map_type_t)type;
+    if (map.type != NANOTUBE_MAP_TYPE_HASH &&
+        map.type != NANOTUBE_MAP_TYPE_ARRAY_LE)
+      fail("Unsupported type " + Twine(type) + " of map " + Twine(id) +
+           ".");
+    pos += 5;
+
+    while (true) {
+      if (pos >= words.size())
+        fail("Missing end of map " + Twine(id) + ".");
+      if (words[pos] == "end") {
+        pos++;
+        break;
+      }
+      if (words[pos] != "key:")
+        fail("Expected a key in map " + Twine(id) + ".");
+      pos++;
+      std::vector<uint8_t> key, value;
+      read_bytes(pos, map.key_sz, &key);
+      if (pos >= words.size() || words[pos] != "value:")
+        fail("Expected a value in map " + Twine(id) + ".");
+      pos++;
+      read_bytes(pos, map.value_sz, &value);
+      map.entries[key] = value;
+    }
+
+    if (!snapshot->emplace(map.id, std::move(map)).second)
+      fail("Map " + Twine(id) + " appears more than once.");
+  }
+}
+
+// Convert bytes in memory order to the integer which is loaded from
+// them.
+static APInt bytes_to_apint(ArrayRef<uint8_t> bytes, bool little_endian)
+{
+  unsigned n = bytes.size();
+  APInt result(n * 8, 0);
+  for (unsigned i=0; i<n; i++) {
+    unsigned pos = (little_endian ? i : n - 1 - i);
+    result.insertBits(APInt(8, bytes[i]), pos * 8);
+  }
+  return result;
+}
+
+// The number of bytes returned by a read which hits.
+static uint64_t hit_length(const static_map &map, uint64_t offset,
+                           uint64_t length)
+{
+  if (offset >= map.value_sz)
+    return 0;
+  return std::min<uint64_t>(length, map.value_sz - offset);
+}
+
+// Find a perfect hash function for the keys.  Returns false if none
+// was found.
+static bool find_perfect_hash(const std::vector<uint64_t> &keys,
+                              nanotube_map_id_t id, perfect_hash *hash)
+{
+  unsigned log2_min = std::max(1U, Log2_64_Ceil(keys.size()));
+  std::mt19937_64 rng(0x6e616e6f74756265ULL ^ id);
+  std::vector<bool> used;
+
+  for (unsigned log2_size = log2_min; log2_size <= log2_min + 2;
+       log2_size++) {
+    if ((uint64_t(1) << log2_size) > opt_max_rom)
+      break;
+    for (unsigned attempt=0; attempt<max_hash_attempts; attempt++) {
+      hash->multiplier = rng() | 1;
+      hash->log2_size = log2_size;
+      used.assign(size_t(1) << log2_size, false);
+      bool ok = true;
+      for (uint64_t key: keys) {
+        auto slot = hash->slot(key);
+        if (used[slot]) {
+          ok = false;
+          break;
+        }
+        used[slot] = true;
+      }
+      if (ok)
+        return true;
+    }
+  }
+  return false;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+char specialise_maps_pass::ID;
+
+specialise_maps_pass::specialise_maps_pass():
+  ModulePass(ID)
+{
+}
+
+// Create match logic.  Each group is matched with a chain of
+// comparisons and selects its data.
+Value *specialise_maps_pass::create_compare(IRBuilder<> &ir,
+                                            const static_map &map,
+                                            Value *key,
+                                            ArrayRef<key_group> groups,
+                                            unsigned num_keys,
+                                            Value **hit_out)
+{
+  auto *key_type = cast<IntegerType>(key->getType());
+  Value *hit = nullptr;
+  Value *data = nullptr;
+  APInt zero;
+
+  // Array maps hold an entry for each index below the capacity.
+  if (map.type == NANOTUBE_MAP_TYPE_ARRAY_LE) {
+    hit = ir.CreateICmpULT(key, ConstantInt::get(key_type,
+                             nanotube_array_map_capacity),
+                           "map_hit");
+  }
+
+  for (auto &group: groups) {
+    if (data == nullptr) {
+      zero = APInt(group.data.getBitWidth(), 0);
+      data = ir.getInt(zero);
+    }
+    Value *match = nullptr;
+    for (auto &k: group.keys) {
+      Value *eq = ir.CreateICmpEQ(key, ir.getInt(k), "map_match");
+      match = (match == nullptr ? eq : ir.CreateOr(match, eq, "map_match"));
+    }
+    if (map.type != NANOTUBE_MAP_TYPE_ARRAY_LE)
+      hit = (hit == nullptr ? match : ir.CreateOr(hit, match, "map_hit"));
+    if (group.data != zero)
+      data = ir.CreateSelect(match, ir.getInt(group.data), data,
+                             "map_data");
+  }
+
+  LLVM_DEBUG(dbgs() << "  Using " << num_keys << " comparisons.\n");
+  *hit_out = (hit == nullptr ? ir.getFalse() : hit);
+  return data;
+}
+
+// Create a ROM lookup.  Array maps are indexed by the key and hash maps
+// use a perfect hash.  The ROMs are shared by reads of the same map
+// with the same offset and data length.
+Value *specialise_maps_pass::create_rom(IRBuilder<> &ir,
+                                        const static_map &map,
+                                        Value *key,
+                                        ArrayRef<key_group> groups,
+                                        unsigned num_keys,
+                                        uint64_t offset,
+                                        Value **hit_out)
+{
+  Module &m = *ir.GetInsertBlock()->getModule();
+  auto *key_type = cast<IntegerType>(key->getType());
+  auto *data_type = ir.getIntNTy(groups.front().data.getBitWidth());
+  auto *i64_type = ir.getInt64Ty();
+  bool is_array = (map.type == NANOTUBE_MAP_TYPE_ARRAY_LE);
+
+  // Determine the slot of each key.
+  perfect_hash hash;
+  GlobalVariable *key_rom = nullptr;
+  uint64_t rom_size;
+  Value *index;
+  Value *hit = nullptr;
+  if (is_array) {
+    rom_size = nanotube_array_map_capacity;
+    hit = ir.CreateICmpULT(key, ConstantInt::get(key_type, rom_size),
+                           "map_hit");
+    index = ir.CreateZExtOrTrunc(key, i64_type);
+    index = ir.CreateSelect(hit, index, ir.getInt64(0), "map_index");
+  } else {
+    auto it = m_key_roms.find(map.id);
+    if (it != m_key_roms.end()) {
+      hash = it->second.first;
+      key_rom = it->second.second;
+    } else {
+      std::vector<uint64_t> keys;
+      for (auto &group: groups)
+        for (auto &k: group.keys)
+          keys.push_back(k.getZExtValue());
+      if (!find_perfect_hash(keys, map.id, &hash))
+        return nullptr;
+    }
+    rom_size = uint64_t(1) << hash.log2_size;
+    index = ir.CreateZExt(key, i64_type);
+    index = ir.CreateMul(index, ir.getInt64(hash.multiplier), "map_hash");
+    index = ir.CreateLShr(index, 64 - hash.log2_size, "map_index");
+  }
+
+  // Fill in the ROM contents.
+  APInt zero(data_type->getBitWidth(), 0);
+  std::vector<Constant *> data_elems(rom_size, ir.getInt(zero));
+  std::vector<Constant *> key_elems;
+  if (!is_array) {
+    Constant *empty = ir.getInt(groups.front().keys.front());
+    key_elems.assign(rom_size, empty);
+  }
+  for (auto &group: groups) {
+    for (auto &k: group.keys) {
+      uint64_t slot = (is_array ? k.getZExtValue() :
+                       hash.slot(k.getZExtValue()));
+      data_elems[slot] = ir.getInt(group.data);
+      if (!is_array)
+        key_elems[slot] = ir.getInt(k);
+    }
+  }
+
+  auto create_global = [&](Type *elem_type, ArrayRef<Constant *> elems,
+                           const Twine &name) {
+    auto *array_type = ArrayType::get(elem_type, elems.size());
+    auto *init = ConstantArray::get(array_type, elems);
+    return new GlobalVariable(m, array_type, true,
+                              GlobalValue::PrivateLinkage, init,
+                              name);
+  };
+  auto load_rom = [&](GlobalVariable *rom, const Twine &name) {
+    Value *indices[] = { ir.getInt64(0), index };
+    Value *ptr = ir.CreateInBoundsGEP(rom->getValueType(), rom, indices);
+    return ir.CreateLoad(ptr, name);
+  };
+
+  std::string prefix = ("map" + Twine(unsigned(map.id))).str();
+  if (!is_array) {
+    if (key_rom == nullptr) {
+      key_rom = create_global(key_type, key_elems, prefix + "_keys");
+      m_key_roms[map.id] = std::make_pair(hash, key_rom);
+    }
+    Value *rom_key = load_rom(key_rom, "map_rom_key");
+    hit = ir.CreateICmpEQ(rom_key, key, "map_hit");
+  }
+  auto &data_rom = m_data_roms[std::make_tuple(map.id, offset,
+                                               data_type->getBitWidth())];
+  if (data_rom == nullptr)
+    data_rom = create_global(data_type, data_elems, prefix + "_data");
+  Value *data = load_rom(data_rom, "map_rom_data");
+  data = ir.CreateSelect(hit, data, ir.getInt(zero), "map_data");
+
+  LLVM_DEBUG(dbgs() << "  Using a ROM with " << rom_size << " entries for "
+                    << num_keys << " keys.\n");
+  *hit_out = hit;
+  return data;
+}
+
+// Replace a read from a static map with inline logic.  Returns whether
+// the read was replaced.
+bool specialise_maps_pass::specialise_read(CallInst *call,
+                                           const static_map &map)
+{
+  map_op_args args(call);
+
+  // Without a data buffer, nanotube_map_op returns zero whether the
+  // key is found or not.
+  if (isa<ConstantPointerNull>(args.data_out)) {
+    LLVM_DEBUG(dbgs() << "Replacing " << *call << " with zero.\n");
+    call->replaceAllUsesWith(ConstantInt::get(call->getType(), 0));
+    call->eraseFromParent();
+    return true;
+  }
+
+  auto *key_length = dyn_cast<ConstantInt>(args.key_length);
+  auto *offset = dyn_cast<ConstantInt>(args.offset);
+  auto *data_length = dyn_cast<ConstantInt>(args.data_length);
+  if (key_length == nullptr || offset == nullptr ||
+      data_length == nullptr) {
+    LLVM_DEBUG(dbgs() << "Non-constant arguments in " << *call << '\n');
+    return false;
+  }
+
+  uint64_t key_sz = key_length->getZExtValue();
+  uint64_t data_sz = data_length->getZExtValue();
+  if (key_sz != map.key_sz || key_sz == 0 || data_sz == 0 ||
+      key_sz > max_inline_bytes || data_sz > max_inline_bytes ||
+      isa<ConstantPointerNull>(args.key)) {
+    LLVM_DEBUG(dbgs() << "Unsupported sizes in " << *call << '\n');
+    return false;
+  }
+
+  // Array maps are indexed by the little-endian key.
+  bool little_endian = m_data_layout->isLittleEndian();
+  bool is_array = (map.type == NANOTUBE_MAP_TYPE_ARRAY_LE);
+  if (is_array && !little_endian)
+    return false;
+
+  // Determine the data returned for each key and group the keys.
+  uint64_t off = offset->getZExtValue();
+  uint64_t hit_len = hit_length(map, off, data_sz);
+  std::map<std::vector<uint8_t>, unsigned> group_index;
+  std::vector<key_group> groups;
+  unsigned num_keys = 0;
+  for (auto &entry: map.entries) {
+    APInt key = bytes_to_apint(entry.first, little_endian);
+    if (is_array && key.uge(nanotube_array_map_capacity))
+      continue;
+
+    std::vector<uint8_t> data(data_sz, 0);
+    for (uint64_t i=0; i<hit_len; i++)
+      data[i] = entry.second[off + i];
+
+    // Array map entries with zero data are covered by the range
+    // check.
+    bool is_zero = std::all_of(data.begin(), data.end(),
+                               [](uint8_t b) { return b == 0; });
+    if (is_array && is_zero)
+      continue;
+
+    auto ins = group_index.emplace(data, groups.size());
+    if (ins.second) {
+      groups.push_back(key_group());
+      groups.back().data = bytes_to_apint(data, little_endian);
+    }
+    groups[ins.first->second].keys.push_back(key);
+    num_keys++;
+  }
+
+  LLVM_DEBUG(dbgs() << "Specialising " << *call << " against map "
+                    << map.id << " with " << map.entries.size()
+                    << " entries.\n");
+
+  IRBuilder<> ir(call);
+  auto *key_type = ir.getIntNTy(key_sz * 8);
+  auto *data_type = ir.getIntNTy(data_sz * 8);
+  Value *hit = nullptr;
+  Value *data = nullptr;
+  if (num_keys == 0) {
+    // Every lookup returns zero data and only array maps can hit.
+    data = ConstantInt::get(data_type, 0);
+    hit = ir.getFalse();
+    if (is_array) {
+      Value *key = ir.CreateAlignedLoad(
+        ir.CreateBitCast(args.key, key_type->getPointerTo()), 1, "map_key");
+      hit = ir.CreateICmpULT(key, ConstantInt::get(key_type,
+                               nanotube_array_map_capacity),
+                             "map_hit");
+    }
+  } else {
+    Value *key = ir.CreateAlignedLoad(
+      ir.CreateBitCast(args.key, key_type->getPointerTo()), 1, "map_key");
+    if (num_keys <= opt_max_compare) {
+      data = create_compare(ir, map, key, groups, num_keys, &hit);
+    } else if (num_keys <= opt_max_rom &&
+               (is_array || key_sz <= 8)) {
+      data = create_rom(ir, map, key, groups, num_keys, off, &hit);
+    }
+    if (data == nullptr) {
+      // Leave the map access in place.  The key load is dead.
+      cast<Instruction>(key)->eraseFromParent();
+      errs() << "WARNING: Map " << map.id << " is too large to be"
+             << " specialised in " << call->getFunction()->getName()
+             << ".\n";
+      return false;
+    }
+  }
+
+  // Write the data buffer and return the length, as nanotube_map_op
+  // does.
+  Value *ptr = ir.CreateBitCast(args.data_out, data_type->getPointerTo());
+  ir.CreateAlignedStore(data, ptr, 1);
+  auto *len_type = call->getType();
+  Value *len = ir.CreateSelect(hit, ConstantInt::get(len_type, hit_len),
+                               ConstantInt::get(len_type, 0),
+                               "map_length");
+  call->replaceAllUsesWith(len);
+  call->eraseFromParent();
+  return true;
+}
+
+// Determine whether a call is a map access which could modify the
+// map.  The pointer returned by nanotube_map_lookup can be used to
+// write the entry.
+static bool may_modify_map(CallInst *call, Intrinsics::ID iid)
+{
+  switch (iid) {
+  case Intrinsics::map_op: {
+    auto *type = dyn_cast<ConstantInt>(call->getArgOperand(2));
+    return ( type == nullptr ||
+             ( type->getZExtValue() != NANOTUBE_MAP_READ &&
+               type->getZExtValue() != NANOTUBE_MAP_NOP ) );
+  }
+  case Intrinsics::map_read:
+    return false;
+  default:
+    return true;
+  }
+}
+
+bool specialise_maps_pass::runOnModule(Module &m)
+{
+  if (opt_snapshot.empty()) {
+    errs() << "ERROR: The specialise-maps pass requires the"
+           << " -map-snapshot option.\n";
+    exit(1);
+  }
+
+  m_snapshot.clear();
+  m_key_roms.clear();
+  m_data_roms.clear();
+  read_snapshot(opt_snapshot, &m_snapshot);
+  m_data_layout = &m.getDataLayout();
+
+  // Find the map accesses and the maps which are created.
+  std::map<nanotube_map_id_t, std::vector<CallInst *>> reads;
+  std::map<nanotube_map_id_t, unsigned> num_accesses;
+  std::set<nanotube_map_id_t> modified;
+  std::vector<CallInst *> creates;
+  for (Function &f: m) {
+    for (Instruction &insn: instructions(f)) {
+      auto *call = dyn_cast<CallInst>(&insn);
+      if (call == nullptr)
+        continue;
+      auto iid = get_intrinsic(call);
+      switch (iid) {
+      case Intrinsics::map_create:
+        creates.push_back(call);
+        continue;
+      case Intrinsics::map_op:
+      case Intrinsics::map_lookup:
+      case Intrinsics::map_read:
+      case Intrinsics::map_write:
+      case Intrinsics::map_insert:
+      case Intrinsics::map_update:
+      case Intrinsics::map_remove:
+        break;
+      default:
+        continue;
+      }
+
+      auto *id_val = dyn_cast<ConstantInt>(call->getArgOperand(1));
+      if (id_val == nullptr) {
+        // Any static map could be modified by this access.
+        if (may_modify_map(call, iid)) {
+          errs() << "WARNING: Map access with a non-constant ID in "
+                 << f.getName() << ", not specialising maps.\n";
+          return false;
+        }
+        continue;
+      }
+
+      auto id = nanotube_map_id_t(id_val->getZExtValue());
+      num_accesses[id]++;
+      if (may_modify_map(call, iid))
+        modified.insert(id);
+      else if (iid == Intrinsics::map_op)
+        reads[id].push_back(call);
+    }
+  }
+
+  // Check the maps created by the setup function against the
+  // snapshot.
+  for (CallInst *call: creates) {
+    map_create_args args(call);
+    auto it = m_snapshot.find(args.id);
+    if (it == m_snapshot.end())
+      continue;
+    auto *key_sz = dyn_cast<ConstantInt>(args.key_sz);
+    auto *value_sz = dyn_cast<ConstantInt>(args.value_sz);
+    if (args.type != it->second.type ||
+        (key_sz != nullptr && key_sz->getZExtValue() != it->second.key_sz) ||
+        (value_sz != nullptr &&
+         value_sz->getZExtValue() != it->second.value_sz)) {
+      errs() << "ERROR: Map " << args.id << " in the snapshot does not"
+             << " match the map created by the setup function.\n";
+      exit(1);
+    }
+  }
+
+  // Specialise the reads from the static maps.
+  bool any_changes = false;
+  for (auto &map_reads: reads) {
+    auto id = map_reads.first;
+    auto it = m_snapshot.find(id);
+    if (it == m_snapshot.end())
+      continue;
+    if (modified.count(id) != 0) {
+      errs() << "WARNING: Map " << id << " is modified by the program,"
+             << " not specialising it.\n";
+      continue;
+    }
+    for (CallInst *call: map_reads.second) {
+      if (specialise_read(call, it->second)) {
+        num_accesses[id]--;
+        any_changes = true;
+      }
+    }
+  }
+
+  // Remove the maps which are no longer accessed from the setup
+  // function.
+  for (CallInst *call: creates) {
+    map_create_args args(call);
+    if (m_snapshot.count(args.id) == 0 || num_accesses[args.id] != 0)
+      continue;
+    for (auto it = call->user_begin(); it != call->user_end(); ) {
+      auto *user = dyn_cast<CallInst>(*(it++));
+      if (user != nullptr &&
+          get_intrinsic(user) == Intrinsics::context_add_map)
+        user->eraseFromParent();
+    }
+    if (call->use_empty()) {
+      LLVM_DEBUG(dbgs() << "Removing map " << args.id << '\n');
+      call->eraseFromParent();
+      any_changes = true;
+    }
+  }
+
+  return any_changes;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+static RegisterPass<specialise_maps_pass>
+register_pass("specialise-maps",
+              "Specialise packet kernels against static map contents",
+              false,
+              false
+  );
+
+///////////////////////////////////////////////////////////////////////////
+/* vim: set ts=8 et sw=2 sts=2 tw=75: */
@@ -76,7 +76,10 @@ struct ebpf_to_NT : public ModulePass {
     BPF_MAP_LOOKUP      = 1,
     BPF_MAP_UPDATE      = 2,
     BPF_KTIME_GET_NS    = 5,
+    BPF_REDIRECT        = 23,
+    BPF_CSUM_DIFF       = 28,
     BPF_XDP_ADJUST_HEAD = 44,
+    BPF_REDIRECT_MAP    = 51,
     BPF_XDP_ADJUST_META = 54,
   };
 
@@ -179,6 +182,14 @@ struct ebpf_to_NT : public ModulePass {
       case BPF_MAP_TYPE_PERCPU_ARRAY:
         return NANOTUBE_MAP_TYPE_ARRAY_LE;
 
+      /* Redirect maps hold the port of each entry */
+      case BPF_MAP_TYPE_DEVMAP:
+        return NANOTUBE_MAP_TYPE_ARRAY_LE;
+      case BPF_MAP_TYPE_XSKMAP:
+        return NANOTUBE_MAP_TYPE_ARRAY_LE;
+      case BPF_MAP_TYPE_DEVMAP_HASH:
+        return NANOTUBE_MAP_TYPE_HASH;
+
       /* Unhandled */
       default:
         errs() << "Unknown / unhandled EBPF map type " << ebpf_map_type
@@ -889,6 +900,109 @@ struct ebpf_to_NT : public ModulePass {
     return nt_time_call;
   }
 
+  /*!
+   * Convert an EBPF csum_diff call into inline arithmetic.
+   * @param M Module where the call resides.
+   * @param call Call instruction that will be converted.
+   *
+   * The helper computes the ones-complement sum of the seed, the
+   * complemented words of the from buffer and the words of the to
+   * buffer.  The sizes must be constant multiples of four so that the
+   * loops can be unrolled.
+   */
+  Value* convert_to_csum_diff(Module* M, CallInst* call) {
+    /**
+     * s64 bpf_csum_diff(__be32 *from, u32 from_size, __be32 *to,
+     *                   u32 to_size, __wsum seed);
+     */
+    auto* from_sz = dyn_cast<ConstantInt>(call->getArgOperand(1));
+    auto* to_sz   = dyn_cast<ConstantInt>(call->getArgOperand(3));
+    if( from_sz == nullptr || to_sz == nullptr ||
+        (from_sz->getZExtValue() % 4) != 0 ||
+        (to_sz->getZExtValue() % 4) != 0 ) {
+      errs() << "ERROR: bpf_csum_diff needs constant sizes which are "
+             << "multiples of four in " << *call
+             << "\nAborting!\n";
+      exit(1);
+    }
+
+    IRBuilder<> ir(call);
+    auto*  i32p_ty = ir.getInt32Ty()->getPointerTo();
+    Value* sum = ir.CreateZExtOrTrunc(call->getArgOperand(4), ir.getInt64Ty());
+
+    /* Add the words of both buffers to the 64 bit sum */
+    Value*   bufs[]  = { call->getArgOperand(0), call->getArgOperand(2) };
+    uint64_t sizes[] = { from_sz->getZExtValue(), to_sz->getZExtValue() };
+    for( unsigned b = 0; b < 2; ++b ) {
+      auto* base = ir.CreatePointerCast(bufs[b], i32p_ty);
+      for( unsigned i = 0; i < sizes[b] / 4; ++i ) {
+        auto*  ptr  = ir.CreateConstGEP1_32(base, i);
+        Value* word = ir.CreateAlignedLoad(ptr, 1, "csum_word");
+        if( b == 0 )
+          word = ir.CreateNot(word);
+        sum = ir.CreateAdd(sum, ir.CreateZExt(word, ir.getInt64Ty()));
+      }
+    }
+
+    /* Fold the carries back into the low 32 bits */
+    for( unsigned i = 0; i < 2; ++i ) {
+      auto* lo = ir.CreateAnd(sum, ir.getInt64(0xffffffff));
+      auto* hi = ir.CreateLShr(sum, 32);
+      sum = ir.CreateAdd(lo, hi);
+    }
+    return ir.CreateZExtOrTrunc(sum, call->getType(), "csum_diff");
+  }
+
+  /*!
+   * Convert an EBPF redirect call into a call to the redirect adapter
+   * which sets the packet port.
+   * @param M Module where the call resides.
+   * @param call Call instruction that will be converted.
+   */
+  Value* convert_to_redirect(Module* M, CallInst* call) {
+    /**
+     * long bpf_redirect(u32 ifindex, u64 flags);
+     */
+    IRBuilder<> ir(call);
+    auto*  nt_packet = call->getFunction()->arg_begin() + 1;
+    Value* args[] = {
+      nt_packet,
+      ir.CreateZExtOrTrunc(call->getArgOperand(0), ir.getInt32Ty()),
+      ir.CreateZExtOrTrunc(call->getArgOperand(1), ir.getInt64Ty()),
+    };
+
+    Constant* ra = create_packet_redirect_adapter(*M);
+    auto* redirect = ir.CreateCall(ra, args, "redirect");
+    return ir.CreateSExtOrTrunc(redirect, call->getType());
+  }
+
+  Value* convert_to_redirect_map(Module* M, CallInst* call) {
+    LLVMContext& C = M->getContext();
+
+    /**
+     * long bpf_redirect_map(void *map, u32 key, u64 flags);
+     */
+    auto* map_id = get_map_id(C, call);
+    if( map_id == nullptr ) {
+      errs() << "ERROR: Could not convert " << *call
+             << "\nAborting!\n";
+      exit(1);
+    }
+
+    IRBuilder<> ir(call);
+    auto*  nt_ctx    = call->getFunction()->arg_begin();
+    auto*  nt_packet = call->getFunction()->arg_begin() + 1;
+    Value* args[] = {
+      nt_ctx, nt_packet, map_id,
+      ir.CreateZExtOrTrunc(call->getArgOperand(1), ir.getInt32Ty()),
+      ir.CreateZExtOrTrunc(call->getArgOperand(2), ir.getInt64Ty()),
+    };
+
+    Constant* rma = create_packet_redirect_map_adapter(*M);
+    auto* redirect = ir.CreateCall(rma, args, "redirect_map");
+    return ir.CreateSExtOrTrunc(redirect, call->getType());
+  }
+
   /*!
   ** Convert low-level Nanotube functions (EBPF) into Nanotube API L1
   ** @param F Function that is being traversed for EBPF map lookups.
@@ -915,6 +1029,15 @@ struct ebpf_to_NT : public ModulePass {
           case BPF_KTIME_GET_NS:
             conv = convert_to_nt_get_time_ns(F.getParent(), c);
             break;
+          case BPF_CSUM_DIFF:
+            conv = convert_to_csum_diff(F.getParent(), c);
+            break;
+          case BPF_REDIRECT:
+            conv = convert_to_redirect(F.getParent(), c);
+            break;
+          case BPF_REDIRECT_MAP:
+            conv = convert_to_redirect_map(F.getParent(), c);
+            break;
           default:
             continue;
         }
@@ -57,13 +57,47 @@ int32_t packet_adjust_head_adapter(nanotube_packet_t* packet,
                                    int32_t offset);
 
 /*!
-** Set the packet port so that it matches XDP semantics.
+** Set the packet port so that it matches XDP semantics.  XDP_PASS and
+** XDP_TX leave the port alone, so that XDP_TX sends the packet back out
+** of the port it arrived on, and XDP_REDIRECT keeps the port set by the
+** redirect helper.  All other results drop the packet.
 ** \param packet   The packet to adjust the port.
 ** \param xdp_ret  The XDP return code.
 **/
 extern
 nanotube_kernel_rc_t packet_handle_xdp_result(nanotube_packet_t* packet,
                                               int xdp_ret);
+
+/*!
+** Redirect a packet to an interface, like bpf_redirect.  The interface
+** index is used as the Nanotube port.
+** \param packet   The packet to redirect.
+** \param ifindex  The interface index.
+** \param flags    The redirect flags (ignored).
+** \return         XDP_REDIRECT on success, XDP_ABORTED if the interface
+**                 index is not a valid port.
+**/
+extern
+int32_t packet_redirect_adapter(nanotube_packet_t* packet, uint32_t ifindex,
+                                uint64_t flags);
+
+/*!
+** Redirect a packet to the interface found in a DEVMAP or XSKMAP, like
+** bpf_redirect_map.  The first four bytes of the map value are used as
+** the interface index.
+** \param map_id   Map-ID of the redirect map.
+** \param packet   The packet to redirect.
+** \param key      The index into the map.
+** \param flags    The lower two bits are returned if the key is not
+**                 found.
+** \return         XDP_REDIRECT on success, otherwise the fallback
+**                 action.
+**/
+extern
+int32_t packet_redirect_map_adapter(nanotube_context_t* ctx,
+                                    nanotube_packet_t* packet,
+                                    nanotube_map_id_t map_id,
+                                    uint32_t key, uint64_t flags);
 #ifdef __cplusplus
 }
 #endif
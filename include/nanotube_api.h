@@ -350,6 +350,22 @@ extern
 size_t nanotube_packet_bounded_length(nanotube_packet_t* packet,
                                       size_t max_length);
 
+/*!
+** Calculate the ones-complement sum of a region of the packet.
+** \param packet The input packet
+** \param offset Offset in bytes of the start of the region
+** \param length Number of bytes in the region
+** \param seed   A partial sum to add to the result
+** \return The folded 16-bit ones-complement sum, not inverted.
+**
+** The bytes are summed as big-endian 16-bit values, as described in
+** RFC 1071.  The part of the region beyond the end of the packet is
+** ignored.
+**/
+extern
+uint16_t nanotube_packet_csum(nanotube_packet_t* packet, size_t offset,
+                              size_t length, uint32_t seed);
+
 /*!
 ** Get the destination port of the specified packet.
 ** \param packet  The packet to examine
@@ -510,6 +526,21 @@ enum map_access_t {
   NANOTUBE_MAP_WRITE,       //< Either add or overwrite entry
   NANOTUBE_MAP_REMOVE,      //< Remove an entry from the map
   NANOTUBE_MAP_NOP,
+
+  /* Read-modify-write operations: the entry must exist, the accessed
+   * bytes are treated as one little-endian unsigned integer and are
+   * combined with data_in in a single request.  data_out receives the
+   * value from before the update. */
+  NANOTUBE_MAP_ADD,         //< Add data_in, wrapping around
+  NANOTUBE_MAP_ADD_SAT,     //< Add data_in, saturating at all-ones
+  NANOTUBE_MAP_MIN,         //< Keep the smaller of value and data_in
+  NANOTUBE_MAP_MAX,         //< Keep the larger of value and data_in
+
+  /* Iteration: data_out receives the key which follows the given key,
+   * or the first key if the given key is not present.  Nothing is
+   * returned after the last key.  Map taps return at most the value
+   * length of the key. */
+  NANOTUBE_MAP_NEXT_KEY,    //< Find the key following the given key
 };
 
 /*!
@@ -685,6 +716,28 @@ void nanotube_map_process_capsule(nanotube_context_t *ctxt,
                                   size_t key_len,
                                   size_t value_len);
 
+/*!
+** Process a map control capsule which may contain a batch of entries.
+**
+** The capsule buffer must hold at least
+** NANOTUBE_CAPSULE_MAP_BATCH_CAPSULE_SIZE(key_len, value_len,
+** max_entries) bytes.  Batches with more than max_entries entries are
+** rejected.
+**
+** \param ctxt        The Nanotube context.
+** \param map_id      The map ID of the map to access.
+** \param capsule     The buffer holding the capsule.
+** \param key_len     The length of the map key.
+** \param value_len   The length of the map value.
+** \param max_entries The maximum number of entries in a batch.
+**/
+void nanotube_map_process_capsule_batch(nanotube_context_t *ctxt,
+                                        nanotube_map_id_t map_id,
+                                        uint8_t *capsule,
+                                        size_t key_len,
+                                        size_t value_len,
+                                        size_t max_entries);
+
 /*!
 ** Print out the map specified with map_id to stdout.
 **
@@ -785,6 +838,32 @@ uint64_t nanotube_get_time_ns(void);
 **/
 void nanotube_debug_trace(uint64_t id, uint64_t value);
 
+/*!
+** Write the debug trace to a binary file.
+**
+** Subsequent calls to nanotube_debug_trace append records to per-thread
+** buffers which are written to the file by a separate thread.  The file
+** can be decoded with scripts/trace_decode.
+**
+** \param filename The name of the file to write.
+** \param sample   Only record every sample-th call of each thread.
+** \param id_min   The lowest ID to record.
+** \param id_max   The highest ID to record.
+** \return Zero on success or -1 if the file could not be opened.
+**/
+int nanotube_debug_trace_open(const char *filename, uint64_t sample,
+                              uint64_t id_min, uint64_t id_max);
+
+/*!
+** Finish writing the binary debug trace.
+**
+** Calls of nanotube_debug_trace which are in progress are allowed to
+** finish before the file is closed.  Later calls write to stderr again.
+**
+** \return Zero on success or -1 if the file could not be written.
+**/
+int nanotube_debug_trace_close(void);
+
 /*!
 ** Report the contents of a buffer to the debug log.
 **
@@ -795,6 +874,82 @@ void nanotube_debug_trace(uint64_t id, uint64_t value);
 void nanotube_trace_buffer(uint64_t id, uint8_t *buffer,
                            uint64_t size);
 
+/*!
+** Count a packet which was discarded early by a pipeline stage.
+**
+** Calls to this function are inserted by the pipeline pass when
+** -pipeline-early-drop is specified.  The count is kept per thread, so
+** each pipeline stage has its own count.
+**/
+void nanotube_debug_packet_dropped(void);
+
+/*!
+** Write the number of packets discarded early by each pipeline stage to
+** stdout and reset the counts.  Nothing is written if no packets were
+** discarded.
+**/
+void nanotube_debug_print_drops(void);
+
+/******************** Profiling ********************/
+
+/*!
+** Count the execution of a basic block of a packet kernel.
+**
+** Calls to this function are inserted by the nt-profile-gen pass.
+**
+** \param func  The name of the packet kernel.
+** \param block The index of the basic block in the packet kernel.
+** \param succ  The index of the successor taken by the basic block.
+**/
+void nanotube_profile_block(const char *func, uint32_t block,
+                            uint32_t succ);
+
+/*!
+** Write the profile counts to a file.
+**
+** The file can be read by the nt-profile-use pass.
+**
+** \param filename The name of the file to write.
+** \return Zero on success or -1 if the file could not be written.
+**/
+int nanotube_profile_write(const char *filename);
+
+
+/******************** Checksums ********************/
+
+/*!
+** Fold a 32-bit ones-complement partial sum into 16 bits.
+** \param sum The partial sum.
+** \return The folded sum, not inverted.
+**/
+MAGIC_INLINE
+uint16_t nanotube_csum_fold(uint32_t sum);
+
+/*!
+** Update a checksum after a 16-bit field has changed, as described in
+** RFC 1624.  The checksum and the field values must all be in the
+** same byte order.
+** \param csum    The checksum before the change.
+** \param old_val The old value of the field.
+** \param new_val The new value of the field.
+** \return The checksum after the change.
+**/
+MAGIC_INLINE
+uint16_t nanotube_csum_replace2(uint16_t csum, uint16_t old_val,
+                                uint16_t new_val);
+
+/*!
+** Update a checksum after a 32-bit field has changed, as described in
+** RFC 1624.  The checksum and the field values must all be in the
+** same byte order.
+** \param csum    The checksum before the change.
+** \param old_val The old value of the field.
+** \param new_val The new value of the field.
+** \return The checksum after the change.
+**/
+MAGIC_INLINE
+uint16_t nanotube_csum_replace4(uint16_t csum, uint32_t old_val,
+                                uint32_t new_val);
 
 /******************** Utility functions ********************/
 void
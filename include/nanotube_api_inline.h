@@ -161,3 +161,52 @@ size_t nanotube_map_remove(nanotube_context_t* ctx, nanotube_map_id_t map,
                            NULL /* enables */,  0 /* offset */,
                            0 /* data_length */);
 }
+
+/*!
+** Fold a 32-bit ones-complement partial sum into 16 bits.
+** \param sum The partial sum.
+** \return The folded sum, not inverted.
+**/
+MAGIC_INLINE
+uint16_t nanotube_csum_fold(uint32_t sum) {
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+  return (uint16_t)sum;
+}
+
+/*!
+** Update a checksum after a 16-bit field has changed, as described in
+** RFC 1624.  The checksum and the field values must all be in the
+** same byte order.
+** \param csum    The checksum before the change.
+** \param old_val The old value of the field.
+** \param new_val The new value of the field.
+** \return The checksum after the change.
+**/
+MAGIC_INLINE
+uint16_t nanotube_csum_replace2(uint16_t csum, uint16_t old_val,
+                                uint16_t new_val) {
+  /* HC' = ~(~HC + ~m + m') */
+  uint32_t sum = ( (uint32_t)(uint16_t)~csum +
+                   (uint32_t)(uint16_t)~old_val + new_val );
+  return (uint16_t)~nanotube_csum_fold(sum);
+}
+
+/*!
+** Update a checksum after a 32-bit field has changed, as described in
+** RFC 1624.  The checksum and the field values must all be in the
+** same byte order.
+** \param csum    The checksum before the change.
+** \param old_val The old value of the field.
+** \param new_val The new value of the field.
+** \return The checksum after the change.
+**/
+MAGIC_INLINE
+uint16_t nanotube_csum_replace4(uint16_t csum, uint32_t old_val,
+                                uint32_t new_val) {
+  uint32_t sum = ( (uint32_t)(uint16_t)~csum +
+                   (uint32_t)(uint16_t)~(old_val >> 16) +
+                   (uint32_t)(uint16_t)~old_val +
+                   (new_val >> 16) + (new_val & 0xffff) );
+  return (uint16_t)~nanotube_csum_fold(sum);
+}
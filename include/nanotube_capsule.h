@@ -55,6 +55,9 @@
 /*! The requested entry was not found. */
 #define NANOTUBE_CAPSULE_RESPONSE_CODE_NO_ENTRY 4
 
+/*! The request contained too many entries. */
+#define NANOTUBE_CAPSULE_RESPONSE_CODE_TOO_LONG 5
+
 /*! The size of the generic header. */
 #define NANOTUBE_CAPSULE_HEADER_SIZE 6
 
@@ -81,8 +84,15 @@
  *  response is empty. */
 #define NANOTUBE_CAPSULE_MAP_OPCODE_REMOVE 4
 /*! Find the next key.  The request contains the key.  The response
- *  contains the next key. */
+ *  contains the next key and its value.  If the requested key is not
+ *  present, the response contains the first key.  The response code
+ *  is NO_ENTRY after the last key. */
 #define NANOTUBE_CAPSULE_MAP_OPCODE_NEXT_KEY 5
+/*! Perform a batch of operations.  The request contains a count
+ *  followed by that many entries in the batch format below.  Each
+ *  entry is processed as if it was sent in its own capsule and its
+ *  response is written in place. */
+#define NANOTUBE_CAPSULE_MAP_OPCODE_BATCH 6
 
 /*! The key to access. */
 #define NANOTUBE_CAPSULE_MAP_KEY_OFFSET(KEY_SIZE,VALUE_SIZE) \
@@ -96,6 +106,49 @@
 #define NANOTUBE_CAPSULE_MAP_CAPSULE_SIZE(KEY_SIZE,VALUE_SIZE) \
   (NANOTUBE_CAPSULE_HEADER_SIZE+2+(KEY_SIZE)+(VALUE_SIZE))
 
+///////////////////////////////////////////////////////////////////////////
+// The format of batched map requests.
+
+/*! The largest capsule which fits in a standard Ethernet MTU. */
+#define NANOTUBE_CAPSULE_MAX_SIZE 1500
+
+/*! The number of entries in the batch. */
+#define NANOTUBE_CAPSULE_MAP_BATCH_COUNT_OFFSET (NANOTUBE_CAPSULE_HEADER_SIZE+2)
+#define NANOTUBE_CAPSULE_MAP_BATCH_COUNT_SIZE 2
+
+/*! The offset of the first entry. */
+#define NANOTUBE_CAPSULE_MAP_BATCH_ENTRIES_OFFSET \
+  (NANOTUBE_CAPSULE_HEADER_SIZE+4)
+
+/*! The opcode of an entry, one of the single entry opcodes above. */
+#define NANOTUBE_CAPSULE_MAP_ENTRY_OPCODE_OFFSET 0
+#define NANOTUBE_CAPSULE_MAP_ENTRY_OPCODE_SIZE 2
+
+/*! The response code of an entry. */
+#define NANOTUBE_CAPSULE_MAP_ENTRY_RESPONSE_CODE_OFFSET 2
+#define NANOTUBE_CAPSULE_MAP_ENTRY_RESPONSE_CODE_SIZE 2
+
+/*! The key of an entry. */
+#define NANOTUBE_CAPSULE_MAP_ENTRY_KEY_OFFSET(KEY_SIZE,VALUE_SIZE) 4
+
+/*! The value of an entry. */
+#define NANOTUBE_CAPSULE_MAP_ENTRY_VALUE_OFFSET(KEY_SIZE,VALUE_SIZE) \
+  (4+(KEY_SIZE))
+
+/*! The size of each entry. */
+#define NANOTUBE_CAPSULE_MAP_ENTRY_SIZE(KEY_SIZE,VALUE_SIZE) \
+  (4+(KEY_SIZE)+(VALUE_SIZE))
+
+/*! The number of entries which fit in a capsule of the maximum size. */
+#define NANOTUBE_CAPSULE_MAP_BATCH_MAX_ENTRIES(KEY_SIZE,VALUE_SIZE) \
+  ( (NANOTUBE_CAPSULE_MAX_SIZE-NANOTUBE_CAPSULE_MAP_BATCH_ENTRIES_OFFSET) / \
+    NANOTUBE_CAPSULE_MAP_ENTRY_SIZE(KEY_SIZE,VALUE_SIZE) )
+
+/*! The total length of a capsule holding a batch of entries. */
+#define NANOTUBE_CAPSULE_MAP_BATCH_CAPSULE_SIZE(KEY_SIZE,VALUE_SIZE,COUNT) \
+  ( NANOTUBE_CAPSULE_MAP_BATCH_ENTRIES_OFFSET + \
+    (COUNT)*NANOTUBE_CAPSULE_MAP_ENTRY_SIZE(KEY_SIZE,VALUE_SIZE) )
+
 ///////////////////////////////////////////////////////////////////////////
 
 #endif // NANOTUBE_CAPSULE_H
@@ -23,6 +23,8 @@
 
 #include "nanotube_context.hpp"
 
+class nanotube_sim;
+
 ///////////////////////////////////////////////////////////////////////////
 
 struct nanotube_channel
@@ -74,6 +76,23 @@ public:
   /*! Get the element size of the channel. */
   size_t get_elem_size() const { return m_elem_size; }
 
+  /*! Get the capacity of the channel in elements. */
+  size_t get_num_elem() const { return m_num_elem; }
+
+  /*! Account for the elements in a timing model.
+  //
+  // \param sim  The timing model of the processing system.
+  */
+  void enable_sim(nanotube_sim *sim);
+
+  /*! Get the number of elements written while being simulated. */
+  uint64_t get_sim_elems() const { return m_sim_elems; }
+
+  /*! Get the number of cycles the writer waited for space while
+  // being simulated.
+  */
+  uint64_t get_sim_full_cycles() const { return m_sim_full_cycles; }
+
   /*! Get the read pointer of the channel.
   //
   // The channel is implemented as a circular buffer.  This call
@@ -145,6 +164,9 @@ private:
   // The size of each element in the vector.
   size_t m_elem_size;
 
+  // The capacity of the channel in elements.
+  size_t m_num_elem;
+
   // The size of sideband data in the vector (included in m_elem_size)
   size_t m_sideband_size;
 
@@ -188,6 +210,21 @@ private:
   // The type exported for writing. */
   nanotube_channel_type_t m_write_export_type;
 
+  // The timing model, or nullptr if the channel is not being
+  // simulated.
+  nanotube_sim *m_sim;
+
+  // The cycle stamp of each slot of m_contents.  An occupied slot
+  // holds the cycle at which the element arrives at the reader.  A
+  // free slot holds the cycle at which it was freed.
+  std::vector<uint64_t> m_sim_stamps;
+
+  // The number of elements written while being simulated.
+  uint64_t m_sim_elems;
+
+  // The number of cycles the writer waited for space.
+  uint64_t m_sim_full_cycles;
+
   /**
    * Print debug info of data currently accessed
    */
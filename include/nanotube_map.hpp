@@ -31,6 +31,7 @@ public:
   virtual uint8_t* lookup(const uint8_t* key)                          = 0;
   virtual uint8_t* insert_empty(const uint8_t* key)                    = 0;
   virtual bool remove(const uint8_t* key)                              = 0;
+  virtual bool next_key(const uint8_t* key, uint8_t* next)            = 0;
   virtual std::ostream& print_entries(std::ostream &os) const          = 0;
   virtual ~nanotube_map() {};
   enum map_type_t get_type() const { return type; }
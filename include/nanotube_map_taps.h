@@ -38,6 +38,35 @@ typedef enum {
 
 ///////////////////////////////////////////////////////////////////////////
 
+/*! Apply a read-modify-write operation to a map value.
+**
+** \param data_length The size of the value in bytes.
+**
+** \param value The value, which is updated in place.
+**
+** \param data_in The operand.
+**
+** \param access The operation to perform, one of NANOTUBE_MAP_ADD,
+** NANOTUBE_MAP_ADD_SAT, NANOTUBE_MAP_MIN and NANOTUBE_MAP_MAX.  Other
+** operations leave the value unchanged.
+**
+** Both value and data_in are treated as little-endian unsigned integers
+** of data_length bytes.
+*/
+void
+nanotube_tap_map_rmw_core(
+  /* Parameters */
+  nanotube_map_width_t data_length,
+
+  /* State */
+  uint8_t *value,
+
+  /* Inputs */
+  const uint8_t *data_in,
+  enum map_access_t access);
+
+///////////////////////////////////////////////////////////////////////////
+
 /*! Allocate the state for a CAM-based map tap.
 **
 ** \param key_length The size of each key in bytes.
@@ -296,6 +296,102 @@ void nanotube_tap_packet_write(
   const struct nanotube_tap_packet_write_req *req_in,
   const uint8_t *request_bytes_in,
   const uint8_t *request_mask_in);
+
+///////////////////////////////////////////////////////////////////////////
+
+/*! Describes a request to the packet checksum tap. */
+struct nanotube_tap_packet_csum_req {
+  /*! True if the request has been supplied. */
+  bool valid;
+
+  /*! The packet offset in bytes of the start of the summed region. */
+  uint16_t csum_offset;
+
+  /*! The number of bytes to sum. */
+  uint16_t csum_length;
+
+  /*! A ones-complement partial sum which is added to the result. */
+  uint32_t seed;
+};
+
+/*! Describes a response from the packet checksum tap. */
+struct nanotube_tap_packet_csum_resp {
+  /*! True if the response is valid.  This will be set after one call
+   *  per packet. */
+  bool valid;
+
+  /*! The number of bytes which were summed. */
+  uint16_t result_length;
+
+  /*! The folded ones-complement sum, not inverted. */
+  uint16_t result_sum;
+};
+
+/*! The state passed between calls to the packet checksum tap. */
+struct nanotube_tap_packet_csum_state {
+  /*! The length of the current packet (only used by softhub_bus) */
+  uint16_t packet_length;
+
+  /*! The current offset into the packet. */
+  uint16_t packet_offset;
+
+  /*! The partial sum of the bytes seen so far. */
+  uint32_t partial_sum;
+
+  /*! A flag which indicates that the response has been produced. */
+  uint8_t done;
+
+  /*! A flag which indicates that we've seen the DATA_EOP bit set for
+   *  this packet (only used by x3rx_bus) */
+  uint8_t data_eop_seen;
+};
+
+/*! The initial state to pass to the packet checksum tap. */
+static const nanotube_tap_packet_csum_state
+  nanotube_tap_packet_csum_state_init = { 0, 0, 0, 0, 0 };
+
+/*! Calculate the ones-complement sum of a series of packet bytes.
+**
+** \param resp_out The response structure, written by the tap with the
+** result of the operation.
+**
+** \param state_inout An opaque state structure which should be
+** initialised to nanotube_tap_packet_csum_state_init and then passed
+** to every call to the checksum tap.
+**
+** \param packet_word_in  The input packet word.
+**
+** \param req_in A non-null pointer to the checksum request.  The
+** request is only acted on if the "valid" member is set.  After
+** "valid" has been set, the request structure must remain constant
+** until after the end of packet.  The "valid" member must be set in
+** the call for the word which contains the first byte to be summed.
+**
+** The bytes are summed as big-endian 16-bit values, as in RFC 1071,
+** where the first byte of the region is the most significant byte of
+** the first value.  A region with an odd length is padded with a zero
+** byte.  The sum is accumulated as the packet words stream through
+** the tap, so the region can start at any offset and can cover
+** several words.  The response valid bit will be set for exactly one
+** word of the packet, which is the word containing the last byte of
+** the region or the end of packet word if the region extends beyond
+** the end of the packet.
+**
+** The seed allows the sum to be combined with other partial sums.
+** For an incremental update as described in RFC 1624, the seed is
+** the sum of the inverted old checksum and the inverted old values.
+*/
+void nanotube_tap_packet_csum(
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_csum_req *req_in);
+
 ///////////////////////////////////////////////////////////////////////////
 
 /*! A structure containing request parameters for the resize tap. */
@@ -592,6 +688,126 @@ bool nanotube_tap_packet_is_eop(
       decltype(fn ## suffix), \
       decltype(fn)>::value, \
     "Wrong type for " # fn # suffix );
+
+// The bus specific taps are provided for several bus widths.  The
+// taps with the plain bus suffix use the default width.  The other
+// widths have a suffix of the form _sb_w128 which names the number of
+// data bytes.  These macros declare and define the taps for one bus
+// width, given the bus suffix, the log2 of the number of data bytes
+// and a namespace holding templated implementations of the taps.
+#define declare_bus_width_taps(bus, width)                               \
+  extern "C" {                                                          \
+    decltype(nanotube_tap_packet_length)                                \
+      nanotube_tap_packet_length ## bus ## _w ## width;                 \
+    decltype(nanotube_tap_packet_read)                                  \
+      nanotube_tap_packet_read ## bus ## _w ## width;                   \
+    decltype(nanotube_tap_packet_write)                                 \
+      nanotube_tap_packet_write ## bus ## _w ## width;                  \
+    decltype(nanotube_tap_packet_csum)                                  \
+      nanotube_tap_packet_csum ## bus ## _w ## width;                   \
+    decltype(nanotube_tap_packet_resize_ingress)                        \
+      nanotube_tap_packet_resize_ingress ## bus ## _w ## width;         \
+    decltype(nanotube_tap_packet_resize_egress)                         \
+      nanotube_tap_packet_resize_egress ## bus ## _w ## width;          \
+    decltype(nanotube_tap_packet_is_eop)                                \
+      nanotube_tap_packet_is_eop ## bus ## _w ## width;                 \
+  }
+
+#if __clang__
+#define NANOTUBE_TAP_ALWAYS_INLINE __attribute__((always_inline))
+#else
+#define NANOTUBE_TAP_ALWAYS_INLINE
+#endif
+
+#define define_bus_width_taps(bus, width, log_width, impl)               \
+  void nanotube_tap_packet_length ## bus ## _w ## width(                \
+    struct nanotube_tap_packet_length_resp *resp_out,                   \
+    struct nanotube_tap_packet_length_state *state_inout,               \
+    const void *packet_word_in,                                         \
+    const struct nanotube_tap_packet_length_req *req_in)                \
+  NANOTUBE_TAP_ALWAYS_INLINE                                            \
+  {                                                                     \
+    impl::tap_packet_length<log_width>(resp_out, state_inout,           \
+                                       packet_word_in, req_in);         \
+  }                                                                     \
+  void nanotube_tap_packet_read ## bus ## _w ## width(                  \
+    uint16_t result_buffer_length,                                      \
+    uint8_t result_buffer_index_bits,                                   \
+    struct nanotube_tap_packet_read_resp *resp_out,                     \
+    uint8_t *result_buffer_inout,                                       \
+    struct nanotube_tap_packet_read_state *state_inout,                 \
+    const void *packet_word_in,                                         \
+    const struct nanotube_tap_packet_read_req *req_in)                  \
+  NANOTUBE_TAP_ALWAYS_INLINE                                            \
+  {                                                                     \
+    impl::tap_packet_read<log_width>(                                   \
+      result_buffer_length, result_buffer_index_bits, resp_out,         \
+      result_buffer_inout, state_inout, packet_word_in, req_in);        \
+  }                                                                     \
+  void nanotube_tap_packet_write ## bus ## _w ## width(                 \
+    uint16_t request_buffer_length,                                     \
+    uint8_t request_buffer_index_bits,                                  \
+    void *packet_word_out,                                              \
+    struct nanotube_tap_packet_write_state *state_inout,                \
+    const void *packet_word_in,                                         \
+    const struct nanotube_tap_packet_write_req *req_in,                 \
+    const uint8_t *request_bytes_in,                                    \
+    const uint8_t *request_mask_in)                                     \
+  NANOTUBE_TAP_ALWAYS_INLINE                                            \
+  {                                                                     \
+    impl::tap_packet_write<log_width>(                                  \
+      request_buffer_length, request_buffer_index_bits,                 \
+      packet_word_out, state_inout, packet_word_in, req_in,             \
+      request_bytes_in, request_mask_in);                               \
+  }                                                                     \
+  void nanotube_tap_packet_csum ## bus ## _w ## width(                  \
+    struct nanotube_tap_packet_csum_resp *resp_out,                     \
+    struct nanotube_tap_packet_csum_state *state_inout,                 \
+    const void *packet_word_in,                                         \
+    const struct nanotube_tap_packet_csum_req *req_in)                  \
+  NANOTUBE_TAP_ALWAYS_INLINE                                            \
+  {                                                                     \
+    impl::tap_packet_csum<log_width>(resp_out, state_inout,             \
+                                     packet_word_in, req_in);           \
+  }                                                                     \
+  void nanotube_tap_packet_resize_ingress ## bus ## _w ## width(        \
+    bool *packet_done_out,                                              \
+    nanotube_tap_packet_resize_cword_t *cword_out,                      \
+    nanotube_tap_offset_t *packet_length_out,                           \
+    nanotube_tap_packet_resize_ingress_state_t *state,                  \
+    nanotube_tap_packet_resize_req_t *resize_req_in,                    \
+    void *packet_word_in)                                               \
+  NANOTUBE_TAP_ALWAYS_INLINE                                            \
+  {                                                                     \
+    impl::tap_packet_resize_ingress<log_width>(                         \
+      packet_done_out, cword_out, packet_length_out, state,             \
+      resize_req_in, packet_word_in);                                   \
+  }                                                                     \
+  void nanotube_tap_packet_resize_egress ## bus ## _w ## width(         \
+    bool *input_done_out,                                               \
+    bool *packet_done_out,                                              \
+    bool *packet_valid_out,                                             \
+    void *packet_word_out,                                              \
+    nanotube_tap_packet_resize_egress_state_t *state,                   \
+    void *state_packet_word,                                            \
+    nanotube_tap_packet_resize_cword_t *cword,                          \
+    void *packet_word_in,                                               \
+    nanotube_tap_offset_t new_packet_len)                               \
+  NANOTUBE_TAP_ALWAYS_INLINE                                            \
+  {                                                                     \
+    impl::tap_packet_resize_egress<log_width>(                          \
+      input_done_out, packet_done_out, packet_valid_out,                \
+      packet_word_out, state, state_packet_word, cword,                 \
+      packet_word_in, new_packet_len);                                  \
+  }                                                                     \
+  bool nanotube_tap_packet_is_eop ## bus ## _w ## width(                \
+    const void *packet_word_in,                                         \
+    struct nanotube_tap_packet_eop_state *state_inout)                  \
+  NANOTUBE_TAP_ALWAYS_INLINE                                            \
+  {                                                                     \
+    return impl::tap_packet_is_eop<log_width>(packet_word_in,           \
+                                              state_inout);             \
+  }
 #endif
 
 #endif // PACKET_TAPS_H
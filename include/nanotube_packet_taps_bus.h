@@ -86,6 +86,23 @@ void nanotube_tap_packet_write_bus(
 
 ///////////////////////////////////////////////////////////////////////////
 
+void nanotube_tap_packet_csum_bus(
+  /* Constant parameters */
+  nanotube_bus_id_t bus_type,
+
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  nanotube_tap_offset_t packet_word_len,
+  const struct nanotube_tap_packet_csum_req *req_in);
+
+///////////////////////////////////////////////////////////////////////////
+
 void nanotube_tap_packet_resize_ingress_bus(
   /* Constant parameters */
   nanotube_bus_id_t bus_type,
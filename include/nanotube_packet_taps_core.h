@@ -125,6 +125,124 @@ void nanotube_duplicate_bits(uint8_t *dup_bits_out,
 
 ///////////////////////////////////////////////////////////////////////////
 
+enum byte_class: uint8_t {
+  BYTE_CLASS_BEFORE,
+  BYTE_CLASS_IN,
+  BYTE_CLASS_AFTER,
+};
+
+/*! Classify the buffer entries relative to the specified region.
+**
+** \param result_buffer_length The number of entries in the buffer.
+**
+** \param result_buffer_index_bits The number of bits required to
+** represent an index into the buffer.
+**
+** \param buffer_out The output buffer.
+**
+** \param start_offset The offset of the first byte of the region.
+**
+** \param end_offset The offset after the last byte of the region.
+**
+** The buffer bytes are all set based on whether they are before, in
+** or after the specified region as follows:
+**   BYTE_CLASS_BEFORE: index < start_offset
+**   BYTE_CLASS_IN: index >= start_offset && index < end_offset
+**   BYTE_CLASS_AFTER: index >= end_offset
+**
+** The caller must make sure start_offset<=end_offset.
+*/
+void nanotube_classify_entries(uint16_t result_buffer_length,
+                               uint8_t result_buffer_index_bits,
+                               enum byte_class *buffer_out,
+                               uint16_t start_offset,
+                               uint16_t end_offset);
+
+///////////////////////////////////////////////////////////////////////////
+
+/*! Merge rotated request data into a packet buffer.
+**
+** \param packet_buffer_length The number of bytes in the packet buffer.
+**
+** \param packet_buffer_index_bits The number of bits required to
+** represent an index into the packet buffer.
+**
+** \param rot_buf_length The number of bytes in the rotated data.
+**
+** \param packet_buffer_out The output packet buffer.
+**
+** \param packet_buffer_in The input packet buffer.
+**
+** \param rot_data The rotated request data.
+**
+** \param rot_mask The rotated request mask, one bit per byte of
+** rot_data.
+**
+** \param start_offset The offset of the first byte to write.
+**
+** \param end_offset The offset after the last byte to write.
+**
+** Copies the input packet buffer to the output packet buffer.  Each
+** byte at index i in the region from start_offset to end_offset is
+** replaced by rot_data[i%rot_buf_length] if the corresponding bit of
+** rot_mask is set.
+*/
+void nanotube_packet_write_blend(uint16_t packet_buffer_length,
+                                 uint8_t packet_buffer_index_bits,
+                                 uint16_t rot_buf_length,
+                                 uint8_t *packet_buffer_out,
+                                 const uint8_t *packet_buffer_in,
+                                 const uint8_t *rot_data,
+                                 const uint8_t *rot_mask,
+                                 uint16_t start_offset,
+                                 uint16_t end_offset);
+
+///////////////////////////////////////////////////////////////////////////
+
+/* The functions above are implemented in two ways.  The scalar
+** versions below are written as unrolled byte loops which can be
+** synthesised.  They are used when the library is compiled for HLS,
+** which is indicated by NANOTUBE_TAPS_HLS being defined.  Otherwise
+** the functions above operate on whole words at a time, which is
+** much faster in software simulation.  The scalar versions are
+** always available so that the two can be compared.
+*/
+void nanotube_rotate_down_scalar(uint16_t buffer_out_length,
+                                 uint16_t rot_buffer_length,
+                                 uint16_t buffer_in_length,
+                                 uint8_t rot_amount_bits,
+                                 uint8_t *buffer_out,
+                                 const uint8_t *buffer_in,
+                                 uint16_t rot_amount);
+
+void nanotube_shift_down_bits_scalar(uint32_t buffer_out_length,
+                                     uint8_t *buffer_out,
+                                     const uint8_t *buffer_in,
+                                     uint8_t shift_amount);
+
+void nanotube_duplicate_bits_scalar(uint8_t *dup_bits_out,
+                                    const uint8_t *bit_vec_in,
+                                    uint32_t input_bit_length,
+                                    uint32_t padded_bit_length);
+
+void nanotube_classify_entries_scalar(uint16_t result_buffer_length,
+                                      uint8_t result_buffer_index_bits,
+                                      enum byte_class *buffer_out,
+                                      uint16_t start_offset,
+                                      uint16_t end_offset);
+
+void nanotube_packet_write_blend_scalar(uint16_t packet_buffer_length,
+                                        uint8_t packet_buffer_index_bits,
+                                        uint16_t rot_buf_length,
+                                        uint8_t *packet_buffer_out,
+                                        const uint8_t *packet_buffer_in,
+                                        const uint8_t *rot_data,
+                                        const uint8_t *rot_mask,
+                                        uint16_t start_offset,
+                                        uint16_t end_offset);
+
+///////////////////////////////////////////////////////////////////////////
+
 /*! Determine the length of the packet, upto the specified maximum.
 **
 ** \param resp_out The response structure, written by the tap with the
@@ -309,6 +427,46 @@ void nanotube_tap_packet_write_core(
 
 ///////////////////////////////////////////////////////////////////////////
 
+/*! Calculate the ones-complement sum of a series of packet bytes.
+**
+** \param packet_buffer_length The number of bytes in the packet
+** buffer.  This must be a constant expression for synthesis.
+**
+** \param resp_out The response structure, written by the tap with the
+** result of the operation.
+**
+** \param state_inout An opaque state structure which should be
+** initialised to nanotube_tap_packet_csum_state_init and then passed
+** to every call to the checksum tap.
+**
+** \param packet_buffer_in The input packet buffer.
+**
+** \param packet_word_eop Indicates whether this is the last word of
+** the packet.
+**
+** \param packet_word_length The number of valid bytes in the packet
+** buffer.
+**
+** \param req_in A non-null pointer to the checksum request.
+*/
+void nanotube_tap_packet_csum_core(
+  /* Constant parameters */
+  uint16_t packet_buffer_length,
+
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const uint8_t *packet_buffer_in,
+  bool packet_word_eop,
+  uint16_t packet_word_length,
+  const struct nanotube_tap_packet_csum_req *req_in);
+
+///////////////////////////////////////////////////////////////////////////
+
 /*! The core of the resize tap ingress stage.
 **
 ** \param packet_word_length The number of bytes per packet word.
@@ -432,6 +590,115 @@ void nanotube_tap_packet_resize_egress_core(
 
 #ifdef __cplusplus
 }
+
+/* Versions of the packet tap cores which take the packet buffer size as
+ * template arguments.  The bus wrappers use these so that the host
+ * build gets code specialised for each bus width instead of loops over
+ * a runtime word size.  They are instantiated in
+ * nanotube_packet_taps_core.cpp for packet buffers of 32, 64 and 128
+ * bytes.  The parameters are the same as for the C functions above.
+ *
+ * The HLS flow only runs the always-inline pass after linking the
+ * taps, so an out-of-line template instance would be left as a call
+ * in the stage.  When compiling for HLS, the templates forward to the
+ * C cores instead, which are always inlined and see the packet buffer
+ * size as a constant after inlining. */
+namespace nanotube_taps {
+
+#ifdef NANOTUBE_TAPS_HLS
+#define NANOTUBE_TAP_TEMPLATE inline __attribute__((always_inline))
+#else
+#define NANOTUBE_TAP_TEMPLATE
+#endif
+
+template<uint16_t PACKET_BUFFER_LENGTH,
+         uint8_t PACKET_BUFFER_INDEX_BITS>
+NANOTUBE_TAP_TEMPLATE void tap_packet_read_core(
+  /* Constant parameters */
+  uint16_t result_buffer_length,
+  uint8_t result_buffer_index_bits,
+
+  /* Outputs. */
+  struct nanotube_tap_packet_read_resp *resp_out,
+  uint8_t *result_buffer_inout,
+
+  /* State. */
+  struct nanotube_tap_packet_read_state *state_inout,
+
+  /* Inputs. */
+  const uint8_t *packet_buffer_in,
+  bool packet_word_eop,
+  uint16_t packet_word_length,
+  const struct nanotube_tap_packet_read_req *req_in)
+#ifdef NANOTUBE_TAPS_HLS
+{
+  nanotube_tap_packet_read_core(
+    result_buffer_length, result_buffer_index_bits, PACKET_BUFFER_LENGTH,
+    PACKET_BUFFER_INDEX_BITS, resp_out, result_buffer_inout, state_inout,
+    packet_buffer_in, packet_word_eop, packet_word_length, req_in);
+}
+#else
+;
+#endif
+
+template<uint16_t PACKET_BUFFER_LENGTH,
+         uint8_t PACKET_BUFFER_INDEX_BITS>
+NANOTUBE_TAP_TEMPLATE void tap_packet_write_core(
+  /* Constant parameters */
+  uint16_t request_buffer_length,
+  uint8_t request_buffer_index_bits,
+
+  /* Outputs. */
+  uint8_t *packet_buffer_out,
+
+  /* State. */
+  struct nanotube_tap_packet_write_state *state_inout,
+
+  /* Inputs. */
+  const uint8_t *packet_buffer_in,
+  bool packet_word_eop,
+  uint16_t packet_word_length,
+  const struct nanotube_tap_packet_write_req *req_in,
+  const uint8_t *request_bytes_in,
+  const uint8_t *request_mask_in)
+#ifdef NANOTUBE_TAPS_HLS
+{
+  nanotube_tap_packet_write_core(
+    request_buffer_length, request_buffer_index_bits, PACKET_BUFFER_LENGTH,
+    PACKET_BUFFER_INDEX_BITS, packet_buffer_out, state_inout,
+    packet_buffer_in, packet_word_eop, packet_word_length, req_in,
+    request_bytes_in, request_mask_in);
+}
+#else
+;
+#endif
+
+template<uint16_t PACKET_BUFFER_LENGTH>
+NANOTUBE_TAP_TEMPLATE void tap_packet_csum_core(
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const uint8_t *packet_buffer_in,
+  bool packet_word_eop,
+  uint16_t packet_word_length,
+  const struct nanotube_tap_packet_csum_req *req_in)
+#ifdef NANOTUBE_TAPS_HLS
+{
+  nanotube_tap_packet_csum_core(
+    PACKET_BUFFER_LENGTH, resp_out, state_inout, packet_buffer_in,
+    packet_word_eop, packet_word_length, req_in);
+}
+#else
+;
+#endif
+
+#undef NANOTUBE_TAP_TEMPLATE
+
+} // namespace nanotube_taps
 #endif
 
 #endif // NANOTUBE_PACKET_TAPS_CORE_H
@@ -85,6 +85,22 @@ void nanotube_tap_packet_write_sb(
   const uint8_t *request_mask_in);
 
 
+///////////////////////////////////////////////////////////////////////////
+
+/*! The simple bus wrapper of the checksum tap.
+**/
+void nanotube_tap_packet_csum_sb(
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_csum_req *req_in);
+
+
 ///////////////////////////////////////////////////////////////////////////
 
 /*! The simple bus wrapper of the resize tap ingress stage.
@@ -197,6 +213,10 @@ bool nanotube_tap_packet_is_eop_sb(
 
 #ifdef __cplusplus
 }
+
+/* The simple bus taps for 32 and 128 byte bus words. */
+declare_bus_width_taps(_sb, 32)
+declare_bus_width_taps(_sb, 128)
 #endif
 
 #endif // NANOTUBE_PACKET_TAPS_SB_H
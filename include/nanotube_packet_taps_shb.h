@@ -79,6 +79,22 @@ void nanotube_tap_packet_write_shb(
   const uint8_t *request_mask_in);
 
 
+///////////////////////////////////////////////////////////////////////////
+
+/*! The softhub bus wrapper of the checksum tap.
+**/
+void nanotube_tap_packet_csum_shb(
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_csum_req *req_in);
+
+
 ///////////////////////////////////////////////////////////////////////////
 
 /*! The softhub bus wrapper of the resize tap ingress stage.
@@ -185,6 +201,10 @@ bool nanotube_tap_packet_is_eop_shb(
 
 #ifdef __cplusplus
 }
+
+/* The softhub bus taps for 32 and 128 byte bus words. */
+declare_bus_width_taps(_shb, 32)
+declare_bus_width_taps(_shb, 128)
 #endif
 
 #endif // NANOTUBE_PACKET_TAPS_SHB_H
@@ -79,6 +79,22 @@ void nanotube_tap_packet_write_x3rx(
   const uint8_t *request_mask_in);
 
 
+///////////////////////////////////////////////////////////////////////////
+
+/*! The x3rx bus wrapper of the checksum tap.
+**/
+void nanotube_tap_packet_csum_x3rx(
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_csum_req *req_in);
+
+
 ///////////////////////////////////////////////////////////////////////////
 
 /*! The x3rx bus wrapper of the resize tap ingress stage.
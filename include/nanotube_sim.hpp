@@ -0,0 +1,304 @@
+/**************************************************************************\
+*//*! \file nanotube_sim.hpp
+**  \brief  A cycle-approximate timing model of a processing system.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+#ifndef NANOTUBE_SIM_HPP
+#define NANOTUBE_SIM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class nanotube_thread;
+class processing_system;
+
+///////////////////////////////////////////////////////////////////////////
+
+/*! The timing state of a pipeline stage.
+//
+// Each thread of the processing system is modelled as a pipeline
+// stage.  An invocation of the thread function which reads or writes
+// a channel element models one firing of the stage.  The firing
+// issues when all the elements it reads have arrived and the next
+// firing can issue II cycles later.  Elements written by the firing
+// leave the stage after the latency of the stage.
+//
+// The state is only accessed by the thread which runs the stage,
+// apart from reporting when the processing system is idle.
+*/
+class nanotube_sim_stage
+{
+public:
+  /*! Create the timing state of a stage.
+  //
+  // \param name     The name of the stage.
+  // \param ii       The initiation interval in cycles.
+  // \param latency  The latency in cycles.
+  */
+  nanotube_sim_stage(const std::string &name, unsigned ii,
+                     unsigned latency);
+
+  /*! Get the name of the stage. */
+  const std::string &get_name() const { return m_name; }
+
+  /*! Get the initiation interval of the stage. */
+  unsigned get_ii() const { return m_ii; }
+
+  /*! Get the latency of the stage. */
+  unsigned get_latency() const { return m_latency; }
+
+  /*! Get the issue cycle of the current firing. */
+  uint64_t get_time() const { return m_time; }
+
+  /*! Get the number of firings. */
+  uint64_t get_firings() const { return m_firings; }
+
+  /*! Get the number of cycles spent stalled on full channels. */
+  uint64_t get_stall_cycles() const { return m_stall_cycles; }
+
+  /*! Delay the issue of the current firing.
+  //
+  // \param time  The earliest issue cycle.
+  */
+  void delay_until(uint64_t time) {
+    if (time > m_time)
+      m_time = time;
+  }
+
+  /*! Account for an element read by the current firing.
+  //
+  // \param ready  The cycle at which the element arrived.
+  //
+  // \returns the cycle at which the element was consumed.
+  */
+  uint64_t read_elem(uint64_t ready);
+
+  /*! Account for an element written by the current firing.
+  //
+  // \param freed  The cycle at which space became available.
+  // \param stall  Incremented by the cycles spent waiting for space.
+  //
+  // \returns the cycle at which the element leaves the stage.
+  */
+  uint64_t write_elem(uint64_t freed, uint64_t *stall);
+
+  /*! Finish an invocation of the thread function.
+  //
+  // The invocation only counts as a firing if it accessed a channel.
+  // Invocations which found nothing to do are polls which are not
+  // present in hardware.
+  */
+  void end_invocation() {
+    if (!m_active)
+      return;
+    m_active = false;
+    m_time += m_ii;
+    m_firings++;
+  }
+
+private:
+  // The name of the stage.
+  std::string m_name;
+
+  // The initiation interval in cycles.
+  unsigned m_ii;
+
+  // The latency in cycles.
+  unsigned m_latency;
+
+  // The earliest issue cycle of the current firing.
+  uint64_t m_time;
+
+  // Whether the current invocation accessed a channel.
+  bool m_active;
+
+  // The number of firings.
+  uint64_t m_firings;
+
+  // The number of cycles spent stalled on full channels.
+  uint64_t m_stall_cycles;
+};
+
+///////////////////////////////////////////////////////////////////////////
+
+/*! A cycle-approximate timing model of a processing system.
+//
+// The threads of the processing system still run freely, but each
+// channel element carries the cycle at which it arrives at the
+// reader and each free slot of a channel carries the cycle at which
+// it was freed.  The stages use these to keep a virtual clock as
+// described in nanotube_sim_stage.  The exported packet channels are
+// driven by an ingress port which writes one bus word per cycle and
+// drained by an egress port which reads one bus word per cycle.
+//
+// The model is approximate because a stage processes elements in
+// the order in which its thread runs, so arbitration between the
+// clients of a map follows the order of the software run.  Per-packet
+// latency pairs the packets leaving the egress port with the packets
+// which entered the ingress port in order.  Packets which have not
+// left when the processing system becomes idle are counted as
+// dropped.
+*/
+class nanotube_sim
+{
+public:
+  /*! The configuration of the timing model. */
+  struct config_t
+  {
+    /*! Construct the default configuration. */
+    config_t();
+
+    // The name of a performance report written by the code_metrics
+    // pass.  If it is not empty, it provides the initiation interval
+    // and latency of each thread.
+    std::string perf_report;
+
+    // The default initiation interval of a stage in cycles.
+    unsigned ii;
+
+    // The default latency of a stage in cycles.
+    unsigned latency;
+
+    // The latency of a map tap in cycles.
+    unsigned map_latency;
+
+    // The latency of a channel in cycles.
+    unsigned fifo_latency;
+
+    // The depth of all channels in elements, or zero to use the
+    // depth requested by the application.
+    size_t fifo_depth;
+
+    // The minimum number of cycles between the starts of two packets
+    // at the ingress port.
+    unsigned packet_gap;
+
+    // The initiation interval and latency of stages, by thread name.
+    std::map<std::string, std::pair<unsigned, unsigned> > stage_costs;
+
+    // The depth of channels, by channel name.
+    std::map<std::string, size_t> fifo_depths;
+  };
+
+  /*! Create the timing model.
+  //
+  // \param config  The configuration.
+  */
+  explicit nanotube_sim(const config_t &config);
+
+  /*! Get the configuration. */
+  const config_t &get_config() const { return m_config; }
+
+  /*! Get the depth of a channel.
+  //
+  // \param name      The name of the channel.
+  // \param num_elem  The depth requested by the application.
+  //
+  // \returns the depth to use for the channel.
+  */
+  size_t get_fifo_depth(const std::string &name, size_t num_elem) const;
+
+  /*! Attach timing state to the threads of the processing system.
+  //
+  // \param threads  The threads in creation order.
+  */
+  void bind_threads(
+    const std::vector<std::unique_ptr<nanotube_thread> > &threads);
+
+  /*! Account for an element written to a channel.
+  //
+  // \param stage  The stage writing the element or nullptr for the
+  //               ingress port.
+  // \param freed  The cycle at which the slot was freed.
+  // \param stall  Incremented by the cycles spent waiting for the slot.
+  //
+  // \returns the cycle at which the element arrives at the reader.
+  */
+  uint64_t write_elem(nanotube_sim_stage *stage, uint64_t freed,
+                      uint64_t *stall);
+
+  /*! Account for an element read from a channel.
+  //
+  // \param stage  The stage reading the element or nullptr for the
+  //               egress port.
+  // \param ready  The cycle at which the element arrived.
+  //
+  // \returns the cycle at which the slot was freed.
+  */
+  uint64_t read_elem(nanotube_sim_stage *stage, uint64_t ready);
+
+  /*! Indicate that a packet is about to enter the ingress port. */
+  void packet_start();
+
+  /*! Indicate that a packet has left the egress port. */
+  void packet_end();
+
+  /*! Indicate that the processing system is idle. */
+  void flush();
+
+  /*! Write a report of the simulation as JSON.
+  //
+  // \param os      The stream to write to.
+  // \param system  The processing system which was simulated.
+  */
+  void write_report(std::ostream &os, processing_system &system);
+
+private:
+  // The configuration.
+  config_t m_config;
+
+  // The timing state of each thread.
+  std::vector<std::unique_ptr<nanotube_sim_stage> > m_stages;
+
+  // The ingress and egress ports.
+  nanotube_sim_stage m_ingress;
+  nanotube_sim_stage m_egress;
+
+  // Whether the next ingress word starts a packet.
+  bool m_packet_pending;
+
+  // Whether a packet has started.
+  bool m_any_start;
+
+  // The cycle at which the last packet started.
+  uint64_t m_last_start;
+
+  // The cycle at which the last word left the egress port.
+  uint64_t m_last_egress;
+
+  // The start cycles of the packets which have not left yet.
+  std::deque<uint64_t> m_in_flight;
+
+  // Packet and word counts.
+  uint64_t m_packets_in;
+  uint64_t m_packets_out;
+  uint64_t m_packets_dropped;
+  uint64_t m_words_in;
+  uint64_t m_words_out;
+
+  // The first ingress cycle and the last egress cycle.
+  uint64_t m_first_in;
+  uint64_t m_last_out;
+
+  // Per-packet latency statistics.
+  uint64_t m_latency_min;
+  uint64_t m_latency_max;
+  uint64_t m_latency_sum;
+  uint64_t m_latency_count;
+};
+
+///////////////////////////////////////////////////////////////////////////
+
+#endif // NANOTUBE_SIM_HPP
@@ -55,6 +55,7 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////
 
+class nanotube_sim_stage;
 class nanotube_thread;
 
 /*! A class for waiting until threads are idle.
@@ -145,6 +146,13 @@ public:
   /*! Determine whether the thread is the current thread. */
   bool is_current();
 
+  /*! Get the thread object of the calling thread.
+  //
+  // \returns the current thread or nullptr if the calling thread is
+  // not a Nanotube thread.
+  */
+  static nanotube_thread *get_current();
+
   /*! Determine whether the thread is stopped. */
   bool is_stopped();
 
@@ -217,6 +225,17 @@ public:
   void kill(int sig);
 
   std::string get_name() { return m_name; }
+
+  /*! Get the timing state of the thread.
+  //
+  // \returns the timing state or nullptr if the processing system is
+  // not being simulated.
+  */
+  nanotube_sim_stage *get_sim_stage() const { return m_sim_stage; }
+
+  /*! Set the timing state of the thread. */
+  void set_sim_stage(nanotube_sim_stage *stage) { m_sim_stage = stage; }
+
 private:
   friend class nanotube_thread_idle_waiter;
 
@@ -318,6 +337,10 @@ private:
   // waiter whenever it transitions into or out of the SLEEPING state.
   // This member is protected by m_mutex.
   nanotube_thread_idle_waiter *m_idle_waiter;
+
+  // The timing state of the thread when the processing system is
+  // being simulated.
+  nanotube_sim_stage *m_sim_stage;
 };
 
 ///////////////////////////////////////////////////////////////////////////
@@ -22,6 +22,7 @@
 #include "nanotube_api.h"
 #include "nanotube_context.hpp"
 #include "nanotube_map.hpp"
+#include "nanotube_sim.hpp"
 #include "nanotube_thread.hpp"
 #include "packet_kernel.hpp"
 
@@ -50,6 +51,7 @@ public:
   typedef std::unique_ptr<nanotube_context> context_ptr_t;
   typedef std::vector<context_ptr_t>        context_vec_t;
   typedef std::unique_ptr<nanotube_channel> channel_ptr_t;
+  typedef std::multimap<std::string, channel_ptr_t> channel_map_t;
   typedef std::unique_ptr<packet_kernel>    packet_kernel_ptr_t;
   typedef std::vector<packet_kernel_ptr_t>  packet_kernel_vec_t;
   typedef std::unique_ptr<nanotube_thread>  thread_ptr_t;
@@ -57,7 +59,11 @@ public:
   typedef std::unique_ptr<nanotube_map>                    map_ptr_t;
   typedef std::unordered_map<nanotube_map_id_t, map_ptr_t> id_to_map_t;
 
-  static ptr_t attach(ps_client &client);
+  // Attach to the processing system.  If sim_config is not nullptr,
+  // the processing system is simulated with a cycle-approximate
+  // timing model.
+  static ptr_t attach(ps_client &client,
+                      const nanotube_sim::config_t *sim_config = nullptr);
   static void detach(ptr_t &ptr);
 
   static processing_system &get_current();
@@ -68,6 +74,10 @@ public:
   const thread_vec_t&        threads() const { return m_threads; }
   const context_vec_t&  contexts() const { return m_contexts; }
   const id_to_map_t&         maps() const { return m_id2map; }
+  const channel_map_t&       channels() const { return m_channels; }
+
+  // Get the timing model or nullptr if not simulating.
+  nanotube_sim *get_sim() { return m_sim.get(); }
 
   nanotube_context *get_main_context() { return &m_main_context; }
   nanotube_thread *get_main_thread() { return &m_main_thread; }
@@ -92,7 +102,8 @@ public:
   }
 
 private:
-  processing_system(ps_client &client);
+  processing_system(ps_client &client,
+                    const nanotube_sim::config_t *sim_config);
 
   void start_threads();
 
@@ -102,6 +113,8 @@ private:
 
   ps_client &m_client;
 
+  std::unique_ptr<nanotube_sim> m_sim;
+
   packet_kernel_vec_t m_kernels;
 
   id_to_map_t m_id2map;
@@ -113,7 +126,7 @@ private:
 
   std::vector<void *> m_mallocs;
 
-  std::multimap<std::string, channel_ptr_t> m_channels;
+  channel_map_t m_channels;
 
   std::vector<nanotube_channel *> m_packet_read_channels;
   std::vector<nanotube_channel *> m_packet_write_channels;
@@ -6,9 +6,11 @@
 #define SIMPLE_BUS_HPP
 
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <type_traits>
 
 namespace simple_bus
 {
@@ -16,119 +18,239 @@ namespace simple_bus
   typedef unsigned char wsize_t;
   typedef unsigned char empty_t;
 
-  static const byte_t control_eop = 0x80;
-  static const byte_t control_err = 0x40;
-  static const byte_t control_empty_lbn = 0;
-  static const byte_t control_empty_width = 6;
-  static const byte_t control_empty_mask =
-    (byte_t(2) << (control_empty_width-1)) - 1;
-  static const byte_t control_empty_smask =
-    (control_empty_mask << control_empty_lbn);
+  /* The properties of a simple bus with (1<<LOG_DATA_BYTES) data
+   * bytes per word.  Words of up to 64 data bytes have a single
+   * control byte.  Wider words have a two byte little-endian control
+   * field so that the empty count fits alongside the EOP and error
+   * flags. */
+  template<int LOG_DATA_BYTES>
+  struct bus_traits
+  {
+    static const int log_data_bytes = LOG_DATA_BYTES;
+    static const int data_bytes = (1<<log_data_bytes);
+    static const int control_bytes = (log_data_bytes > 6 ? 2 : 1);
+    typedef typename std::conditional<(control_bytes > 1),
+                                      uint16_t, byte_t>::type control_t;
 
-  static const int log_data_bytes = 6;
-  static const int data_bytes = (1<<log_data_bytes);
-  static const int sideband_signals_bytes = 0;
-#if 1 //control byte inline with data 
-  static const int sideband_bytes = 0;
-  static const int total_bytes = data_bytes+1+sideband_signals_bytes;
-  static inline unsigned sideband_signals_offset() { return data_bytes+1; }
+    static const control_t control_eop =
+      control_t(0x80 << (8*(control_bytes-1)));
+    static const control_t control_err =
+      control_t(0x40 << (8*(control_bytes-1)));
+    static const byte_t control_empty_lbn = 0;
+    static const byte_t control_empty_width =
+      (log_data_bytes > 6 ? log_data_bytes : 6);
+    static const control_t control_empty_mask =
+      (control_t(2) << (control_empty_width-1)) - 1;
+    static const control_t control_empty_smask =
+      (control_empty_mask << control_empty_lbn);
+
+    static const int sideband_signals_bytes = 0;
+#if 1 //control byte inline with data
+    static const int sideband_bytes = 0;
+    static const int total_bytes =
+      data_bytes+control_bytes+sideband_signals_bytes;
+    static inline unsigned sideband_signals_offset() {
+      return data_bytes+control_bytes;
+    }
 #else //control byte as sideband
-  static const int sideband_bytes = 1;
-  static const int total_bytes = data_bytes+sideband_bytes+sideband_signals_bytes;
-  static inline unsigned sideband_signals_offset() { return data_bytes+sideband_bytes; }
+    static const int sideband_bytes = control_bytes;
+    static const int total_bytes =
+      data_bytes+sideband_bytes+sideband_signals_bytes;
+    static inline unsigned sideband_signals_offset() {
+      return data_bytes+sideband_bytes;
+    }
 #endif
-  static inline unsigned data_offset(unsigned index) { return 0+index; }
-  static inline unsigned control_offset() { return data_bytes; }
+    static inline unsigned data_offset(unsigned index) { return 0+index; }
+    static inline unsigned control_offset() { return data_bytes; }
 
-  static inline bool get_control_eop(byte_t control) {
-    return (control & control_eop) != 0;
-  }
-  static inline bool get_control_err(byte_t control) {
+    static inline bool get_control_eop(control_t control) {
+      return (control & control_eop) != 0;
+    }
+    static inline bool get_control_err(control_t control) {
       return (control & control_err) != 0;
+    }
+    static inline empty_t get_control_empty(control_t control) {
+      return ( (control & control_empty_smask) >> control_empty_lbn );
+    }
+    static inline control_t control_value(bool eop, bool err,
+                                          empty_t empty) {
+      return ( (eop ? control_eop : 0) |
+               (err ? control_err : 0) |
+               ( (empty & control_empty_mask) << control_empty_lbn ) );
+    }
+
+    /* Read and write the control field of a word buffer. */
+    static inline control_t load_control(const byte_t *bytes) {
+      control_t control = 0;
+      for (int i=0; i<control_bytes; i++)
+        control |= control_t(bytes[control_offset()+i]) << (8*i);
+      return control;
+    }
+    static inline void store_control(byte_t *bytes, control_t control) {
+      for (int i=0; i<control_bytes; i++)
+        bytes[control_offset()+i] = byte_t(control >> (8*i));
+    }
+  };
+
+  template<int L> const int bus_traits<L>::log_data_bytes;
+  template<int L> const int bus_traits<L>::data_bytes;
+  template<int L> const int bus_traits<L>::control_bytes;
+  template<int L> const int bus_traits<L>::sideband_signals_bytes;
+  template<int L> const int bus_traits<L>::sideband_bytes;
+  template<int L> const int bus_traits<L>::total_bytes;
+  template<int L> const typename bus_traits<L>::control_t
+    bus_traits<L>::control_eop;
+  template<int L> const typename bus_traits<L>::control_t
+    bus_traits<L>::control_err;
+  template<int L> const typename bus_traits<L>::control_t
+    bus_traits<L>::control_empty_mask;
+  template<int L> const typename bus_traits<L>::control_t
+    bus_traits<L>::control_empty_smask;
+
+  /* The default bus has 64 data bytes per word. */
+  static const int log_data_bytes = 6;
+  typedef bus_traits<log_data_bytes> default_traits;
+
+  typedef default_traits::control_t control_t;
+  static const control_t control_eop = default_traits::control_eop;
+  static const control_t control_err = default_traits::control_err;
+  static const byte_t control_empty_lbn = default_traits::control_empty_lbn;
+  static const byte_t control_empty_width =
+    default_traits::control_empty_width;
+  static const control_t control_empty_mask =
+    default_traits::control_empty_mask;
+  static const control_t control_empty_smask =
+    default_traits::control_empty_smask;
+
+  static const int data_bytes = default_traits::data_bytes;
+  static const int sideband_signals_bytes =
+    default_traits::sideband_signals_bytes;
+  static const int sideband_bytes = default_traits::sideband_bytes;
+  static const int total_bytes = default_traits::total_bytes;
+  static inline unsigned sideband_signals_offset() {
+    return default_traits::sideband_signals_offset();
+  }
+  static inline unsigned data_offset(unsigned index) {
+    return default_traits::data_offset(index);
+  }
+  static inline unsigned control_offset() {
+    return default_traits::control_offset();
+  }
+
+  static inline bool get_control_eop(control_t control) {
+    return default_traits::get_control_eop(control);
+  }
+  static inline bool get_control_err(control_t control) {
+    return default_traits::get_control_err(control);
   }
-  static inline empty_t get_control_empty(byte_t control) {
-    return ( (control & control_empty_smask) >> control_empty_lbn );
+  static inline empty_t get_control_empty(control_t control) {
+    return default_traits::get_control_empty(control);
   }
-  static inline byte_t control_value(bool eop, bool err, empty_t empty) {
-    return ( (eop ? control_eop : 0) |
-             (err ? control_err : 0) |
-             ( (empty & control_empty_mask) << control_empty_lbn ) );
+  static inline control_t control_value(bool eop, bool err, empty_t empty) {
+    return default_traits::control_value(eop, err, empty);
+  }
+
+  /* The supported bus widths are 32, 64 and 128 data bytes per
+   * word.  The width of a packet channel is determined by its element
+   * size. */
+  static const int max_total_bytes = bus_traits<7>::total_bytes;
+  static inline bool is_word_size(std::size_t size) {
+    return ( size == std::size_t(bus_traits<5>::total_bytes) ||
+             size == std::size_t(bus_traits<6>::total_bytes) ||
+             size == std::size_t(bus_traits<7>::total_bytes) );
   }
 
   struct header {
     byte_t port;
   };
 
-  struct word {
-    byte_t bytes[total_bytes];
+  template<int LOG_DATA_BYTES>
+  struct basic_word {
+    typedef bus_traits<LOG_DATA_BYTES> traits;
+    typedef typename traits::control_t control_t;
 
-    byte_t &control() {
-      return bytes[control_offset()];
+    byte_t bytes[traits::total_bytes];
+
+    control_t get_control() const {
+      return traits::load_control(bytes);
     }
-    const byte_t &control() const {
-      return bytes[control_offset()];
+    void set_control_raw(control_t control) {
+      traits::store_control(bytes, control);
     }
     byte_t &data_ref(unsigned index=0) {
-      return bytes[data_offset(index)];
+      return bytes[traits::data_offset(index)];
     }
     const byte_t &data_ref(unsigned index=0) const {
-      return bytes[data_offset(index)];
+      return bytes[traits::data_offset(index)];
     }
     byte_t *data_ptr(unsigned index=0) {
-      return &(bytes[data_offset(index)]);
+      return &(bytes[traits::data_offset(index)]);
     }
     const byte_t *data_ptr(unsigned index=0) const {
-      return &(bytes[data_offset(index)]);
+      return &(bytes[traits::data_offset(index)]);
     }
 
     bool get_eop() const {
-      return get_control_eop(control());
+      return traits::get_control_eop(get_control());
     }
     bool get_err() const {
-      return get_control_err(control());
+      return traits::get_control_err(get_control());
     }
     empty_t get_empty() const {
-      return get_control_empty(control());
+      return traits::get_control_empty(get_control());
     }
     void set_control(bool eop, bool err, empty_t empty) {
-      control() = control_value(eop, err, empty);
+      set_control_raw(traits::control_value(eop, err, empty));
     }
-    
+
     byte_t &tkeep() {
-      return bytes[sideband_signals_offset()];
+      return bytes[traits::sideband_signals_offset()];
     }
     byte_t &tstrb() {
-      return bytes[sideband_signals_offset()+((sideband_signals_bytes-1)/2)];
+      return bytes[traits::sideband_signals_offset()+
+                   ((traits::sideband_signals_bytes-1)/2)];
     }
     byte_t &tlast() {
-      return bytes[total_bytes-1];
+      return bytes[traits::total_bytes-1];
+    }
+
+    /* Sets the last N bits of a data_bytes wide mask to 1, the rest
+     * to 0. */
+    static void set_mask(byte_t *mask, int N) {
+      for (int i=0; i<traits::data_bytes; i++) {
+        if (i % 8 == 0)
+          mask[i/8] = 0;
+        if (i >= traits::data_bytes - N)
+          mask[i/8] |= byte_t(1 << (i%8));
+      }
     }
 
     /* Sets first N bits of TKEEP to 1, the rest to 0 */
     void set_tkeep(int N) {
-      //uint64_t assumes 64 data bytes 
-      uint64_t mask = (~0ull << (simple_bus::data_bytes - N));
-      memcpy(&tkeep(), &mask, simple_bus::data_bytes / 8);
+      set_mask(&tkeep(), N);
     }
 
     /* Sets first N bits of TKEEP to 1, the rest to 0 */
     void set_tstrb(int N) {
-      //uint64_t assumes 64 data bytes 
-      uint64_t mask = (~0ull << (simple_bus::data_bytes - N));
-      memcpy(&tstrb(), &mask, simple_bus::data_bytes / 8);
+      set_mask(&tstrb(), N);
     }
     void set_tlast(bool last) {
       tlast() = last;
     }
   };
 
-  static inline std::ostream &operator <<(std::ostream &o, const word &w)
+  typedef basic_word<log_data_bytes> word;
+
+  template<int LOG_DATA_BYTES>
+  static inline std::ostream &operator <<(std::ostream &o,
+                                          const basic_word<LOG_DATA_BYTES> &w)
   {
+    typedef bus_traits<LOG_DATA_BYTES> traits;
     const int width = 16;
 
-    int num_bytes = ( simple_bus::data_bytes -
+    int num_bytes = ( traits::data_bytes -
                       (w.get_eop() ? w.get_empty() : 0) );
-    assert (num_bytes >= 0 && num_bytes <= simple_bus::data_bytes);
+    assert (num_bytes >= 0 && num_bytes <= traits::data_bytes);
 
     int col = 0;
     for (int i=0; i<num_bytes; i++) {
@@ -15,14 +15,50 @@ namespace softhub_bus
   typedef unsigned char byte_t;
   typedef unsigned char empty_t;
 
+  /* The properties of a softhub bus with (1<<LOG_DATA_BYTES) data
+   * bytes per word.  The sideband signals hold TKEEP, TSTRB and
+   * TLAST. */
+  template<int LOG_DATA_BYTES>
+  struct bus_traits
+  {
+    static const int log_data_bytes = LOG_DATA_BYTES;
+    static const int data_bytes = (1<<log_data_bytes);
+    static const int sideband_bytes = 0;
+    static const int sideband_signals_bytes = (data_bytes / 8) * 2 + 1;
+    static const int total_bytes =
+      data_bytes+sideband_bytes+sideband_signals_bytes;
+
+    static inline unsigned data_offset(unsigned index) { return 0+index; }
+  };
+
+  template<int L> const int bus_traits<L>::log_data_bytes;
+  template<int L> const int bus_traits<L>::data_bytes;
+  template<int L> const int bus_traits<L>::sideband_bytes;
+  template<int L> const int bus_traits<L>::sideband_signals_bytes;
+  template<int L> const int bus_traits<L>::total_bytes;
+
   /* AXI-S is 512 bits, so 64 bytes */
   static const int log_data_bytes = 6;
-  static const int data_bytes = (1<<log_data_bytes);
-  static const int sideband_bytes = 0;
-  static const int sideband_signals_bytes = (data_bytes / 8) * 2 + 1;
-  static const int total_bytes = data_bytes+sideband_bytes+sideband_signals_bytes;
+  typedef bus_traits<log_data_bytes> default_traits;
+  static const int data_bytes = default_traits::data_bytes;
+  static const int sideband_bytes = default_traits::sideband_bytes;
+  static const int sideband_signals_bytes =
+    default_traits::sideband_signals_bytes;
+  static const int total_bytes = default_traits::total_bytes;
+
+  static inline unsigned data_offset(unsigned index) {
+    return default_traits::data_offset(index);
+  }
 
-  static inline unsigned data_offset(unsigned index) { return 0+index; }
+  /* The supported bus widths are 32, 64 and 128 data bytes per
+   * word.  The width of a packet channel is determined by its element
+   * size. */
+  static const int max_total_bytes = bus_traits<7>::total_bytes;
+  static inline bool is_word_size(std::size_t size) {
+    return ( size == std::size_t(bus_traits<5>::total_bytes) ||
+             size == std::size_t(bus_traits<6>::total_bytes) ||
+             size == std::size_t(bus_traits<7>::total_bytes) );
+  }
  
  /* Layout of bitfields is compiler dependent, but this is the header structure */
  /*
@@ -95,20 +131,23 @@ namespace softhub_bus
     header[4] = (header[4] & ~CH_LENGTH_MASK_1) | (byte_t)((length >> 8) & CH_LENGTH_MASK_1);
   }
 
-  struct word {
-    byte_t bytes[total_bytes];
+  template<int LOG_DATA_BYTES>
+  struct basic_word {
+    typedef bus_traits<LOG_DATA_BYTES> traits;
+
+    byte_t bytes[traits::total_bytes];
 
     byte_t &data_ref(unsigned index=0) {
-      return bytes[data_offset(index)];
+      return bytes[traits::data_offset(index)];
     }
     const byte_t &data_ref(unsigned index=0) const {
-      return bytes[data_offset(index)];
+      return bytes[traits::data_offset(index)];
     }
     byte_t *data_ptr(unsigned index=0) {
-      return &(bytes[data_offset(index)]);
+      return &(bytes[traits::data_offset(index)]);
     }
     const byte_t *data_ptr(unsigned index=0) const {
-      return &(bytes[data_offset(index)]);
+      return &(bytes[traits::data_offset(index)]);
     }
 
     /* Assumes there is a capsule header at start of the word */
@@ -129,40 +168,52 @@ namespace softhub_bus
     }
 
     byte_t &tkeep() {
-      return bytes[data_bytes+sideband_bytes];
+      return bytes[traits::data_bytes+traits::sideband_bytes];
     }
     byte_t &tstrb() {
-      return bytes[data_bytes+sideband_bytes+((sideband_signals_bytes-1)/2)];
+      return bytes[traits::data_bytes+traits::sideband_bytes+
+                   ((traits::sideband_signals_bytes-1)/2)];
     }
     byte_t &tlast() {
-      return bytes[total_bytes-1];
+      return bytes[traits::total_bytes-1];
+    }
+
+    /* Sets the first N bits of a data_bytes wide mask to 1, the rest
+     * to 0. */
+    static void set_mask(byte_t *mask, int N) {
+      for (int i=0; i<traits::data_bytes; i++) {
+        if (i % 8 == 0)
+          mask[i/8] = 0;
+        if (i < N)
+          mask[i/8] |= byte_t(1 << (i%8));
+      }
     }
 
     /* Sets first N bits of TKEEP to 1, the rest to 0 */
     void set_tkeep(int N) {
-      //uint64_t assumes 64 data bytes 
-      uint64_t mask = (1ull << N) - 1;
-      memcpy(&tkeep(), &mask, softhub_bus::data_bytes / 8);
+      set_mask(&tkeep(), N);
     }
 
     /* Sets first N bits of TKEEP to 1, the rest to 0 */
     void set_tstrb(int N) {
-      //uint64_t assumes 64 data bytes 
-      uint64_t mask = (1ull << N) - 1;
-      memcpy(&tstrb(), &mask, softhub_bus::data_bytes / 8);
+      set_mask(&tstrb(), N);
     }
     void set_tlast(bool last) {
       tlast() = last;
     }
   };
-  
-  
-  static inline std::ostream &operator <<(std::ostream &o, const word &w)
+
+  typedef basic_word<log_data_bytes> word;
+
+  template<int LOG_DATA_BYTES>
+  static inline std::ostream &operator <<(std::ostream &o,
+                                          const basic_word<LOG_DATA_BYTES> &w)
   {
+    typedef bus_traits<LOG_DATA_BYTES> traits;
     const int width = 16;
 
-    int num_bytes = ( data_bytes );
-    assert (num_bytes >= 0 && num_bytes <= data_bytes);
+    int num_bytes = ( traits::data_bytes );
+    assert (num_bytes >= 0 && num_bytes <= traits::data_bytes);
 
     int col = 0;
     for (int i=0; i<num_bytes; i++) {
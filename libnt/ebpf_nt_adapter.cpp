@@ -17,6 +17,11 @@
 
 #include "nanotube_api.h"
 
+/* The bits of the bpf_redirect_map flags which hold the action to return
+ * if the key is not found, as in the Linux kernel. */
+static const uint64_t redirect_map_action_mask =
+  XDP_ABORTED | XDP_DROP | XDP_PASS | XDP_TX;
+
 /**
  * NOTE: The EBPF native functions report errors via a normal int32, and
  * use the typical Linux kernel errno values.  The user-space API needs the
@@ -81,13 +86,64 @@ nanotube_kernel_rc_t packet_handle_xdp_result(nanotube_packet_t* packet, int xdp
     case XDP_PASS:
       return NANOTUBE_PACKET_PASS;
       break;
+    case XDP_TX:
+      /* The packet leaves on the port it arrived on. */
+      return NANOTUBE_PACKET_PASS;
+    case XDP_REDIRECT:
+      /* The redirect helper has already set the port. */
+      return NANOTUBE_PACKET_PASS;
     case XDP_DROP:
       /* Fall-through*/
+    case XDP_ABORTED:
+      /* Fall-through*/
     default:
       return NANOTUBE_PACKET_DROP;
   }
 }
 
+#ifdef __clang__
+__attribute__((always_inline))
+#endif
+int32_t packet_redirect_adapter(nanotube_packet_t* packet, uint32_t ifindex,
+                                uint64_t flags) {
+  /* The interface index is the Nanotube port.  Reject the ones which
+   * do not fit or which would turn the packet into a control capsule. */
+  if( ifindex >= NANOTUBE_PORT_CONTROL )
+    return XDP_ABORTED;
+
+  nanotube_packet_set_port(packet, nanotube_packet_port_t(ifindex));
+  return XDP_REDIRECT;
+}
+
+#ifdef __clang__
+__attribute__((always_inline))
+#endif
+int32_t packet_redirect_map_adapter(nanotube_context_t* ctx,
+                                    nanotube_packet_t* packet,
+                                    nanotube_map_id_t map_id,
+                                    uint32_t key, uint64_t flags) {
+  /* The first four bytes of the value hold the interface index.  This
+   * covers both the plain DEVMAP value and struct bpf_devmap_val.  For
+   * an XSKMAP the control plane stores the port of the socket there. */
+  uint8_t key_buf[sizeof(key)];
+  uint8_t value_buf[sizeof(uint32_t)];
+  for( unsigned i = 0; i < sizeof(key); i++ )
+    key_buf[i] = uint8_t(key >> (8 * i));
+
+  size_t ret = nanotube_map_read(ctx, map_id, key_buf, sizeof(key_buf),
+                                 value_buf, 0, sizeof(value_buf));
+
+  /* On a failed lookup the lower bits of the flags are the action. */
+  if( ret != sizeof(value_buf) )
+    return int32_t(flags & redirect_map_action_mask);
+
+  uint32_t ifindex = ( uint32_t(value_buf[0])       |
+                       uint32_t(value_buf[1]) << 8  |
+                       uint32_t(value_buf[2]) << 16 |
+                       uint32_t(value_buf[3]) << 24 );
+  return packet_redirect_adapter(packet, ifindex, 0);
+}
+
 } // extern "C"
 
 
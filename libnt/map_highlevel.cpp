@@ -45,37 +45,43 @@ size_t nanotube_map_write(nanotube_context_t* ctx, nanotube_map_id_t id,
                          all_one,  offset, data_length);
 }
 
+static inline uint16_t capsule_get_u16(const uint8_t *ptr)
+{
+  return ( (uint16_t(ptr[0]) << 0) |
+           (uint16_t(ptr[1]) << 8) );
+}
+
+static inline void capsule_set_u16(uint8_t *ptr, uint16_t val)
+{
+  ptr[0] = uint8_t(val >> 0);
+  ptr[1] = uint8_t(val >> 8);
+}
+
+/* Perform the map operation of a single capsule entry.  The key and
+ * value are updated in place to form the response.  Returns the
+ * response code. */
 #ifdef __clang__
 __attribute__((always_inline))
 #endif
-void nanotube_map_process_capsule(nanotube_context_t *ctxt,
-                                  nanotube_map_id_t map_id,
-                                  uint8_t *capsule,
-                                  size_t key_length,
-                                  size_t value_length)
+static uint16_t
+nanotube_map_process_capsule_entry(nanotube_context_t *ctxt,
+                                   nanotube_map_id_t map_id,
+                                   uint16_t opcode,
+                                   uint8_t *key_ptr,
+                                   uint8_t *value_ptr,
+                                   size_t key_length,
+                                   size_t value_length)
 {
-#ifndef NANOTUBE_CAPSULE_LITTLE_ENDIAN
-#error "Expected little-endian format."
-#endif
-
-  // Get pointers to the key and value.
-  uint8_t *key_ptr = 
-    ( capsule +
-      NANOTUBE_CAPSULE_MAP_KEY_OFFSET(key_length, value_length) );
-  uint8_t *value_ptr =
-    ( capsule +
-      NANOTUBE_CAPSULE_MAP_VALUE_OFFSET(key_length, value_length) );
-
   // Generate a mask which is required for some operations.
   size_t mask_size = (value_length + 7) / 8;
   uint8_t* all_one = (uint8_t*)alloca(mask_size);
   memset(all_one, 0xff, mask_size);
 
-  // Extract the opcode.
-  static_assert(NANOTUBE_CAPSULE_MAP_OPCODE_SIZE == 2,
-                "Opcode size mismatch.");
-  auto opcode = ( (uint16_t(capsule[NANOTUBE_CAPSULE_MAP_OPCODE_OFFSET+0]) << 0) |
-                  (uint16_t(capsule[NANOTUBE_CAPSULE_MAP_OPCODE_OFFSET+1]) << 8) );
+  // Take a copy of the value so that the response can be written to
+  // the capsule without clobbering the request.
+  uint8_t* data_in = (uint8_t*)alloca(value_length);
+  memcpy(data_in, value_ptr, value_length);
+
   enum map_access_t access = NANOTUBE_MAP_NOP;
 
   // Perform the relevant operation.
@@ -97,16 +103,129 @@ void nanotube_map_process_capsule(nanotube_context_t *ctxt,
     break;
 
   case NANOTUBE_CAPSULE_MAP_OPCODE_REMOVE:
+    access = NANOTUBE_MAP_REMOVE;
+    break;
+
+  case NANOTUBE_CAPSULE_MAP_OPCODE_NEXT_KEY: {
+    // Find the next key and then read its value.
+    uint8_t* next_key = (uint8_t*)alloca(key_length);
+    size_t len = nanotube_map_op(ctxt, map_id, NANOTUBE_MAP_NEXT_KEY,
+                                 key_ptr, key_length, NULL, next_key,
+                                 NULL, 0, key_length);
+    if (len == 0)
+      return NANOTUBE_CAPSULE_RESPONSE_CODE_NO_ENTRY;
+    memcpy(key_ptr, next_key, key_length);
     access = NANOTUBE_MAP_READ;
     break;
+  }
 
-  case NANOTUBE_CAPSULE_MAP_OPCODE_NEXT_KEY:
   default:
-    break;
+    return NANOTUBE_CAPSULE_RESPONSE_CODE_UNKNOWN_OPCODE;
+  }
+
+  size_t len = nanotube_map_op(ctxt, map_id, access, key_ptr, key_length,
+                               data_in, value_ptr, all_one, 0,
+                               value_length);
+  return ( len != 0 ?
+           NANOTUBE_CAPSULE_RESPONSE_CODE_SUCCESS :
+           NANOTUBE_CAPSULE_RESPONSE_CODE_NO_ENTRY );
+}
+
+#ifdef __clang__
+__attribute__((always_inline))
+#endif
+void nanotube_map_process_capsule(nanotube_context_t *ctxt,
+                                  nanotube_map_id_t map_id,
+                                  uint8_t *capsule,
+                                  size_t key_length,
+                                  size_t value_length)
+{
+#ifndef NANOTUBE_CAPSULE_LITTLE_ENDIAN
+#error "Expected little-endian format."
+#endif
+
+  // Get pointers to the key and value.
+  uint8_t *key_ptr = 
+    ( capsule +
+      NANOTUBE_CAPSULE_MAP_KEY_OFFSET(key_length, value_length) );
+  uint8_t *value_ptr =
+    ( capsule +
+      NANOTUBE_CAPSULE_MAP_VALUE_OFFSET(key_length, value_length) );
+
+  // Extract the opcode.
+  static_assert(NANOTUBE_CAPSULE_MAP_OPCODE_SIZE == 2,
+                "Opcode size mismatch.");
+  auto opcode = capsule_get_u16(capsule + NANOTUBE_CAPSULE_MAP_OPCODE_OFFSET);
+
+  uint16_t resp_code =
+    nanotube_map_process_capsule_entry(ctxt, map_id, opcode,
+                                       key_ptr, value_ptr,
+                                       key_length, value_length);
+
+  static_assert(NANOTUBE_CAPSULE_RESPONSE_CODE_SIZE == 2,
+                "Response code size mismatch.");
+  capsule_set_u16(capsule + NANOTUBE_CAPSULE_RESPONSE_CODE_OFFSET,
+                  resp_code);
+}
+
+#ifdef __clang__
+__attribute__((always_inline))
+#endif
+void nanotube_map_process_capsule_batch(nanotube_context_t *ctxt,
+                                        nanotube_map_id_t map_id,
+                                        uint8_t *capsule,
+                                        size_t key_length,
+                                        size_t value_length,
+                                        size_t max_entries)
+{
+  // Handle single entry capsules as usual.
+  auto opcode = capsule_get_u16(capsule + NANOTUBE_CAPSULE_MAP_OPCODE_OFFSET);
+  if (opcode != NANOTUBE_CAPSULE_MAP_OPCODE_BATCH) {
+    nanotube_map_process_capsule(ctxt, map_id, capsule,
+                                 key_length, value_length);
+    return;
+  }
+
+  static_assert(NANOTUBE_CAPSULE_MAP_BATCH_COUNT_SIZE == 2,
+                "Count size mismatch.");
+  size_t count =
+    capsule_get_u16(capsule + NANOTUBE_CAPSULE_MAP_BATCH_COUNT_OFFSET);
+  if (count > max_entries) {
+    capsule_set_u16(capsule + NANOTUBE_CAPSULE_RESPONSE_CODE_OFFSET,
+                    NANOTUBE_CAPSULE_RESPONSE_CODE_TOO_LONG);
+    return;
+  }
+
+  // The loop bound is a constant so that the loop can be unrolled.
+  size_t entry_size =
+    NANOTUBE_CAPSULE_MAP_ENTRY_SIZE(key_length, value_length);
+  for (size_t i=0; i<max_entries && i<count; i++) {
+    uint8_t *entry = ( capsule +
+                       NANOTUBE_CAPSULE_MAP_BATCH_ENTRIES_OFFSET +
+                       i*entry_size );
+    uint8_t *key_ptr =
+      ( entry +
+        NANOTUBE_CAPSULE_MAP_ENTRY_KEY_OFFSET(key_length, value_length) );
+    uint8_t *value_ptr =
+      ( entry +
+        NANOTUBE_CAPSULE_MAP_ENTRY_VALUE_OFFSET(key_length, value_length) );
+
+    static_assert(NANOTUBE_CAPSULE_MAP_ENTRY_OPCODE_SIZE == 2,
+                  "Opcode size mismatch.");
+    static_assert(NANOTUBE_CAPSULE_MAP_ENTRY_RESPONSE_CODE_SIZE == 2,
+                  "Response code size mismatch.");
+    uint16_t entry_opcode =
+      capsule_get_u16(entry + NANOTUBE_CAPSULE_MAP_ENTRY_OPCODE_OFFSET);
+    uint16_t resp_code =
+      nanotube_map_process_capsule_entry(ctxt, map_id, entry_opcode,
+                                         key_ptr, value_ptr,
+                                         key_length, value_length);
+    capsule_set_u16(entry + NANOTUBE_CAPSULE_MAP_ENTRY_RESPONSE_CODE_OFFSET,
+                    resp_code);
   }
 
-  nanotube_map_op(ctxt, map_id, access, key_ptr, key_length,
-                  value_ptr, value_ptr, all_one, 0, value_length);
+  capsule_set_u16(capsule + NANOTUBE_CAPSULE_RESPONSE_CODE_OFFSET,
+                  NANOTUBE_CAPSULE_RESPONSE_CODE_SUCCESS);
 }
 
 /* vim: set ts=8 et sw=2 sts=2 tw=75: */
@@ -15,6 +15,7 @@
 
 #include "nanotube_api.h"
 #include "nanotube_context.hpp"
+#include "nanotube_sim.hpp"
 #include "nanotube_thread.hpp"
 #include "processing_system.hpp"
 
@@ -36,6 +37,7 @@ nanotube_channel::nanotube_channel(const std::string &name,
                                    size_t num_elem):
   m_name(name),
   m_elem_size(elem_size),
+  m_num_elem(num_elem),
   m_sideband_size(0),
   m_sideband_signals_size(0),
   m_read_ptr(0),
@@ -45,10 +47,23 @@ nanotube_channel::nanotube_channel(const std::string &name,
   m_reader(nullptr),
   m_writer(nullptr),
   m_read_export_type(NANOTUBE_CHANNEL_TYPE_NONE),
-  m_write_export_type(NANOTUBE_CHANNEL_TYPE_NONE)
+  m_write_export_type(NANOTUBE_CHANNEL_TYPE_NONE),
+  m_sim(nullptr),
+  m_sim_elems(0),
+  m_sim_full_cycles(0)
 {
 }
 
+void nanotube_channel::enable_sim(nanotube_sim *sim)
+{
+  // Elements without any contents are not simulated.
+  if (m_elem_size == 0)
+    return;
+
+  m_sim = sim;
+  m_sim_stamps.assign(m_num_elem, 0);
+}
+
 void nanotube_channel::set_reader(nanotube_context *context)
 {
   if (m_reader != nullptr) {
@@ -154,6 +169,16 @@ bool nanotube_channel::try_read(void* data, size_t data_size)
   size_t offset = read_ptr & ptr_mask;
   memcpy(data, &(m_contents[offset]), data_size);
 
+  // Account for the element in the timing model.  The exported side
+  // of a channel is the egress port of the processing system.
+  if (m_sim != nullptr) {
+    nanotube_sim_stage *stage = nullptr;
+    if (m_read_export_type == NANOTUBE_CHANNEL_TYPE_NONE)
+      stage = m_reader->get_thread()->get_sim_stage();
+    uint64_t &stamp = m_sim_stamps[offset / m_elem_size];
+    stamp = m_sim->read_elem(stage, stamp);
+  }
+
 #ifdef CHANNEL_DATA_DEBUG
   print_data_debug(data, data_size, "read");
 #endif
@@ -271,6 +296,17 @@ bool nanotube_channel::try_write(const void* data, size_t data_size)
   size_t offset = write_ptr & ptr_mask;
   memcpy(&(m_contents[offset]), data, data_size);
 
+  // Account for the element in the timing model.  The exported side
+  // of a channel is the ingress port of the processing system.
+  if (m_sim != nullptr) {
+    nanotube_sim_stage *stage = nullptr;
+    if (m_write_export_type == NANOTUBE_CHANNEL_TYPE_NONE)
+      stage = m_writer->get_thread()->get_sim_stage();
+    uint64_t &stamp = m_sim_stamps[offset / m_elem_size];
+    stamp = m_sim->write_elem(stage, stamp, &m_sim_full_cycles);
+    m_sim_elems++;
+  }
+
   // Update the write pointer.
   if (data_size < m_contents.size() - offset) {
     // If there is enough space without wrapping, increment the low
@@ -337,11 +373,19 @@ nanotube_channel_create(const char* name,
                         size_t elem_size,
                         size_t num_elem)
 {
+  processing_system &ps = processing_system::get_current();
+
+  // The timing model can override the depth of the channel.
+  nanotube_sim *sim = ps.get_sim();
+  if (sim != nullptr)
+    num_elem = sim->get_fifo_depth(name, num_elem);
+
   nanotube_channel::ptr_t
     channel_ptr{ new nanotube_channel(name, elem_size, num_elem) };
 
-  processing_system &ps = processing_system::get_current();
   nanotube_channel *channel = channel_ptr.get();
+  if (sim != nullptr)
+    channel->enable_sim(sim);
   ps.add_channel(name, std::move(channel_ptr));
   return channel;
 }
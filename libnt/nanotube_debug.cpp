@@ -11,14 +11,282 @@
 ** SPDX-License-Identifier: MIT
 **************************************************************************/
 
+// Binary traces
+// =============
+//
+// By default, nanotube_debug_trace writes a line of text to stderr
+// for each call.  That serializes all the threads on the stderr mutex
+// and is very slow for programs instrumented by the add-trace pass.
+// nanotube_debug_trace_open switches to a binary trace file instead.
+//
+// Each thread which calls nanotube_debug_trace gets a ring buffer of
+// trace records.  The thread is the only writer of the head index and
+// a flush thread is the only writer of the tail index, so neither
+// needs a lock.  The flush thread periodically copies the records of
+// all the ring buffers to the file.  If a ring buffer is full, the
+// tracing thread wakes the flush thread and waits for space, so no
+// records are lost.  The registry mutex is only taken when a thread
+// traces for the first time.
+//
+// Threads may still be tracing while the trace is closed.  Each call
+// of nanotube_debug_trace counts itself as a user of the trace before
+// loading the writer.  Closing the trace clears the writer and then
+// waits until there are no users before deleting it, so no thread can
+// still be using it.
+//
+// The records contain a global sequence number so that the decoder
+// (scripts/trace_decode) can restore the order of the calls across
+// threads.  The trace can be sampled and filtered by ID range to
+// reduce the overhead further.
+//
+// The file starts with an 8 byte magic string followed by the records.
+// Each record is three 64-bit words in host byte order: the ID, the
+// value and the sequence number.
+
 #include "nanotube_api.h"
 #include "nanotube_thread.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+const char trace_file_magic[8] = { 'N', 'T', 'T', 'R', 'A', 'C', 'E', '1' };
+
+struct trace_record
+{
+  uint64_t id;
+  uint64_t value;
+  uint64_t seq;
+};
+
+// A single producer, single consumer ring of trace records.
+class trace_ring
+{
+public:
+  static const size_t num_records = 4096;
+
+  trace_ring(): m_head(0), m_tail(0) {}
+
+  // Called by the owning thread.  Returns false if the ring is full.
+  bool push(const trace_record &rec);
+
+  // Called by the flush thread.  Writes the available records.
+  void drain(FILE *out);
+
+private:
+  trace_record m_records[num_records];
+  std::atomic<size_t> m_head;
+  std::atomic<size_t> m_tail;
+};
+
+// The state of an open binary trace.
+class trace_writer
+{
+public:
+  trace_writer(FILE *out, uint64_t sample,
+               uint64_t id_min, uint64_t id_max);
+  ~trace_writer();
+
+  FILE *get_file() const { return m_out; }
+  void trace(uint64_t id, uint64_t value);
+
+private:
+  trace_ring *get_ring();
+  void flush_func();
+  void drain_all();
+
+  FILE *m_out;
+  uint64_t m_sample;
+  uint64_t m_id_min;
+  uint64_t m_id_max;
+  unsigned m_generation;
+
+  std::atomic<uint64_t> m_seq;
+
+  // Protects m_rings, m_stop and the condition variable.
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::vector<std::unique_ptr<trace_ring>> m_rings;
+  bool m_stop;
+
+  std::thread m_flush_thread;
+};
+
+// The ring of the current thread.  The generation identifies the
+// trace_writer which owns it.
+struct thread_trace_state
+{
+  trace_ring *ring;
+  unsigned generation;
+  uint64_t sample_count;
+};
+
+} // anonymous namespace
+
+static std::atomic<trace_writer*> s_trace_writer(nullptr);
+static std::atomic<unsigned> s_trace_users(0);
+static unsigned s_trace_generation = 0;
+static thread_local thread_trace_state s_thread_trace = { nullptr, 0, 0 };
+
+bool trace_ring::push(const trace_record &rec)
+{
+  size_t head = m_head.load(std::memory_order_relaxed);
+  if (head - m_tail.load(std::memory_order_acquire) >= num_records)
+    return false;
+  m_records[head % num_records] = rec;
+  m_head.store(head+1, std::memory_order_release);
+  return true;
+}
+
+void trace_ring::drain(FILE *out)
+{
+  size_t tail = m_tail.load(std::memory_order_relaxed);
+  size_t head = m_head.load(std::memory_order_acquire);
+  while (tail != head) {
+    size_t index = tail % num_records;
+    size_t count = std::min(head - tail, num_records - index);
+    fwrite(&m_records[index], sizeof(trace_record), count, out);
+    tail += count;
+  }
+  m_tail.store(tail, std::memory_order_release);
+}
+
+trace_writer::trace_writer(FILE *out, uint64_t sample,
+                           uint64_t id_min, uint64_t id_max):
+  m_out(out),
+  m_sample(sample == 0 ? 1 : sample),
+  m_id_min(id_min),
+  m_id_max(id_max),
+  m_generation(++s_trace_generation),
+  m_seq(0),
+  m_stop(false)
+{
+  fwrite(trace_file_magic, sizeof(trace_file_magic), 1, m_out);
+  m_flush_thread = std::thread(&trace_writer::flush_func, this);
+}
+
+trace_writer::~trace_writer()
+{
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  m_flush_thread.join();
+  drain_all();
+}
+
+trace_ring *trace_writer::get_ring()
+{
+  thread_trace_state &state = s_thread_trace;
+  if (state.generation == m_generation)
+    return state.ring;
+
+  std::lock_guard<std::mutex> guard(m_mutex);
+  m_rings.emplace_back(new trace_ring);
+  state.ring = m_rings.back().get();
+  state.generation = m_generation;
+  state.sample_count = 0;
+  return state.ring;
+}
+
+void trace_writer::trace(uint64_t id, uint64_t value)
+{
+  if (id < m_id_min || id > m_id_max)
+    return;
+
+  trace_ring *ring = get_ring();
+  if ((s_thread_trace.sample_count++ % m_sample) != 0)
+    return;
+
+  trace_record rec;
+  rec.id = id;
+  rec.value = value;
+  rec.seq = m_seq.fetch_add(1, std::memory_order_relaxed);
+  while (!ring->push(rec)) {
+    m_wake.notify_one();
+    std::this_thread::yield();
+  }
+}
+
+void trace_writer::drain_all()
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+  for (auto &ring: m_rings)
+    ring->drain(m_out);
+}
+
+void trace_writer::flush_func()
+{
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait_for(lock, std::chrono::milliseconds(1));
+      if (m_stop)
+        return;
+    }
+    drain_all();
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+int nanotube_debug_trace_open(const char *filename, uint64_t sample,
+                              uint64_t id_min, uint64_t id_max)
+{
+  FILE *out = fopen(filename, "wb");
+  if (out == nullptr)
+    return -1;
+
+  nanotube_debug_trace_close();
+  s_trace_writer.store(new trace_writer(out, sample, id_min, id_max));
+  return 0;
+}
+
+int nanotube_debug_trace_close(void)
+{
+  trace_writer *writer = s_trace_writer.exchange(nullptr);
+  if (writer == nullptr)
+    return 0;
+
+  // Wait for the threads which loaded the writer before it was
+  // cleared.
+  while (s_trace_users.load() != 0)
+    std::this_thread::yield();
+
+  // Deleting the writer stops the flush thread and writes the
+  // remaining records.
+  FILE *out = writer->get_file();
+  delete writer;
+  bool failed = (ferror(out) != 0);
+  failed |= (fclose(out) != 0);
+  return (failed ? -1 : 0);
+}
 
 void nanotube_debug_trace(uint64_t id, uint64_t value)
 {
+  s_trace_users.fetch_add(1);
+  trace_writer *writer = s_trace_writer.load();
+  if (writer != nullptr) {
+    writer->trace(id, value);
+    s_trace_users.fetch_sub(1, std::memory_order_release);
+    return;
+  }
+  s_trace_users.fetch_sub(1, std::memory_order_release);
+
   nanotube_stderr_guard guard;
   std::cerr << "Trace " << id << " Value " << value << '\n';
 }
@@ -41,4 +309,31 @@ void nanotube_trace_buffer(uint64_t id, uint8_t *buffer,
   std::cerr << "\n";
 }
 
+///////////////////////////////////////////////////////////////////////////
+
+// The number of packets discarded early by each pipeline stage, indexed
+// by the name of the thread which runs the stage.
+static std::mutex s_drop_mutex;
+static std::map<std::string, uint64_t> s_drop_counts;
 
+void nanotube_debug_packet_dropped(void)
+{
+  nanotube_thread *thread = nanotube_thread::get_current();
+  std::string name = (thread != nullptr ? thread->get_name() : "unknown");
+
+  std::lock_guard<std::mutex> guard(s_drop_mutex);
+  ++s_drop_counts[name];
+}
+
+void nanotube_debug_print_drops(void)
+{
+  std::lock_guard<std::mutex> guard(s_drop_mutex);
+  if (s_drop_counts.empty())
+    return;
+
+  std::cout << "Packets dropped early:\n";
+  for (auto &name_count: s_drop_counts)
+    std::cout << "  " << name_count.first << ": " << name_count.second
+              << '\n';
+  s_drop_counts.clear();
+}
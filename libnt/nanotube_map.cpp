@@ -9,6 +9,7 @@
 ** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
 ** SPDX-License-Identifier: MIT
 **************************************************************************/
+#include <alloca.h>
 #include <assert.h>
 #include <iomanip>
 #include <iostream>
@@ -18,6 +19,7 @@
 #include "nanotube_api.h"
 #include "nanotube_context.hpp"
 #include "nanotube_map.hpp"
+#include "nanotube_map_taps.h"
 #include "nanotube_private.hpp"
 #include "processing_system.hpp"
 
@@ -111,6 +113,30 @@ struct nanotube_hash_map: public nanotube_map {
     return true;
   }
 
+  /*!
+  ** Find the key which follows a key in iteration order.
+  **
+  ** \param key  The current key.  If it is not present, the first key
+  **             is returned.
+  ** \param next Buffer for the next key.
+  ** \return was there a next key?
+  **/
+  bool next_key(const uint8_t* key, uint8_t* next) override {
+    auto it = map.end();
+    if( key != nullptr )
+      it = map.find(key_wrap(key));
+
+    if( it == map.end() )
+      it = map.begin();
+    else
+      ++it;
+
+    if( it == map.end() )
+      return false;
+    memcpy(next, it->first.key, key_sz);
+    return true;
+  }
+
   struct key_wrap {
     const uint8_t* key;
     key_wrap(const uint8_t* k) : key(k) {
@@ -283,6 +309,33 @@ public:
     exit(1);
   }
 
+  /*!
+  ** Find the key which follows a key in index order.
+  **
+  ** \param key  The current key.  If it is out of range, the first key
+  **             is returned.
+  ** \param next Buffer for the next key.
+  ** \return was there a next key?
+  **/
+  bool next_key(const uint8_t* key, uint8_t* next) override {
+    size_t index = 0;
+    if( lookup(key) != nullptr ) {
+      for (size_t i=key_sz; i!=0; ) {
+        --i;
+        index = (index<<8) | key[i];
+      }
+      index++;
+    }
+    if( index >= max_entries )
+      return false;
+
+    for( size_t i = 0; i < key_sz; ++i ) {
+      next[i] = uint8_t(index);
+      index >>= 8;
+    }
+    return true;
+  }
+
   /*!
   ** Print the entries of this map to os.
   **/
@@ -394,7 +447,8 @@ size_t nanotube_map_op(nanotube_context_t* ctx, nanotube_map_id_t id,
 
   /* Read a found value for all operations. (NANO-274) */
   int len = 0;
-  if( value != nullptr && data_out != nullptr ) {
+  if( value != nullptr && data_out != nullptr &&
+      type != NANOTUBE_MAP_NEXT_KEY ) {
     len = data_length;
     /* Allow reads with bigger buffers / requests, for now */
     if( offset + len > value_size )
@@ -439,12 +493,37 @@ size_t nanotube_map_op(nanotube_context_t* ctx, nanotube_map_id_t id,
     }
     return data_length;
 
+  case NANOTUBE_MAP_ADD:
+  case NANOTUBE_MAP_ADD_SAT:
+  case NANOTUBE_MAP_MIN:
+  case NANOTUBE_MAP_MAX:
+    if( offset + data_length > value_size )
+      return 0;
+    /* Read-modify-write operations need the entry present */
+    if( value == nullptr || data_in == nullptr )
+      return 0;
+    nanotube_tap_map_rmw_core(data_length, value + offset, data_in, type);
+    return data_length;
+
   case NANOTUBE_MAP_REMOVE: {
     if( value == nullptr )
       return 0;
     bool removed = map->remove(key);
     return removed ? SIZE_MAX : 0;
   }
+
+  case NANOTUBE_MAP_NEXT_KEY: {
+    if( data_out == nullptr || offset >= map->key_sz )
+      return 0;
+    uint8_t* next = (uint8_t*)alloca(map->key_sz);
+    if( !map->next_key(key, next) )
+      return 0;
+    len = data_length;
+    if( offset + len > map->key_sz )
+      len = map->key_sz - offset;
+    memcpy(data_out, next + offset, len);
+    return len;
+  }
   default:
     assert(false && "Unknown map op!");
   }
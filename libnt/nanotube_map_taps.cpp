@@ -19,6 +19,62 @@
 
 ///////////////////////////////////////////////////////////////////////////
 
+void
+nanotube_tap_map_rmw_core(
+  /* Parameters */
+  nanotube_map_width_t data_length,
+
+  /* State */
+  uint8_t *value,
+
+  /* Inputs */
+  const uint8_t *data_in,
+  enum map_access_t access)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  // Determine whether the sum overflows and how the value compares to
+  // the operand.  The bytes are visited least significant first, so the
+  // most significant differing byte decides the comparison.
+  unsigned carry = 0;
+  bool less = false;
+  for (nanotube_map_width_t i=0; i<data_length; i++) {
+    unsigned sum = unsigned(value[i]) + data_in[i] + carry;
+    carry = (sum >> 8);
+    if (value[i] != data_in[i])
+      less = (value[i] < data_in[i]);
+  }
+  bool overflow = (carry != 0);
+
+  carry = 0;
+  for (nanotube_map_width_t i=0; i<data_length; i++) {
+    unsigned sum = unsigned(value[i]) + data_in[i] + carry;
+    carry = (sum >> 8);
+
+    switch (access) {
+    case NANOTUBE_MAP_ADD:
+      value[i] = uint8_t(sum);
+      break;
+    case NANOTUBE_MAP_ADD_SAT:
+      value[i] = ( overflow ? 0xff : uint8_t(sum) );
+      break;
+    case NANOTUBE_MAP_MIN:
+      if (!less)
+        value[i] = data_in[i];
+      break;
+    case NANOTUBE_MAP_MAX:
+      if (less)
+        value[i] = data_in[i];
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
+
 namespace {
 struct array_map_params
 {
@@ -91,15 +147,31 @@ nanotube_tap_map_array_core(
   // one side has to be adjusted.  The line below will change this low-level
   // implementation, but change the behaviour in the high-level map for now.
   //bool do_read   = ( access == NANOTUBE_MAP_READ );
-  const bool do_read = true;
+  bool do_next_key = ( access == NANOTUBE_MAP_NEXT_KEY );
+  bool do_read   = !do_next_key;
   bool do_update = ( access == NANOTUBE_MAP_UPDATE ||
                      access == NANOTUBE_MAP_WRITE );
+  bool do_rmw    = ( access == NANOTUBE_MAP_ADD ||
+                     access == NANOTUBE_MAP_ADD_SAT ||
+                     access == NANOTUBE_MAP_MIN ||
+                     access == NANOTUBE_MAP_MAX );
 
   // Start with no data.
   memset(data_out, 0, data_length);
 
   nanotube_map_result_t result = NANOTUBE_MAP_RESULT_ABSENT;
-  if (index < params.m_capacity) {
+  if (do_next_key) {
+    // Every index is present, so the next key is the next index or
+    // the first one if the key is out of range.
+    nanotube_map_depth_t next = (index < params.m_capacity ? index+1 : 0);
+    if (next < params.m_capacity) {
+      for (nanotube_map_width_t i=0; i<key_length && i<data_length; i++) {
+        data_out[i] = uint8_t(next);
+        next >>= 8;
+      }
+      result = NANOTUBE_MAP_RESULT_PRESENT;
+    }
+  } else if (index < params.m_capacity) {
     uint8_t *elem = map_state + index*params.elem_size();
     uint8_t *elem_data = params.data(elem);
 
@@ -110,6 +182,10 @@ nanotube_tap_map_array_core(
     if (do_update) {
       memcpy(elem_data, data_in, data_length);
     }
+
+    if (do_rmw) {
+      nanotube_tap_map_rmw_core(data_length, elem_data, data_in, access);
+    }
     result = NANOTUBE_MAP_RESULT_PRESENT;
   } else {
     result = NANOTUBE_MAP_RESULT_ABSENT;
@@ -189,12 +265,17 @@ nanotube_tap_map_cam_core(
   // one side has to be adjusted.  The line below will change this low-level
   // implementation, but change the behaviour in the high-level map for now.
   //bool do_read   = ( access == NANOTUBE_MAP_READ );
-  const bool do_read = true;
+  bool do_next_key = ( access == NANOTUBE_MAP_NEXT_KEY );
+  bool do_read   = !do_next_key;
   bool do_insert = ( access == NANOTUBE_MAP_INSERT ||
                      access == NANOTUBE_MAP_WRITE );
   bool do_update = ( access == NANOTUBE_MAP_UPDATE ||
                      access == NANOTUBE_MAP_WRITE );
   bool do_remove = ( access == NANOTUBE_MAP_REMOVE );
+  bool do_rmw    = ( access == NANOTUBE_MAP_ADD ||
+                     access == NANOTUBE_MAP_ADD_SAT ||
+                     access == NANOTUBE_MAP_MIN ||
+                     access == NANOTUBE_MAP_MAX );
 
   // Start with no data.
   memset(data_out, 0, data_length);
@@ -221,6 +302,11 @@ nanotube_tap_map_cam_core(
   // Only insert if there was no match.
   bool need_insert = do_insert && !match_any;
 
+  // The next key is held by the first valid entry after the matching
+  // one, or by the first valid entry if there was no match.
+  bool past_match = !match_any;
+  bool next_any = false;
+
   for (unsigned i=0; i<capacity; i++) {
     uint8_t *elem = map_state + i*params.elem_size();
     uint8_t *elem_key = params.key(elem);
@@ -231,11 +317,21 @@ nanotube_tap_map_cam_core(
     bool insert_elem = (need_insert && target);
     bool update_elem = (do_update && match);
     bool remove_elem = (do_remove && match);
+    bool rmw_elem    = (do_rmw && match);
+    bool valid = (*params.valid(elem) & 1) != 0;
+    bool next_elem   = (do_next_key && valid && past_match && !next_any);
+    past_match |= match;
+    next_any |= next_elem;
 
     if (read_elem) {
       memcpy(data_out, elem_data, data_length);
     }
 
+    if (next_elem) {
+      memcpy(data_out, elem_key,
+             (key_length < data_length ? key_length : data_length));
+    }
+
     if (insert_elem) {
       *params.valid(elem) = 1;
     }
@@ -245,13 +341,22 @@ nanotube_tap_map_cam_core(
       memcpy(elem_data, data_in, data_length);
     }
 
+    if (rmw_elem) {
+      nanotube_tap_map_rmw_core(data_length, elem_data, data_in, access);
+    }
+
     if (remove_elem) {
       *params.valid(elem) = 0;
     }
   }
 
   nanotube_map_result_t result = NANOTUBE_MAP_RESULT_ABSENT;
-  if (match_any) {
+  if (do_next_key) {
+    if (next_any)
+      result = NANOTUBE_MAP_RESULT_PRESENT;
+    else
+      result = NANOTUBE_MAP_RESULT_ABSENT;
+  } else if (match_any) {
     if (do_remove)
       result = NANOTUBE_MAP_RESULT_REMOVED;
     else
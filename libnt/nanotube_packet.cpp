@@ -53,6 +53,25 @@ size_t nanotube_packet_bounded_length(nanotube_packet_t* packet,
   return std::min(pkt_len, max);
 }
 
+uint16_t nanotube_packet_csum(nanotube_packet_t* packet, size_t offset,
+                              size_t length, uint32_t seed) {
+  uint32_t sum = (seed & 0xffff) + (seed >> 16);
+  auto sec = ( packet->get_is_capsule()
+               ? NANOTUBE_SECTION_WHOLE
+               : NANOTUBE_SECTION_PAYLOAD );
+  auto pkt_len = packet->size(sec);
+  if( offset < pkt_len ) {
+    /* Truncate long regions */
+    length = std::min(length, pkt_len - offset);
+    const uint8_t* data = nanotube_packet_data(packet) + offset;
+    for( size_t i = 0; i < length; i++ ) {
+      sum += ( (i & 1) == 0 ? (uint32_t(data[i]) << 8) : data[i] );
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  }
+  return nanotube_csum_fold(sum);
+}
+
 
 nanotube_packet_port_t
 nanotube_packet_get_port(nanotube_packet_t* packet)
@@ -548,67 +567,170 @@ void nanotube_packet::set_port(nanotube_packet_port_t port)
   }
 }
 
-bool
-nanotube_packet::get_bus_word(uint8_t *buffer, std::size_t buf_size,
-                              std::size_t *iter)
+///////////////////////////////////////////////////////////////////////////
+
+/* Bus word conversions for the simple bus and softhub bus.  These are
+ * templated on the log2 of the number of data bytes in a word so that
+ * each supported bus width is handled by the same code.  The width is
+ * determined from the size of the buffer passed in. */
+
+template<int LOG_DATA_BYTES>
+static bool get_sb_word(const std::vector<uint8_t> &contents,
+                        uint8_t *buffer, std::size_t *iter)
 {
+  typedef simple_bus::bus_traits<LOG_DATA_BYTES> traits;
   std::size_t offset = *iter;
+  size_t total_size = contents.size();
+
+  assert(offset < total_size);
+  size_t remaining = total_size - offset;
+  const uint8_t *data = &(contents[offset]);
+
+  // Handle a word which is not the last.
+  if (remaining > traits::data_bytes) {
+    memcpy(buffer, data, traits::data_bytes);
+    traits::store_control(buffer, traits::control_value(false, false, 0));
+    *iter = offset + traits::data_bytes;
+    return true;
+  }
+
+  // Handle the last (potentially partial) word.
+  assert(remaining > 0);
+  memcpy(buffer, data, remaining);
+  auto empty = traits::data_bytes-remaining;
+  if (remaining < traits::data_bytes)
+    memset(buffer+remaining, 0, empty);
+  traits::store_control(buffer, traits::control_value(true, false, empty));
+  return false;
+}
 
-  switch (m_bus_type) {
-  default:
-    assert(false); // Unsupported.
+template<int LOG_DATA_BYTES>
+static bool get_shb_word(const std::vector<uint8_t> &contents,
+                         uint8_t *buffer, std::size_t *iter)
+{
+  typedef softhub_bus::bus_traits<LOG_DATA_BYTES> traits;
+  std::size_t offset = *iter;
+  size_t total_size = contents.size();
 
-  case NANOTUBE_BUS_ID_SB: {
-    assert(buf_size == simple_bus::total_bytes);
-    size_t total_size = m_contents.size();
+  assert(offset < total_size);
+  size_t remaining = total_size - offset;
+  const uint8_t *data = &(contents[offset]);
 
-    assert(offset < total_size);
-    size_t remaining = m_contents.size() - offset;
-    uint8_t *data = &(m_contents[offset]);
+  // Handle a word which is not the last.
+  if (remaining > traits::data_bytes) {
+    memcpy(buffer, data, traits::data_bytes);
+    *iter = offset + traits::data_bytes;
+    return true;
+  }
 
-    // Handle a word which is not the last.
-    if (remaining > simple_bus::data_bytes) {
-      memcpy(buffer, data, simple_bus::data_bytes);
-      buffer[simple_bus::control_offset()] =
-        simple_bus::control_value(false, false, 0);
-      *iter = offset + simple_bus::data_bytes;
-      return true;
-    }
+  // Handle the final (potentially partial) word.
+  assert(remaining > 0);
+  memcpy(buffer, data, remaining);
+  if (remaining < traits::data_bytes)
+    memset(buffer+remaining, 0, traits::data_bytes-remaining);
+  return false;
+}
 
-    // Handle the last (potentially partial) word.
-    assert(remaining > 0);
-    memcpy(buffer, data, remaining);
-    auto empty = simple_bus::data_bytes-remaining;
-    if (remaining < simple_bus::data_bytes)
-      memset(buffer+remaining, 0, empty);
-    buffer[simple_bus::control_offset()] =
-      simple_bus::control_value(true, false, empty);
-    return false;
+template<int LOG_DATA_BYTES>
+static bool add_sb_word(std::vector<uint8_t> &contents,
+                        const uint8_t *buffer)
+{
+  typedef simple_bus::bus_traits<LOG_DATA_BYTES> traits;
+
+  // The number of bytes to append.
+  const uint8_t *data = buffer + traits::data_offset(0);
+  std::size_t num_bytes = traits::data_bytes;
+
+  // If EOP is not set then just append the whole word.
+  auto control = traits::load_control(buffer);
+  if (!traits::get_control_eop(control)) {
+    contents.insert(contents.end(), data, data+num_bytes);
+    // Indicate that there are more words to come.
+    return true;
   }
 
-  case NANOTUBE_BUS_ID_SHB: {
-    assert(buf_size == softhub_bus::total_bytes);
-    size_t total_size = m_contents.size();
+  // If EOP is set then append the bytes which are not empty.
+  std::size_t empty = traits::get_control_empty(control);
+  assert(empty < num_bytes);
+  num_bytes -= empty;
+  contents.insert(contents.end(), data, data+num_bytes);
 
-    assert(offset < total_size);
-    size_t remaining = m_contents.size() - offset;
-    uint8_t *data = &(m_contents[offset]);
+  // Indicate that this is the last word.
+  return false;
+}
 
-    // Handle a word which is not the last.
-    if (remaining > softhub_bus::data_bytes) {
-      memcpy(buffer, data, softhub_bus::data_bytes);
-      *iter = offset + softhub_bus::data_bytes;
-      return true;
-    }
+template<int LOG_DATA_BYTES>
+static bool add_shb_word(std::vector<uint8_t> &contents,
+                         const uint8_t *buffer)
+{
+  typedef softhub_bus::bus_traits<LOG_DATA_BYTES> traits;
 
-    // Handle the final (potentially partial) word.
-    assert(remaining > 0);
-    memcpy(buffer, data, remaining);
-    if (remaining < softhub_bus::data_bytes)
-      memset(buffer+remaining, 0, softhub_bus::data_bytes-remaining);
-    return false;
+  const uint8_t *data = buffer+traits::data_offset(0);
+  std::size_t num_bytes = traits::data_bytes;
+
+  // Insert the bytes into the packet.
+  contents.insert(contents.end(), data, data+num_bytes);
+
+  // Check whether we reached the end of the packet.  The header is
+  // already present because the first word has been read.
+  static_assert(sizeof(softhub_bus::header) <= traits::total_bytes,
+                "Softhub header does not fit in a bus word.");
+
+  uint8_t *p_data = &(contents.front());
+  auto sec_len = contents.size();
+  auto cap_len = softhub_bus::get_ch_length_raw(p_data);
+
+  // Indicate that there is more to come if the packet is not
+  // complete.
+  if (sec_len < cap_len) {
+    return true;
+  }
+
+  // Otherwise end of packet reached so strip the excess bytes.
+  if (cap_len < sec_len) {
+    contents.resize(cap_len);
   }
 
+  // Indicate that this was the last word.
+  return false;
+}
+
+bool
+nanotube_packet::get_bus_word(uint8_t *buffer, std::size_t buf_size,
+                              std::size_t *iter)
+{
+  std::size_t offset = *iter;
+
+  switch (m_bus_type) {
+  default:
+    assert(false); // Unsupported.
+
+  case NANOTUBE_BUS_ID_SB:
+    switch (buf_size) {
+    case simple_bus::bus_traits<5>::total_bytes:
+      return get_sb_word<5>(m_contents, buffer, iter);
+    case simple_bus::bus_traits<6>::total_bytes:
+      return get_sb_word<6>(m_contents, buffer, iter);
+    case simple_bus::bus_traits<7>::total_bytes:
+      return get_sb_word<7>(m_contents, buffer, iter);
+    default:
+      assert(false); // Unsupported bus width.
+      return false;
+    }
+
+  case NANOTUBE_BUS_ID_SHB:
+    switch (buf_size) {
+    case softhub_bus::bus_traits<5>::total_bytes:
+      return get_shb_word<5>(m_contents, buffer, iter);
+    case softhub_bus::bus_traits<6>::total_bytes:
+      return get_shb_word<6>(m_contents, buffer, iter);
+    case softhub_bus::bus_traits<7>::total_bytes:
+      return get_shb_word<7>(m_contents, buffer, iter);
+    default:
+      assert(false); // Unsupported bus width.
+      return false;
+    }
+
   case NANOTUBE_BUS_ID_X3RX: {
     assert(buf_size == x3rx_bus::total_bytes);
     size_t total_size = m_contents.size();
@@ -656,63 +778,32 @@ nanotube_packet::add_bus_word(uint8_t *buffer, std::size_t buf_size)
   default:
     assert(false); // Unsupported.
 
-  case NANOTUBE_BUS_ID_SB: {
-    assert(buf_size == simple_bus::total_bytes);
-
-    // The number of bytes to append.
-    uint8_t *data = buffer + simple_bus::data_offset(0);
-    std::size_t num_bytes = simple_bus::data_bytes;
-
-    // If EOP is not set then just append the whole word.
-    auto control = buffer[simple_bus::control_offset()];
-    if ((control & simple_bus::control_eop) == 0) {
-      m_contents.insert(m_contents.end(), data, data+num_bytes);
-      // Indicate that there are more words to come.
-      return true;
-    }
-
-    // If EOP is set then append the bytes which are not empty.
-    std::size_t empty = simple_bus::get_control_empty(control);
-    assert(empty < num_bytes);
-    num_bytes -= empty;
-    m_contents.insert(m_contents.end(), data, data+num_bytes);
-
-    // Indicate that this is the last word.
-    return false;
-  }
-
-  case NANOTUBE_BUS_ID_SHB: {
-    assert(buf_size == softhub_bus::total_bytes);
-
-    uint8_t *data = buffer+softhub_bus::data_offset(0);
-    std::size_t num_bytes = softhub_bus::data_bytes;
-
-    // Insert the bytes into the packet.
-    m_contents.insert(m_contents.end(), data, data+num_bytes);
-
-    // Check whether we reached the end of the packet.  The header is
-    // already present because the first word has been read.
-    static_assert(sizeof(softhub_bus::header) <= softhub_bus::total_bytes);
-
-    uint8_t *p_data = &(m_contents.front());
-    auto sec_len = m_contents.size();
-    auto cap_len = softhub_bus::get_ch_length_raw(p_data);
-
-    // Indicate that there is more to come if the packet is not
-    // complete.
-    if (sec_len < cap_len) {
-      return true;
+  case NANOTUBE_BUS_ID_SB:
+    switch (buf_size) {
+    case simple_bus::bus_traits<5>::total_bytes:
+      return add_sb_word<5>(m_contents, buffer);
+    case simple_bus::bus_traits<6>::total_bytes:
+      return add_sb_word<6>(m_contents, buffer);
+    case simple_bus::bus_traits<7>::total_bytes:
+      return add_sb_word<7>(m_contents, buffer);
+    default:
+      assert(false); // Unsupported bus width.
+      return false;
     }
 
-    // Otherwise end of packet reached so strip the excess bytes.
-    if (cap_len < sec_len) {
-      m_contents.resize(cap_len);
+  case NANOTUBE_BUS_ID_SHB:
+    switch (buf_size) {
+    case softhub_bus::bus_traits<5>::total_bytes:
+      return add_shb_word<5>(m_contents, buffer);
+    case softhub_bus::bus_traits<6>::total_bytes:
+      return add_shb_word<6>(m_contents, buffer);
+    case softhub_bus::bus_traits<7>::total_bytes:
+      return add_shb_word<7>(m_contents, buffer);
+    default:
+      assert(false); // Unsupported bus width.
+      return false;
     }
 
-    // Indicate that this was the last word.
-    return false;
-  }
-
   case NANOTUBE_BUS_ID_X3RX: {
     assert(buf_size == x3rx_bus::total_bytes);
 
@@ -186,6 +186,53 @@ void nanotube_tap_packet_write_bus(
 
 ///////////////////////////////////////////////////////////////////////////
 
+//Wrapper for nanotube_tap_packet_csum_core() that selects the bus to use
+
+void nanotube_tap_packet_csum_bus(
+  /* Which bus implementation to use */
+  const enum nanotube_bus_id_t bus,
+
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const uint8_t *packet_word_in,
+  nanotube_tap_offset_t packet_word_len,
+  const struct nanotube_tap_packet_csum_req *req_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  switch (bus) {
+      case NANOTUBE_BUS_ID_SB:
+        assert(packet_word_len == simple_bus::total_bytes);
+        return nanotube_tap_packet_csum_sb(resp_out, state_inout,
+                                           packet_word_in,
+                                           req_in);
+        break;
+      case NANOTUBE_BUS_ID_SHB:
+        assert(packet_word_len == softhub_bus::total_bytes);
+        return nanotube_tap_packet_csum_shb(resp_out, state_inout,
+                                            packet_word_in,
+                                            req_in);
+        break;
+      case NANOTUBE_BUS_ID_X3RX:
+        assert(packet_word_len == x3rx_bus::total_bytes);
+        return nanotube_tap_packet_csum_x3rx(resp_out, state_inout,
+                                             packet_word_in,
+                                             req_in);
+        break;
+      default:
+        assert(false);
+  }
+  return;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
 //Wrapper for nanotube_tap_packet_resize_ingress_core() that selects the bus to use
 
 void nanotube_tap_packet_resize_ingress_bus(
@@ -37,9 +37,28 @@
 #include <iostream>
 #endif
 
+/* The scalar implementations of the core primitives are written for
+ * HLS.  When the library is not being compiled for HLS, the host
+ * implementations further down are used instead.  They produce the
+ * same results, but operate on whole words using memcpy, memset and
+ * 64-bit arithmetic, which the compiler is free to vectorise. */
+#if !defined(NANOTUBE_TAPS_HLS) && \
+    defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define NANOTUBE_TAPS_HOST 1
+#else
+#define NANOTUBE_TAPS_HOST 0
+#endif
+
+/* The bodies of the read, write and checksum tap cores are shared by
+ * the C entry points and the nanotube_taps templates.  They are always
+ * inlined so that each template instance is compiled with its packet
+ * buffer size as a constant. */
+#define NANOTUBE_TAP_CORE_INLINE static inline __attribute__((always_inline))
+
 ///////////////////////////////////////////////////////////////////////////
 
-void nanotube_rotate_down(
+void nanotube_rotate_down_scalar(
   /* Constant parameters. */
   uint16_t buffer_out_length,
   uint16_t rot_buffer_length,
@@ -173,34 +192,7 @@ void nanotube_rotate_down(
 
 ///////////////////////////////////////////////////////////////////////////
 
-enum byte_class: uint8_t {
-  BYTE_CLASS_BEFORE,
-  BYTE_CLASS_IN,
-  BYTE_CLASS_AFTER,
-};
-
-/*! Classify the buffer entries relative to the specified region.
- *
- * \param result_buffer_length The number of entries in the buffer.
- *
- * \param result_buffer_index_bits The number of bits required to
- * represent an index into the buffer.
- *
- * \param buffer_out The output buffer.
- *
- * \param start_offset The offset of the first byte of the region.
- *
- * \param end_offset The offset after the last byte of the region.
- *
- * The buffer bytes are all set based on whether they are before, in
- * or after the specified region as follows:
- *   BYTE_CLASS_BEFORE: index < start_offset
- *   BYTE_CLASS_IN: index >= start_offset && index < end_offset
- *   BYTE_CLASS_AFTER: index >= end_offset
- *
- * The caller must make sure start_offset<=end_offset.
- */
-static void nanotube_classify_entries(
+void nanotube_classify_entries_scalar(
   /* Constant parameters. */
   uint16_t result_buffer_length,
   uint8_t result_buffer_index_bits,
@@ -373,10 +365,10 @@ static void nanotube_classify_entries(
 
 ///////////////////////////////////////////////////////////////////////////
 
-void nanotube_shift_down_bits(uint32_t buffer_out_length,
-                              uint8_t *buffer_out,
-                              const uint8_t *buffer_in,
-                              uint8_t shift_amount)
+void nanotube_shift_down_bits_scalar(uint32_t buffer_out_length,
+                                     uint8_t *buffer_out,
+                                     const uint8_t *buffer_in,
+                                     uint8_t shift_amount)
 #if __clang__
   __attribute__((always_inline))
 #endif
@@ -394,10 +386,10 @@ void nanotube_shift_down_bits(uint32_t buffer_out_length,
 
 ///////////////////////////////////////////////////////////////////////////
 
-void nanotube_duplicate_bits(uint8_t *dup_bits_out,
-                             const uint8_t *bit_vec_in,
-                             uint32_t input_bit_length,
-                             uint32_t padded_bit_length)
+void nanotube_duplicate_bits_scalar(uint8_t *dup_bits_out,
+                                    const uint8_t *bit_vec_in,
+                                    uint32_t input_bit_length,
+                                    uint32_t padded_bit_length)
 #if __clang__
   __attribute__((always_inline))
 #endif
@@ -531,6 +523,319 @@ void nanotube_duplicate_bits(uint8_t *dup_bits_out,
   }
 }
 
+///////////////////////////////////////////////////////////////////////////
+
+void nanotube_packet_write_blend_scalar(
+  uint16_t packet_buffer_length,
+  uint8_t packet_buffer_index_bits,
+  uint16_t rot_buf_length,
+  uint8_t *packet_buffer_out,
+  const uint8_t *packet_buffer_in,
+  const uint8_t *rot_data,
+  const uint8_t *rot_mask,
+  uint16_t start_offset,
+  uint16_t end_offset)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  /* Classify the bytes of the packet buffer. */
+  enum byte_class byte_classes[packet_buffer_length];
+  nanotube_classify_entries_scalar(
+    packet_buffer_length,
+    packet_buffer_index_bits,
+    byte_classes,
+    start_offset,
+    end_offset);
+
+  /* Write the packet buffer. */
+#if __clang__
+#pragma clang loop unroll(full)
+#endif
+  for (uint16_t index=0; index<packet_buffer_length; index++) {
+    uint8_t packet_in_byte = packet_buffer_in[index];
+    uint16_t rot_index = index % rot_buf_length;
+    uint8_t req_byte = rot_data[rot_index];
+    uint8_t mask_byte = rot_mask[rot_index/8];
+    uint8_t mask_bit = (mask_byte >> (rot_index&7)) & 1;
+    enum byte_class this_byte_class = byte_classes[index];
+    uint8_t output_byte =
+      ( this_byte_class == BYTE_CLASS_IN && mask_bit != 0
+        ? req_byte : packet_in_byte );
+    packet_buffer_out[index] = output_byte;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+#if NANOTUBE_TAPS_HOST
+
+static inline uint64_t nanotube_load_word(const uint8_t *ptr)
+{
+  uint64_t val;
+  memcpy(&val, ptr, sizeof(val));
+  return val;
+}
+
+static inline void nanotube_store_word(uint8_t *ptr, uint64_t val)
+{
+  memcpy(ptr, &val, sizeof(val));
+}
+
+/* Expand the 8 bits of a mask byte into a word with one byte per
+ * mask bit.  The byte is broadcast into each lane, each lane keeps
+ * its own bit and then each non-zero lane is widened to 0xff. */
+static inline uint64_t nanotube_expand_mask(uint8_t mask)
+{
+  const uint64_t lsbs = 0x0101010101010101ULL;
+  uint64_t bits = (mask * lsbs) & 0x8040201008040201ULL;
+  uint64_t msbs = (bits + 0x7f7f7f7f7f7f7f7fULL) & (0x80 * lsbs);
+  return (msbs >> 7) * 0xff;
+}
+
+void nanotube_rotate_down(
+  /* Constant parameters. */
+  uint16_t buffer_out_length,
+  uint16_t rot_buffer_length,
+  uint16_t buffer_in_length,
+  uint8_t rot_amount_bits,
+
+  /* Outputs. */
+  uint8_t *buffer_out,
+
+  /* Inputs. */
+  const uint8_t *buffer_in,
+  uint16_t rot_amount)
+{
+  assert(rot_buffer_length != 0);
+  uint32_t in_length = std::min(buffer_in_length, rot_buffer_length);
+  uint32_t amount_mask = (uint32_t(1) << rot_amount_bits) - 1;
+  uint32_t pos = (rot_amount & amount_mask) % rot_buffer_length;
+
+  /* Copy contiguous runs of the padded input, wrapping back to the
+   * start of the rotation buffer at the end of each run. */
+  uint32_t index = 0;
+  while (index < buffer_out_length) {
+    uint32_t run = std::min(uint32_t(buffer_out_length - index),
+                            uint32_t(rot_buffer_length - pos));
+    uint32_t copy = ( pos >= in_length ? 0 :
+                      std::min(run, in_length - pos) );
+    memcpy(buffer_out + index, buffer_in + pos, copy);
+    memset(buffer_out + index + copy, 0, run - copy);
+    index += run;
+    pos = 0;
+  }
+}
+
+void nanotube_classify_entries(
+  /* Constant parameters. */
+  uint16_t result_buffer_length,
+  uint8_t result_buffer_index_bits,
+
+  /* Outputs. */
+  enum byte_class *buffer_out,
+
+  /* Inputs. */
+  uint16_t start_offset,
+  uint16_t end_offset)
+{
+  uint16_t start = std::min(start_offset, result_buffer_length);
+  uint16_t end = std::max(start, std::min(end_offset,
+                                          result_buffer_length));
+  memset(buffer_out, BYTE_CLASS_BEFORE, start);
+  memset(buffer_out + start, BYTE_CLASS_IN, end - start);
+  memset(buffer_out + end, BYTE_CLASS_AFTER, result_buffer_length - end);
+}
+
+void nanotube_shift_down_bits(uint32_t buffer_out_length,
+                              uint8_t *buffer_out,
+                              const uint8_t *buffer_in,
+                              uint8_t shift_amount)
+{
+  if (shift_amount == 0) {
+    memmove(buffer_out, buffer_in, buffer_out_length);
+    return;
+  }
+
+  /* Each output word needs the corresponding input word and the
+   * first byte of the following word. */
+  uint32_t index = 0;
+  for (; index + 8 <= buffer_out_length; index += 8) {
+    uint64_t lo = nanotube_load_word(buffer_in + index);
+    uint64_t hi = buffer_in[index + 8];
+    nanotube_store_word(buffer_out + index,
+                        (lo >> shift_amount) |
+                        (hi << (64 - shift_amount)));
+  }
+
+  for (; index < buffer_out_length; index++) {
+    uint16_t val = ( (uint16_t(buffer_in[index+1]) << 8) |
+                     buffer_in[index] );
+    buffer_out[index] = val >> shift_amount;
+  }
+}
+
+void nanotube_duplicate_bits(uint8_t *dup_bits_out,
+                             const uint8_t *bit_vec_in,
+                             uint32_t input_bit_length,
+                             uint32_t padded_bit_length)
+{
+  uint32_t input_byte_length = (input_bit_length+7)/8;
+  uint32_t output_byte_length = (2*padded_bit_length+7)/8;
+  uint32_t lshift = padded_bit_length % 8;
+  uint32_t base = padded_bit_length / 8;
+
+  /* The input with the bits after input_bit_length cleared. */
+  uint8_t masked[input_byte_length + 1];
+  memcpy(masked, bit_vec_in, input_byte_length);
+  masked[input_byte_length] = 0;
+  if (input_bit_length % 8 != 0)
+    masked[input_byte_length-1] &= (1 << (input_bit_length % 8)) - 1;
+
+  /* The first copy is not shifted. */
+  uint32_t first_length = std::min(input_byte_length, output_byte_length);
+  memcpy(dup_bits_out, masked, first_length);
+  memset(dup_bits_out + first_length, 0,
+         output_byte_length - first_length);
+
+  /* The second copy starts at bit padded_bit_length. */
+  for (uint32_t in_idx = 0; in_idx <= input_byte_length; in_idx++) {
+    uint32_t out_idx = base + in_idx;
+    if (out_idx >= output_byte_length)
+      break;
+    uint8_t low = masked[in_idx] << lshift;
+    uint8_t high = ( in_idx == 0 || lshift == 0 ? 0 :
+                     masked[in_idx-1] >> (8 - lshift) );
+    dup_bits_out[out_idx] |= low | high;
+  }
+}
+
+/* Write the IN region of the packet buffer, selecting request bytes
+ * using the rotated mask a word at a time where possible. */
+void nanotube_packet_write_blend(
+  uint16_t packet_buffer_length,
+  uint8_t packet_buffer_index_bits,
+  uint16_t rot_buf_length,
+  uint8_t *packet_buffer_out,
+  const uint8_t *packet_buffer_in,
+  const uint8_t *rot_data,
+  const uint8_t *rot_mask,
+  uint16_t start_offset,
+  uint16_t end_offset)
+{
+  memmove(packet_buffer_out, packet_buffer_in, packet_buffer_length);
+  uint32_t end = std::min(end_offset, packet_buffer_length);
+  uint32_t index = start_offset;
+  while (index < end) {
+    uint32_t rot_index = index % rot_buf_length;
+    if ( (rot_index & 7) == 0 &&
+         index + 8 <= end &&
+         rot_index + 8 <= rot_buf_length ) {
+      uint64_t sel = nanotube_expand_mask(rot_mask[rot_index/8]);
+      uint64_t pkt = nanotube_load_word(packet_buffer_out + index);
+      uint64_t req = nanotube_load_word(rot_data + rot_index);
+      nanotube_store_word(packet_buffer_out + index,
+                          (pkt & ~sel) | (req & sel));
+      index += 8;
+    } else {
+      if ( ((rot_mask[rot_index/8] >> (rot_index&7)) & 1) != 0 )
+        packet_buffer_out[index] = rot_data[rot_index];
+      index++;
+    }
+  }
+}
+
+#else /* !NANOTUBE_TAPS_HOST */
+
+void nanotube_rotate_down(
+  /* Constant parameters. */
+  uint16_t buffer_out_length,
+  uint16_t rot_buffer_length,
+  uint16_t buffer_in_length,
+  uint8_t rot_amount_bits,
+
+  /* Outputs. */
+  uint8_t *buffer_out,
+
+  /* Inputs. */
+  const uint8_t *buffer_in,
+  uint16_t rot_amount)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  nanotube_rotate_down_scalar(buffer_out_length, rot_buffer_length,
+                              buffer_in_length, rot_amount_bits,
+                              buffer_out, buffer_in, rot_amount);
+}
+
+void nanotube_classify_entries(
+  /* Constant parameters. */
+  uint16_t result_buffer_length,
+  uint8_t result_buffer_index_bits,
+
+  /* Outputs. */
+  enum byte_class *buffer_out,
+
+  /* Inputs. */
+  uint16_t start_offset,
+  uint16_t end_offset)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  nanotube_classify_entries_scalar(result_buffer_length,
+                                   result_buffer_index_bits,
+                                   buffer_out, start_offset, end_offset);
+}
+
+void nanotube_shift_down_bits(uint32_t buffer_out_length,
+                              uint8_t *buffer_out,
+                              const uint8_t *buffer_in,
+                              uint8_t shift_amount)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  nanotube_shift_down_bits_scalar(buffer_out_length, buffer_out,
+                                  buffer_in, shift_amount);
+}
+
+void nanotube_duplicate_bits(uint8_t *dup_bits_out,
+                             const uint8_t *bit_vec_in,
+                             uint32_t input_bit_length,
+                             uint32_t padded_bit_length)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  nanotube_duplicate_bits_scalar(dup_bits_out, bit_vec_in,
+                                 input_bit_length, padded_bit_length);
+}
+
+void nanotube_packet_write_blend(
+  uint16_t packet_buffer_length,
+  uint8_t packet_buffer_index_bits,
+  uint16_t rot_buf_length,
+  uint8_t *packet_buffer_out,
+  const uint8_t *packet_buffer_in,
+  const uint8_t *rot_data,
+  const uint8_t *rot_mask,
+  uint16_t start_offset,
+  uint16_t end_offset)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  nanotube_packet_write_blend_scalar(packet_buffer_length,
+                                     packet_buffer_index_bits,
+                                     rot_buf_length, packet_buffer_out,
+                                     packet_buffer_in, rot_data, rot_mask,
+                                     start_offset, end_offset);
+}
+
+#endif /* NANOTUBE_TAPS_HOST */
+
 
 ///////////////////////////////////////////////////////////////////////////
 
@@ -573,7 +878,7 @@ void nanotube_tap_packet_length_core(
 
 ///////////////////////////////////////////////////////////////////////////
 
-void nanotube_tap_packet_read_core(
+NANOTUBE_TAP_CORE_INLINE void tap_packet_read_core_impl(
   /* Constant parameters */
   uint16_t result_buffer_length,
   uint8_t result_buffer_index_bits,
@@ -592,9 +897,6 @@ void nanotube_tap_packet_read_core(
   bool packet_word_eop,
   uint16_t packet_word_length,
   const struct nanotube_tap_packet_read_req *req_in)
-#if __clang__
-  __attribute__((always_inline))
-#endif
 {
   /* The read tap copies a contiguous region of the packet into the
    * result buffer.  It does this by first rotating the packet data so
@@ -723,6 +1025,22 @@ void nanotube_tap_packet_read_core(
             << ".\n";
 #endif
 
+#if NANOTUBE_TAPS_HOST
+  /* Keep the bytes before the word, copy the bytes in the word from
+   * the rotation buffer and clear the bytes after the word. */
+  uint32_t copy_end = std::min(result_end_offset, result_buffer_length);
+  for (uint32_t index = result_start_offset; index < copy_end; ) {
+    uint32_t rot_index = index % sizeof(rot_buffer);
+    uint32_t run = std::min(copy_end - index,
+                            uint32_t(sizeof(rot_buffer) - rot_index));
+    memcpy(result_buffer_inout + index, rot_buffer + rot_index, run);
+    index += run;
+  }
+  uint32_t clear_start = std::max(uint32_t(result_start_offset), copy_end);
+  if (clear_start < result_buffer_length)
+    memset(result_buffer_inout + clear_start, 0,
+           result_buffer_length - clear_start);
+#else
   enum byte_class byte_classes[result_buffer_length];
   nanotube_classify_entries(
     result_buffer_length,
@@ -754,11 +1072,69 @@ void nanotube_tap_packet_read_core(
     }
     result_buffer_inout[index] = byte_val;
   }
+#endif
 }
 
+void nanotube_tap_packet_read_core(
+  /* Constant parameters */
+  uint16_t result_buffer_length,
+  uint8_t result_buffer_index_bits,
+  uint16_t packet_buffer_length,
+  uint8_t packet_buffer_index_bits,
+
+  /* Outputs. */
+  struct nanotube_tap_packet_read_resp *resp_out,
+  uint8_t *result_buffer_inout,
+
+  /* State. */
+  struct nanotube_tap_packet_read_state *state_inout,
+
+  /* Inputs. */
+  const uint8_t *packet_buffer_in,
+  bool packet_word_eop,
+  uint16_t packet_word_length,
+  const struct nanotube_tap_packet_read_req *req_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  tap_packet_read_core_impl(
+    result_buffer_length, result_buffer_index_bits, packet_buffer_length,
+    packet_buffer_index_bits, resp_out, result_buffer_inout, state_inout,
+    packet_buffer_in, packet_word_eop, packet_word_length, req_in);
+}
+
+#ifndef NANOTUBE_TAPS_HLS
+template<uint16_t PACKET_BUFFER_LENGTH,
+         uint8_t PACKET_BUFFER_INDEX_BITS>
+void nanotube_taps::tap_packet_read_core(
+  /* Constant parameters */
+  uint16_t result_buffer_length,
+  uint8_t result_buffer_index_bits,
+
+  /* Outputs. */
+  struct nanotube_tap_packet_read_resp *resp_out,
+  uint8_t *result_buffer_inout,
+
+  /* State. */
+  struct nanotube_tap_packet_read_state *state_inout,
+
+  /* Inputs. */
+  const uint8_t *packet_buffer_in,
+  bool packet_word_eop,
+  uint16_t packet_word_length,
+  const struct nanotube_tap_packet_read_req *req_in)
+{
+  tap_packet_read_core_impl(
+    result_buffer_length, result_buffer_index_bits, PACKET_BUFFER_LENGTH,
+    PACKET_BUFFER_INDEX_BITS, resp_out, result_buffer_inout, state_inout,
+    packet_buffer_in, packet_word_eop, packet_word_length, req_in);
+}
+#endif
+
 ///////////////////////////////////////////////////////////////////////////
 
-void nanotube_tap_packet_write_core(
+NANOTUBE_TAP_CORE_INLINE void tap_packet_write_core_impl(
   /* Constant parameters */
   uint16_t request_buffer_length,
   uint8_t request_buffer_index_bits,
@@ -778,9 +1154,6 @@ void nanotube_tap_packet_write_core(
   const struct nanotube_tap_packet_write_req *req_in,
   const uint8_t *request_bytes_in,
   const uint8_t *request_mask_in)
-#if __clang__
-  __attribute__((always_inline))
-#endif
 {
   /* The write tap copies the request buffer into a contiguous region
    * of the packet.  It does this by first rotating the request data
@@ -1045,31 +1418,13 @@ void nanotube_tap_packet_write_core(
   std::cout << std::dec << std::setfill(' ');
 #endif
 
-  /* Classify the bytes of the packet buffer. */
-  enum byte_class byte_classes[packet_buffer_length];
-  nanotube_classify_entries(
-    packet_buffer_length,
-    packet_buffer_index_bits,
-    byte_classes,
-    frag_start_word_offset,
-    frag_end_word_offset);
-
-  /* Write the packet buffer. */
-#if __clang__
-#pragma clang loop unroll(full)
-#endif
-  for (uint16_t index=0; index<packet_buffer_length; index++) {
-    uint8_t packet_in_byte = packet_buffer_in[index];
-    uint16_t rot_index = index % rot_buf_length;
-    uint8_t req_byte = rot_data[rot_index];
-    uint8_t mask_byte = rot_mask[rot_index/8];
-    uint8_t mask_bit = (mask_byte >> (rot_index&7)) & 1;
-    enum byte_class this_byte_class = byte_classes[index];
-    uint8_t output_byte =
-      ( this_byte_class == BYTE_CLASS_IN && mask_bit != 0
-        ? req_byte : packet_in_byte );
-    packet_buffer_out[index] = output_byte;
-  }
+  nanotube_packet_write_blend(packet_buffer_length,
+                              packet_buffer_index_bits,
+                              rot_buf_length,
+                              packet_buffer_out, packet_buffer_in,
+                              rot_data, rot_mask,
+                              frag_start_word_offset,
+                              frag_end_word_offset);
 
 #if DEBUG_PACKET_WRITE
   std::cout << "  Word out: " << std::setfill('0') << std::hex;
@@ -1081,6 +1436,199 @@ void nanotube_tap_packet_write_core(
 #endif
 }
 
+void nanotube_tap_packet_write_core(
+  /* Constant parameters */
+  uint16_t request_buffer_length,
+  uint8_t request_buffer_index_bits,
+  uint16_t packet_buffer_length,
+  uint8_t packet_buffer_index_bits,
+
+  /* Outputs. */
+  uint8_t *packet_buffer_out,
+
+  /* State. */
+  struct nanotube_tap_packet_write_state *state_inout,
+
+  /* Inputs. */
+  const uint8_t *packet_buffer_in,
+  bool packet_word_eop,
+  uint16_t packet_word_length,
+  const struct nanotube_tap_packet_write_req *req_in,
+  const uint8_t *request_bytes_in,
+  const uint8_t *request_mask_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  tap_packet_write_core_impl(
+    request_buffer_length, request_buffer_index_bits, packet_buffer_length,
+    packet_buffer_index_bits, packet_buffer_out, state_inout,
+    packet_buffer_in, packet_word_eop, packet_word_length, req_in,
+    request_bytes_in, request_mask_in);
+}
+
+#ifndef NANOTUBE_TAPS_HLS
+template<uint16_t PACKET_BUFFER_LENGTH,
+         uint8_t PACKET_BUFFER_INDEX_BITS>
+void nanotube_taps::tap_packet_write_core(
+  /* Constant parameters */
+  uint16_t request_buffer_length,
+  uint8_t request_buffer_index_bits,
+
+  /* Outputs. */
+  uint8_t *packet_buffer_out,
+
+  /* State. */
+  struct nanotube_tap_packet_write_state *state_inout,
+
+  /* Inputs. */
+  const uint8_t *packet_buffer_in,
+  bool packet_word_eop,
+  uint16_t packet_word_length,
+  const struct nanotube_tap_packet_write_req *req_in,
+  const uint8_t *request_bytes_in,
+  const uint8_t *request_mask_in)
+{
+  tap_packet_write_core_impl(
+    request_buffer_length, request_buffer_index_bits, PACKET_BUFFER_LENGTH,
+    PACKET_BUFFER_INDEX_BITS, packet_buffer_out, state_inout,
+    packet_buffer_in, packet_word_eop, packet_word_length, req_in,
+    request_bytes_in, request_mask_in);
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////
+
+NANOTUBE_TAP_CORE_INLINE void tap_packet_csum_core_impl(
+  /* Constant parameters */
+  uint16_t packet_buffer_length,
+
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const uint8_t *packet_buffer_in,
+  bool packet_word_eop,
+  uint16_t packet_word_length,
+  const struct nanotube_tap_packet_csum_req *req_in)
+{
+  /* The checksum tap adds each byte in the region to a running sum
+   * as the packet words stream past.  Bytes at an even distance from
+   * the start of the region are shifted into the upper half of a
+   * 16-bit value.  The carries out of the low 16 bits are folded back
+   * in after each word, so the running sum stays well within 32 bits.
+   *
+   * The pipeline stage which calls the tap reruns its prologue,
+   * including the code which builds the request, for every packet word
+   * until the tap reports a valid response.  The request is therefore
+   * presented with every word from the start of the packet up to the
+   * word which completes the region, not just once.  The bytes of a
+   * word are only summed if the request is presented with that word.
+   */
+
+  /* Determine the offset into the packet and update the packet offset
+   * state. */
+  uint16_t word_start_offset = state_inout->packet_offset;
+  uint16_t word_end_offset = word_start_offset + packet_word_length;
+  state_inout->packet_offset = ( packet_word_eop ? 0 : word_end_offset );
+
+  bool req_in_valid = (req_in->valid & 1) != 0;
+  uint16_t csum_start = req_in->csum_offset;
+  uint32_t csum_end = uint32_t(csum_start) + req_in->csum_length;
+
+  uint32_t word_sum = 0;
+  int index;
+#if __clang__
+#pragma clang loop unroll(full)
+#endif
+  for (index = 0; index < packet_buffer_length; index++) {
+    uint16_t offset = word_start_offset + index;
+    bool in_region = ( req_in_valid &&
+                       index < packet_word_length &&
+                       offset >= csum_start &&
+                       offset < csum_end );
+    bool high_byte = ( ((offset - csum_start) & 1) == 0 );
+    uint32_t byte_val = packet_buffer_in[index];
+    word_sum += ( !in_region ? 0 :
+                  ( high_byte ? (byte_val << 8) : byte_val ) );
+  }
+
+  uint32_t sum = state_inout->partial_sum + word_sum;
+  sum = (sum & 0xffff) + (sum >> 16);
+  state_inout->partial_sum = ( packet_word_eop ? 0 : sum );
+
+  /* Produce the response for the word containing the last byte of the
+   * region, or at the end of the packet.  An empty region completes on
+   * the first word which presents the request. */
+  bool old_done = state_inout->done;
+  bool is_done = ( ( req_in_valid &&
+                     ( req_in->csum_length == 0 ||
+                       word_end_offset >= csum_end ) ) ||
+                   packet_word_eop );
+  state_inout->done = ( packet_word_eop ? 0 : is_done );
+  resp_out->valid = ( is_done && !old_done );
+
+  uint32_t summed_end = std::min(uint32_t(word_end_offset), csum_end);
+  resp_out->result_length =
+    ( (!req_in_valid || summed_end < csum_start) ? 0 :
+      summed_end - csum_start );
+
+  /* Add the seed and fold the result into 16 bits. */
+  uint32_t result = ( sum + (req_in->seed & 0xffff) +
+                      (req_in->seed >> 16) );
+  result = (result & 0xffff) + (result >> 16);
+  result = (result & 0xffff) + (result >> 16);
+  resp_out->result_sum = result;
+}
+
+void nanotube_tap_packet_csum_core(
+  /* Constant parameters */
+  uint16_t packet_buffer_length,
+
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const uint8_t *packet_buffer_in,
+  bool packet_word_eop,
+  uint16_t packet_word_length,
+  const struct nanotube_tap_packet_csum_req *req_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  tap_packet_csum_core_impl(
+    packet_buffer_length, resp_out, state_inout, packet_buffer_in,
+    packet_word_eop, packet_word_length, req_in);
+}
+
+#ifndef NANOTUBE_TAPS_HLS
+template<uint16_t PACKET_BUFFER_LENGTH>
+void nanotube_taps::tap_packet_csum_core(
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const uint8_t *packet_buffer_in,
+  bool packet_word_eop,
+  uint16_t packet_word_length,
+  const struct nanotube_tap_packet_csum_req *req_in)
+{
+  tap_packet_csum_core_impl(
+    PACKET_BUFFER_LENGTH, resp_out, state_inout, packet_buffer_in,
+    packet_word_eop, packet_word_length, req_in);
+}
+#endif
+
 ///////////////////////////////////////////////////////////////////////////
 
 // The packet resize tap is used to insert bytes into and remove bytes
@@ -1733,3 +2281,32 @@ void nanotube_tap_packet_resize_egress_core(
 }
 
 ///////////////////////////////////////////////////////////////////////////
+
+// Instantiate the templated cores for the bus widths supported by the
+// bus wrappers.  The HLS build uses the inline versions in the header.
+
+#ifndef NANOTUBE_TAPS_HLS
+#define instantiate_tap_cores(width, log_width)                          \
+  template void nanotube_taps::tap_packet_read_core<width, log_width>(  \
+    uint16_t, uint8_t, struct nanotube_tap_packet_read_resp *,          \
+    uint8_t *, struct nanotube_tap_packet_read_state *,                 \
+    const uint8_t *, bool, uint16_t,                                    \
+    const struct nanotube_tap_packet_read_req *);                       \
+  template void nanotube_taps::tap_packet_write_core<width, log_width>( \
+    uint16_t, uint8_t, uint8_t *,                                       \
+    struct nanotube_tap_packet_write_state *,                           \
+    const uint8_t *, bool, uint16_t,                                    \
+    const struct nanotube_tap_packet_write_req *,                       \
+    const uint8_t *, const uint8_t *);                                  \
+  template void nanotube_taps::tap_packet_csum_core<width>(             \
+    struct nanotube_tap_packet_csum_resp *,                             \
+    struct nanotube_tap_packet_csum_state *,                            \
+    const uint8_t *, bool, uint16_t,                                    \
+    const struct nanotube_tap_packet_csum_req *);
+
+instantiate_tap_cores(32, 5)
+instantiate_tap_cores(64, 6)
+instantiate_tap_cores(128, 7)
+#endif
+
+///////////////////////////////////////////////////////////////////////////
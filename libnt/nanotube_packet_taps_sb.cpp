@@ -18,9 +18,16 @@
 #include <cstring>
 
 ///////////////////////////////////////////////////////////////////////////
+
+/* The simple bus wrappers are templated on the log2 of the number of
+ * data bytes in a bus word.  The extern functions at the end of the
+ * file instantiate them for the supported bus widths. */
+namespace sb_taps {
+
 //Simple bus wrapper for nanotube_tap_packet_length_core()
 
-void nanotube_tap_packet_length_sb(
+template<int LOG_DATA_BYTES>
+static void tap_packet_length(
   /* Outputs. */
   struct nanotube_tap_packet_length_resp *resp_out,
 
@@ -34,12 +41,12 @@ void nanotube_tap_packet_length_sb(
   __attribute__((always_inline))
 #endif
 {
-  check_type(nanotube_tap_packet_length, _sb);
-
-  const auto* sbw_in = (simple_bus::word*)packet_word_in;
+  typedef simple_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef simple_bus::basic_word<LOG_DATA_BYTES> word_t;
+  const auto* sbw_in = (const word_t*)packet_word_in;
   bool packet_word_eop = sbw_in->get_eop();
   uint16_t packet_word_length =
-    ( simple_bus::data_bytes -
+    ( traits::data_bytes -
       (packet_word_eop ? sbw_in->get_empty() : 0) );
 
   nanotube_tap_packet_length_core(
@@ -50,9 +57,10 @@ void nanotube_tap_packet_length_sb(
 
 ///////////////////////////////////////////////////////////////////////////
 
-//Simple bus wrapper for nanotube_tap_packet_read_core()
+//Simple bus wrapper for nanotube_taps::tap_packet_read_core()
 
-void nanotube_tap_packet_read_sb(
+template<int LOG_DATA_BYTES>
+static void tap_packet_read(
   /* Constant parameters */
   uint16_t result_buffer_length,
   uint8_t result_buffer_index_bits,
@@ -71,21 +79,18 @@ void nanotube_tap_packet_read_sb(
   __attribute__((always_inline))
 #endif
 {
-  check_type(nanotube_tap_packet_read, _sb);
-
-  const uint8_t word_index_bits = 6;
-  static_assert(sizeof(simple_bus::data_bytes) <= (1U<<word_index_bits),
-                "Word index width is too small.");
-  const auto* sbw_in = (const simple_bus::word*)packet_word_in;
+  typedef simple_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef simple_bus::basic_word<LOG_DATA_BYTES> word_t;
+  const uint8_t word_index_bits = traits::log_data_bytes;
+  const auto* sbw_in = (const word_t*)packet_word_in;
 
   bool packet_word_eop = sbw_in->get_eop();
   uint16_t packet_word_length =
-    ( simple_bus::data_bytes -
+    ( traits::data_bytes -
       (packet_word_eop ? sbw_in->get_empty() : 0) );
 
-  nanotube_tap_packet_read_core(
+  nanotube_taps::tap_packet_read_core<traits::data_bytes, word_index_bits>(
     result_buffer_length, result_buffer_index_bits,
-    simple_bus::data_bytes, word_index_bits,
     resp_out, result_buffer_inout,
     state_inout,
     sbw_in->data_ptr(0), packet_word_eop, packet_word_length, req_in);
@@ -93,9 +98,10 @@ void nanotube_tap_packet_read_sb(
 
 ///////////////////////////////////////////////////////////////////////////
 
-//Simple bus wrapper for nanotube_tap_packet_write_core()
+//Simple bus wrapper for nanotube_taps::tap_packet_write_core()
 
-void nanotube_tap_packet_write_sb(
+template<int LOG_DATA_BYTES>
+static void tap_packet_write(
   /* Constant parameters */
   uint16_t request_buffer_length,
   uint8_t request_buffer_index_bits,
@@ -115,37 +121,34 @@ void nanotube_tap_packet_write_sb(
   __attribute__((always_inline))
 #endif
 {
-  check_type(nanotube_tap_packet_write, _sb);
-
-  const uint8_t word_index_bits = 6;
-  static_assert(sizeof(simple_bus::data_bytes) <= (1U<<word_index_bits),
-                "Word index width is too small.");
+  typedef simple_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef simple_bus::basic_word<LOG_DATA_BYTES> word_t;
+  const uint8_t word_index_bits = traits::log_data_bytes;
 
-  const auto *sbw_in = (const simple_bus::word*)packet_word_in;
-  auto *sbw_out      = (simple_bus::word*)packet_word_out;
+  const auto *sbw_in = (const word_t*)packet_word_in;
+  auto *sbw_out      = (word_t*)packet_word_out;
 
   bool packet_word_eop = sbw_in->get_eop();
   uint16_t packet_word_length =
-    ( simple_bus::data_bytes -
+    ( traits::data_bytes -
       (packet_word_eop ? sbw_in->get_empty() : 0) );
 
   // Copy the control value.
-  sbw_out->control() = sbw_in->control();
+  sbw_out->set_control_raw(sbw_in->get_control());
 
   /* Propagate any additional sideband bytes/signals */
-  if( simple_bus::total_bytes > simple_bus::data_bytes + 1 /*control byte*/ ) {
-    memcpy(sbw_out->data_ptr(simple_bus::data_bytes),
-           sbw_in->data_ptr(simple_bus::data_bytes),
-           simple_bus::total_bytes - simple_bus::data_bytes - 1);
+  const int control_end = traits::data_bytes + traits::control_bytes;
+  if( traits::total_bytes > control_end ) {
+    memcpy(sbw_out->data_ptr(control_end),
+           sbw_in->data_ptr(control_end),
+           traits::total_bytes - control_end);
   }
 
   // Invoke the core of the tap.
-  nanotube_tap_packet_write_core(
+  nanotube_taps::tap_packet_write_core<traits::data_bytes, word_index_bits>(
     /* Constant parameters */
     request_buffer_length,
     request_buffer_index_bits,
-    simple_bus::data_bytes,
-    word_index_bits,
 
     /* Outputs. */
     sbw_out->data_ptr(),
@@ -164,9 +167,43 @@ void nanotube_tap_packet_write_sb(
 
 ///////////////////////////////////////////////////////////////////////////
 
+//Simple bus wrapper for nanotube_taps::tap_packet_csum_core()
+
+template<int LOG_DATA_BYTES>
+static void tap_packet_csum(
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_csum_req *req_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  typedef simple_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef simple_bus::basic_word<LOG_DATA_BYTES> word_t;
+  const auto* sbw_in = (const word_t*)packet_word_in;
+
+  bool packet_word_eop = sbw_in->get_eop();
+  uint16_t packet_word_length =
+    ( traits::data_bytes -
+      (packet_word_eop ? sbw_in->get_empty() : 0) );
+
+  nanotube_taps::tap_packet_csum_core<traits::data_bytes>(
+    resp_out, state_inout,
+    sbw_in->data_ptr(0), packet_word_eop, packet_word_length, req_in);
+}
+
+///////////////////////////////////////////////////////////////////////////
+
 //Simple bus wrapper for nanotube_tap_packet_resize_ingress_core()
 
-void nanotube_tap_packet_resize_ingress_sb(
+template<int LOG_DATA_BYTES>
+static void tap_packet_resize_ingress(
   /* Outputs. */
   bool *packet_done_out,
   nanotube_tap_packet_resize_cword_t *cword_out,
@@ -182,17 +219,17 @@ void nanotube_tap_packet_resize_ingress_sb(
   __attribute__((always_inline))
 #endif
 {
-  check_type(nanotube_tap_packet_resize_ingress, _sb);
-
-  auto *sbw_in = (simple_bus::word*)packet_word_in;
+  typedef simple_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef simple_bus::basic_word<LOG_DATA_BYTES> word_t;
+  auto *sbw_in = (word_t*)packet_word_in;
 
   nanotube_tap_offset_t word_length_in =
-    ( simple_bus::data_bytes -
+    ( traits::data_bytes -
       (sbw_in->get_eop() ? sbw_in->get_empty() : 0) );
   bool eop_in = sbw_in->get_eop();
 
   nanotube_tap_packet_resize_ingress_core(
-    simple_bus::data_bytes,
+    traits::data_bytes,
     packet_done_out,
     cword_out,
     packet_length_out,
@@ -206,7 +243,8 @@ void nanotube_tap_packet_resize_ingress_sb(
 
 //Simple bus wrapper for nanotube_tap_packet_resize_egress_core()
 
-void nanotube_tap_packet_resize_egress_sb(
+template<int LOG_DATA_BYTES>
+static void tap_packet_resize_egress(
   /* Outputs. */
   bool *input_done_out,
   bool *packet_done_out,
@@ -225,10 +263,10 @@ void nanotube_tap_packet_resize_egress_sb(
   __attribute__((always_inline))
 #endif
 {
-  check_type(nanotube_tap_packet_resize_egress, _sb);
-
-  auto *sbw_in  = (simple_bus::word*)packet_word_in;
-  auto *sbw_out = (simple_bus::word*)packet_word_out;
+  typedef simple_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef simple_bus::basic_word<LOG_DATA_BYTES> word_t;
+  auto *sbw_in  = (word_t*)packet_word_in;
+  auto *sbw_out = (word_t*)packet_word_out;
 
   bool word_eop_out;
   nanotube_tap_offset_t word_length_out;
@@ -236,7 +274,7 @@ void nanotube_tap_packet_resize_egress_sb(
   bool input_eop = sbw_in->get_eop();
 
   nanotube_tap_packet_resize_egress_core(
-    simple_bus::data_bytes, simple_bus::log_data_bytes,
+    traits::data_bytes, traits::log_data_bytes,
     input_done_out,
     word_valid_out, &word_eop_out,
     &word_length_out, sbw_out->data_ptr(),
@@ -246,11 +284,11 @@ void nanotube_tap_packet_resize_egress_sb(
   *packet_done_out = input_eop & *input_done_out;
 
   bool err = sbw_in->get_err();
-  simple_bus::empty_t empty = simple_bus::data_bytes - word_length_out;
+  simple_bus::empty_t empty = traits::data_bytes - word_length_out;
   sbw_out->set_control(word_eop_out, err, empty);
 
   /* Set TLAST, TKEEP, TSTRB, if sideband signals present */
-  if( *word_valid_out && simple_bus::sideband_signals_bytes ) { 
+  if( *word_valid_out && traits::sideband_signals_bytes ) {
     sbw_out->set_tlast(word_eop_out);
     /* Assume first word_length_out bytes are valid and rest are not */
     sbw_out->set_tkeep(word_length_out);
@@ -260,6 +298,163 @@ void nanotube_tap_packet_resize_egress_sb(
 
 ///////////////////////////////////////////////////////////////////////////
 
+template<int LOG_DATA_BYTES>
+static bool tap_packet_is_eop(
+  const void *packet_word_in,
+  struct nanotube_tap_packet_eop_state *state_inout
+)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  typedef simple_bus::basic_word<LOG_DATA_BYTES> word_t;
+  auto* pw = (const word_t*)packet_word_in;
+  return pw->get_eop();
+}
+
+} // namespace sb_taps
+
+///////////////////////////////////////////////////////////////////////////
+
+/* The simple bus taps with the default width. */
+
+void nanotube_tap_packet_length_sb(
+  /* Outputs. */
+  struct nanotube_tap_packet_length_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_length_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_length_req *req_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_length, _sb);
+  sb_taps::tap_packet_length<simple_bus::log_data_bytes>(
+    resp_out, state_inout, packet_word_in, req_in);
+}
+
+void nanotube_tap_packet_read_sb(
+  /* Constant parameters */
+  uint16_t result_buffer_length,
+  uint8_t result_buffer_index_bits,
+
+  /* Outputs. */
+  struct nanotube_tap_packet_read_resp *resp_out,
+  uint8_t *result_buffer_inout,
+
+  /* State. */
+  struct nanotube_tap_packet_read_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_read_req *req_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_read, _sb);
+  sb_taps::tap_packet_read<simple_bus::log_data_bytes>(
+    result_buffer_length, result_buffer_index_bits, resp_out,
+    result_buffer_inout, state_inout, packet_word_in, req_in);
+}
+
+void nanotube_tap_packet_write_sb(
+  /* Constant parameters */
+  uint16_t request_buffer_length,
+  uint8_t request_buffer_index_bits,
+
+  /* Outputs. */
+  void *packet_word_out,
+
+  /* State. */
+  struct nanotube_tap_packet_write_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_write_req *req_in,
+  const uint8_t *request_bytes_in,
+  const uint8_t *request_mask_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_write, _sb);
+  sb_taps::tap_packet_write<simple_bus::log_data_bytes>(
+    request_buffer_length, request_buffer_index_bits, packet_word_out,
+    state_inout, packet_word_in, req_in, request_bytes_in,
+    request_mask_in);
+}
+
+void nanotube_tap_packet_csum_sb(
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_csum_req *req_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_csum, _sb);
+  sb_taps::tap_packet_csum<simple_bus::log_data_bytes>(
+    resp_out, state_inout, packet_word_in, req_in);
+}
+
+void nanotube_tap_packet_resize_ingress_sb(
+  /* Outputs. */
+  bool *packet_done_out,
+  nanotube_tap_packet_resize_cword_t *cword_out,
+  nanotube_tap_offset_t *packet_length_out,
+
+  /* State. */
+  nanotube_tap_packet_resize_ingress_state_t *state,
+
+  /* Inputs. */
+  nanotube_tap_packet_resize_req_t *resize_req_in,
+  void *packet_word_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_resize_ingress, _sb);
+  sb_taps::tap_packet_resize_ingress<simple_bus::log_data_bytes>(
+    packet_done_out, cword_out, packet_length_out, state,
+    resize_req_in, packet_word_in);
+}
+
+void nanotube_tap_packet_resize_egress_sb(
+  /* Outputs. */
+  bool *input_done_out,
+  bool *packet_done_out,
+  bool *word_valid_out,
+  void *packet_word_out,
+
+  /* State. */
+  nanotube_tap_packet_resize_egress_state_t *state,
+  void *state_packet_word,
+
+  /* Inputs. */
+  nanotube_tap_packet_resize_cword_t *cword,
+  void *packet_word_in,
+  nanotube_tap_offset_t new_packet_len)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_resize_egress, _sb);
+  sb_taps::tap_packet_resize_egress<simple_bus::log_data_bytes>(
+    input_done_out, packet_done_out, word_valid_out, packet_word_out,
+    state, state_packet_word, cword, packet_word_in, new_packet_len);
+}
+
 bool nanotube_tap_packet_is_eop_sb(
   const void *packet_word_in,
   struct nanotube_tap_packet_eop_state *state_inout
@@ -269,11 +464,16 @@ bool nanotube_tap_packet_is_eop_sb(
 #endif
 {
   check_type(nanotube_tap_packet_is_eop, _sb);
-
-  auto* pw = (simple_bus::word*)packet_word_in;
-  return pw->get_eop();
+  return sb_taps::tap_packet_is_eop<simple_bus::log_data_bytes>(
+    packet_word_in, state_inout);
 }
 
 ///////////////////////////////////////////////////////////////////////////
 
+/* The simple bus taps with other widths. */
+define_bus_width_taps(_sb, 32, 5, sb_taps)
+define_bus_width_taps(_sb, 128, 7, sb_taps)
+
+///////////////////////////////////////////////////////////////////////////
+
 /* vim: set ts=8 et sw=2 sts=2 tw=75: */
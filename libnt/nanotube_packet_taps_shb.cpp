@@ -18,9 +18,16 @@
 #include <cstring>
 
 ///////////////////////////////////////////////////////////////////////////
+
+/* The softhub bus wrappers are templated on the log2 of the number of
+ * data bytes in a bus word.  The extern functions at the end of the
+ * file instantiate them for the supported bus widths. */
+namespace shb_taps {
+
 //Simple bus wrapper for nanotube_tap_packet_length_core()
 
-void nanotube_tap_packet_length_shb(
+template<int LOG_DATA_BYTES>
+static void tap_packet_length(
   /* Outputs. */
   struct nanotube_tap_packet_length_resp *resp_out,
 
@@ -34,17 +41,17 @@ void nanotube_tap_packet_length_shb(
   __attribute__((always_inline))
 #endif
 {
-  check_type(nanotube_tap_packet_length, _shb);
-
-  const auto* shbw_in = (softhub_bus::word*)packet_word_in;
+  typedef softhub_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef softhub_bus::basic_word<LOG_DATA_BYTES> word_t;
+  const auto* shbw_in = (word_t*)packet_word_in;
 
   if( state_inout->packet_offset == 0 ) {
     state_inout->packet_length = shbw_in->get_ch_length();
   }
 
   uint16_t packet_remaining = state_inout->packet_length - state_inout->packet_offset;
-  bool packet_word_eop = packet_remaining <= softhub_bus::data_bytes;
-  uint16_t packet_word_length = (packet_word_eop ? packet_remaining : softhub_bus::data_bytes);
+  bool packet_word_eop = packet_remaining <= traits::data_bytes;
+  uint16_t packet_word_length = (packet_word_eop ? packet_remaining : traits::data_bytes);
 
   nanotube_tap_packet_length_core(
     resp_out,
@@ -54,9 +61,10 @@ void nanotube_tap_packet_length_shb(
 
 ///////////////////////////////////////////////////////////////////////////
 
-//Simple bus wrapper for nanotube_tap_packet_read_core()
+//Simple bus wrapper for nanotube_taps::tap_packet_read_core()
 
-void nanotube_tap_packet_read_shb(
+template<int LOG_DATA_BYTES>
+static void tap_packet_read(
   /* Constant parameters */
   uint16_t result_buffer_length,
   uint8_t result_buffer_index_bits,
@@ -75,24 +83,21 @@ void nanotube_tap_packet_read_shb(
   __attribute__((always_inline))
 #endif
 {
-  check_type(nanotube_tap_packet_read, _shb);
-
-  const uint8_t word_index_bits = 6;
-  static_assert(sizeof(softhub_bus::data_bytes) <= (1U<<word_index_bits),
-                "Word index width is too small.");
-  const auto* shbw_in = (const softhub_bus::word*)packet_word_in;
+  typedef softhub_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef softhub_bus::basic_word<LOG_DATA_BYTES> word_t;
+  const uint8_t word_index_bits = traits::log_data_bytes;
+  const auto* shbw_in = (const word_t*)packet_word_in;
   
   if( state_inout->packet_offset == 0 ) {
     state_inout->packet_length = shbw_in->get_ch_length();
   }
 
   uint16_t packet_remaining = state_inout->packet_length - state_inout->packet_offset;
-  bool packet_word_eop = packet_remaining <= softhub_bus::data_bytes;
-  uint16_t packet_word_length = (packet_word_eop ? packet_remaining : softhub_bus::data_bytes);
+  bool packet_word_eop = packet_remaining <= traits::data_bytes;
+  uint16_t packet_word_length = (packet_word_eop ? packet_remaining : traits::data_bytes);
 
-  nanotube_tap_packet_read_core(
+  nanotube_taps::tap_packet_read_core<traits::data_bytes, word_index_bits>(
     result_buffer_length, result_buffer_index_bits,
-    softhub_bus::data_bytes, word_index_bits,
     resp_out, result_buffer_inout,
     state_inout,
     shbw_in->data_ptr(0), packet_word_eop, packet_word_length, req_in);
@@ -100,9 +105,10 @@ void nanotube_tap_packet_read_shb(
 
 ///////////////////////////////////////////////////////////////////////////
 
-//Simple bus wrapper for nanotube_tap_packet_write_core()
+//Simple bus wrapper for nanotube_taps::tap_packet_write_core()
 
-void nanotube_tap_packet_write_shb(
+template<int LOG_DATA_BYTES>
+static void tap_packet_write(
   /* Constant parameters */
   uint16_t request_buffer_length,
   uint8_t request_buffer_index_bits,
@@ -122,37 +128,33 @@ void nanotube_tap_packet_write_shb(
   __attribute__((always_inline))
 #endif
 {
-  check_type(nanotube_tap_packet_write, _shb);
-
-  const uint8_t word_index_bits = 6;
-  static_assert(sizeof(softhub_bus::data_bytes) <= (1U<<word_index_bits),
-                "Word index width is too small.");
+  typedef softhub_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef softhub_bus::basic_word<LOG_DATA_BYTES> word_t;
+  const uint8_t word_index_bits = traits::log_data_bytes;
 
-  const auto *shbw_in = (const softhub_bus::word*)packet_word_in;
-  auto *shbw_out      = (softhub_bus::word*)packet_word_out;
+  const auto *shbw_in = (const word_t*)packet_word_in;
+  auto *shbw_out      = (word_t*)packet_word_out;
 
   if( state_inout->packet_offset == 0 ) {
     state_inout->packet_length = shbw_in->get_ch_length();
   }
 
   /* Propagate the sideband bytes */
-  if( softhub_bus::total_bytes > softhub_bus::data_bytes ) {
-    memcpy(shbw_out->data_ptr(softhub_bus::data_bytes),
-           shbw_in->data_ptr(softhub_bus::data_bytes),
-           softhub_bus::total_bytes - softhub_bus::data_bytes);
+  if( traits::total_bytes > traits::data_bytes ) {
+    memcpy(shbw_out->data_ptr(traits::data_bytes),
+           shbw_in->data_ptr(traits::data_bytes),
+           traits::total_bytes - traits::data_bytes);
   }
 
   uint16_t packet_remaining = state_inout->packet_length - state_inout->packet_offset;
-  bool packet_word_eop = packet_remaining <= softhub_bus::data_bytes;
-  uint16_t packet_word_length = (packet_word_eop ? packet_remaining : softhub_bus::data_bytes);
+  bool packet_word_eop = packet_remaining <= traits::data_bytes;
+  uint16_t packet_word_length = (packet_word_eop ? packet_remaining : traits::data_bytes);
 
   // Invoke the core of the tap.
-  nanotube_tap_packet_write_core(
+  nanotube_taps::tap_packet_write_core<traits::data_bytes, word_index_bits>(
     /* Constant parameters */
     request_buffer_length,
     request_buffer_index_bits,
-    softhub_bus::data_bytes,
-    word_index_bits,
 
     /* Outputs. */
     shbw_out->data_ptr(),
@@ -171,9 +173,46 @@ void nanotube_tap_packet_write_shb(
 
 ///////////////////////////////////////////////////////////////////////////
 
+//Simple bus wrapper for nanotube_taps::tap_packet_csum_core()
+
+template<int LOG_DATA_BYTES>
+static void tap_packet_csum(
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_csum_req *req_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  typedef softhub_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef softhub_bus::basic_word<LOG_DATA_BYTES> word_t;
+  const auto* shbw_in = (const word_t*)packet_word_in;
+
+  if( state_inout->packet_offset == 0 ) {
+    state_inout->packet_length = shbw_in->get_ch_length();
+  }
+
+  uint16_t packet_remaining = state_inout->packet_length - state_inout->packet_offset;
+  bool packet_word_eop = packet_remaining <= traits::data_bytes;
+  uint16_t packet_word_length = (packet_word_eop ? packet_remaining : traits::data_bytes);
+
+  nanotube_taps::tap_packet_csum_core<traits::data_bytes>(
+    resp_out, state_inout,
+    shbw_in->data_ptr(0), packet_word_eop, packet_word_length, req_in);
+}
+
+///////////////////////////////////////////////////////////////////////////
+
 //Simple bus wrapper for nanotube_tap_packet_resize_ingress_core()
 
-void nanotube_tap_packet_resize_ingress_shb(
+template<int LOG_DATA_BYTES>
+static void tap_packet_resize_ingress(
   /* Outputs. */
   bool *packet_done_out,
   nanotube_tap_packet_resize_cword_t *cword_out,
@@ -189,9 +228,9 @@ void nanotube_tap_packet_resize_ingress_shb(
   __attribute__((always_inline))
 #endif
 {
-  check_type(nanotube_tap_packet_resize_ingress, _shb);
-
-  auto *shbw_in = (softhub_bus::word*)packet_word_in;
+  typedef softhub_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef softhub_bus::basic_word<LOG_DATA_BYTES> word_t;
+  auto *shbw_in = (word_t*)packet_word_in;
 
   if( state->new_req ) {
     state->packet_length = shbw_in->get_ch_length();
@@ -205,11 +244,11 @@ void nanotube_tap_packet_resize_ingress_shb(
   *packet_length_out = state->packet_length - bytes_deleted + bytes_inserted;
 
   nanotube_tap_offset_t packet_remaining_in = state->packet_length - state->packet_offset;
-  bool eop_in = packet_remaining_in <= softhub_bus::data_bytes;
-  nanotube_tap_offset_t word_length_in = (eop_in ? packet_remaining_in : softhub_bus::data_bytes);
+  bool eop_in = packet_remaining_in <= traits::data_bytes;
+  nanotube_tap_offset_t word_length_in = (eop_in ? packet_remaining_in : traits::data_bytes);
 
   nanotube_tap_packet_resize_ingress_core(
-    softhub_bus::data_bytes,
+    traits::data_bytes,
     packet_done_out,
     cword_out,
     packet_length_out,
@@ -223,7 +262,8 @@ void nanotube_tap_packet_resize_ingress_shb(
 
 //Simple bus wrapper for nanotube_tap_packet_resize_egress_core()
 
-void nanotube_tap_packet_resize_egress_shb(
+template<int LOG_DATA_BYTES>
+static void tap_packet_resize_egress(
   /* Outputs. */
   bool *input_done_out,
   bool *packet_done_out,
@@ -242,10 +282,10 @@ void nanotube_tap_packet_resize_egress_shb(
   __attribute__((always_inline))
 #endif
 {
-  check_type(nanotube_tap_packet_resize_egress, _shb);
-
-  auto *shbw_in  = (softhub_bus::word*)packet_word_in;
-  auto *shbw_out = (softhub_bus::word*)packet_word_out;
+  typedef softhub_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef softhub_bus::basic_word<LOG_DATA_BYTES> word_t;
+  auto *shbw_in  = (word_t*)packet_word_in;
+  auto *shbw_out = (word_t*)packet_word_out;
 
   bool word_eop_out;
   nanotube_tap_offset_t word_length_out;
@@ -256,10 +296,10 @@ void nanotube_tap_packet_resize_egress_shb(
     /* update the header to have the new length */
     shbw_in->set_ch_length(new_packet_len);
   }
-  bool input_eop = (state->packet_length - state->packet_offset) < softhub_bus::data_bytes;
+  bool input_eop = (state->packet_length - state->packet_offset) < traits::data_bytes;
 
   nanotube_tap_packet_resize_egress_core(
-    softhub_bus::data_bytes, softhub_bus::log_data_bytes,
+    traits::data_bytes, traits::log_data_bytes,
     input_done_out,
     word_valid_out, &word_eop_out,
     &word_length_out, shbw_out->data_ptr(),
@@ -277,11 +317,11 @@ void nanotube_tap_packet_resize_egress_shb(
   else {
     state->new_pkt = false;
     if( *input_done_out ) {
-      state->packet_offset += softhub_bus::data_bytes;
+      state->packet_offset += traits::data_bytes;
     }
   }
   /* Set TLAST, TKEEP, TSTRB, if sideband signals present */
-  if( *word_valid_out && softhub_bus::sideband_signals_bytes ) {
+  if( *word_valid_out && traits::sideband_signals_bytes ) {
     shbw_out->set_tlast(word_eop_out);
     /* Assume first word_length_out bytes are valid and rest are not */
     shbw_out->set_tkeep(word_length_out);
@@ -291,7 +331,9 @@ void nanotube_tap_packet_resize_egress_shb(
 
 ///////////////////////////////////////////////////////////////////////////
 
-bool nanotube_tap_packet_is_eop_shb(
+
+template<int LOG_DATA_BYTES>
+static bool tap_packet_is_eop(
   const void *packet_word_in,
   struct nanotube_tap_packet_eop_state *state_inout
 )
@@ -299,24 +341,188 @@ bool nanotube_tap_packet_is_eop_shb(
   __attribute__((always_inline))
 #endif
 {
-  check_type(nanotube_tap_packet_is_eop, _shb);
-  auto *shbw_in  = (softhub_bus::word*)packet_word_in;
+  typedef softhub_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef softhub_bus::basic_word<LOG_DATA_BYTES> word_t;
+  auto *shbw_in  = (word_t*)packet_word_in;
 
   if( state_inout->packet_offset == 0) {
     //new packet
     state_inout->packet_length = shbw_in->get_ch_length();
   }
   uint16_t packet_remaining = state_inout->packet_length - state_inout->packet_offset;
-  bool packet_word_eop = packet_remaining <= softhub_bus::data_bytes;
+  bool packet_word_eop = packet_remaining <= traits::data_bytes;
 
   if( packet_word_eop )
     state_inout->packet_offset = 0;
   else 
-    state_inout->packet_offset += softhub_bus::data_bytes;
+    state_inout->packet_offset += traits::data_bytes;
   
   return packet_word_eop;
 }
 
 ///////////////////////////////////////////////////////////////////////////
 
+} // namespace shb_taps
+
+///////////////////////////////////////////////////////////////////////////
+
+/* The softhub bus taps with the default width. */
+
+void nanotube_tap_packet_length_shb(
+  /* Outputs. */
+  struct nanotube_tap_packet_length_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_length_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_length_req *req_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_length, _shb);
+  shb_taps::tap_packet_length<softhub_bus::log_data_bytes>(
+    resp_out, state_inout, packet_word_in, req_in);
+}
+
+void nanotube_tap_packet_read_shb(
+  /* Constant parameters */
+  uint16_t result_buffer_length,
+  uint8_t result_buffer_index_bits,
+
+  /* Outputs. */
+  struct nanotube_tap_packet_read_resp *resp_out,
+  uint8_t *result_buffer_inout,
+
+  /* State. */
+  struct nanotube_tap_packet_read_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_read_req *req_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_read, _shb);
+  shb_taps::tap_packet_read<softhub_bus::log_data_bytes>(
+    result_buffer_length, result_buffer_index_bits, resp_out,
+    result_buffer_inout, state_inout, packet_word_in, req_in);
+}
+
+void nanotube_tap_packet_write_shb(
+  /* Constant parameters */
+  uint16_t request_buffer_length,
+  uint8_t request_buffer_index_bits,
+
+  /* Outputs. */
+  void *packet_word_out,
+
+  /* State. */
+  struct nanotube_tap_packet_write_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_write_req *req_in,
+  const uint8_t *request_bytes_in,
+  const uint8_t *request_mask_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_write, _shb);
+  shb_taps::tap_packet_write<softhub_bus::log_data_bytes>(
+    request_buffer_length, request_buffer_index_bits, packet_word_out,
+    state_inout, packet_word_in, req_in, request_bytes_in, request_mask_in);
+}
+
+void nanotube_tap_packet_csum_shb(
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_csum_req *req_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_csum, _shb);
+  shb_taps::tap_packet_csum<softhub_bus::log_data_bytes>(
+    resp_out, state_inout, packet_word_in, req_in);
+}
+
+void nanotube_tap_packet_resize_ingress_shb(
+  /* Outputs. */
+  bool *packet_done_out,
+  nanotube_tap_packet_resize_cword_t *cword_out,
+  nanotube_tap_offset_t *packet_length_out,
+
+  /* State. */
+  nanotube_tap_packet_resize_ingress_state_t *state,
+
+  /* Inputs. */
+  nanotube_tap_packet_resize_req_t *resize_req_in,
+  void *packet_word_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_resize_ingress, _shb);
+  shb_taps::tap_packet_resize_ingress<softhub_bus::log_data_bytes>(
+    packet_done_out, cword_out, packet_length_out, state, resize_req_in,
+    packet_word_in);
+}
+
+void nanotube_tap_packet_resize_egress_shb(
+  /* Outputs. */
+  bool *input_done_out,
+  bool *packet_done_out,
+  bool *word_valid_out,
+  void *packet_word_out,
+
+  /* State. */
+  nanotube_tap_packet_resize_egress_state_t *state,
+  void *state_packet_word,
+
+  /* Inputs. */
+  nanotube_tap_packet_resize_cword_t *cword,
+  void *packet_word_in,
+  nanotube_tap_offset_t new_packet_len)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_resize_egress, _shb);
+  shb_taps::tap_packet_resize_egress<softhub_bus::log_data_bytes>(
+    input_done_out, packet_done_out, word_valid_out, packet_word_out,
+    state, state_packet_word, cword, packet_word_in, new_packet_len);
+}
+
+bool nanotube_tap_packet_is_eop_shb(
+  const void *packet_word_in,
+  struct nanotube_tap_packet_eop_state *state_inout
+)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_is_eop, _shb);
+  return shb_taps::tap_packet_is_eop<softhub_bus::log_data_bytes>(
+    packet_word_in, state_inout);
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+/* The softhub bus taps with other widths. */
+define_bus_width_taps(_shb, 32, 5, shb_taps)
+define_bus_width_taps(_shb, 128, 7, shb_taps)
+
+///////////////////////////////////////////////////////////////////////////
+
 /* vim: set ts=8 et sw=2 sts=2 tw=75: */
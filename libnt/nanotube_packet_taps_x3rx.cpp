@@ -199,6 +199,39 @@ void nanotube_tap_packet_write_x3rx(
 
 ///////////////////////////////////////////////////////////////////////////
 
+// X3RX bus wrapper for nanotube_tap_packet_csum_core()
+
+void nanotube_tap_packet_csum_x3rx(
+  /* Outputs. */
+  struct nanotube_tap_packet_csum_resp *resp_out,
+
+  /* State. */
+  struct nanotube_tap_packet_csum_state *state_inout,
+
+  /* Inputs. */
+  const void *packet_word_in,
+  const struct nanotube_tap_packet_csum_req *req_in)
+#if __clang__
+  __attribute__((always_inline))
+#endif
+{
+  check_type(nanotube_tap_packet_csum, _x3rx);
+
+  const auto* x3rxw_in = (const x3rx_bus::word*)packet_word_in;
+  uint16_t packet_word_length;
+  /* meta EOP comes after data EOP so use that to track when there are no
+   * more words for this packet */
+  bool packet_word_eop = x3rxw_in->get_meta_eop();
+
+  packet_word_length = x3rx_valid_data_bytes(x3rxw_in, &state_inout->data_eop_seen);
+
+  nanotube_tap_packet_csum_core(
+    x3rx_bus::data_bytes, resp_out, state_inout,
+    x3rxw_in->data_ptr(0), packet_word_eop, packet_word_length, req_in);
+}
+
+///////////////////////////////////////////////////////////////////////////
+
 // X3RX bus wrapper for nanotube_tap_packet_resize_ingress_core()
 
 void nanotube_tap_packet_resize_ingress_x3rx(
@@ -0,0 +1,62 @@
+/**************************************************************************\
+*//*! \file nanotube_profile.cpp
+**  \brief  Nanotube profiling functions.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+#include "nanotube_api.h"
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+///////////////////////////////////////////////////////////////////////////
+
+// The counts are keyed by the address of the function name so that
+// counting a block does not need to compare strings.  The names are
+// only compared when writing the profile.
+typedef std::tuple<const char *, uint32_t, uint32_t> profile_key_t;
+
+static std::mutex s_profile_mutex;
+static std::map<profile_key_t, uint64_t> s_profile_counts;
+
+void nanotube_profile_block(const char *func, uint32_t block,
+                            uint32_t succ)
+{
+  std::lock_guard<std::mutex> guard(s_profile_mutex);
+  s_profile_counts[profile_key_t(func, block, succ)]++;
+}
+
+int nanotube_profile_write(const char *filename)
+{
+  typedef std::tuple<std::string, uint32_t, uint32_t> named_key_t;
+  std::map<named_key_t, uint64_t> counts;
+  {
+    std::lock_guard<std::mutex> guard(s_profile_mutex);
+    for (auto &entry: s_profile_counts) {
+      named_key_t key(std::get<0>(entry.first), std::get<1>(entry.first),
+                      std::get<2>(entry.first));
+      counts[key] += entry.second;
+    }
+  }
+
+  std::ofstream out(filename);
+  out << "# Nanotube profile: <function> <block> <successor> <count>\n";
+  for (auto &entry: counts) {
+    out << std::get<0>(entry.first) << ' '
+        << std::get<1>(entry.first) << ' '
+        << std::get<2>(entry.first) << ' '
+        << entry.second << '\n';
+  }
+  out.close();
+  return (out.fail() ? -1 : 0);
+}
+
+///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,296 @@
+/**************************************************************************\
+*//*! \file nanotube_sim.cpp
+**  \brief  A cycle-approximate timing model of a processing system.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+#include "nanotube_sim.hpp"
+
+#include "nanotube_channel.hpp"
+#include "nanotube_thread.hpp"
+#include "processing_system.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <limits>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+///////////////////////////////////////////////////////////////////////////
+
+nanotube_sim_stage::nanotube_sim_stage(const std::string &name,
+                                       unsigned ii, unsigned latency):
+  m_name(name),
+  m_ii(std::max(1u, ii)),
+  m_latency(latency),
+  m_time(0),
+  m_active(false),
+  m_firings(0),
+  m_stall_cycles(0)
+{
+}
+
+uint64_t nanotube_sim_stage::read_elem(uint64_t ready)
+{
+  // The firing cannot issue before the element arrives.
+  delay_until(ready);
+  m_active = true;
+  return m_time;
+}
+
+uint64_t nanotube_sim_stage::write_elem(uint64_t freed, uint64_t *stall)
+{
+  // The element leaves the stage after the latency of the stage.  If
+  // the channel is full at that point, the stage stalls until the
+  // slot is freed.
+  uint64_t out = m_time + m_latency;
+  if (freed > out) {
+    m_stall_cycles += freed - out;
+    *stall += freed - out;
+    m_time += freed - out;
+    out = freed;
+  }
+  m_active = true;
+  return out;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+nanotube_sim::config_t::config_t():
+  ii(1),
+  latency(1),
+  map_latency(2),
+  fifo_latency(1),
+  fifo_depth(0),
+  packet_gap(0)
+{
+}
+
+nanotube_sim::nanotube_sim(const config_t &config):
+  m_config(config),
+  m_ingress("ingress", 1, 0),
+  m_egress("egress", 1, 0),
+  m_packet_pending(false),
+  m_any_start(false),
+  m_last_start(0),
+  m_last_egress(0),
+  m_packets_in(0),
+  m_packets_out(0),
+  m_packets_dropped(0),
+  m_words_in(0),
+  m_words_out(0),
+  m_first_in(0),
+  m_last_out(0),
+  m_latency_min(std::numeric_limits<uint64_t>::max()),
+  m_latency_max(0),
+  m_latency_sum(0),
+  m_latency_count(0)
+{
+}
+
+size_t nanotube_sim::get_fifo_depth(const std::string &name,
+                                    size_t num_elem) const
+{
+  auto it = m_config.fifo_depths.find(name);
+  if (it != m_config.fifo_depths.end())
+    return it->second;
+  if (m_config.fifo_depth != 0)
+    return m_config.fifo_depth;
+  return num_elem;
+}
+
+void nanotube_sim::bind_threads(
+  const std::vector<std::unique_ptr<nanotube_thread> > &threads)
+{
+  namespace pt = boost::property_tree;
+
+  // Read the costs of the stages from the performance report.  The
+  // stages are listed in thread creation order.  Only use an entry if
+  // the thread name matches in case the report is out of date.
+  std::vector<pt::ptree> report_stages;
+  if (!m_config.perf_report.empty()) {
+    pt::ptree report;
+    pt::read_json(m_config.perf_report, report);
+    for (auto &entry: report.get_child("stages"))
+      report_stages.push_back(entry.second);
+  }
+
+  for (size_t index = 0; index < threads.size(); index++) {
+    nanotube_thread *thread = threads[index].get();
+    std::string name = thread->get_name();
+    unsigned ii = m_config.ii;
+    unsigned latency = m_config.latency;
+
+    if (index < report_stages.size() &&
+        report_stages[index].get<std::string>("name", "") == name) {
+      ii = report_stages[index].get<unsigned>("ii", ii);
+      latency = report_stages[index].get<unsigned>("latency_cycles",
+                                                   latency);
+    }
+
+    // Map taps serve one request per cycle.
+    if (name == "map_tap") {
+      ii = 1;
+      latency = m_config.map_latency;
+    }
+
+    auto it = m_config.stage_costs.find(name);
+    if (it != m_config.stage_costs.end()) {
+      ii = it->second.first;
+      latency = it->second.second;
+    }
+
+    std::unique_ptr<nanotube_sim_stage>
+      stage(new nanotube_sim_stage(name, ii, latency));
+    thread->set_sim_stage(stage.get());
+    m_stages.push_back(std::move(stage));
+  }
+}
+
+uint64_t nanotube_sim::write_elem(nanotube_sim_stage *stage,
+                                  uint64_t freed, uint64_t *stall)
+{
+  if (stage != nullptr)
+    return stage->write_elem(freed, stall) + m_config.fifo_latency;
+
+  // The ingress port writes one word per cycle.
+  uint64_t out = m_ingress.write_elem(freed, stall);
+  m_ingress.end_invocation();
+  m_words_in++;
+  if (m_packet_pending) {
+    m_packet_pending = false;
+    if (m_packets_in == 0)
+      m_first_in = out;
+    m_packets_in++;
+    m_last_start = out;
+    m_in_flight.push_back(out);
+  }
+  return out + m_config.fifo_latency;
+}
+
+uint64_t nanotube_sim::read_elem(nanotube_sim_stage *stage,
+                                 uint64_t ready)
+{
+  if (stage != nullptr)
+    return stage->read_elem(ready);
+
+  // The egress port reads one word per cycle.
+  uint64_t freed = m_egress.read_elem(ready);
+  m_egress.end_invocation();
+  m_words_out++;
+  m_last_egress = freed;
+  return freed;
+}
+
+void nanotube_sim::packet_start()
+{
+  // Apply the minimum gap between packets.
+  if (m_any_start)
+    m_ingress.delay_until(m_last_start + m_config.packet_gap);
+  m_any_start = true;
+  m_packet_pending = true;
+}
+
+void nanotube_sim::packet_end()
+{
+  // The packet left after its last word.  Pair it with the oldest
+  // packet in flight.
+  m_packets_out++;
+  m_last_out = m_last_egress;
+  if (m_in_flight.empty())
+    return;
+
+  uint64_t start = m_in_flight.front();
+  m_in_flight.pop_front();
+  uint64_t latency = m_last_egress - start;
+  m_latency_min = std::min(m_latency_min, latency);
+  m_latency_max = std::max(m_latency_max, latency);
+  m_latency_sum += latency;
+  m_latency_count++;
+}
+
+void nanotube_sim::flush()
+{
+  // Packets which are still in flight when the processing system is
+  // idle were dropped by the pipeline.
+  m_packets_dropped += m_in_flight.size();
+  m_in_flight.clear();
+}
+
+void nanotube_sim::write_report(std::ostream &os, processing_system &system)
+{
+  uint64_t count = m_latency_count;
+  uint64_t cycles = (m_last_out > m_first_in ? m_last_out - m_first_in : 0);
+
+  auto flags = os.flags();
+  os << std::fixed << std::setprecision(3);
+  os << "{\n"
+     << "  \"packets_in\": " << m_packets_in << ",\n"
+     << "  \"packets_out\": " << m_packets_out << ",\n"
+     << "  \"packets_dropped\": " << m_packets_dropped << ",\n"
+     << "  \"words_in\": " << m_words_in << ",\n"
+     << "  \"words_out\": " << m_words_out << ",\n"
+     << "  \"first_in_cycle\": " << m_first_in << ",\n"
+     << "  \"last_out_cycle\": " << m_last_out << ",\n"
+     << "  \"latency_min\": "
+     << (count != 0 ? m_latency_min : 0) << ",\n"
+     << "  \"latency_avg\": "
+     << (count != 0 ? double(m_latency_sum) / count : 0.0) << ",\n"
+     << "  \"latency_max\": " << m_latency_max << ",\n"
+     << "  \"cycles_per_packet\": "
+     << (m_packets_out != 0 ? double(cycles) / m_packets_out : 0.0)
+     << ",\n"
+     << "  \"packets_per_cycle\": "
+     << (cycles != 0 ? double(m_packets_out) / cycles : 0.0) << ",\n"
+     << "  \"stages\": [\n";
+
+  for (size_t i = 0; i < m_stages.size(); i++) {
+    const nanotube_sim_stage &stage = *(m_stages[i]);
+    uint64_t busy = stage.get_firings() * stage.get_ii();
+    if (i != 0)
+      os << ",\n";
+    os << "    {\n"
+       << "      \"name\": \"" << stage.get_name() << "\",\n"
+       << "      \"ii\": " << stage.get_ii() << ",\n"
+       << "      \"latency\": " << stage.get_latency() << ",\n"
+       << "      \"firings\": " << stage.get_firings() << ",\n"
+       << "      \"stall_cycles\": " << stage.get_stall_cycles() << ",\n"
+       << "      \"utilization\": "
+       << (cycles != 0 ? std::min(1.0, double(busy) / cycles) : 0.0)
+       << "\n"
+       << "    }";
+  }
+  if (!m_stages.empty())
+    os << "\n";
+  os << "  ],\n"
+     << "  \"channels\": [\n";
+
+  bool first = true;
+  for (auto &entry: system.channels()) {
+    const nanotube_channel &channel = *(entry.second);
+    if (!first)
+      os << ",\n";
+    first = false;
+    os << "    {\n"
+       << "      \"name\": \"" << channel.get_name() << "\",\n"
+       << "      \"depth\": " << channel.get_num_elem() << ",\n"
+       << "      \"elements\": " << channel.get_sim_elems() << ",\n"
+       << "      \"full_cycles\": " << channel.get_sim_full_cycles()
+       << "\n"
+       << "    }";
+  }
+  if (!first)
+    os << "\n";
+  os << "  ]\n"
+     << "}\n";
+  os.flags(flags);
+}
+
+///////////////////////////////////////////////////////////////////////////
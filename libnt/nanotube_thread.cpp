@@ -14,6 +14,7 @@
 #include "nanotube_thread.hpp"
 
 #include "nanotube_context.hpp"
+#include "nanotube_sim.hpp"
 #include "processing_system.hpp"
 
 #include <atomic>
@@ -103,7 +104,8 @@ nanotube_thread::nanotube_thread(nanotube_context_t* context):
   m_thread_id(pthread_self()),
   m_current_time_valid(false),
   m_wake_time_valid(false),
-  m_idle_waiter(nullptr)
+  m_idle_waiter(nullptr),
+  m_sim_stage(nullptr)
 {
   assert(s_current_thread == nullptr);
   s_current_thread = this;
@@ -125,7 +127,8 @@ nanotube_thread::nanotube_thread(nanotube_context_t* context,
   m_wake_state(WAKE_STATE_RUNNING),
   m_current_time_valid(false),
   m_wake_time_valid(false),
-  m_idle_waiter(nullptr)
+  m_idle_waiter(nullptr),
+  m_sim_stage(nullptr)
 {
   init();
 }
@@ -181,6 +184,11 @@ bool nanotube_thread::is_current()
   return this == s_current_thread;
 }
 
+nanotube_thread *nanotube_thread::get_current()
+{
+  return s_current_thread;
+}
+
 bool nanotube_thread::is_stopped()
 {
   auto state = m_thread_state.load();
@@ -244,9 +252,14 @@ void *nanotube_thread::enter_thread(void *arg)
   // Set the thread ID.
   s_current_thread = thread;
 
-  // Call the thread function repeately.
-  while (true)
+  // Call the thread function repeately.  Each call is a potential
+  // firing of the stage when the processing system is being
+  // simulated.
+  while (true) {
     thread->m_func(thread->m_context, &thread->m_user_data[0]);
+    if (thread->m_sim_stage != nullptr)
+      thread->m_sim_stage->end_invocation();
+  }
 }
 
 void nanotube_thread::start()
@@ -53,4 +53,36 @@ nanotube_merge_data_mask(uint8_t* inout_data, uint8_t* inout_mask,
   }
 }
 
+#ifdef __clang__
+__attribute__((always_inline))
+#endif
+uint16_t nanotube_csum_fold(uint32_t sum) {
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+  return (uint16_t)sum;
+}
+
+#ifdef __clang__
+__attribute__((always_inline))
+#endif
+uint16_t nanotube_csum_replace2(uint16_t csum, uint16_t old_val,
+                                uint16_t new_val) {
+  /* HC' = ~(~HC + ~m + m') */
+  uint32_t sum = ( uint32_t(uint16_t(~csum)) +
+                   uint32_t(uint16_t(~old_val)) + new_val );
+  return uint16_t(~nanotube_csum_fold(sum));
+}
+
+#ifdef __clang__
+__attribute__((always_inline))
+#endif
+uint16_t nanotube_csum_replace4(uint16_t csum, uint32_t old_val,
+                                uint32_t new_val) {
+  uint32_t sum = ( uint32_t(uint16_t(~csum)) +
+                   uint32_t(uint16_t(~(old_val >> 16))) +
+                   uint32_t(uint16_t(~old_val)) +
+                   (new_val >> 16) + (new_val & 0xffff) );
+  return uint16_t(~nanotube_csum_fold(sum));
+}
+
 /* vim: set ts=8 et sw=2 sts=2 tw=75: */
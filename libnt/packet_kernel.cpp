@@ -121,15 +121,17 @@ channel_packet_kernel::channel_packet_kernel(
   case NANOTUBE_CHANNEL_TYPE_SIMPLE_PACKET:
     assert(packet_read_channel.get_read_export_type() ==
            NANOTUBE_CHANNEL_TYPE_SIMPLE_PACKET);
-    assert(packet_write_channel.get_elem_size() == simple_bus::total_bytes);
-    assert(packet_read_channel.get_elem_size() == simple_bus::total_bytes);
+    assert(simple_bus::is_word_size(packet_write_channel.get_elem_size()));
+    assert(packet_read_channel.get_elem_size() ==
+           packet_write_channel.get_elem_size());
     m_bus_type = NANOTUBE_BUS_ID_SB;
     break;
   case NANOTUBE_CHANNEL_TYPE_SOFTHUB_PACKET:
     assert(packet_read_channel.get_read_export_type() ==
            NANOTUBE_CHANNEL_TYPE_SOFTHUB_PACKET);
-    assert(packet_write_channel.get_elem_size() == softhub_bus::total_bytes);
-    assert(packet_read_channel.get_elem_size() == softhub_bus::total_bytes);
+    assert(softhub_bus::is_word_size(packet_write_channel.get_elem_size()));
+    assert(packet_read_channel.get_elem_size() ==
+           packet_write_channel.get_elem_size());
     m_bus_type = NANOTUBE_BUS_ID_SHB;
     break;
   case NANOTUBE_CHANNEL_TYPE_X3RX_PACKET:
@@ -150,6 +152,11 @@ channel_packet_kernel::channel_packet_kernel(
 
 void channel_packet_kernel::process(nanotube_packet_t *packet)
 {
+  // Tell the timing model where the packet starts.
+  nanotube_sim *sim = m_system.get_sim();
+  if (sim != nullptr)
+    sim->packet_start();
+
   switch (m_packet_write_channel.get_write_export_type()) {
   default:
   case NANOTUBE_CHANNEL_TYPE_NONE:
@@ -184,19 +191,20 @@ channel_packet_kernel::write_simple_packet(nanotube_packet_t *packet)
   // Make sure the correct metadata is present.
   packet->convert_bus_type(NANOTUBE_BUS_ID_SB);
 
-  simple_bus::word w = {0};
+  uint8_t w[simple_bus::max_total_bytes] = {0};
   std::size_t iter = 0;
 
-  assert(m_packet_write_channel.get_elem_size() == simple_bus::total_bytes);
+  // The bus width is determined by the channel element size.
+  std::size_t word_size = m_packet_write_channel.get_elem_size();
+  assert(simple_bus::is_word_size(word_size));
 
   bool more = true;
   while (more) {
     // Get a word from the packet.
-    more = packet->get_bus_word(w.bytes, simple_bus::total_bytes,
-                                &iter);
+    more = packet->get_bus_word(w, word_size, &iter);
 
     // Write it to the channel.
-    write_word(w.bytes, simple_bus::total_bytes);
+    write_word(w, word_size);
   }
 }
 
@@ -206,12 +214,14 @@ channel_packet_kernel::write_softhub_packet(nanotube_packet_t *packet)
   // Make sure the correct metadata is present.
   packet->convert_bus_type(NANOTUBE_BUS_ID_SHB);
 
-  softhub_bus::word w = {0};
+  uint8_t w[softhub_bus::max_total_bytes] = {0};
   size_t sec_size = packet->size(NANOTUBE_SECTION_WHOLE);
   uint8_t *data = packet->begin(NANOTUBE_SECTION_WHOLE);
   std::size_t iter = 0;
 
-  assert(m_packet_write_channel.get_elem_size() == softhub_bus::total_bytes);
+  // The bus width is determined by the channel element size.
+  std::size_t word_size = m_packet_write_channel.get_elem_size();
+  assert(softhub_bus::is_word_size(word_size));
 
   // Make sure the header fields are correct.
   softhub_bus::set_ch_route_raw(data, packet->get_port());
@@ -220,11 +230,10 @@ channel_packet_kernel::write_softhub_packet(nanotube_packet_t *packet)
   bool more = true;
   while (more) {
     // Get a word from the packet.
-    more = packet->get_bus_word(w.bytes, softhub_bus::total_bytes,
-                                &iter);
+    more = packet->get_bus_word(w, word_size, &iter);
 
     // Write it to the channel.
-    write_word(w.bytes, softhub_bus::total_bytes);
+    write_word(w, word_size);
   }
 }
 
@@ -295,21 +304,26 @@ bool channel_packet_kernel::try_read_word()
 
 bool channel_packet_kernel::try_read_simple_word()
 {
-  simple_bus::word word_read_buffer;
+  uint8_t word_read_buffer[simple_bus::max_total_bytes];
+  std::size_t word_size = m_packet_read_channel.get_elem_size();
 
   // Try to read a word from the channel.
   bool success = m_packet_read_channel.try_read(
-    word_read_buffer.bytes, simple_bus::total_bytes);
+    word_read_buffer, word_size);
   if (!success)
     return false;
 
   // Add the word to the packet.
-  bool more = m_read_packet.add_bus_word(word_read_buffer.bytes,
-                                         simple_bus::total_bytes);
+  bool more = m_read_packet.add_bus_word(word_read_buffer, word_size);
   if (more)
     // Indicate that a word was read.
     return true;
 
+  // Tell the timing model that the packet has left.
+  nanotube_sim *sim = m_system.get_sim();
+  if (sim != nullptr)
+    sim->packet_end();
+
   // Process the packet.
   m_system.receive_packet(&m_read_packet, NANOTUBE_PACKET_PASS);
 
@@ -322,21 +336,26 @@ bool channel_packet_kernel::try_read_simple_word()
 
 bool channel_packet_kernel::try_read_softhub_word()
 {
-  softhub_bus::word word_read_buffer;
+  uint8_t word_read_buffer[softhub_bus::max_total_bytes];
+  std::size_t word_size = m_packet_read_channel.get_elem_size();
 
   // Try to read a word from the channel.
   bool success = m_packet_read_channel.try_read(
-    word_read_buffer.bytes, softhub_bus::total_bytes);
+    word_read_buffer, word_size);
   if (!success)
     return false;
 
   // Add the word to the packet.
-  bool more = m_read_packet.add_bus_word(word_read_buffer.bytes,
-                                         softhub_bus::total_bytes);
+  bool more = m_read_packet.add_bus_word(word_read_buffer, word_size);
   if (more)
     // Indicate that a word was read.
     return true;
 
+  // Tell the timing model that the packet has left.
+  nanotube_sim *sim = m_system.get_sim();
+  if (sim != nullptr)
+    sim->packet_end();
+
   // Process the packet.
   m_system.receive_packet(&m_read_packet, NANOTUBE_PACKET_PASS);
 
@@ -367,6 +386,11 @@ bool channel_packet_kernel::try_read_x3rx_word()
   // Convert the packet to Ethernet.
   m_read_packet.convert_bus_type(NANOTUBE_BUS_ID_ETH);
 
+  // Tell the timing model that the packet has left.
+  nanotube_sim *sim = m_system.get_sim();
+  if (sim != nullptr)
+    sim->packet_end();
+
   // Process the packet.
   m_system.receive_packet(&m_read_packet, NANOTUBE_PACKET_PASS);
 
@@ -426,6 +450,16 @@ void channel_packet_kernel::flush()
 
     nanotube_thread_wait();
   }
+
+  // Any packets which are still in flight in the timing model were
+  // dropped.  Collect any words which arrived after the last poll
+  // first.
+  nanotube_sim *sim = m_system.get_sim();
+  if (sim != nullptr) {
+    while (try_read_word())
+      ;
+    sim->flush();
+  }
 }
 
 void channel_packet_kernel::set_sender(nanotube_context *sender)
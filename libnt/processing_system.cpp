@@ -32,9 +32,11 @@ void dummy_ps_client::receive_packet(nanotube_packet_t *packet, nanotube_kernel_
 {
 }
 
-processing_system::ptr_t processing_system::attach(ps_client &client)
+processing_system::ptr_t
+processing_system::attach(ps_client &client,
+                          const nanotube_sim::config_t *sim_config)
 {
-  return ptr_t(new processing_system(client));
+  return ptr_t(new processing_system(client, sim_config));
 }
 
 void processing_system::detach(ptr_t &ptr)
@@ -49,8 +51,10 @@ processing_system &processing_system::get_current()
   return *s_current;
 }
 
-processing_system::processing_system(ps_client &client):
+processing_system::processing_system(ps_client &client,
+                                     const nanotube_sim::config_t *sim_config):
   m_client(client),
+  m_sim(sim_config != nullptr ? new nanotube_sim(*sim_config) : nullptr),
   m_main_thread(&m_main_context)
 {
   // Make the processing_system available to any API calls which need
@@ -68,6 +72,10 @@ processing_system::processing_system(ps_client &client):
   // Create the channel kernels, if any.
   make_channel_kernels();
 
+  // Attach the timing model to the threads.
+  if (m_sim)
+    m_sim->bind_threads(m_threads);
+
   // Start all the threads now that everything has been created.
   start_threads();
 }
@@ -0,0 +1,37 @@
+/*******************************************************/
+/*! \file profile_out_agent.cpp
+**  \brief A test agent for writing the profile to a file.
+*//******************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+#include "profile_out_agent.hpp"
+
+#include "nanotube_api.h"
+#include "test_harness.hpp"
+
+#include <iostream>
+
+///////////////////////////////////////////////////////////////////////////
+
+profile_out_agent::profile_out_agent(test_harness* harness,
+                                     const std::string &filename):
+  test_agent(harness),
+  m_filename(filename)
+{
+}
+
+void profile_out_agent::end_test()
+{
+  // The counts are only collected if the kernels were instrumented
+  // with the nt-profile-gen pass.
+  if (nanotube_profile_write(m_filename.c_str()) != 0) {
+    std::cerr << "Failed to write profile '" << m_filename << "'.\n";
+    get_harness()->set_test_failure();
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
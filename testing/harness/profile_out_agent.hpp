@@ -0,0 +1,34 @@
+/*******************************************************/
+/*! \file profile_out_agent.hpp
+**  \brief A test agent for writing the profile to a file.
+*//******************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+#ifndef PROFILE_OUT_AGENT_HPP
+#define PROFILE_OUT_AGENT_HPP
+
+#include "test_agent.hpp"
+
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////
+
+class profile_out_agent: public test_agent
+{
+public:
+  profile_out_agent(test_harness* harness, const std::string &filename);
+
+  void end_test() override;
+
+private:
+  // The name of the profile file.
+  std::string m_filename;
+};
+
+///////////////////////////////////////////////////////////////////////////
+
+#endif // PROFILE_OUT_AGENT_HPP
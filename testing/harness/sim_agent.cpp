@@ -0,0 +1,121 @@
+/*******************************************************/
+/*! \file sim_agent.cpp
+**  \brief A test agent for the cycle-approximate simulation mode.
+*//******************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+#include "sim_agent.hpp"
+
+#include "nanotube_sim.hpp"
+#include "test_harness.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+///////////////////////////////////////////////////////////////////////////
+
+// Parse an unsigned integer, exiting on failure.
+static unsigned parse_uint(const std::string &params,
+                           const std::string &val)
+{
+  char *end = nullptr;
+  unsigned long result = strtoul(val.c_str(), &end, 0);
+  if (val.empty() || *end != '\0') {
+    std::cerr << "Invalid number '" << val << "' in simulation"
+              << " parameters '" << params << "'.\n";
+    exit(1);
+  }
+  return result;
+}
+
+sim_agent::sim_agent(test_harness* harness, const std::string &params):
+  test_agent(harness)
+{
+  nanotube_sim::config_t config;
+
+  std::istringstream iss(params);
+  std::getline(iss, m_filename, ',');
+
+  std::string setting;
+  while (std::getline(iss, setting, ',')) {
+    size_t eq = setting.find('=');
+    std::string name = setting.substr(0, eq);
+    std::string val = ( eq == std::string::npos ? "" :
+                        setting.substr(eq+1) );
+    size_t colon = val.rfind(':');
+
+    if (name == "perf") {
+      config.perf_report = val;
+
+    } else if (name == "ii") {
+      config.ii = parse_uint(params, val);
+
+    } else if (name == "latency") {
+      config.latency = parse_uint(params, val);
+
+    } else if (name == "stage") {
+      size_t colon1 = val.rfind(':', colon-1);
+      if (colon == std::string::npos || colon == 0 ||
+          colon1 == std::string::npos) {
+        std::cerr << "Invalid stage costs '" << val
+                  << "'.  Expected NAME:II:LATENCY.\n";
+        exit(1);
+      }
+      unsigned ii = parse_uint(params, val.substr(colon1+1,
+                                                  colon-colon1-1));
+      unsigned latency = parse_uint(params, val.substr(colon+1));
+      config.stage_costs[val.substr(0, colon1)] =
+        std::make_pair(ii, latency);
+
+    } else if (name == "map-latency") {
+      config.map_latency = parse_uint(params, val);
+
+    } else if (name == "fifo-latency") {
+      config.fifo_latency = parse_uint(params, val);
+
+    } else if (name == "fifo-depth") {
+      if (colon == std::string::npos) {
+        config.fifo_depth = parse_uint(params, val);
+      } else {
+        config.fifo_depths[val.substr(0, colon)] =
+          parse_uint(params, val.substr(colon+1));
+      }
+
+    } else if (name == "gap") {
+      config.packet_gap = parse_uint(params, val);
+
+    } else {
+      std::cerr << "Unknown simulation setting '" << setting << "'.\n";
+      exit(1);
+    }
+  }
+
+  // The configuration is needed when the processing system is
+  // created, which happens before the test starts.
+  harness->set_sim_config(config);
+}
+
+void sim_agent::end_test()
+{
+  processing_system *system = get_harness()->get_system();
+  nanotube_sim *sim = system->get_sim();
+  assert(sim != nullptr);
+
+  std::ofstream out(m_filename);
+  sim->write_report(out, *system);
+  out.close();
+  if (out.fail()) {
+    std::cerr << "Failed to write simulation report '" << m_filename
+              << "'.\n";
+    get_harness()->set_test_failure();
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
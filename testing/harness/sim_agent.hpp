@@ -0,0 +1,46 @@
+/*******************************************************/
+/*! \file sim_agent.hpp
+**  \brief A test agent for the cycle-approximate simulation mode.
+*//******************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+#ifndef SIM_AGENT_HPP
+#define SIM_AGENT_HPP
+
+#include "test_agent.hpp"
+
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////
+
+// The parameters are the name of the report file followed by optional
+// comma separated settings:
+//   perf=FILE           Take stage costs from a code_metrics report.
+//   ii=N                The default initiation interval of a stage.
+//   latency=N           The default latency of a stage.
+//   stage=NAME:II:LAT   The costs of the stages with thread name NAME.
+//   map-latency=N       The latency of a map tap.
+//   fifo-latency=N      The latency of a channel.
+//   fifo-depth=N        The depth of all channels.
+//   fifo-depth=NAME:N   The depth of the channels named NAME.
+//   gap=N               The minimum cycles between packet starts.
+
+class sim_agent: public test_agent
+{
+public:
+  sim_agent(test_harness* harness, const std::string &params);
+
+  void end_test() override;
+
+private:
+  // The name of the report file.
+  std::string m_filename;
+};
+
+///////////////////////////////////////////////////////////////////////////
+
+#endif // SIM_AGENT_HPP
@@ -29,10 +29,13 @@
 #include "pcap_expect_agent.hpp"
 #include "pcap_in_agent.hpp"
 #include "pcap_out_agent.hpp"
+#include "profile_out_agent.hpp"
+#include "sim_agent.hpp"
 #include "socket_agent.hpp"
 #include "tap_agent.hpp"
 #include "test_agent.hpp"
 #include "test_harness_run.h"
+#include "trace_out_agent.hpp"
 #include "verbose_agent.hpp"
 
 namespace asio = boost::asio;
@@ -57,6 +60,12 @@ void test_harness::add_agent(test_agent_ptr_t agent)
   m_agents.push_back(std::move(agent));
 }
 
+void test_harness::set_sim_config(const nanotube_sim::config_t &config)
+{
+  assert(!m_system);
+  m_sim_config.reset(new nanotube_sim::config_t(config));
+}
+
 void test_harness::wake_io_thread()
 {
   if (m_asio_context.stopped()) {
@@ -80,6 +89,9 @@ void test_harness::test_kernel(packet_kernel &kernel)
   }
 
   kernel.flush();
+
+  // Report the packets discarded by early-drop pipeline stages.
+  nanotube_debug_print_drops();
 }
 
 void test_harness::send_packet(nanotube_packet_t *packet)
@@ -160,6 +172,12 @@ int test_harness::parse_arguments(int argc, char* argv[])
      "Dump maps to a text file after each packet.")
     ("tap", new agent_val_sem<tap_agent>(this, "NAME"),
      "Use a Linux TAP interface.")
+    ("profile-out", new agent_val_sem<profile_out_agent>(this, "FILENAME"),
+     "Write the profile of instrumented kernels to a file.")
+    ("trace-out", new agent_val_sem<trace_out_agent>(this, "PARAMS"),
+     "Write debug traces to a binary file.")
+    ("sim", new agent_val_sem<sim_agent>(this, "PARAMS"),
+     "Simulate with a cycle-approximate timing model and write a report.")
     ;
 
   po::positional_options_description pos;
@@ -309,7 +327,7 @@ int test_harness::run(int argc, char* argv[])
   if (rc != 0)
     return rc;
 
-  m_system = processing_system::attach(*this);
+  m_system = processing_system::attach(*this, m_sim_config.get());
 
   // Start the IO thread.
   start_io_thread();
@@ -73,6 +73,10 @@ public:
   // Add an agent to the test harness.  Ownership is transferred.
   void add_agent(test_agent_ptr_t agent);
 
+  // Simulate the processing system with a cycle-approximate timing
+  // model.  Must be called before the test starts.
+  void set_sim_config(const nanotube_sim::config_t &config);
+
   // Make sure the I/O thread is servicing requests.
   void wake_io_thread();
 
@@ -147,6 +151,10 @@ private:
 
   // The test agents.
   std::vector<test_agent_ptr_t> m_agents;
+
+  // The configuration of the timing model or nullptr if the
+  // processing system is not being simulated.
+  std::unique_ptr<nanotube_sim::config_t> m_sim_config;
 };
 
 ///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,92 @@
+/*******************************************************/
+/*! \file trace_out_agent.cpp
+**  \brief A test agent for writing a binary debug trace.
+*//******************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+#include "trace_out_agent.hpp"
+
+#include "nanotube_api.h"
+#include "test_harness.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+///////////////////////////////////////////////////////////////////////////
+
+// Parse an unsigned integer, exiting on failure.
+static uint64_t parse_uint(const std::string &params,
+                           const std::string &val)
+{
+  char *end = nullptr;
+  unsigned long long result = strtoull(val.c_str(), &end, 0);
+  if (val.empty() || *end != '\0') {
+    std::cerr << "Invalid number '" << val << "' in trace parameters '"
+              << params << "'.\n";
+    exit(1);
+  }
+  return result;
+}
+
+trace_out_agent::trace_out_agent(test_harness* harness,
+                                 const std::string &params):
+  test_agent(harness),
+  m_sample(1),
+  m_id_min(0),
+  m_id_max(std::numeric_limits<uint64_t>::max())
+{
+  std::istringstream iss(params);
+  std::getline(iss, m_filename, ',');
+
+  std::string setting;
+  while (std::getline(iss, setting, ',')) {
+    size_t eq = setting.find('=');
+    std::string name = setting.substr(0, eq);
+    std::string val = ( eq == std::string::npos ? "" :
+                        setting.substr(eq+1) );
+
+    if (name == "sample") {
+      m_sample = parse_uint(params, val);
+
+    } else if (name == "ids") {
+      size_t colon = val.find(':');
+      if (colon == std::string::npos) {
+        std::cerr << "Invalid ID range '" << val
+                  << "'.  Expected MIN:MAX.\n";
+        exit(1);
+      }
+      m_id_min = parse_uint(params, val.substr(0, colon));
+      m_id_max = parse_uint(params, val.substr(colon+1));
+
+    } else {
+      std::cerr << "Unknown trace setting '" << setting << "'.\n";
+      exit(1);
+    }
+  }
+}
+
+void trace_out_agent::start_test()
+{
+  int rc = nanotube_debug_trace_open(m_filename.c_str(), m_sample,
+                                     m_id_min, m_id_max);
+  if (rc != 0) {
+    std::cerr << "Failed to open trace file '" << m_filename << "'.\n";
+    exit(1);
+  }
+}
+
+void trace_out_agent::end_test()
+{
+  if (nanotube_debug_trace_close() != 0) {
+    std::cerr << "Failed to write trace file '" << m_filename << "'.\n";
+    get_harness()->set_test_failure();
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
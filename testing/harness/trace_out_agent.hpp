@@ -0,0 +1,46 @@
+/*******************************************************/
+/*! \file trace_out_agent.hpp
+**  \brief A test agent for writing a binary debug trace.
+*//******************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+
+#ifndef TRACE_OUT_AGENT_HPP
+#define TRACE_OUT_AGENT_HPP
+
+#include "test_agent.hpp"
+
+#include <cstdint>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////
+
+// The parameters are the filename followed by optional comma
+// separated settings:
+//   sample=N     Only record every Nth trace call of each thread.
+//   ids=MIN:MAX  Only record trace IDs in the range MIN to MAX.
+
+class trace_out_agent: public test_agent
+{
+public:
+  trace_out_agent(test_harness* harness, const std::string &params);
+
+  void start_test() override;
+  void end_test() override;
+
+private:
+  // The name of the trace file.
+  std::string m_filename;
+  // The sampling interval.
+  uint64_t m_sample;
+  // The range of IDs to record.
+  uint64_t m_id_min;
+  uint64_t m_id_max;
+};
+
+///////////////////////////////////////////////////////////////////////////
+
+#endif // TRACE_OUT_AGENT_HPP
@@ -0,0 +1,22 @@
+#include "stages.hh"
+
+void nanotube_top(
+  hls::stream<ap_axiu<512,8,0,0> > &channel0,
+  hls::stream<bytes<65> > &channel2)
+{
+#pragma HLS interface ap_ctrl_none port=return
+#pragma HLS interface axis port=channel0
+#pragma HLS interface axis port=channel2
+#if defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS data_pack variable=channel2
+#else // defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS aggregate variable=channel2
+#endif // defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS dataflow
+
+  static hls::stream<bytes<65> > channel1("packets_through");
+#pragma HLS stream variable=channel1 depth=16
+
+  stage_0(channel0, channel1);
+  stage_1(channel1, channel2);
+}
@@ -0,0 +1,83 @@
+#include "stages.hh"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// The number of invocations without any progress before the
+// testbench stops.
+static const int idle_limit = 1000;
+
+static bool read_elem(std::istream &in, uint8_t *data, size_t size)
+{
+  std::string line;
+  do {
+    if (!std::getline(in, line))
+      return false;
+  } while (line.find_first_not_of(" \t\r") == std::string::npos);
+
+  std::istringstream line_in(line);
+  for (size_t i=0; i<size; i++) {
+    unsigned val;
+    if (!(line_in >> std::hex >> val) || val > 0xff) {
+      std::cerr << "Invalid channel element: " << line << "\n";
+      exit(1);
+    }
+    data[i] = val;
+  }
+  return true;
+}
+
+static void write_elem(std::ostream &out, const uint8_t *data, size_t size)
+{
+  out << std::hex << std::setfill('0');
+  for (size_t i=0; i<size; i++)
+    out << (i == 0 ? "" : " ") << std::setw(2) << unsigned(data[i]);
+  out << std::dec << std::setfill(' ') << "\n";
+}
+
+int main(int argc, char *argv[])
+{
+  // Channel 0: "packets_in"
+  hls::stream<ap_axiu<512,8,0,0> > channel0("channel0");
+  std::ifstream channel0_file("channel0.in");
+  bool channel0_done = false;
+  // Channel 2: "packets_out"
+  hls::stream<bytes<65> > channel2("channel2");
+  std::ofstream channel2_file("channel2.out");
+
+  int idle = 0;
+  while (idle < idle_limit) {
+    bool active = false;
+
+    if (!channel0_done && channel0.empty()) {
+      bytes<65> channel0_flat;
+      if (read_elem(channel0_file, channel0_flat.data, 65)) {
+        ap_axiu<512,8,0,0> channel0_elem;
+        nanotube_memcpy(&channel0_elem.data, &(channel0_flat.data[0]), 64);
+        nanotube_memcpy(&channel0_elem.user, &(channel0_flat.data[64]), 1);
+        channel0.write(channel0_elem);
+        active = true;
+      } else {
+        channel0_done = true;
+      }
+    }
+
+    nanotube_top(channel0, channel2);
+
+    while (!channel2.empty()) {
+      bytes<65> channel2_elem = channel2.read();
+      bytes<65> channel2_flat;
+      channel2_flat = channel2_elem;
+      write_elem(channel2_file, channel2_flat.data, 65);
+      active = true;
+    }
+
+    idle = (active ? 0 : idle + 1);
+  }
+
+  return 0;
+}
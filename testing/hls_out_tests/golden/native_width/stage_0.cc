@@ -0,0 +1,121 @@
+// Stage 0
+// Thread name:    stage_0
+// Thread function logic_0
+//   Port 0 reads  channel 0
+//   Port 1 writes channel 1
+#include "ap_int.h"
+#include "hls_stream.h"
+#include "stages.hh"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+void stage_0(
+  hls::stream<bytes<65> > &port0,
+  hls::stream<bytes<65> > &port1)
+{
+  bytes<65> port0_data;
+  bytes<65> port1_data;
+  uint8_t v0[65];
+#pragma HLS array_partition variable=v0 complete
+  uint8_t v1[16]__attribute__((aligned(8)));
+#pragma HLS array_partition variable=v1 complete
+  ap_uint<32> v2;
+  ap_uint<1> v3;
+  ap_uint<8> v4;
+  ap_uint<16> v5;
+  ap_uint<32> v6;
+  ap_uint<64> v7;
+  ap_uint<16> v8;
+  ap_uint<32> v9;
+  ap_uint<64> v10;
+  ap_uint<8> v11;
+  ap_uint<8> v12;
+  ap_uint<8> v13;
+  ap_uint<8> v14;
+  ap_uint<8> v15;
+
+#pragma HLS pipeline II=1
+#pragma HLS interface ap_ctrl_none port=return
+#pragma HLS interface axis port=port0
+#if defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS data_pack variable=port0
+#else // defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS aggregate variable=port0
+#pragma HLS aggregate variable=port0_data
+#endif // defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS interface axis port=port1
+#if defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS data_pack variable=port1
+#else // defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS aggregate variable=port1
+#pragma HLS aggregate variable=port1_data
+#endif // defined(NANOTUBE_USING_VIVADO_HLS)
+
+  v2 = port0.read_nb(port0_data);
+  nanotube_memcpy(v0, port0_data.data, 65);
+  v3 = v2 == ap_uint<32>(0);
+  if ( v3 ) {
+    goto L0;
+  } else {
+    goto L1;
+  }
+
+L0:
+  goto L2;
+
+L1:
+  v4 = (ap_uint<8>(v0[0]) << 0);
+  v5 = ap_uint<8>(v4);
+  v6 = ap_uint<8>(v4);
+  v7 = ap_uint<8>(v4);
+  {
+    ap_uint<16> packed = v5;
+    v1[0] = packed.range(7, 0);
+    v1[1] = packed.range(15, 8);
+  }
+  {
+    ap_uint<32> packed = v6;
+    (v1+4)[0] = packed.range(7, 0);
+    (v1+4)[1] = packed.range(15, 8);
+    (v1+4)[2] = packed.range(23, 16);
+    (v1+4)[3] = packed.range(31, 24);
+  }
+  {
+    ap_uint<64> packed = v7;
+    (v1+8)[0] = packed.range(7, 0);
+    (v1+8)[1] = packed.range(15, 8);
+    (v1+8)[2] = packed.range(23, 16);
+    (v1+8)[3] = packed.range(31, 24);
+    (v1+8)[4] = packed.range(39, 32);
+    (v1+8)[5] = packed.range(47, 40);
+    (v1+8)[6] = packed.range(55, 48);
+    (v1+8)[7] = packed.range(63, 56);
+  }
+  v8 = (ap_uint<8>(v1[1]),
+    ap_uint<8>(v1[0]));
+  v9 = (ap_uint<8>((v1+4)[3]),
+    ap_uint<8>((v1+4)[2]),
+    ap_uint<8>((v1+4)[1]),
+    ap_uint<8>((v1+4)[0]));
+  v10 = (ap_uint<8>((v1+8)[7]),
+    ap_uint<8>((v1+8)[6]),
+    ap_uint<8>((v1+8)[5]),
+    ap_uint<8>((v1+8)[4]),
+    ap_uint<8>((v1+8)[3]),
+    ap_uint<8>((v1+8)[2]),
+    ap_uint<8>((v1+8)[1]),
+    ap_uint<8>((v1+8)[0]));
+  v11 = ap_uint<16>(v8);
+  v12 = ap_uint<32>(v9);
+  v13 = ap_uint<64>(v10);
+  v14 = v11 + v12;
+  v15 = v14 + v13;
+  v0[0] = (v15 >> 0);
+  nanotube_memcpy(port1_data.data, v0, 65);
+  port1.write(port1_data);
+  goto L2;
+
+L2:
+  return;
+}
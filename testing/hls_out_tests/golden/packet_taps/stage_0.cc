@@ -0,0 +1,157 @@
+// Stage 0
+// Thread name:    stage_0
+// Thread function logic_0
+//   Port 0 reads  channel 0
+//   Port 1 writes channel 1
+#include "ap_int.h"
+#include "hls_stream.h"
+#include "stages.hh"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+static uint8_t s0[6] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+void stage_0(
+  hls::stream<bytes<65> > &port0,
+  hls::stream<bytes<65> > &port1)
+{
+  bytes<65> port0_data;
+  bytes<65> port1_data;
+  uint8_t v0[65];
+#pragma HLS array_partition variable=v0 complete
+  uint8_t v1[6]__attribute__((aligned(2)));
+#pragma HLS array_partition variable=v1 complete
+  uint8_t v2[4]__attribute__((aligned(2)));
+#pragma HLS array_partition variable=v2 complete
+  uint8_t v3[1];
+#pragma HLS array_partition variable=v3 complete
+  ap_uint<32> v4;
+  ap_uint<1> v5;
+  ap_uint<8> v6;
+  ap_uint<1> v7;
+  ap_uint<8> v8;
+  ap_uint<16> v9;
+  ap_uint<16> v10;
+  ap_uint<16> v11;
+  ap_uint<16> v12;
+  ap_uint<16> v13;
+  ap_uint<16> v14;
+  ap_uint<8> v15;
+  ap_uint<16> v16;
+  ap_uint<1> v17;
+  ap_uint<1> v18;
+  ap_uint<1> v19;
+  ap_uint<1> v20;
+  ap_uint<1> v21;
+  ap_uint<16> v22;
+  ap_uint<64> v23;
+  uint8_t *v24;
+  ap_uint<8> v25;
+  ap_uint<8> v26;
+  ap_uint<1> v27;
+  ap_uint<8> v28;
+
+#pragma HLS pipeline II=1
+#pragma HLS interface ap_ctrl_none port=return
+#pragma HLS interface axis port=port0
+#if defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS data_pack variable=port0
+#else // defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS aggregate variable=port0
+#pragma HLS aggregate variable=port0_data
+#endif // defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS interface axis port=port1
+#if defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS data_pack variable=port1
+#else // defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS aggregate variable=port1
+#pragma HLS aggregate variable=port1_data
+#endif // defined(NANOTUBE_USING_VIVADO_HLS)
+#pragma HLS array_partition variable=s0 complete
+
+  v4 = port0.read_nb(port0_data);
+  nanotube_memcpy(v0, port0_data.data, 65);
+  v5 = v4 == ap_uint<32>(0);
+  if ( v5 ) {
+    goto L0;
+  } else {
+    goto L1;
+  }
+
+L0:
+  goto L2;
+
+L1:
+  v1[0] = (ap_uint<8>(1) >> 0);
+  (v1+2)[0] = (ap_uint<16>(14) >> 0);
+  (v1+2)[1] = (ap_uint<16>(14) >> 8);
+  (v1+4)[0] = (ap_uint<16>(1) >> 0);
+  (v1+4)[1] = (ap_uint<16>(1) >> 8);
+  v6 = (ap_uint<8>((v0+64)[0]) << 0);
+  v7 = ((ap_uint<8>(1) << 7) ^ v6) < ((ap_uint<8>(1) << 7) ^ ap_uint<8>(0));
+  v8 = v6 & ap_uint<8>(63);
+  v9 = ap_uint<8>(v8);
+  v10 = ap_uint<16>(64) - v9;
+  v11 = (v7 ? v10 : ap_uint<16>(64));
+  v12 = (ap_uint<16>((s0+2)[0]) << 0) |
+    (ap_uint<16>((s0+2)[1]) << 8);
+  v13 = v12 + v11;
+  v14 = (v7 ? ap_uint<16>(0) : v13);
+  (s0+2)[0] = (v14 >> 0);
+  (s0+2)[1] = (v14 >> 8);
+  v15 = (ap_uint<8>(v1[0]) << 0);
+  v16 = (ap_uint<16>((v1+2)[0]) << 0) |
+    (ap_uint<16>((v1+2)[1]) << 8);
+  v17 = v15 != ap_uint<8>(0);
+  v18 = v16 >= v12;
+  v19 = v16 < v13;
+  v20 = v18 & v19;
+  v21 = v17 & v20;
+  if ( v21 ) {
+    goto L3;
+  } else {
+    goto L4;
+  }
+
+L3:
+  v22 = v16 - v12;
+  v23 = ap_uint<16>(v22);
+  v24 = (v0 + (1 * v23));
+  v25 = (ap_uint<8>(v24[0]) << 0);
+  v3[0] = (v25 >> 0);
+  v2[0] = (ap_uint<8>(1) >> 0);
+  (v2+2)[0] = (ap_uint<16>(1) >> 0);
+  (v2+2)[1] = (ap_uint<16>(1) >> 8);
+  goto L5;
+
+L4:
+  v2[0] = (ap_uint<8>(0) >> 0);
+  (v2+2)[0] = (ap_uint<16>(0) >> 0);
+  (v2+2)[1] = (ap_uint<16>(0) >> 8);
+  goto L5;
+
+L5:
+  v26 = (ap_uint<8>(v2[0]) << 0);
+  v27 = v26 == ap_uint<8>(0);
+  if ( v27 ) {
+    goto L6;
+  } else {
+    goto L7;
+  }
+
+L7:
+  v28 = (ap_uint<8>(v3[0]) << 0);
+  (v0+1)[0] = (v28 >> 0);
+  goto L6;
+
+L6:
+  nanotube_memcpy(port1_data.data, v0, 65);
+  port1.write(port1_data);
+  goto L2;
+
+L2:
+  return;
+}
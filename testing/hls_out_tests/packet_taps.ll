@@ -0,0 +1,164 @@
+; //! \file   packet_taps.ll
+; // \author  Neil Turton <neilt@amd.com>
+; //  \brief  A HLS output pass test for a stage with a packet tap.
+; //   \date  2026-10-19
+;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+; In this test, logic_0 reads one byte of each packet using the simple
+; bus packet read tap.  The module has the shape left by the link_taps
+; step: the bus wrapper calls the templated core for a 64 byte packet
+; buffer, which calls the C core.  The tap bodies are cut down from
+; those in nanotube_low_level.bc.  All three must be inlined by the
+; always-inline pass, otherwise the HLS output pass reports an
+; unsupported call in the thread function.
+;
+; OPTIONS = -passes=always-inline
+
+source_filename = "testing/hls_out_tests/packet_taps.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%"struct.simple_bus::word" = type { [65 x i8] }
+%struct.nanotube_channel = type opaque
+%struct.nanotube_tap_packet_read_req = type { i8, i16, i16 }
+%struct.nanotube_tap_packet_read_resp = type { i8, i16 }
+%struct.nanotube_tap_packet_read_state = type { i16, i16, i16 }
+
+@packets_in.str = private unnamed_addr constant [11 x i8] c"packets_in\00", align 1
+@packets_out.str = private unnamed_addr constant [12 x i8] c"packets_out\00", align 1
+@stage_0.str = private unnamed_addr constant [8 x i8] c"stage_0\00", align 1
+@_ZZ7logic_0E5state = internal global %struct.nanotube_tap_packet_read_state zeroinitializer, align 2
+
+declare dso_local i32 @nanotube_channel_try_read(%struct.nanotube_context*, i32, i8*, i64) local_unnamed_addr #0
+declare dso_local void @nanotube_thread_wait() local_unnamed_addr #0
+declare dso_local void @nanotube_channel_write(%struct.nanotube_context*, i32, i8*, i64) local_unnamed_addr #0
+declare dso_local %struct.nanotube_channel* @nanotube_channel_create(i8*, i64, i64) local_unnamed_addr #0
+declare dso_local %struct.nanotube_context* @nanotube_context_create() local_unnamed_addr #0
+declare dso_local void @nanotube_context_add_channel(%struct.nanotube_context*, i32, %struct.nanotube_channel*, i32) local_unnamed_addr #0
+declare dso_local void @nanotube_thread_create(%struct.nanotube_context*, i8*, void (%struct.nanotube_context*, i8*)*, i8*, i64) local_unnamed_addr #0
+
+; Function Attrs: uwtable
+define dso_local void @logic_0(%struct.nanotube_context* %context, i8* nocapture readnone %arg) #1 {
+entry:
+  %word = alloca %"struct.simple_bus::word", align 1
+  %req = alloca %struct.nanotube_tap_packet_read_req, align 2
+  %resp = alloca %struct.nanotube_tap_packet_read_resp, align 2
+  %result = alloca [1 x i8], align 1
+  %data = getelementptr inbounds %"struct.simple_bus::word", %"struct.simple_bus::word"* %word, i64 0, i32 0, i64 0
+  %succ.int = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %context, i32 0, i8* nonnull %data, i64 65)
+  %fail.bool = icmp eq i32 %succ.int, 0
+  br i1 %fail.bool, label %read_fail, label %read_succ
+
+read_fail:                                          ; preds = %entry
+  call void @nanotube_thread_wait()
+  br label %cleanup
+
+read_succ:                                          ; preds = %entry
+  %req.valid = getelementptr inbounds %struct.nanotube_tap_packet_read_req, %struct.nanotube_tap_packet_read_req* %req, i64 0, i32 0
+  store i8 1, i8* %req.valid, align 2
+  %req.offset = getelementptr inbounds %struct.nanotube_tap_packet_read_req, %struct.nanotube_tap_packet_read_req* %req, i64 0, i32 1
+  store i16 14, i16* %req.offset, align 2
+  %req.length = getelementptr inbounds %struct.nanotube_tap_packet_read_req, %struct.nanotube_tap_packet_read_req* %req, i64 0, i32 2
+  store i16 1, i16* %req.length, align 2
+  %result.ptr = getelementptr inbounds [1 x i8], [1 x i8]* %result, i64 0, i64 0
+  call void @nanotube_tap_packet_read_sb(i16 1, i8 0, %struct.nanotube_tap_packet_read_resp* nonnull %resp, i8* nonnull %result.ptr, %struct.nanotube_tap_packet_read_state* nonnull @_ZZ7logic_0E5state, i8* nonnull %data, %struct.nanotube_tap_packet_read_req* nonnull %req)
+  %resp.valid.ptr = getelementptr inbounds %struct.nanotube_tap_packet_read_resp, %struct.nanotube_tap_packet_read_resp* %resp, i64 0, i32 0
+  %resp.valid = load i8, i8* %resp.valid.ptr, align 2
+  %resp.bool = icmp eq i8 %resp.valid, 0
+  br i1 %resp.bool, label %write, label %update
+
+update:                                             ; preds = %read_succ
+  %result.val = load i8, i8* %result.ptr, align 1
+  %data.1 = getelementptr inbounds %"struct.simple_bus::word", %"struct.simple_bus::word"* %word, i64 0, i32 0, i64 1
+  store i8 %result.val, i8* %data.1, align 1
+  br label %write
+
+write:                                              ; preds = %update, %read_succ
+  call void @nanotube_channel_write(%struct.nanotube_context* %context, i32 1, i8* nonnull %data, i64 65)
+  br label %cleanup
+
+cleanup:                                            ; preds = %write, %read_fail
+  ret void
+}
+
+; The simple bus wrapper.
+; Function Attrs: alwaysinline uwtable
+define dso_local void @nanotube_tap_packet_read_sb(i16 zeroext %result_buffer_length, i8 zeroext %result_buffer_index_bits, %struct.nanotube_tap_packet_read_resp* %resp_out, i8* %result_buffer_inout, %struct.nanotube_tap_packet_read_state* %state_inout, i8* %packet_word_in, %struct.nanotube_tap_packet_read_req* %req_in) #2 {
+entry:
+  %control.ptr = getelementptr inbounds i8, i8* %packet_word_in, i64 64
+  %control = load i8, i8* %control.ptr, align 1
+  %eop = icmp slt i8 %control, 0
+  %empty = and i8 %control, 63
+  %empty.16 = zext i8 %empty to i16
+  %length = sub i16 64, %empty.16
+  %word.length = select i1 %eop, i16 %length, i16 64
+  call void @_ZN13nanotube_taps20tap_packet_read_coreILt64ELh6EEEvthP29nanotube_tap_packet_read_respPhP30nanotube_tap_packet_read_statePKhbtPK28nanotube_tap_packet_read_req(i16 zeroext %result_buffer_length, i8 zeroext %result_buffer_index_bits, %struct.nanotube_tap_packet_read_resp* %resp_out, i8* %result_buffer_inout, %struct.nanotube_tap_packet_read_state* %state_inout, i8* %packet_word_in, i1 zeroext %eop, i16 zeroext %word.length, %struct.nanotube_tap_packet_read_req* %req_in)
+  ret void
+}
+
+; The templated core for a 64 byte packet buffer.
+; Function Attrs: alwaysinline uwtable
+define linkonce_odr dso_local void @_ZN13nanotube_taps20tap_packet_read_coreILt64ELh6EEEvthP29nanotube_tap_packet_read_respPhP30nanotube_tap_packet_read_statePKhbtPK28nanotube_tap_packet_read_req(i16 zeroext %result_buffer_length, i8 zeroext %result_buffer_index_bits, %struct.nanotube_tap_packet_read_resp* %resp_out, i8* %result_buffer_inout, %struct.nanotube_tap_packet_read_state* %state_inout, i8* %packet_buffer_in, i1 zeroext %packet_word_eop, i16 zeroext %packet_word_length, %struct.nanotube_tap_packet_read_req* %req_in) #2 {
+entry:
+  call void @nanotube_tap_packet_read_core(i16 zeroext %result_buffer_length, i8 zeroext %result_buffer_index_bits, i16 zeroext 64, i8 zeroext 6, %struct.nanotube_tap_packet_read_resp* %resp_out, i8* %result_buffer_inout, %struct.nanotube_tap_packet_read_state* %state_inout, i8* %packet_buffer_in, i1 zeroext %packet_word_eop, i16 zeroext %packet_word_length, %struct.nanotube_tap_packet_read_req* %req_in)
+  ret void
+}
+
+; The C core, cut down to read a single byte.
+; Function Attrs: alwaysinline uwtable
+define dso_local void @nanotube_tap_packet_read_core(i16 zeroext %result_buffer_length, i8 zeroext %result_buffer_index_bits, i16 zeroext %packet_buffer_length, i8 zeroext %packet_buffer_index_bits, %struct.nanotube_tap_packet_read_resp* %resp_out, i8* %result_buffer_inout, %struct.nanotube_tap_packet_read_state* %state_inout, i8* %packet_buffer_in, i1 zeroext %packet_word_eop, i16 zeroext %packet_word_length, %struct.nanotube_tap_packet_read_req* %req_in) #2 {
+entry:
+  %offset.ptr = getelementptr inbounds %struct.nanotube_tap_packet_read_state, %struct.nanotube_tap_packet_read_state* %state_inout, i64 0, i32 1
+  %word.start = load i16, i16* %offset.ptr, align 2
+  %word.end = add i16 %word.start, %packet_word_length
+  %new.offset = select i1 %packet_word_eop, i16 0, i16 %word.end
+  store i16 %new.offset, i16* %offset.ptr, align 2
+  %req.valid.ptr = getelementptr inbounds %struct.nanotube_tap_packet_read_req, %struct.nanotube_tap_packet_read_req* %req_in, i64 0, i32 0
+  %req.valid = load i8, i8* %req.valid.ptr, align 2
+  %req.offset.ptr = getelementptr inbounds %struct.nanotube_tap_packet_read_req, %struct.nanotube_tap_packet_read_req* %req_in, i64 0, i32 1
+  %req.offset = load i16, i16* %req.offset.ptr, align 2
+  %valid = icmp ne i8 %req.valid, 0
+  %after.start = icmp uge i16 %req.offset, %word.start
+  %before.end = icmp ult i16 %req.offset, %word.end
+  %in.word = and i1 %after.start, %before.end
+  %hit = and i1 %valid, %in.word
+  %resp.valid.ptr = getelementptr inbounds %struct.nanotube_tap_packet_read_resp, %struct.nanotube_tap_packet_read_resp* %resp_out, i64 0, i32 0
+  %resp.length.ptr = getelementptr inbounds %struct.nanotube_tap_packet_read_resp, %struct.nanotube_tap_packet_read_resp* %resp_out, i64 0, i32 1
+  br i1 %hit, label %copy, label %miss
+
+copy:                                               ; preds = %entry
+  %index = sub i16 %req.offset, %word.start
+  %index.64 = zext i16 %index to i64
+  %byte.ptr = getelementptr inbounds i8, i8* %packet_buffer_in, i64 %index.64
+  %byte = load i8, i8* %byte.ptr, align 1
+  store i8 %byte, i8* %result_buffer_inout, align 1
+  store i8 1, i8* %resp.valid.ptr, align 2
+  store i16 1, i16* %resp.length.ptr, align 2
+  ret void
+
+miss:                                               ; preds = %entry
+  store i8 0, i8* %resp.valid.ptr, align 2
+  store i16 0, i16* %resp.length.ptr, align 2
+  ret void
+}
+
+; Function Attrs: uwtable
+define dso_local void @nanotube_setup() local_unnamed_addr #1 {
+entry:
+  %channel_0 = tail call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([11 x i8], [11 x i8]* @packets_in.str, i64 0, i64 0), i64 65, i64 16)
+  %channel_1 = tail call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([12 x i8], [12 x i8]* @packets_out.str, i64 0, i64 0), i64 65, i64 16)
+  %context_0 = tail call %struct.nanotube_context* @nanotube_context_create()
+  tail call void @nanotube_context_add_channel(%struct.nanotube_context* %context_0, i32 0, %struct.nanotube_channel* %channel_0, i32 1)
+  tail call void @nanotube_context_add_channel(%struct.nanotube_context* %context_0, i32 1, %struct.nanotube_channel* %channel_1, i32 2)
+  tail call void @nanotube_thread_create(%struct.nanotube_context* %context_0, i8* getelementptr inbounds ([8 x i8], [8 x i8]* @stage_0.str, i64 0, i64 0), void (%struct.nanotube_context*, i8*)* nonnull @logic_0, i8* null, i64 0)
+  ret void
+}
+
+attributes #0 = { "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="false" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "no-trapping-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #1 = { uwtable "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "less-precise-fpmad"="false" "min-legal-vector-width"="0" "no-frame-pointer-elim"="false" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "no-trapping-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #2 = { alwaysinline uwtable "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "less-precise-fpmad"="false" "min-legal-vector-width"="0" "no-frame-pointer-elim"="false" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "no-trapping-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
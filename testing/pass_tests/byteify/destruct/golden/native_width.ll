@@ -0,0 +1,62 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+source_filename = "testing/pass_tests/byteify/destruct/native_width.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define i64 @foo(i32* %p, i64 %idx, i32 %val) {
+entry:
+  %0 = alloca [16 x i8], align 8
+  %bc_u8p = bitcast [16 x i8]* %0 to i8*
+  %1 = getelementptr inbounds i8, i8* %bc_u8p, i64 0
+  %bc_proxyi22 = bitcast i8* %1 to i16*
+  store i16 1, i16* %bc_proxyi22, align 2
+  %2 = getelementptr inbounds i8, i8* %bc_u8p, i64 2
+  %bc_proxyi21 = bitcast i8* %2 to i16*
+  %base = bitcast i16* %bc_proxyi21 to i8*
+  %trunc = trunc i16 2 to i8
+  %elemp = getelementptr i8, i8* %base, i32 0
+  store i8 %trunc, i8* %elemp
+  %shifted = lshr i16 2, 8
+  %trunc1 = trunc i16 %shifted to i8
+  %elemp2 = getelementptr i8, i8* %base, i32 1
+  store i8 %trunc1, i8* %elemp2
+  %3 = getelementptr inbounds i8, i8* %bc_u8p, i64 4
+  %bc_proxyi20 = bitcast i8* %3 to i32*
+  store i32 %val, i32* %bc_proxyi20, align 4
+  %4 = getelementptr inbounds i8, i8* %bc_u8p, i64 8
+  %bc_proxyi19 = bitcast i8* %4 to i64*
+  store i64 3, i64* %bc_proxyi19, align 8
+  %a = load i16, i16* %bc_proxyi22, align 2
+  %b = load i32, i32* %bc_proxyi20, align 4
+  %fv = getelementptr inbounds i32, i32* %p, i64 %idx
+  %base3 = bitcast i32* %fv to i8*
+  %elemp4 = getelementptr i8, i8* %base3, i32 0
+  %val8 = load i8, i8* %elemp4
+  %wide = zext i8 %val8 to i32
+  %elemp5 = getelementptr i8, i8* %base3, i32 1
+  %val86 = load i8, i8* %elemp5
+  %wide7 = zext i8 %val86 to i32
+  %shifted8 = shl i32 %wide7, 8
+  %ORed = or i32 %shifted8, %wide
+  %elemp9 = getelementptr i8, i8* %base3, i32 2
+  %val810 = load i8, i8* %elemp9
+  %wide11 = zext i8 %val810 to i32
+  %shifted12 = shl i32 %wide11, 16
+  %ORed13 = or i32 %shifted12, %ORed
+  %elemp14 = getelementptr i8, i8* %base3, i32 3
+  %val815 = load i8, i8* %elemp14
+  %wide16 = zext i8 %val815 to i32
+  %shifted17 = shl i32 %wide16, 24
+  %ORed18 = or i32 %shifted17, %ORed13
+  %d = load i64, i64* %bc_proxyi19, align 8
+  %a64 = zext i16 %a to i64
+  %b64 = zext i32 %b to i64
+  %c64 = zext i32 %ORed18 to i64
+  %s0 = add i64 %a64, %b64
+  %s1 = add i64 %s0, %c64
+  %s2 = add i64 %s1, %d
+  ret i64 %s2
+}
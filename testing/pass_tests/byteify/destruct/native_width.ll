@@ -0,0 +1,43 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;
+; A test for native width accesses surviving byteify and destruct.
+;
+; The aligned accesses at constant offsets into %s must stay at their
+; native width.  The access through a variable index and the
+; under-aligned access must still be split into bytes.
+;
+; OPTIONS = -native-width-access
+
+source_filename = "testing/pass_tests/byteify/destruct/native_width.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.hdr = type { i16, i16, i32, i64 }
+
+define i64 @foo(i32* %p, i64 %idx, i32 %val) {
+entry:
+  %s = alloca %struct.hdr, align 8
+  %f0 = getelementptr inbounds %struct.hdr, %struct.hdr* %s, i64 0, i32 0
+  store i16 1, i16* %f0, align 2
+  %f1 = getelementptr inbounds %struct.hdr, %struct.hdr* %s, i64 0, i32 1
+  store i16 2, i16* %f1, align 1
+  %f2 = getelementptr inbounds %struct.hdr, %struct.hdr* %s, i64 0, i32 2
+  store i32 %val, i32* %f2, align 4
+  %f3 = getelementptr inbounds %struct.hdr, %struct.hdr* %s, i64 0, i32 3
+  store i64 3, i64* %f3, align 8
+  %a = load i16, i16* %f0, align 2
+  %b = load i32, i32* %f2, align 4
+  %fv = getelementptr inbounds i32, i32* %p, i64 %idx
+  %c = load i32, i32* %fv, align 4
+  %d = load i64, i64* %f3, align 8
+  %a64 = zext i16 %a to i64
+  %b64 = zext i32 %b to i64
+  %c64 = zext i32 %c to i64
+  %s0 = add i64 %a64, %b64
+  %s1 = add i64 %s0, %c64
+  %s2 = add i64 %s1, %d
+  ret i64 %s2
+}
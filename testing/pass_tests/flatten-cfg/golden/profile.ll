@@ -0,0 +1,53 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+source_filename = "testing/pass_tests/flatten-cfg/profile.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+@.str = private unnamed_addr constant [7 x i8] c"kernel\00", align 1
+
+define dso_local i32 @kernel(%struct.nanotube_context* %context, %struct.nanotube_packet* %packet) !prof !0 {
+entry:
+  %buf = alloca [2 x i8], align 1
+  %0 = getelementptr inbounds [2 x i8], [2 x i8]* %buf, i64 0, i64 0
+  %1 = getelementptr inbounds [2 x i8], [2 x i8]* %buf, i64 0, i64 1
+  %rd0 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %0, i64 0, i64 1)
+  %type = load i8, i8* %0, align 1
+  %case_0 = icmp eq i8 %type, 8
+  %case_1 = icmp eq i8 %type, 6
+  %not_default = or i1 %case_0, %case_1
+  %case_default = xor i1 %not_default, true
+  %2 = select i1 %case_1, i64 1, i64 0
+  %rd2 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %1, i64 2, i64 %2)
+  %rd1 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %1, i64 1, i64 1)
+  %3 = select i1 %case_default, i64 1, i64 0
+  %rd3 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %1, i64 3, i64 %3)
+  %is_zero = icmp eq i8 %type, 0
+  %not_is_zero = xor i1 %is_zero, true
+  %4 = select i1 %not_is_zero, i64 1, i64 0
+  %wr = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %1, i64 4, i64 %4)
+  %5 = select i1 %is_zero, i32 1, i32 0
+  ret i32 %5
+}
+
+define dso_local void @nanotube_setup() {
+entry:
+  %context = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_add_plain_packet_kernel(i8* getelementptr inbounds ([7 x i8], [7 x i8]* @.str, i64 0, i64 0), i32 (%struct.nanotube_context*, %struct.nanotube_packet*)* @kernel, i32 0, i32 1)
+  ret void
+}
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_packet_write(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare %struct.nanotube_context* @nanotube_context_create()
+
+declare void @nanotube_add_plain_packet_kernel(i8*, i32 (%struct.nanotube_context*, %struct.nanotube_packet*)*, i32, i32)
+
+!0 = !{!"function_entry_count", i64 1000}
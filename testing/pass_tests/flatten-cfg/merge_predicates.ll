@@ -0,0 +1,59 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Block if.then is entered either directly or through if.else, whose
+; condition is the inverse of the one of if.entry.  Its predicate
+; therefore recomputes the predicate of if.entry and is replaced by it.
+source_filename = "testing/pass_tests/flatten-cfg/merge_predicates.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+@.str = private unnamed_addr constant [7 x i8] c"kernel\00", align 1
+
+define dso_local i32 @kernel(%struct.nanotube_context* %context, %struct.nanotube_packet* %packet) {
+entry:
+  %buf = alloca [2 x i8], align 1
+  %out = alloca i8, align 1
+  %0 = getelementptr inbounds [2 x i8], [2 x i8]* %buf, i64 0, i64 0
+  %1 = getelementptr inbounds [2 x i8], [2 x i8]* %buf, i64 0, i64 1
+  %rd = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %0, i64 0, i64 2)
+  %a = load i8, i8* %0, align 1
+  %b = load i8, i8* %1, align 1
+  %is_zero = icmp eq i8 %a, 0
+  br i1 %is_zero, label %if.entry, label %return
+
+if.entry:
+  %is_ten = icmp eq i8 %b, 10
+  br i1 %is_ten, label %if.then, label %if.else
+
+if.else:
+  %not_ten = icmp ne i8 %b, 10
+  br i1 %not_ten, label %if.then, label %return
+
+if.then:
+  store i8 1, i8* %out, align 1
+  %wr = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %out, i64 2, i64 1)
+  br label %return
+
+return:
+  ret i32 0
+}
+
+define dso_local void @nanotube_setup() {
+entry:
+  %context = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_add_plain_packet_kernel(i8* getelementptr inbounds ([7 x i8], [7 x i8]* @.str, i64 0, i64 0), i32 (%struct.nanotube_context*, %struct.nanotube_packet*)* @kernel, i32 0, i32 1)
+  ret void
+}
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_packet_write(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare %struct.nanotube_context* @nanotube_context_create()
+
+declare void @nanotube_add_plain_packet_kernel(i8*, i32 (%struct.nanotube_context*, %struct.nanotube_packet*)*, i32, i32)
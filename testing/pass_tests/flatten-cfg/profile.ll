@@ -0,0 +1,67 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; With a profile, the packet read of the hot block is executed
+; speculatively and the packet reads of the warm and cold blocks are
+; predicated, even though -flatten-spec-reads is not given.
+source_filename = "testing/pass_tests/flatten-cfg/profile.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+@.str = private unnamed_addr constant [7 x i8] c"kernel\00", align 1
+
+define dso_local i32 @kernel(%struct.nanotube_context* %context, %struct.nanotube_packet* %packet) !prof !0 {
+entry:
+  %buf = alloca [2 x i8], align 1
+  %0 = getelementptr inbounds [2 x i8], [2 x i8]* %buf, i64 0, i64 0
+  %1 = getelementptr inbounds [2 x i8], [2 x i8]* %buf, i64 0, i64 1
+  %rd0 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %0, i64 0, i64 1)
+  %type = load i8, i8* %0, align 1
+  switch i8 %type, label %cold [
+    i8 8, label %hot
+    i8 6, label %warm
+  ], !prof !1
+
+hot:                                              ; preds = %entry
+  %rd1 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %1, i64 1, i64 1)
+  br label %exit
+
+warm:                                             ; preds = %entry
+  %rd2 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %1, i64 2, i64 1)
+  br label %exit
+
+cold:                                             ; preds = %entry
+  %rd3 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %1, i64 3, i64 1)
+  %is_zero = icmp eq i8 %type, 0
+  br i1 %is_zero, label %drop, label %exit, !prof !2
+
+drop:                                             ; preds = %cold
+  ret i32 1
+
+exit:                                             ; preds = %cold, %warm, %hot
+  %wr = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %1, i64 4, i64 1)
+  ret i32 0
+}
+
+define dso_local void @nanotube_setup() {
+entry:
+  %context = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_add_plain_packet_kernel(i8* getelementptr inbounds ([7 x i8], [7 x i8]* @.str, i64 0, i64 0), i32 (%struct.nanotube_context*, %struct.nanotube_packet*)* @kernel, i32 0, i32 1)
+  ret void
+}
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_packet_write(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare %struct.nanotube_context* @nanotube_context_create()
+
+declare void @nanotube_add_plain_packet_kernel(i8*, i32 (%struct.nanotube_context*, %struct.nanotube_packet*)*, i32, i32)
+
+!0 = !{!"function_entry_count", i64 1000}
+!1 = !{!"branch_weights", i32 4, i32 900, i32 96}
+!2 = !{!"branch_weights", i32 0, i32 4}
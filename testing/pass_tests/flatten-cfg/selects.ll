@@ -0,0 +1,54 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; A select on an arm of a select with the same condition looks through
+; the inner select.  The select with the inverted condition and swapped
+; inputs is merged with the first one and a select whose arms both
+; reduce to the same value collapses.
+source_filename = "testing/pass_tests/flatten-cfg/selects.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+@.str = private unnamed_addr constant [7 x i8] c"kernel\00", align 1
+
+define dso_local i32 @kernel(%struct.nanotube_context* %context, %struct.nanotube_packet* %packet) {
+entry:
+  %buf = alloca [2 x i8], align 1
+  %out = alloca i8, align 1
+  %0 = getelementptr inbounds [2 x i8], [2 x i8]* %buf, i64 0, i64 0
+  %1 = getelementptr inbounds [2 x i8], [2 x i8]* %buf, i64 0, i64 1
+  %rd = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %0, i64 0, i64 2)
+  %a = load i8, i8* %0, align 1
+  %b = load i8, i8* %1, align 1
+  %c = icmp eq i8 %a, 0
+  %not_c = xor i1 %c, true
+  %sel0 = select i1 %c, i8 %a, i8 %b
+  %sel1 = select i1 %c, i8 %sel0, i8 7
+  %sel2 = select i1 %not_c, i8 %b, i8 %a
+  %sel3 = select i1 %c, i8 %b, i8 %a
+  %sel4 = select i1 %c, i8 %sel3, i8 %sel0
+  %sum0 = add i8 %sel1, %sel2
+  %sum1 = add i8 %sum0, %sel4
+  store i8 %sum1, i8* %out, align 1
+  %wr = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %out, i64 2, i64 1)
+  ret i32 0
+}
+
+define dso_local void @nanotube_setup() {
+entry:
+  %context = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_add_plain_packet_kernel(i8* getelementptr inbounds ([7 x i8], [7 x i8]* @.str, i64 0, i64 0), i32 (%struct.nanotube_context*, %struct.nanotube_packet*)* @kernel, i32 0, i32 1)
+  ret void
+}
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_packet_write(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare %struct.nanotube_context* @nanotube_context_create()
+
+declare void @nanotube_add_plain_packet_kernel(i8*, i32 (%struct.nanotube_context*, %struct.nanotube_packet*)*, i32, i32)
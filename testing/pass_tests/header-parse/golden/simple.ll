@@ -0,0 +1,74 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+source_filename = "testing/pass_tests/header-parse/simple.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+@0 = private unnamed_addr constant [7 x i8] c"kernel\00", align 1
+
+define void @nanotube_setup() {
+  call void @nanotube_add_plain_packet_kernel(i8* getelementptr inbounds ([7 x i8], [7 x i8]* @0, i32 0, i32 0), i32 (%struct.nanotube_context*, %struct.nanotube_packet*)* @kernel, i32 0, i32 1)
+  ret void
+}
+
+declare void @nanotube_add_plain_packet_kernel(i8*, i32 (%struct.nanotube_context*, %struct.nanotube_packet*)*, i32, i32)
+
+; Function Attrs: inaccessiblemem_or_argmemonly
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64) #0
+
+declare i64 @nanotube_packet_write_masked(%struct.nanotube_packet*, i8*, i8*, i64, i64)
+
+define i32 @kernel(%struct.nanotube_context* %ctx, %struct.nanotube_packet* %packet) {
+entry:
+  %header_buf = alloca i8, i32 78
+  %header_len = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %header_buf, i64 0, i64 78)
+  %eth_type = alloca [2 x i8], align 1
+  %ihl_byte = alloca i8, align 1
+  %ports = alloca [4 x i8], align 1
+  %tail = alloca i8, align 1
+  %mask = alloca i8, align 1
+  %eth_type.p = getelementptr inbounds [2 x i8], [2 x i8]* %eth_type, i64 0, i64 0
+  %0 = getelementptr inbounds i8, i8* %header_buf, i64 12
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* align 1 %eth_type.p, i8* align 1 %0, i64 2, i1 false)
+  %1 = getelementptr inbounds i8, i8* %header_buf, i64 14
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* align 1 %ihl_byte, i8* align 1 %1, i64 1, i1 false)
+  %ihl.b = load i8, i8* %ihl_byte, align 1
+  %ihl.m = and i8 %ihl.b, 15
+  %ihl = zext i8 %ihl.m to i64
+  %ip_len = shl i64 %ihl, 2
+  %l4_off = add i64 %ip_len, 14
+  %ports.p = getelementptr inbounds [4 x i8], [4 x i8]* %ports, i64 0, i64 0
+  %2 = getelementptr inbounds i8, i8* %header_buf, i64 %l4_off
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* align 1 %ports.p, i8* align 1 %2, i64 4, i1 false)
+  %3 = sub i64 %header_len, %l4_off
+  %4 = icmp slt i64 %3, 0
+  %5 = select i1 %4, i64 0, i64 %3
+  %6 = icmp sgt i64 %5, 4
+  %7 = select i1 %6, i64 4, i64 %5
+  %short = icmp ult i64 %7, 4
+  br i1 %short, label %drop, label %parse
+
+parse:                                            ; preds = %entry
+  %ptr.v = load i8, i8* %eth_type.p, align 1
+  %ptr.off = zext i8 %ptr.v to i64
+  %ptr.off2 = shl i64 %ptr.off, 8
+  %r3 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %tail, i64 %ptr.off2, i64 1)
+  store i8 -1, i8* %mask, align 1
+  %w0 = call i64 @nanotube_packet_write_masked(%struct.nanotube_packet* %packet, i8* %ihl_byte, i8* %mask, i64 15, i64 1)
+  %r4 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %tail, i64 15, i64 1)
+  ret i32 0
+
+drop:                                             ; preds = %entry
+  ret i32 1
+}
+
+; Function Attrs: argmemonly nounwind
+declare void @llvm.memcpy.p0i8.p0i8.i64(i8* nocapture writeonly, i8* nocapture readonly, i64, i1) #1
+
+attributes #0 = { inaccessiblemem_or_argmemonly }
+attributes #1 = { argmemonly nounwind }
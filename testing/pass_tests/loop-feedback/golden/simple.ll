@@ -0,0 +1,135 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+source_filename = "simple.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_channel = type opaque
+%struct.nanotube_context = type opaque
+
+@0 = private unnamed_addr constant [6 x i8] c"words\00", align 1
+@1 = private unnamed_addr constant [5 x i8] c"sums\00", align 1
+@2 = private unnamed_addr constant [8 x i8] c"stage_0\00", align 1
+@3 = private unnamed_addr constant [14 x i8] c"stage_0_loop0\00", align 1
+
+define void @nanotube_setup() {
+entry:
+  %words = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([6 x i8], [6 x i8]* @0, i32 0, i32 0), i64 8, i64 4)
+  %sums = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([5 x i8], [5 x i8]* @1, i32 0, i32 0), i64 4, i64 4)
+  call void @nanotube_channel_export(%struct.nanotube_channel* %words, i32 1, i32 2)
+  call void @nanotube_channel_export(%struct.nanotube_channel* %sums, i32 1, i32 1)
+  %context0 = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context0, i32 0, %struct.nanotube_channel* %words, i32 1)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context0, i32 1, %struct.nanotube_channel* %sums, i32 2)
+  %stage_0_loop0 = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([14 x i8], [14 x i8]* @3, i32 0, i32 0), i64 20, i64 1)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context0, i32 2, %struct.nanotube_channel* %stage_0_loop0, i32 1)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context0, i32 3, %struct.nanotube_channel* %stage_0_loop0, i32 2)
+  call void @nanotube_thread_create(%struct.nanotube_context* %context0, i8* getelementptr inbounds ([8 x i8], [8 x i8]* @2, i32 0, i32 0), void (%struct.nanotube_context*, i8*)* @stage_0, i8* null, i64 0)
+  ret void
+}
+
+define void @stage_0(%struct.nanotube_context* %ctx, i8* %arg) #0 {
+loop_dispatch:
+  %word = alloca [8 x i8], align 1
+  %sum = alloca i32, align 4
+  %word.p = getelementptr inbounds [8 x i8], [8 x i8]* %word, i64 0, i64 0
+  %end = getelementptr inbounds [8 x i8], [8 x i8]* %word, i64 1, i64 0
+  %p.i.offset.reg2mem = alloca i64
+  %loop_state = alloca [20 x i8]
+  %0 = bitcast [20 x i8]* %loop_state to i8*
+  %read_loop_state = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %ctx, i32 2, i8* %0, i64 20)
+  %have_loop_state = icmp ne i32 %read_loop_state, 0
+  br i1 %have_loop_state, label %loop_resume, label %entry
+
+loop_resume:                                      ; preds = %loop_dispatch
+  %1 = getelementptr inbounds i8, i8* %0, i64 0
+  %2 = bitcast [8 x i8]* %word to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* align 1 %2, i8* align 1 %1, i64 8, i1 false)
+  %3 = getelementptr inbounds i8, i8* %0, i64 8
+  %4 = bitcast i32* %sum to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* align 1 %4, i8* align 1 %3, i64 4, i1 false)
+  %5 = getelementptr inbounds i8, i8* %0, i64 12
+  %6 = bitcast i64* %p.i.offset.reg2mem to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* align 1 %6, i8* align 1 %5, i64 8, i1 false)
+  br label %loop.i
+
+entry:                                            ; preds = %loop_dispatch
+  %rd = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %ctx, i32 0, i8* %word.p, i64 8)
+  %fail = icmp eq i32 %rd, 0
+  br i1 %fail, label %wait, label %body
+
+wait:                                             ; preds = %entry
+  call void @nanotube_thread_wait()
+  ret void
+
+body:                                             ; preds = %entry
+  %first = load i8, i8* %word.p, align 1
+  %first.ext = zext i8 %first to i64
+  %start.idx = and i64 %first.ext, 7
+  %start = getelementptr inbounds [8 x i8], [8 x i8]* %word, i64 0, i64 %start.idx
+  store i32 0, i32* %sum, align 4
+  %7 = ptrtoint i8* %start to i64
+  %8 = ptrtoint [8 x i8]* %word to i64
+  %start.offset = sub i64 %7, %8
+  store i64 %start.offset, i64* %p.i.offset.reg2mem
+  br label %loop.i
+
+loop.i:                                           ; preds = %loop_resume, %body
+  %p.i.offset.reload = load i64, i64* %p.i.offset.reg2mem
+  %9 = bitcast [8 x i8]* %word to i8*
+  %10 = getelementptr inbounds i8, i8* %9, i64 %p.i.offset.reload
+  %b.i = load i8, i8* %10, align 1
+  %b.ext.i = zext i8 %b.i to i32
+  %old.i = load i32, i32* %sum, align 4
+  %new.i = add i32 %old.i, %b.ext.i
+  store i32 %new.i, i32* %sum, align 4
+  %p.next.i = getelementptr inbounds i8, i8* %10, i64 1
+  %more.i = icmp ult i8* %p.next.i, %end
+  %11 = ptrtoint i8* %p.next.i to i64
+  %12 = ptrtoint [8 x i8]* %word to i64
+  %p.next.i.offset = sub i64 %11, %12
+  store i64 %p.next.i.offset, i64* %p.i.offset.reg2mem
+  br i1 %more.i, label %loop_iterate, label %stage_0.loop0.exit
+
+stage_0.loop0.exit:                               ; preds = %loop.i
+  %sum.p = bitcast i32* %sum to i8*
+  call void @nanotube_channel_write(%struct.nanotube_context* %ctx, i32 1, i8* %sum.p, i64 4)
+  ret void
+
+loop_iterate:                                     ; preds = %loop.i
+  %13 = getelementptr inbounds i8, i8* %0, i64 0
+  %14 = bitcast [8 x i8]* %word to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* align 1 %13, i8* align 1 %14, i64 8, i1 false)
+  %15 = getelementptr inbounds i8, i8* %0, i64 8
+  %16 = bitcast i32* %sum to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* align 1 %15, i8* align 1 %16, i64 4, i1 false)
+  %17 = getelementptr inbounds i8, i8* %0, i64 12
+  %18 = bitcast i64* %p.i.offset.reg2mem to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* align 1 %17, i8* align 1 %18, i64 8, i1 false)
+  call void @nanotube_channel_write(%struct.nanotube_context* %ctx, i32 3, i8* %0, i64 20)
+  ret void
+}
+
+declare %struct.nanotube_channel* @nanotube_channel_create(i8*, i64, i64)
+
+declare void @nanotube_channel_export(%struct.nanotube_channel*, i32, i32)
+
+declare %struct.nanotube_context* @nanotube_context_create()
+
+declare void @nanotube_context_add_channel(%struct.nanotube_context*, i32, %struct.nanotube_channel*, i32)
+
+declare void @nanotube_thread_create(%struct.nanotube_context*, i8*, void (%struct.nanotube_context*, i8*)*, i8*, i64)
+
+declare i32 @nanotube_channel_try_read(%struct.nanotube_context*, i32, i8*, i64)
+
+declare void @nanotube_channel_write(%struct.nanotube_context*, i32, i8*, i64)
+
+declare void @nanotube_thread_wait()
+
+; Function Attrs: argmemonly nounwind
+declare void @llvm.memcpy.p0i8.p0i8.i64(i8* nocapture writeonly, i8* nocapture readonly, i64, i1) #1
+
+attributes #0 = { "nanotube_loop_max_trips"="8" }
+attributes #1 = { argmemonly nounwind }
@@ -0,0 +1,95 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; A pipeline stage which calls a loop outlined by the outline-loops
+; pass.  The loop walks a pointer which starts at a variable offset into
+; the input word, so the pointer has to be carried in the loop state as
+; an offset from the stack allocation.
+;
+source_filename = "simple.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_channel = type opaque
+%struct.nanotube_context = type opaque
+
+@0 = private unnamed_addr constant [6 x i8] c"words\00", align 1
+@1 = private unnamed_addr constant [5 x i8] c"sums\00", align 1
+@2 = private unnamed_addr constant [8 x i8] c"stage_0\00", align 1
+
+define void @nanotube_setup() {
+entry:
+  %words = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([6 x i8], [6 x i8]* @0, i32 0, i32 0), i64 8, i64 4)
+  %sums = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([5 x i8], [5 x i8]* @1, i32 0, i32 0), i64 4, i64 4)
+  call void @nanotube_channel_export(%struct.nanotube_channel* %words, i32 1, i32 2)
+  call void @nanotube_channel_export(%struct.nanotube_channel* %sums, i32 1, i32 1)
+  %context0 = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context0, i32 0, %struct.nanotube_channel* %words, i32 1)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context0, i32 1, %struct.nanotube_channel* %sums, i32 2)
+  call void @nanotube_thread_create(%struct.nanotube_context* %context0, i8* getelementptr inbounds ([8 x i8], [8 x i8]* @2, i32 0, i32 0), void (%struct.nanotube_context*, i8*)* @stage_0, i8* null, i64 0)
+  ret void
+}
+
+define void @stage_0(%struct.nanotube_context* %ctx, i8* %arg) {
+entry:
+  %word = alloca [8 x i8], align 1
+  %sum = alloca i32, align 4
+  %word.p = getelementptr inbounds [8 x i8], [8 x i8]* %word, i64 0, i64 0
+  %rd = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %ctx, i32 0, i8* %word.p, i64 8)
+  %fail = icmp eq i32 %rd, 0
+  br i1 %fail, label %wait, label %body
+
+wait:
+  call void @nanotube_thread_wait()
+  ret void
+
+body:
+  %first = load i8, i8* %word.p, align 1
+  %first.ext = zext i8 %first to i64
+  %start.idx = and i64 %first.ext, 7
+  %start = getelementptr inbounds [8 x i8], [8 x i8]* %word, i64 0, i64 %start.idx
+  %end = getelementptr inbounds [8 x i8], [8 x i8]* %word, i64 1, i64 0
+  store i32 0, i32* %sum, align 4
+  call void @stage_0.loop0(i8* %start, i8* %end, i32* %sum)
+  %sum.p = bitcast i32* %sum to i8*
+  call void @nanotube_channel_write(%struct.nanotube_context* %ctx, i32 1, i8* %sum.p, i64 4)
+  ret void
+}
+
+define internal void @stage_0.loop0(i8* %start, i8* %end, i32* %sum) #0 {
+newFuncRoot:
+  br label %loop
+
+loop:
+  %p = phi i8* [ %start, %newFuncRoot ], [ %p.next, %loop ]
+  %b = load i8, i8* %p, align 1
+  %b.ext = zext i8 %b to i32
+  %old = load i32, i32* %sum, align 4
+  %new = add i32 %old, %b.ext
+  store i32 %new, i32* %sum, align 4
+  %p.next = getelementptr inbounds i8, i8* %p, i64 1
+  %more = icmp ult i8* %p.next, %end
+  br i1 %more, label %loop, label %exit
+
+exit:
+  ret void
+}
+
+declare %struct.nanotube_channel* @nanotube_channel_create(i8*, i64, i64)
+
+declare void @nanotube_channel_export(%struct.nanotube_channel*, i32, i32)
+
+declare %struct.nanotube_context* @nanotube_context_create()
+
+declare void @nanotube_context_add_channel(%struct.nanotube_context*, i32, %struct.nanotube_channel*, i32)
+
+declare void @nanotube_thread_create(%struct.nanotube_context*, i8*, void (%struct.nanotube_context*, i8*)*, i8*, i64)
+
+declare i32 @nanotube_channel_try_read(%struct.nanotube_context*, i32, i8*, i64)
+
+declare void @nanotube_channel_write(%struct.nanotube_context*, i32, i8*, i64)
+
+declare void @nanotube_thread_wait()
+
+attributes #0 = { argmemonly noinline "nanotube_loop_max_trips"="8" }
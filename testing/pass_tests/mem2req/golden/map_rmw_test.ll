@@ -0,0 +1,107 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+source_filename = "testing/pass_tests/mem2req/map_rmw_test.cpp"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+; Function Attrs: uwtable
+define dso_local i32 @_Z12map_rmw_testP16nanotube_contextP15nanotube_packet(%struct.nanotube_context* %nt_ctx, %struct.nanotube_packet* nocapture readnone %packet) local_unnamed_addr #0 {
+entry:
+  %rmw_mask = alloca i8
+  %_buffer7 = alloca i64
+  %0 = bitcast i64* %_buffer7 to i8*
+  %_buffer6 = alloca i64
+  %1 = bitcast i64* %_buffer6 to i8*
+  %key_copy3 = alloca i8, i64 1
+  %dummy_rd_data4 = alloca i8
+  %_buffer2 = alloca i32
+  %2 = bitcast i32* %_buffer2 to i8*
+  %_old_buffer = alloca i32
+  %3 = bitcast i32* %_old_buffer to i8*
+  %_buffer1 = alloca i32
+  %4 = bitcast i32* %_buffer1 to i8*
+  %_buffer = alloca i32
+  %5 = bitcast i32* %_buffer to i8*
+  %key_copy = alloca i8, i64 1
+  %dummy_rd_data = alloca i8
+  %key = alloca i8, align 1
+  call void @llvm.lifetime.start.p0i8(i64 1, i8* nonnull %key) #4
+  store i8 0, i8* %key, align 1, !tbaa !4
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %key_copy3, i8* %key, i64 1, i1 false)
+  %key_check5 = call i64 @nanotube_map_read(%struct.nanotube_context* %nt_ctx, i16 0, i8* %key_copy3, i64 1, i8* %dummy_rd_data4, i64 0, i64 1)
+  %6 = icmp eq i64 %key_check5, 0
+  br i1 %6, label %if.end, label %if.then
+
+if.then:                                          ; preds = %entry
+  store i64 1, i64* %_buffer6
+  call void @llvm.memset.p0i8.i64(i8* %rmw_mask, i8 -1, i64 1, i1 false)
+  %7 = call i64 @nanotube_map_op(%struct.nanotube_context* %nt_ctx, i16 0, i32 6, i8* %key_copy3, i64 1, i8* %1, i8* null, i8* %rmw_mask, i64 0, i64 8)
+  br label %if.end
+
+if.end:                                           ; preds = %if.then, %entry
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %key_copy, i8* %key, i64 1, i1 false)
+  %key_check = call i64 @nanotube_map_read(%struct.nanotube_context* %nt_ctx, i16 1, i8* %key_copy, i64 1, i8* %dummy_rd_data, i64 0, i64 1)
+  %8 = icmp eq i64 %key_check, 0
+  br i1 %8, label %if.end7, label %if.then3
+
+if.then3:                                         ; preds = %if.end
+  %9 = call i64 @nanotube_map_read(%struct.nanotube_context* %nt_ctx, i16 1, i8* %key_copy, i64 1, i8* %3, i64 4, i64 4)
+  %10 = load i32, i32* %_old_buffer
+  %11 = add i32 %10, 64
+  store i32 %11, i32* %_buffer2
+  %12 = call i64 @nanotube_map_write(%struct.nanotube_context* %nt_ctx, i16 1, i8* %key_copy, i64 1, i8* %2, i64 4, i64 4)
+  %13 = call i64 @nanotube_map_read(%struct.nanotube_context* %nt_ctx, i16 1, i8* %key_copy, i64 1, i8* %4, i64 0, i64 4)
+  %14 = load i32, i32* %_buffer1
+  %add6 = add i32 %14, 1
+  store i32 %add6, i32* %_buffer
+  %15 = call i64 @nanotube_map_write(%struct.nanotube_context* %nt_ctx, i16 1, i8* %key_copy, i64 1, i8* %5, i64 0, i64 4)
+  br label %if.end7
+
+if.end7:                                          ; preds = %if.then3, %if.end
+  call void @llvm.lifetime.end.p0i8(i64 1, i8* nonnull %key) #4
+  ret i32 0
+}
+
+; Function Attrs: argmemonly nounwind
+declare void @llvm.lifetime.start.p0i8(i64, i8* nocapture) #1
+
+declare dso_local i8* @nanotube_map_lookup(%struct.nanotube_context*, i16 zeroext, i8*, i64, i64) local_unnamed_addr #2
+
+; Function Attrs: argmemonly nounwind
+declare void @llvm.lifetime.end.p0i8(i64, i8* nocapture) #1
+
+; Function Attrs: argmemonly nounwind
+declare void @llvm.memcpy.p0i8.p0i8.i64(i8* nocapture writeonly, i8* nocapture readonly, i64, i1) #1
+
+; Function Attrs: inaccessiblemem_or_argmemonly
+declare i64 @nanotube_map_read(%struct.nanotube_context*, i16, i8*, i64, i8*, i64, i64) #3
+
+; Function Attrs: inaccessiblemem_or_argmemonly
+declare i64 @nanotube_map_write(%struct.nanotube_context*, i16, i8*, i64, i8*, i64, i64) #3
+
+; Function Attrs: argmemonly nounwind
+declare void @llvm.memset.p0i8.i64(i8* nocapture writeonly, i8, i64, i1) #1
+
+declare i64 @nanotube_map_op(%struct.nanotube_context*, i16, i32, i8*, i64, i8*, i8*, i8*, i64, i64)
+
+attributes #0 = { uwtable "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "less-precise-fpmad"="false" "min-legal-vector-width"="0" "no-frame-pointer-elim"="false" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "no-trapping-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #1 = { argmemonly nounwind }
+attributes #2 = { "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="false" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "no-trapping-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #3 = { inaccessiblemem_or_argmemonly }
+attributes #4 = { nounwind }
+
+!llvm.module.flags = !{!0, !1, !2}
+!llvm.ident = !{!3}
+
+!0 = !{i32 2, !"Dwarf Version", i32 4}
+!1 = !{i32 2, !"Debug Info Version", i32 3}
+!2 = !{i32 1, !"wchar_size", i32 4}
+!3 = !{!"clang version 8.0.0 "}
+!4 = !{!5, !5, i64 0}
+!5 = !{!"omnipotent char", !6, i64 0}
+!6 = !{!"Simple C++ TBAA"}
@@ -0,0 +1,65 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+source_filename = "testing/pass_tests/mem2req/packet_loop_test.cpp"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+; Function Attrs: uwtable
+define dso_local i32 @_Z16packet_loop_testP16nanotube_contextP15nanotube_packet(%struct.nanotube_context* nocapture readnone %nt_ctx, %struct.nanotube_packet* %packet) local_unnamed_addr #0 {
+entry:
+  %_buffer1 = alloca i8
+  %_buffer = alloca i8
+  %0 = call i64 @nanotube_packet_bounded_length(%struct.nanotube_packet* %packet, i64 32767)
+  %sub.ptr.sub = sub i64 %0, 0
+  %cmp = icmp slt i64 %sub.ptr.sub, 9
+  br i1 %cmp, label %return, label %for.body.preheader
+
+for.body.preheader:                               ; preds = %entry
+  br label %for.body
+
+for.body:                                         ; preds = %for.body, %for.body.preheader
+  %i = phi i32 [ %inc, %for.body ], [ 0, %for.body.preheader ]
+  %sum = phi i8 [ %add, %for.body ], [ 0, %for.body.preheader ]
+  %1 = phi i64 [ %4, %for.body ], [ 1, %for.body.preheader ]
+  %2 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %_buffer1, i64 %1, i64 1)
+  %3 = load i8, i8* %_buffer1
+  %add = add i8 %3, %sum
+  %4 = add i64 %1, 1
+  %5 = inttoptr i64 %4 to i8*
+  %inc = add nuw nsw i32 %i, 1
+  %exitcond = icmp eq i32 %inc, 8
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:                                          ; preds = %for.body
+  store i8 %add, i8* %_buffer
+  %6 = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %_buffer, i64 0, i64 1)
+  br label %return
+
+return:                                           ; preds = %for.end, %entry
+  %retval = phi i32 [ 0, %for.end ], [ -1, %entry ]
+  ret i32 %retval
+}
+
+declare dso_local i8* @nanotube_packet_data(%struct.nanotube_packet*) local_unnamed_addr #1
+
+declare dso_local i8* @nanotube_packet_end(%struct.nanotube_packet*) local_unnamed_addr #1
+
+declare i64 @nanotube_packet_bounded_length(%struct.nanotube_packet*, i64)
+
+declare i64 @nanotube_packet_write(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+attributes #0 = { uwtable "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "less-precise-fpmad"="false" "min-legal-vector-width"="0" "no-frame-pointer-elim"="false" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "no-trapping-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #1 = { "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="false" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "no-trapping-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+
+!llvm.module.flags = !{!0}
+!llvm.ident = !{!1}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{!"clang version 8.0.0 "}
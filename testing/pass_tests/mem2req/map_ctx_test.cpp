@@ -0,0 +1,33 @@
+/*******************************************************/
+/*! \file  map_ctx_test.cpp
+**  \brief Test mem2req conversion of map accesses when the context is
+**         not the first function argument.
+*//******************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+#include <stdint.h>
+#include "nanotube_api.h"
+
+int map_ctx_test(nanotube_packet_t *packet,
+                 nanotube_context_t *nt_ctx)
+{
+  uint8_t key = 0;
+
+  /* An update of the whole value becomes a single map operation */
+  uint64_t* total = (uint64_t*)
+    nanotube_map_lookup(nt_ctx, 0, &key, sizeof(key), sizeof(uint64_t));
+  if( total != NULL )
+    *total += 1;
+
+  /* So does an atomic update */
+  uint32_t* bytes = (uint32_t*)
+    nanotube_map_lookup(nt_ctx, 1, &key, sizeof(key), sizeof(uint32_t));
+  if( bytes != NULL )
+    __atomic_fetch_add(bytes, 64, __ATOMIC_RELAXED);
+  return 0;
+}
+
+/* vim: set ts=8 et sw=2 sts=2 tw=75: */
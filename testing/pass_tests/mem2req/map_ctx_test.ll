@@ -0,0 +1,69 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; ModuleID = 'build/testing/pass_tests/mem2req/map_ctx_test.bc'
+source_filename = "testing/pass_tests/mem2req/map_ctx_test.cpp"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+; Function Attrs: uwtable
+define dso_local i32 @_Z12map_ctx_testP15nanotube_packetP16nanotube_context(%struct.nanotube_packet* nocapture readnone %packet, %struct.nanotube_context* %nt_ctx) local_unnamed_addr #0 {
+entry:
+  %key = alloca i8, align 1
+  call void @llvm.lifetime.start.p0i8(i64 1, i8* nonnull %key) #3
+  store i8 0, i8* %key, align 1, !tbaa !4
+  %call = call i8* @nanotube_map_lookup(%struct.nanotube_context* %nt_ctx, i16 zeroext 0, i8* nonnull %key, i64 1, i64 8)
+  %cmp = icmp eq i8* %call, null
+  br i1 %cmp, label %if.end, label %if.then
+
+if.then:                                          ; preds = %entry
+  %0 = bitcast i8* %call to i64*
+  %1 = load i64, i64* %0, align 8, !tbaa !7
+  %add = add i64 %1, 1
+  store i64 %add, i64* %0, align 8, !tbaa !7
+  br label %if.end
+
+if.end:                                           ; preds = %if.then, %entry
+  %call1 = call i8* @nanotube_map_lookup(%struct.nanotube_context* %nt_ctx, i16 zeroext 1, i8* nonnull %key, i64 1, i64 4)
+  %cmp2 = icmp eq i8* %call1, null
+  br i1 %cmp2, label %if.end5, label %if.then3
+
+if.then3:                                         ; preds = %if.end
+  %2 = bitcast i8* %call1 to i32*
+  %3 = atomicrmw add i32* %2, i32 64 monotonic
+  br label %if.end5
+
+if.end5:                                          ; preds = %if.then3, %if.end
+  call void @llvm.lifetime.end.p0i8(i64 1, i8* nonnull %key) #3
+  ret i32 0
+}
+
+; Function Attrs: argmemonly nounwind
+declare void @llvm.lifetime.start.p0i8(i64, i8* nocapture) #1
+
+declare dso_local i8* @nanotube_map_lookup(%struct.nanotube_context*, i16 zeroext, i8*, i64, i64) local_unnamed_addr #2
+
+; Function Attrs: argmemonly nounwind
+declare void @llvm.lifetime.end.p0i8(i64, i8* nocapture) #1
+
+attributes #0 = { uwtable "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "less-precise-fpmad"="false" "min-legal-vector-width"="0" "no-frame-pointer-elim"="false" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "no-trapping-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #1 = { argmemonly nounwind }
+attributes #2 = { "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="false" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "no-trapping-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #3 = { nounwind }
+
+!llvm.module.flags = !{!0, !1, !2}
+!llvm.ident = !{!3}
+
+!0 = !{i32 2, !"Dwarf Version", i32 4}
+!1 = !{i32 2, !"Debug Info Version", i32 3}
+!2 = !{i32 1, !"wchar_size", i32 4}
+!3 = !{!"clang version 8.0.0 "}
+!4 = !{!5, !5, i64 0}
+!5 = !{!"omnipotent char", !6, i64 0}
+!6 = !{!"Simple C++ TBAA"}
+!7 = !{!8, !8, i64 0}
+!8 = !{!"long", !5, i64 0}
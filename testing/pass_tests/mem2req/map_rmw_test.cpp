@@ -0,0 +1,40 @@
+/*******************************************************/
+/*! \file  map_rmw_test.cpp
+**  \brief Test mem2req conversion of map value updates.
+*//******************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+#include <stdint.h>
+#include "nanotube_api.h"
+
+struct counters {
+  uint32_t packets;
+  uint32_t bytes;
+};
+
+int map_rmw_test(nanotube_context_t *nt_ctx,
+                 nanotube_packet_t *packet)
+{
+  uint8_t key = 0;
+
+  /* Updates of the whole value become a single map operation */
+  uint64_t* total = (uint64_t*)
+    nanotube_map_lookup(nt_ctx, 0, &key, sizeof(key), sizeof(uint64_t));
+  if( total != NULL )
+    *total += 1;
+
+  /* Updates of single fields stay a map read and a map write */
+  struct counters* c = (struct counters*)
+    nanotube_map_lookup(nt_ctx, 1, &key, sizeof(key),
+                        sizeof(struct counters));
+  if( c != NULL ) {
+    __atomic_fetch_add(&c->bytes, 64, __ATOMIC_RELAXED);
+    c->packets += 1;
+  }
+  return 0;
+}
+
+/* vim: set ts=8 et sw=2 sts=2 tw=75: */
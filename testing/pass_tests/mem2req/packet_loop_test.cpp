@@ -0,0 +1,34 @@
+/*******************************************************/
+/*! \file  packet_loop_test.cpp
+**  \brief Test mem2req conversion of a packet pointer carried around
+**         a loop.
+*//******************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+#include <stdint.h>
+#include "nanotube_api.h"
+
+int packet_loop_test(nanotube_context_t *nt_ctx,
+                     nanotube_packet_t *packet)
+{
+  uint8_t* data = nanotube_packet_data(packet);
+  uint8_t* end  = nanotube_packet_end(packet);
+
+  if( end - data < 9 )
+    return -1;
+
+  /* The pointer is incremented on the back edge of the loop. */
+  uint8_t* p = data + 1;
+  uint8_t sum = 0;
+  for( unsigned i = 0; i < 8; i++ ) {
+    sum += *p;
+    p++;
+  }
+  data[0] = sum;
+  return 0;
+}
+
+/* vim: set ts=8 et sw=2 sts=2 tw=75: */
@@ -0,0 +1,62 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; ModuleID = 'build/testing/pass_tests/mem2req/packet_loop_test.bc'
+source_filename = "testing/pass_tests/mem2req/packet_loop_test.cpp"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+; Function Attrs: uwtable
+define dso_local i32 @_Z16packet_loop_testP16nanotube_contextP15nanotube_packet(%struct.nanotube_context* nocapture readnone %nt_ctx, %struct.nanotube_packet* %packet) local_unnamed_addr #0 {
+entry:
+  %call = tail call i8* @nanotube_packet_data(%struct.nanotube_packet* %packet)
+  %call1 = tail call i8* @nanotube_packet_end(%struct.nanotube_packet* %packet)
+  %sub.ptr.lhs.cast = ptrtoint i8* %call1 to i64
+  %sub.ptr.rhs.cast = ptrtoint i8* %call to i64
+  %sub.ptr.sub = sub i64 %sub.ptr.lhs.cast, %sub.ptr.rhs.cast
+  %cmp = icmp slt i64 %sub.ptr.sub, 9
+  br i1 %cmp, label %return, label %for.body.preheader
+
+for.body.preheader:                               ; preds = %entry
+  %add.ptr = getelementptr inbounds i8, i8* %call, i64 1
+  br label %for.body
+
+for.body:                                         ; preds = %for.body.preheader, %for.body
+  %i = phi i32 [ %inc, %for.body ], [ 0, %for.body.preheader ]
+  %sum = phi i8 [ %add, %for.body ], [ 0, %for.body.preheader ]
+  %p = phi i8* [ %incdec.ptr, %for.body ], [ %add.ptr, %for.body.preheader ]
+  %0 = load i8, i8* %p, align 1, !tbaa !2
+  %add = add i8 %0, %sum
+  %incdec.ptr = getelementptr inbounds i8, i8* %p, i64 1
+  %inc = add nuw nsw i32 %i, 1
+  %exitcond = icmp eq i32 %inc, 8
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:                                          ; preds = %for.body
+  store i8 %add, i8* %call, align 1, !tbaa !2
+  br label %return
+
+return:                                           ; preds = %entry, %for.end
+  %retval = phi i32 [ 0, %for.end ], [ -1, %entry ]
+  ret i32 %retval
+}
+
+declare dso_local i8* @nanotube_packet_data(%struct.nanotube_packet*) local_unnamed_addr #1
+
+declare dso_local i8* @nanotube_packet_end(%struct.nanotube_packet*) local_unnamed_addr #1
+
+attributes #0 = { uwtable "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "less-precise-fpmad"="false" "min-legal-vector-width"="0" "no-frame-pointer-elim"="false" "no-infs-fp-math"="false" "no-jump-tables"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "no-trapping-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+attributes #1 = { "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "less-precise-fpmad"="false" "no-frame-pointer-elim"="false" "no-infs-fp-math"="false" "no-nans-fp-math"="false" "no-signed-zeros-fp-math"="false" "no-trapping-math"="false" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+fxsr,+mmx,+sse,+sse2,+x87" "unsafe-fp-math"="false" "use-soft-float"="false" }
+
+!llvm.module.flags = !{!0}
+!llvm.ident = !{!1}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{!"clang version 8.0.0 "}
+!2 = !{!3, !3, i64 0}
+!3 = !{!"omnipotent char", !4, i64 0}
+!4 = !{!"Simple C++ TBAA"}
@@ -0,0 +1,11 @@
+# Edge counts for simple.ll, in the format written by the test harness
+# with --profile-out.
+#
+# <function> <block index> <successor index> <count>
+kernel 0 0 4
+kernel 0 1 900
+kernel 0 2 96
+kernel 1 0 900
+kernel 2 0 96
+kernel 3 1 4
+kernel 5 0 1000
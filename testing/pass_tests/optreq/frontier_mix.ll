@@ -0,0 +1,55 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Packet reads and writes are interleaved.  The frontier of %W1 passes
+; the read %R1 of bytes it does not write and mops up %W2.  It is
+; blocked by the read %R2 of a byte written by %W1.  The writes %W3 and
+; %W4 after the read are merged at the end of the function.
+;
+; OPTIONS = -optreq-frontier
+source_filename = "testing/pass_tests/optreq/frontier_mix.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+@.str = private unnamed_addr constant [7 x i8] c"kernel\00", align 1
+
+define dso_local i32 @kernel(%struct.nanotube_context* %context, %struct.nanotube_packet* %packet) {
+entry:
+  %buf = alloca [8 x i8], align 1
+  %maskbuf = alloca [1 x i8], align 1
+  %rbuf = alloca [2 x i8], align 1
+  %0 = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 0
+  %1 = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 2
+  %2 = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 4
+  %3 = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 6
+  %4 = getelementptr inbounds [2 x i8], [2 x i8]* %rbuf, i64 0, i64 0
+  %5 = getelementptr inbounds [2 x i8], [2 x i8]* %rbuf, i64 0, i64 1
+  %mask = getelementptr inbounds [1 x i8], [1 x i8]* %maskbuf, i64 0, i64 0
+  store i8 3, i8* %mask, align 1
+  %W1 = call i64 @nanotube_packet_write_masked(%struct.nanotube_packet* %packet, i8* %0, i8* %mask, i64 0, i64 2)
+  %R1 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %4, i64 8, i64 1)
+  %W2 = call i64 @nanotube_packet_write_masked(%struct.nanotube_packet* %packet, i8* %1, i8* %mask, i64 2, i64 2)
+  %R2 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %5, i64 1, i64 1)
+  %W3 = call i64 @nanotube_packet_write_masked(%struct.nanotube_packet* %packet, i8* %2, i8* %mask, i64 4, i64 2)
+  %W4 = call i64 @nanotube_packet_write_masked(%struct.nanotube_packet* %packet, i8* %3, i8* %mask, i64 6, i64 2)
+  ret i32 0
+}
+
+define dso_local void @nanotube_setup() {
+entry:
+  %context = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_add_plain_packet_kernel(i8* getelementptr inbounds ([7 x i8], [7 x i8]* @.str, i64 0, i64 0), i32 (%struct.nanotube_context*, %struct.nanotube_packet*)* @kernel, i32 0, i32 1)
+  ret void
+}
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_packet_write_masked(%struct.nanotube_packet*, i8*, i8*, i64, i64)
+
+declare %struct.nanotube_context* @nanotube_context_create()
+
+declare void @nanotube_add_plain_packet_kernel(i8*, i32 (%struct.nanotube_context*, %struct.nanotube_packet*)*, i32, i32)
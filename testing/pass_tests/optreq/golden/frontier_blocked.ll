@@ -0,0 +1,74 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+source_filename = "testing/pass_tests/optreq/frontier_blocked.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+@.str = private unnamed_addr constant [7 x i8] c"kernel\00", align 1
+
+define dso_local i32 @kernel(%struct.nanotube_context* %context, %struct.nanotube_packet* %packet) {
+entry:
+  %write_mask_off0 = alloca i8
+  call void @llvm.memset.p0i8.i64(i8* %write_mask_off0, i8 0, i64 1, i1 false)
+  %nanotube_packet_write_masked_buf_off0 = alloca i8, i32 4
+  %write_mask_off4 = alloca i8
+  call void @llvm.memset.p0i8.i64(i8* %write_mask_off4, i8 0, i64 1, i1 false)
+  %nanotube_packet_write_masked_buf_off4 = alloca i8, i32 4
+  %buf = alloca [8 x i8], align 1
+  %maskbuf = alloca [1 x i8], align 1
+  %0 = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 0
+  %1 = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 2
+  %2 = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 4
+  %3 = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 6
+  %4 = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 7
+  %mask = getelementptr inbounds [1 x i8], [1 x i8]* %maskbuf, i64 0, i64 0
+  store i8 3, i8* %mask, align 1
+  call void @nanotube_merge_data_mask(i8* %nanotube_packet_write_masked_buf_off0, i8* %write_mask_off0, i8* %0, i8* %mask, i64 0, i64 2)
+  call void @nanotube_merge_data_mask(i8* %nanotube_packet_write_masked_buf_off0, i8* %write_mask_off0, i8* %1, i8* %mask, i64 2, i64 2)
+  %type = load i8, i8* %4, align 1
+  %is_zero = icmp eq i8 %type, 0
+  %5 = call i64 @nanotube_packet_write_masked(%struct.nanotube_packet* %packet, i8* %nanotube_packet_write_masked_buf_off0, i8* %write_mask_off0, i64 0, i64 4)
+  br i1 %is_zero, label %peek, label %set
+
+peek:                                             ; preds = %entry
+  %rd = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %4, i64 1, i64 1)
+  br label %exit
+
+set:                                              ; preds = %entry
+  call void @nanotube_merge_data_mask(i8* %nanotube_packet_write_masked_buf_off4, i8* %write_mask_off4, i8* %2, i8* %mask, i64 0, i64 2)
+  br label %exit
+
+exit:                                             ; preds = %set, %peek
+  call void @nanotube_merge_data_mask(i8* %nanotube_packet_write_masked_buf_off4, i8* %write_mask_off4, i8* %3, i8* %mask, i64 2, i64 2)
+  %6 = call i64 @nanotube_packet_write_masked(%struct.nanotube_packet* %packet, i8* %nanotube_packet_write_masked_buf_off4, i8* %write_mask_off4, i64 4, i64 4)
+  ret i32 0
+}
+
+define dso_local void @nanotube_setup() {
+entry:
+  %context = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_add_plain_packet_kernel(i8* getelementptr inbounds ([7 x i8], [7 x i8]* @.str, i64 0, i64 0), i32 (%struct.nanotube_context*, %struct.nanotube_packet*)* @kernel, i32 0, i32 1)
+  ret void
+}
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+; Function Attrs: inaccessiblemem_or_argmemonly
+declare i64 @nanotube_packet_write_masked(%struct.nanotube_packet*, i8*, i8*, i64, i64) #0
+
+declare %struct.nanotube_context* @nanotube_context_create()
+
+declare void @nanotube_add_plain_packet_kernel(i8*, i32 (%struct.nanotube_context*, %struct.nanotube_packet*)*, i32, i32)
+
+; Function Attrs: argmemonly nounwind
+declare void @llvm.memset.p0i8.i64(i8* nocapture writeonly, i8, i64, i1) #1
+
+declare void @nanotube_merge_data_mask(i8*, i8*, i8*, i8*, i64, i64)
+
+attributes #0 = { inaccessiblemem_or_argmemonly }
+attributes #1 = { argmemonly nounwind }
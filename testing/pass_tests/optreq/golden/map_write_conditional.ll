@@ -0,0 +1,77 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+source_filename = "map_write_conditional.c"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_packet = type opaque
+%struct.nanotube_context = type opaque
+
+; Function Attrs: inaccessiblemem_or_argmemonly
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64) #0
+
+; Function Attrs: inaccessiblemem_or_argmemonly
+declare i64 @nanotube_map_op(%struct.nanotube_context*, i16 zeroext, i32, i8*, i64, i8*, i8*, i8*, i64, i64) #0
+
+define i32 @process(%struct.nanotube_context* %ctx, %struct.nanotube_packet* %packet) {
+entry:
+  %map_op_buf_off0 = alloca i8, i32 8
+  %map_op_mask_off0 = alloca i8
+  call void @llvm.memset.p0i8.i64(i8* %map_op_mask_off0, i8 0, i64 1, i1 false)
+  %map_op_valid_off0 = alloca i1
+  store i1 false, i1* %map_op_valid_off0
+  %nanotube_packet_read_buf_off0 = alloca i8, i32 13
+  %key = alloca [4 x i8], align 1
+  %sel = alloca i8, align 1
+  %data = alloca [8 x i8], align 1
+  %mask = alloca i8, align 1
+  store i8 15, i8* %mask, align 1
+  %key.p = getelementptr inbounds [4 x i8], [4 x i8]* %key, i64 0, i64 0
+  %data.p = getelementptr inbounds [8 x i8], [8 x i8]* %data, i64 0, i64 0
+  %data.hi = getelementptr inbounds [8 x i8], [8 x i8]* %data, i64 0, i64 4
+  %0 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %nanotube_packet_read_buf_off0, i64 0, i64 13)
+  %1 = getelementptr inbounds i8, i8* %nanotube_packet_read_buf_off0, i32 0
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* align 1 %key.p, i8* align 1 %1, i64 4, i1 false)
+  %2 = getelementptr inbounds i8, i8* %nanotube_packet_read_buf_off0, i32 4
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* align 1 %sel, i8* align 1 %2, i64 1, i1 false)
+  %3 = getelementptr inbounds i8, i8* %nanotube_packet_read_buf_off0, i32 5
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* align 1 %data.p, i8* align 1 %3, i64 8, i1 false)
+  %s = load i8, i8* %sel, align 1
+  %s.lo = and i8 %s, 1
+  %c0 = icmp ne i8 %s.lo, 0
+  br i1 %c0, label %write.lo, label %check.hi
+
+write.lo:                                         ; preds = %entry
+  call void @nanotube_merge_data_mask(i8* %map_op_buf_off0, i8* %map_op_mask_off0, i8* %data.p, i8* %mask, i64 0, i64 4)
+  store i1 true, i1* %map_op_valid_off0
+  br label %check.hi
+
+check.hi:                                         ; preds = %write.lo, %entry
+  %s.hi = and i8 %s, 2
+  %c1 = icmp ne i8 %s.hi, 0
+  br i1 %c1, label %write.hi, label %done
+
+write.hi:                                         ; preds = %check.hi
+  call void @nanotube_merge_data_mask(i8* %map_op_buf_off0, i8* %map_op_mask_off0, i8* %data.hi, i8* %mask, i64 4, i64 4)
+  store i1 true, i1* %map_op_valid_off0
+  br label %done
+
+done:                                             ; preds = %write.hi, %check.hi
+  %4 = load i1, i1* %map_op_valid_off0
+  %5 = select i1 %4, i32 3, i32 5
+  %6 = call i64 @nanotube_map_op(%struct.nanotube_context* %ctx, i16 0, i32 %5, i8* %key.p, i64 4, i8* %map_op_buf_off0, i8* null, i8* %map_op_mask_off0, i64 0, i64 8)
+  ret i32 0
+}
+
+; Function Attrs: argmemonly nounwind
+declare void @llvm.memcpy.p0i8.p0i8.i64(i8* nocapture writeonly, i8* nocapture readonly, i64, i1) #1
+
+; Function Attrs: argmemonly nounwind
+declare void @llvm.memset.p0i8.i64(i8* nocapture writeonly, i8, i64, i1) #1
+
+declare void @nanotube_merge_data_mask(i8*, i8*, i8*, i8*, i64, i64)
+
+attributes #0 = { inaccessiblemem_or_argmemonly }
+attributes #1 = { argmemonly nounwind }
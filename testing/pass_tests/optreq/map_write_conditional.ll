@@ -0,0 +1,54 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Two conditional writes to different fields of the same map entry.  The
+; merged write must become a NOP on the path where neither write happens,
+; otherwise it would insert a missing key.
+;
+; OPTIONS = -optreq-map-merge
+source_filename = "map_write_conditional.c"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_map_op(%struct.nanotube_context*, i16 zeroext, i32, i8*, i64, i8*, i8*, i8*, i64, i64)
+
+define i32 @process(%struct.nanotube_context* %ctx, %struct.nanotube_packet* %packet) {
+entry:
+  %key = alloca [4 x i8], align 1
+  %sel = alloca i8, align 1
+  %data = alloca [8 x i8], align 1
+  %mask = alloca i8, align 1
+  store i8 15, i8* %mask, align 1
+  %key.p = getelementptr inbounds [4 x i8], [4 x i8]* %key, i64 0, i64 0
+  %data.p = getelementptr inbounds [8 x i8], [8 x i8]* %data, i64 0, i64 0
+  %data.hi = getelementptr inbounds [8 x i8], [8 x i8]* %data, i64 0, i64 4
+  %r0 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %key.p, i64 0, i64 4)
+  %r1 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %sel, i64 4, i64 1)
+  %r2 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %data.p, i64 5, i64 8)
+  %s = load i8, i8* %sel, align 1
+  %s.lo = and i8 %s, 1
+  %c0 = icmp ne i8 %s.lo, 0
+  br i1 %c0, label %write.lo, label %check.hi
+
+write.lo:
+  %w0 = call i64 @nanotube_map_op(%struct.nanotube_context* %ctx, i16 zeroext 0, i32 3, i8* %key.p, i64 4, i8* %data.p, i8* null, i8* %mask, i64 0, i64 4)
+  br label %check.hi
+
+check.hi:
+  %s.hi = and i8 %s, 2
+  %c1 = icmp ne i8 %s.hi, 0
+  br i1 %c1, label %write.hi, label %done
+
+write.hi:
+  %w1 = call i64 @nanotube_map_op(%struct.nanotube_context* %ctx, i16 zeroext 0, i32 3, i8* %key.p, i64 4, i8* %data.hi, i8* null, i8* %mask, i64 4, i64 4)
+  br label %done
+
+done:
+  ret i32 0
+}
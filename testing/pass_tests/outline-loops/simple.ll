@@ -0,0 +1,48 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; A packet kernel which sums the bytes of a header up to the first zero
+; byte.  The loop has at most 8 iterations and only accesses the stack,
+; so it is outlined into an argmemonly function.
+;
+source_filename = "simple.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+define i32 @kernel(%struct.nanotube_context* %ctx, %struct.nanotube_packet* %packet) {
+entry:
+  %buf = alloca [8 x i8], align 1
+  %sum = alloca i32, align 4
+  %buf.p = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 0
+  %rd = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %buf.p, i64 0, i64 8)
+  store i32 0, i32* %sum, align 4
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %latch ]
+  %p = getelementptr inbounds [8 x i8], [8 x i8]* %buf, i64 0, i64 %i
+  %b = load i8, i8* %p, align 1
+  %zero = icmp eq i8 %b, 0
+  br i1 %zero, label %exit, label %latch
+
+latch:
+  %b.ext = zext i8 %b to i32
+  %old = load i32, i32* %sum, align 4
+  %new = add i32 %old, %b.ext
+  store i32 %new, i32* %sum, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %more = icmp ult i64 %i.next, 8
+  br i1 %more, label %loop, label %exit
+
+exit:
+  %res = load i32, i32* %sum, align 4
+  %drop = icmp eq i32 %res, 0
+  %ret = select i1 %drop, i32 0, i32 1
+  ret i32 %ret
+}
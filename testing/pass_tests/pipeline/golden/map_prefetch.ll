@@ -0,0 +1,722 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+source_filename = "testing/pass_tests/pipeline/map_prefetch.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_tap_packet_eop_state = type { i16, i16 }
+%struct.nanotube_tap_packet_read_state = type { i16, i16, i16, i16, i8, i8 }
+%struct.nanotube_tap_packet_write_state = type { i16, i16, i16, i16, i8, i8 }
+%struct.nanotube_packet = type opaque
+%struct.nanotube_context = type opaque
+%struct.nanotube_channel = type opaque
+%struct.nanotube_tap_map = type opaque
+%struct.nanotube_map = type opaque
+%struct.nanotube_tap_packet_read_resp = type { i8, i16 }
+%struct.nanotube_tap_packet_read_req = type { i8, i16, i16 }
+%struct.nanotube_tap_packet_write_req = type { i8, i16, i16 }
+
+@.str = private unnamed_addr constant [7 x i8] c"simple\00", align 1
+@packet_eop_tap_state_stage_0 = private global %struct.nanotube_tap_packet_eop_state zeroinitializer
+@sent_app_state_stage_0 = private global i1 false
+@app_state_stage_1 = private global <{ [4 x i8] }> zeroinitializer
+@have_app_state_stage_1 = private global i1 false
+@packet_eop_tap_state_stage_1 = private global %struct.nanotube_tap_packet_eop_state zeroinitializer
+@packet_read_data_stage_1 = private global [1 x i8] zeroinitializer
+@packet_read_tap_state_stage_1 = private global %struct.nanotube_tap_packet_read_state zeroinitializer
+@app_state_stage_2 = private global <{ i8 }> zeroinitializer
+@have_app_state_stage_2 = private global i1 false
+@packet_eop_tap_state_stage_2 = private global %struct.nanotube_tap_packet_eop_state zeroinitializer
+@packet_read_data_stage_2 = private global [1 x i8] zeroinitializer
+@packet_read_tap_state_stage_2 = private global %struct.nanotube_tap_packet_read_state zeroinitializer
+@app_state_stage_3 = private global <{ i8, [1 x i8] }> zeroinitializer
+@have_app_state_stage_3 = private global i1 false
+@map_resp_data_stage_3 = private global [1 x i8] zeroinitializer
+@map_result_stage_3 = private global i32 0
+@have_map_resp_stage_3 = private global i1 false
+@packet_eop_tap_state_stage_3 = private global %struct.nanotube_tap_packet_eop_state zeroinitializer
+@sent_app_state_stage_3 = private global i1 false
+@app_state_stage_4 = private global <{ i32, [1 x i8], [1 x i8] }> zeroinitializer
+@have_app_state_stage_4 = private global i1 false
+@map_resp_data_stage_4 = private global [1 x i8] zeroinitializer
+@map_result_stage_4 = private global i32 0
+@have_map_resp_stage_4 = private global i1 false
+@packet_eop_tap_state_stage_4 = private global %struct.nanotube_tap_packet_eop_state zeroinitializer
+@sent_app_state_stage_4 = private global i1 false
+@app_state_stage_5 = private global <{ [1 x i8] }> zeroinitializer
+@have_app_state_stage_5 = private global i1 false
+@packet_eop_tap_state_stage_5 = private global %struct.nanotube_tap_packet_eop_state zeroinitializer
+@packet_write_tap_state_stage_5 = private global %struct.nanotube_tap_packet_write_state zeroinitializer
+@packet_eop_tap_state_stage_6 = private global %struct.nanotube_tap_packet_eop_state zeroinitializer
+@0 = private unnamed_addr constant [15 x i8] c"packets_0_to_1\00", align 1
+@1 = private unnamed_addr constant [15 x i8] c"packets_1_to_2\00", align 1
+@2 = private unnamed_addr constant [15 x i8] c"packets_2_to_3\00", align 1
+@3 = private unnamed_addr constant [15 x i8] c"packets_3_to_4\00", align 1
+@4 = private unnamed_addr constant [15 x i8] c"packets_4_to_5\00", align 1
+@5 = private unnamed_addr constant [15 x i8] c"packets_5_to_6\00", align 1
+@6 = private unnamed_addr constant [12 x i8] c"packets_out\00", align 1
+@7 = private unnamed_addr constant [13 x i8] c"state_0_to_1\00", align 1
+@8 = private unnamed_addr constant [13 x i8] c"state_1_to_2\00", align 1
+@9 = private unnamed_addr constant [13 x i8] c"state_2_to_3\00", align 1
+@10 = private unnamed_addr constant [13 x i8] c"state_3_to_4\00", align 1
+@11 = private unnamed_addr constant [13 x i8] c"state_4_to_5\00", align 1
+@12 = private unnamed_addr constant [8 x i8] c"stage_0\00", align 1
+@13 = private unnamed_addr constant [8 x i8] c"stage_1\00", align 1
+@14 = private unnamed_addr constant [8 x i8] c"stage_2\00", align 1
+@15 = private unnamed_addr constant [8 x i8] c"stage_3\00", align 1
+@16 = private unnamed_addr constant [8 x i8] c"stage_4\00", align 1
+@17 = private unnamed_addr constant [8 x i8] c"stage_5\00", align 1
+@18 = private unnamed_addr constant [8 x i8] c"stage_6\00", align 1
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_packet_write(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_map_op(%struct.nanotube_context*, i16 zeroext, i32, i8*, i64, i8*, i8*, i8*, i64, i64)
+
+define dso_local void @nanotube_setup() {
+entry:
+  %context = call %struct.nanotube_context* @nanotube_context_create()
+  %packet_in = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([7 x i8], [7 x i8]* @.str, i64 0, i64 0), i64 65, i64 140)
+  %packets_0_to_1 = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([15 x i8], [15 x i8]* @0, i32 0, i32 0), i64 65, i64 140)
+  %packets_1_to_2 = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([15 x i8], [15 x i8]* @1, i32 0, i32 0), i64 65, i64 140)
+  %packets_2_to_3 = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([15 x i8], [15 x i8]* @2, i32 0, i32 0), i64 65, i64 140)
+  %packets_3_to_4 = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([15 x i8], [15 x i8]* @3, i32 0, i32 0), i64 65, i64 140)
+  %packets_4_to_5 = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([15 x i8], [15 x i8]* @4, i32 0, i32 0), i64 65, i64 140)
+  %packets_5_to_6 = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([15 x i8], [15 x i8]* @5, i32 0, i32 0), i64 65, i64 140)
+  %packets_out = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([12 x i8], [12 x i8]* @6, i32 0, i32 0), i64 65, i64 140)
+  call void @nanotube_channel_export(%struct.nanotube_channel* %packet_in, i32 1, i32 2)
+  call void @nanotube_channel_export(%struct.nanotube_channel* %packets_out, i32 1, i32 1)
+  %state_0_to_1 = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([13 x i8], [13 x i8]* @7, i32 0, i32 0), i64 4, i64 10)
+  %state_1_to_2 = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([13 x i8], [13 x i8]* @8, i32 0, i32 0), i64 1, i64 10)
+  %state_2_to_3 = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([13 x i8], [13 x i8]* @9, i32 0, i32 0), i64 2, i64 10)
+  %state_3_to_4 = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([13 x i8], [13 x i8]* @10, i32 0, i32 0), i64 6, i64 10)
+  %state_4_to_5 = call %struct.nanotube_channel* @nanotube_channel_create(i8* getelementptr inbounds ([13 x i8], [13 x i8]* @11, i32 0, i32 0), i64 1, i64 10)
+  %context0 = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context0, i32 0, %struct.nanotube_channel* %packet_in, i32 1)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context0, i32 1, %struct.nanotube_channel* %packets_0_to_1, i32 2)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context0, i32 3, %struct.nanotube_channel* %state_0_to_1, i32 2)
+  %context1 = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context1, i32 0, %struct.nanotube_channel* %packets_0_to_1, i32 1)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context1, i32 1, %struct.nanotube_channel* %packets_1_to_2, i32 2)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context1, i32 3, %struct.nanotube_channel* %state_1_to_2, i32 2)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context1, i32 2, %struct.nanotube_channel* %state_0_to_1, i32 1)
+  %context2 = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context2, i32 0, %struct.nanotube_channel* %packets_1_to_2, i32 1)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context2, i32 1, %struct.nanotube_channel* %packets_2_to_3, i32 2)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context2, i32 3, %struct.nanotube_channel* %state_2_to_3, i32 2)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context2, i32 2, %struct.nanotube_channel* %state_1_to_2, i32 1)
+  %context3 = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context3, i32 0, %struct.nanotube_channel* %packets_2_to_3, i32 1)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context3, i32 1, %struct.nanotube_channel* %packets_3_to_4, i32 2)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context3, i32 3, %struct.nanotube_channel* %state_3_to_4, i32 2)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context3, i32 2, %struct.nanotube_channel* %state_2_to_3, i32 1)
+  %context4 = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context4, i32 0, %struct.nanotube_channel* %packets_3_to_4, i32 1)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context4, i32 1, %struct.nanotube_channel* %packets_4_to_5, i32 2)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context4, i32 3, %struct.nanotube_channel* %state_4_to_5, i32 2)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context4, i32 2, %struct.nanotube_channel* %state_3_to_4, i32 1)
+  %context5 = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context5, i32 0, %struct.nanotube_channel* %packets_4_to_5, i32 1)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context5, i32 1, %struct.nanotube_channel* %packets_5_to_6, i32 2)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context5, i32 2, %struct.nanotube_channel* %state_4_to_5, i32 1)
+  %context6 = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context6, i32 0, %struct.nanotube_channel* %packets_5_to_6, i32 1)
+  call void @nanotube_context_add_channel(%struct.nanotube_context* %context6, i32 1, %struct.nanotube_channel* %packets_out, i32 2)
+  %map_arr = alloca [2 x %struct.nanotube_tap_map*]
+  %map_0 = call %struct.nanotube_tap_map* @nanotube_tap_map_create(i32 0, i16 4, i16 1, i64 10, i32 1)
+  %map_loc0 = getelementptr inbounds [2 x %struct.nanotube_tap_map*], [2 x %struct.nanotube_tap_map*]* %map_arr, i32 0, i32 0
+  store %struct.nanotube_tap_map* %map_0, %struct.nanotube_tap_map** %map_loc0
+  call void @nanotube_tap_map_add_client(%struct.nanotube_tap_map* %map_0, i16 4, i16 0, i1 true, i16 1, %struct.nanotube_context* %context0, i32 6, %struct.nanotube_context* %context3, i32 7)
+  call void @nanotube_tap_map_build(%struct.nanotube_tap_map* %map_0)
+  %map_1 = call %struct.nanotube_tap_map* @nanotube_tap_map_create(i32 0, i16 4, i16 1, i64 10, i32 1)
+  %map_loc1 = getelementptr inbounds [2 x %struct.nanotube_tap_map*], [2 x %struct.nanotube_tap_map*]* %map_arr, i32 0, i32 1
+  store %struct.nanotube_tap_map* %map_1, %struct.nanotube_tap_map** %map_loc1
+  call void @nanotube_tap_map_add_client(%struct.nanotube_tap_map* %map_1, i16 4, i16 0, i1 true, i16 1, %struct.nanotube_context* %context1, i32 6, %struct.nanotube_context* %context4, i32 7)
+  call void @nanotube_tap_map_build(%struct.nanotube_tap_map* %map_1)
+  %0 = bitcast [2 x %struct.nanotube_tap_map*]* %map_arr to i8*
+  call void @nanotube_thread_create(%struct.nanotube_context* %context0, i8* getelementptr inbounds ([8 x i8], [8 x i8]* @12, i32 0, i32 0), void (%struct.nanotube_context*, i8*)* @simple_stage_0, i8* %0, i64 16)
+  %1 = bitcast [2 x %struct.nanotube_tap_map*]* %map_arr to i8*
+  call void @nanotube_thread_create(%struct.nanotube_context* %context1, i8* getelementptr inbounds ([8 x i8], [8 x i8]* @13, i32 0, i32 0), void (%struct.nanotube_context*, i8*)* @simple_stage_1, i8* %1, i64 16)
+  %2 = bitcast [2 x %struct.nanotube_tap_map*]* %map_arr to i8*
+  call void @nanotube_thread_create(%struct.nanotube_context* %context2, i8* getelementptr inbounds ([8 x i8], [8 x i8]* @14, i32 0, i32 0), void (%struct.nanotube_context*, i8*)* @simple_stage_2, i8* %2, i64 16)
+  %3 = bitcast [2 x %struct.nanotube_tap_map*]* %map_arr to i8*
+  call void @nanotube_thread_create(%struct.nanotube_context* %context3, i8* getelementptr inbounds ([8 x i8], [8 x i8]* @15, i32 0, i32 0), void (%struct.nanotube_context*, i8*)* @simple_stage_3, i8* %3, i64 16)
+  %4 = bitcast [2 x %struct.nanotube_tap_map*]* %map_arr to i8*
+  call void @nanotube_thread_create(%struct.nanotube_context* %context4, i8* getelementptr inbounds ([8 x i8], [8 x i8]* @16, i32 0, i32 0), void (%struct.nanotube_context*, i8*)* @simple_stage_4, i8* %4, i64 16)
+  %5 = bitcast [2 x %struct.nanotube_tap_map*]* %map_arr to i8*
+  call void @nanotube_thread_create(%struct.nanotube_context* %context5, i8* getelementptr inbounds ([8 x i8], [8 x i8]* @17, i32 0, i32 0), void (%struct.nanotube_context*, i8*)* @simple_stage_5, i8* %5, i64 16)
+  %6 = bitcast [2 x %struct.nanotube_tap_map*]* %map_arr to i8*
+  call void @nanotube_thread_create(%struct.nanotube_context* %context6, i8* getelementptr inbounds ([8 x i8], [8 x i8]* @18, i32 0, i32 0), void (%struct.nanotube_context*, i8*)* @simple_stage_6, i8* %6, i64 16)
+  ret void
+}
+
+declare %struct.nanotube_map* @nanotube_map_create(i16 zeroext, i32, i64, i64)
+
+declare %struct.nanotube_context* @nanotube_context_create()
+
+declare void @nanotube_context_add_map(%struct.nanotube_context*, %struct.nanotube_map*)
+
+declare void @nanotube_add_plain_packet_kernel(i8*, i32 (%struct.nanotube_context*, %struct.nanotube_packet*)*, i32, i32)
+
+; Function Attrs: inaccessiblemem_or_argmemonly
+declare void @nanotube_map_op_send(%struct.nanotube_context*, i16, i32, i8*, i64, i8*, i8*, i64, i64) #0
+
+; Function Attrs: inaccessiblemem_or_argmemonly
+declare i64 @nanotube_map_op_receive(%struct.nanotube_context*, i16, i8*, i64) #0
+
+declare void @nanotube_packet_drop(%struct.nanotube_packet*, i32)
+
+; Function Attrs: argmemonly nofree nounwind willreturn
+declare void @llvm.memcpy.p0i8.p0i8.i64(i8* nocapture writeonly, i8* nocapture readonly, i64, i1) #1
+
+define void @simple_stage_0(%struct.nanotube_context*, i8*) {
+read_packet_word:
+  %2 = bitcast i8* %1 to [2 x %struct.nanotube_tap_map*]*
+  %3 = getelementptr inbounds [2 x %struct.nanotube_tap_map*], [2 x %struct.nanotube_tap_map*]* %2, i32 0, i32 0
+  %map0 = load %struct.nanotube_tap_map*, %struct.nanotube_tap_map** %3
+  %packet_word = alloca i8, i64 65
+  %read_channel = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %0, i32 0, i8* %packet_word, i64 65)
+  %try_fail = icmp eq i32 %read_channel, 0
+  br i1 %try_fail, label %thread_wait_exit, label %entry_post
+
+thread_wait_exit:                                 ; preds = %read_packet_word
+  call void @nanotube_thread_wait()
+  ret void
+
+entry_post:                                       ; preds = %read_packet_word
+  %eop = call i1 @nanotube_tap_packet_is_eop_sb(i8* %packet_word, %struct.nanotube_tap_packet_eop_state* @packet_eop_tap_state_stage_0)
+  br label %entry
+
+entry:                                            ; preds = %entry_post
+  %map_spec_buf_stage_0 = alloca [1 x i8], !nanotube.pipeline !0
+  %key0_stage_0 = alloca i32, align 4
+  %key1_stage_0 = alloca i32, align 4
+  %buf0_stage_0 = alloca [1 x i8], align 1
+  %buf1_stage_0 = alloca [1 x i8], align 1
+  %data0_stage_0 = alloca [1 x i8], align 1
+  %data1_stage_0 = alloca [1 x i8], align 1
+  %4 = bitcast i32* %key0_stage_0 to i8*
+  %5 = bitcast i32* %key1_stage_0 to i8*
+  %6 = getelementptr inbounds [1 x i8], [1 x i8]* %buf0_stage_0, i64 0, i64 0
+  %7 = getelementptr inbounds [1 x i8], [1 x i8]* %buf1_stage_0, i64 0, i64 0
+  %8 = getelementptr inbounds [1 x i8], [1 x i8]* %data0_stage_0, i64 0, i64 0
+  %9 = getelementptr inbounds [1 x i8], [1 x i8]* %data1_stage_0, i64 0, i64 0
+  store i32 67305985, i32* %key0_stage_0, align 4
+  store i32 134678021, i32* %key1_stage_0, align 4
+  br label %stage_0_app_send_guard, !nanotube.pipeline !1
+
+stage_0_app_send_guard:                           ; preds = %entry
+  %stage_0sent_app_state = load i1, i1* @sent_app_state_stage_0
+  %not_eop = xor i1 %eop, true
+  store i1 %not_eop, i1* @sent_app_state_stage_0
+  br i1 %stage_0sent_app_state, label %stage_0_epilogue, label %stage_0_app_epilogue
+
+stage_0_app_epilogue:                             ; preds = %stage_0_app_send_guard
+  %live_out_state = alloca <{ [4 x i8] }>
+  %key1_stage_0_ptr = getelementptr <{ [4 x i8] }>, <{ [4 x i8] }>* %live_out_state, i32 0, i32 0
+  %10 = bitcast [4 x i8]* %key1_stage_0_ptr to i8*
+  %11 = bitcast i32* %key1_stage_0 to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %10, i8* %11, i64 4, i1 false)
+  %12 = bitcast <{ [4 x i8] }>* %live_out_state to i8*
+  call void @nanotube_channel_write(%struct.nanotube_context* %0, i32 3, i8* %12, i64 4)
+  call void @nanotube_tap_map_send_req(%struct.nanotube_context* %0, %struct.nanotube_tap_map* %map0, i32 0, i32 0, i8* %4, i8* null)
+  br label %stage_0_epilogue
+
+stage_0_epilogue:                                 ; preds = %stage_0_app_epilogue, %stage_0_app_send_guard
+  call void @nanotube_channel_write(%struct.nanotube_context* %0, i32 1, i8* %packet_word, i64 65)
+  br label %exit
+
+exit:                                             ; preds = %stage_0_epilogue
+  ret void
+}
+
+define void @simple_stage_1(%struct.nanotube_context*, i8*) {
+entry:
+  %2 = bitcast i8* %1 to [2 x %struct.nanotube_tap_map*]*
+  %3 = getelementptr inbounds [2 x %struct.nanotube_tap_map*], [2 x %struct.nanotube_tap_map*]* %2, i32 0, i32 1
+  %map1 = load %struct.nanotube_tap_map*, %struct.nanotube_tap_map** %3
+  %4 = load i1, i1* @have_app_state_stage_1
+  %key1_stack_stage_1 = alloca i8, i32 4
+  %key1_stage_1 = bitcast i8* %key1_stack_stage_1 to i32*
+  %buf0_stage_1 = alloca [1 x i8], align 1
+  %_stage_1 = bitcast i32* %key1_stage_1 to i8*
+  %_stage_14 = getelementptr inbounds [1 x i8], [1 x i8]* %buf0_stage_1, i64 0, i64 0
+  br i1 %4, label %read_packet_word, label %read_app_state
+
+read_app_state:                                   ; preds = %entry
+  %read_channel = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %0, i32 2, i8* getelementptr inbounds (<{ [4 x i8] }>, <{ [4 x i8] }>* @app_state_stage_1, i32 0, i32 0, i32 0), i64 4)
+  %try_fail = icmp eq i32 %read_channel, 0
+  br i1 %try_fail, label %thread_wait_exit, label %read_app_state_post
+
+thread_wait_exit:                                 ; preds = %read_packet_word, %read_app_state
+  call void @nanotube_thread_wait()
+  ret void
+
+read_app_state_post:                              ; preds = %read_app_state
+  store i1 true, i1* @have_app_state_stage_1
+  br label %read_packet_word
+
+read_packet_word:                                 ; preds = %read_app_state_post, %entry
+  %packet_word = alloca i8, i64 65
+  %read_channel1 = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %0, i32 0, i8* %packet_word, i64 65)
+  %try_fail2 = icmp eq i32 %read_channel1, 0
+  br i1 %try_fail2, label %thread_wait_exit, label %entry_post_post
+
+entry_post_post:                                  ; preds = %read_packet_word
+  %eop = call i1 @nanotube_tap_packet_is_eop_sb(i8* %packet_word, %struct.nanotube_tap_packet_eop_state* @packet_eop_tap_state_stage_1)
+  %in_packet = xor i1 %eop, true
+  store i1 %in_packet, i1* @have_app_state_stage_1
+  br label %unmarshal_stage_1
+
+unmarshal_stage_1:                                ; preds = %entry_post_post
+  %5 = bitcast [4 x i8]* getelementptr inbounds (<{ [4 x i8] }>, <{ [4 x i8] }>* @app_state_stage_1, i32 0, i32 0) to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %key1_stack_stage_1, i8* %5, i64 4, i1 false)
+  br label %entry3.post.pre
+
+entry3.post.pre:                                  ; preds = %unmarshal_stage_1
+  %resp = alloca %struct.nanotube_tap_packet_read_resp, !nanotube.pipeline !0
+  %req = alloca %struct.nanotube_tap_packet_read_req
+  %req.valid.p = getelementptr inbounds %struct.nanotube_tap_packet_read_req, %struct.nanotube_tap_packet_read_req* %req, i32 0, i32 0
+  %req.read_offset.p = getelementptr inbounds %struct.nanotube_tap_packet_read_req, %struct.nanotube_tap_packet_read_req* %req, i32 0, i32 1
+  %req.read_length.p = getelementptr inbounds %struct.nanotube_tap_packet_read_req, %struct.nanotube_tap_packet_read_req* %req, i32 0, i32 2
+  store i8 1, i8* %req.valid.p
+  store i16 0, i16* %req.read_offset.p
+  store i16 1, i16* %req.read_length.p
+  call void @nanotube_tap_packet_read_sb(i16 1, i8 1, %struct.nanotube_tap_packet_read_resp* %resp, i8* getelementptr inbounds ([1 x i8], [1 x i8]* @packet_read_data_stage_1, i32 0, i32 0), %struct.nanotube_tap_packet_read_state* @packet_read_tap_state_stage_1, i8* %packet_word, %struct.nanotube_tap_packet_read_req* %req)
+  %resp.valid.p = getelementptr inbounds %struct.nanotube_tap_packet_read_resp, %struct.nanotube_tap_packet_read_resp* %resp, i32 0, i32 0
+  %resp.valid.i8 = load i8, i8* %resp.valid.p
+  %resp.valid = trunc i8 %resp.valid.i8 to i1
+  br i1 %resp.valid, label %entry3.post, label %stage_1_epilogue
+
+entry3.post:                                      ; preds = %entry3.post.pre
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %_stage_14, i8* getelementptr inbounds ([1 x i8], [1 x i8]* @packet_read_data_stage_1, i32 0, i32 0), i64 1, i1 false)
+  %byte_stage_1 = load i8, i8* %_stage_14, align 1
+  br label %stage_1_app_epilogue, !nanotube.pipeline !1
+
+stage_1_app_epilogue:                             ; preds = %entry3.post
+  %live_out_state = alloca <{ i8 }>
+  %byte_stage_1_ptr = getelementptr <{ i8 }>, <{ i8 }>* %live_out_state, i32 0, i32 0
+  store i8 %byte_stage_1, i8* %byte_stage_1_ptr
+  %6 = bitcast <{ i8 }>* %live_out_state to i8*
+  call void @nanotube_channel_write(%struct.nanotube_context* %0, i32 3, i8* %6, i64 1)
+  call void @nanotube_tap_map_send_req(%struct.nanotube_context* %0, %struct.nanotube_tap_map* %map1, i32 0, i32 0, i8* %_stage_1, i8* null)
+  br label %stage_1_epilogue
+
+stage_1_epilogue:                                 ; preds = %entry3.post.pre, %stage_1_app_epilogue
+  call void @nanotube_channel_write(%struct.nanotube_context* %0, i32 1, i8* %packet_word, i64 65)
+  br label %exit
+
+exit:                                             ; preds = %stage_1_epilogue
+  ret void
+}
+
+define void @simple_stage_2(%struct.nanotube_context*, i8*) {
+entry:
+  %2 = load i1, i1* @have_app_state_stage_2
+  %buf1_stage_2 = alloca [1 x i8], align 1
+  %_stage_2 = getelementptr inbounds [1 x i8], [1 x i8]* %buf1_stage_2, i64 0, i64 0
+  br i1 %2, label %read_packet_word, label %read_app_state
+
+read_app_state:                                   ; preds = %entry
+  %read_channel = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %0, i32 2, i8* getelementptr inbounds (<{ i8 }>, <{ i8 }>* @app_state_stage_2, i32 0, i32 0), i64 1)
+  %try_fail = icmp eq i32 %read_channel, 0
+  br i1 %try_fail, label %thread_wait_exit, label %read_app_state_post
+
+thread_wait_exit:                                 ; preds = %read_packet_word, %read_app_state
+  call void @nanotube_thread_wait()
+  ret void
+
+read_app_state_post:                              ; preds = %read_app_state
+  store i1 true, i1* @have_app_state_stage_2
+  br label %read_packet_word
+
+read_packet_word:                                 ; preds = %read_app_state_post, %entry
+  %packet_word = alloca i8, i64 65
+  %read_channel1 = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %0, i32 0, i8* %packet_word, i64 65)
+  %try_fail2 = icmp eq i32 %read_channel1, 0
+  br i1 %try_fail2, label %thread_wait_exit, label %entry_post_post
+
+entry_post_post:                                  ; preds = %read_packet_word
+  %eop = call i1 @nanotube_tap_packet_is_eop_sb(i8* %packet_word, %struct.nanotube_tap_packet_eop_state* @packet_eop_tap_state_stage_2)
+  %in_packet = xor i1 %eop, true
+  store i1 %in_packet, i1* @have_app_state_stage_2
+  br label %unmarshal_stage_2
+
+unmarshal_stage_2:                                ; preds = %entry_post_post
+  %byte_stage_2 = load i8, i8* getelementptr inbounds (<{ i8 }>, <{ i8 }>* @app_state_stage_2, i32 0, i32 0)
+  br label %entry3.post.pre
+
+entry3.post.pre:                                  ; preds = %unmarshal_stage_2
+  %resp = alloca %struct.nanotube_tap_packet_read_resp, !nanotube.pipeline !0
+  %req = alloca %struct.nanotube_tap_packet_read_req
+  %req.valid.p = getelementptr inbounds %struct.nanotube_tap_packet_read_req, %struct.nanotube_tap_packet_read_req* %req, i32 0, i32 0
+  %req.read_offset.p = getelementptr inbounds %struct.nanotube_tap_packet_read_req, %struct.nanotube_tap_packet_read_req* %req, i32 0, i32 1
+  %req.read_length.p = getelementptr inbounds %struct.nanotube_tap_packet_read_req, %struct.nanotube_tap_packet_read_req* %req, i32 0, i32 2
+  store i8 1, i8* %req.valid.p
+  store i16 8, i16* %req.read_offset.p
+  store i16 1, i16* %req.read_length.p
+  call void @nanotube_tap_packet_read_sb(i16 1, i8 1, %struct.nanotube_tap_packet_read_resp* %resp, i8* getelementptr inbounds ([1 x i8], [1 x i8]* @packet_read_data_stage_2, i32 0, i32 0), %struct.nanotube_tap_packet_read_state* @packet_read_tap_state_stage_2, i8* %packet_word, %struct.nanotube_tap_packet_read_req* %req)
+  %resp.valid.p = getelementptr inbounds %struct.nanotube_tap_packet_read_resp, %struct.nanotube_tap_packet_read_resp* %resp, i32 0, i32 0
+  %resp.valid.i8 = load i8, i8* %resp.valid.p
+  %resp.valid = trunc i8 %resp.valid.i8 to i1
+  br i1 %resp.valid, label %entry3.post, label %stage_2_epilogue
+
+entry3.post:                                      ; preds = %entry3.post.pre
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %_stage_2, i8* getelementptr inbounds ([1 x i8], [1 x i8]* @packet_read_data_stage_2, i32 0, i32 0), i64 1, i1 false)
+  br label %stage_2_app_epilogue, !nanotube.pipeline !1
+
+stage_2_app_epilogue:                             ; preds = %entry3.post
+  %live_out_state = alloca <{ i8, [1 x i8] }>
+  %byte_stage_2_ptr = getelementptr <{ i8, [1 x i8] }>, <{ i8, [1 x i8] }>* %live_out_state, i32 0, i32 0
+  store i8 %byte_stage_2, i8* %byte_stage_2_ptr
+  %buf1_stage_2_ptr = getelementptr <{ i8, [1 x i8] }>, <{ i8, [1 x i8] }>* %live_out_state, i32 0, i32 1
+  %3 = bitcast [1 x i8]* %buf1_stage_2_ptr to i8*
+  %4 = bitcast [1 x i8]* %buf1_stage_2 to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %3, i8* %4, i64 1, i1 false)
+  %5 = bitcast <{ i8, [1 x i8] }>* %live_out_state to i8*
+  call void @nanotube_channel_write(%struct.nanotube_context* %0, i32 3, i8* %5, i64 2)
+  br label %stage_2_epilogue
+
+stage_2_epilogue:                                 ; preds = %entry3.post.pre, %stage_2_app_epilogue
+  call void @nanotube_channel_write(%struct.nanotube_context* %0, i32 1, i8* %packet_word, i64 65)
+  br label %exit
+
+exit:                                             ; preds = %stage_2_epilogue
+  ret void
+}
+
+define void @simple_stage_3(%struct.nanotube_context*, i8*) {
+entry:
+  %2 = bitcast i8* %1 to [2 x %struct.nanotube_tap_map*]*
+  %3 = getelementptr inbounds [2 x %struct.nanotube_tap_map*], [2 x %struct.nanotube_tap_map*]* %2, i32 0, i32 0
+  %map0 = load %struct.nanotube_tap_map*, %struct.nanotube_tap_map** %3
+  %4 = load i1, i1* @have_app_state_stage_3
+  %buf1_stack_stage_3 = alloca i8
+  %buf1_stage_3 = bitcast i8* %buf1_stack_stage_3 to [1 x i8]*
+  %map_spec_buf_stage_3 = alloca [1 x i8]
+  %data0_stage_3 = alloca [1 x i8], align 1
+  %_stage_3 = getelementptr inbounds [1 x i8], [1 x i8]* %data0_stage_3, i64 0, i64 0
+  br i1 %4, label %entry_post, label %read_app_state
+
+read_app_state:                                   ; preds = %entry
+  %read_channel = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %0, i32 2, i8* getelementptr inbounds (<{ i8, [1 x i8] }>, <{ i8, [1 x i8] }>* @app_state_stage_3, i32 0, i32 0), i64 2)
+  %try_fail = icmp eq i32 %read_channel, 0
+  br i1 %try_fail, label %thread_wait_exit, label %read_app_state_post
+
+thread_wait_exit:                                 ; preds = %read_packet_word, %read_map_resp, %read_app_state
+  call void @nanotube_thread_wait()
+  ret void
+
+read_app_state_post:                              ; preds = %read_app_state
+  store i1 true, i1* @have_app_state_stage_3
+  br label %entry_post
+
+entry_post:                                       ; preds = %read_app_state_post, %entry
+  %5 = load i1, i1* @have_map_resp_stage_3
+  br i1 %5, label %read_packet_word, label %read_map_resp
+
+read_map_resp:                                    ; preds = %entry_post
+  %map_read = call i1 @nanotube_tap_map_recv_resp(%struct.nanotube_context* %0, %struct.nanotube_tap_map* %map0, i32 0, i8* getelementptr inbounds ([1 x i8], [1 x i8]* @map_resp_data_stage_3, i32 0, i32 0), i32* @map_result_stage_3)
+  %try_fail1 = icmp eq i1 %map_read, false
+  br i1 %try_fail1, label %thread_wait_exit, label %read_map_resp_post
+
+read_map_resp_post:                               ; preds = %read_map_resp
+  store i1 true, i1* @have_map_resp_stage_3
+  br label %read_packet_word
+
+read_packet_word:                                 ; preds = %read_map_resp_post, %entry_post
+  %packet_word = alloca i8, i64 65
+  %read_channel2 = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %0, i32 0, i8* %packet_word, i64 65)
+  %try_fail3 = icmp eq i32 %read_channel2, 0
+  br i1 %try_fail3, label %thread_wait_exit, label %entry_post_post_post
+
+entry_post_post_post:                             ; preds = %read_packet_word
+  %eop = call i1 @nanotube_tap_packet_is_eop_sb(i8* %packet_word, %struct.nanotube_tap_packet_eop_state* @packet_eop_tap_state_stage_3)
+  %in_packet = xor i1 %eop, true
+  store i1 %in_packet, i1* @have_app_state_stage_3
+  store i1 %in_packet, i1* @have_map_resp_stage_3
+  br label %unmarshal_stage_3
+
+unmarshal_stage_3:                                ; preds = %entry_post_post_post
+  %byte_stage_3 = load i8, i8* getelementptr inbounds (<{ i8, [1 x i8] }>, <{ i8, [1 x i8] }>* @app_state_stage_3, i32 0, i32 0)
+  %6 = bitcast [1 x i8]* getelementptr inbounds (<{ i8, [1 x i8] }>, <{ i8, [1 x i8] }>* @app_state_stage_3, i32 0, i32 1) to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %buf1_stack_stage_3, i8* %6, i64 1, i1 false)
+  br label %entry4
+
+entry4:                                           ; preds = %unmarshal_stage_3
+  %7 = bitcast [1 x i8]* @map_resp_data_stage_3 to i8*, !nanotube.pipeline !0
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %_stage_3, i8* %7, i64 1, i1 false)
+  %is_zero_stage_3 = icmp eq i8 %byte_stage_3, 0
+  %type_stage_3 = select i1 %is_zero_stage_3, i32 0, i32 5
+  %8 = bitcast [1 x i8]* %map_spec_buf_stage_3 to i8*
+  br label %stage_3_app_send_guard, !nanotube.pipeline !1
+
+stage_3_app_send_guard:                           ; preds = %entry4
+  %stage_3sent_app_state = load i1, i1* @sent_app_state_stage_3
+  %not_eop = xor i1 %eop, true
+  store i1 %not_eop, i1* @sent_app_state_stage_3
+  br i1 %stage_3sent_app_state, label %stage_3_epilogue, label %stage_3_app_epilogue
+
+stage_3_app_epilogue:                             ; preds = %stage_3_app_send_guard
+  %live_out_state = alloca <{ i32, [1 x i8], [1 x i8] }>
+  %type_stage_3_ptr = getelementptr <{ i32, [1 x i8], [1 x i8] }>, <{ i32, [1 x i8], [1 x i8] }>* %live_out_state, i32 0, i32 0
+  store i32 %type_stage_3, i32* %type_stage_3_ptr
+  %buf1_stage_3_ptr = getelementptr <{ i32, [1 x i8], [1 x i8] }>, <{ i32, [1 x i8], [1 x i8] }>* %live_out_state, i32 0, i32 1
+  %9 = bitcast [1 x i8]* %buf1_stage_3_ptr to i8*
+  %10 = bitcast [1 x i8]* %buf1_stage_3 to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %9, i8* %10, i64 1, i1 false)
+  %data0_stage_3_ptr = getelementptr <{ i32, [1 x i8], [1 x i8] }>, <{ i32, [1 x i8], [1 x i8] }>* %live_out_state, i32 0, i32 2
+  %11 = bitcast [1 x i8]* %data0_stage_3_ptr to i8*
+  %12 = bitcast [1 x i8]* %data0_stage_3 to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %11, i8* %12, i64 1, i1 false)
+  %13 = bitcast <{ i32, [1 x i8], [1 x i8] }>* %live_out_state to i8*
+  call void @nanotube_channel_write(%struct.nanotube_context* %0, i32 3, i8* %13, i64 6)
+  br label %stage_3_epilogue
+
+stage_3_epilogue:                                 ; preds = %stage_3_app_epilogue, %stage_3_app_send_guard
+  call void @nanotube_channel_write(%struct.nanotube_context* %0, i32 1, i8* %packet_word, i64 65)
+  br label %exit
+
+exit:                                             ; preds = %stage_3_epilogue
+  ret void
+}
+
+define void @simple_stage_4(%struct.nanotube_context*, i8*) {
+entry:
+  %2 = bitcast i8* %1 to [2 x %struct.nanotube_tap_map*]*
+  %3 = getelementptr inbounds [2 x %struct.nanotube_tap_map*], [2 x %struct.nanotube_tap_map*]* %2, i32 0, i32 1
+  %map1 = load %struct.nanotube_tap_map*, %struct.nanotube_tap_map** %3
+  %4 = load i1, i1* @have_app_state_stage_4
+  %buf1_stack_stage_4 = alloca i8
+  %buf1_stage_4 = bitcast i8* %buf1_stack_stage_4 to [1 x i8]*
+  %data0_stack_stage_4 = alloca i8
+  %data0_stage_4 = bitcast i8* %data0_stack_stage_4 to [1 x i8]*
+  %map_spec_buf_stage_4 = alloca [1 x i8]
+  %data1_stage_4 = alloca [1 x i8], align 1
+  %_stage_4 = getelementptr inbounds [1 x i8], [1 x i8]* %buf1_stage_4, i64 0, i64 0
+  %_stage_45 = getelementptr inbounds [1 x i8], [1 x i8]* %data0_stage_4, i64 0, i64 0
+  %_stage_46 = getelementptr inbounds [1 x i8], [1 x i8]* %data1_stage_4, i64 0, i64 0
+  %_stage_47 = bitcast [1 x i8]* %map_spec_buf_stage_4 to i8*
+  br i1 %4, label %entry_post, label %read_app_state
+
+read_app_state:                                   ; preds = %entry
+  %read_channel = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %0, i32 2, i8* bitcast (<{ i32, [1 x i8], [1 x i8] }>* @app_state_stage_4 to i8*), i64 6)
+  %try_fail = icmp eq i32 %read_channel, 0
+  br i1 %try_fail, label %thread_wait_exit, label %read_app_state_post
+
+thread_wait_exit:                                 ; preds = %read_packet_word, %read_map_resp, %read_app_state
+  call void @nanotube_thread_wait()
+  ret void
+
+read_app_state_post:                              ; preds = %read_app_state
+  store i1 true, i1* @have_app_state_stage_4
+  br label %entry_post
+
+entry_post:                                       ; preds = %read_app_state_post, %entry
+  %5 = load i1, i1* @have_map_resp_stage_4
+  br i1 %5, label %read_packet_word, label %read_map_resp
+
+read_map_resp:                                    ; preds = %entry_post
+  %map_read = call i1 @nanotube_tap_map_recv_resp(%struct.nanotube_context* %0, %struct.nanotube_tap_map* %map1, i32 0, i8* getelementptr inbounds ([1 x i8], [1 x i8]* @map_resp_data_stage_4, i32 0, i32 0), i32* @map_result_stage_4)
+  %try_fail1 = icmp eq i1 %map_read, false
+  br i1 %try_fail1, label %thread_wait_exit, label %read_map_resp_post
+
+read_map_resp_post:                               ; preds = %read_map_resp
+  store i1 true, i1* @have_map_resp_stage_4
+  br label %read_packet_word
+
+read_packet_word:                                 ; preds = %read_map_resp_post, %entry_post
+  %packet_word = alloca i8, i64 65
+  %read_channel2 = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %0, i32 0, i8* %packet_word, i64 65)
+  %try_fail3 = icmp eq i32 %read_channel2, 0
+  br i1 %try_fail3, label %thread_wait_exit, label %entry_post_post_post
+
+entry_post_post_post:                             ; preds = %read_packet_word
+  %eop = call i1 @nanotube_tap_packet_is_eop_sb(i8* %packet_word, %struct.nanotube_tap_packet_eop_state* @packet_eop_tap_state_stage_4)
+  %in_packet = xor i1 %eop, true
+  store i1 %in_packet, i1* @have_app_state_stage_4
+  store i1 %in_packet, i1* @have_map_resp_stage_4
+  br label %unmarshal_stage_4
+
+unmarshal_stage_4:                                ; preds = %entry_post_post_post
+  %type_stage_4 = load i32, i32* getelementptr inbounds (<{ i32, [1 x i8], [1 x i8] }>, <{ i32, [1 x i8], [1 x i8] }>* @app_state_stage_4, i32 0, i32 0)
+  %6 = bitcast [1 x i8]* getelementptr inbounds (<{ i32, [1 x i8], [1 x i8] }>, <{ i32, [1 x i8], [1 x i8] }>* @app_state_stage_4, i32 0, i32 1) to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %buf1_stack_stage_4, i8* %6, i64 1, i1 false)
+  %7 = bitcast [1 x i8]* getelementptr inbounds (<{ i32, [1 x i8], [1 x i8] }>, <{ i32, [1 x i8], [1 x i8] }>* @app_state_stage_4, i32 0, i32 2) to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %data0_stack_stage_4, i8* %7, i64 1, i1 false)
+  br label %entry4
+
+entry4:                                           ; preds = %unmarshal_stage_4
+  %8 = bitcast [1 x i8]* @map_resp_data_stage_4 to i8*, !nanotube.pipeline !0
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %_stage_47, i8* %8, i64 1, i1 false)
+  %map_op_res = load i32, i32* @map_result_stage_4
+  %9 = zext i32 %map_op_res to i64
+  %map_cancel_stage_4 = icmp ne i32 %type_stage_4, 0
+  %10 = select i1 %map_cancel_stage_4, i64 0, i64 1
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %_stage_46, i8* %_stage_47, i64 %10, i1 false)
+  %miss_stage_4 = icmp eq i64 %9, 0
+  %11 = or i1 %miss_stage_4, %map_cancel_stage_4
+  %val0_stage_4 = load i8, i8* %_stage_45, align 1
+  %val1_stage_4 = load i8, i8* %_stage_46, align 1
+  %sum_stage_4 = add i8 %val0_stage_4, %val1_stage_4
+  %res_stage_4 = select i1 %11, i8 0, i8 %sum_stage_4
+  store i8 %res_stage_4, i8* %_stage_4, align 1
+  br label %stage_4_app_send_guard, !nanotube.pipeline !1
+
+stage_4_app_send_guard:                           ; preds = %entry4
+  %stage_4sent_app_state = load i1, i1* @sent_app_state_stage_4
+  %not_eop = xor i1 %eop, true
+  store i1 %not_eop, i1* @sent_app_state_stage_4
+  br i1 %stage_4sent_app_state, label %stage_4_epilogue, label %stage_4_app_epilogue
+
+stage_4_app_epilogue:                             ; preds = %stage_4_app_send_guard
+  %live_out_state = alloca <{ [1 x i8] }>
+  %buf1_stage_4_ptr = getelementptr <{ [1 x i8] }>, <{ [1 x i8] }>* %live_out_state, i32 0, i32 0
+  %12 = bitcast [1 x i8]* %buf1_stage_4_ptr to i8*
+  %13 = bitcast [1 x i8]* %buf1_stage_4 to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %12, i8* %13, i64 1, i1 false)
+  %14 = bitcast <{ [1 x i8] }>* %live_out_state to i8*
+  call void @nanotube_channel_write(%struct.nanotube_context* %0, i32 3, i8* %14, i64 1)
+  br label %stage_4_epilogue
+
+stage_4_epilogue:                                 ; preds = %stage_4_app_epilogue, %stage_4_app_send_guard
+  call void @nanotube_channel_write(%struct.nanotube_context* %0, i32 1, i8* %packet_word, i64 65)
+  br label %exit
+
+exit:                                             ; preds = %stage_4_epilogue
+  ret void
+}
+
+define void @simple_stage_5(%struct.nanotube_context*, i8*) {
+entry:
+  %2 = load i1, i1* @have_app_state_stage_5
+  %buf1_stack_stage_5 = alloca i8
+  %buf1_stage_5 = bitcast i8* %buf1_stack_stage_5 to [1 x i8]*
+  %_stage_5 = getelementptr inbounds [1 x i8], [1 x i8]* %buf1_stage_5, i64 0, i64 0
+  br i1 %2, label %read_packet_word, label %read_app_state
+
+read_app_state:                                   ; preds = %entry
+  %read_channel = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %0, i32 2, i8* getelementptr inbounds (<{ [1 x i8] }>, <{ [1 x i8] }>* @app_state_stage_5, i32 0, i32 0, i32 0), i64 1)
+  %try_fail = icmp eq i32 %read_channel, 0
+  br i1 %try_fail, label %thread_wait_exit, label %read_app_state_post
+
+thread_wait_exit:                                 ; preds = %read_packet_word, %read_app_state
+  call void @nanotube_thread_wait()
+  ret void
+
+read_app_state_post:                              ; preds = %read_app_state
+  store i1 true, i1* @have_app_state_stage_5
+  br label %read_packet_word
+
+read_packet_word:                                 ; preds = %read_app_state_post, %entry
+  %packet_word = alloca i8, i64 65
+  %read_channel1 = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %0, i32 0, i8* %packet_word, i64 65)
+  %try_fail2 = icmp eq i32 %read_channel1, 0
+  br i1 %try_fail2, label %thread_wait_exit, label %entry_post_post
+
+entry_post_post:                                  ; preds = %read_packet_word
+  %eop = call i1 @nanotube_tap_packet_is_eop_sb(i8* %packet_word, %struct.nanotube_tap_packet_eop_state* @packet_eop_tap_state_stage_5)
+  %in_packet = xor i1 %eop, true
+  store i1 %in_packet, i1* @have_app_state_stage_5
+  br label %unmarshal_stage_5
+
+unmarshal_stage_5:                                ; preds = %entry_post_post
+  %3 = bitcast [1 x i8]* getelementptr inbounds (<{ [1 x i8] }>, <{ [1 x i8] }>* @app_state_stage_5, i32 0, i32 0) to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %buf1_stack_stage_5, i8* %3, i64 1, i1 false)
+  br label %entry3
+
+entry3:                                           ; preds = %unmarshal_stage_5
+  %packet_word.out = alloca i8, i64 65, !nanotube.pipeline !0
+  %mask = alloca i8
+  call void @llvm.memset.p0i8.i64(i8* align 1 %mask, i8 -1, i64 1, i1 false)
+  %req = alloca %struct.nanotube_tap_packet_write_req
+  %req.valid.p = getelementptr inbounds %struct.nanotube_tap_packet_write_req, %struct.nanotube_tap_packet_write_req* %req, i32 0, i32 0
+  %req.write_offset.p = getelementptr inbounds %struct.nanotube_tap_packet_write_req, %struct.nanotube_tap_packet_write_req* %req, i32 0, i32 1
+  %req.write_length.p = getelementptr inbounds %struct.nanotube_tap_packet_write_req, %struct.nanotube_tap_packet_write_req* %req, i32 0, i32 2
+  store i8 1, i8* %req.valid.p
+  store i16 8, i16* %req.write_offset.p
+  store i16 1, i16* %req.write_length.p
+  call void @nanotube_tap_packet_write_sb(i16 1, i8 1, i8* %packet_word.out, %struct.nanotube_tap_packet_write_state* @packet_write_tap_state_stage_5, i8* %packet_word, %struct.nanotube_tap_packet_write_req* %req, i8* %_stage_5, i8* %mask)
+  br label %stage_5_epilogue, !nanotube.pipeline !1
+
+stage_5_epilogue:                                 ; preds = %entry3
+  call void @nanotube_channel_write(%struct.nanotube_context* %0, i32 1, i8* %packet_word.out, i64 65)
+  br label %exit
+
+exit:                                             ; preds = %stage_5_epilogue
+  ret void
+}
+
+define void @simple_stage_6(%struct.nanotube_context*, i8*) {
+read_packet_word:
+  %packet_word = alloca i8, i64 65
+  %read_channel = call i32 @nanotube_channel_try_read(%struct.nanotube_context* %0, i32 0, i8* %packet_word, i64 65)
+  %try_fail = icmp eq i32 %read_channel, 0
+  br i1 %try_fail, label %thread_wait_exit, label %entry_post
+
+thread_wait_exit:                                 ; preds = %read_packet_word
+  call void @nanotube_thread_wait()
+  ret void
+
+entry_post:                                       ; preds = %read_packet_word
+  %eop = call i1 @nanotube_tap_packet_is_eop_sb(i8* %packet_word, %struct.nanotube_tap_packet_eop_state* @packet_eop_tap_state_stage_6)
+  br label %entry
+
+entry:                                            ; preds = %entry_post
+  br label %stage_6_epilogue, !nanotube.pipeline !1
+
+stage_6_epilogue:                                 ; preds = %entry
+  br i1 false, label %stage_6_epilogue_post, label %cond_packet_word_write
+
+cond_packet_word_write:                           ; preds = %stage_6_epilogue
+  call void @nanotube_channel_write(%struct.nanotube_context* %0, i32 1, i8* %packet_word, i64 65)
+  br label %stage_6_epilogue_post
+
+stage_6_epilogue_post:                            ; preds = %cond_packet_word_write, %stage_6_epilogue
+  br label %exit
+
+exit:                                             ; preds = %stage_6_epilogue_post
+  ret void
+}
+
+declare i32 @nanotube_channel_try_read(%struct.nanotube_context*, i32, i8*, i64)
+
+declare void @nanotube_thread_wait()
+
+declare i1 @nanotube_tap_packet_is_eop_sb(i8*, %struct.nanotube_tap_packet_eop_state*)
+
+declare void @nanotube_channel_write(%struct.nanotube_context*, i32, i8*, i64)
+
+declare void @nanotube_tap_map_send_req(%struct.nanotube_context*, %struct.nanotube_tap_map*, i32, i32, i8*, i8*)
+
+declare void @nanotube_tap_packet_read_sb(i16, i8, %struct.nanotube_tap_packet_read_resp*, i8*, %struct.nanotube_tap_packet_read_state*, i8*, %struct.nanotube_tap_packet_read_req*)
+
+declare i1 @nanotube_tap_map_recv_resp(%struct.nanotube_context*, %struct.nanotube_tap_map*, i32, i8*, i32*)
+
+; Function Attrs: argmemonly nofree nounwind willreturn writeonly
+declare void @llvm.memset.p0i8.i64(i8* nocapture writeonly, i8, i64, i1) #1
+
+declare void @nanotube_tap_packet_write_sb(i16, i8, i8*, %struct.nanotube_tap_packet_write_state*, i8*, %struct.nanotube_tap_packet_write_req*, i8*, i8*)
+
+declare %struct.nanotube_channel* @nanotube_channel_create(i8*, i64, i64)
+
+declare void @nanotube_channel_export(%struct.nanotube_channel*, i32, i32)
+
+declare void @nanotube_context_add_channel(%struct.nanotube_context*, i32, %struct.nanotube_channel*, i32)
+
+declare %struct.nanotube_tap_map* @nanotube_tap_map_create(i32, i16, i16, i64, i32)
+
+declare void @nanotube_tap_map_add_client(%struct.nanotube_tap_map*, i16, i16, i1, i16, %struct.nanotube_context*, i32, %struct.nanotube_context*, i32)
+
+declare void @nanotube_tap_map_build(%struct.nanotube_tap_map*)
+
+declare void @nanotube_thread_create(%struct.nanotube_context*, i8*, void (%struct.nanotube_context*, i8*)*, i8*, i64)
+
+attributes #0 = { inaccessiblemem_or_argmemonly }
+attributes #1 = { argmemonly nounwind }
+
+!0 = !{!"app_entry"}
+!1 = !{!"app_exit"}
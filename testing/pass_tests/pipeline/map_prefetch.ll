@@ -0,0 +1,77 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; OPTIONS = -pipeline-map-prefetch
+;
+; The request of map 0 has a constant key and moves to the first stage.
+; The type of the map 1 access depends on the packet, so its request is
+; sent as a read speculatively and the response is cancelled if the type
+; is not a read.  The undef in that type is resolved to a no-op.
+source_filename = "testing/pass_tests/pipeline/map_prefetch.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+%struct.nanotube_map = type opaque
+
+@.str = private unnamed_addr constant [7 x i8] c"simple\00", align 1
+
+define dso_local i32 @simple(%struct.nanotube_context* %context, %struct.nanotube_packet* %packet) {
+entry:
+  %key0 = alloca i32, align 4
+  %key1 = alloca i32, align 4
+  %buf0 = alloca [1 x i8], align 1
+  %buf1 = alloca [1 x i8], align 1
+  %data0 = alloca [1 x i8], align 1
+  %data1 = alloca [1 x i8], align 1
+  %0 = bitcast i32* %key0 to i8*
+  %1 = bitcast i32* %key1 to i8*
+  %2 = getelementptr inbounds [1 x i8], [1 x i8]* %buf0, i64 0, i64 0
+  %3 = getelementptr inbounds [1 x i8], [1 x i8]* %buf1, i64 0, i64 0
+  %4 = getelementptr inbounds [1 x i8], [1 x i8]* %data0, i64 0, i64 0
+  %5 = getelementptr inbounds [1 x i8], [1 x i8]* %data1, i64 0, i64 0
+  store i32 67305985, i32* %key0, align 4
+  store i32 134678021, i32* %key1, align 4
+  %rd0 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %2, i64 0, i64 1)
+  %byte = load i8, i8* %2, align 1
+  %rd1 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %3, i64 8, i64 1)
+  %call0 = call i64 @nanotube_map_op(%struct.nanotube_context* %context, i16 zeroext 0, i32 0, i8* %0, i64 4, i8* null, i8* %4, i8* null, i64 0, i64 1)
+  %is_zero = icmp eq i8 %byte, 0
+  %type = select i1 %is_zero, i32 0, i32 undef
+  %call1 = call i64 @nanotube_map_op(%struct.nanotube_context* %context, i16 zeroext 1, i32 %type, i8* %1, i64 4, i8* null, i8* %5, i8* null, i64 0, i64 1)
+  %miss = icmp eq i64 %call1, 0
+  %val0 = load i8, i8* %4, align 1
+  %val1 = load i8, i8* %5, align 1
+  %sum = add i8 %val0, %val1
+  %res = select i1 %miss, i8 0, i8 %sum
+  store i8 %res, i8* %3, align 1
+  %wr = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %3, i64 8, i64 1)
+  ret i32 0
+}
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_packet_write(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_map_op(%struct.nanotube_context*, i16 zeroext, i32, i8*, i64, i8*, i8*, i8*, i64, i64)
+
+define dso_local void @nanotube_setup() {
+entry:
+  %map0 = call %struct.nanotube_map* @nanotube_map_create(i16 zeroext 0, i32 0, i64 4, i64 1)
+  %map1 = call %struct.nanotube_map* @nanotube_map_create(i16 zeroext 1, i32 0, i64 4, i64 1)
+  %context = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_context_add_map(%struct.nanotube_context* %context, %struct.nanotube_map* %map0)
+  call void @nanotube_context_add_map(%struct.nanotube_context* %context, %struct.nanotube_map* %map1)
+  call void @nanotube_add_plain_packet_kernel(i8* getelementptr inbounds ([7 x i8], [7 x i8]* @.str, i64 0, i64 0), i32 (%struct.nanotube_context*, %struct.nanotube_packet*)* @simple, i32 0, i32 1)
+  ret void
+}
+
+declare %struct.nanotube_map* @nanotube_map_create(i16 zeroext, i32, i64, i64)
+
+declare %struct.nanotube_context* @nanotube_context_create()
+
+declare void @nanotube_context_add_map(%struct.nanotube_context*, %struct.nanotube_map*)
+
+declare void @nanotube_add_plain_packet_kernel(i8*, i32 (%struct.nanotube_context*, %struct.nanotube_packet*)*, i32, i32)
@@ -0,0 +1,107 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+source_filename = "testing/pass_tests/specialise-maps/static_maps.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+%struct.nanotube_map = type opaque
+
+@.str = private unnamed_addr constant [7 x i8] c"kernel\00", align 1
+@map1_data = private constant [32 x i8] c"\01\02\03\04\05\06\07\08\09\0A\00\00\00\00\00\00\00\00\00\00\00\00\00\00\00\00\00\00\00\00\00\00"
+@map2_keys = private constant [16 x i16] [i16 5376, i16 13568, i16 -5620, i16 5376, i16 5376, i16 5376, i16 5376, i16 5376, i16 -17663, i16 20480, i16 5376, i16 6400, i16 -28928, i16 28160, i16 -28641, i16 5632]
+@map2_data = private constant [16 x i32] [i32 167772160, i32 33554432, i32 134217728, i32 0, i32 0, i32 0, i32 0, i32 0, i32 50331648, i32 16777216, i32 0, i32 83886080, i32 117440512, i32 100663296, i32 150994944, i32 67108864]
+
+define dso_local void @kernel(%struct.nanotube_context* %context, %struct.nanotube_packet* %packet) {
+entry:
+  %key4 = alloca [4 x i8], align 1
+  %key2 = alloca [2 x i8], align 1
+  %data0 = alloca [2 x i8], align 1
+  %data1a = alloca [1 x i8], align 1
+  %data1b = alloca [1 x i8], align 1
+  %data2 = alloca [4 x i8], align 1
+  %key4.ptr = getelementptr inbounds [4 x i8], [4 x i8]* %key4, i64 0, i64 0
+  %key2.ptr = getelementptr inbounds [2 x i8], [2 x i8]* %key2, i64 0, i64 0
+  %data0.ptr = getelementptr inbounds [2 x i8], [2 x i8]* %data0, i64 0, i64 0
+  %data1a.ptr = getelementptr inbounds [1 x i8], [1 x i8]* %data1a, i64 0, i64 0
+  %data1b.ptr = getelementptr inbounds [1 x i8], [1 x i8]* %data1b, i64 0, i64 0
+  %data2.ptr = getelementptr inbounds [4 x i8], [4 x i8]* %data2, i64 0, i64 0
+  %rd0 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %key4.ptr, i64 0, i64 4)
+  %rd1 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %key2.ptr, i64 4, i64 2)
+  %0 = bitcast i8* %key4.ptr to i32*
+  %map_key = load i32, i32* %0, align 1
+  %map_match = icmp eq i32 %map_key, 16777226
+  %map_match1 = icmp eq i32 %map_key, 33554442
+  %map_match2 = or i1 %map_match, %map_match1
+  %map_data = select i1 %map_match2, i16 8721, i16 0
+  %map_match3 = icmp eq i32 %map_key, 50331658
+  %map_hit = or i1 %map_match2, %map_match3
+  %map_data4 = select i1 %map_match3, i16 17459, i16 %map_data
+  %1 = bitcast i8* %data0.ptr to i16*
+  store i16 %map_data4, i16* %1, align 1
+  %map_length = select i1 %map_hit, i64 2, i64 0
+  %2 = bitcast i8* %key4.ptr to i32*
+  %map_key5 = load i32, i32* %2, align 1
+  %map_hit6 = icmp ult i32 %map_key5, 32
+  %3 = zext i32 %map_key5 to i64
+  %map_index = select i1 %map_hit6, i64 %3, i64 0
+  %4 = getelementptr inbounds [32 x i8], [32 x i8]* @map1_data, i64 0, i64 %map_index
+  %map_rom_data = load i8, i8* %4
+  %map_data7 = select i1 %map_hit6, i8 %map_rom_data, i8 0
+  store i8 %map_data7, i8* %data1a.ptr, align 1
+  %map_length8 = select i1 %map_hit6, i64 1, i64 0
+  %5 = bitcast i8* %key4.ptr to i32*
+  %map_key9 = load i32, i32* %5, align 1
+  %map_hit10 = icmp ult i32 %map_key9, 32
+  %6 = zext i32 %map_key9 to i64
+  %map_index11 = select i1 %map_hit10, i64 %6, i64 0
+  %7 = getelementptr inbounds [32 x i8], [32 x i8]* @map1_data, i64 0, i64 %map_index11
+  %map_rom_data12 = load i8, i8* %7
+  %map_data13 = select i1 %map_hit10, i8 %map_rom_data12, i8 0
+  store i8 %map_data13, i8* %data1b.ptr, align 1
+  %map_length14 = select i1 %map_hit10, i64 1, i64 0
+  %8 = bitcast i8* %key2.ptr to i16*
+  %map_key15 = load i16, i16* %8, align 1
+  %9 = zext i16 %map_key15 to i64
+  %map_hash = mul i64 %9, -3465416668130893107
+  %map_index16 = lshr i64 %map_hash, 60
+  %10 = getelementptr inbounds [16 x i16], [16 x i16]* @map2_keys, i64 0, i64 %map_index16
+  %map_rom_key = load i16, i16* %10
+  %map_hit17 = icmp eq i16 %map_rom_key, %map_key15
+  %11 = getelementptr inbounds [16 x i32], [16 x i32]* @map2_data, i64 0, i64 %map_index16
+  %map_rom_data18 = load i32, i32* %11
+  %map_data19 = select i1 %map_hit17, i32 %map_rom_data18, i32 0
+  %12 = bitcast i8* %data2.ptr to i32*
+  store i32 %map_data19, i32* %12, align 1
+  %map_length20 = select i1 %map_hit17, i64 4, i64 0
+  %wr0 = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %data0.ptr, i64 8, i64 %map_length)
+  %wr0n = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %data0.ptr, i64 10, i64 0)
+  %wr1a = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %data1a.ptr, i64 12, i64 %map_length8)
+  %wr1b = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %data1b.ptr, i64 13, i64 %map_length14)
+  %wr2 = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %data2.ptr, i64 14, i64 %map_length20)
+  ret void
+}
+
+define dso_local void @nanotube_setup() {
+entry:
+  %context = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_add_plain_packet_kernel(i8* getelementptr inbounds ([7 x i8], [7 x i8]* @.str, i64 0, i64 0), void (%struct.nanotube_context*, %struct.nanotube_packet*)* @kernel, i32 0, i32 1)
+  ret void
+}
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_packet_write(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_map_op(%struct.nanotube_context*, i16 zeroext, i32, i8*, i64, i8*, i8*, i8*, i64, i64)
+
+declare %struct.nanotube_map* @nanotube_map_create(i16 zeroext, i32, i64, i64)
+
+declare %struct.nanotube_context* @nanotube_context_create()
+
+declare void @nanotube_context_add_map(%struct.nanotube_context*, %struct.nanotube_map*)
+
+declare void @nanotube_add_plain_packet_kernel(i8*, void (%struct.nanotube_context*, %struct.nanotube_packet*)*, i32, i32)
@@ -0,0 +1,74 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+; SPDX-License-Identifier: MIT
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; OPTIONS = -map-snapshot=testing/pass_tests/specialise-maps/static_maps.snapshot
+;
+; Map 0 is matched with comparisons.  Its second read has no data
+; buffer, so it returns zero.  Both reads of map 1 share the same ROM
+; and map 2 uses a perfect hash.
+source_filename = "testing/pass_tests/specialise-maps/static_maps.ll"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+%struct.nanotube_context = type opaque
+%struct.nanotube_packet = type opaque
+%struct.nanotube_map = type opaque
+
+@.str = private unnamed_addr constant [7 x i8] c"kernel\00", align 1
+
+define dso_local void @kernel(%struct.nanotube_context* %context, %struct.nanotube_packet* %packet) {
+entry:
+  %key4 = alloca [4 x i8], align 1
+  %key2 = alloca [2 x i8], align 1
+  %data0 = alloca [2 x i8], align 1
+  %data1a = alloca [1 x i8], align 1
+  %data1b = alloca [1 x i8], align 1
+  %data2 = alloca [4 x i8], align 1
+  %key4.ptr = getelementptr inbounds [4 x i8], [4 x i8]* %key4, i64 0, i64 0
+  %key2.ptr = getelementptr inbounds [2 x i8], [2 x i8]* %key2, i64 0, i64 0
+  %data0.ptr = getelementptr inbounds [2 x i8], [2 x i8]* %data0, i64 0, i64 0
+  %data1a.ptr = getelementptr inbounds [1 x i8], [1 x i8]* %data1a, i64 0, i64 0
+  %data1b.ptr = getelementptr inbounds [1 x i8], [1 x i8]* %data1b, i64 0, i64 0
+  %data2.ptr = getelementptr inbounds [4 x i8], [4 x i8]* %data2, i64 0, i64 0
+  %rd0 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %key4.ptr, i64 0, i64 4)
+  %rd1 = call i64 @nanotube_packet_read(%struct.nanotube_packet* %packet, i8* %key2.ptr, i64 4, i64 2)
+  %len0 = call i64 @nanotube_map_op(%struct.nanotube_context* %context, i16 zeroext 0, i32 0, i8* %key4.ptr, i64 4, i8* null, i8* %data0.ptr, i8* null, i64 0, i64 2)
+  %len0n = call i64 @nanotube_map_op(%struct.nanotube_context* %context, i16 zeroext 0, i32 0, i8* %key4.ptr, i64 4, i8* null, i8* null, i8* null, i64 0, i64 2)
+  %len1a = call i64 @nanotube_map_op(%struct.nanotube_context* %context, i16 zeroext 1, i32 0, i8* %key4.ptr, i64 4, i8* null, i8* %data1a.ptr, i8* null, i64 0, i64 1)
+  %len1b = call i64 @nanotube_map_op(%struct.nanotube_context* %context, i16 zeroext 1, i32 0, i8* %key4.ptr, i64 4, i8* null, i8* %data1b.ptr, i8* null, i64 0, i64 1)
+  %len2 = call i64 @nanotube_map_op(%struct.nanotube_context* %context, i16 zeroext 2, i32 0, i8* %key2.ptr, i64 2, i8* null, i8* %data2.ptr, i8* null, i64 0, i64 4)
+  %wr0 = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %data0.ptr, i64 8, i64 %len0)
+  %wr0n = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %data0.ptr, i64 10, i64 %len0n)
+  %wr1a = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %data1a.ptr, i64 12, i64 %len1a)
+  %wr1b = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %data1b.ptr, i64 13, i64 %len1b)
+  %wr2 = call i64 @nanotube_packet_write(%struct.nanotube_packet* %packet, i8* %data2.ptr, i64 14, i64 %len2)
+  ret void
+}
+
+define dso_local void @nanotube_setup() {
+entry:
+  %map0 = call %struct.nanotube_map* @nanotube_map_create(i16 zeroext 0, i32 0, i64 4, i64 2)
+  %map1 = call %struct.nanotube_map* @nanotube_map_create(i16 zeroext 1, i32 2, i64 4, i64 1)
+  %map2 = call %struct.nanotube_map* @nanotube_map_create(i16 zeroext 2, i32 0, i64 2, i64 4)
+  %context = call %struct.nanotube_context* @nanotube_context_create()
+  call void @nanotube_context_add_map(%struct.nanotube_context* %context, %struct.nanotube_map* %map0)
+  call void @nanotube_context_add_map(%struct.nanotube_context* %context, %struct.nanotube_map* %map1)
+  call void @nanotube_context_add_map(%struct.nanotube_context* %context, %struct.nanotube_map* %map2)
+  call void @nanotube_add_plain_packet_kernel(i8* getelementptr inbounds ([7 x i8], [7 x i8]* @.str, i64 0, i64 0), void (%struct.nanotube_context*, %struct.nanotube_packet*)* @kernel, i32 0, i32 1)
+  ret void
+}
+
+declare i64 @nanotube_packet_read(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_packet_write(%struct.nanotube_packet*, i8*, i64, i64)
+
+declare i64 @nanotube_map_op(%struct.nanotube_context*, i16 zeroext, i32, i8*, i64, i8*, i8*, i8*, i64, i64)
+
+declare %struct.nanotube_map* @nanotube_map_create(i16 zeroext, i32, i64, i64)
+
+declare %struct.nanotube_context* @nanotube_context_create()
+
+declare void @nanotube_context_add_map(%struct.nanotube_context*, %struct.nanotube_map*)
+
+declare void @nanotube_add_plain_packet_kernel(i8*, void (%struct.nanotube_context*, %struct.nanotube_packet*)*, i32, i32)
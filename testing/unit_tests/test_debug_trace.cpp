@@ -0,0 +1,173 @@
+/**************************************************************************\
+*//*! \file test_debug_trace.cpp
+**  \brief  A test for the binary debug trace.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+#include "nanotube_api.h"
+#include "test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+struct trace_record
+{
+  uint64_t id;
+  uint64_t value;
+  uint64_t seq;
+};
+
+// Read a trace file, returning the records in sequence order.
+static std::vector<trace_record> read_trace(const char *filename)
+{
+  std::ifstream in(filename, std::ios::binary);
+  std::vector<char> data((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+
+  static const size_t magic_len = 8;
+  assert_eq(data.size() >= magic_len, true);
+  assert_eq(memcmp(data.data(), "NTTRACE1", magic_len), 0);
+  assert_eq((data.size() - magic_len) % sizeof(trace_record), size_t(0));
+
+  size_t num = (data.size() - magic_len) / sizeof(trace_record);
+  std::vector<trace_record> records(num);
+  memcpy(records.data(), data.data() + magic_len,
+         num * sizeof(trace_record));
+
+  std::vector<trace_record> sorted(num);
+  for (auto &rec: records) {
+    assert_eq(rec.seq < num, true);
+    sorted[rec.seq] = rec;
+  }
+  return sorted;
+}
+
+static void trace_thread(uint64_t id, uint64_t count)
+{
+  for (uint64_t i=0; i<count; i++)
+    nanotube_debug_trace(id, i);
+}
+
+static void trace_until(uint64_t id, const std::atomic<bool> *stop)
+{
+  for (uint64_t i=0; !stop->load(); i++)
+    nanotube_debug_trace(id, i);
+}
+
+void test_debug_trace()
+{
+  char filename[] = "/tmp/test_debug_trace.XXXXXX";
+  int fd = mkstemp(filename);
+  assert_eq(fd >= 0, true);
+  close(fd);
+
+  static const unsigned num_threads = 4;
+  static const uint64_t num_calls = 20000;
+
+  std::cout << "Case  1: Concurrent threads\n";
+  {
+    int rc = nanotube_debug_trace_open(filename, 1, 0, ~uint64_t(0));
+    assert_eq(rc, 0);
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<num_threads; t++)
+      threads.emplace_back(trace_thread, t, num_calls);
+    for (auto &thread: threads)
+      thread.join();
+    rc = nanotube_debug_trace_close();
+    assert_eq(rc, 0);
+
+    auto records = read_trace(filename);
+    assert_eq(records.size(), size_t(num_threads * num_calls));
+
+    // The values of each thread appear in order.
+    std::vector<uint64_t> next(num_threads, 0);
+    for (auto &rec: records) {
+      assert_eq(rec.id < num_threads, true);
+      assert_eq(rec.value, next[rec.id]);
+      next[rec.id]++;
+    }
+  }
+
+  std::cout << "Case  2: Sampling and ID range\n";
+  {
+    int rc = nanotube_debug_trace_open(filename, 4, 1, 2);
+    assert_eq(rc, 0);
+    for (uint64_t i=0; i<100; i++)
+      nanotube_debug_trace(i % 4, i);
+    rc = nanotube_debug_trace_close();
+    assert_eq(rc, 0);
+
+    // IDs 1 and 2 are selected, then every 4th call is recorded.
+    auto records = read_trace(filename);
+    assert_eq(records.size(), size_t(13));
+    for (size_t i=0; i<records.size(); i++) {
+      uint64_t call = i * 4;
+      uint64_t value = (call / 2) * 4 + 1 + (call % 2);
+      assert_eq(records[i].id, value % 4);
+      assert_eq(records[i].value, value);
+    }
+  }
+
+  std::cout << "Case  3: Close while tracing\n";
+  {
+    // Redirect the calls made after the close away from the test
+    // output.
+    FILE *saved_stderr = fdopen(dup(fileno(stderr)), "w");
+    assert_eq(freopen("/dev/null", "w", stderr) != nullptr, true);
+
+    int rc = nanotube_debug_trace_open(filename, 1, 0, ~uint64_t(0));
+    assert_eq(rc, 0);
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> threads;
+    for (unsigned t=0; t<num_threads; t++)
+      threads.emplace_back(trace_until, t, &stop);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    rc = nanotube_debug_trace_close();
+    assert_eq(rc, 0);
+    stop = true;
+    for (auto &thread: threads)
+      thread.join();
+
+    fflush(stderr);
+    dup2(fileno(saved_stderr), fileno(stderr));
+    fclose(saved_stderr);
+
+    // Each thread recorded a prefix of its values.
+    auto records = read_trace(filename);
+    std::vector<uint64_t> next(num_threads, 0);
+    for (auto &rec: records) {
+      assert_eq(rec.id < num_threads, true);
+      assert_eq(rec.value, next[rec.id]);
+      next[rec.id]++;
+    }
+  }
+
+  unlink(filename);
+}
+
+int main(int argc, char *argv[])
+{
+  test_init(argc, argv);
+  test_debug_trace();
+  return test_fini();
+}
+
+///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,114 @@
+/**************************************************************************\
+*//*! \file test_ebpf_adapter.cpp
+**  \brief  Unit tests for the XDP result and redirect adapters.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+#include "ebpf_nt_adapter.h"
+#include "nanotube_api.h"
+#include "nanotube_context.hpp"
+#include "nanotube_packet.hpp"
+#include "test.hpp"
+
+#include <iostream>
+
+extern "C" {
+#include <linux/bpf.h>
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+static const nanotube_packet_port_t in_port = 3;
+
+// Handle an XDP result for a packet which arrived on in_port.
+static void check_result(int xdp_ret, nanotube_kernel_rc_t exp_rc,
+                         nanotube_packet_port_t exp_port)
+{
+  nanotube_packet_t packet;
+  nanotube_packet_set_port(&packet, in_port);
+  nanotube_kernel_rc_t rc = packet_handle_xdp_result(&packet, xdp_ret);
+  assert_eq(rc, exp_rc);
+  if (rc == NANOTUBE_PACKET_PASS)
+    assert_eq(nanotube_packet_get_port(&packet), exp_port);
+}
+
+// Write a port into a redirect map.
+static void set_redirect(nanotube_context_t *ctx, nanotube_map_id_t id,
+                         uint32_t key, uint32_t port)
+{
+  uint8_t key_buf[4];
+  uint8_t value_buf[4];
+  for (unsigned i=0; i<4; i++) {
+    key_buf[i] = uint8_t(key >> (8*i));
+    value_buf[i] = uint8_t(port >> (8*i));
+  }
+  size_t rc = nanotube_map_write(ctx, id, key_buf, sizeof(key_buf),
+                                 value_buf, 0, sizeof(value_buf));
+  assert_eq(rc, sizeof(value_buf));
+}
+
+void test_ebpf_adapter()
+{
+  std::cout << "Case  1: XDP results\n";
+  {
+    check_result(XDP_PASS, NANOTUBE_PACKET_PASS, in_port);
+    check_result(XDP_TX, NANOTUBE_PACKET_PASS, in_port);
+    check_result(XDP_DROP, NANOTUBE_PACKET_DROP, in_port);
+    check_result(XDP_ABORTED, NANOTUBE_PACKET_DROP, in_port);
+  }
+
+  std::cout << "Case  2: Redirect to an interface\n";
+  {
+    nanotube_packet_t packet;
+    nanotube_packet_set_port(&packet, in_port);
+    assert_eq(packet_redirect_adapter(&packet, 5, 0), XDP_REDIRECT);
+    assert_eq(packet_handle_xdp_result(&packet, XDP_REDIRECT),
+              NANOTUBE_PACKET_PASS);
+    assert_eq(nanotube_packet_get_port(&packet), 5);
+
+    // The control port cannot be used as an interface.
+    nanotube_packet_set_port(&packet, in_port);
+    assert_eq(packet_redirect_adapter(&packet, NANOTUBE_PORT_CONTROL, 0),
+              XDP_ABORTED);
+    assert_eq(nanotube_packet_get_port(&packet), in_port);
+  }
+
+  std::cout << "Case  3: Redirect through a map\n";
+  {
+    nanotube_context_t ctx;
+    const nanotube_map_id_t id = 2;
+    nanotube_map_t *map = nanotube_map_create(id, NANOTUBE_MAP_TYPE_HASH,
+                                              4, 4);
+    nanotube_context_add_map(&ctx, map);
+    set_redirect(&ctx, id, 1, 7);
+
+    nanotube_packet_t packet;
+    nanotube_packet_set_port(&packet, in_port);
+    assert_eq(packet_redirect_map_adapter(&ctx, &packet, id, 1, 0),
+              XDP_REDIRECT);
+    assert_eq(nanotube_packet_get_port(&packet), 7);
+
+    // A missing key returns the action in the lower bits of the flags
+    // and leaves the port alone.
+    nanotube_packet_set_port(&packet, in_port);
+    assert_eq(packet_redirect_map_adapter(&ctx, &packet, id, 2, XDP_TX),
+              XDP_TX);
+    assert_eq(packet_redirect_map_adapter(&ctx, &packet, id, 2,
+                                          0x10 | XDP_PASS),
+              XDP_PASS);
+    assert_eq(nanotube_packet_get_port(&packet), in_port);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  test_init(argc, argv);
+  test_ebpf_adapter();
+  return test_fini();
+}
+
+///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,178 @@
+/**************************************************************************\
+*//*! \file test_map_capsules.cpp
+** \brief  Unit tests for map control capsule processing.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "nanotube_api.h"
+#include "nanotube_capsule.h"
+#include "nanotube_context.hpp"
+#include "test.hpp"
+
+static const size_t key_len = 4;
+static const size_t value_len = 8;
+static const size_t max_entries = 8;
+
+static uint16_t get_u16(const uint8_t *ptr)
+{
+  return uint16_t(ptr[0]) | (uint16_t(ptr[1]) << 8);
+}
+
+static void set_u16(uint8_t *ptr, uint16_t val)
+{
+  ptr[0] = uint8_t(val);
+  ptr[1] = uint8_t(val >> 8);
+}
+
+static uint8_t *entry_ptr(uint8_t *capsule, size_t index)
+{
+  return ( capsule + NANOTUBE_CAPSULE_MAP_BATCH_ENTRIES_OFFSET +
+           index*NANOTUBE_CAPSULE_MAP_ENTRY_SIZE(key_len, value_len) );
+}
+
+static void set_entry(uint8_t *capsule, size_t index, uint16_t opcode,
+                      uint32_t key, uint8_t value)
+{
+  uint8_t *entry = entry_ptr(capsule, index);
+  set_u16(entry + NANOTUBE_CAPSULE_MAP_ENTRY_OPCODE_OFFSET, opcode);
+  set_u16(entry + NANOTUBE_CAPSULE_MAP_ENTRY_RESPONSE_CODE_OFFSET,
+          NANOTUBE_CAPSULE_RESPONSE_CODE_UNHANDLED);
+  uint8_t *key_ptr =
+    entry + NANOTUBE_CAPSULE_MAP_ENTRY_KEY_OFFSET(key_len, value_len);
+  for (size_t i=0; i<key_len; i++)
+    key_ptr[i] = uint8_t(key >> (8*i));
+  uint8_t *value_ptr =
+    entry + NANOTUBE_CAPSULE_MAP_ENTRY_VALUE_OFFSET(key_len, value_len);
+  memset(value_ptr, value, value_len);
+}
+
+static void print_entry(uint8_t *capsule, size_t index)
+{
+  uint8_t *entry = entry_ptr(capsule, index);
+  uint8_t *key_ptr =
+    entry + NANOTUBE_CAPSULE_MAP_ENTRY_KEY_OFFSET(key_len, value_len);
+  uint8_t *value_ptr =
+    entry + NANOTUBE_CAPSULE_MAP_ENTRY_VALUE_OFFSET(key_len, value_len);
+  printf("  %zu: rc=%u key=", index,
+         get_u16(entry + NANOTUBE_CAPSULE_MAP_ENTRY_RESPONSE_CODE_OFFSET));
+  for (size_t i=0; i<key_len; i++)
+    printf("%02x", key_ptr[i]);
+  printf(" value=");
+  for (size_t i=0; i<value_len; i++)
+    printf("%02x", value_ptr[i]);
+  printf("\n");
+}
+
+static void init_batch(uint8_t *capsule, size_t count)
+{
+  memset(capsule, 0,
+         NANOTUBE_CAPSULE_MAP_BATCH_CAPSULE_SIZE(key_len, value_len,
+                                                 max_entries));
+  set_u16(capsule + NANOTUBE_CAPSULE_RESPONSE_CODE_OFFSET,
+          NANOTUBE_CAPSULE_RESPONSE_CODE_UNHANDLED);
+  set_u16(capsule + NANOTUBE_CAPSULE_MAP_OPCODE_OFFSET,
+          NANOTUBE_CAPSULE_MAP_OPCODE_BATCH);
+  set_u16(capsule + NANOTUBE_CAPSULE_MAP_BATCH_COUNT_OFFSET, count);
+}
+
+static void process_batch(nanotube_context_t *ctx, nanotube_map_id_t id,
+                          uint8_t *capsule, size_t count)
+{
+  nanotube_map_process_capsule_batch(ctx, id, capsule, key_len, value_len,
+                                     max_entries);
+  printf("Batch of %zu: rc=%u\n", count,
+         get_u16(capsule + NANOTUBE_CAPSULE_RESPONSE_CODE_OFFSET));
+  for (size_t i=0; i<count; i++)
+    print_entry(capsule, i);
+}
+
+static void test_capsules(enum map_type_t type, const char *name)
+{
+  printf("\n_Testing_%s_capsules_\n", name);
+
+  auto* ctx = new nanotube_context();
+  const nanotube_map_id_t id = 7;
+  nanotube_map_t* map = nanotube_map_create(id, type, key_len, value_len);
+  nanotube_context_add_map(ctx, map);
+
+  uint8_t capsule[NANOTUBE_CAPSULE_MAP_BATCH_CAPSULE_SIZE(key_len,
+                                                          value_len,
+                                                          max_entries)];
+
+  // Write a batch of entries and read them back.
+  uint16_t write_op = ( type == NANOTUBE_MAP_TYPE_HASH ?
+                        NANOTUBE_CAPSULE_MAP_OPCODE_WRITE :
+                        NANOTUBE_CAPSULE_MAP_OPCODE_UPDATE );
+  init_batch(capsule, 4);
+  for (size_t i=0; i<4; i++)
+    set_entry(capsule, i, write_op, 3*i+1, 0x10+i);
+  process_batch(ctx, id, capsule, 4);
+
+  init_batch(capsule, 5);
+  for (size_t i=0; i<5; i++)
+    set_entry(capsule, i, NANOTUBE_CAPSULE_MAP_OPCODE_READ, 3*i+1, 0);
+  process_batch(ctx, id, capsule, 5);
+
+  // Iterate over the map starting from a missing key.  Only print the
+  // number of keys found for hash maps since their order is not
+  // defined.
+  uint8_t single[NANOTUBE_CAPSULE_MAP_CAPSULE_SIZE(key_len, value_len)];
+  uint8_t *key_ptr =
+    single + NANOTUBE_CAPSULE_MAP_KEY_OFFSET(key_len, value_len);
+  memset(single, 0, sizeof(single));
+  memset(key_ptr, 0xff, key_len);
+  unsigned found = 0;
+  unsigned nonzero = 0;
+  while (found < 100) {
+    set_u16(single + NANOTUBE_CAPSULE_MAP_OPCODE_OFFSET,
+            NANOTUBE_CAPSULE_MAP_OPCODE_NEXT_KEY);
+    nanotube_map_process_capsule(ctx, id, single, key_len, value_len);
+    uint16_t rc = get_u16(single + NANOTUBE_CAPSULE_RESPONSE_CODE_OFFSET);
+    if (rc != NANOTUBE_CAPSULE_RESPONSE_CODE_SUCCESS)
+      break;
+    found++;
+    uint8_t *value_ptr =
+      single + NANOTUBE_CAPSULE_MAP_VALUE_OFFSET(key_len, value_len);
+    if (value_ptr[0] != 0)
+      nonzero++;
+  }
+  printf("Iteration found %u keys, %u with non-zero values\n",
+         found, nonzero);
+
+  // Remove an entry from a hash map and check it has gone.
+  if (type == NANOTUBE_MAP_TYPE_HASH) {
+    init_batch(capsule, 3);
+    set_entry(capsule, 0, NANOTUBE_CAPSULE_MAP_OPCODE_REMOVE, 4, 0);
+    set_entry(capsule, 1, NANOTUBE_CAPSULE_MAP_OPCODE_READ, 4, 0);
+    set_entry(capsule, 2, NANOTUBE_CAPSULE_MAP_OPCODE_READ, 7, 0);
+    process_batch(ctx, id, capsule, 3);
+  }
+
+  // Unknown opcodes and oversized batches are rejected.
+  init_batch(capsule, 1);
+  set_entry(capsule, 0, 99, 1, 0);
+  process_batch(ctx, id, capsule, 1);
+
+  init_batch(capsule, max_entries+1);
+  nanotube_map_process_capsule_batch(ctx, id, capsule, key_len, value_len,
+                                     max_entries);
+  printf("Batch of %zu: rc=%u\n", max_entries+1,
+         get_u16(capsule + NANOTUBE_CAPSULE_RESPONSE_CODE_OFFSET));
+
+  delete ctx;
+}
+
+int main(int argc, char *argv[]) {
+  test_init(argc, argv);
+  test_capsules(NANOTUBE_MAP_TYPE_HASH, "hash");
+  test_capsules(NANOTUBE_MAP_TYPE_ARRAY_LE, "array");
+  return test_fini();
+}
+/* vim: set ts=8 et sw=2 sts=2 tw=75: */
@@ -0,0 +1,176 @@
+/**************************************************************************\
+*//*! \file test_sim.cpp
+**  \brief  A test for the cycle-approximate simulation mode.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+#include "nanotube_api.h"
+#include "nanotube_channel.hpp"
+#include "nanotube_packet.hpp"
+#include "processing_system.hpp"
+#include "simple_bus.hpp"
+#include "test.hpp"
+
+#include <iostream>
+#include <sstream>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+///////////////////////////////////////////////////////////////////////////
+
+// A simple bus word with 64 bytes of data.
+static const size_t word_size = simple_bus::bus_traits<6>::total_bytes;
+
+// Each packet is five bus words.
+static const size_t packet_size = 256;
+static const unsigned num_packets = 10;
+
+// A stage which forwards each word.
+static void forward_func(nanotube_context_t *context, void *data)
+{
+  uint8_t word[word_size];
+  if (!nanotube_channel_try_read(context, 0, word, word_size)) {
+    nanotube_thread_wait();
+    return;
+  }
+  nanotube_channel_write(context, 1, word, word_size);
+}
+
+// A pipeline of two forwarding stages.
+void nanotube_setup()
+{
+  auto *packets_in = nanotube_channel_create("packets_in", word_size, 4);
+  auto *mid = nanotube_channel_create("mid", word_size, 4);
+  auto *packets_out = nanotube_channel_create("packets_out", word_size, 4);
+  nanotube_channel_export(packets_in, NANOTUBE_CHANNEL_TYPE_SIMPLE_PACKET,
+                          NANOTUBE_CHANNEL_WRITE);
+  nanotube_channel_export(packets_out, NANOTUBE_CHANNEL_TYPE_SIMPLE_PACKET,
+                          NANOTUBE_CHANNEL_READ);
+
+  auto *context_0 = nanotube_context_create();
+  nanotube_context_add_channel(context_0, 0, packets_in,
+                               NANOTUBE_CHANNEL_READ);
+  nanotube_context_add_channel(context_0, 1, mid, NANOTUBE_CHANNEL_WRITE);
+  nanotube_thread_create(context_0, "stage_0", forward_func, nullptr, 0);
+
+  auto *context_1 = nanotube_context_create();
+  nanotube_context_add_channel(context_1, 0, mid, NANOTUBE_CHANNEL_READ);
+  nanotube_context_add_channel(context_1, 1, packets_out,
+                               NANOTUBE_CHANNEL_WRITE);
+  nanotube_thread_create(context_1, "stage_1", forward_func, nullptr, 0);
+}
+
+// Simulate the pipeline and return the report.
+static boost::property_tree::ptree
+run_sim(const nanotube_sim::config_t &config)
+{
+  dummy_ps_client psc;
+  auto ps = processing_system::attach(psc, &config);
+  assert_eq(ps->kernels().size(), size_t(1));
+  packet_kernel &kernel = *(ps->kernels()[0]);
+
+  for (unsigned i=0; i<num_packets; i++) {
+    nanotube_packet packet;
+    packet.resize(NANOTUBE_SECTION_WHOLE, packet_size);
+    kernel.process(&packet);
+    kernel.flush();
+  }
+
+  std::stringstream ss;
+  ps->get_sim()->write_report(ss, *ps);
+  processing_system::detach(ps);
+
+  boost::property_tree::ptree report;
+  boost::property_tree::read_json(ss, report);
+  return report;
+}
+
+static void print_report(const boost::property_tree::ptree &report)
+{
+  std::cout << "  Packets: " << report.get<unsigned>("packets_in")
+            << " in, " << report.get<unsigned>("packets_out")
+            << " out, " << report.get<unsigned>("words_in")
+            << " words\n"
+            << "  Latency: " << report.get<unsigned>("latency_min")
+            << " to " << report.get<unsigned>("latency_max")
+            << " cycles\n"
+            << "  Last cycle: " << report.get<unsigned>("last_out_cycle")
+            << "\n";
+  for (auto &entry: report.get_child("stages")) {
+    auto &stage = entry.second;
+    std::cout << "  Stage " << stage.get<std::string>("name")
+              << ": II " << stage.get<unsigned>("ii")
+              << ", latency " << stage.get<unsigned>("latency")
+              << ", firings " << stage.get<unsigned>("firings")
+              << ", stalled " << stage.get<unsigned>("stall_cycles")
+              << "\n";
+  }
+  for (auto &entry: report.get_child("channels")) {
+    auto &channel = entry.second;
+    std::cout << "  Channel " << channel.get<std::string>("name")
+              << ": depth " << channel.get<unsigned>("depth")
+              << ", full " << channel.get<unsigned>("full_cycles")
+              << "\n";
+  }
+}
+
+void test_sim()
+{
+  std::cout << "Case  1: Default costs\n";
+  {
+    nanotube_sim::config_t config;
+    auto report = run_sim(config);
+    print_report(report);
+
+    // Each stage adds its latency plus the channel latency.  The
+    // pipeline accepts one word per cycle.
+    assert_eq(report.get<unsigned>("latency_min"), 9u);
+    assert_eq(report.get<unsigned>("latency_max"), 9u);
+    assert_eq(report.get<unsigned>("last_out_cycle"),
+              num_packets * 5 - 1 + 5);
+  }
+
+  std::cout << "Case  2: Slow stage\n";
+  {
+    nanotube_sim::config_t config;
+    config.stage_costs["stage_1"] = std::make_pair(3u, 5u);
+    auto report = run_sim(config);
+    print_report(report);
+
+    // The second stage limits the throughput to one word every three
+    // cycles, so the packets queue up behind it.
+    assert_eq(report.get<unsigned>("last_out_cycle"),
+              3 * (num_packets * 5 - 1) + 3 + 5 + 1);
+    assert_eq(report.get<unsigned>("latency_max") >
+              report.get<unsigned>("latency_min"), true);
+  }
+
+  std::cout << "Case  3: FIFO depth and packet gap\n";
+  {
+    nanotube_sim::config_t config;
+    config.stage_costs["stage_1"] = std::make_pair(3u, 5u);
+    config.fifo_depths["mid"] = 1;
+    config.packet_gap = 16;
+    auto report = run_sim(config);
+    print_report(report);
+
+    // The packets arrive slower than the pipeline can process them,
+    // so every packet sees the same latency.
+    assert_eq(report.get<unsigned>("latency_min"),
+              report.get<unsigned>("latency_max"));
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  test_init(argc, argv);
+  test_sim();
+  return test_fini();
+}
+
+///////////////////////////////////////////////////////////////////////////
@@ -21,6 +21,52 @@
 
 ///////////////////////////////////////////////////////////////////////////
 
+// Reference model of the read-modify-write operations on little-endian
+// unsigned integers.
+static void shadow_rmw(std::vector<uint8_t> *value,
+                       const std::vector<uint8_t> &operand,
+                       enum map_access_t access)
+{
+  size_t n = value->size();
+  std::vector<uint8_t> sum(n);
+  unsigned carry = 0;
+  for (size_t i=0; i<n; i++) {
+    unsigned s = unsigned(value->at(i)) + operand.at(i) + carry;
+    sum.at(i) = uint8_t(s);
+    carry = s >> 8;
+  }
+
+  // Compare starting at the most significant byte.
+  int cmp = 0;
+  for (size_t i=n; i>0 && cmp==0; i--) {
+    cmp = int(value->at(i-1)) - int(operand.at(i-1));
+  }
+
+  switch (access) {
+  case NANOTUBE_MAP_ADD:
+    *value = sum;
+    break;
+  case NANOTUBE_MAP_ADD_SAT:
+    if (carry != 0)
+      value->assign(n, 0xff);
+    else
+      *value = sum;
+    break;
+  case NANOTUBE_MAP_MIN:
+    if (cmp > 0)
+      *value = operand;
+    break;
+  case NANOTUBE_MAP_MAX:
+    if (cmp < 0)
+      *value = operand;
+    break;
+  default:
+    assert(false);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
+
 class map_test
 {
 public:
@@ -45,6 +91,8 @@ private:
   void write(int key_id, bool exp_succ);
   void remove(int key_id, bool exp_succ);
   void read(int key_id, bool exp_succ);
+  void rmw(int key_id, enum map_access_t access, bool exp_succ);
+  void next_key(int key_id);
   void verify_all();
   bool key_is_valid(int key_id) const {
     return key_id >= 0 && key_id < m_capacity;
@@ -128,12 +176,33 @@ void map_test::run_all()
   comment("Verify the contents");
   verify_all();
 
+  comment("Add to the first entry");
+  rmw(0, NANOTUBE_MAP_ADD, true);
+
+  comment("Saturating add to the second entry");
+  for(int i=0; i<4; i++)
+    rmw(1, NANOTUBE_MAP_ADD_SAT, true);
+
+  comment("Minimum and maximum of the last entry");
+  rmw(m_capacity-1, NANOTUBE_MAP_MIN, true);
+  rmw(m_capacity-1, NANOTUBE_MAP_MAX, true);
+
+  comment("Add past the end");
+  rmw(m_capacity, NANOTUBE_MAP_ADD, false);
+
+  comment("Verify the contents");
+  verify_all();
+
   comment("Fill the table");
   for(int i=0; i<m_capacity; i++)
     write(i, true);
 
   comment("Verify the contents");
   verify_all();
+
+  comment("Iterate over the keys");
+  for(int i=0; i<=m_capacity; i++)
+    next_key(i);
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -200,6 +269,11 @@ void map_test::invoke(enum map_access_t access)
     case NANOTUBE_MAP_WRITE:  std::cout << "WRITE\n"; break;
     case NANOTUBE_MAP_REMOVE: std::cout << "REMOVE\n"; break;
     case NANOTUBE_MAP_NOP:    std::cout << "NOP\n"; break;
+    case NANOTUBE_MAP_ADD:     std::cout << "ADD\n"; break;
+    case NANOTUBE_MAP_ADD_SAT: std::cout << "ADD_SAT\n"; break;
+    case NANOTUBE_MAP_MIN:     std::cout << "MIN\n"; break;
+    case NANOTUBE_MAP_MAX:     std::cout << "MAX\n"; break;
+    case NANOTUBE_MAP_NEXT_KEY: std::cout << "NEXT_KEY\n"; break;
     }
     std::cout << "  Key:     " << std::hex << std::setfill('0');
     for (int i=0; i<m_key_length; i++) {
@@ -340,6 +414,44 @@ void map_test::read(int key_id, bool exp_succ)
   }
 }
 
+void map_test::rmw(int key_id, enum map_access_t access, bool exp_succ)
+{
+  gen_key(key_id);
+  gen_data();
+  invoke(access);
+
+  if (key_is_valid(key_id)) {
+    assert_eq(exp_succ, true);
+    assert_eq(m_result_out, NANOTUBE_MAP_RESULT_PRESENT);
+    check_data(m_shadow_map.at(key_id));
+    shadow_rmw(&m_shadow_map.at(key_id), m_data_in, access);
+  } else {
+    assert_eq(exp_succ, false);
+    assert_eq(m_result_out, NANOTUBE_MAP_RESULT_ABSENT);
+    check_data_zero();
+  }
+}
+
+void map_test::next_key(int key_id)
+{
+  gen_key(key_id);
+  gen_data();
+  invoke(NANOTUBE_MAP_NEXT_KEY);
+
+  // A key past the end restarts at the first key.
+  int next_id = (key_is_valid(key_id) ? key_id+1 : 0);
+  if (key_is_valid(next_id)) {
+    assert_eq(m_result_out, NANOTUBE_MAP_RESULT_PRESENT);
+    byte_vec_t next_data(m_data_length, 0);
+    gen_key(next_id);
+    std::copy(m_key_in.begin(), m_key_in.end(), next_data.begin());
+    check_data(next_data);
+  } else {
+    assert_eq(m_result_out, NANOTUBE_MAP_RESULT_ABSENT);
+    check_data_zero();
+  }
+}
+
 void map_test::verify_all()
 {
   for (int i=0; i<m_capacity; i++) {
@@ -21,6 +21,52 @@
 
 ///////////////////////////////////////////////////////////////////////////
 
+// Reference model of the read-modify-write operations on little-endian
+// unsigned integers.
+static void shadow_rmw(std::vector<uint8_t> *value,
+                       const std::vector<uint8_t> &operand,
+                       enum map_access_t access)
+{
+  size_t n = value->size();
+  std::vector<uint8_t> sum(n);
+  unsigned carry = 0;
+  for (size_t i=0; i<n; i++) {
+    unsigned s = unsigned(value->at(i)) + operand.at(i) + carry;
+    sum.at(i) = uint8_t(s);
+    carry = s >> 8;
+  }
+
+  // Compare starting at the most significant byte.
+  int cmp = 0;
+  for (size_t i=n; i>0 && cmp==0; i--) {
+    cmp = int(value->at(i-1)) - int(operand.at(i-1));
+  }
+
+  switch (access) {
+  case NANOTUBE_MAP_ADD:
+    *value = sum;
+    break;
+  case NANOTUBE_MAP_ADD_SAT:
+    if (carry != 0)
+      value->assign(n, 0xff);
+    else
+      *value = sum;
+    break;
+  case NANOTUBE_MAP_MIN:
+    if (cmp > 0)
+      *value = operand;
+    break;
+  case NANOTUBE_MAP_MAX:
+    if (cmp < 0)
+      *value = operand;
+    break;
+  default:
+    assert(false);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
+
 class map_test
 {
 public:
@@ -45,6 +91,8 @@ private:
   void write(int key_id, bool exp_succ);
   void remove(int key_id, bool exp_succ);
   void read(int key_id, bool exp_succ);
+  void rmw(int key_id, enum map_access_t access, bool exp_succ);
+  void iterate();
   void verify_all();
 
   int m_key_length;
@@ -120,6 +168,23 @@ void map_test::run_all()
   comment("Verify the contents");
   verify_all();
 
+  comment("Read-modify-write existing entries + read");
+  rmw(0, NANOTUBE_MAP_ADD, true);
+  read(0, true);
+  for(int i=0; i<4; i++)
+    rmw(1, NANOTUBE_MAP_ADD_SAT, true);
+  read(1, true);
+  rmw(3, NANOTUBE_MAP_MIN, true);
+  rmw(3, NANOTUBE_MAP_MAX, true);
+  read(3, true);
+
+  comment("Read-modify-write a missing entry + read");
+  rmw(4, NANOTUBE_MAP_ADD, false);
+  read(4, false);
+
+  comment("Verify the contents");
+  verify_all();
+
   comment("Remove an existing entry + read");
   remove(2, true);
   read(2, false);
@@ -130,6 +195,9 @@ void map_test::run_all()
 
   comment("Verify the contents");
   verify_all();
+
+  comment("Iterate over the keys");
+  iterate();
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -191,6 +259,11 @@ void map_test::invoke(enum map_access_t access)
     case NANOTUBE_MAP_WRITE:  std::cout << "WRITE\n"; break;
     case NANOTUBE_MAP_REMOVE: std::cout << "REMOVE\n"; break;
     case NANOTUBE_MAP_NOP:    std::cout << "NOP\n"; break;
+    case NANOTUBE_MAP_ADD:     std::cout << "ADD\n"; break;
+    case NANOTUBE_MAP_ADD_SAT: std::cout << "ADD_SAT\n"; break;
+    case NANOTUBE_MAP_MIN:     std::cout << "MIN\n"; break;
+    case NANOTUBE_MAP_MAX:     std::cout << "MAX\n"; break;
+    case NANOTUBE_MAP_NEXT_KEY: std::cout << "NEXT_KEY\n"; break;
     }
     std::cout << "  Key:     " << std::hex << std::setfill('0');
     for (int i=0; i<m_key_length; i++) {
@@ -348,6 +421,50 @@ void map_test::read(int key_id, bool exp_succ)
   }
 }
 
+void map_test::rmw(int key_id, enum map_access_t access, bool exp_succ)
+{
+  gen_key(key_id);
+  gen_data();
+  invoke(access);
+
+  auto it = m_shadow_map.find(m_key_in);
+  if (it != m_shadow_map.end()) {
+    assert_eq(exp_succ, true);
+    assert_eq(m_result_out, NANOTUBE_MAP_RESULT_PRESENT);
+    check_data(it->second);
+    shadow_rmw(&it->second, m_data_in, access);
+
+  } else {
+    assert_eq(exp_succ, false);
+    assert_eq(m_result_out, NANOTUBE_MAP_RESULT_ABSENT);
+    check_data_zero();
+  }
+}
+
+void map_test::iterate()
+{
+  // Start from a missing key and collect the keys in iteration order.
+  shadow_map_t seen;
+  gen_key(99);
+  assert_eq(m_shadow_map.count(m_key_in), 0);
+  for (int i=0; i<m_capacity+1; i++) {
+    gen_data();
+    invoke(NANOTUBE_MAP_NEXT_KEY);
+    if (m_result_out == NANOTUBE_MAP_RESULT_ABSENT) {
+      check_data_zero();
+      break;
+    }
+    assert_eq(m_result_out, NANOTUBE_MAP_RESULT_PRESENT);
+
+    byte_vec_t key(m_data_out.begin(), m_data_out.begin()+m_key_length);
+    assert_eq(m_shadow_map.count(key), 1);
+    assert_eq(seen.count(key), 0);
+    seen.emplace(key, m_zero_data);
+    m_key_in = key;
+  }
+  assert_eq(seen.size(), m_shadow_map.size());
+}
+
 void map_test::verify_all()
 {
   for (auto it=m_shadow_map.begin(); it!=m_shadow_map.end(); it++) {
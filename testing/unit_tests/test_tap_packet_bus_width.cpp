@@ -0,0 +1,208 @@
+/**************************************************************************\
+*//*! \file test_tap_packet_bus_width.cpp
+** \author  Neil Turton <neilt@amd.com>
+**  \brief  Test the bus specific packet taps at each bus width.
+**   \date  2026-10-19
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+#include "nanotube_packet_taps.h"
+#include "nanotube_packet_taps_sb.h"
+#include "nanotube_packet_taps_shb.h"
+#include "simple_bus.hpp"
+#include "softhub_bus.hpp"
+#include "test.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////
+
+/* The taps of one bus at one width. */
+struct bus_taps {
+  decltype(nanotube_tap_packet_length) *length;
+  decltype(nanotube_tap_packet_read) *read;
+  decltype(nanotube_tap_packet_write) *write;
+  decltype(nanotube_tap_packet_is_eop) *is_eop;
+};
+
+/* Build simple bus words from packet data.  The EOP word holds
+ * the number of unused data bytes in its control field. */
+template<int LOG_DATA_BYTES>
+struct sb_format {
+  typedef simple_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef simple_bus::basic_word<LOG_DATA_BYTES> word_t;
+
+  static void set_header(uint8_t *packet, size_t length) {}
+
+  static void make_word(word_t *word, const uint8_t *data, size_t length,
+                        bool eop) {
+    memset(word->bytes, 0, sizeof(word->bytes));
+    memcpy(word->data_ptr(0), data, length);
+    word->set_control(eop, false, traits::data_bytes - length);
+  }
+};
+
+/* Build softhub bus words from packet data.  The taps take the
+ * packet length from the capsule header at the start of the packet. */
+template<int LOG_DATA_BYTES>
+struct shb_format {
+  typedef softhub_bus::bus_traits<LOG_DATA_BYTES> traits;
+  typedef softhub_bus::basic_word<LOG_DATA_BYTES> word_t;
+
+  static void set_header(uint8_t *packet, size_t length) {
+    softhub_bus::set_ch_length_raw(packet, length);
+  }
+
+  static void make_word(word_t *word, const uint8_t *data, size_t length,
+                        bool eop) {
+    memset(word->bytes, 0, sizeof(word->bytes));
+    memcpy(word->data_ptr(0), data, length);
+    word->set_tkeep(length);
+    word->set_tstrb(length);
+    word->set_tlast(eop);
+  }
+};
+
+template<class FORMAT>
+void test_bus_width(const char *bus_name, const bus_taps &taps)
+{
+  typedef typename FORMAT::traits traits;
+  typedef typename FORMAT::word_t word_t;
+  const size_t data_bytes = traits::data_bytes;
+
+  std::cout << "Testing the " << bus_name << " taps with "
+            << data_bytes << " data bytes.\n";
+
+  /* A packet of three words with a partial final word. */
+  size_t packet_length = 3*data_bytes - 7;
+  size_t num_words = (packet_length + data_bytes - 1) / data_bytes;
+  uint8_t packet[num_words * data_bytes];
+  for (size_t i = 0; i < sizeof(packet); i++)
+    packet[i] = rand() & 0xff;
+  FORMAT::set_header(packet, packet_length);
+
+  std::vector<word_t> words(num_words);
+  for (size_t w = 0; w < num_words; w++) {
+    bool eop = (w == num_words-1);
+    size_t length = ( eop ? packet_length - w*data_bytes : data_bytes );
+    FORMAT::make_word(&words[w], packet + w*data_bytes, length, eop);
+  }
+
+  /* Check the EOP and length taps. */
+  struct nanotube_tap_packet_eop_state eop_state =
+    nanotube_tap_packet_eop_state_init;
+  struct nanotube_tap_packet_length_state length_state =
+    nanotube_tap_packet_length_state_init;
+  struct nanotube_tap_packet_length_req length_req = { true, 0xffff };
+  struct nanotube_tap_packet_length_resp length_resp = { false, 0 };
+  for (size_t w = 0; w < num_words; w++) {
+    bool eop = taps.is_eop(&words[w], &eop_state);
+    assert_eq(eop, (w == num_words-1));
+    taps.length(&length_resp, &length_state, &words[w], &length_req);
+  }
+  assert_eq(length_resp.valid, true);
+  assert_eq(length_resp.result_length, packet_length);
+
+  /* Read across the boundary between the first two words. */
+  const uint16_t rb_len = 32;
+  const uint8_t rb_index_bits = 5;
+  struct nanotube_tap_packet_read_state read_state =
+    nanotube_tap_packet_read_state_init;
+  struct nanotube_tap_packet_read_req read_req = {
+    true, uint16_t(data_bytes - 5), 20 };
+  struct nanotube_tap_packet_read_resp read_resp;
+  uint8_t result[rb_len];
+  memset(result, 0, sizeof(result));
+  size_t resp_word = num_words;
+  for (size_t w = 0; w < num_words; w++) {
+    taps.read(rb_len, rb_index_bits, &read_resp, result, &read_state,
+              &words[w], &read_req);
+    if (read_resp.valid) {
+      /* The response is valid once, in the word with the last byte. */
+      assert_eq(resp_word, num_words);
+      assert_eq(read_resp.result_length, read_req.read_length);
+      resp_word = w;
+    }
+  }
+  assert_eq(resp_word, 1U);
+  assert_array_eq(result, packet + read_req.read_offset,
+                  read_req.read_length);
+
+  /* Write across the boundary between the last two words, with some
+   * of the request bytes masked out. */
+  const uint16_t req_len = 16;
+  const uint8_t req_index_bits = 4;
+  uint8_t req_data[req_len];
+  uint8_t req_mask[req_len/8] = { 0xf7, 0x7f };
+  for (size_t i = 0; i < req_len; i++)
+    req_data[i] = rand() & 0xff;
+
+  struct nanotube_tap_packet_write_state write_state =
+    nanotube_tap_packet_write_state_init;
+  struct nanotube_tap_packet_write_req write_req = {
+    true, uint16_t(2*data_bytes - 6), req_len };
+  std::vector<word_t> out_words(num_words);
+  for (size_t w = 0; w < num_words; w++) {
+    taps.write(req_len, req_index_bits, &out_words[w], &write_state,
+               &words[w], &write_req, req_data, req_mask);
+  }
+
+  uint8_t expected[sizeof(packet)];
+  memcpy(expected, packet, sizeof(expected));
+  for (size_t i = 0; i < req_len; i++) {
+    if ((req_mask[i/8] >> (i%8)) & 1)
+      expected[write_req.write_offset + i] = req_data[i];
+  }
+
+  for (size_t w = 0; w < num_words; w++) {
+    bool eop = (w == num_words-1);
+    size_t length = ( eop ? packet_length - w*data_bytes : data_bytes );
+    word_t expected_word;
+    FORMAT::make_word(&expected_word, expected + w*data_bytes, length,
+                      eop);
+    assert_array_eq(out_words[w].bytes, expected_word.bytes,
+                    sizeof(expected_word.bytes));
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  test_init(argc, argv);
+
+  bus_taps sb_w32 = {
+    nanotube_tap_packet_length_sb_w32, nanotube_tap_packet_read_sb_w32,
+    nanotube_tap_packet_write_sb_w32, nanotube_tap_packet_is_eop_sb_w32 };
+  bus_taps sb_w64 = {
+    nanotube_tap_packet_length_sb, nanotube_tap_packet_read_sb,
+    nanotube_tap_packet_write_sb, nanotube_tap_packet_is_eop_sb };
+  bus_taps sb_w128 = {
+    nanotube_tap_packet_length_sb_w128, nanotube_tap_packet_read_sb_w128,
+    nanotube_tap_packet_write_sb_w128, nanotube_tap_packet_is_eop_sb_w128 };
+  test_bus_width<sb_format<5> >("simple bus", sb_w32);
+  test_bus_width<sb_format<6> >("simple bus", sb_w64);
+  test_bus_width<sb_format<7> >("simple bus", sb_w128);
+
+  bus_taps shb_w32 = {
+    nanotube_tap_packet_length_shb_w32, nanotube_tap_packet_read_shb_w32,
+    nanotube_tap_packet_write_shb_w32, nanotube_tap_packet_is_eop_shb_w32 };
+  bus_taps shb_w64 = {
+    nanotube_tap_packet_length_shb, nanotube_tap_packet_read_shb,
+    nanotube_tap_packet_write_shb, nanotube_tap_packet_is_eop_shb };
+  bus_taps shb_w128 = {
+    nanotube_tap_packet_length_shb_w128, nanotube_tap_packet_read_shb_w128,
+    nanotube_tap_packet_write_shb_w128,
+    nanotube_tap_packet_is_eop_shb_w128 };
+  test_bus_width<shb_format<5> >("softhub bus", shb_w32);
+  test_bus_width<shb_format<6> >("softhub bus", shb_w64);
+  test_bus_width<shb_format<7> >("softhub bus", shb_w128);
+
+  return test_fini();
+}
+
+///////////////////////////////////////////////////////////////////////////
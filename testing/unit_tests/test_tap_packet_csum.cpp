@@ -0,0 +1,197 @@
+/**************************************************************************\
+*//*! \file test_tap_packet_csum.cpp
+**  \brief  A simple test for the packet checksum tap core logic.
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+#include "nanotube_packet_taps_core.h"
+#include "test.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+///////////////////////////////////////////////////////////////////////////
+
+// Compute the expected checksum one byte at a time.
+static uint16_t reference_csum(const uint8_t *data, uint16_t length,
+                               uint32_t seed)
+{
+  uint32_t sum = (seed & 0xffff) + (seed >> 16);
+  for (uint16_t i=0; i<length; i++) {
+    sum += ( (i & 1) == 0 ? (uint32_t(data[i]) << 8) : data[i] );
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  sum = (sum & 0xffff) + (sum >> 16);
+  return uint16_t(sum);
+}
+
+void test_tap_packet_csum_core_case(
+  struct nanotube_tap_packet_csum_state *state,
+  uint16_t packet_buffer_length,
+  uint16_t csum_offset,
+  uint16_t csum_length,
+  uint32_t seed,
+  uint16_t req_valid_offset,
+  uint16_t packet_length)
+{
+  uint16_t pb_len = packet_buffer_length;
+
+  // The word index at which req.valid is set.
+  uint16_t req_valid_index = ( req_valid_offset / pb_len );
+
+  // The byte after the last one summed.
+  uint32_t csum_end_offset = uint32_t(csum_offset) + csum_length;
+
+  // The offset into the packet at which the checksum completes.
+  uint16_t resp_valid_offset =
+    std::min(csum_length == 0 ? uint32_t(req_valid_offset)
+                              : csum_end_offset-1U,
+             packet_length-1U);
+  uint16_t resp_valid_index = (resp_valid_offset / pb_len);
+
+  // The expected number of bytes summed.
+  uint16_t resp_length = ( std::min(csum_end_offset, uint32_t(packet_length)) -
+                           std::min(csum_offset, packet_length) );
+
+  uint16_t packet_num_words = ( (packet_length + (pb_len-1)) / pb_len );
+  uint16_t pd_len = packet_num_words * pb_len;
+
+  if (test_verbose) {
+    std::cout << "  Parameters: pbl=" << packet_buffer_length
+              << " co=" << csum_offset
+              << " cl=" << csum_length
+              << " seed=" << seed
+              << " rvo=" << req_valid_offset
+              << " pl=" << packet_length
+              << "\n";
+  }
+
+  assert(resp_valid_index < packet_num_words);
+
+  // The packet data, with random bytes past the end of the packet.
+  uint8_t packet_data[pd_len];
+  for (size_t i = 0; i < sizeof(packet_data); i++)
+    packet_data[i] = rand() & 0xff;
+
+  uint16_t expected_sum = reference_csum(packet_data+csum_offset,
+                                         resp_length, seed);
+
+  struct nanotube_tap_packet_csum_resp resp;
+  struct nanotube_tap_packet_csum_req req;
+
+  for (uint16_t index=0; index<packet_num_words; index++) {
+    if (index >= req_valid_index) {
+      req.valid = 1;
+      req.csum_offset = csum_offset;
+      req.csum_length = csum_length;
+      req.seed = seed;
+    } else {
+      req.valid = 0;
+      req.csum_offset = rand() & 0xffff;
+      req.csum_length = rand() & 0xffff;
+      req.seed = rand();
+    }
+
+    bool packet_word_eop = (index == packet_num_words-1);
+    uint16_t packet_word_length = pb_len;
+    if (packet_word_eop)
+      packet_word_length = packet_length - (packet_num_words-1)*pb_len;
+
+    nanotube_tap_packet_csum_core(
+      packet_buffer_length, &resp, state,
+      packet_data + index*pb_len, packet_word_eop, packet_word_length,
+      &req);
+
+    if (test_verbose) {
+      std::cout << "  Response: rv=" << uint32_t(resp.valid);
+      if (resp.valid)
+        std::cout << " rl=" << uint32_t(resp.result_length)
+                  << " rs=" << uint32_t(resp.result_sum);
+      std::cout << "\n";
+    }
+
+    // Make sure the valid bit is set at the right time.
+    assert_eq(resp.valid, index==resp_valid_index);
+
+    if (resp.valid && index==resp_valid_index) {
+      assert_eq(resp.result_length, resp_length);
+      assert_eq(resp.result_sum, expected_sum);
+    }
+  }
+}
+
+void test_tap_packet_csum_core()
+{
+  struct nanotube_tap_packet_csum_state state;
+
+  std::cout << "Case  1: Single word\n";
+
+  state = nanotube_tap_packet_csum_state_init;
+
+  test_tap_packet_csum_core_case(&state,
+                                 /* Packet buffer */     8,
+                                 /* Csum offset/len */   0, 8,
+                                 /* Seed */              0,
+                                 /* Req valid */         0,
+                                 /* Packet length */     8);
+
+  std::cout << "Case  2: Odd offset spanning words\n";
+
+  test_tap_packet_csum_core_case(&state,
+                                 /* Packet buffer */     8,
+                                 /* Csum offset/len */   3, 15,
+                                 /* Seed */              0x12345,
+                                 /* Req valid */         0,
+                                 /* Packet length */     40);
+
+  std::cout << "Case  3: Region truncated by EOP\n";
+
+  test_tap_packet_csum_core_case(&state,
+                                 /* Packet buffer */     16,
+                                 /* Csum offset/len */   14, 100,
+                                 /* Seed */              0xffffffff,
+                                 /* Req valid */         0,
+                                 /* Packet length */     37);
+
+  std::cout << "Case  4: Late request\n";
+
+  test_tap_packet_csum_core_case(&state,
+                                 /* Packet buffer */     8,
+                                 /* Csum offset/len */   20, 6,
+                                 /* Seed */              7,
+                                 /* Req valid */         17,
+                                 /* Packet length */     30);
+
+  std::cout << "Random cases.\n";
+  for (int i=0; i<1000; i++) {
+    uint16_t packet_buffer_length = (rand() % 16) + 1;
+    uint16_t packet_length = (rand() % 64) + 1;
+    uint16_t csum_offset = (rand() % packet_length);
+    uint16_t csum_length = (rand() % 64);
+    uint32_t seed = ( (rand() % 2) == 0 ? 0 : uint32_t(rand()) );
+    uint16_t req_valid_offset = (rand() % (csum_offset+1));
+
+    if (test_verbose)
+      std::cout << "Random case " << i << "\n";
+
+    test_tap_packet_csum_core_case(&state, packet_buffer_length,
+                                   csum_offset, csum_length, seed,
+                                   req_valid_offset, packet_length);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  test_init(argc, argv);
+  test_tap_packet_csum_core();
+  return test_fini();
+}
+
+///////////////////////////////////////////////////////////////////////////
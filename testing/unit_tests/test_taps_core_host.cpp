@@ -0,0 +1,184 @@
+/**************************************************************************\
+*//*! \file test_taps_core_host.cpp
+** \author  Neil Turton <neilt@amd.com>
+**  \brief  Compare the host and scalar packet tap core primitives.
+**   \date  2026-10-18
+*//*
+\**************************************************************************/
+
+/**************************************************************************
+** Copyright (C) 2023, Advanced Micro Devices, Inc. All rights reserved.
+** SPDX-License-Identifier: MIT
+**************************************************************************/
+#include "nanotube_packet_taps_core.h"
+#include "test.hpp"
+
+#include <cstring>
+#include <iostream>
+
+///////////////////////////////////////////////////////////////////////////
+
+/* The number of random cases to run for each primitive. */
+static const int num_cases = 2000;
+
+/* Guard bytes placed around each output buffer. */
+static const size_t pad = 16;
+
+static void fill_random(uint8_t *buf, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+    buf[i] = rand() & 0xff;
+}
+
+static size_t index_bits(size_t len)
+{
+  size_t bits = 0;
+  while ((size_t(1) << bits) < len)
+    bits++;
+  return bits;
+}
+
+void test_rotate_down_equiv()
+{
+  std::cout << "Comparing nanotube_rotate_down.\n";
+
+  for (int c = 0; c < num_cases; c++) {
+    size_t rot_length = 1 + rand() % 150;
+    size_t in_length = rand() % (rot_length + 1);
+    size_t out_length = rand() % (rot_length + 1);
+    size_t rot_amount_bits = index_bits(rot_length) + rand() % 2;
+    uint16_t rot_amount = rand() & 0xffff;
+
+    uint8_t in_buf[in_length + 1];
+    uint8_t host_buf[out_length + 2*pad];
+    uint8_t scalar_buf[out_length + 2*pad];
+    fill_random(in_buf, sizeof(in_buf));
+    fill_random(host_buf, sizeof(host_buf));
+    memcpy(scalar_buf, host_buf, sizeof(host_buf));
+
+    nanotube_rotate_down(out_length, rot_length, in_length,
+                         rot_amount_bits, host_buf + pad, in_buf,
+                         rot_amount);
+    nanotube_rotate_down_scalar(out_length, rot_length, in_length,
+                                rot_amount_bits, scalar_buf + pad,
+                                in_buf, rot_amount);
+    assert_array_eq(host_buf, scalar_buf, sizeof(host_buf));
+  }
+}
+
+void test_shift_down_bits_equiv()
+{
+  std::cout << "Comparing nanotube_shift_down_bits.\n";
+
+  for (int c = 0; c < num_cases; c++) {
+    size_t out_length = rand() % 80;
+    uint8_t shift_amount = rand() % 8;
+
+    uint8_t in_buf[out_length + 1];
+    uint8_t host_buf[out_length + 2*pad];
+    uint8_t scalar_buf[out_length + 2*pad];
+    fill_random(in_buf, sizeof(in_buf));
+    fill_random(host_buf, sizeof(host_buf));
+    memcpy(scalar_buf, host_buf, sizeof(host_buf));
+
+    nanotube_shift_down_bits(out_length, host_buf + pad, in_buf,
+                             shift_amount);
+    nanotube_shift_down_bits_scalar(out_length, scalar_buf + pad, in_buf,
+                                    shift_amount);
+    assert_array_eq(host_buf, scalar_buf, sizeof(host_buf));
+  }
+}
+
+void test_duplicate_bits_equiv()
+{
+  std::cout << "Comparing nanotube_duplicate_bits.\n";
+
+  for (int c = 0; c < num_cases; c++) {
+    uint32_t padded_bit_length = 1 + rand() % 300;
+    uint32_t input_bit_length = 1 + rand() % padded_bit_length;
+    size_t in_length = (input_bit_length + 7) / 8;
+    size_t out_length = (2*padded_bit_length + 7) / 8;
+
+    uint8_t in_buf[in_length];
+    uint8_t host_buf[out_length + 2*pad];
+    uint8_t scalar_buf[out_length + 2*pad];
+    fill_random(in_buf, sizeof(in_buf));
+    fill_random(host_buf, sizeof(host_buf));
+    memcpy(scalar_buf, host_buf, sizeof(host_buf));
+
+    nanotube_duplicate_bits(host_buf + pad, in_buf, input_bit_length,
+                            padded_bit_length);
+    nanotube_duplicate_bits_scalar(scalar_buf + pad, in_buf,
+                                   input_bit_length, padded_bit_length);
+    assert_array_eq(host_buf, scalar_buf, sizeof(host_buf));
+  }
+}
+
+void test_classify_entries_equiv()
+{
+  std::cout << "Comparing nanotube_classify_entries.\n";
+
+  for (int c = 0; c < num_cases; c++) {
+    uint16_t length = 1 + rand() % 150;
+    uint16_t end_offset = rand() % (length + 1);
+    uint16_t start_offset = rand() % (end_offset + 1);
+
+    uint8_t host_buf[length + 2*pad];
+    uint8_t scalar_buf[length + 2*pad];
+    fill_random(host_buf, sizeof(host_buf));
+    memcpy(scalar_buf, host_buf, sizeof(host_buf));
+
+    nanotube_classify_entries(length, index_bits(length),
+                              (enum byte_class *)(host_buf + pad),
+                              start_offset, end_offset);
+    nanotube_classify_entries_scalar(length, index_bits(length),
+                                     (enum byte_class *)(scalar_buf + pad),
+                                     start_offset, end_offset);
+    assert_array_eq(host_buf, scalar_buf, sizeof(host_buf));
+  }
+}
+
+void test_packet_write_blend_equiv()
+{
+  std::cout << "Comparing nanotube_packet_write_blend.\n";
+
+  for (int c = 0; c < num_cases; c++) {
+    uint16_t length = 1 + rand() % 150;
+    uint16_t rot_length = 1 + rand() % 150;
+    uint16_t end_offset = rand() % (length + 1);
+    uint16_t start_offset = rand() % (end_offset + 1);
+
+    uint8_t in_buf[length];
+    uint8_t rot_data[rot_length];
+    uint8_t rot_mask[(rot_length + 7) / 8];
+    uint8_t host_buf[length + 2*pad];
+    uint8_t scalar_buf[length + 2*pad];
+    fill_random(in_buf, sizeof(in_buf));
+    fill_random(rot_data, sizeof(rot_data));
+    fill_random(rot_mask, sizeof(rot_mask));
+    fill_random(host_buf, sizeof(host_buf));
+    memcpy(scalar_buf, host_buf, sizeof(host_buf));
+
+    nanotube_packet_write_blend(length, index_bits(length), rot_length,
+                                host_buf + pad, in_buf, rot_data,
+                                rot_mask, start_offset, end_offset);
+    nanotube_packet_write_blend_scalar(length, index_bits(length),
+                                       rot_length, scalar_buf + pad,
+                                       in_buf, rot_data, rot_mask,
+                                       start_offset, end_offset);
+    assert_array_eq(host_buf, scalar_buf, sizeof(host_buf));
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  test_init(argc, argv);
+  test_rotate_down_equiv();
+  test_shift_down_bits_equiv();
+  test_duplicate_bits_equiv();
+  test_classify_entries_equiv();
+  test_packet_write_blend_equiv();
+  return test_fini();
+}
+
+///////////////////////////////////////////////////////////////////////////